@@ -259,8 +259,18 @@ int
 module_resolver::IncludeTranslateRequest (Cody::Server *s, Cody::Flags,
 					  std::string &include)
 {
+  std::string const *cmi = nullptr;
   auto iter = map.find (include);
-  if (iter == map.end () && default_translate)
+  if (iter != map.end ())
+    cmi = &iter->second;
+  else if (default_translate)
+    {
+      iter = xlate_cache.find (include);
+      if (iter != xlate_cache.end ())
+	cmi = &iter->second;
+    }
+
+  if (!cmi && default_translate)
     {
       // Not found, look for it
       auto file = GetCMIName (include);
@@ -297,26 +307,28 @@ module_resolver::IncludeTranslateRequest (Cody::Server *s, Cody::Flags,
       if (!ok)
 	// Mark as not present
 	file.clear ();
-      auto res = map.emplace (include, file);
-      iter = res.first;
+      auto res = xlate_cache.emplace (include, file);
+      cmi = &res.first->second;
     }
 
-  if (iter == map.end () || iter->second.empty ())
+  if (!cmi || cmi->empty ())
     s->BoolResponse (false);
   else
-    s->PathnameResponse (iter->second);
+    s->PathnameResponse (*cmi);
 
   return 0;
 }
 
 /* This handles a client notification to the server that a CMI has been
-   produced for a module.  For this simplified server, we just accept
-   the transaction and respond with "OK".  */
+   produced for a module.  For this simplified server, we just forget
+   what we found when looking for the CMI of a header unit of that name,
+   and respond with "OK".  */
 
 int
 module_resolver::ModuleCompiledRequest (Cody::Server *s, Cody::Flags,
-				      std::string &)
+				      std::string &module)
 {
+  xlate_cache.erase (module);
   s->OKResponse();
   return 0;
 }
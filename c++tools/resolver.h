@@ -26,7 +26,7 @@ along with GCC; see the file COPYING3.  If not see
 // C++
 #if !IN_GCC
 #include <string>
-#include <map>
+#include <unordered_map>
 #endif
 
 // This is a GCC class, so GCC coding conventions on new bits.  
@@ -34,12 +34,17 @@ class module_resolver : public Cody::Resolver
 {
 public:
   using parent = Cody::Resolver;
-  using module_map = std::map<std::string, std::string>;
+  using module_map = std::unordered_map<std::string, std::string>;
 
 private:
   std::string repo;
   std::string ident;
   module_map map;
+  // Include translations found by looking for their CMI in the repo,
+  // empty for those not found.  Unlike MAP these are only what the
+  // file system said, so a MODULE-COMPILED notification for the
+  // header drops its entry.
+  module_map xlate_cache;
   int fd_repo = -1;
   bool default_map = true;
   bool default_translate = true;
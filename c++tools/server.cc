@@ -504,19 +504,28 @@ kill_signal (int sig)
 
 bool process_server (Cody::Server *server, unsigned slot, int epoll_fd)
 {
-  switch (server->GetDirection ())
+  auto direction = server->GetDirection ();
+
+  switch (direction)
     {
     case Cody::Server::READING:
       if (int err = server->Read ())
 	return !(err == EINTR || err == EAGAIN);
       server->ProcessRequests ();
       server->PrepareToWrite ();
-      break;
+      /* The client is waiting for the response, so the socket is almost
+	 certainly writable.  Try now, rather than going round the wait
+	 loop again.  */
+      /* FALLTHROUGH */
 
     case Cody::Server::WRITING:
       if (int err = server->Write ())
-	return !(err == EINTR || err == EAGAIN);
-      server->PrepareToRead ();
+	{
+	  if (!(err == EINTR || err == EAGAIN))
+	    return true;
+	}
+      else
+	server->PrepareToRead ();
       break;
 
     default:
@@ -524,11 +533,14 @@ bool process_server (Cody::Server *server, unsigned slot, int epoll_fd)
       return true;
     }
 
-  // We've changed direction, so update epoll
-  gcc_assert (server->GetFDRead () == server->GetFDWrite ());
-  my_epoll_ctl (epoll_fd, EPOLL_CTL_MOD,
-		server->GetDirection () == Cody::Server::READING
-		? EPOLLIN : EPOLLOUT, server->GetFDRead (), slot + 1);
+  // If we've changed direction, update epoll
+  if (server->GetDirection () != direction)
+    {
+      gcc_assert (server->GetFDRead () == server->GetFDWrite ());
+      my_epoll_ctl (epoll_fd, EPOLL_CTL_MOD,
+		    server->GetDirection () == Cody::Server::READING
+		    ? EPOLLIN : EPOLLOUT, server->GetFDRead (), slot + 1);
+    }
 
   return false;
 }
@@ -610,7 +622,7 @@ server (bool ipv6, int sock_fd, module_resolver *resolver)
 #endif
 
 #ifdef HAVE_EPOLL
-  const unsigned max_events = 20;
+  const unsigned max_events = 128;
   epoll_event events[max_events];
 #endif
 #if defined (HAVE_PSELECT) || defined (HAVE_SELECT)
@@ -847,7 +859,7 @@ static int maybe_parse_socket (std::string &option, module_resolver *r)
     {
       /* A local socket.  */
 #if CODY_NETWORKING
-      fd = Cody::ListenLocal (&errmsg, option.c_str () + 1);
+      fd = Cody::ListenLocal (&errmsg, option.c_str () + 1, SOMAXCONN);
 #endif
     }
   else
@@ -865,7 +877,8 @@ static int maybe_parse_socket (std::string &option, module_resolver *r)
 	      /* Ends in ':number', treat as ipv6 domain socket.  */
 	      option.erase (colon);
 #if CODY_NETWORKING
-	      fd = Cody::ListenInet6 (&errmsg, option.c_str (), port);
+	      fd = Cody::ListenInet6 (&errmsg, option.c_str (), port,
+				      SOMAXCONN);
 #endif
 	    }
 	}
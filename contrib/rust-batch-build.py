@@ -0,0 +1,169 @@
+#!/usr/bin/env python3
+#
+# Build a workspace of Rust crates with gccrs from a single manifest.
+#
+# This file is part of GCC.
+#
+# GCC is free software; you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free
+# Software Foundation; either version 3, or (at your option) any later
+# version.
+#
+# GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with GCC; see the file COPYING3.  If not see
+# <http://www.gnu.org/licenses/>.
+#
+#
+# The manifest is a JSON list of crates in dependency order:
+#
+#   [
+#     {"name": "util", "source": "util/lib.rs"},
+#     {"name": "app", "source": "app/main.rs", "deps": ["util"]}
+#   ]
+#
+# Every crate is compiled to NAME.o and NAME.rox in the output directory,
+# which is also on the import search path of all later crates. Crates whose
+# dependencies are built are compiled in parallel, and all compiles share
+# one -frust-metadata-cache= directory, so an extern crate's reachability
+# data is built once for the whole workspace instead of once per importer.
+#
+# Usage:
+#   contrib/rust-batch-build.py --compiler=build/gcc/gccrs -B build/gcc \
+#       --output-dir=out -j8 workspace.json
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+from concurrent.futures import ThreadPoolExecutor, FIRST_COMPLETED, wait
+
+
+def load_manifest(path):
+    with open(path) as f:
+        crates = json.load(f)
+
+    seen = set()
+    for crate in crates:
+        name = crate.get('name')
+        if not name or 'source' not in crate:
+            raise ValueError('every crate needs a name and a source')
+        if name in seen:
+            raise ValueError('crate %s is listed twice' % name)
+        for dep in crate.get('deps', []):
+            if dep not in seen:
+                raise ValueError('crate %s depends on %s, which is not '
+                                 'listed before it' % (name, dep))
+        seen.add(name)
+    return crates
+
+
+def compile_crate(args, crate, base):
+    name = crate['name']
+    source = crate['source']
+    if not os.path.isabs(source):
+        source = os.path.join(base, source)
+
+    cmd = [args.compiler] + args.extra
+    cmd += ['-c', source, '-o', os.path.join(args.output_dir, name + '.o'),
+            '-frust-crate=' + name,
+            '-frust-metadata-output='
+            + os.path.join(args.output_dir, name + '.rox'),
+            '-frust-metadata-cache=' + args.cache_dir,
+            '-L', args.output_dir]
+    cmd += crate.get('flags', [])
+
+    result = subprocess.run(cmd, stdout=subprocess.PIPE,
+                            stderr=subprocess.STDOUT)
+    return name, cmd, result.returncode, result.stdout.decode()
+
+
+def build(args, crates, base):
+    pending = list(crates)
+    done = set()
+    failed = set()
+    running = {}
+
+    with ThreadPoolExecutor(max_workers=args.jobs) as pool:
+        while pending or running:
+            # start every crate whose dependencies are all built
+            for crate in list(pending):
+                deps = crate.get('deps', [])
+                if any(d in failed for d in deps):
+                    sys.stderr.write('skipping %s, a dependency failed\n'
+                                     % crate['name'])
+                    failed.add(crate['name'])
+                    pending.remove(crate)
+                elif all(d in done for d in deps):
+                    future = pool.submit(compile_crate, args, crate, base)
+                    running[future] = crate
+                    pending.remove(crate)
+
+            if not running:
+                break
+
+            finished, _ = wait(running, return_when=FIRST_COMPLETED)
+            for future in finished:
+                del running[future]
+                name, cmd, code, output = future.result()
+                if args.verbose:
+                    sys.stdout.write(' '.join(cmd) + '\n')
+                sys.stdout.write(output)
+                if code == 0:
+                    done.add(name)
+                else:
+                    sys.stderr.write('%s failed\n' % name)
+                    failed.add(name)
+
+    return not failed
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Compile a manifest of Rust crates with gccrs.')
+    parser.add_argument('manifest', help='JSON list of crates')
+    parser.add_argument('--compiler', default='gccrs',
+                        help='the gccrs driver to use')
+    parser.add_argument('-B', dest='prefix',
+                        help='passed on to the driver, for running from a '
+                        'build tree')
+    parser.add_argument('--output-dir', default='.',
+                        help='where the objects and metadata are written')
+    parser.add_argument('--cache-dir',
+                        help='metadata cache shared by all compiles, '
+                        'OUTPUT_DIR/metadata-cache by default')
+    parser.add_argument('-j', dest='jobs', type=int, default=os.cpu_count(),
+                        help='number of crates compiled at once')
+    parser.add_argument('-v', dest='verbose', action='store_true',
+                        help='print each compiler command')
+    parser.add_argument('flags', nargs=argparse.REMAINDER,
+                        help='after --, extra flags for every compile')
+    args = parser.parse_args()
+
+    args.extra = []
+    if args.prefix:
+        args.extra.append('-B' + args.prefix)
+    args.extra += [f for f in args.flags if f != '--']
+
+    args.output_dir = os.path.abspath(args.output_dir)
+    if not args.cache_dir:
+        args.cache_dir = os.path.join(args.output_dir, 'metadata-cache')
+    os.makedirs(args.output_dir, exist_ok=True)
+    os.makedirs(args.cache_dir, exist_ok=True)
+
+    try:
+        crates = load_manifest(args.manifest)
+    except (OSError, ValueError) as e:
+        parser.error(str(e))
+
+    base = os.path.dirname(os.path.abspath(args.manifest))
+    return 0 if build(args, crates, base) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
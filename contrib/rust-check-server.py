@@ -0,0 +1,202 @@
+#!/usr/bin/env python3
+#
+# Serve repeated gccrs checks from a long-running process.
+#
+# This file is part of GCC.
+#
+# GCC is free software; you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free
+# Software Foundation; either version 3, or (at your option) any later
+# version.
+#
+# GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with GCC; see the file COPYING3.  If not see
+# <http://www.gnu.org/licenses/>.
+#
+#
+# Editors and watch-mode builds run the same -fsyntax-only or
+# -frust-compile-until= checks over and over, mostly on crates that have not
+# changed since the last run. The server keeps the result of every check
+# keyed by the command line and the contents of everything the crate can
+# read: the .rs files under the crate's source directory and the .rox and .o
+# files in its -L directories. A request whose key is unchanged gets the
+# stored diagnostics back without running the compiler. Anything else is
+# run, and every compile shares one -frust-metadata-cache= directory so
+# extern crates stay decoded between requests.
+#
+# Usage:
+#   contrib/rust-check-server.py serve --compiler=build/gcc/gccrs \
+#       -B build/gcc --socket=/tmp/gccrs.sock &
+#   contrib/rust-check-server.py check --socket=/tmp/gccrs.sock -- \
+#       -fsyntax-only src/lib.rs
+#
+# The protocol is one JSON object per line. A request is
+# {"cwd": DIR, "args": [...]} and the reply is
+# {"returncode": N, "output": TEXT, "cached": BOOL}.
+
+import argparse
+import hashlib
+import json
+import os
+import socket
+import socketserver
+import subprocess
+import sys
+import tempfile
+import threading
+
+
+def source_files(args, cwd):
+    """The files whose contents decide the result of compiling ARGS."""
+    files = []
+    search = []
+    i = 0
+    while i < len(args):
+        arg = args[i]
+        if arg == '-L' and i + 1 < len(args):
+            search.append(args[i + 1])
+            i += 1
+        elif arg.startswith('-L'):
+            search.append(arg[2:])
+        elif arg.endswith('.rs') and not arg.startswith('-'):
+            # modules are loaded from the directory of the crate root and
+            # below it
+            root = os.path.dirname(os.path.join(cwd, arg)) or cwd
+            for dirpath, _, names in os.walk(root):
+                files += [os.path.join(dirpath, n) for n in names
+                          if n.endswith('.rs')]
+        i += 1
+
+    for directory in search:
+        directory = os.path.join(cwd, directory)
+        if os.path.isdir(directory):
+            files += [os.path.join(directory, n)
+                      for n in os.listdir(directory)
+                      if n.endswith('.rox') or n.endswith('.o')]
+    return sorted(set(files))
+
+
+def request_key(args, cwd):
+    h = hashlib.sha256()
+    h.update(json.dumps([cwd, args]).encode())
+    for path in source_files(args, cwd):
+        h.update(path.encode() + b'\0')
+        try:
+            with open(path, 'rb') as f:
+                h.update(hashlib.sha256(f.read()).digest())
+        except OSError:
+            h.update(b'missing')
+    return h.hexdigest()
+
+
+class CheckServer(socketserver.ThreadingUnixStreamServer):
+    daemon_threads = True
+
+    def __init__(self, path, options):
+        self.options = options
+        self.results = {}
+        self.lock = threading.Lock()
+        super().__init__(path, CheckHandler)
+
+    def check(self, args, cwd):
+        key = request_key(args, cwd)
+        with self.lock:
+            if key in self.results:
+                returncode, output = self.results[key]
+                return {'returncode': returncode, 'output': output,
+                        'cached': True}
+
+        cmd = [self.options.compiler] + self.options.extra
+        cmd += ['-frust-metadata-cache=' + self.options.cache_dir] + args
+        result = subprocess.run(cmd, cwd=cwd, stdout=subprocess.PIPE,
+                                stderr=subprocess.STDOUT)
+        output = result.stdout.decode()
+
+        # the key was taken before compiling, so a file changed while the
+        # compiler ran just misses the next time
+        with self.lock:
+            self.results[key] = (result.returncode, output)
+        return {'returncode': result.returncode, 'output': output,
+                'cached': False}
+
+
+class CheckHandler(socketserver.StreamRequestHandler):
+    def handle(self):
+        for line in self.rfile:
+            try:
+                request = json.loads(line)
+                reply = self.server.check(request['args'], request['cwd'])
+            except (ValueError, KeyError, TypeError) as e:
+                reply = {'returncode': -1, 'output': 'bad request: %s\n' % e,
+                         'cached': False}
+            self.wfile.write(json.dumps(reply).encode() + b'\n')
+            self.wfile.flush()
+
+
+def serve(options):
+    options.extra = []
+    if options.prefix:
+        options.extra.append('-B' + options.prefix)
+    if not options.cache_dir:
+        options.cache_dir = tempfile.mkdtemp(prefix='gccrs-metadata-')
+    os.makedirs(options.cache_dir, exist_ok=True)
+
+    if os.path.exists(options.socket):
+        os.unlink(options.socket)
+    server = CheckServer(options.socket, options)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        server.server_close()
+        os.unlink(options.socket)
+    return 0
+
+
+def check(options):
+    args = [a for a in options.args if a != '--']
+    request = {'cwd': os.getcwd(), 'args': args}
+
+    with socket.socket(socket.AF_UNIX, socket.SOCK_STREAM) as sock:
+        sock.connect(options.socket)
+        sock.sendall(json.dumps(request).encode() + b'\n')
+        reply = json.loads(sock.makefile().readline())
+
+    sys.stderr.write(reply['output'])
+    return reply['returncode']
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Serve repeated gccrs checks from one process.')
+    sub = parser.add_subparsers(dest='command', required=True)
+
+    p = sub.add_parser('serve', help='run the server')
+    p.add_argument('--socket', required=True, help='unix socket to listen on')
+    p.add_argument('--compiler', default='gccrs',
+                   help='the gccrs driver to run checks with')
+    p.add_argument('-B', dest='prefix',
+                   help='passed on to the driver, for running from a '
+                   'build tree')
+    p.add_argument('--cache-dir',
+                   help='metadata cache shared by every check')
+
+    p = sub.add_parser('check', help='send one compile to the server')
+    p.add_argument('--socket', required=True, help='unix socket of the server')
+    p.add_argument('args', nargs=argparse.REMAINDER,
+                   help='after --, the compiler arguments')
+
+    options = parser.parse_args()
+    if options.command == 'serve':
+        return serve(options)
+    return check(options)
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,243 @@
+#!/usr/bin/env python3
+#
+# Time the stages of the Rust front end on synthetic stress crates.
+#
+# This file is part of GCC.
+#
+# GCC is free software; you can redistribute it and/or modify it under
+# the terms of the GNU General Public License as published by the Free
+# Software Foundation; either version 3, or (at your option) any later
+# version.
+#
+# GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+# WARRANTY; without even the implied warranty of MERCHANTABILITY or
+# FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+# for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with GCC; see the file COPYING3.  If not see
+# <http://www.gnu.org/licenses/>.
+#
+#
+# The script generates crates that stress one part of the front end each
+# (trait impls, generic nesting, macro_rules! arms, flat modules and match
+# arms), compiles every crate once per -frust-compile-until= stage and
+# reports how long each stage took as JSON, so that a regression in say
+# method resolution or expansion shows up as a jump in a single stage.
+#
+# Usage:
+#   contrib/rust-frontend-bench.py --compiler=build/gcc/gccrs \
+#       -B build/gcc --scale=2 --output=before.json
+#
+# Each stage time is the best of --repeat runs of the compiler stopped at the
+# following stage, minus the same for the stage itself.
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import time
+
+# The order the session runs them in; -frust-compile-until=X stops just
+# before X runs.
+STAGES = ['ast', 'attributecheck', 'expansion', 'nameresolution', 'lowering',
+          'typecheck', 'privacy', 'unsafety', 'const', 'compilation', 'end']
+
+
+def gen_trait_impls(n):
+    out = ['pub trait Get {', '    fn get(&self) -> i32;', '}', '']
+    for i in range(n):
+        out.append('pub struct S%d;' % i)
+        out.append('impl Get for S%d {' % i)
+        out.append('    fn get(&self) -> i32 { %d }' % (i % 100))
+        out.append('}')
+    out.append('pub fn total() -> i32 {')
+    out.append('    let mut t = 0;')
+    for i in range(n):
+        out.append('    t = t + S%d.get();' % i)
+    out.append('    t')
+    out.append('}')
+    return out
+
+
+def gen_generic_nesting(n):
+    out = ['pub struct W<T> {', '    v: T,', '}', '',
+           'impl<T> W<T> {',
+           '    pub fn new(v: T) -> W<T> { W { v } }',
+           '    pub fn get(self) -> T { self.v }',
+           '}', '']
+    depth = min(n, 200)
+    nested = '0i32'
+    for _ in range(depth):
+        nested = 'W::new(%s)' % nested
+    unwrap = 'w' + '.get()' * depth
+    for i in range(max(1, n // depth)):
+        out.append('pub fn nest%d() -> i32 {' % i)
+        out.append('    let w = %s;' % nested)
+        out.append('    %s' % unwrap)
+        out.append('}')
+    return out
+
+
+def gen_macro_arms(n):
+    out = ['macro_rules! pick {']
+    for i in range(n):
+        out.append('    (arm%d $e:expr) => { $e + %d };' % (i, i % 100))
+    out.append('}')
+    out.append('pub fn picks() -> i32 {')
+    out.append('    let mut t = 0;')
+    for i in range(0, n, max(1, n // 1000)):
+        out.append('    t = pick!(arm%d t);' % i)
+    out.append('    t')
+    out.append('}')
+    return out
+
+
+def gen_flat_module(n):
+    out = ['pub mod flat {']
+    # each function takes five lines
+    for i in range(n // 5):
+        out.append('    pub fn f%d(x: i32) -> i32 {' % i)
+        out.append('        let y = x + %d;' % (i % 100))
+        out.append('        let z = y * 2;')
+        out.append('        z - x')
+        out.append('    }')
+    out.append('}')
+    return out
+
+
+def gen_huge_match(n):
+    out = ['pub fn classify(x: i32) -> i32 {', '    match x {']
+    for i in range(n):
+        out.append('        %d => %d,' % (i, (i * 7) % 100))
+    out.append('        _ => -1,')
+    out.append('    }')
+    out.append('}')
+    return out
+
+
+# name, generator and size at --scale=1
+BENCHMARKS = [
+    ('trait-impls', gen_trait_impls, 10000),
+    ('generic-nesting', gen_generic_nesting, 2000),
+    ('macro-arms', gen_macro_arms, 2000),
+    ('flat-module', gen_flat_module, 100000),
+    ('huge-match', gen_huge_match, 20000),
+]
+
+
+def write_crate(directory, name, generator, size):
+    lines = generator(size)
+    lines += ['', 'fn main() {}', '']
+    path = os.path.join(directory, name + '.rs')
+    with open(path, 'w') as f:
+        f.write('\n'.join(lines))
+    return path, len(lines)
+
+
+def time_compile(args, source, stage):
+    cmd = [args.compiler] + args.extra + ['-S', '-o', os.devnull,
+                                          '-frust-compile-until=' + stage,
+                                          source]
+    best = None
+    for _ in range(args.repeat):
+        start = time.perf_counter()
+        result = subprocess.run(cmd, stdout=subprocess.DEVNULL,
+                                stderr=subprocess.PIPE)
+        elapsed = time.perf_counter() - start
+        if result.returncode != 0:
+            sys.stderr.write('%s failed:\n%s' % (' '.join(cmd),
+                                                 result.stderr.decode()))
+            return None
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+
+def run_benchmark(args, directory, name, generator, size):
+    source, lines = write_crate(directory, name, generator, size)
+    cumulative = {}
+    for stage in STAGES:
+        cumulative[stage] = time_compile(args, source, stage)
+
+    # until=X measures everything before X, so stage X costs the difference
+    # between stopping after it and stopping before it
+    stages = {}
+    for before, after in zip(STAGES, STAGES[1:]):
+        if cumulative[before] is None or cumulative[after] is None:
+            stages[before] = None
+        else:
+            stages[before] = max(0.0, cumulative[after] - cumulative[before])
+
+    return {
+        'name': name,
+        'size': size,
+        'lines': lines,
+        'total': cumulative['end'],
+        'stages': stages,
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description='Time the Rust front end stages on stress crates.')
+    parser.add_argument('--compiler', default='gccrs',
+                        help='the gccrs driver to benchmark')
+    parser.add_argument('-B', dest='prefix',
+                        help='passed on to the driver, for running from a '
+                        'build tree')
+    parser.add_argument('--scale', type=float, default=1.0,
+                        help='multiply the size of every stress crate')
+    parser.add_argument('--repeat', type=int, default=3,
+                        help='runs per measurement, the fastest is kept')
+    parser.add_argument('--only', action='append', default=[],
+                        help='only run the named benchmark, may be repeated')
+    parser.add_argument('--keep', metavar='DIR',
+                        help='write the generated crates to DIR and keep them')
+    parser.add_argument('--output', metavar='FILE',
+                        help='write the JSON report to FILE, not stdout')
+    args = parser.parse_args()
+
+    args.extra = []
+    if args.prefix:
+        args.extra.append('-B' + args.prefix)
+
+    names = [b[0] for b in BENCHMARKS]
+    for name in args.only:
+        if name not in names:
+            parser.error('unknown benchmark %s, choose from %s'
+                         % (name, ', '.join(names)))
+
+    directory = args.keep or tempfile.mkdtemp(prefix='rust-bench-')
+    os.makedirs(directory, exist_ok=True)
+
+    results = []
+    for name, generator, size in BENCHMARKS:
+        if args.only and name not in args.only:
+            continue
+        scaled = max(1, int(size * args.scale))
+        results.append(run_benchmark(args, directory, name, generator,
+                                     scaled))
+
+    if not args.keep:
+        for name in os.listdir(directory):
+            os.remove(os.path.join(directory, name))
+        os.rmdir(directory)
+
+    report = {'compiler': args.compiler, 'scale': args.scale,
+              'repeat': args.repeat, 'benchmarks': results}
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent=2)
+            f.write('\n')
+    else:
+        json.dump(report, sys.stdout, indent=2)
+        sys.stdout.write('\n')
+
+    return 0 if all(r['total'] is not None for r in results) else 1
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -1414,15 +1414,16 @@ bitmap_and_into (bitmap a, const_bitmap b)
 	  /* Matching elts, generate A &= B.  */
 	  unsigned ix;
 	  BITMAP_WORD ior = 0;
+	  BITMAP_WORD cleared = 0;
 
 	  for (ix = 0; ix < BITMAP_ELEMENT_WORDS; ix++)
 	    {
 	      BITMAP_WORD r = a_elt->bits[ix] & b_elt->bits[ix];
-	      if (a_elt->bits[ix] != r)
-		changed = true;
+	      cleared |= a_elt->bits[ix] ^ r;
 	      a_elt->bits[ix] = r;
 	      ior |= r;
 	    }
+	  changed |= cleared != 0;
 	  next = a_elt->next;
 	  if (!ior)
 	    bitmap_list_unlink_element (a, a_elt);
@@ -1455,13 +1456,16 @@ bitmap_elt_copy (bitmap dst, bitmap_element *dst_elt, bitmap_element *dst_prev,
   if (!changed && dst_elt && dst_elt->indx == src_elt->indx)
     {
       unsigned ix;
+      BITMAP_WORD diff = 0;
 
+      /* Store every word and accumulate the differences rather than
+	 branching on each of them, so that the loop can be vectorized.  */
       for (ix = 0; ix < BITMAP_ELEMENT_WORDS; ix++)
-	if (src_elt->bits[ix] != dst_elt->bits[ix])
-	  {
-	    dst_elt->bits[ix] = src_elt->bits[ix];
-	    changed = true;
-	  }
+	{
+	  diff |= src_elt->bits[ix] ^ dst_elt->bits[ix];
+	  dst_elt->bits[ix] = src_elt->bits[ix];
+	}
+      changed = diff != 0;
     }
   else
     {
@@ -1522,17 +1526,17 @@ bitmap_and_compl (bitmap dst, const_bitmap a, const_bitmap b)
 
 	  if (!changed && dst_elt && dst_elt->indx == a_elt->indx)
 	    {
+	      BITMAP_WORD diff = 0;
+
 	      for (ix = 0; ix < BITMAP_ELEMENT_WORDS; ix++)
 		{
 		  BITMAP_WORD r = a_elt->bits[ix] & ~b_elt->bits[ix];
 
-		  if (dst_elt->bits[ix] != r)
-		    {
-		      changed = true;
-		      dst_elt->bits[ix] = r;
-		    }
+		  diff |= dst_elt->bits[ix] ^ r;
+		  dst_elt->bits[ix] = r;
 		  ior |= r;
 		}
+	      changed = diff != 0;
 	    }
 	  else
 	    {
@@ -1980,15 +1984,15 @@ bitmap_elt_ior (bitmap dst, bitmap_element *dst_elt, bitmap_element *dst_prev,
 
       if (!changed && dst_elt && dst_elt->indx == a_elt->indx)
 	{
+	  BITMAP_WORD diff = 0;
+
 	  for (ix = 0; ix < BITMAP_ELEMENT_WORDS; ix++)
 	    {
 	      BITMAP_WORD r = a_elt->bits[ix] | b_elt->bits[ix];
-	      if (r != dst_elt->bits[ix])
-		{
-		  dst_elt->bits[ix] = r;
-		  changed = true;
-		}
+	      diff |= r ^ dst_elt->bits[ix];
+	      dst_elt->bits[ix] = r;
 	    }
+	  changed = diff != 0;
 	}
       else
 	{
@@ -2973,6 +2977,44 @@ test_aligned_chunk (unsigned num_bits)
     }
 }
 
+/* Verify that the operations that write into an existing element report
+   whether they changed it.  */
+
+static void
+test_changed_results ()
+{
+  bitmap a = bitmap_gc_alloc ();
+  bitmap b = bitmap_gc_alloc ();
+  bitmap kill = bitmap_gc_alloc ();
+  bitmap dst = bitmap_gc_alloc ();
+
+  /* Put bits in both words of an element.  */
+  bitmap_set_bit (a, 3);
+  bitmap_set_bit (a, 100);
+  bitmap_set_bit (b, 3);
+  bitmap_set_bit (b, 101);
+  bitmap_set_bit (kill, 101);
+
+  ASSERT_TRUE (bitmap_ior (dst, a, b));
+  ASSERT_FALSE (bitmap_ior (dst, a, b));
+  ASSERT_EQ (3, bitmap_count_bits (dst));
+
+  ASSERT_TRUE (bitmap_ior_and_compl (dst, a, b, kill));
+  ASSERT_FALSE (bitmap_ior_and_compl (dst, a, b, kill));
+  ASSERT_TRUE (bitmap_equal_p (dst, a));
+
+  ASSERT_TRUE (bitmap_and_compl (dst, b, kill));
+  ASSERT_FALSE (bitmap_and_compl (dst, b, kill));
+  ASSERT_EQ (1, bitmap_count_bits (dst));
+
+  ASSERT_TRUE (bitmap_ior_into (dst, b));
+  ASSERT_FALSE (bitmap_ior_into (dst, b));
+  ASSERT_TRUE (bitmap_and_into (dst, a));
+  ASSERT_FALSE (bitmap_and_into (dst, a));
+  ASSERT_TRUE (bitmap_bit_p (dst, 3));
+  ASSERT_EQ (1, bitmap_count_bits (dst));
+}
+
 /* Run all of the selftests within this file.  */
 
 void
@@ -2983,6 +3025,7 @@ bitmap_cc_tests ()
   test_clear_bit_in_middle ();
   test_copying ();
   test_bitmap_single_bit_set_p ();
+  test_changed_results ();
   /* Test 2, 4 and 8 bit aligned chunks.  */
   test_aligned_chunk (2);
   test_aligned_chunk (4);
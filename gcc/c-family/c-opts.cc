@@ -532,6 +532,10 @@ c_common_handle_option (size_t scode, const char *arg, HOST_WIDE_INT value,
       cpp_opts->wide_charset = arg;
       break;
 
+    case OPT_finclude_cache_:
+      cpp_opts->include_cache = arg;
+      break;
+
     case OPT_finput_charset_:
       cpp_opts->input_charset = arg;
       cpp_opts->cpp_input_charset_explicit = 1;
@@ -24,7 +24,7 @@ along with GCC; see the file COPYING3.  If not see
 #define INCLUDE_STRING
 #define INCLUDE_VECTOR
 #define INCLUDE_ALGORITHM
-#define INCLUDE_MAP
+#define INCLUDE_UNORDERED_MAP
 #define INCLUDE_MEMORY
 #include "system.h"
 
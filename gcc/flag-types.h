@@ -494,6 +494,13 @@ enum openacc_privatization
   OPENACC_PRIVATIZATION_NOISY
 };
 
+/* The formats of the -ftime-report output.  */
+enum time_report_format
+{
+  TIME_REPORT_FORMAT_TEXT,
+  TIME_REPORT_FORMAT_JSON
+};
+
 #endif
 
 #endif /* ! GCC_FLAG_TYPES_H */
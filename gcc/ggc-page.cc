@@ -1498,9 +1498,9 @@ gt_ggc_m_S (const void *p)
   if (entry->in_use_p[word] & mask)
     return;
 
-  /* Otherwise set it, and decrement the free object count.  */
+  /* Otherwise set it.  The free object count of the page is updated
+     from its marks when the collector sweeps it.  */
   entry->in_use_p[word] |= mask;
-  entry->num_free_objects -= 1;
 
   if (GGC_DEBUG_LEVEL >= 4)
     fprintf (G.debug_file, "Marking %p\n", p);
@@ -1560,9 +1560,9 @@ ggc_set_mark (const void *p)
   if (entry->in_use_p[word] & mask)
     return 1;
 
-  /* Otherwise set it, and decrement the free object count.  */
+  /* Otherwise set it.  The free object count of the page is updated
+     from its marks when the collector sweeps it.  */
   entry->in_use_p[word] |= mask;
-  entry->num_free_objects -= 1;
 
   if (GGC_DEBUG_LEVEL >= 4)
     fprintf (G.debug_file, "Marking %p\n", p);
@@ -1852,15 +1852,12 @@ ggc_recalculate_in_use_p (page_entry *p)
 		 sizeof (*p->in_use_p));
        ++i)
     {
-      unsigned long j;
-
       /* Something is in use if it is marked, or if it was in use in a
 	 context further down the context stack.  */
       p->in_use_p[i] |= save_in_use_p (p)[i];
 
       /* Decrement the free object count for every object allocated.  */
-      for (j = p->in_use_p[i]; j; j >>= 1)
-	p->num_free_objects -= (j & 1);
+      p->num_free_objects -= popcount_hwi (p->in_use_p[i]);
     }
 
   gcc_assert (p->num_free_objects < num_objects);
@@ -1895,9 +1892,8 @@ clear_marks (void)
 	      memcpy (save_in_use_p (p), p->in_use_p, bitmap_size);
 	    }
 
-	  /* Reset reset the number of free objects and clear the
-             in-use bits.  These will be adjusted by mark_obj.  */
-	  p->num_free_objects = num_objects;
+	  /* Clear the in-use bits; they are set again by marking, and
+	     sweep_pages counts the free objects from them.  */
 	  memset (p->in_use_p, 0, bitmap_size);
 
 	  /* Make sure the one-past-the-end bit is always set.  */
@@ -1954,6 +1950,21 @@ ggc_handle_finalizers ()
     }
 }
 
+/* Return the number of objects on page P whose in-use bit is set.  */
+
+static size_t
+count_in_use_objects (page_entry *p)
+{
+  size_t num_objects = OBJECTS_IN_PAGE (p);
+  size_t count = 0;
+
+  for (size_t i = 0; i <= num_objects / HOST_BITS_PER_LONG; i++)
+    count += popcount_hwi (p->in_use_p[i]);
+
+  /* Don't count the one-past-the-end bit.  */
+  return count - 1;
+}
+
 /* Free all empty pages.  Partially empty pages need no attention
    because the `mark' bit doubles as an `unused' bit.  */
 
@@ -1987,9 +1998,11 @@ sweep_pages (void)
 
 	  num_objects = OBJECTS_IN_PAGE (p);
 
-	  /* Add all live objects on this page to the count of
-             allocated memory.  */
-	  live_objects = num_objects - p->num_free_objects;
+	  /* Marking only sets the in-use bits, so count the live objects
+	     on the page from them.  Add them to the count of allocated
+	     memory.  */
+	  live_objects = count_in_use_objects (p);
+	  p->num_free_objects = num_objects - live_objects;
 
 	  G.allocated += OBJECT_SIZE (order) * live_objects;
 
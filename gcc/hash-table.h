@@ -974,9 +974,9 @@ hash_table<Descriptor, Lazy, Allocator>
   m_searches++;
   value_type *first_deleted_slot = NULL;
   hashval_t index = hash_table_mod1 (hash, m_size_prime_index);
-  hashval_t hash2 = hash_table_mod2 (hash, m_size_prime_index);
   value_type *entry = &m_entries[index];
   size_t size = m_size;
+  hashval_t hash2;
   if (is_empty (*entry))
     goto empty_entry;
   else if (is_deleted (*entry))
@@ -984,6 +984,9 @@ hash_table<Descriptor, Lazy, Allocator>
   else if (Descriptor::equal (*entry, comparable))
     return &m_entries[index];
 
+  /* Most lookups are resolved by the first probe, so only compute the
+     step of the probe sequence once it is needed.  */
+  hash2 = hash_table_mod2 (hash, m_size_prime_index);
   for (;;)
     {
       m_collisions++;
@@ -123,6 +123,14 @@ lto_normalized_zstd_level (void)
   return level;
 }
 
+/* The zstd compression and decompression contexts.  A translation unit
+   streams out and reads in many small sections, so the contexts are
+   created on first use and kept for the rest of the compilation rather
+   than set up and torn down again for every section.  */
+
+static ZSTD_CCtx *lto_zstd_cctx;
+static ZSTD_DCtx *lto_zstd_dctx;
+
 /* Compress STREAM using ZSTD algorithm.  */
 
 static void
@@ -135,8 +143,16 @@ lto_compression_zstd (struct lto_compression_stream *stream)
   size_t const outbuf_length = ZSTD_compressBound (size);
   char *outbuf = (char *) xmalloc (outbuf_length);
 
-  size_t const csize = ZSTD_compress (outbuf, outbuf_length, cursor, size,
-				      lto_normalized_zstd_level ());
+  if (!lto_zstd_cctx)
+    {
+      lto_zstd_cctx = ZSTD_createCCtx ();
+      if (!lto_zstd_cctx)
+	internal_error ("compressed stream: %s", "out of memory");
+    }
+
+  size_t const csize = ZSTD_compressCCtx (lto_zstd_cctx, outbuf,
+					  outbuf_length, cursor, size,
+					  lto_normalized_zstd_level ());
 
   if (ZSTD_isError (csize))
     internal_error ("compressed stream: %s", ZSTD_getErrorName (csize));
@@ -165,7 +181,15 @@ lto_uncompression_zstd (struct lto_compression_stream *stream)
     internal_error ("original size unknown");
 
   char *outbuf = (char *) xmalloc (rsize);
-  size_t const dsize = ZSTD_decompress (outbuf, rsize, cursor, size);
+  if (!lto_zstd_dctx)
+    {
+      lto_zstd_dctx = ZSTD_createDCtx ();
+      if (!lto_zstd_dctx)
+	internal_error ("decompressed stream: %s", "out of memory");
+    }
+
+  size_t const dsize = ZSTD_decompressDCtx (lto_zstd_dctx, outbuf, rsize,
+					    cursor, size);
 
   if (ZSTD_isError (dsize))
     internal_error ("decompressed stream: %s", ZSTD_getErrorName (dsize));
@@ -1393,6 +1393,7 @@ run_gcc (unsigned argc, char *argv[])
   unsigned i, j;
   const char **new_argv;
   const char **argv_ptr;
+  struct pex_obj *lto_pex;
   char *list_option_full = NULL;
   const char *linker_output = NULL;
   const char *collect_gcc;
@@ -1858,11 +1859,14 @@ cont1:
 
   new_argv = XOBFINISH (&argv_obstack, const char **);
   argv_ptr = &new_argv[new_head_argc];
-  fork_execute (new_argv[0], CONST_CAST (char **, new_argv), true,
-		"ltrans_args");
+  lto_pex = collect_execute (new_argv[0], CONST_CAST (char **, new_argv),
+			     NULL, NULL, PEX_LAST | PEX_SEARCH, true,
+			     "ltrans_args");
 
   /* Copy the early generated debug info from the objects to temporary
-     files and append those to the partial link commandline.  */
+     files and append those to the partial link commandline.  This only
+     reads the input objects, so do it while WPA (or the LTO compile)
+     is running instead of delaying the start of the LTRANS stage.  */
   early_debug_object_names = NULL;
   if (! skip_debug)
     {
@@ -1876,6 +1880,8 @@ cont1:
 	}
     }
 
+  do_wait (new_argv[0], lto_pex);
+
   if (lto_mode == LTO_MODE_LTO)
     {
       printf ("%s\n", flto_out);
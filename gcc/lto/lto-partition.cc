@@ -124,6 +124,22 @@ add_references_to_partition (ltrans_partition part, symtab_node *node)
       }
 }
 
+/* Return the size NODE accounts for in its partition.  Hot functions are
+   optimized harder by the LTRANS compile, so their size is scaled by
+   param_lto_hot_partition_weight to keep partitions holding hot code
+   from taking longer to compile than the others.  */
+
+static int
+partition_node_size (cgraph_node *node)
+{
+  int size = ipa_size_summaries->get (node)->size;
+  cgraph_node *where = node->inlined_to ? node->inlined_to : node;
+
+  if (where->frequency == NODE_FREQUENCY_HOT)
+    size = (int64_t) size * param_lto_hot_partition_weight / 100;
+  return size;
+}
+
 /* Helper function for add_symbol_to_partition doing the actual dirty work
    of adding NODE to PART.  */
 
@@ -170,7 +186,7 @@ add_symbol_to_partition_1 (ltrans_partition part, symtab_node *node)
     {
       struct cgraph_edge *e;
       if (!node->alias && c == SYMBOL_PARTITION)
-	part->insns += ipa_size_summaries->get (cnode)->size;
+	part->insns += partition_node_size (cnode);
 
       /* Add all inline clones and callees that are duplicated.  */
       for (e = cnode->callees; e; e = e->next_callee)
@@ -290,7 +306,7 @@ undo_partition (ltrans_partition partition, unsigned int n_nodes)
 
       if (!node->alias && (cnode = dyn_cast <cgraph_node *> (node))
           && node->get_partitioning_class () == SYMBOL_PARTITION)
-	partition->insns -= ipa_size_summaries->get (cnode)->size;
+	partition->insns -= partition_node_size (cnode);
       lto_symtab_encoder_delete_node (partition->encoder, node);
       node->aux = (void *)((size_t)node->aux - 1);
     }
@@ -395,6 +411,24 @@ add_sorted_nodes (vec<symtab_node *> &next_nodes, ltrans_partition partition)
       add_symbol_to_partition (partition, node);
 }
 
+/* Return the boundary cost of EDGE if its caller and callee end up in
+   different partitions.  When the profile says the call is hot, scale it
+   by param_lto_hot_partition_weight so that hot calls are kept within a
+   partition in preference to cold ones.  */
+
+static int64_t
+partition_edge_cost (cgraph_edge *edge)
+{
+  int64_t edge_cost = edge->frequency ();
+
+  if (!edge_cost)
+    edge_cost = 1;
+  if (edge->count.ipa ().initialized_p () && edge->maybe_hot_p ())
+    edge_cost = edge_cost * param_lto_hot_partition_weight / 100;
+  gcc_assert (edge_cost > 0);
+  return edge_cost;
+}
+
 /* Return true if we should account reference from N1 to N2 in cost
    of partition boundary.  */
 
@@ -499,7 +533,7 @@ lto_balanced_map (int n_lto_partitions, int max_partition_size)
 	else
 	  order.safe_push (node);
 	if (!node->alias)
-	  total_size += ipa_size_summaries->get (node)->size;
+	  total_size += partition_node_size (node);
       }
 
   original_total_size = total_size;
@@ -602,12 +636,9 @@ lto_balanced_map (int n_lto_partitions, int max_partition_size)
 		if (edge->inline_failed
 		    && account_reference_p (node, edge->callee))
 		  {
-		    int edge_cost = edge->frequency ();
+		    int64_t edge_cost = partition_edge_cost (edge);
 		    int index;
 
-		    if (!edge_cost)
-		      edge_cost = 1;
-		    gcc_assert (edge_cost > 0);
 		    index = lto_symtab_encoder_lookup (partition->encoder,
 						       edge->callee);
 		    if (index != LCC_NOT_FOUND
@@ -620,13 +651,10 @@ lto_balanced_map (int n_lto_partitions, int max_partition_size)
 		if (edge->inline_failed
 		    && account_reference_p (edge->caller, node))
 		{
-		  int edge_cost = edge->frequency ();
+		  int64_t edge_cost = partition_edge_cost (edge);
 		  int index;
 
 		  gcc_assert (edge->caller->definition);
-		  if (!edge_cost)
-		    edge_cost = 1;
-		  gcc_assert (edge_cost > 0);
 		  index = lto_symtab_encoder_lookup (partition->encoder,
 						     edge->caller);
 		  if (index != LCC_NOT_FOUND
@@ -63,6 +63,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "diagnostic-core.h" /* for fnotice */
 #include "stringpool.h"
 #include "attribs.h"
+#include "demangle.h"
 
 using namespace gcc;
 
@@ -2306,6 +2307,78 @@ execute_ipa_summary_passes (ipa_opt_pass_d *ipa_pass)
     }
 }
 
+/* For -ftime-report-functions=N, the N runs of a pass on a single
+   function that took the most time, longest first.  */
+
+struct function_pass_cost
+{
+  /* The assembler name of the function and the name of the pass, both
+     owned by the entry.  */
+  char *fn_name;
+  char *pass_name;
+  /* The run time of the pass on the function, in microseconds.  */
+  long usecs;
+  /* The GGC memory allocated while it ran.  */
+  size_t ggc_mem;
+};
+
+static vec<function_pass_cost> function_pass_costs;
+
+/* The end of a run of PASS on FNDECL that started at run time START_USECS
+   with START_GGC bytes of GGC memory allocated in total: record it if it
+   is among the -ftime-report-functions most expensive ones.  */
+
+static void
+record_function_pass_cost (tree fndecl, opt_pass *pass, long start_usecs,
+			   size_t start_ggc)
+{
+  unsigned limit = flag_time_report_functions;
+  long usecs = get_run_time () - start_usecs;
+  if (function_pass_costs.length () == limit
+      && usecs <= function_pass_costs.last ().usecs)
+    return;
+
+  if (function_pass_costs.length () == limit)
+    {
+      function_pass_cost evicted = function_pass_costs.pop ();
+      free (evicted.fn_name);
+      free (evicted.pass_name);
+    }
+
+  function_pass_cost cost;
+  cost.fn_name = xstrdup (IDENTIFIER_POINTER (DECL_ASSEMBLER_NAME (fndecl)));
+  cost.pass_name = xstrdup (pass->name ? pass->name : "");
+  cost.usecs = usecs;
+  cost.ggc_mem = timevar_ggc_mem_total - start_ggc;
+
+  unsigned i = function_pass_costs.length ();
+  while (i > 0 && function_pass_costs[i - 1].usecs < usecs)
+    i--;
+  function_pass_costs.safe_insert (i, cost);
+}
+
+/* Print the runs recorded for -ftime-report-functions to FP.  */
+
+void
+print_function_pass_costs (FILE *fp)
+{
+  if (function_pass_costs.is_empty ())
+    return;
+
+  fprintf (fp, "\n%-30s%12s%12s  %s\n", "Pass", "usr+sys", "GGC",
+	   "Function");
+  for (const function_pass_cost &cost : function_pass_costs)
+    {
+      char *demangled = cplus_demangle (cost.fn_name, DMGL_PARAMS | DMGL_ANSI);
+      fprintf (fp, " %-29s%12.3f" PRsa (11) "  %s", cost.pass_name,
+	       cost.usecs / 1e6, SIZE_AMOUNT (cost.ggc_mem), cost.fn_name);
+      if (demangled)
+	fprintf (fp, " (%s)", demangled);
+      fputc ('\n', fp);
+      free (demangled);
+    }
+}
+
 /* Execute IPA_PASS function transform on NODE.  */
 
 static void
@@ -2325,6 +2398,9 @@ execute_one_ipa_transform_pass (struct cgraph_node *node,
 
   pass_init_dump_file (pass);
 
+  long start_usecs = flag_time_report_functions ? get_run_time () : 0;
+  size_t start_ggc = timevar_ggc_mem_total;
+
   /* If a timevar is present, start it.  */
   if (pass->tv_id != TV_NONE)
     timevar_push (pass->tv_id);
@@ -2343,6 +2419,9 @@ execute_one_ipa_transform_pass (struct cgraph_node *node,
   if (pass->tv_id != TV_NONE)
     timevar_pop (pass->tv_id);
 
+  if (flag_time_report_functions)
+    record_function_pass_cost (node->decl, pass, start_usecs, start_ggc);
+
   if (dump_file)
     do_per_function (execute_function_dump, pass);
   pass_fini_dump_file (pass);
@@ -2628,6 +2707,12 @@ execute_one_pass (opt_pass *pass)
 
   pass_init_dump_file (pass);
 
+  /* Only passes over a single function are attributed to one for
+     -ftime-report-functions.  */
+  tree timed_fndecl = flag_time_report_functions && cfun ? cfun->decl : NULL;
+  long start_usecs = timed_fndecl ? get_run_time () : 0;
+  size_t start_ggc = timevar_ggc_mem_total;
+
   /* If a timevar is present, start it.  */
   if (pass->tv_id != TV_NONE)
     timevar_push (pass->tv_id);
@@ -2649,6 +2734,10 @@ execute_one_pass (opt_pass *pass)
       if (pass->tv_id != TV_NONE)
 	timevar_pop (pass->tv_id);
 
+      if (timed_fndecl)
+	record_function_pass_cost (timed_fndecl, pass, start_usecs,
+				   start_ggc);
+
       pass_fini_dump_file (pass);
 
       gcc_assert (cfun);
@@ -2699,6 +2788,9 @@ execute_one_pass (opt_pass *pass)
   if (pass->tv_id != TV_NONE)
     timevar_pop (pass->tv_id);
 
+  if (timed_fndecl)
+    record_function_pass_cost (timed_fndecl, pass, start_usecs, start_ggc);
+
   if (pass->type == IPA_PASS
       && ((ipa_opt_pass_d *)pass)->function_transform)
     {
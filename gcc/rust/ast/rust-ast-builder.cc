@@ -0,0 +1,286 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-ast-builder.h"
+
+namespace Rust {
+namespace AST {
+
+PathInExpression
+AstBuilder::path_in_expression (std::vector<std::string> segments)
+{
+  std::vector<PathExprSegment> path_segments;
+  for (auto &seg : segments)
+    path_segments.push_back (PathExprSegment (std::move (seg), loc));
+
+  return PathInExpression (std::move (path_segments), {}, loc);
+}
+
+TypePath
+AstBuilder::type_path (std::string name, std::vector<GenericArg> args,
+		       std::vector<Lifetime> lifetimes)
+{
+  std::vector<std::unique_ptr<TypePathSegment>> segments;
+  if (args.empty () && lifetimes.empty ())
+    segments.push_back (std::unique_ptr<TypePathSegment> (
+      new TypePathSegment (std::move (name), false, loc)));
+  else
+    segments.push_back (std::unique_ptr<TypePathSegment> (
+      new TypePathSegmentGeneric (std::move (name), false,
+				  std::move (lifetimes), std::move (args), {},
+				  loc)));
+
+  return TypePath (std::move (segments), loc);
+}
+
+std::unique_ptr<Type>
+AstBuilder::type (TypePath path)
+{
+  return std::unique_ptr<Type> (new TypePath (std::move (path)));
+}
+
+std::unique_ptr<Type>
+AstBuilder::reference_type (TypePath path, bool is_mut)
+{
+  return std::unique_ptr<Type> (
+    new ReferenceType (is_mut,
+		       std::unique_ptr<TypeNoBounds> (
+			 new TypePath (std::move (path))),
+		       loc));
+}
+
+std::unique_ptr<TypeParamBound>
+AstBuilder::trait_bound (std::string trait_name)
+{
+  return std::unique_ptr<TypeParamBound> (
+    new TraitBound (type_path (std::move (trait_name)), loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::identifier (std::string name)
+{
+  return std::unique_ptr<Expr> (new IdentifierExpr (std::move (name), {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::path (std::vector<std::string> segments)
+{
+  return std::unique_ptr<Expr> (
+    new PathInExpression (path_in_expression (std::move (segments))));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::qualified_call (std::unique_ptr<Type> type, std::string trait_name,
+			    std::string fn_name)
+{
+  QualifiedPathType qual_type (std::move (type), loc,
+			       type_path (std::move (trait_name)));
+  std::vector<PathExprSegment> segments;
+  segments.push_back (PathExprSegment (std::move (fn_name), loc));
+
+  std::unique_ptr<Expr> callee (
+    new QualifiedPathInExpression (std::move (qual_type), std::move (segments),
+				   {}, loc));
+  return call (std::move (callee));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::call (std::unique_ptr<Expr> callee,
+		  std::vector<std::unique_ptr<Expr>> args)
+{
+  return std::unique_ptr<Expr> (
+    new CallExpr (std::move (callee), std::move (args), {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::method_call (std::unique_ptr<Expr> receiver, std::string name,
+			 std::vector<std::unique_ptr<Expr>> args)
+{
+  return std::unique_ptr<Expr> (
+    new MethodCallExpr (std::move (receiver),
+			PathExprSegment (std::move (name), loc),
+			std::move (args), {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::field_access (std::unique_ptr<Expr> receiver, std::string field)
+{
+  return std::unique_ptr<Expr> (
+    new FieldAccessExpr (std::move (receiver), std::move (field), {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::tuple_index (std::unique_ptr<Expr> receiver, TupleIndex index)
+{
+  return std::unique_ptr<Expr> (
+    new TupleIndexExpr (std::move (receiver), index, {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::deref (std::unique_ptr<Expr> expr)
+{
+  return std::unique_ptr<Expr> (
+    new DereferenceExpr (std::move (expr), {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::borrow (std::unique_ptr<Expr> expr)
+{
+  return std::unique_ptr<Expr> (
+    new BorrowExpr (std::move (expr), false, false, {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::comparison (std::unique_ptr<Expr> lhs, std::unique_ptr<Expr> rhs,
+			ComparisonOperator op)
+{
+  return std::unique_ptr<Expr> (
+    new ComparisonExpr (std::move (lhs), std::move (rhs), op, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::lazy_and (std::unique_ptr<Expr> lhs, std::unique_ptr<Expr> rhs)
+{
+  return std::unique_ptr<Expr> (
+    new LazyBooleanExpr (std::move (lhs), std::move (rhs),
+			 LazyBooleanOperator::LOGICAL_AND, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::literal_bool (bool value)
+{
+  return std::unique_ptr<Expr> (
+    new LiteralExpr (value ? "true" : "false", Literal::LitType::BOOL,
+		     PrimitiveCoreType::CORETYPE_BOOL, {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::literal_isize (int value)
+{
+  return std::unique_ptr<Expr> (
+    new LiteralExpr (std::to_string (value), Literal::LitType::INT,
+		     PrimitiveCoreType::CORETYPE_ISIZE, {}, loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::struct_expr (PathInExpression path,
+			 std::vector<std::unique_ptr<StructExprField>> fields)
+{
+  return std::unique_ptr<Expr> (
+    new StructExprStructFields (std::move (path), std::move (fields), loc));
+}
+
+std::unique_ptr<StructExprField>
+AstBuilder::struct_expr_field (std::string name, std::unique_ptr<Expr> value)
+{
+  return std::unique_ptr<StructExprField> (
+    new StructExprFieldIdentifierValue (std::move (name), std::move (value),
+					loc));
+}
+
+std::unique_ptr<Expr>
+AstBuilder::match (std::unique_ptr<Expr> scrutinee,
+		   std::vector<MatchCase> cases)
+{
+  return std::unique_ptr<Expr> (
+    new MatchExpr (std::move (scrutinee), std::move (cases), {}, {}, loc));
+}
+
+MatchCase
+AstBuilder::match_case (std::unique_ptr<Pattern> pattern,
+			std::unique_ptr<Expr> expr)
+{
+  std::vector<std::unique_ptr<Pattern>> patterns;
+  patterns.push_back (std::move (pattern));
+
+  return MatchCase (MatchArm (std::move (patterns), loc), std::move (expr));
+}
+
+std::unique_ptr<BlockExpr>
+AstBuilder::block (std::vector<std::unique_ptr<Stmt>> stmts,
+		   std::unique_ptr<Expr> tail)
+{
+  return std::unique_ptr<BlockExpr> (
+    new BlockExpr (std::move (stmts), std::move (tail), {}, {}, loc, loc));
+}
+
+std::unique_ptr<Stmt>
+AstBuilder::statementify (std::unique_ptr<Expr> expr)
+{
+  if (expr->is_expr_without_block ())
+    return std::unique_ptr<Stmt> (new ExprStmtWithoutBlock (
+      std::unique_ptr<ExprWithoutBlock> (
+	static_cast<ExprWithoutBlock *> (expr.release ())),
+      loc));
+
+  return std::unique_ptr<Stmt> (
+    new ExprStmtWithBlock (std::unique_ptr<ExprWithBlock> (
+			     static_cast<ExprWithBlock *> (expr.release ())),
+			   loc, true));
+}
+
+std::unique_ptr<Pattern>
+AstBuilder::identifier_pattern (std::string name)
+{
+  return std::unique_ptr<Pattern> (
+    new IdentifierPattern (std::move (name), loc));
+}
+
+std::unique_ptr<Pattern>
+AstBuilder::wildcard ()
+{
+  return std::unique_ptr<Pattern> (new WildcardPattern (loc));
+}
+
+std::unique_ptr<Pattern>
+AstBuilder::path_pattern (std::vector<std::string> segments)
+{
+  return std::unique_ptr<Pattern> (
+    new PathInExpression (path_in_expression (std::move (segments))));
+}
+
+std::unique_ptr<Pattern>
+AstBuilder::tuple_struct_pattern (std::vector<std::string> segments,
+				  std::vector<std::unique_ptr<Pattern>> fields)
+{
+  std::unique_ptr<TupleStructItems> items (
+    new TupleStructItemsNoRange (std::move (fields)));
+
+  return std::unique_ptr<Pattern> (
+    new TupleStructPattern (path_in_expression (std::move (segments)),
+			    std::move (items)));
+}
+
+std::unique_ptr<Pattern>
+AstBuilder::struct_pattern (
+  std::vector<std::string> segments,
+  std::vector<std::pair<std::string, std::unique_ptr<Pattern>>> fields)
+{
+  std::vector<std::unique_ptr<StructPatternField>> pattern_fields;
+  for (auto &field : fields)
+    pattern_fields.push_back (std::unique_ptr<StructPatternField> (
+      new StructPatternFieldIdentPat (std::move (field.first),
+				      std::move (field.second), {}, loc)));
+
+  return std::unique_ptr<Pattern> (
+    new StructPattern (path_in_expression (std::move (segments)), loc,
+		       StructPatternElements (std::move (pattern_fields))));
+}
+
+} // namespace AST
+} // namespace Rust
@@ -0,0 +1,104 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_AST_BUILDER_H
+#define RUST_AST_BUILDER_H
+
+#include "rust-ast-full.h"
+
+namespace Rust {
+namespace AST {
+
+/* Builds AST nodes directly, for the parts of the expander which generate
+ * code themselves rather than going through tokens and the parser. Every node
+ * is located at the builder's location and gets a fresh NodeId. */
+class AstBuilder
+{
+public:
+  AstBuilder (Location loc) : loc (loc) {}
+
+  /* Paths */
+  PathInExpression path_in_expression (std::vector<std::string> segments);
+  TypePath type_path (std::string name, std::vector<GenericArg> args = {},
+		      std::vector<Lifetime> lifetimes = {});
+
+  /* Types */
+  std::unique_ptr<Type> type (TypePath path);
+  std::unique_ptr<Type> reference_type (TypePath path, bool is_mut = false);
+  std::unique_ptr<TypeParamBound> trait_bound (std::string trait_name);
+
+  /* Expressions */
+  std::unique_ptr<Expr> identifier (std::string name);
+  std::unique_ptr<Expr> path (std::vector<std::string> segments);
+  std::unique_ptr<Expr> qualified_call (std::unique_ptr<Type> type,
+					std::string trait_name,
+					std::string fn_name);
+  std::unique_ptr<Expr> call (std::unique_ptr<Expr> callee,
+			      std::vector<std::unique_ptr<Expr>> args = {});
+  std::unique_ptr<Expr> method_call (std::unique_ptr<Expr> receiver,
+				     std::string name,
+				     std::vector<std::unique_ptr<Expr>> args
+				     = {});
+  std::unique_ptr<Expr> field_access (std::unique_ptr<Expr> receiver,
+				      std::string field);
+  std::unique_ptr<Expr> tuple_index (std::unique_ptr<Expr> receiver,
+				     TupleIndex index);
+  std::unique_ptr<Expr> deref (std::unique_ptr<Expr> expr);
+  std::unique_ptr<Expr> borrow (std::unique_ptr<Expr> expr);
+  std::unique_ptr<Expr> comparison (std::unique_ptr<Expr> lhs,
+				    std::unique_ptr<Expr> rhs,
+				    ComparisonOperator op);
+  std::unique_ptr<Expr> lazy_and (std::unique_ptr<Expr> lhs,
+				  std::unique_ptr<Expr> rhs);
+  std::unique_ptr<Expr> literal_bool (bool value);
+  std::unique_ptr<Expr> literal_isize (int value);
+  std::unique_ptr<Expr>
+  struct_expr (PathInExpression path,
+	       std::vector<std::unique_ptr<StructExprField>> fields);
+  std::unique_ptr<StructExprField> struct_expr_field (std::string name,
+						      std::unique_ptr<Expr> value);
+  std::unique_ptr<Expr> match (std::unique_ptr<Expr> scrutinee,
+			       std::vector<MatchCase> cases);
+  MatchCase match_case (std::unique_ptr<Pattern> pattern,
+			std::unique_ptr<Expr> expr);
+  std::unique_ptr<BlockExpr> block (std::vector<std::unique_ptr<Stmt>> stmts,
+				    std::unique_ptr<Expr> tail = nullptr);
+
+  /* Statements */
+  std::unique_ptr<Stmt> statementify (std::unique_ptr<Expr> expr);
+
+  /* Patterns */
+  std::unique_ptr<Pattern> identifier_pattern (std::string name);
+  std::unique_ptr<Pattern> wildcard ();
+  std::unique_ptr<Pattern> path_pattern (std::vector<std::string> segments);
+  std::unique_ptr<Pattern>
+  tuple_struct_pattern (std::vector<std::string> segments,
+			std::vector<std::unique_ptr<Pattern>> fields);
+  std::unique_ptr<Pattern>
+  struct_pattern (std::vector<std::string> segments,
+		  std::vector<std::pair<std::string, std::unique_ptr<Pattern>>>
+		    fields);
+
+private:
+  Location loc;
+};
+
+} // namespace AST
+} // namespace Rust
+
+#endif // RUST_AST_BUILDER_H
@@ -43,7 +43,9 @@ Indent::decrement ()
   tabs--;
 }
 
-Dump::Dump (std::ostream &stream) : stream (stream), indentation (Indent ()) {}
+Dump::Dump (std::ostream &stream)
+  : stream (stream), indentation (Indent ()), complete (true)
+{}
 
 void
 Dump::go (AST::Crate &crate)
@@ -62,6 +64,35 @@ Dump::go (AST::Item &item)
   item.accept_vis (*this);
 }
 
+void
+Dump::go_extern_signature (AST::Function &function, const std::string &abi)
+{
+  stream << "extern \"" << abi << "\" {\n";
+  indentation.increment ();
+
+  stream << indentation << "fn " << function.get_function_name () << '(';
+  auto &params = function.get_function_params ();
+  for (size_t i = 0; i < params.size (); i++)
+    {
+      bool has_next = (i + 1) < params.size ();
+
+      format_function_param (params[i]);
+      if (has_next)
+	stream << ", ";
+    }
+
+  stream << ')';
+  if (function.has_return_type ())
+    {
+      stream << "-> ";
+      function.get_return_type ()->accept_vis (*this);
+    }
+  stream << ";\n";
+
+  indentation.decrement ();
+  stream << "\n" << indentation << "}\n";
+}
+
 void
 Dump::format_function_param (FunctionParam &param)
 {
@@ -143,7 +174,9 @@ Dump::visit (LifetimeParam &lifetime_param)
 
 void
 Dump::visit (ConstGenericParam &lifetime_param)
-{}
+{
+  complete = false;
+}
 
 // rust-path.h
 void
@@ -178,7 +211,9 @@ Dump::visit (QualifiedPathInExpression &path)
 
 void
 Dump::visit (QualifiedPathInType &path)
-{}
+{
+  complete = false;
+}
 
 // rust-expr.h
 void
@@ -201,19 +236,27 @@ Dump::visit (MetaItemPathLit &meta_item)
 
 void
 Dump::visit (BorrowExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (DereferenceExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ErrorPropagationExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (NegationExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ArithmeticOrLogicalExpr &expr)
@@ -269,75 +312,111 @@ Dump::visit (ArithmeticOrLogicalExpr &expr)
 
 void
 Dump::visit (ComparisonExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (LazyBooleanExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TypeCastExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (AssignmentExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (CompoundAssignmentExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (GroupedExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ArrayElemsValues &elems)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ArrayElemsCopied &elems)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ArrayExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ArrayIndexExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TupleExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TupleIndexExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructExprStruct &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructExprFieldIdentifier &field)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructExprFieldIdentifierValue &field)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructExprFieldIndexValue &field)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructExprStructFields &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructExprStructBase &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (CallExpr &expr)
@@ -361,15 +440,21 @@ Dump::visit (CallExpr &expr)
 
 void
 Dump::visit (MethodCallExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (FieldAccessExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ClosureExprInner &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (BlockExpr &expr)
@@ -397,107 +482,159 @@ Dump::visit (BlockExpr &expr)
 
 void
 Dump::visit (ClosureExprInnerTyped &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ContinueExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (BreakExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangeFromToExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangeFromExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangeToExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangeFullExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangeFromToInclExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangeToInclExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ReturnExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (UnsafeBlockExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (LoopExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (WhileLoopExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (WhileLetLoopExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ForLoopExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfExprConseqElse &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfExprConseqIf &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfExprConseqIfLet &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfLetExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfLetExprConseqElse &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfLetExprConseqIf &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IfLetExprConseqIfLet &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (MatchExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (AwaitExpr &expr)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (AsyncBlockExpr &expr)
-{}
+{
+  complete = false;
+}
 
 // rust-item.h
 void
@@ -517,7 +654,9 @@ Dump::visit (LifetimeWhereClauseItem &item)
 
 void
 Dump::visit (TypeBoundWhereClauseItem &item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (Method &method)
@@ -554,27 +693,39 @@ Dump::visit (Method &method)
 
 void
 Dump::visit (Module &module)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ExternCrate &crate)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (UseTreeGlob &use_tree)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (UseTreeList &use_tree)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (UseTreeRebind &use_tree)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (UseDeclaration &use_decl)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (Function &function)
@@ -628,47 +779,69 @@ Dump::visit (Function &function)
 
 void
 Dump::visit (TypeAlias &type_alias)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructStruct &struct_item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TupleStruct &tuple_struct)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (EnumItem &item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (EnumItemTuple &item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (EnumItemStruct &item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (EnumItemDiscriminant &item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (Enum &enum_item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (Union &union_item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ConstantItem &const_item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StaticItem &static_item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::format_function_common (std::unique_ptr<Type> &return_type,
@@ -829,7 +1002,9 @@ Dump::visit (TraitImpl &impl)
 
 void
 Dump::visit (ExternalStaticItem &item)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ExternalFunctionItem &function)
@@ -897,7 +1072,9 @@ Dump::visit (MacroRulesDefinition &rules_def)
 
 void
 Dump::visit (MacroInvocation &macro_invoc)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (MetaItemPath &meta_item)
@@ -926,93 +1103,138 @@ Dump::visit (MetaListNameValueStr &meta_item)
 // rust-pattern.h
 void
 Dump::visit (LiteralPattern &pattern)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (IdentifierPattern &pattern)
 {
+  if (pattern.get_is_ref ())
+    stream << "ref ";
+  if (pattern.get_is_mut ())
+    stream << "mut ";
   stream << pattern.get_ident ();
+
+  if (pattern.has_pattern_to_bind ())
+    complete = false;
 }
 
 void
 Dump::visit (WildcardPattern &pattern)
-{}
+{
+  stream << '_';
+}
 
 // void Dump::visit(RangePatternBound& bound){}
 
 void
 Dump::visit (RangePatternBoundLiteral &bound)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangePatternBoundPath &bound)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangePatternBoundQualPath &bound)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RangePattern &pattern)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ReferencePattern &pattern)
-{}
+{
+  complete = false;
+}
 
 // void Dump::visit(StructPatternField& field){}
 
 void
 Dump::visit (StructPatternFieldTuplePat &field)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructPatternFieldIdentPat &field)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructPatternFieldIdent &field)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (StructPattern &pattern)
-{}
+{
+  complete = false;
+}
 
 // void Dump::visit(TupleStructItems& tuple_items){}
 
 void
 Dump::visit (TupleStructItemsNoRange &tuple_items)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TupleStructItemsRange &tuple_items)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TupleStructPattern &pattern)
-{}
+{
+  complete = false;
+}
 
 // void Dump::visit(TuplePatternItems& tuple_items){}
 
 void
 Dump::visit (TuplePatternItemsMultiple &tuple_items)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TuplePatternItemsRanged &tuple_items)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TuplePattern &pattern)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (GroupedPattern &pattern)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (SlicePattern &pattern)
-{}
+{
+  complete = false;
+}
 
 // rust-stmt.h
 void
@@ -1055,39 +1277,57 @@ Dump::visit (ExprStmtWithBlock &stmt)
 // rust-type.h
 void
 Dump::visit (TraitBound &bound)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ImplTraitType &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TraitObjectType &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ParenthesisedType &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ImplTraitTypeOneBound &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TraitObjectTypeOneBound &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (TupleType &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (NeverType &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (RawPointerType &type)
-{}
+{
+  complete = false;
+}
 
 void
 Dump::visit (ReferenceType &type)
@@ -1115,7 +1355,9 @@ Dump::visit (InferredType &type)
 
 void
 Dump::visit (BareFunctionType &type)
-{}
+{
+  complete = false;
+}
 
 } // namespace AST
 } // namespace Rust
@@ -52,6 +52,20 @@ public:
   void go (AST::Crate &crate);
   void go (AST::Item &item);
 
+  /**
+   * Emit FUNCTION's signature as the single item of an extern block with the
+   * given ABI, the same text as dumping an equivalent ExternBlock but without
+   * having to build one
+   */
+  void go_extern_signature (AST::Function &function, const std::string &abi);
+
+  /**
+   * Whether everything dumped so far was printed in full. Nodes the dumper
+   * does not know how to print yet are left out of the output, which then
+   * cannot be parsed back as the same code.
+   */
+  bool is_complete () const { return complete; }
+
   /**
    * Use the AST Dump as a debugging tool
    */
@@ -71,6 +85,7 @@ public:
 private:
   std::ostream &stream;
   Indent indentation;
+  bool complete;
 
   // Format together common items of functions: Parameters, return type, block
   void format_function_common (std::unique_ptr<Type> &return_type,
@@ -88,6 +103,7 @@ private:
   std::ostream &emit_indented_string (const std::string &value,
 				      const std::string &comment = "");
 
+protected:
   // rust-ast.h
   void visit (Token &tok);
   void visit (DelimTokenTree &delim_tok_tree);
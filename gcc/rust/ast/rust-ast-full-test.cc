@@ -3961,11 +3961,10 @@ filename_from_path_attribute (std::vector<Attribute> &outer_attrs)
   return extract_module_path ({}, outer_attrs, "");
 }
 
-void
-Module::process_file_path ()
+std::string
+Module::find_module_file (bool report_errors)
 {
   rust_assert (kind == Module::ModuleKind::UNLOADED);
-  rust_assert (module_file.empty ());
 
   // This corresponds to the path of the file 'including' the module. So the
   // file that contains the 'mod <file>;' directive
@@ -3994,10 +3993,7 @@ Module::process_file_path ()
 
   auto path_string = filename_from_path_attribute (get_outer_attrs ());
   if (!path_string.empty ())
-    {
-      module_file = current_directory_name + path_string;
-      return;
-    }
+    return current_directory_name + path_string;
 
   // FIXME: We also have to search for
   // <directory>/<including_fname>/<module_name>.rs In rustc, this is done via
@@ -4016,20 +4012,56 @@ Module::process_file_path ()
   bool multiple_candidates_found = file_mod_found && dir_mod_found;
   bool no_candidates_found = !file_mod_found && !dir_mod_found;
 
-  if (multiple_candidates_found)
+  if (multiple_candidates_found && report_errors)
     rust_error_at (locus,
 		   "two candidates found for module %s: %s.rs and %s%smod.rs",
 		   module_name.c_str (), module_name.c_str (),
 		   module_name.c_str (), file_separator);
 
-  if (no_candidates_found)
+  if (no_candidates_found && report_errors)
     rust_error_at (locus, "no candidate found for module %s",
 		   module_name.c_str ());
 
   if (no_candidates_found || multiple_candidates_found)
+    return "";
+
+  return file_mod_found ? file_mod_path : dir_mod_path;
+}
+
+void
+Module::process_file_path ()
+{
+  rust_assert (module_file.empty ());
+  module_file = find_module_file (true);
+}
+
+void
+Module::prefetch_file ()
+{
+#ifdef POSIX_FADV_WILLNEED
+  if (kind != Module::ModuleKind::UNLOADED || !module_file.empty ())
+    return;
+
+  // any error is reported once the module is actually loaded
+  std::string path = find_module_file (false);
+  if (path.empty ())
     return;
 
-  module_file = std::move (file_mod_found ? file_mod_path : dir_mod_path);
+  int fd = open (path.c_str (), O_RDONLY);
+  if (fd < 0)
+    return;
+
+  posix_fadvise (fd, 0, 0, POSIX_FADV_WILLNEED);
+  close (fd);
+#endif
+}
+
+void
+Module::prefetch_files (std::vector<std::unique_ptr<Item>> &items)
+{
+  for (auto &item : items)
+    if (item->get_ast_kind () == Kind::MODULE)
+      static_cast<Module *> (item.get ())->prefetch_file ();
 }
 
 void
@@ -4052,6 +4084,7 @@ Module::load_items ()
     }
 
   rust_debug ("Attempting to parse file %s", module_file.c_str ());
+  Session::get_instance ().add_dependency (module_file);
 
   Lexer lex (module_file.c_str (), std::move (file_wrap), linemap);
   Parser<Lexer> parser (lex);
@@ -25,6 +25,7 @@
 #include "rust-token.h"
 #include "rust-location.h"
 #include "rust-diagnostics.h"
+#include "rust-pool-allocator.h"
 
 namespace Rust {
 // TODO: remove typedefs and make actual types for these
@@ -44,10 +45,22 @@ enum Kind
   UNKNOWN,
   MACRO_RULES_DEFINITION,
   MACRO_INVOCATION,
+  MODULE,
+  EXTERN_CRATE,
+  STRUCT_STRUCT,
+  TUPLE_STRUCT,
+  ENUM,
+  ENUM_ITEM,
+  ENUM_ITEM_TUPLE,
+  ENUM_ITEM_STRUCT,
+  ENUM_ITEM_DISCRIMINANT,
+  UNION,
+  ARITHMETIC_OR_LOGICAL_EXPR,
+  METHOD_CALL_EXPR,
 };
 
 // Abstract base class for all AST elements
-class Node
+class Node : public PoolAllocated
 {
 public:
   /**
@@ -72,7 +85,7 @@ enum DelimType
 class Token;
 
 // A tree of tokens (or a single token) - abstract base class
-class TokenTree
+class TokenTree : public PoolAllocated
 {
 public:
   virtual ~TokenTree () {}
@@ -97,7 +110,7 @@ protected:
 };
 
 // Abstract base class for a macro match
-class MacroMatch
+class MacroMatch : public PoolAllocated
 {
 public:
   enum MacroMatchType
@@ -572,7 +585,7 @@ protected:
 };
 
 // Attribute body - abstract base class
-class AttrInput
+class AttrInput : public PoolAllocated
 {
 public:
   enum AttrInputType
@@ -615,7 +628,7 @@ protected:
 class MetaNameValueStr;
 
 // abstract base meta item inner class
-class MetaItemInner
+class MetaItemInner : public PoolAllocated
 {
 protected:
   // pure virtual as MetaItemInner
@@ -914,7 +927,16 @@ public:
   // behavior that we have items that can also be expressions?
   bool is_item () const override { return true; }
 
+  /* Set by the parser when nothing after the item's outer attributes is an
+   * attribute, a macro invocation or a macro definition. cfg-stripping and
+   * macro expansion then have nothing to do below the item's own outer
+   * attributes and can skip walking it. */
+  void mark_expansion_free () { expansion_free = true; }
+  bool is_expansion_free () const { return expansion_free; }
+
 protected:
+  bool expansion_free = false;
+
   // Clone function implementation as pure virtual method
   virtual Item *clone_item_impl () const = 0;
 
@@ -1071,7 +1093,7 @@ protected:
 };
 
 // Pattern base AST node
-class Pattern
+class Pattern : public PoolAllocated
 {
 public:
   // Unique pointer custom clone function
@@ -1169,7 +1191,7 @@ protected:
 
 /* Abstract base class representing a type param bound - Lifetime and TraitBound
  * extends it */
-class TypeParamBound
+class TypeParamBound : public PoolAllocated
 {
 public:
   virtual ~TypeParamBound () {}
@@ -1258,7 +1280,7 @@ protected:
 
 /* Base generic parameter in AST. Abstract - can be represented by a Lifetime or
  * Type param */
-class GenericParam
+class GenericParam : public PoolAllocated
 {
 public:
   enum class Kind
@@ -1354,7 +1376,7 @@ class MacroItem : public Item
 };
 
 // Item used in trait declarations - abstract base class
-class TraitItem
+class TraitItem : public PoolAllocated
 {
 protected:
   TraitItem () : node_id (Analysis::Mappings::get ()->get_next_node_id ()) {}
@@ -1385,7 +1407,7 @@ public:
 
 /* Abstract base class for items used within an inherent impl block (the impl
  * name {} one) */
-class InherentImplItem
+class InherentImplItem : public PoolAllocated
 {
 protected:
   // Clone function implementation as pure virtual method
@@ -1411,7 +1433,7 @@ public:
 };
 
 // Abstract base class for items used in a trait impl
-class TraitImplItem
+class TraitImplItem : public PoolAllocated
 {
 protected:
   virtual TraitImplItem *clone_trait_impl_item_impl () const = 0;
@@ -1434,7 +1456,7 @@ public:
 };
 
 // Abstract base class for an item used inside an extern block
-class ExternalItem
+class ExternalItem : public PoolAllocated
 {
 public:
   ExternalItem () : node_id (Analysis::Mappings::get ()->get_next_node_id ()) {}
@@ -457,6 +457,11 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override
+  {
+    return Kind::ARITHMETIC_OR_LOGICAL_EXPR;
+  }
+
   // TODO: is this better? Or is a "vis_block" better?
   std::unique_ptr<Expr> &get_left_expr ()
   {
@@ -2005,6 +2010,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::METHOD_CALL_EXPR; }
+
   // Invalid if receiver expr is null, so base stripping on that.
   void mark_for_strip () override { receiver = nullptr; }
   bool is_marked_for_strip () const override { return receiver == nullptr; }
@@ -2333,6 +2340,7 @@ class BlockExpr : public ExprWithBlock
   Location start_locus;
   Location end_locus;
   bool marked_for_strip = false;
+  bool expansion_free = false;
 
 public:
   std::string as_string () const override;
@@ -2358,7 +2366,8 @@ public:
   BlockExpr (BlockExpr const &other)
     : ExprWithBlock (other), outer_attrs (other.outer_attrs),
       inner_attrs (other.inner_attrs), start_locus (other.start_locus),
-      end_locus (other.end_locus), marked_for_strip (other.marked_for_strip)
+      end_locus (other.end_locus), marked_for_strip (other.marked_for_strip),
+      expansion_free (other.expansion_free)
   {
     // guard to protect from null pointer dereference
     if (other.expr != nullptr)
@@ -2377,6 +2386,7 @@ public:
     start_locus = other.start_locus;
     end_locus = other.end_locus;
     marked_for_strip = other.marked_for_strip;
+    expansion_free = other.expansion_free;
     outer_attrs = other.outer_attrs;
 
     // guard to protect from null pointer dereference
@@ -2413,6 +2423,11 @@ public:
   void mark_for_strip () override { marked_for_strip = true; }
   bool is_marked_for_strip () const override { return marked_for_strip; }
 
+  /* Set by the parser when there is no attribute, macro invocation or macro
+   * definition between the braces, see Item::is_expansion_free. */
+  void mark_expansion_free () { expansion_free = true; }
+  bool is_expansion_free () const { return expansion_free; }
+
   size_t num_statements () const { return statements.size (); }
 
   // TODO: this mutable getter seems really dodgy. Think up better way.
@@ -1002,6 +1002,9 @@ private:
   // error occured when dealing with UNLOADED modules
   std::string module_file;
 
+  // Path of the file an external module is found in, or an empty string
+  std::string find_module_file (bool report_errors);
+
   void clone_items (const std::vector<std::unique_ptr<Item>> &other_items)
   {
     items.reserve (other_items.size ());
@@ -1077,11 +1080,18 @@ public:
   // Search for the filename associated with an external module, storing it in
   // module_file
   void process_file_path ();
+  /* Ask the kernel to start reading the file of an external module in the
+   * background, so that it is in the page cache by the time it is loaded. */
+  void prefetch_file ();
+  // Prefetch the files of the external modules declared among ITEMS
+  static void prefetch_files (std::vector<std::unique_ptr<Item>> &items);
   // Load the items contained in an external module
   void load_items ();
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::MODULE; }
+
   /* Override that runs the function recursively on all items contained within
    * the module. */
   void add_crate_name (std::vector<std::string> &names) const override;
@@ -1153,6 +1163,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::EXTERN_CRATE; }
+
   const std::string &get_referenced_crate () const { return referenced_crate; }
   const std::string &get_as_clause () const { return as_clause_name; }
 
@@ -2018,6 +2030,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::STRUCT_STRUCT; }
+
   // TODO: this mutable getter seems really dodgy. Think up better way.
   std::vector<StructField> &get_fields () { return fields; }
   const std::vector<StructField> &get_fields () const { return fields; }
@@ -2146,6 +2160,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::TUPLE_STRUCT; }
+
   // TODO: this mutable getter seems really dodgy. Think up better way.
   std::vector<TupleField> &get_fields () { return fields; }
   const std::vector<TupleField> &get_fields () const { return fields; }
@@ -2188,6 +2204,8 @@ public:
   // not pure virtual as not abstract
   virtual void accept_vis (ASTVisitor &vis);
 
+  Kind get_ast_kind () const override { return Kind::ENUM_ITEM; }
+
   Location get_locus () const { return locus; }
 
   Identifier get_identifier () const { return variant_name; }
@@ -2222,6 +2240,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::ENUM_ITEM_TUPLE; }
+
   // TODO: this mutable getter seems really dodgy. Think up better way.
   std::vector<TupleField> &get_tuple_fields () { return tuple_fields; }
   const std::vector<TupleField> &get_tuple_fields () const
@@ -2259,6 +2279,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::ENUM_ITEM_STRUCT; }
+
   // TODO: this mutable getter seems really dodgy. Think up better way.
   std::vector<StructField> &get_struct_fields () { return struct_fields; }
   const std::vector<StructField> &get_struct_fields () const
@@ -2312,6 +2334,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::ENUM_ITEM_DISCRIMINANT; }
+
   // TODO: is this better? Or is a "vis_block" better?
   std::unique_ptr<Expr> &get_expr ()
   {
@@ -2411,6 +2435,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::ENUM; }
+
   Identifier get_identifier () const { return enum_name; }
 
   // Invalid if name is empty, so base stripping on that.
@@ -2513,6 +2539,8 @@ public:
 
   void accept_vis (ASTVisitor &vis) override;
 
+  Kind get_ast_kind () const override { return Kind::UNION; }
+
   // Invalid if name is empty, so base stripping on that.
   void mark_for_strip () override { union_name = ""; }
   bool is_marked_for_strip () const override { return union_name.empty (); }
@@ -21,6 +21,7 @@
 #include "rust-tree.h"
 #include "langhooks.h"
 #include "tree.h"
+#include "target.h"
 
 namespace Rust {
 namespace Compile {
@@ -93,10 +94,51 @@ public:
     return lookup_gcc_builtin (it->second, builtin);
   }
 
+  // Record a builtin the target defined itself, such as __builtin_ia32_*,
+  // see grs_langhook_builtin_function.
+  void register_target_builtin (tree decl)
+  {
+    const char *name = IDENTIFIER_POINTER (DECL_NAME (decl));
+    target_builtin_functions_[name] = decl;
+  }
+
+  // Look up the target builtin an extern function with #[link_name =
+  // LINK_NAME] binds to. LINK_NAME is either the name of an LLVM intrinsic
+  // listed in rust-target-builtins.def or the name of the GCC builtin itself.
+  bool lookup_target_builtin (const std::string &link_name, tree *builtin)
+  {
+    std::string name = link_name;
+    auto mapped = llvm_intrinsic_to_target_builtin.find (link_name);
+    if (mapped != llvm_intrinsic_to_target_builtin.end ())
+      name = mapped->second;
+
+    auto it = target_builtin_functions_.find (name);
+    if (it == target_builtin_functions_.end ())
+      return false;
+
+    *builtin = it->second;
+    return true;
+  }
+
+  // The target builtin LINK_NAME maps to, even if the target we compile for
+  // does not have it.
+  bool lookup_target_builtin_name (const std::string &link_name,
+				   std::string *name)
+  {
+    auto mapped = llvm_intrinsic_to_target_builtin.find (link_name);
+    if (mapped == llvm_intrinsic_to_target_builtin.end ())
+      return false;
+
+    *name = mapped->second;
+    return true;
+  }
+
 private:
   static const int builtin_const = 1 << 0;
   static const int builtin_noreturn = 1 << 1;
   static const int builtin_novops = 1 << 2;
+  static const int builtin_nothrow = 1 << 3;
+  static const int builtin_cold = 1 << 4;
 
   BuiltinsContext () { setup (); }
 
@@ -124,23 +166,216 @@ private:
 		    math_function_type_f32, builtin_const);
   }
 
+  // The sized __atomic_* builtins of sync-builtins.def, which the atomic_*
+  // intrinsics lower to. They expand to libatomic calls where the target has
+  // no instructions for the size.
+  void setup_atomic_fns ()
+  {
+    tree vptr = build_pointer_type (
+      build_qualified_type (void_type_node, TYPE_QUAL_VOLATILE));
+    tree cvptr = build_pointer_type (
+      build_qualified_type (void_type_node,
+			    TYPE_QUAL_VOLATILE | TYPE_QUAL_CONST));
+    tree ptr = build_pointer_type (void_type_node);
+
+    static const struct
+    {
+      built_in_function load, store, exchange, compare_exchange;
+      built_in_function fetch_add, fetch_sub, fetch_and, fetch_nand;
+      built_in_function fetch_or, fetch_xor;
+    } sized[] = {
+      {BUILT_IN_ATOMIC_LOAD_1, BUILT_IN_ATOMIC_STORE_1,
+       BUILT_IN_ATOMIC_EXCHANGE_1, BUILT_IN_ATOMIC_COMPARE_EXCHANGE_1,
+       BUILT_IN_ATOMIC_FETCH_ADD_1, BUILT_IN_ATOMIC_FETCH_SUB_1,
+       BUILT_IN_ATOMIC_FETCH_AND_1, BUILT_IN_ATOMIC_FETCH_NAND_1,
+       BUILT_IN_ATOMIC_FETCH_OR_1, BUILT_IN_ATOMIC_FETCH_XOR_1},
+      {BUILT_IN_ATOMIC_LOAD_2, BUILT_IN_ATOMIC_STORE_2,
+       BUILT_IN_ATOMIC_EXCHANGE_2, BUILT_IN_ATOMIC_COMPARE_EXCHANGE_2,
+       BUILT_IN_ATOMIC_FETCH_ADD_2, BUILT_IN_ATOMIC_FETCH_SUB_2,
+       BUILT_IN_ATOMIC_FETCH_AND_2, BUILT_IN_ATOMIC_FETCH_NAND_2,
+       BUILT_IN_ATOMIC_FETCH_OR_2, BUILT_IN_ATOMIC_FETCH_XOR_2},
+      {BUILT_IN_ATOMIC_LOAD_4, BUILT_IN_ATOMIC_STORE_4,
+       BUILT_IN_ATOMIC_EXCHANGE_4, BUILT_IN_ATOMIC_COMPARE_EXCHANGE_4,
+       BUILT_IN_ATOMIC_FETCH_ADD_4, BUILT_IN_ATOMIC_FETCH_SUB_4,
+       BUILT_IN_ATOMIC_FETCH_AND_4, BUILT_IN_ATOMIC_FETCH_NAND_4,
+       BUILT_IN_ATOMIC_FETCH_OR_4, BUILT_IN_ATOMIC_FETCH_XOR_4},
+      {BUILT_IN_ATOMIC_LOAD_8, BUILT_IN_ATOMIC_STORE_8,
+       BUILT_IN_ATOMIC_EXCHANGE_8, BUILT_IN_ATOMIC_COMPARE_EXCHANGE_8,
+       BUILT_IN_ATOMIC_FETCH_ADD_8, BUILT_IN_ATOMIC_FETCH_SUB_8,
+       BUILT_IN_ATOMIC_FETCH_AND_8, BUILT_IN_ATOMIC_FETCH_NAND_8,
+       BUILT_IN_ATOMIC_FETCH_OR_8, BUILT_IN_ATOMIC_FETCH_XOR_8},
+      {BUILT_IN_ATOMIC_LOAD_16, BUILT_IN_ATOMIC_STORE_16,
+       BUILT_IN_ATOMIC_EXCHANGE_16, BUILT_IN_ATOMIC_COMPARE_EXCHANGE_16,
+       BUILT_IN_ATOMIC_FETCH_ADD_16, BUILT_IN_ATOMIC_FETCH_SUB_16,
+       BUILT_IN_ATOMIC_FETCH_AND_16, BUILT_IN_ATOMIC_FETCH_NAND_16,
+       BUILT_IN_ATOMIC_FETCH_OR_16, BUILT_IN_ATOMIC_FETCH_XOR_16},
+    };
+
+    for (unsigned i = 0; i < sizeof (sized) / sizeof (sized[0]); i++)
+      {
+	unsigned bytes = 1 << i;
+	if (bytes == 16 && !targetm.scalar_mode_supported_p (TImode))
+	  break;
+
+	tree itype = build_nonstandard_integer_type (BITS_PER_UNIT * bytes, 1);
+	std::string size = "_" + std::to_string (bytes);
+
+	define_atomic_builtin (
+	  "__atomic_load" + size, sized[i].load,
+	  build_function_type_list (itype, cvptr, integer_type_node,
+				    NULL_TREE));
+	define_atomic_builtin (
+	  "__atomic_store" + size, sized[i].store,
+	  build_function_type_list (void_type_node, vptr, itype,
+				    integer_type_node, NULL_TREE));
+	define_atomic_builtin (
+	  "__atomic_compare_exchange" + size, sized[i].compare_exchange,
+	  build_function_type_list (boolean_type_node, vptr, ptr, itype,
+				    boolean_type_node, integer_type_node,
+				    integer_type_node, NULL_TREE));
+
+	tree rmw_type = build_function_type_list (itype, vptr, itype,
+						  integer_type_node, NULL_TREE);
+	define_atomic_builtin ("__atomic_exchange" + size, sized[i].exchange,
+			       rmw_type);
+	define_atomic_builtin ("__atomic_fetch_add" + size, sized[i].fetch_add,
+			       rmw_type);
+	define_atomic_builtin ("__atomic_fetch_sub" + size, sized[i].fetch_sub,
+			       rmw_type);
+	define_atomic_builtin ("__atomic_fetch_and" + size, sized[i].fetch_and,
+			       rmw_type);
+	define_atomic_builtin ("__atomic_fetch_nand" + size,
+			       sized[i].fetch_nand, rmw_type);
+	define_atomic_builtin ("__atomic_fetch_or" + size, sized[i].fetch_or,
+			       rmw_type);
+	define_atomic_builtin ("__atomic_fetch_xor" + size, sized[i].fetch_xor,
+			       rmw_type);
+      }
+
+    tree fence_type
+      = build_function_type_list (void_type_node, integer_type_node, NULL_TREE);
+    define_atomic_builtin ("__atomic_thread_fence",
+			   BUILT_IN_ATOMIC_THREAD_FENCE, fence_type);
+    define_atomic_builtin ("__atomic_signal_fence",
+			   BUILT_IN_ATOMIC_SIGNAL_FENCE, fence_type);
+  }
+
+  // The builtins that the bit manipulation and hint intrinsics such as ctpop,
+  // bswap, likely and prefetch_read_data lower to.
+  void setup_bit_fns ()
+  {
+    static const struct
+    {
+      const char *suffix;
+      tree *arg_type;
+      built_in_function popcount, clz, ctz;
+    } widths[] = {
+      {"", &unsigned_type_node, BUILT_IN_POPCOUNT, BUILT_IN_CLZ, BUILT_IN_CTZ},
+      {"l", &long_unsigned_type_node, BUILT_IN_POPCOUNTL, BUILT_IN_CLZL,
+       BUILT_IN_CTZL},
+      {"ll", &long_long_unsigned_type_node, BUILT_IN_POPCOUNTLL,
+       BUILT_IN_CLZLL, BUILT_IN_CTZLL},
+    };
+
+    for (auto &width : widths)
+      {
+	tree count_type
+	  = build_function_type_list (integer_type_node, *width.arg_type,
+				      NULL_TREE);
+	std::string suffix = width.suffix;
+
+	define_internal_builtin ("__builtin_popcount" + suffix, width.popcount,
+				 count_type, builtin_const | builtin_nothrow);
+	define_internal_builtin ("__builtin_clz" + suffix, width.clz,
+				 count_type, builtin_const | builtin_nothrow);
+	define_internal_builtin ("__builtin_ctz" + suffix, width.ctz,
+				 count_type, builtin_const | builtin_nothrow);
+      }
+
+    static const struct
+    {
+      unsigned bits;
+      built_in_function bswap;
+    } bswaps[] = {{16, BUILT_IN_BSWAP16},
+		  {32, BUILT_IN_BSWAP32},
+		  {64, BUILT_IN_BSWAP64},
+		  {128, BUILT_IN_BSWAP128}};
+
+    for (auto &bswap : bswaps)
+      {
+	if (bswap.bits == 128 && !targetm.scalar_mode_supported_p (TImode))
+	  break;
+
+	tree itype = build_nonstandard_integer_type (bswap.bits, 1);
+	define_internal_builtin ("__builtin_bswap" + std::to_string (bswap.bits),
+				 bswap.bswap,
+				 build_function_type_list (itype, itype,
+							   NULL_TREE),
+				 builtin_const | builtin_nothrow);
+      }
+
+    define_internal_builtin ("__builtin_expect", BUILT_IN_EXPECT,
+			     build_function_type_list (long_integer_type_node,
+						       long_integer_type_node,
+						       long_integer_type_node,
+						       NULL_TREE),
+			     builtin_const | builtin_nothrow);
+
+    tree const_ptr = build_pointer_type (
+      build_qualified_type (void_type_node, TYPE_QUAL_CONST));
+    define_internal_builtin ("__builtin_prefetch", BUILT_IN_PREFETCH,
+			     build_varargs_function_type_list (void_type_node,
+							       const_ptr,
+							       NULL_TREE),
+			     builtin_novops);
+  }
+
+  void define_atomic_builtin (const std::string &name, built_in_function bcode,
+			      tree fntype)
+  {
+    define_internal_builtin (name, bcode, fntype, builtin_nothrow);
+  }
+
+  // A builtin only the intrinsics reach, by its BCODE: it has no library
+  // fallback and the Rust name is the builtin's own.
+  void define_internal_builtin (const std::string &name,
+				built_in_function bcode, tree fntype, int flags)
+  {
+    define_builtin (name, bcode, name.c_str (), NULL, fntype, flags);
+  }
+
+  void setup_target_builtin_names ()
+  {
+#define DEF_RUST_TARGET_BUILTIN(LINK_NAME, GCC_NAME)                           \
+  llvm_intrinsic_to_target_builtin[LINK_NAME] = GCC_NAME;
+#include "rust-target-builtins.def"
+#undef DEF_RUST_TARGET_BUILTIN
+  }
+
   void setup ()
   {
     setup_math_fns ();
     setup_overflow_fns ();
+    setup_atomic_fns ();
+    setup_bit_fns ();
+    setup_target_builtin_names ();
 
+    // The failure paths, such as the overflow checks, call these: as in
+    // builtins.def they are cold, so that the branches to them are predicted
+    // not taken and the calls are moved out of the hot code.
     define_builtin ("unreachable", BUILT_IN_UNREACHABLE,
 		    "__builtin_unreachable", NULL,
 		    build_function_type (void_type_node, void_list_node),
-		    builtin_const | builtin_noreturn);
+		    builtin_const | builtin_noreturn | builtin_nothrow
+		      | builtin_cold);
 
     define_builtin ("abort", BUILT_IN_ABORT, "__builtin_abort", "abort",
 		    build_function_type (void_type_node, void_list_node),
-		    builtin_const | builtin_noreturn);
+		    builtin_noreturn | builtin_nothrow | builtin_cold);
 
     define_builtin ("breakpoint", BUILT_IN_TRAP, "__builtin_trap", "breakpoint",
 		    build_function_type (void_type_node, void_list_node),
-		    builtin_const | builtin_noreturn);
+		    builtin_noreturn | builtin_nothrow | builtin_cold);
 
     define_builtin (
       "memcpy", BUILT_IN_MEMCPY, "__builtin_memcpy", "memcpy",
@@ -149,6 +384,13 @@ private:
 				build_pointer_type (void_type_node),
 				size_type_node, NULL_TREE),
       0);
+
+    define_builtin (
+      "memset", BUILT_IN_MEMSET, "__builtin_memset", "memset",
+      build_function_type_list (build_pointer_type (void_type_node),
+				build_pointer_type (void_type_node),
+				integer_type_node, size_type_node, NULL_TREE),
+      0);
   }
 
   static void handle_flags (tree decl, int flags)
@@ -156,9 +398,14 @@ private:
     if (flags & builtin_const)
       TREE_READONLY (decl) = 1;
     if (flags & builtin_noreturn)
-      TREE_READONLY (decl) = 1;
+      TREE_THIS_VOLATILE (decl) = 1;
     if (flags & builtin_novops)
       DECL_IS_NOVOPS (decl) = 1;
+    if (flags & builtin_nothrow)
+      TREE_NOTHROW (decl) = 1;
+    if (flags & builtin_cold)
+      DECL_ATTRIBUTES (decl) = tree_cons (get_identifier ("cold"), NULL_TREE,
+					  DECL_ATTRIBUTES (decl));
   }
 
   // Define a builtin function.  BCODE is the builtin function code
@@ -202,6 +449,11 @@ private:
   // A mapping of the GCC built-ins exposed to GCC Rust.
   std::map<std::string, tree> builtin_functions_;
   std::map<std::string, std::string> rust_intrinsic_to_gcc_builtin;
+
+  // The builtins of the target, and the LLVM intrinsics core::arch refers to
+  // mapped to them.
+  std::map<std::string, tree> target_builtin_functions_;
+  std::map<std::string, std::string> llvm_intrinsic_to_target_builtin;
 };
 
 } // namespace Compile
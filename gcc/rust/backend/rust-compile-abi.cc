@@ -0,0 +1,384 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-compile-abi.h"
+#include "rust-gcc.h"
+
+#include "fold-const.h"
+#include "stringpool.h"
+#include "attribs.h"
+#include "tree-iterator.h"
+#include "tree.h"
+
+namespace Rust {
+namespace Compile {
+
+static const char *rust_abi_attribute = "rust abi";
+
+static bool
+is_rust_abi_p (tree fntype)
+{
+  return TREE_CODE (fntype) == FUNCTION_TYPE
+	 && lookup_attribute (rust_abi_attribute, TYPE_ATTRIBUTES (fntype))
+	      != NULL_TREE;
+}
+
+// Return the Nth field of the scalar pair TYPE.
+static tree
+scalar_pair_field (tree type, int n)
+{
+  for (tree field = TYPE_FIELDS (type); field != NULL_TREE;
+       field = DECL_CHAIN (field))
+    {
+      if (TREE_CODE (field) == FIELD_DECL && n-- == 0)
+	return field;
+    }
+  gcc_unreachable ();
+}
+
+// A record of exactly two scalars, like a fat pointer or (usize, bool).
+static bool
+scalar_pair_p (tree type)
+{
+  if (type == NULL_TREE || TREE_CODE (type) != RECORD_TYPE
+      || !COMPLETE_TYPE_P (type) || TREE_ADDRESSABLE (type))
+    return false;
+
+  int n = 0;
+  for (tree field = TYPE_FIELDS (type); field != NULL_TREE;
+       field = DECL_CHAIN (field))
+    {
+      if (TREE_CODE (field) != FIELD_DECL)
+	continue;
+
+      tree field_type = TREE_TYPE (field);
+      bool is_scalar = INTEGRAL_TYPE_P (field_type)
+		       || POINTER_TYPE_P (field_type)
+		       || SCALAR_FLOAT_TYPE_P (field_type);
+      if (!is_scalar || DECL_BIT_FIELD (field) || ++n > 2)
+	return false;
+    }
+  return n == 2;
+}
+
+tree
+AbiLowering::rust_function_type (tree fntype)
+{
+  if (fntype == error_mark_node || stdarg_p (fntype))
+    return fntype;
+
+  tree attrs = tree_cons (get_identifier (rust_abi_attribute), NULL_TREE,
+			  TYPE_ATTRIBUTES (fntype));
+  return build_type_attribute_variant (fntype, attrs);
+}
+
+void
+AbiLowering::lower (Context *ctx)
+{
+  AbiLowering lowering;
+
+  // the signatures first, so the walk below knows which parameters went away
+  for (tree fndecl : ctx->get_func_decls ())
+    {
+      if (fndecl != error_mark_node)
+	lowering.lower_function_decl (fndecl);
+    }
+
+  for (tree fndecl : ctx->get_func_decls ())
+    {
+      if (fndecl != error_mark_node && DECL_SAVED_TREE (fndecl) != NULL_TREE)
+	lowering.lower_tree (&DECL_SAVED_TREE (fndecl));
+    }
+
+  // statics can hold function pointers
+  for (::Bvariable *var : ctx->get_var_decls ())
+    {
+      tree decl = var->get_decl ();
+      if (decl != error_mark_node && DECL_INITIAL (decl) != NULL_TREE)
+	lowering.lower_tree (&DECL_INITIAL (decl));
+    }
+}
+
+// The FUNCTION_TYPE FNTYPE with each scalar pair parameter replaced by its two
+// fields, or NULL_TREE if FNTYPE does not use the Rust ABI or has no scalar
+// pair to split.
+
+tree
+AbiLowering::split_function_type (tree fntype)
+{
+  auto it = split_types.find (fntype);
+  if (it != split_types.end ())
+    return it->second;
+
+  tree split = NULL_TREE;
+  if (is_rust_abi_p (fntype))
+    {
+      auto_vec<tree> types;
+      bool has_pair = false;
+      for (tree arg = TYPE_ARG_TYPES (fntype);
+	   arg != NULL_TREE && arg != void_list_node; arg = TREE_CHAIN (arg))
+	{
+	  tree type = TREE_VALUE (arg);
+	  if (!scalar_pair_p (type))
+	    {
+	      types.safe_push (type);
+	      continue;
+	    }
+
+	  has_pair = true;
+	  types.safe_push (TREE_TYPE (scalar_pair_field (type, 0)));
+	  types.safe_push (TREE_TYPE (scalar_pair_field (type, 1)));
+	}
+
+      if (has_pair)
+	{
+	  split = build_function_type_array (TREE_TYPE (fntype),
+					     types.length (), types.address ());
+
+	  // the split type is final, it must not be split again
+	  tree attrs = remove_attribute (rust_abi_attribute,
+					 copy_list (TYPE_ATTRIBUTES (fntype)));
+	  if (attrs != NULL_TREE)
+	    split = build_type_attribute_variant (split, attrs);
+	}
+    }
+
+  split_types[fntype] = split;
+  return split;
+}
+
+void
+AbiLowering::lower_function_decl (tree fndecl)
+{
+  if (!lowered_decls.insert (fndecl).second)
+    return;
+
+  tree fntype = TREE_TYPE (fndecl);
+  tree split = split_function_type (fntype);
+  if (split == NULL_TREE)
+    return;
+
+  if (DECL_SAVED_TREE (fndecl) != NULL_TREE)
+    lower_parameters (fndecl, fntype);
+  TREE_TYPE (fndecl) = split;
+}
+
+// Replace each scalar pair parameter of FNDECL by two parameters, one per
+// field. The body keeps referring to the original PARM_DECL, which becomes an
+// alias for a local rebuilt from the halves on entry.
+
+void
+AbiLowering::lower_parameters (tree fndecl, tree fntype)
+{
+  tree bind = DECL_SAVED_TREE (fndecl);
+  gcc_assert (TREE_CODE (bind) == BIND_EXPR);
+
+  tree inits = NULL_TREE;
+  tree parms = NULL_TREE;
+  tree *pp = &parms;
+  tree arg = TYPE_ARG_TYPES (fntype);
+  for (tree parm = DECL_ARGUMENTS (fndecl), next = NULL_TREE;
+       parm != NULL_TREE; parm = next, arg = TREE_CHAIN (arg))
+    {
+      next = DECL_CHAIN (parm);
+
+      tree type = TREE_VALUE (arg);
+      if (!scalar_pair_p (type))
+	{
+	  *pp = parm;
+	  pp = &DECL_CHAIN (parm);
+	  continue;
+	}
+
+      location_t locus = DECL_SOURCE_LOCATION (parm);
+      vec<constructor_elt, va_gc> *elts = NULL;
+      for (int n = 0; n < 2; n++)
+	{
+	  tree field = scalar_pair_field (type, n);
+	  tree half
+	    = build_decl (locus, PARM_DECL, NULL_TREE, TREE_TYPE (field));
+	  DECL_ARG_TYPE (half) = TREE_TYPE (field);
+	  DECL_CONTEXT (half) = fndecl;
+	  DECL_ARTIFICIAL (half) = 1;
+	  DECL_IGNORED_P (half) = 1;
+	  TREE_USED (half) = 1;
+
+	  *pp = half;
+	  pp = &DECL_CHAIN (half);
+	  CONSTRUCTOR_APPEND_ELT (elts, field, half);
+	}
+
+      tree local = build_decl (locus, VAR_DECL, DECL_NAME (parm),
+			       TREE_TYPE (parm));
+      DECL_CONTEXT (local) = fndecl;
+      DECL_ARTIFICIAL (local) = DECL_ARTIFICIAL (parm);
+      TREE_ADDRESSABLE (local) = TREE_ADDRESSABLE (parm);
+      TREE_USED (local) = 1;
+      DECL_CHAIN (local) = BIND_EXPR_VARS (bind);
+      BIND_EXPR_VARS (bind) = local;
+
+      tree init = build2_loc (locus, INIT_EXPR, TREE_TYPE (local), local,
+			      build_constructor (TREE_TYPE (local), elts));
+      append_to_statement_list (init, &inits);
+
+      SET_DECL_VALUE_EXPR (parm, local);
+      DECL_HAS_VALUE_EXPR_P (parm) = 1;
+    }
+  *pp = NULL_TREE;
+  DECL_ARGUMENTS (fndecl) = parms;
+
+  if (inits == NULL_TREE)
+    return;
+
+  // the block shares its chain of variables with the BIND_EXPR
+  if (BIND_EXPR_BLOCK (bind) != NULL_TREE)
+    BLOCK_VARS (BIND_EXPR_BLOCK (bind)) = BIND_EXPR_VARS (bind);
+
+  append_to_statement_list (BIND_EXPR_BODY (bind), &inits);
+  BIND_EXPR_BODY (bind) = inits;
+}
+
+// Rewrite CALL to pass each scalar pair argument as its two fields, or return
+// NULL_TREE if the callee's type has nothing to split.
+
+tree
+AbiLowering::lower_call (tree call)
+{
+  tree fn = CALL_EXPR_FN (call);
+  if (fn == NULL_TREE || !POINTER_TYPE_P (TREE_TYPE (fn)))
+    return NULL_TREE;
+
+  tree fntype = TREE_TYPE (TREE_TYPE (fn));
+  tree split = split_function_type (fntype);
+  if (split == NULL_TREE)
+    return NULL_TREE;
+
+  location_t locus = EXPR_LOCATION (call);
+  auto_vec<tree> args;
+  tree arg_type = TYPE_ARG_TYPES (fntype);
+  for (int i = 0; i < call_expr_nargs (call); i++)
+    {
+      tree arg = CALL_EXPR_ARG (call, i);
+      tree type = NULL_TREE;
+      if (arg_type != NULL_TREE)
+	{
+	  type = TREE_VALUE (arg_type);
+	  arg_type = TREE_CHAIN (arg_type);
+	}
+
+      if (!scalar_pair_p (type))
+	{
+	  args.safe_push (arg);
+	  continue;
+	}
+
+      if (TYPE_MAIN_VARIANT (TREE_TYPE (arg)) != TYPE_MAIN_VARIANT (type))
+	arg = fold_build1_loc (locus, VIEW_CONVERT_EXPR, type, arg);
+
+      // both halves read the argument, which must only be evaluated once
+      if (!DECL_P (arg))
+	arg = save_expr (arg);
+
+      for (int n = 0; n < 2; n++)
+	{
+	  tree field = scalar_pair_field (type, n);
+	  args.safe_push (build3_loc (locus, COMPONENT_REF, TREE_TYPE (field),
+				      arg, field, NULL_TREE));
+	}
+    }
+
+  tree callee = build1_loc (locus, NOP_EXPR, build_pointer_type (split), fn);
+  tree lowered = build_call_array_loc (locus, TREE_TYPE (call), callee,
+				       args.length (), args.address ());
+  TREE_NOTHROW (lowered) = TREE_NOTHROW (call);
+  TREE_THIS_VOLATILE (lowered) = TREE_THIS_VOLATILE (call);
+  CALL_EXPR_TAILCALL (lowered) = CALL_EXPR_TAILCALL (call);
+  CALL_EXPR_MUST_TAIL_CALL (lowered) = CALL_EXPR_MUST_TAIL_CALL (call);
+  CALL_EXPR_RETURN_SLOT_OPT (lowered) = CALL_EXPR_RETURN_SLOT_OPT (call);
+  CALL_EXPR_STATIC_CHAIN (lowered) = CALL_EXPR_STATIC_CHAIN (call);
+  return lowered;
+}
+
+// The address of a function whose signature was split no longer has the type
+// the front end gave it, convert it back for the code that uses it.
+
+tree
+AbiLowering::lower_function_address (tree addr)
+{
+  tree fndecl = TREE_OPERAND (addr, 0);
+  lower_function_decl (fndecl);
+
+  tree fntype = TREE_TYPE (fndecl);
+  if (is_rust_abi_p (fntype) || TREE_TYPE (TREE_TYPE (addr)) == fntype)
+    return NULL_TREE;
+
+  tree lowered = build_fold_addr_expr_loc (EXPR_LOCATION (addr), fndecl);
+  return build1_loc (EXPR_LOCATION (addr), NOP_EXPR, TREE_TYPE (addr),
+		     lowered);
+}
+
+void
+AbiLowering::lower_tree (tree *tp)
+{
+  walk_tree (tp, lower_tree_r, this, NULL);
+}
+
+tree
+AbiLowering::lower_tree_r (tree *tp, int *walk_subtrees, void *data)
+{
+  AbiLowering *self = static_cast<AbiLowering *> (data);
+  tree t = *tp;
+  if (TYPE_P (t))
+    {
+      *walk_subtrees = 0;
+      return NULL_TREE;
+    }
+
+  // bodies share subtrees, a rewritten one has to be replaced everywhere it
+  // is used
+  auto it = self->replaced.find (t);
+  if (it != self->replaced.end ())
+    {
+      *tp = it->second;
+      *walk_subtrees = 0;
+      return NULL_TREE;
+    }
+  if (!self->seen.insert (t).second)
+    {
+      *walk_subtrees = 0;
+      return NULL_TREE;
+    }
+
+  tree lowered = NULL_TREE;
+  if (TREE_CODE (t) == CALL_EXPR)
+    lowered = self->lower_call (t);
+  else if (TREE_CODE (t) == ADDR_EXPR
+	   && TREE_CODE (TREE_OPERAND (t, 0)) == FUNCTION_DECL)
+    lowered = self->lower_function_address (t);
+
+  if (lowered != NULL_TREE)
+    {
+      self->replaced[t] = lowered;
+      self->seen.insert (lowered);
+      *tp = lowered;
+    }
+  return NULL_TREE;
+}
+
+} // namespace Compile
+} // namespace Rust
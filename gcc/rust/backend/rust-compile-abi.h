@@ -0,0 +1,70 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_COMPILE_ABI
+#define RUST_COMPILE_ABI
+
+#include "rust-compile-context.h"
+
+namespace Rust {
+namespace Compile {
+
+// The Rust ABI is not the C one: a parameter whose type is a pair of scalars,
+// which covers fat pointers such as &[T], &str and &dyn Trait as well as
+// two-element tuples and structs, is passed as two separate arguments so each
+// half can live in its own register.
+//
+// Function types are compiled like C ones and only tagged as using the Rust
+// ABI; once every body of the crate has been compiled, and so can no longer
+// be evaluated by the constant folder, AbiLowering rewrites the definitions,
+// calls and function addresses of the tagged types to the split signature.
+class AbiLowering
+{
+public:
+  // Tag FNTYPE, a FUNCTION_TYPE, as using the Rust ABI.
+  static tree rust_function_type (tree fntype);
+
+  // Rewrite every function and global initializer compiled in CTX.
+  static void lower (Context *ctx);
+
+private:
+  AbiLowering () {}
+
+  tree split_function_type (tree fntype);
+  void lower_function_decl (tree fndecl);
+  void lower_parameters (tree fndecl, tree fntype);
+  tree lower_call (tree call);
+  tree lower_function_address (tree addr);
+  void lower_tree (tree *tp);
+
+  static tree lower_tree_r (tree *tp, int *walk_subtrees, void *data);
+
+  // FUNCTION_TYPE to its split form, or NULL_TREE when there is nothing to
+  // split
+  std::map<tree, tree> split_types;
+  // FUNCTION_DECLs whose signature has been rewritten
+  std::set<tree> lowered_decls;
+  // trees already walked, and the replacement of those that were rewritten
+  std::set<tree> seen;
+  std::map<tree, tree> replaced;
+};
+
+} // namespace Compile
+} // namespace Rust
+
+#endif // RUST_COMPILE_ABI
@@ -27,11 +27,16 @@
 #include "rust-diagnostics.h"
 #include "rust-expr.h"	// for AST::AttrInputLiteral
 #include "rust-macro.h" // for AST::MetaNameValueStr
+#include "rust-trace.h"
 
 #include "fold-const.h"
+#include "function.h"
+#include "gimplify.h"
 #include "stringpool.h"
 #include "attribs.h"
+#include "target.h"
 #include "tree.h"
+#include "varasm.h"
 
 namespace Rust {
 namespace Compile {
@@ -45,7 +50,8 @@ void
 HIRCompileBase::setup_fndecl (tree fndecl, bool is_main_entry_point,
 			      bool is_generic_fn, HIR::Visibility &visibility,
 			      const HIR::FunctionQualifiers &qualifiers,
-			      const AST::AttrVec &attrs)
+			      const AST::AttrVec &attrs,
+			      const Analysis::BuiltinAttrSet &builtin_attrs)
 {
   // if its the main fn or pub visibility mark its as DECL_PUBLIC
   // please see https://github.com/Rust-GCC/gccrs/pull/137
@@ -62,42 +68,37 @@ HIRCompileBase::setup_fndecl (tree fndecl, bool is_main_entry_point,
       TREE_READONLY (fndecl) = 1;
     }
 
-  // is it inline?
-  for (const auto &attr : attrs)
+  for (const auto &entry : builtin_attrs.get_entries ())
     {
-      bool is_inline = attr.get_path ().as_string ().compare ("inline") == 0;
-      bool is_must_use
-	= attr.get_path ().as_string ().compare ("must_use") == 0;
-      bool is_cold = attr.get_path ().as_string ().compare ("cold") == 0;
-      bool is_link_section
-	= attr.get_path ().as_string ().compare ("link_section") == 0;
-      bool no_mangle = attr.get_path ().as_string ().compare ("no_mangle") == 0;
-      bool is_deprecated
-	= attr.get_path ().as_string ().compare ("deprecated") == 0;
-
-      if (is_inline)
+      const AST::Attribute &attr = attrs.at (entry.second);
+      switch (entry.first)
 	{
+	case Analysis::BuiltinAttrKind::INLINE:
 	  handle_inline_attribute_on_fndecl (fndecl, attr);
-	}
-      else if (is_must_use)
-	{
+	  break;
+	case Analysis::BuiltinAttrKind::MUST_USE:
 	  handle_must_use_attribute_on_fndecl (fndecl, attr);
-	}
-      else if (is_cold)
-	{
+	  break;
+	case Analysis::BuiltinAttrKind::COLD:
 	  handle_cold_attribute_on_fndecl (fndecl, attr);
-	}
-      else if (is_link_section)
-	{
+	  break;
+	case Analysis::BuiltinAttrKind::LINK_SECTION:
 	  handle_link_section_attribute_on_fndecl (fndecl, attr);
-	}
-      else if (is_deprecated)
-	{
+	  break;
+	case Analysis::BuiltinAttrKind::DEPRECATED:
 	  handle_deprecated_attribute_on_fndecl (fndecl, attr);
-	}
-      else if (no_mangle)
-	{
+	  break;
+	case Analysis::BuiltinAttrKind::NO_MANGLE:
 	  handle_no_mangle_attribute_on_fndecl (fndecl, attr);
+	  break;
+	case Analysis::BuiltinAttrKind::TARGET_FEATURE:
+	  handle_target_feature_attribute_on_fndecl (fndecl, attr);
+	  break;
+	case Analysis::BuiltinAttrKind::TARGET_CLONES:
+	  handle_target_clones_attribute_on_fndecl (fndecl, attr);
+	  break;
+	default:
+	  break;
 	}
     }
 }
@@ -145,6 +146,83 @@ HIRCompileBase::handle_link_section_attribute_on_fndecl (
   set_decl_section_name (fndecl, msg_str.c_str ());
 }
 
+// The allocator shims of liballoc, __rust_alloc and friends, are declared
+// with #[rustc_allocator], #[rustc_allocator_zeroed] or #[rustc_reallocator].
+// Describe them to GCC as it would malloc and realloc, so that it knows the
+// size and alignment of the blocks they return, and that an allocation
+// aliases nothing else.
+void
+HIRCompileBase::setup_allocator_fndecl (
+  tree fndecl, const Analysis::BuiltinAttrSet &builtin_attrs)
+{
+  // the positions of the size and alignment arguments:
+  //   fn __rust_alloc (size: usize, align: usize) -> *mut u8
+  //   fn __rust_realloc (ptr: *mut u8, old_size: usize, align: usize,
+  //                      new_size: usize) -> *mut u8
+  int size_arg, align_arg;
+  bool is_realloc = false;
+  if (builtin_attrs.has (Analysis::BuiltinAttrKind::RUSTC_ALLOCATOR)
+      || builtin_attrs.has (Analysis::BuiltinAttrKind::RUSTC_ALLOCATOR_ZEROED))
+    {
+      size_arg = 1;
+      align_arg = 2;
+    }
+  else if (builtin_attrs.has (Analysis::BuiltinAttrKind::RUSTC_REALLOCATOR))
+    {
+      size_arg = 4;
+      align_arg = 3;
+      is_realloc = true;
+    }
+  else
+    return;
+
+  tree fntype = TREE_TYPE (fndecl);
+  if (!POINTER_TYPE_P (TREE_TYPE (fntype))
+      || type_num_arguments (fntype) < MAX (size_arg, align_arg))
+    return;
+
+  // realloc can return the block it was given
+  if (!is_realloc)
+    DECL_IS_MALLOC (fndecl) = 1;
+
+  tree attrs = TYPE_ATTRIBUTES (fntype);
+  attrs = tree_cons (get_identifier ("alloc_size"),
+		     build_tree_list (NULL_TREE, build_int_cst (integer_type_node,
+								size_arg)),
+		     attrs);
+  attrs = tree_cons (get_identifier ("alloc_align"),
+		     build_tree_list (NULL_TREE, build_int_cst (integer_type_node,
+								align_arg)),
+		     attrs);
+  TREE_TYPE (fndecl) = build_type_attribute_variant (fntype, attrs);
+}
+
+bool
+HIRCompileBase::has_thread_local_attribute (
+  const AST::AttrVec &attrs, const Analysis::BuiltinAttrSet &builtin_attrs)
+{
+  const AST::Attribute *attr
+    = builtin_attrs.get (attrs, Analysis::BuiltinAttrKind::THREAD_LOCAL);
+  if (attr == nullptr)
+    return false;
+
+  if (attr->has_attr_input ())
+    rust_error_at (attr->get_locus (),
+		   "attribute %<thread_local%> does not accept any arguments");
+  return true;
+}
+
+void
+HIRCompileBase::setup_thread_local_decl (tree decl)
+{
+  // statics are always initialized with a constant, so TLS needs no lazy
+  // initialization and the cheapest model the decl allows is enough:
+  // local-exec in an executable, initial-exec for a definition from another
+  // object, and the dynamic models only with -fpic unless -ftls-model says
+  // otherwise
+  set_decl_tls_model (decl, decl_default_tls_model (decl));
+}
+
 void
 HIRCompileBase::handle_no_mangle_attribute_on_fndecl (
   tree fndecl, const AST::Attribute &attr)
@@ -160,6 +238,159 @@ HIRCompileBase::handle_no_mangle_attribute_on_fndecl (
 					DECL_ATTRIBUTES (fndecl));
 }
 
+// The x86 features rustc and the target attribute spell differently. Any
+// other name is passed on as it is, so AArch64 extensions are given in the
+// "+sve" form of the target attribute.
+static const std::map<std::string, std::string> target_feature_names
+  = {{"bmi1", "bmi"},
+     {"cmpxchg16b", "cx16"},
+     {"pclmulqdq", "pclmul"},
+     {"rdrand", "rdrnd"}};
+
+// Collect the features of #[target_feature(enable = "avx2,fma")], or of
+// #[target_clones] which takes the same input, as target attribute strings.
+static bool
+parse_enabled_target_features (const AST::Attribute &attr,
+			       std::vector<std::string> *features)
+{
+  const std::string name = attr.get_path ().as_string ();
+  if (!attr.has_attr_input ()
+      || attr.get_attr_input ().get_attr_input_type ()
+	   != AST::AttrInput::AttrInputType::TOKEN_TREE)
+    {
+      rust_error_at (attr.get_locus (),
+		     "malformed %qs attribute input, expected %<%s(enable = "
+		     "\"name\")%>",
+		     name.c_str (), name.c_str ());
+      return false;
+    }
+
+  const auto &option
+    = static_cast<const AST::DelimTokenTree &> (attr.get_attr_input ());
+  AST::AttrInputMetaItemContainer *meta_item = option.parse_to_meta_item ();
+  for (const auto &item : meta_item->get_items ())
+    {
+      auto converted_item = item->to_meta_name_value_str ();
+      if (!converted_item
+	  || converted_item->get_name_value_pair ().first.compare ("enable")
+	       != 0)
+	{
+	  rust_error_at (attr.get_locus (),
+			 "%qs only accepts sub-keys of %<enable%>",
+			 name.c_str ());
+	  return false;
+	}
+
+      const std::string &list = converted_item->get_name_value_pair ().second;
+      size_t start = 0;
+      while (start <= list.size ())
+	{
+	  size_t end = list.find (',', start);
+	  if (end == std::string::npos)
+	    end = list.size ();
+
+	  std::string feature = list.substr (start, end - start);
+	  if (feature.empty ())
+	    {
+	      rust_error_at (attr.get_locus (), "empty feature name in %qs",
+			     name.c_str ());
+	      return false;
+	    }
+
+	  auto it = target_feature_names.find (feature);
+	  features->push_back (it != target_feature_names.end () ? it->second
+								  : feature);
+	  start = end + 1;
+	}
+    }
+
+  return true;
+}
+
+void
+HIRCompileBase::handle_target_feature_attribute_on_fndecl (
+  tree fndecl, const AST::Attribute &attr)
+{
+  std::vector<std::string> features;
+  if (!parse_enabled_target_features (attr, &features))
+    return;
+
+  if (lookup_attribute ("target_clones", DECL_ATTRIBUTES (fndecl)))
+    {
+      rust_error_at (attr.get_locus (),
+		     "%<target_feature%> cannot be combined with "
+		     "%<target_clones%>");
+      return;
+    }
+
+  // several #[target_feature] add up to a single target attribute
+  tree args = NULL_TREE;
+  tree existing = lookup_attribute ("target", DECL_ATTRIBUTES (fndecl));
+  if (existing)
+    args = copy_list (TREE_VALUE (existing));
+  for (const auto &feature : features)
+    args = chainon (args, build_tree_list (NULL_TREE,
+					   build_string (feature.size (),
+							 feature.c_str ())));
+  DECL_ATTRIBUTES (fndecl)
+    = remove_attribute ("target", DECL_ATTRIBUTES (fndecl));
+
+  // like the handler of the C family, this is what sets up the options the
+  // function is compiled with; the target reports features it does not know
+  tree target = get_identifier ("target");
+  if (!targetm.target_option.valid_attribute_p (fndecl, target, args, 0))
+    return;
+
+  DECL_ATTRIBUTES (fndecl)
+    = tree_cons (target, args, DECL_ATTRIBUTES (fndecl));
+}
+
+// #[target_clones(enable = "avx512f,avx2")] compiles the function once for
+// each feature and once without, and has an ifunc resolver pick one when the
+// program is loaded. The cloning is done by the multiple_target pass.
+void
+HIRCompileBase::handle_target_clones_attribute_on_fndecl (
+  tree fndecl, const AST::Attribute &attr)
+{
+  std::vector<std::string> features;
+  if (!parse_enabled_target_features (attr, &features))
+    return;
+
+  if (lookup_attribute ("target", DECL_ATTRIBUTES (fndecl)))
+    {
+      rust_error_at (attr.get_locus (),
+		     "%<target_clones%> cannot be combined with "
+		     "%<target_feature%>");
+      return;
+    }
+  if (lookup_attribute ("target_clones", DECL_ATTRIBUTES (fndecl)))
+    {
+      rust_error_at (attr.get_locus (),
+		     "multiple %<target_clones%> attributes");
+      return;
+    }
+  if (!targetm.has_ifunc_p ())
+    {
+      rust_error_at (attr.get_locus (),
+		     "%<target_clones%> needs %<ifunc%>, which is not "
+		     "supported by this target");
+      return;
+    }
+
+  features.push_back ("default");
+  tree args = NULL_TREE;
+  for (const auto &feature : features)
+    args = chainon (args, build_tree_list (NULL_TREE,
+					   build_string (feature.size (),
+							 feature.c_str ())));
+
+  DECL_ATTRIBUTES (fndecl) = tree_cons (get_identifier ("target_clones"), args,
+					DECL_ATTRIBUTES (fndecl));
+
+  // every caller has to go through the resolver
+  DECL_UNINLINABLE (fndecl) = 1;
+}
+
 void
 HIRCompileBase::handle_deprecated_attribute_on_fndecl (
   tree fndecl, const AST::Attribute &attr)
@@ -507,19 +738,45 @@ HIRCompileBase::compile_function_body (Context *ctx, tree fndecl,
     }
 }
 
+// -frust-overflow-checks sets the default for the crate, "debug" meaning only
+// when not optimizing. Functions from other crates are compiled here to be
+// inlined or instantiated; like the library code they are they skip the
+// checks, unless they carry #[rustc_inherit_overflow_checks] asking to follow
+// the crate using them, as the arithmetic operator impls of core do.
+bool
+HIRCompileBase::function_has_overflow_checks (Context *ctx,
+					      const TyTy::FnType *fntype,
+					      const Analysis::BuiltinAttrSet &attrs)
+{
+  bool enabled = flag_rust_overflow_checks == 2 ? optimize == 0
+						: flag_rust_overflow_checks;
+  if (!enabled)
+    return false;
+
+  if (fntype->get_id ().crateNum == ctx->get_mappings ()->get_current_crate ())
+    return true;
+
+  return attrs.has (Analysis::BuiltinAttrKind::RUSTC_INHERIT_OVERFLOW_CHECKS);
+}
+
 tree
 HIRCompileBase::compile_function (
   Context *ctx, const std::string &fn_name, HIR::SelfParam &self_param,
   std::vector<HIR::FunctionParam> &function_params,
   const HIR::FunctionQualifiers &qualifiers, HIR::Visibility &visibility,
-  AST::AttrVec &outer_attrs, Location locus, HIR::BlockExpr *function_body,
-  const Resolver::CanonicalPath *canonical_path, TyTy::FnType *fntype,
-  bool function_has_return)
+  const AST::AttrVec &outer_attrs,
+  const Analysis::BuiltinAttrSet &builtin_attrs, Location locus,
+  HIR::BlockExpr *function_body, const Resolver::CanonicalPath *canonical_path,
+  TyTy::FnType *fntype, bool function_has_return)
 {
   tree compiled_fn_type = TyTyResolveCompile::compile (ctx, fntype);
   std::string ir_symbol_name
     = canonical_path->get () + fntype->subst_as_string ();
 
+  TraceScope trace ("compilation", "function");
+  if (trace.is_active ())
+    trace.add_arg ("path", ir_symbol_name);
+
   // we don't mangle the main fn since we haven't implemented the main shim
   bool is_main_fn = fn_name.compare ("main") == 0;
   std::string asm_name = fn_name;
@@ -529,9 +786,17 @@ HIRCompileBase::compile_function (
 					       "" /* asm_name */, flags, locus);
 
   setup_fndecl (fndecl, is_main_fn, fntype->has_subsititions_defined (),
-		visibility, qualifiers, outer_attrs);
+		visibility, qualifiers, outer_attrs, builtin_attrs);
   setup_abi_options (fndecl, qualifiers.get_abi ());
 
+  // a public function from another crate only has a body here because it was
+  // exported for inlining, the crate it comes from emits the definition so
+  // ours is available externally only, like a gnu_inline function in C
+  bool is_foreign_fn
+    = fntype->get_id ().crateNum != ctx->get_mappings ()->get_current_crate ();
+  if (is_foreign_fn && TREE_PUBLIC (fndecl))
+    DECL_EXTERNAL (fndecl) = 1;
+
   // conditionally mangle the function name
   bool should_mangle = should_mangle_item (fndecl);
   if (!is_main_fn && should_mangle)
@@ -540,6 +805,26 @@ HIRCompileBase::compile_function (
 			   get_identifier_with_length (asm_name.data (),
 						       asm_name.length ()));
 
+  // below -O2 generic instances are shared between crates: the crate of the
+  // generic defines its instances with a public symbol and dependents link
+  // against those rather than compiling them again. Optimized builds keep
+  // their own copies so that they can be inlined and internalized.
+  bool share_instance
+    = fntype->has_subsititions_defined () && !is_main_fn && optimize < 2;
+  if (share_instance && !is_foreign_fn)
+    {
+      TREE_PUBLIC (fndecl) = 1;
+      ctx->insert_shared_instance (asm_name);
+    }
+  else if (share_instance
+	   && ctx->get_mappings ()->is_shared_instance (asm_name))
+    {
+      TREE_PUBLIC (fndecl) = 1;
+      DECL_EXTERNAL (fndecl) = 1;
+      ctx->insert_function_decl (fntype, fndecl);
+      return fndecl;
+    }
+
   // insert into the context
   ctx->insert_function_decl (fntype, fndecl);
 
@@ -552,6 +837,7 @@ HIRCompileBase::compile_function (
       TyTy::BaseType *self_tyty_lookup = fntype->get_self_type ();
 
       tree self_type = TyTyResolveCompile::compile (ctx, self_tyty_lookup);
+      self_type = restrict_param_type (ctx, self_tyty_lookup, self_type);
       Bvariable *compiled_self_param
 	= CompileSelfParam::compile (ctx, fndecl, self_param, self_type,
 				     self_param.get_locus ());
@@ -570,6 +856,8 @@ HIRCompileBase::compile_function (
       auto tyty_param = fntype->param_at (i++);
       auto param_tyty = tyty_param.second;
       auto compiled_param_type = TyTyResolveCompile::compile (ctx, param_tyty);
+      compiled_param_type
+	= restrict_param_type (ctx, param_tyty, compiled_param_type);
 
       Location param_locus = referenced_param.get_locus ();
       Bvariable *compiled_param_var
@@ -621,7 +909,8 @@ HIRCompileBase::compile_function (
       ctx->add_statement (ret_var_stmt);
     }
 
-  ctx->push_fn (fndecl, return_address);
+  ctx->push_fn (fndecl, return_address,
+	       function_has_overflow_checks (ctx, fntype, builtin_attrs));
   compile_function_body (ctx, fndecl, *function_body, function_has_return);
   tree bind_tree = ctx->pop_block ();
 
@@ -629,13 +918,17 @@ HIRCompileBase::compile_function (
   DECL_SAVED_TREE (fndecl) = bind_tree;
 
   ctx->pop_fn ();
-  ctx->push_function (fndecl);
 
   if (DECL_DECLARED_CONSTEXPR_P (fndecl))
     {
       maybe_save_constexpr_fundef (fndecl);
     }
 
+  // the constant evaluator keeps its own copy of the body, which still
+  // returns the local by value
+  named_return_value_optimization (fndecl);
+  ctx->push_function (fndecl);
+
   return fndecl;
 }
 
@@ -643,9 +936,15 @@ tree
 HIRCompileBase::compile_constant_item (
   Context *ctx, TyTy::BaseType *resolved_type,
   const Resolver::CanonicalPath *canonical_path, HIR::Expr *const_value_expr,
-  Location locus)
+  Location locus, bool is_static)
 {
   const std::string &ident = canonical_path->get ();
+  const std::string type_key = resolved_type->as_string ();
+  HirId expr_id = const_value_expr->get_mappings ().get_hirid ();
+  tree cached = NULL_TREE;
+  if (ctx->lookup_const_value (expr_id, type_key, &cached))
+    return cached;
+
   tree type = TyTyResolveCompile::compile (ctx, resolved_type);
   tree const_type = build_qualified_type (type, TYPE_QUAL_CONST);
 
@@ -717,9 +1016,357 @@ HIRCompileBase::compile_constant_item (
   // lets fold it into a call expr
   tree call
     = build_call_array_loc (locus.gcc_location (), const_type, fndecl, 0, NULL);
-  tree folded_expr = fold_expr (call);
+  bool exhausted = false;
+  tree folded_expr = fold_constant_item (call, ident, &exhausted);
+  if (exhausted)
+    {
+      // the value is computed by calling the fake function instead
+      rust_warning_at (locus, 0,
+		       "evaluating constant %qs exceeds "
+		       "%<-frust-const-eval-limit=%wd%>; it is computed at "
+		       "run time instead",
+		       ident.c_str (), flag_rust_const_eval_limit);
+      ctx->push_function (fndecl);
+    }
+  else if (!mark_constant_initializer (folded_expr) && !is_static
+	   && folded_expr != error_mark_node)
+    {
+      // a constant can still be computed where it is used, the caller
+      // diagnoses a static
+      rust_warning_at (locus, 0,
+		       "constant %qs could not be evaluated at compile time; "
+		       "it is computed at run time instead",
+		       ident.c_str ());
+    }
+
+  tree value
+    = named_constant_expression (const_type, ident, folded_expr, locus);
+  ctx->insert_const_value (expr_id, type_key, value);
+  return value;
+}
+
+// Mark the constructors of VALUE, a folded constant or static initializer,
+// constant and static where all their elements are. GCC then emits them as
+// data, and copies aggregate constants out of .rodata instead of building
+// them field by field at every use. Return whether all of VALUE can be
+// emitted as data, with no run time initialization.
+bool
+HIRCompileBase::mark_constant_initializer (tree value)
+{
+  if (value == error_mark_node)
+    return false;
+
+  tree ctor = value;
+  if (TREE_CODE (ctor) == ADDR_EXPR)
+    ctor = TREE_OPERAND (ctor, 0);
+
+  if (TREE_CODE (ctor) == CONSTRUCTOR)
+    {
+      bool is_constant = true;
+      unsigned HOST_WIDE_INT i;
+      tree elt;
+      FOR_EACH_CONSTRUCTOR_VALUE (CONSTRUCTOR_ELTS (ctor), i, elt)
+	if (!mark_constant_initializer (elt))
+	  is_constant = false;
+
+      if (!is_constant)
+	return false;
+
+      TREE_CONSTANT (ctor) = 1;
+      TREE_STATIC (ctor) = 1;
+      if (ctor != value)
+	recompute_tree_invariant_for_addr_expr (value);
+    }
+
+  return initializer_constant_valid_p (value, TREE_TYPE (value)) != NULL_TREE;
+}
+
+// Whether TYPE holds an UnsafeCell, which lets a static be written through a
+// shared reference, so that it cannot go in read-only memory. What pointers
+// point to is not part of TYPE.
+bool
+HIRCompileBase::has_interior_mutability (Context *ctx, TyTy::BaseType *type)
+{
+  const TyTy::BaseType *resolved = type->destructure ();
+  switch (resolved->get_kind ())
+    {
+      case TyTy::TypeKind::ADT: {
+	const auto *adt = static_cast<const TyTy::ADTType *> (resolved);
+
+	DefId unsafe_cell_id = UNKNOWN_DEFID;
+	if (ctx->get_mappings ()->lookup_lang_item (
+	      Analysis::RustLangItem::ItemType::UNSAFE_CELL, &unsafe_cell_id))
+	  {
+	    HIR::Item *item = ctx->get_mappings ()->lookup_defid (unsafe_cell_id);
+	    HirId item_id = item->get_mappings ().get_hirid ();
+	    if (adt->get_ref () == item_id || adt->get_ty_ref () == item_id)
+	      return true;
+	  }
+
+	for (auto &variant : adt->get_variants ())
+	  for (auto &field : variant->get_fields ())
+	    if (has_interior_mutability (ctx, field->get_field_type ()))
+	      return true;
+	return false;
+      }
+
+      case TyTy::TypeKind::TUPLE: {
+	const auto *tuple = static_cast<const TyTy::TupleType *> (resolved);
+	for (size_t i = 0; i < tuple->num_fields (); i++)
+	  if (has_interior_mutability (ctx, tuple->get_field (i)))
+	    return true;
+	return false;
+      }
+
+      case TyTy::TypeKind::ARRAY: {
+	const auto *array = static_cast<const TyTy::ArrayType *> (resolved);
+	return has_interior_mutability (ctx, array->get_element_type ());
+      }
+
+    default:
+      return false;
+    }
+}
+
+// The type of a parameter of TYPE, which compiles to TYPE_TREE. While the
+// function runs, a &mut T parameter is the only way to reach what it points
+// to, and nothing writes what a &T points to unless it holds an UnsafeCell,
+// which is the promise of a restrict pointer. References to slices, str and
+// trait objects are fat pointers and are left alone.
+tree
+HIRCompileBase::restrict_param_type (Context *ctx, TyTy::BaseType *type,
+				     tree type_tree)
+{
+  if (!flag_rust_restrict_references || !POINTER_TYPE_P (type_tree))
+    return type_tree;
+
+  const TyTy::BaseType *resolved = type->destructure ();
+  if (resolved->get_kind () != TyTy::TypeKind::REF)
+    return type_tree;
+
+  const auto *ref = static_cast<const TyTy::ReferenceType *> (resolved);
+  if (!ref->is_mutable () && has_interior_mutability (ctx, ref->get_base ()))
+    return type_tree;
+
+  return ctx->get_backend ()->restrict_type (type_tree);
+}
+
+struct named_return_value
+{
+  tree fndecl;
+  tree result;
+  tree var;
+};
+
+// Find the local every RETURN_EXPR copies into the result, giving up with
+// error_mark_node when some return is anything else.
+static tree
+find_named_return_value_r (tree *tp, int *walk_subtrees, void *data)
+{
+  named_return_value *nrv = static_cast<named_return_value *> (data);
+  tree t = *tp;
+  if (TYPE_P (t))
+    {
+      *walk_subtrees = 0;
+      return NULL_TREE;
+    }
+  if (TREE_CODE (t) != RETURN_EXPR)
+    return NULL_TREE;
+
+  tree set = TREE_OPERAND (t, 0);
+  if (set == NULL_TREE || TREE_CODE (set) != MODIFY_EXPR
+      || TREE_OPERAND (set, 0) != nrv->result)
+    return error_mark_node;
+
+  tree var = TREE_OPERAND (set, 1);
+  bool is_candidate
+    = VAR_P (var) && DECL_CONTEXT (var) == nrv->fndecl && !TREE_STATIC (var)
+      && !DECL_EXTERNAL (var) && !TREE_THIS_VOLATILE (var)
+      && !DECL_HAS_VALUE_EXPR_P (var)
+      && TYPE_MAIN_VARIANT (TREE_TYPE (var))
+	   == TYPE_MAIN_VARIANT (TREE_TYPE (nrv->result))
+      && DECL_ALIGN (var) <= DECL_ALIGN (nrv->result);
+  if (!is_candidate || (nrv->var != NULL_TREE && nrv->var != var))
+    return error_mark_node;
 
-  return named_constant_expression (const_type, ident, folded_expr, locus);
+  nrv->var = var;
+  *walk_subtrees = 0;
+  return NULL_TREE;
+}
+
+static tree
+apply_named_return_value_r (tree *tp, int *walk_subtrees, void *data)
+{
+  named_return_value *nrv = static_cast<named_return_value *> (data);
+  tree t = *tp;
+  if (TYPE_P (t))
+    *walk_subtrees = 0;
+  else if (TREE_CODE (t) == RETURN_EXPR)
+    {
+      TREE_OPERAND (t, 0) = nrv->result;
+      *walk_subtrees = 0;
+    }
+  return NULL_TREE;
+}
+
+// When every return of FNDECL returns the same local, and the result lives in
+// memory, build that local directly in the return slot instead of copying it
+// there on return, the named return value optimization of the C++ front end.
+// The local becomes an alias of the RESULT_DECL, which keeps it visible to
+// the debugger and leaves its initialization and uses in the body as they
+// are.
+void
+HIRCompileBase::named_return_value_optimization (tree fndecl)
+{
+  tree result = DECL_RESULT (fndecl);
+  if (result == NULL_TREE || result == error_mark_node
+      || TREE_TYPE (result) == void_type_node
+      || !aggregate_value_p (result, fndecl))
+    return;
+
+  named_return_value nrv = {fndecl, result, NULL_TREE};
+  if (walk_tree_without_duplicates (&DECL_SAVED_TREE (fndecl),
+				    find_named_return_value_r, &nrv)
+	!= NULL_TREE
+      || nrv.var == NULL_TREE)
+    return;
+
+  SET_DECL_VALUE_EXPR (nrv.var, result);
+  DECL_HAS_VALUE_EXPR_P (nrv.var) = 1;
+  walk_tree_without_duplicates (&DECL_SAVED_TREE (fndecl),
+				apply_named_return_value_r, &nrv);
+}
+
+// Build the value of VARIANT_INDEX of the enum ADT from the compiled values of
+// its fields.
+tree
+HIRCompileBase::enum_variant_constructor (TyTy::ADTType *adt,
+					  tree compiled_adt_type,
+					  TyTy::VariantDef *variant,
+					  int variant_index,
+					  const std::vector<tree> &arguments,
+					  Location locus)
+{
+  if (compiled_adt_type == error_mark_node)
+    return error_mark_node;
+
+  EnumNiche niche;
+  if (TyTyResolveCompile::get_enum_niche (*adt, &niche))
+    {
+      if (variant_index == niche.dataful_variant)
+	return ctx->get_backend ()->constructor_expression (compiled_adt_type,
+							    true, arguments,
+							    variant_index,
+							    locus);
+
+      // the data-less variants only set the niche
+      tree field = TYPE_FIELDS (compiled_adt_type);
+      for (int i = 0; i < niche.niche_field; i++)
+	field = DECL_CHAIN (field);
+      tree value = build_int_cstu (TREE_TYPE (field),
+				   niche.value_for_variant (variant_index));
+
+      return ctx->get_backend ()->constructor_expression (compiled_adt_type,
+							  false, {value},
+							  niche.niche_field,
+							  locus);
+    }
+
+  // otherwise the discriminator comes first in every variant
+  HIR::Expr *discrim_expr = variant->get_discriminant ();
+  tree discrim_expr_node = CompileExpr::Compile (discrim_expr, ctx);
+  tree qualifier = fold_expr (discrim_expr_node);
+
+  std::vector<tree> ctor_arguments;
+  ctor_arguments.push_back (qualifier);
+  for (auto &arg : arguments)
+    ctor_arguments.push_back (arg);
+
+  return ctx->get_backend ()->constructor_expression (compiled_adt_type, true,
+						      ctor_arguments,
+						      variant_index, locus);
+}
+
+// The value a match on the enum value SCRUTINEE switches over, with the arms
+// labelled by enum_variant_case_label. Enums with a niche switch on the niche
+// itself, so the switch lowering sees through the layout and can still pick a
+// jump table or a compact decision tree over the values.
+tree
+HIRCompileBase::enum_switch_expression (TyTy::ADTType *adt, tree scrutinee,
+					Location locus)
+{
+  EnumNiche niche;
+  if (TyTyResolveCompile::get_enum_niche (*adt, &niche))
+    return ctx->get_backend ()->struct_field_expression (scrutinee,
+							  niche.niche_field,
+							  locus);
+
+  // need to access qualifier the field, if we use QUAL_UNION_TYPE this
+  // would be DECL_QUALIFIER i think. For now this will just access the
+  // first record field and its respective qualifier because it will always
+  // be set because this is all a big special union
+  tree first_record
+    = ctx->get_backend ()->struct_field_expression (scrutinee, 0, locus);
+  return ctx->get_backend ()->struct_field_expression (first_record, 0, locus);
+}
+
+// The case label for the arms matching variant VARIANT_INDEX of ADT in a
+// switch over enum_switch_expression.
+tree
+HIRCompileBase::enum_variant_case_label (TyTy::ADTType *adt,
+					 int variant_index, tree label)
+{
+  EnumNiche niche;
+  if (!TyTyResolveCompile::get_enum_niche (*adt, &niche))
+    {
+      TyTy::VariantDef *variant = adt->get_variants ().at (variant_index);
+      HIR::Expr *discrim_expr = variant->get_discriminant ();
+      tree discrim_expr_node = CompileExpr::Compile (discrim_expr, ctx);
+      tree folded_discrim_expr = fold_expr (discrim_expr_node);
+
+      return build_case_label (folded_discrim_expr, NULL_TREE, label);
+    }
+
+  tree compiled_adt_type = TyTyResolveCompile::compile (ctx, adt);
+  tree field = TYPE_FIELDS (compiled_adt_type);
+  for (int i = 0; i < niche.niche_field; i++)
+    field = DECL_CHAIN (field);
+  tree niche_type = TREE_TYPE (field);
+
+  if (variant_index != niche.dataful_variant)
+    {
+      tree value
+	= build_int_cstu (niche_type, niche.value_for_variant (variant_index));
+      return build_case_label (value, NULL_TREE, label);
+    }
+
+  // the variant holding data owns every valid value of the field
+  tree low = build_int_cstu (niche_type, niche.valid_start);
+  tree high = niche.valid_end == HOST_WIDE_INT_M1U
+		? TYPE_MAX_VALUE (niche_type)
+		: build_int_cstu (niche_type, niche.valid_end);
+  return build_case_label (low, high, label);
+}
+
+// Field FIELD_INDEX of variant VARIANT_INDEX of the enum value SCRUTINEE.
+tree
+HIRCompileBase::enum_variant_field_expression (TyTy::ADTType *adt,
+					       tree scrutinee,
+					       int variant_index,
+					       size_t field_index,
+					       Location locus)
+{
+  tree variant_accessor
+    = ctx->get_backend ()->struct_field_expression (scrutinee, variant_index,
+						    locus);
+
+  // we are offsetting by + 1 here since the first field in the record is the
+  // discriminator, unless the enum keeps it in a niche instead
+  if (!TyTyResolveCompile::get_enum_niche (*adt, nullptr))
+    field_index++;
+
+  return ctx->get_backend ()->struct_field_expression (variant_accessor,
+						       field_index, locus);
 }
 
 tree
@@ -741,5 +1388,20 @@ HIRCompileBase::named_constant_expression (tree type_tree,
   return decl;
 }
 
+// The tree to use for a reference to the constant DECL. A constant over its
+// evaluation budget is still the call computing it, which the gimplifier
+// would otherwise substitute for every use without copying, so each use gets
+// its own copy of the call.
+tree
+HIRCompileBase::constant_use (tree decl)
+{
+  if (decl != error_mark_node && TREE_CODE (decl) == CONST_DECL
+      && DECL_INITIAL (decl) != NULL_TREE
+      && TREE_CODE (DECL_INITIAL (decl)) == CALL_EXPR)
+    return unshare_expr (DECL_INITIAL (decl));
+
+  return decl;
+}
+
 } // namespace Compile
 } // namespace Rust
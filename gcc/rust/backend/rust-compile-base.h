@@ -50,6 +50,10 @@ protected:
   tree coerce_to_dyn_object (tree compiled_ref, const TyTy::BaseType *actual,
 			     const TyTy::DynamicObjectType *ty, Location locus);
 
+  tree compile_vtable (const TyTy::BaseType *actual,
+		       const TyTy::DynamicObjectType *ty, tree vtable_type,
+		       Location locus);
+
   tree compute_address_for_trait_item (
     const Resolver::TraitItemReference *ref,
     const TyTy::TypeBoundPredicate *predicate,
@@ -60,11 +64,30 @@ protected:
   bool verify_array_capacities (tree ltype, tree rtype, Location ltype_locus,
 				Location rtype_locus);
 
+  tree enum_variant_constructor (TyTy::ADTType *adt, tree compiled_adt_type,
+				 TyTy::VariantDef *variant, int variant_index,
+				 const std::vector<tree> &arguments,
+				 Location locus);
+
+  tree enum_switch_expression (TyTy::ADTType *adt, tree scrutinee,
+			       Location locus);
+
+  tree enum_variant_case_label (TyTy::ADTType *adt, int variant_index,
+				tree label);
+
+  tree enum_variant_field_expression (TyTy::ADTType *adt, tree scrutinee,
+				      int variant_index, size_t field_index,
+				      Location locus);
+
   tree query_compile (HirId ref, TyTy::BaseType *lookup,
 		      const HIR::PathIdentSegment &final_segment,
 		      const Analysis::NodeMapping &mappings,
 		      Location expr_locus, bool is_qualified_path);
 
+  // mark the locals and constants which the HIR simplifier dropped from the
+  // node ID as used, as if the paths naming them had been compiled
+  void mark_retained_uses (HirId id);
+
   tree resolve_adjustements (std::vector<Resolver::Adjustment> &adjustments,
 			     tree expression, Location locus);
 
@@ -86,7 +109,8 @@ protected:
   static void setup_fndecl (tree fndecl, bool is_main_entry_point,
 			    bool is_generic_fn, HIR::Visibility &visibility,
 			    const HIR::FunctionQualifiers &qualifiers,
-			    const AST::AttrVec &attrs);
+			    const AST::AttrVec &attrs,
+			    const Analysis::BuiltinAttrSet &builtin_attrs);
 
   static void handle_inline_attribute_on_fndecl (tree fndecl,
 						 const AST::Attribute &attr);
@@ -107,8 +131,26 @@ protected:
   static void handle_no_mangle_attribute_on_fndecl (tree fndecl,
 						    const AST::Attribute &attr);
 
+  static void
+  handle_target_feature_attribute_on_fndecl (tree fndecl,
+					     const AST::Attribute &attr);
+
+  static void
+  handle_target_clones_attribute_on_fndecl (tree fndecl,
+					    const AST::Attribute &attr);
+
   static void setup_abi_options (tree fndecl, ABI abi);
 
+  static void
+  setup_allocator_fndecl (tree fndecl,
+			  const Analysis::BuiltinAttrSet &builtin_attrs);
+
+  static bool
+  has_thread_local_attribute (const AST::AttrVec &attrs,
+			      const Analysis::BuiltinAttrSet &builtin_attrs);
+
+  static void setup_thread_local_decl (tree decl);
+
   static tree address_expression (tree expr, Location locus);
 
   static tree indirect_expression (tree expr, Location locus);
@@ -122,22 +164,40 @@ protected:
 				     HIR::BlockExpr &function_body,
 				     bool has_return_type);
 
+  static bool function_has_overflow_checks (Context *ctx,
+					    const TyTy::FnType *fntype,
+					    const Analysis::BuiltinAttrSet &attrs);
+
   static tree compile_function (
     Context *ctx, const std::string &fn_name, HIR::SelfParam &self_param,
     std::vector<HIR::FunctionParam> &function_params,
     const HIR::FunctionQualifiers &qualifiers, HIR::Visibility &visibility,
-    AST::AttrVec &outer_attrs, Location locus, HIR::BlockExpr *function_body,
+    const AST::AttrVec &outer_attrs,
+    const Analysis::BuiltinAttrSet &builtin_attrs, Location locus,
+    HIR::BlockExpr *function_body,
     const Resolver::CanonicalPath *canonical_path, TyTy::FnType *fntype,
     bool function_has_return);
 
   static tree
   compile_constant_item (Context *ctx, TyTy::BaseType *resolved_type,
 			 const Resolver::CanonicalPath *canonical_path,
-			 HIR::Expr *const_value_expr, Location locus);
+			 HIR::Expr *const_value_expr, Location locus,
+			 bool is_static = false);
 
   static tree named_constant_expression (tree type_tree,
 					 const std::string &name,
 					 tree const_val, Location location);
+
+  static tree constant_use (tree decl);
+
+  static bool mark_constant_initializer (tree value);
+
+  static bool has_interior_mutability (Context *ctx, TyTy::BaseType *type);
+
+  static tree restrict_param_type (Context *ctx, TyTy::BaseType *type,
+				   tree type_tree);
+
+  static void named_return_value_optimization (tree fndecl);
 };
 
 } // namespace Compile
@@ -98,9 +98,37 @@ CompileBlock::visit (HIR::BlockExpr &expr)
   translated = new_block;
 }
 
+bool
+CompileConditionalBlocks::known_condition (HIR::IfExpr &expr, bool *taken)
+{
+  HIR::Expr *condition = expr.get_if_condition ();
+  if (condition->get_expression_type () != HIR::Expr::ExprType::Lit)
+    return false;
+
+  auto literal = static_cast<HIR::LiteralExpr *> (condition);
+  if (literal->get_lit_type () != HIR::Literal::BOOL)
+    return false;
+
+  // the untaken branch is not lowered at all, but what it uses still counts
+  mark_retained_uses (expr.get_mappings ().get_hirid ());
+  mark_retained_uses (condition->get_mappings ().get_hirid ());
+
+  *taken = literal->get_literal ().as_string ().compare ("true") == 0;
+  return true;
+}
+
 void
 CompileConditionalBlocks::visit (HIR::IfExpr &expr)
 {
+  bool taken;
+  if (known_condition (expr, &taken))
+    {
+      translated
+	= taken ? CompileBlock::compile (expr.get_if_block (), ctx, result)
+		: build_empty_stmt (expr.get_locus ().gcc_location ());
+      return;
+    }
+
   fncontext fnctx = ctx->peek_fn ();
   tree fndecl = fnctx.fndecl;
   tree condition_expr = CompileExpr::Compile (expr.get_if_condition (), ctx);
@@ -114,6 +142,15 @@ CompileConditionalBlocks::visit (HIR::IfExpr &expr)
 void
 CompileConditionalBlocks::visit (HIR::IfExprConseqElse &expr)
 {
+  bool taken;
+  if (known_condition (expr, &taken))
+    {
+      translated = CompileBlock::compile (taken ? expr.get_if_block ()
+						: expr.get_else_block (),
+					  ctx, result);
+      return;
+    }
+
   fncontext fnctx = ctx->peek_fn ();
   tree fndecl = fnctx.fndecl;
   tree condition_expr = CompileExpr::Compile (expr.get_if_condition (), ctx);
@@ -128,6 +165,16 @@ CompileConditionalBlocks::visit (HIR::IfExprConseqElse &expr)
 void
 CompileConditionalBlocks::visit (HIR::IfExprConseqIf &expr)
 {
+  bool taken;
+  if (known_condition (expr, &taken))
+    {
+      translated
+	= taken ? CompileBlock::compile (expr.get_if_block (), ctx, result)
+		: CompileConditionalBlocks::compile (expr.get_conseq_if_expr (),
+						     ctx, result);
+      return;
+    }
+
   fncontext fnctx = ctx->peek_fn ();
   tree fndecl = fnctx.fndecl;
   tree condition_expr = CompileExpr::Compile (expr.get_if_condition (), ctx);
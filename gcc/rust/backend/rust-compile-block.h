@@ -112,6 +112,10 @@ private:
     : HIRCompileBase (ctx), translated (nullptr), result (result)
   {}
 
+  // Whether the condition of EXPR was folded to a literal, and if so which
+  // branch is TAKEN
+  bool known_condition (HIR::IfExpr &expr, bool *taken);
+
   tree translated;
   Bvariable *result;
 };
@@ -17,7 +17,6 @@
 // <http://www.gnu.org/licenses/>.
 
 #include "rust-compile-context.h"
-#include "rust-compile-type.h"
 
 namespace Rust {
 namespace Compile {
@@ -25,28 +24,10 @@ namespace Compile {
 Context::Context (::Backend *backend)
   : backend (backend), resolver (Resolver::Resolver::get ()),
     tyctx (Resolver::TypeCheckContext::get ()),
-    mappings (Analysis::Mappings::get ()), mangler (Mangler ())
-{
-  setup_builtins ();
-}
-
-void
-Context::setup_builtins ()
-{
-  auto builtins = resolver->get_builtin_types ();
-  for (auto it = builtins.begin (); it != builtins.end (); it++)
-    {
-      HirId ref;
-      bool ok = tyctx->lookup_type_by_node_id ((*it)->get_node_id (), &ref);
-      rust_assert (ok);
-
-      TyTy::BaseType *lookup;
-      ok = tyctx->lookup_type (ref, &lookup);
-      rust_assert (ok);
-
-      TyTyResolveCompile::compile (this, lookup);
-    }
-}
+    mappings (Analysis::Mappings::get ()), mangler (Mangler ()),
+    gc_roots_mark (rust_gc_roots_mark ()), compiled_type_map (64),
+    main_variants (64)
+{}
 
 hashval_t
 Context::type_hasher (tree type)
@@ -142,5 +123,123 @@ Context::type_hasher (tree type)
   return hstate.end ();
 }
 
+bool
+Context::types_equal (tree a, tree b)
+{
+  if (a == b)
+    return true;
+
+  if (TREE_CODE (a) != TREE_CODE (b))
+    return false;
+
+  if ((TYPE_NAME (a) == NULL_TREE) != (TYPE_NAME (b) == NULL_TREE))
+    return false;
+  if (TYPE_NAME (a) && DECL_NAME (TYPE_NAME (a)) != DECL_NAME (TYPE_NAME (b)))
+    return false;
+
+  tree attr_a = TYPE_ATTRIBUTES (a);
+  tree attr_b = TYPE_ATTRIBUTES (b);
+  for (; attr_a && attr_b;
+       attr_a = TREE_CHAIN (attr_a), attr_b = TREE_CHAIN (attr_b))
+    {
+      if (TREE_PURPOSE (attr_a) != TREE_PURPOSE (attr_b))
+	return false;
+    }
+  if (attr_a || attr_b)
+    return false;
+
+  switch (TREE_CODE (a))
+    {
+    case METHOD_TYPE:
+      if (TYPE_METHOD_BASETYPE (a) != TYPE_METHOD_BASETYPE (b))
+	return false;
+      /* FALLTHROUGH. */
+      case FUNCTION_TYPE: {
+	if (TREE_TYPE (a) != TREE_TYPE (b))
+	  return false;
+
+	tree arg_a = TYPE_ARG_TYPES (a);
+	tree arg_b = TYPE_ARG_TYPES (b);
+	for (; arg_a && arg_b;
+	     arg_a = TREE_CHAIN (arg_a), arg_b = TREE_CHAIN (arg_b))
+	  {
+	    if (TREE_VALUE (arg_a) != TREE_VALUE (arg_b))
+	      return false;
+	  }
+	return arg_a == arg_b;
+      }
+
+    case OFFSET_TYPE:
+      return TYPE_OFFSET_BASETYPE (a) == TYPE_OFFSET_BASETYPE (b)
+	     && TREE_TYPE (a) == TREE_TYPE (b);
+
+    case ARRAY_TYPE:
+      return TYPE_DOMAIN (a) == TYPE_DOMAIN (b)
+	     && TYPE_TYPELESS_STORAGE (a) == TYPE_TYPELESS_STORAGE (b)
+	     && types_equal (TREE_TYPE (a), TREE_TYPE (b));
+
+      case INTEGER_TYPE: {
+	if (TYPE_PRECISION (a) != TYPE_PRECISION (b)
+	    || TYPE_UNSIGNED (a) != TYPE_UNSIGNED (b))
+	  return false;
+
+	tree max_a = TYPE_MAX_VALUE (a);
+	tree max_b = TYPE_MAX_VALUE (b);
+	if (!max_a || !max_b)
+	  {
+	    max_a = TYPE_MIN_VALUE (a);
+	    max_b = TYPE_MIN_VALUE (b);
+	  }
+	return tree_int_cst_equal (max_a, max_b);
+      }
+
+    case REAL_TYPE:
+    case FIXED_POINT_TYPE:
+      return TYPE_PRECISION (a) == TYPE_PRECISION (b);
+
+    case VECTOR_TYPE:
+      return known_eq (TYPE_VECTOR_SUBPARTS (a), TYPE_VECTOR_SUBPARTS (b))
+	     && types_equal (TREE_TYPE (a), TREE_TYPE (b));
+
+    case RECORD_TYPE:
+    case UNION_TYPE:
+      case QUAL_UNION_TYPE: {
+	tree field_a = TYPE_FIELDS (a);
+	tree field_b = TYPE_FIELDS (b);
+	for (; field_a && field_b;
+	     field_a = TREE_CHAIN (field_a), field_b = TREE_CHAIN (field_b))
+	  {
+	    if (DECL_NAME (field_a) != DECL_NAME (field_b)
+		|| !types_equal (TREE_TYPE (field_a), TREE_TYPE (field_b)))
+	      return false;
+	  }
+	return field_a == field_b;
+      }
+
+    case REFERENCE_TYPE:
+    case POINTER_TYPE:
+      return types_equal (TREE_TYPE (a), TREE_TYPE (b));
+
+    default:
+      return true;
+    }
+}
+
+size_t compiled_type_hasher::collisions = 0;
+
+bool
+compiled_type_hasher::equal (const compiled_type_entry *a,
+			     const compiled_type_entry *b)
+{
+  if (a->hash != b->hash)
+    return false;
+
+  if (Context::types_equal (a->type, b->type))
+    return true;
+
+  collisions++;
+  return false;
+}
+
 } // namespace Compile
 } // namespace Rust
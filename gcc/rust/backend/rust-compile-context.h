@@ -27,6 +27,7 @@
 #include "rust-hir-full.h"
 #include "rust-mangle.h"
 #include "rust-tree.h"
+#include "rust-compile-fn-merge.h"
 
 namespace Rust {
 namespace Compile {
@@ -35,6 +36,29 @@ struct fncontext
 {
   tree fndecl;
   ::Bvariable *ret_addr;
+  bool overflow_checks;
+};
+
+// an entry in the compiled type caches, the hash is kept alongside the type so
+// that only entries whose hashes match are ever compared structurally
+struct compiled_type_entry
+{
+  hashval_t hash;
+  tree type;
+};
+
+struct compiled_type_hasher : nofree_ptr_hash<compiled_type_entry>
+{
+  static hashval_t hash (const compiled_type_entry *entry)
+  {
+    return entry->hash;
+  }
+
+  static bool equal (const compiled_type_entry *a,
+		     const compiled_type_entry *b);
+
+  // the number of times two different types had the same hash
+  static size_t collisions;
 };
 
 class Context
@@ -42,40 +66,82 @@ class Context
 public:
   Context (::Backend *backend);
 
-  void setup_builtins ();
-
   bool lookup_compiled_types (tree t, tree *type)
   {
-    hashval_t h = type_hasher (t);
-    auto it = compiled_type_map.find (h);
-    if (it == compiled_type_map.end ())
-      return false;
+    compiled_type_entry key = {type_hasher (t), t};
+    compiled_type_entry *found = compiled_type_map.find (&key);
+    if (found == nullptr)
+      {
+	type_cache_misses++;
+	return false;
+      }
 
-    *type = it->second;
+    type_cache_hits++;
+    *type = found->type;
     return true;
   }
 
+  // the type cache statistics count the lookups of compiled_type_map, each
+  // once, whichever of these makes it
   tree insert_compiled_type (tree type)
   {
-    hashval_t h = type_hasher (type);
-    auto it = compiled_type_map.find (h);
-    if (it != compiled_type_map.end ())
-      return it->second;
+    bool found = false;
+    tree canonical = insert_cached_type (compiled_type_map, type, &found);
+    if (found)
+      {
+	type_cache_hits++;
+	return canonical;
+      }
 
-    compiled_type_map.insert ({h, type});
+    type_cache_misses++;
     push_type (type);
     return type;
   }
 
   tree insert_main_variant (tree type)
   {
-    hashval_t h = type_hasher (type);
-    auto it = main_variants.find (h);
-    if (it != main_variants.end ())
-      return it->second;
+    bool found = false;
+    return insert_cached_type (main_variants, type, &found);
+  }
 
-    main_variants.insert ({h, type});
-    return type;
+  // every compiled instance of each function, monomorphized instances of a
+  // generic function share its DefId
+  const std::map<DefId, std::vector<std::pair<const TyTy::BaseType *, tree>>> &
+  get_mono_fns () const
+  {
+    return mono_fns;
+  }
+
+  // the generic instances defined with a public symbol so that dependent
+  // crates link against them instead of instantiating them again
+  void insert_shared_instance (const std::string &asm_name)
+  {
+    shared_instances.push_back (asm_name);
+  }
+
+  const std::vector<std::string> &get_shared_instances () const
+  {
+    return shared_instances;
+  }
+
+  // every struct, union and enum compiled, by the name of the instance, with
+  // whether it is an enum
+  void insert_compiled_adt (const std::string &name, tree type, bool is_enum)
+  {
+    compiled_adts[name] = {type, is_enum};
+  }
+
+  const std::map<std::string, std::pair<tree, bool>> &
+  get_compiled_adts () const
+  {
+    return compiled_adts;
+  }
+
+  size_t get_type_cache_hits () const { return type_cache_hits; }
+  size_t get_type_cache_misses () const { return type_cache_misses; }
+  size_t get_type_cache_collisions () const
+  {
+    return compiled_type_hasher::collisions;
   }
 
   ::Backend *get_backend () { return backend; }
@@ -94,11 +160,9 @@ public:
     auto block = scope_stack.back ();
     scope_stack.pop_back ();
 
-    auto stmts = statements.back ();
+    backend->block_add_statements (block, statements.back ());
     statements.pop_back ();
 
-    backend->block_add_statements (block, stmts);
-
     return block;
   }
 
@@ -119,16 +183,16 @@ public:
 
   void insert_var_decl (HirId id, ::Bvariable *decl)
   {
-    compiled_var_decls[id] = decl;
+    compiled_var_decls.insert (id, decl);
   }
 
   bool lookup_var_decl (HirId id, ::Bvariable **decl)
   {
-    auto it = compiled_var_decls.find (id);
-    if (it == compiled_var_decls.end ())
+    ::Bvariable **found = compiled_var_decls.lookup (id);
+    if (found == nullptr)
       return false;
 
-    *decl = it->second;
+    *decl = *found;
     return true;
   }
 
@@ -137,14 +201,17 @@ public:
     auto id = ref->get_ty_ref ();
     auto dId = ref->get_id ();
 
-    rust_assert (compiled_fn_map.find (id) == compiled_fn_map.end ());
-    compiled_fn_map[id] = fn;
-
-    auto it = mono_fns.find (dId);
-    if (it == mono_fns.end ())
-      mono_fns[dId] = {};
+    rust_assert (!compiled_fn_map.contains (id));
+    compiled_fn_map.insert (id, fn);
 
     mono_fns[dId].push_back ({ref, fn});
+    mono_fn_types[dId][ref->as_string ()].push_back ({ref, fn});
+    if (DECL_ASSEMBLER_NAME_SET_P (fn))
+      {
+	tree raw = DECL_ASSEMBLER_NAME_RAW (fn);
+	std::string asm_name (IDENTIFIER_POINTER (raw), IDENTIFIER_LENGTH (raw));
+	mono_fn_asm_names.insert ({asm_name, {dId, fn}});
+      }
   }
 
   bool lookup_function_decl (HirId id, tree *fn, DefId dId = UNKNOWN_DEFID,
@@ -156,96 +223,231 @@ public:
       {
 	rust_assert (dId != UNKNOWN_DEFID);
 
-	auto it = mono_fns.find (dId);
-	if (it == mono_fns.end ())
+	auto it = mono_fn_types.find (dId);
+	if (it == mono_fn_types.end ())
 	  return false;
 
-	for (auto &e : mono_fns[dId])
+	// equal types print the same, so only the instances in this bucket
+	// need the full comparison
+	auto bucket = it->second.find (ref->as_string ());
+	if (bucket != it->second.end ())
 	  {
-	    const TyTy::BaseType *r = e.first;
-	    tree f = e.second;
-
-	    if (ref->is_equal (*r))
+	    for (auto &e : bucket->second)
 	      {
-		*fn = f;
-		return true;
-	      }
-
-	    if (DECL_ASSEMBLER_NAME_SET_P (f) && !asm_name.empty ())
-	      {
-		tree raw = DECL_ASSEMBLER_NAME_RAW (f);
-		const char *rptr = IDENTIFIER_POINTER (raw);
-
-		bool lengths_match_p
-		  = IDENTIFIER_LENGTH (raw) == asm_name.size ();
-		if (lengths_match_p
-		    && strncmp (rptr, asm_name.c_str (),
-				IDENTIFIER_LENGTH (raw))
-			 == 0)
+		if (ref->is_equal (*e.first))
 		  {
-		    *fn = f;
+		    *fn = e.second;
 		    return true;
 		  }
 	      }
 	  }
+
+	if (!asm_name.empty ())
+	  {
+	    auto named = mono_fn_asm_names.find (asm_name);
+	    if (named != mono_fn_asm_names.end () && named->second.first == dId)
+	      {
+		*fn = named->second.second;
+		return true;
+	      }
+	  }
 	return false;
       }
 
-    auto it = compiled_fn_map.find (id);
-    if (it == compiled_fn_map.end ())
+    tree *found = compiled_fn_map.lookup (id);
+    if (found == nullptr)
       return false;
 
-    *fn = it->second;
+    *fn = *found;
     return true;
   }
 
-  void insert_const_decl (HirId id, tree expr) { compiled_consts[id] = expr; }
+  // the type parameters each generic function's instances depend on, by the
+  // function's DefId, see TypeParamUsage
+  void insert_type_param_usage (DefId id, std::vector<bool> used)
+  {
+    type_param_usage[id] = std::move (used);
+  }
+
+  const std::vector<bool> *lookup_type_param_usage (DefId id) const
+  {
+    auto it = type_param_usage.find (id);
+    if (it == type_param_usage.end ())
+      return nullptr;
+    return &it->second;
+  }
+
+  /* Find an instance of the same function as INSTANCE whose substitutions
+   * only differ from it in the type parameters that are not USED. */
+  bool lookup_shared_instance (const TyTy::FnType *instance,
+			       const std::vector<bool> &used, tree *fn)
+  {
+    auto it = mono_fns.find (instance->get_id ());
+    if (it == mono_fns.end ())
+      return false;
+
+    const auto &substs = instance->get_substs ();
+    rust_assert (used.size () == substs.size ());
+    for (auto &e : it->second)
+      {
+	if (e.first->get_kind () != TyTy::TypeKind::FNDEF)
+	  continue;
+
+	auto other = static_cast<const TyTy::FnType *> (e.first);
+	const auto &other_substs = other->get_substs ();
+	if (other_substs.size () != substs.size ())
+	  continue;
+
+	bool same = true;
+	for (size_t i = 0; i < substs.size () && same; i++)
+	  {
+	    if (!used[i])
+	      continue;
+
+	    const TyTy::ParamType *a = substs.at (i).get_param_ty ();
+	    const TyTy::ParamType *b = other_substs.at (i).get_param_ty ();
+	    same = a->can_resolve () && b->can_resolve ()
+		   && a->resolve ()->is_equal (*b->resolve ());
+	  }
+
+	if (same)
+	  {
+	    *fn = e.second;
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  void insert_const_decl (HirId id, tree expr)
+  {
+    compiled_consts.insert (id, expr);
+  }
 
   bool lookup_const_decl (HirId id, tree *expr)
   {
-    auto it = compiled_consts.find (id);
-    if (it == compiled_consts.end ())
+    tree *found = compiled_consts.lookup (id);
+    if (found == nullptr)
+      return false;
+
+    *expr = *found;
+    return true;
+  }
+
+  // constant expressions are evaluated once per expression and concrete type
+  // and the folded result is reused for every later use
+  void insert_const_value (HirId expr_id, const std::string &type_key,
+			   tree value)
+  {
+    const_values[{expr_id, type_key}] = value;
+  }
+
+  bool lookup_const_value (HirId expr_id, const std::string &type_key,
+			   tree *value)
+  {
+    auto it = const_values.find ({expr_id, type_key});
+    if (it == const_values.end ())
       return false;
 
-    *expr = it->second;
+    *value = it->second;
     return true;
   }
 
-  void insert_label_decl (HirId id, tree label) { compiled_labels[id] = label; }
+  // one vtable is emitted per concrete type and trait object type, keyed by
+  // the type reference and string of the concrete type, which tells apart
+  // instances of the same generic type, and by the trait object's string
+  void insert_vtable (const TyTy::BaseType *concrete,
+		      const TyTy::BaseType *dyn, tree vtable)
+  {
+    vtables[vtable_key (concrete, dyn)] = vtable;
+  }
+
+  bool lookup_vtable (const TyTy::BaseType *concrete,
+		      const TyTy::BaseType *dyn, tree *vtable)
+  {
+    auto it = vtables.find (vtable_key (concrete, dyn));
+    if (it == vtables.end ())
+      return false;
+
+    *vtable = it->second;
+    return true;
+  }
+
+  // string and byte string literals are interned per crate so every
+  // occurrence of the same contents shares one constant. They are keyed by
+  // the hash of their contents and compared against the STRING_CST itself,
+  // so an included file is not held once more as a key.
+  void insert_string_literal (const std::string &value, tree cst)
+  {
+    string_literals[string_literal_hash (value)].push_back (cst);
+  }
+
+  bool lookup_string_literal (const std::string &value, tree *cst)
+  {
+    auto it = string_literals.find (string_literal_hash (value));
+    if (it == string_literals.end ())
+      return false;
+
+    for (tree candidate : it->second)
+      {
+	// the constant holds the terminating nul as well
+	if (static_cast<size_t> (TREE_STRING_LENGTH (candidate))
+	      == value.size () + 1
+	    && memcmp (TREE_STRING_POINTER (candidate), value.data (),
+		       value.size ())
+		 == 0)
+	  {
+	    *cst = candidate;
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  void insert_label_decl (HirId id, tree label)
+  {
+    compiled_labels.insert (id, label);
+  }
 
   bool lookup_label_decl (HirId id, tree *label)
   {
-    auto it = compiled_labels.find (id);
-    if (it == compiled_labels.end ())
+    tree *found = compiled_labels.lookup (id);
+    if (found == nullptr)
       return false;
 
-    *label = it->second;
+    *label = *found;
     return true;
   }
 
   void insert_pattern_binding (HirId id, tree binding)
   {
-    implicit_pattern_bindings[id] = binding;
+    implicit_pattern_bindings.insert (id, binding);
   }
 
   bool lookup_pattern_binding (HirId id, tree *binding)
   {
-    auto it = implicit_pattern_bindings.find (id);
-    if (it == implicit_pattern_bindings.end ())
+    tree *found = implicit_pattern_bindings.lookup (id);
+    if (found == nullptr)
       return false;
 
-    *binding = it->second;
+    *binding = *found;
     return true;
   }
 
-  void push_fn (tree fn, ::Bvariable *ret_addr)
+  void push_fn (tree fn, ::Bvariable *ret_addr, bool overflow_checks = false)
   {
-    fn_stack.push_back (fncontext{fn, ret_addr});
+    fn_stack.push_back (fncontext{fn, ret_addr, overflow_checks});
   }
   void pop_fn () { fn_stack.pop_back (); }
 
   bool in_fn () { return fn_stack.size () != 0; }
 
+  // whether the arithmetic of the function being compiled traps on overflow
+  bool overflow_checks_p ()
+  {
+    return in_fn () && fn_stack.back ().overflow_checks;
+  }
+
   // Note: it is undefined behavior to call peek_fn () if fn_stack is empty.
   fncontext peek_fn ()
   {
@@ -256,12 +458,29 @@ public:
   void push_type (tree t) { type_decls.push_back (t); }
   void push_var (::Bvariable *v) { var_decls.push_back (v); }
   void push_const (tree c) { const_decls.push_back (c); }
-  void push_function (tree f) { func_decls.push_back (f); }
+  void push_function (tree f)
+  {
+    func_decls.push_back (f);
+
+    // with -frust-stream-codegen the middle-end gets each function as soon
+    // as its body is complete instead of in one batch at the end
+    if (flag_rust_stream_codegen)
+      backend->write_function_definition (f);
+  }
 
   void write_to_backend ()
   {
-    backend->write_global_definitions (type_decls, const_decls, func_decls,
+    // streamed functions have already been finalized, the others are first
+    // merged with any function compiled to the same body
+    std::vector<tree> fns;
+    if (!flag_rust_stream_codegen)
+      fns = flag_rust_merge_functions ? FunctionMerger::merge (func_decls)
+				      : func_decls;
+    backend->write_global_definitions (type_decls, const_decls, fns,
 				       var_decls);
+
+    // the middle-end now references everything it needs
+    rust_release_gc_roots (gc_roots_mark);
   }
 
   bool function_completed (tree fn)
@@ -310,10 +529,20 @@ public:
   }
   bool const_context_p (void) { return (const_context > 0); }
 
-  std::string mangle_item (const TyTy::BaseType *ty,
-			   const Resolver::CanonicalPath &path) const
+  /* Items are mangled every time they are declared or referenced, so the
+   * result is kept per type instance and path. Types are never freed during
+   * compilation, which makes the pointer a stable key. */
+  const std::string &mangle_item (const TyTy::BaseType *ty,
+				  const Resolver::CanonicalPath &path)
   {
-    return mangler.mangle_item (ty, path);
+    auto key = std::make_pair (ty, path.get_node_id ());
+    auto it = mangled_items.find (key);
+    if (it != mangled_items.end ())
+      return it->second;
+
+    auto res
+      = mangled_items.insert ({key, mangler.mangle_item (ty, path)}).first;
+    return res->second;
   }
 
   std::vector<tree> &get_type_decls () { return type_decls; }
@@ -323,28 +552,83 @@ public:
 
   static hashval_t type_hasher (tree type);
 
+  // structural equality matching what type_hasher looks at
+  static bool types_equal (tree a, tree b);
+
 private:
+  static hashval_t string_literal_hash (const std::string &value)
+  {
+    return iterative_hash (value.data (), value.size (), 0);
+  }
+
+  static std::pair<HirId, std::string>
+  vtable_key (const TyTy::BaseType *concrete, const TyTy::BaseType *dyn)
+  {
+    return {concrete->get_ty_ref (),
+	    concrete->as_string () + " as " + dyn->as_string ()};
+  }
+
+  // return the type already in TABLE that is structurally equal to TYPE,
+  // setting FOUND, or insert TYPE and return it
+  tree insert_cached_type (hash_table<compiled_type_hasher> &table, tree type,
+			   bool *found)
+  {
+    compiled_type_entry key = {type_hasher (type), type};
+    compiled_type_entry **slot = table.find_slot (&key, INSERT);
+    *found = *slot != nullptr;
+    if (*found)
+      return (*slot)->type;
+
+    type_cache_entries.push_back (key);
+    *slot = &type_cache_entries.back ();
+    return type;
+  }
+
   ::Backend *backend;
   Resolver::Resolver *resolver;
   Resolver::TypeCheckContext *tyctx;
   Analysis::Mappings *mappings;
   Mangler mangler;
+  std::map<std::pair<const TyTy::BaseType *, NodeId>, std::string>
+    mangled_items;
+
+  // the trees preserved from the garbage collector before this context
+  size_t gc_roots_mark;
 
   // state
   std::vector<fncontext> fn_stack;
-  std::map<HirId, ::Bvariable *> compiled_var_decls;
-  std::map<hashval_t, tree> compiled_type_map;
-  std::map<HirId, tree> compiled_fn_map;
-  std::map<HirId, tree> compiled_consts;
-  std::map<HirId, tree> compiled_labels;
+  // the side tables keyed by HirId are looked up by every reference to a
+  // variable, function or constant, HirIds are dense so they are vectors
+  DenseIdMap<::Bvariable *> compiled_var_decls;
+  hash_table<compiled_type_hasher> compiled_type_map;
+  DenseIdMap<tree> compiled_fn_map;
+  DenseIdMap<tree> compiled_consts;
+  std::map<std::pair<HirId, std::string>, tree> const_values;
+  std::map<std::pair<HirId, std::string>, tree> vtables;
+  std::unordered_map<hashval_t, std::vector<tree>> string_literals;
+  std::map<std::string, std::pair<tree, bool>> compiled_adts;
+  DenseIdMap<tree> compiled_labels;
   std::vector<::std::vector<tree>> statements;
   std::vector<tree> scope_stack;
   std::vector<::Bvariable *> loop_value_stack;
   std::vector<tree> loop_begin_labels;
   std::map<DefId, std::vector<std::pair<const TyTy::BaseType *, tree>>>
     mono_fns;
-  std::map<HirId, tree> implicit_pattern_bindings;
-  std::map<hashval_t, tree> main_variants;
+  // the same instances bucketed by the string form of their type and indexed
+  // by assembler name, so finding an instance does not compare against every
+  // other instance of the function
+  std::map<DefId,
+	   std::unordered_map<
+	     std::string, std::vector<std::pair<const TyTy::BaseType *, tree>>>>
+    mono_fn_types;
+  std::unordered_map<std::string, std::pair<DefId, tree>> mono_fn_asm_names;
+  std::map<DefId, std::vector<bool>> type_param_usage;
+  std::vector<std::string> shared_instances;
+  DenseIdMap<tree> implicit_pattern_bindings;
+  hash_table<compiled_type_hasher> main_variants;
+  std::deque<compiled_type_entry> type_cache_entries;
+  size_t type_cache_hits = 0;
+  size_t type_cache_misses = 0;
 
   // To GCC middle-end
   std::vector<tree> type_decls;
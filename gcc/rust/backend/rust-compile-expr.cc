@@ -24,6 +24,7 @@
 #include "rust-compile-pattern.h"
 #include "rust-compile-resolve-path.h"
 #include "rust-compile-block.h"
+#include "rust-compile-var-decl.h"
 #include "rust-compile-implitem.h"
 #include "rust-constexpr.h"
 #include "rust-gcc.h"
@@ -129,9 +130,28 @@ CompileExpr::visit (HIR::ReturnExpr &expr)
 
 void
 CompileExpr::visit (HIR::ArithmeticOrLogicalExpr &expr)
+{
+  // Operator chains nest to the left: compile the leftmost operand, then each
+  // operator around the previous one
+  std::vector<HIR::ArithmeticOrLogicalExpr *> chain = {&expr};
+  HIR::Expr *operand = expr.get_lhs ();
+  while (operand->get_expression_type ()
+	 == HIR::Expr::ExprType::ArithmeticOrLogical)
+    {
+      chain.push_back (static_cast<HIR::ArithmeticOrLogicalExpr *> (operand));
+      operand = chain.back ()->get_lhs ();
+    }
+
+  translated = CompileExpr::Compile (operand, ctx);
+  for (auto it = chain.rbegin (); it != chain.rend (); it++)
+    translated = compile_arithmetic_or_logical (**it, translated);
+}
+
+tree
+CompileExpr::compile_arithmetic_or_logical (HIR::ArithmeticOrLogicalExpr &expr,
+					    tree lhs)
 {
   auto op = expr.get_expr_type ();
-  auto lhs = CompileExpr::Compile (expr.get_lhs (), ctx);
   auto rhs = CompileExpr::Compile (expr.get_rhs (), ctx);
 
   // this might be an operator overload situation lets check
@@ -142,12 +162,11 @@ CompileExpr::visit (HIR::ArithmeticOrLogicalExpr &expr)
     {
       auto lang_item_type
 	= Analysis::RustLangItem::OperatorToLangItem (expr.get_expr_type ());
-      translated = resolve_operator_overload (lang_item_type, expr, lhs, rhs,
-					      expr.get_lhs (), expr.get_rhs ());
-      return;
+      return resolve_operator_overload (lang_item_type, expr, lhs, rhs,
+					expr.get_lhs (), expr.get_rhs ());
     }
 
-  if (ctx->in_fn () && !ctx->const_context_p ())
+  if (ctx->overflow_checks_p () && !ctx->const_context_p ())
     {
       auto receiver_tmp = NULL_TREE;
       auto receiver
@@ -160,13 +179,11 @@ CompileExpr::visit (HIR::ArithmeticOrLogicalExpr &expr)
 	  op, lhs, rhs, expr.get_locus (), receiver);
 
       ctx->add_statement (check);
-      translated = receiver->get_tree (expr.get_locus ());
-    }
-  else
-    {
-      translated = ctx->get_backend ()->arithmetic_or_logical_expression (
-	op, lhs, rhs, expr.get_locus ());
+      return receiver->get_tree (expr.get_locus ());
     }
+
+  return ctx->get_backend ()->arithmetic_or_logical_expression (
+    op, lhs, rhs, expr.get_locus ());
 }
 
 void
@@ -194,7 +211,7 @@ CompileExpr::visit (HIR::CompoundAssignmentExpr &expr)
       return;
     }
 
-  if (ctx->in_fn () && !ctx->const_context_p ())
+  if (ctx->overflow_checks_p () && !ctx->const_context_p ())
     {
       auto tmp = NULL_TREE;
       auto receiver
@@ -212,8 +229,11 @@ CompileExpr::visit (HIR::CompoundAssignmentExpr &expr)
     }
   else
     {
-      translated = ctx->get_backend ()->arithmetic_or_logical_expression (
+      tree result = ctx->get_backend ()->arithmetic_or_logical_expression (
 	op, lhs, rhs, expr.get_locus ());
+      translated
+	= ctx->get_backend ()->assignment_statement (lhs, result,
+						     expr.get_locus ());
     }
 }
 
@@ -548,22 +568,15 @@ CompileExpr::visit (HIR::StructExprStructFields &struct_expr)
 
   // the constructor depends on whether this is actually an enum or not if
   // its an enum we need to setup the discriminator
-  std::vector<tree> ctor_arguments;
   if (adt->is_enum ())
-    {
-      HIR::Expr *discrim_expr = variant->get_discriminant ();
-      tree discrim_expr_node = CompileExpr::Compile (discrim_expr, ctx);
-      tree folded_discrim_expr = fold_expr (discrim_expr_node);
-      tree qualifier = folded_discrim_expr;
-
-      ctor_arguments.push_back (qualifier);
-    }
-  for (auto &arg : arguments)
-    ctor_arguments.push_back (arg);
-
-  translated = ctx->get_backend ()->constructor_expression (
-    compiled_adt_type, adt->is_enum (), ctor_arguments, union_disriminator,
-    struct_expr.get_locus ());
+    translated
+      = enum_variant_constructor (adt, compiled_adt_type, variant,
+				  union_disriminator, arguments,
+				  struct_expr.get_locus ());
+  else
+    translated = ctx->get_backend ()->constructor_expression (
+      compiled_adt_type, false, arguments, union_disriminator,
+      struct_expr.get_locus ());
 }
 
 void
@@ -747,6 +760,166 @@ CompileExpr::visit (HIR::WhileLoopExpr &expr)
   ctx->add_statement (loop_expr);
 }
 
+// Is TY the RangeInclusive lang item; the type checker only lets a for loop
+// iterate over it or over Range.
+static bool
+range_inclusive_p (Context *ctx, TyTy::BaseType *ty)
+{
+  DefId lang_item_id = UNKNOWN_DEFID;
+  if (!ctx->get_mappings ()->lookup_lang_item (
+	Analysis::RustLangItem::ItemType::RANGE_INCLUSIVE, &lang_item_id))
+    return false;
+
+  HIR::Item *item = ctx->get_mappings ()->lookup_defid (lang_item_id);
+  TyTy::BaseType *item_type = nullptr;
+  return item != nullptr
+	 && ctx->get_tyctx ()->lookup_type (item->get_mappings ().get_hirid (),
+					    &item_type)
+	 && item_type->get_ty_ref () == ty->get_ty_ref ();
+}
+
+void
+CompileExpr::visit (HIR::ForLoopExpr &expr)
+{
+  // for PAT in START..END { BODY } is compiled as a counted loop over a
+  // hidden induction variable:
+  //
+  //   index = START; end = END;
+  //   loop { if index >= end break; PAT = index; index += 1; BODY }
+  //
+  // and START..=END as:
+  //
+  //   index = START; end = END; done = START > END;
+  //   loop { if done break; PAT = index; done = index == end;
+  //          if !done index += 1; BODY }
+  //
+  // The increment comes before the body so continue, which jumps back to the
+  // exit test, still steps the loop, and it never goes past END so it cannot
+  // overflow.
+  fncontext fnctx = ctx->peek_fn ();
+  if (expr.has_loop_label ())
+    {
+      HIR::LoopLabel &loop_label = expr.get_loop_label ();
+      tree label
+	= ctx->get_backend ()->label (fnctx.fndecl,
+				      loop_label.get_lifetime ().get_name (),
+				      loop_label.get_locus ());
+      tree label_decl = ctx->get_backend ()->label_definition_statement (label);
+      ctx->add_statement (label_decl);
+      ctx->insert_label_decl (
+	loop_label.get_lifetime ().get_mappings ().get_hirid (), label);
+    }
+
+  TyTy::BaseType *range_tyty = nullptr;
+  bool ok = ctx->get_tyctx ()->lookup_type (
+    expr.get_iterator_expr ()->get_mappings ().get_hirid (), &range_tyty);
+  rust_assert (ok);
+  bool inclusive = range_inclusive_p (ctx, range_tyty);
+
+  tree range = CompileExpr::Compile (expr.get_iterator_expr ().get (), ctx);
+  if (range == error_mark_node)
+    return;
+
+  Location locus = expr.get_locus ();
+  tree enclosing_scope = ctx->peek_enclosing_scope ();
+  tree stmt = NULL_TREE;
+  Bvariable *range_tmp
+    = ctx->get_backend ()->temporary_variable (fnctx.fndecl, enclosing_scope,
+					       TREE_TYPE (range), range, false,
+					       locus, &stmt);
+  ctx->add_statement (stmt);
+  tree range_ref = ctx->get_backend ()->var_expression (range_tmp, locus);
+
+  tree start
+    = ctx->get_backend ()->struct_field_expression (range_ref, 0, locus);
+  tree element_type = TREE_TYPE (start);
+  Bvariable *index_tmp
+    = ctx->get_backend ()->temporary_variable (fnctx.fndecl, enclosing_scope,
+					       element_type, start, false,
+					       locus, &stmt);
+  ctx->add_statement (stmt);
+  tree index = ctx->get_backend ()->var_expression (index_tmp, locus);
+
+  tree end
+    = ctx->get_backend ()->struct_field_expression (range_ref, 1, locus);
+  Bvariable *end_tmp
+    = ctx->get_backend ()->temporary_variable (fnctx.fndecl, enclosing_scope,
+					       element_type, end, false, locus,
+					       &stmt);
+  ctx->add_statement (stmt);
+  end = ctx->get_backend ()->var_expression (end_tmp, locus);
+
+  tree done = NULL_TREE;
+  if (inclusive)
+    {
+      tree empty = ctx->get_backend ()->comparison_expression (
+	ComparisonOperator::GREATER_THAN, index, end, locus);
+      Bvariable *done_tmp
+	= ctx->get_backend ()->temporary_variable (fnctx.fndecl,
+						   enclosing_scope,
+						   boolean_type_node, empty,
+						   false, locus, &stmt);
+      ctx->add_statement (stmt);
+      done = ctx->get_backend ()->var_expression (done_tmp, locus);
+    }
+
+  // the loop variable itself is a fresh copy of the index on every iteration
+  // so the body cannot change the number of iterations
+  Bvariable *binding
+    = CompileVarDecl::compile (fnctx.fndecl, element_type,
+			       expr.get_pattern ().get (), ctx);
+  std::vector<Bvariable *> locals = {binding};
+  Location start_location = expr.get_loop_block ()->get_locus ();
+  Location end_location = expr.get_loop_block ()->get_end_locus ();
+  tree loop_block
+    = ctx->get_backend ()->block (fnctx.fndecl, enclosing_scope, locals,
+				  start_location, end_location);
+  ctx->push_block (loop_block);
+
+  tree loop_begin_label = ctx->get_backend ()->label (fnctx.fndecl, "", locus);
+  tree loop_begin_label_decl
+    = ctx->get_backend ()->label_definition_statement (loop_begin_label);
+  ctx->add_statement (loop_begin_label_decl);
+  ctx->push_loop_begin_label (loop_begin_label);
+
+  tree exit_condition
+    = inclusive ? done
+		: ctx->get_backend ()->comparison_expression (
+		  ComparisonOperator::GREATER_OR_EQUAL, index, end, locus);
+  ctx->add_statement (
+    ctx->get_backend ()->exit_expression (exit_condition, locus));
+
+  ctx->add_statement (
+    ctx->get_backend ()->init_statement (fnctx.fndecl, binding, index));
+
+  tree next = ctx->get_backend ()->arithmetic_or_logical_expression (
+    ArithmeticOrLogicalOperator::ADD, index,
+    build_int_cst (element_type, 1), locus);
+  if (inclusive)
+    {
+      tree last
+	= ctx->get_backend ()->comparison_expression (ComparisonOperator::EQUAL,
+						      index, end, locus);
+      ctx->add_statement (
+	ctx->get_backend ()->assignment_statement (done, last, locus));
+      next = fold_build3_loc (locus.gcc_location (), COND_EXPR, element_type,
+			      done, index, next);
+    }
+  ctx->add_statement (
+    ctx->get_backend ()->assignment_statement (index, next, locus));
+
+  tree code_block_stmt
+    = CompileBlock::compile (expr.get_loop_block ().get (), ctx, nullptr);
+  rust_assert (TREE_CODE (code_block_stmt) == BIND_EXPR);
+  ctx->add_statement (code_block_stmt);
+
+  ctx->pop_loop_begin_label ();
+  ctx->pop_block ();
+
+  tree loop_expr = ctx->get_backend ()->loop_expression (loop_block, locus);
+  ctx->add_statement (loop_expr);
+}
+
 void
 CompileExpr::visit (HIR::BreakExpr &expr)
 {
@@ -903,6 +1076,8 @@ CompileExpr::visit (HIR::DereferenceExpr &expr)
 void
 CompileExpr::visit (HIR::LiteralExpr &expr)
 {
+  mark_retained_uses (expr.get_mappings ().get_hirid ());
+
   TyTy::BaseType *tyty = nullptr;
   if (!ctx->get_tyctx ()->lookup_type (expr.get_mappings ().get_hirid (),
 				       &tyty))
@@ -1286,6 +1461,20 @@ simplify_tuple_match (HIR::MatchExpr &expr)
   return outer_match;
 }
 
+// The enum type matched on by EXPR, once check_match_scrutinee has seen it is
+// an ADT.
+static TyTy::ADTType *
+match_scrutinee_adt (HIR::MatchExpr &expr, Context *ctx)
+{
+  TyTy::BaseType *scrutinee_expr_tyty = nullptr;
+  bool ok = ctx->get_tyctx ()->lookup_type (
+    expr.get_scrutinee_expr ()->get_mappings ().get_hirid (),
+    &scrutinee_expr_tyty);
+  rust_assert (ok && scrutinee_expr_tyty->get_kind () == TyTy::TypeKind::ADT);
+
+  return static_cast<TyTy::ADTType *> (scrutinee_expr_tyty);
+}
+
 // Helper for CompileExpr::visit (HIR::MatchExpr).
 // Check that the scrutinee of EXPR is a valid kind of expression to match on.
 // Return the TypeKind of the scrutinee if it is valid, or TyTy::TypeKind::ERROR
@@ -1407,17 +1596,10 @@ CompileExpr::visit (HIR::MatchExpr &expr)
     }
   else if (scrutinee_kind == TyTy::TypeKind::ADT)
     {
-      // need to access qualifier the field, if we use QUAL_UNION_TYPE this
-      // would be DECL_QUALIFIER i think. For now this will just access the
-      // first record field and its respective qualifier because it will always
-      // be set because this is all a big special union
-      tree scrutinee_first_record_expr
-	= ctx->get_backend ()->struct_field_expression (
-	  match_scrutinee_expr, 0, expr.get_scrutinee_expr ()->get_locus ());
       match_scrutinee_expr_qualifier_expr
-	= ctx->get_backend ()->struct_field_expression (
-	  scrutinee_first_record_expr, 0,
-	  expr.get_scrutinee_expr ()->get_locus ());
+	= enum_switch_expression (match_scrutinee_adt (expr, ctx),
+				  match_scrutinee_expr,
+				  expr.get_scrutinee_expr ()->get_locus ());
     }
   else if (scrutinee_kind == TyTy::TypeKind::TUPLE)
     {
@@ -1463,18 +1645,9 @@ CompileExpr::visit (HIR::MatchExpr &expr)
 	      }
 	    else if (scrutinee_kind == TyTy::TypeKind::ADT)
 	      {
-		// need to access qualifier the field, if we use QUAL_UNION_TYPE
-		// this would be DECL_QUALIFIER i think. For now this will just
-		// access the first record field and its respective qualifier
-		// because it will always be set because this is all a big
-		// special union
-		tree scrutinee_first_record_expr
-		  = ctx->get_backend ()->struct_field_expression (
-		    match_scrutinee_expr, 0,
-		    expr.get_scrutinee_expr ()->get_locus ());
 		match_scrutinee_expr_qualifier_expr
-		  = ctx->get_backend ()->struct_field_expression (
-		    scrutinee_first_record_expr, 0,
+		  = enum_switch_expression (
+		    match_scrutinee_adt (expr, ctx), match_scrutinee_expr,
 		    expr.get_scrutinee_expr ()->get_locus ());
 	      }
 	    else
@@ -1520,6 +1693,9 @@ CompileExpr::visit (HIR::MatchExpr &expr)
 				  end_location);
   ctx->push_block (switch_body_block);
 
+  // whether every arm has a case label, and whether one of them is a default
+  bool all_arms_labelled = true;
+  bool has_default_label = false;
   for (auto &kase : expr.get_match_cases ())
     {
       // for now lets just get single pattern's working
@@ -1538,6 +1714,10 @@ CompileExpr::visit (HIR::MatchExpr &expr)
 	    = CompilePatternCaseLabelExpr::Compile (kase_pattern.get (),
 						    case_label, ctx);
 	  ctx->add_statement (switch_kase_expr);
+	  if (TREE_CODE (switch_kase_expr) != CASE_LABEL_EXPR)
+	    all_arms_labelled = false;
+	  else if (CASE_LOW (switch_kase_expr) == NULL_TREE)
+	    has_default_label = true;
 
 	  CompilePatternBindings::Compile (kase_pattern.get (),
 					   match_scrutinee_expr, ctx);
@@ -1562,6 +1742,27 @@ CompileExpr::visit (HIR::MatchExpr &expr)
       ctx->add_statement (goto_end_label);
     }
 
+  // an enum only ever holds the discriminant of one of its variants, so when
+  // the match was proven exhaustive the values no arm handles are impossible;
+  // otherwise they trap rather than fall out of the switch
+  if (scrutinee_kind == TyTy::TypeKind::ADT && all_arms_labelled
+      && !has_default_label && match_scrutinee_adt (expr, ctx)->is_enum ())
+    {
+      Location match_locus = expr.get_locus ();
+      tree default_label = ctx->get_backend ()->label (
+	fndecl, "" /* empty creates an artificial label */, match_locus);
+      ctx->add_statement (
+	build_case_label (NULL_TREE, NULL_TREE, default_label));
+
+      bool exhaustive = ctx->get_tyctx ()->is_exhaustive_match (
+	expr.get_mappings ().get_hirid ());
+      tree fn = builtin_decl_explicit (exhaustive ? BUILT_IN_UNREACHABLE
+						  : BUILT_IN_TRAP);
+      rust_assert (fn != NULL_TREE);
+      ctx->add_statement (
+	build_call_expr_loc (match_locus.gcc_location (), fn, 0));
+    }
+
   // setup the switch expression
   tree match_body = ctx->pop_block ();
   tree match_expr_stmt
@@ -1650,22 +1851,15 @@ CompileExpr::visit (HIR::CallExpr &expr)
 
       // the constructor depends on whether this is actually an enum or not if
       // its an enum we need to setup the discriminator
-      std::vector<tree> ctor_arguments;
       if (adt->is_enum ())
-	{
-	  HIR::Expr *discrim_expr = variant->get_discriminant ();
-	  tree discrim_expr_node = CompileExpr::Compile (discrim_expr, ctx);
-	  tree folded_discrim_expr = fold_expr (discrim_expr_node);
-	  tree qualifier = folded_discrim_expr;
-
-	  ctor_arguments.push_back (qualifier);
-	}
-      for (auto &arg : arguments)
-	ctor_arguments.push_back (arg);
-
-      translated = ctx->get_backend ()->constructor_expression (
-	compiled_adt_type, adt->is_enum (), ctor_arguments, union_disriminator,
-	expr.get_locus ());
+	translated
+	  = enum_variant_constructor (adt, compiled_adt_type, variant,
+				      union_disriminator, arguments,
+				      expr.get_locus ());
+      else
+	translated = ctx->get_backend ()->constructor_expression (
+	  compiled_adt_type, false, arguments, union_disriminator,
+	  expr.get_locus ());
 
       return;
     }
@@ -1755,8 +1949,24 @@ CompileExpr::visit (HIR::CallExpr &expr)
 void
 CompileExpr::visit (HIR::MethodCallExpr &expr)
 {
-  // method receiver
-  tree self = CompileExpr::Compile (expr.get_receiver ().get (), ctx);
+  // Builder chains nest through their receivers: compile the innermost
+  // receiver, then each call around the previous one
+  std::vector<HIR::MethodCallExpr *> chain = {&expr};
+  HIR::Expr *receiver = expr.get_receiver ().get ();
+  while (receiver->get_expression_type () == HIR::Expr::ExprType::MethodCall)
+    {
+      chain.push_back (static_cast<HIR::MethodCallExpr *> (receiver));
+      receiver = chain.back ()->get_receiver ().get ();
+    }
+
+  translated = CompileExpr::Compile (receiver, ctx);
+  for (auto it = chain.rbegin (); it != chain.rend (); it++)
+    translated = compile_method_call (**it, translated);
+}
+
+tree
+CompileExpr::compile_method_call (HIR::MethodCallExpr &expr, tree self)
+{
 
   // lookup the resolved name
   NodeId resolved_node_id = UNKNOWN_NODEID;
@@ -1764,7 +1974,7 @@ CompileExpr::visit (HIR::MethodCallExpr &expr)
 	expr.get_mappings ().get_nodeid (), &resolved_node_id))
     {
       rust_error_at (expr.get_locus (), "failed to lookup resolved MethodCall");
-      return;
+      return error_mark_node;
     }
 
   // reverse lookup
@@ -1772,7 +1982,7 @@ CompileExpr::visit (HIR::MethodCallExpr &expr)
   if (!ctx->get_mappings ()->lookup_node_to_hir (resolved_node_id, &ref))
     {
       rust_fatal_error (expr.get_locus (), "reverse lookup failure");
-      return;
+      return error_mark_node;
     }
 
   // lookup the expected function type
@@ -1864,8 +2074,48 @@ CompileExpr::visit (HIR::MethodCallExpr &expr)
       args.push_back (rvalue);
     }
 
-  translated = ctx->get_backend ()->call_expression (fn_expr, args, nullptr,
-						     expr.get_locus ());
+  return ctx->get_backend ()->call_expression (fn_expr, args, nullptr,
+					       expr.get_locus ());
+}
+
+// Return the address of entry OFFS of the vtable of trait object OBJECT when
+// it is known at compile time: OBJECT is the coercion of a concrete type to a
+// trait object, or an immutable local initialized from one, possibly through
+// other such locals. Since every vtable is a constant global we can read the
+// entry from its initializer.
+static tree
+known_vtable_entry (tree object, size_t offs)
+{
+  while (VAR_P (object) && !TREE_STATIC (object)
+	 && TYPE_READONLY (TREE_TYPE (object))
+	 && DECL_INITIAL (object) != NULL_TREE)
+    object = DECL_INITIAL (object);
+
+  if (TREE_CODE (object) != CONSTRUCTOR || CONSTRUCTOR_NELTS (object) != 2)
+    return NULL_TREE;
+
+  tree vtable = CONSTRUCTOR_ELT (object, 1)->value;
+  STRIP_NOPS (vtable);
+  if (TREE_CODE (vtable) != ADDR_EXPR)
+    return NULL_TREE;
+
+  tree vtable_decl = TREE_OPERAND (vtable, 0);
+  if (!VAR_P (vtable_decl) || !TREE_READONLY (vtable_decl)
+      || DECL_INITIAL (vtable_decl) == NULL_TREE
+      || TREE_CODE (DECL_INITIAL (vtable_decl)) != CONSTRUCTOR)
+    return NULL_TREE;
+
+  tree entries = DECL_INITIAL (vtable_decl);
+  if (offs >= CONSTRUCTOR_NELTS (entries))
+    return NULL_TREE;
+
+  tree entry = CONSTRUCTOR_ELT (entries, offs)->value;
+  STRIP_NOPS (entry);
+  if (TREE_CODE (entry) != ADDR_EXPR
+      || TREE_CODE (TREE_OPERAND (entry, 0)) != FUNCTION_DECL)
+    return NULL_TREE;
+
+  return entry;
 }
 
 tree
@@ -1894,8 +2144,10 @@ CompileExpr::get_fn_addr_from_dyn (const TyTy::DynamicObjectType *dyn,
   if (ref == nullptr)
     return error_mark_node;
 
-  // get any indirection sorted out
-  if (receiver->get_kind () == TyTy::TypeKind::REF)
+  // get any indirection sorted out, a reference to the object is already the
+  // fat pointer
+  if (receiver->get_kind () == TyTy::TypeKind::REF
+      && !SLICE_TYPE_P (TREE_TYPE (receiver_ref)))
     {
       tree indirect = indirect_expression (receiver_ref, expr_locus);
       receiver_ref = indirect;
@@ -1903,14 +2155,23 @@ CompileExpr::get_fn_addr_from_dyn (const TyTy::DynamicObjectType *dyn,
 
   // cast it to the correct fntype
   tree expected_fntype = TyTyResolveCompile::compile (ctx, fntype, true);
+
+  // the object was made from a concrete type in this function, call its
+  // method directly so that it can be inlined
+  tree direct = known_vtable_entry (receiver_ref, offs);
+  if (direct != NULL_TREE)
+    return fold_convert_loc (expr_locus.gcc_location (), expected_fntype,
+			     direct);
+
   tree idx = build_int_cst (size_type_node, offs);
 
   tree vtable_ptr
     = ctx->get_backend ()->struct_field_expression (receiver_ref, 1,
 						    expr_locus);
+  tree vtable = indirect_expression (vtable_ptr, expr_locus);
   tree vtable_array_access = build4_loc (expr_locus.gcc_location (), ARRAY_REF,
-					 TREE_TYPE (TREE_TYPE (vtable_ptr)),
-					 vtable_ptr, idx, NULL_TREE, NULL_TREE);
+					 TREE_TYPE (TREE_TYPE (vtable)), vtable,
+					 idx, NULL_TREE, NULL_TREE);
 
   tree vcall
     = build3_loc (expr_locus.gcc_location (), OBJ_TYPE_REF, expected_fntype,
@@ -1926,13 +2187,14 @@ CompileExpr::get_receiver_from_dyn (const TyTy::DynamicObjectType *dyn,
 				    Location expr_locus)
 {
   // get any indirection sorted out
-  if (receiver->get_kind () == TyTy::TypeKind::REF)
+  if (receiver->get_kind () == TyTy::TypeKind::REF
+      && !SLICE_TYPE_P (TREE_TYPE (receiver_ref)))
     {
       tree indirect = indirect_expression (receiver_ref, expr_locus);
       receiver_ref = indirect;
     }
 
-  // access the offs + 1 for the fnptr and offs=0 for the reciever obj
+  // field 1 is the vtable pointer and field 0 the receiver obj
   return ctx->get_backend ()->struct_field_expression (receiver_ref, 0,
 						       expr_locus);
 }
@@ -2101,17 +2363,60 @@ CompileExpr::compile_bool_literal (const HIR::LiteralExpr &expr,
   return ctx->get_backend ()->boolean_constant_expression (bval);
 }
 
+// Parses the decimal digits of an integer literal, as left by the lexer,
+// into VALUE. Returns false if STR is not plain digits or does not fit in
+// 64 bits, which leaves the literal to the mpz path.
+static bool
+parse_small_integer_literal (const std::string &str, uint64_t &value)
+{
+  if (str.empty () || str.size () > 20)
+    return false;
+
+  uint64_t v = 0;
+  for (char c : str)
+    {
+      if (!ISDIGIT (c))
+	return false;
+
+      uint64_t digit = c - '0';
+      if (v > (UINT64_MAX - digit) / 10)
+	return false;
+      v = v * 10 + digit;
+    }
+
+  value = v;
+  return true;
+}
+
 tree
 CompileExpr::compile_integer_literal (const HIR::LiteralExpr &expr,
 				      const TyTy::BaseType *tyty)
 {
   rust_assert (expr.get_lit_type () == HIR::Literal::INT);
   const auto literal_value = expr.get_literal ();
+  const std::string &literal_str = literal_value.as_string ();
 
   tree type = TyTyResolveCompile::compile (ctx, tyty);
 
+  // nearly every literal fits in 64 bits, build those without going
+  // through gmp
+  uint64_t small_value;
+  if (parse_small_integer_literal (literal_str, small_value))
+    {
+      widest_int value = widest_int::from (wi::uhwi (small_value, 64),
+					   UNSIGNED);
+      if (!wi::fits_to_tree_p (value, type))
+	{
+	  rust_error_at (expr.get_locus (),
+			 "integer overflows the respective type %<%s%>",
+			 tyty->get_name ().c_str ());
+	  return error_mark_node;
+	}
+      return wide_int_to_tree (type, value);
+    }
+
   mpz_t ival;
-  if (mpz_init_set_str (ival, literal_value.as_string ().c_str (), 10) != 0)
+  if (mpz_init_set_str (ival, literal_str.c_str (), 10) != 0)
     {
       rust_error_at (expr.get_locus (), "bad number in literal");
       return error_mark_node;
@@ -2197,6 +2502,18 @@ CompileExpr::compile_byte_literal (const HIR::LiteralExpr &expr,
   return build_int_cst (type, c);
 }
 
+tree
+CompileExpr::compile_string_constant (const std::string &value)
+{
+  tree cst = NULL_TREE;
+  if (ctx->lookup_string_literal (value, &cst))
+    return cst;
+
+  cst = ctx->get_backend ()->string_constant_expression (value);
+  ctx->insert_string_literal (value, cst);
+  return cst;
+}
+
 tree
 CompileExpr::compile_string_literal (const HIR::LiteralExpr &expr,
 				     const TyTy::BaseType *tyty)
@@ -2206,8 +2523,7 @@ CompileExpr::compile_string_literal (const HIR::LiteralExpr &expr,
   rust_assert (expr.get_lit_type () == HIR::Literal::STRING);
   const auto literal_value = expr.get_literal ();
 
-  auto base = ctx->get_backend ()->string_constant_expression (
-    literal_value.as_string ());
+  tree base = compile_string_constant (literal_value.as_string ());
   tree data = address_expression (base, expr.get_locus ());
 
   TyTy::BaseType *usize = nullptr;
@@ -2235,26 +2551,14 @@ CompileExpr::compile_byte_string_literal (const HIR::LiteralExpr &expr,
   const auto ref_tyty = static_cast<const TyTy::ReferenceType *> (tyty);
   auto base_tyty = ref_tyty->get_base ();
   rust_assert (base_tyty->get_kind () == TyTy::TypeKind::ARRAY);
-  auto array_tyty = static_cast<TyTy::ArrayType *> (base_tyty);
 
-  std::string value_str = expr.get_literal ().as_string ();
-  std::vector<tree> vals;
-  std::vector<unsigned long> indexes;
-  for (size_t i = 0; i < value_str.size (); i++)
-    {
-      char b = value_str.at (i);
-      tree bb = ctx->get_backend ()->char_constant_expression (b);
-      vals.push_back (bb);
-      indexes.push_back (i);
-    }
-
-  tree array_type = TyTyResolveCompile::compile (ctx, array_tyty);
-  tree constructed
-    = ctx->get_backend ()->array_constructor_expression (array_type, indexes,
-							 vals,
-							 expr.get_locus ());
+  // point into the same read-only string constant a str literal uses rather
+  // than building the array on the stack at every use
+  tree type = TyTyResolveCompile::compile (ctx, tyty);
+  tree base = compile_string_constant (expr.get_literal ().as_string ());
+  tree data = address_expression (base, expr.get_locus ());
 
-  return address_expression (constructed, expr.get_locus ());
+  return fold_convert_loc (expr.get_locus ().gcc_location (), type, data);
 }
 
 tree
@@ -2436,24 +2740,22 @@ CompileExpr::array_copied_expr (Location expr_locus,
   unsigned HOST_WIDE_INT len
     = wi::ext (max - min + 1, precision, sign).to_uhwi ();
 
-  // In a const context we must initialize the entire array, which entails
-  // allocating for each element. If the user wants a huge array, we will OOM
-  // and die horribly.
+  // In a const context we must initialize the entire array. Rather than one
+  // element per copy, which for a huge array would OOM and die horribly, use
+  // a single RANGE_EXPR element covering all of them, or no element at all
+  // when they are zero.
   if (ctx->const_context_p ())
     {
-      size_t idx = 0;
-      std::vector<unsigned long> indexes;
-      std::vector<tree> constructor;
-      for (unsigned HOST_WIDE_INT i = 0; i < len; i++)
-	{
-	  constructor.push_back (translated_expr);
-	  indexes.push_back (idx++);
-	}
+      if (len == 0 || initializer_zerop (translated_expr))
+	return ctx->get_backend ()->array_constructor_expression (array_type,
+								  {}, {},
+								  expr_locus);
 
-      return ctx->get_backend ()->array_constructor_expression (array_type,
-								indexes,
-								constructor,
-								expr_locus);
+      tree range = build2 (RANGE_EXPR, TREE_TYPE (domain), min_domain,
+			   max_domain);
+      tree ctor = build_constructor_single (array_type, range, translated_expr);
+      TREE_CONSTANT (ctor) = TREE_CONSTANT (translated_expr);
+      return ctor;
     }
 
   else
@@ -2793,6 +3095,27 @@ CompileExpr::visit (HIR::ArrayIndexExpr &expr)
 	= indirect_expression (array_reference, expr.get_locus ());
     }
 
+  // a constant index into a fixed-size array is known to be in or out of
+  // bounds right now, as rustc does reject the ones which are out
+  tree array_type = TREE_TYPE (array_reference);
+  tree folded_index = fold_expr (index);
+  if (TREE_CODE (array_type) == ARRAY_TYPE && TYPE_DOMAIN (array_type)
+      && TREE_CODE (folded_index) == INTEGER_CST)
+    {
+      tree max = TYPE_MAX_VALUE (TYPE_DOMAIN (array_type));
+      if (max != NULL_TREE && TREE_CODE (max) == INTEGER_CST
+	  && tree_int_cst_lt (max, folded_index))
+	{
+	  rust_error_at (expr.get_locus (),
+			 "this operation will panic at runtime: index out of "
+			 "bounds: the length is %s but the index is %s",
+			 std::to_string (tree_to_shwi (max) + 1).c_str (),
+			 std::to_string (tree_to_uhwi (folded_index)).c_str ());
+	  translated = error_mark_node;
+	  return;
+	}
+    }
+
   translated
     = ctx->get_backend ()->array_index_expression (array_reference, index,
 						   expr.get_locus ());
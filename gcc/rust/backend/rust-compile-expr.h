@@ -57,6 +57,7 @@ public:
   void visit (HIR::PathInExpression &expr) override;
   void visit (HIR::LoopExpr &expr) override;
   void visit (HIR::WhileLoopExpr &expr) override;
+  void visit (HIR::ForLoopExpr &expr) override;
   void visit (HIR::BreakExpr &expr) override;
   void visit (HIR::ContinueExpr &expr) override;
   void visit (HIR::BorrowExpr &expr) override;
@@ -73,7 +74,6 @@ public:
   void visit (HIR::ClosureExprInnerTyped &) override {}
   void visit (HIR::ErrorPropagationExpr &) override {}
   void visit (HIR::RangeToInclExpr &) override {}
-  void visit (HIR::ForLoopExpr &) override {}
 
   // TODO
   // these need to be sugared in the HIR to if statements and a match
@@ -108,6 +108,12 @@ protected:
 			       Analysis::NodeMapping expr_mappings,
 			       Location expr_locus);
 
+  // The bodies of the visitors of chained operators and method calls, given
+  // the left operand or the receiver already compiled
+  tree compile_arithmetic_or_logical (HIR::ArithmeticOrLogicalExpr &expr,
+				      tree lhs);
+  tree compile_method_call (HIR::MethodCallExpr &expr, tree self);
+
   tree
   resolve_operator_overload (Analysis::RustLangItem::ItemType lang_item_type,
 			     HIR::OperatorExprMeta expr, tree lhs, tree rhs,
@@ -128,6 +134,8 @@ protected:
   tree compile_byte_literal (const HIR::LiteralExpr &expr,
 			     const TyTy::BaseType *tyty);
 
+  tree compile_string_constant (const std::string &value);
+
   tree compile_string_literal (const HIR::LiteralExpr &expr,
 			       const TyTy::BaseType *tyty);
 
@@ -21,6 +21,7 @@
 
 #include "rust-compile-base.h"
 #include "rust-compile-intrinsic.h"
+#include "rust-builtins.h"
 
 namespace Rust {
 namespace Compile {
@@ -72,6 +73,10 @@ public:
       = ctx->get_backend ()->global_variable (name, asm_name, type, is_external,
 					      is_hidden, in_unique_section,
 					      item.get_locus ());
+    if (has_thread_local_attribute (item.get_outer_attrs (),
+				    Analysis::BuiltinAttrSet (
+				      item.get_outer_attrs ())))
+      setup_thread_local_decl (static_global->get_decl ());
     ctx->insert_var_decl (item.get_mappings ().get_hirid (), static_global);
     ctx->push_var (static_global);
 
@@ -128,9 +133,29 @@ public:
 	return;
       }
 
+    // core::arch binds vendor intrinsics by naming them in #[link_name],
+    // those we have a target builtin for are compiled as calls to it
+    std::string link_name;
+    bool has_link_name
+      = lookup_link_name (function.get_outer_attrs (), &link_name);
+    tree builtin = NULL_TREE;
+    if (has_link_name
+	&& BuiltinsContext::get ().lookup_target_builtin (link_name, &builtin))
+      {
+	Intrinsics compile (ctx);
+	tree fndecl = compile.compile_target_builtin (fntype, builtin);
+	if (fndecl == error_mark_node)
+	  return;
+
+	ctx->insert_function_decl (fntype, fndecl);
+	reference = address_expression (fndecl, ref_locus);
+	return;
+      }
+
     tree compiled_fn_type = TyTyResolveCompile::compile (ctx, fntype);
     std::string ir_symbol_name = function.get_item_name ();
-    std::string asm_name = function.get_item_name ();
+    std::string asm_name
+      = has_link_name ? link_name : function.get_item_name ();
     if (fntype->get_abi () == ABI::RUST)
       {
 	// then we need to get the canonical path of it and mangle it
@@ -149,6 +174,8 @@ public:
 				       asm_name, flags, function.get_locus ());
     TREE_PUBLIC (fndecl) = 1;
     setup_abi_options (fndecl, fntype->get_abi ());
+    setup_allocator_fndecl (fndecl, Analysis::BuiltinAttrSet (
+				      function.get_outer_attrs ()));
 
     ctx->insert_function_decl (fntype, fndecl);
 
@@ -156,6 +183,30 @@ public:
   }
 
 private:
+  static bool lookup_link_name (AST::AttrVec &attrs, std::string *link_name)
+  {
+    for (auto &attr : attrs)
+      {
+	if (attr.get_path ().as_string ().compare ("link_name") != 0)
+	  continue;
+
+	if (!attr.has_attr_input ()
+	    || attr.get_attr_input ().get_attr_input_type ()
+		 != AST::AttrInput::AttrInputType::LITERAL)
+	  {
+	    rust_error_at (attr.get_locus (),
+			   "%<link_name%> expects exactly one argument");
+	    return false;
+	  }
+
+	auto &literal
+	  = static_cast<AST::AttrInputLiteral &> (attr.get_attr_input ());
+	*link_name = literal.get_literal ().as_string ();
+	return true;
+      }
+    return false;
+  }
+
   CompileExternItem (Context *ctx, TyTy::BaseType *concrete, Location ref_locus)
     : HIRCompileBase (ctx), concrete (concrete), reference (error_mark_node),
       ref_locus (ref_locus)
@@ -0,0 +1,493 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-compile-fn-merge.h"
+#include "tree-iterator.h"
+#include "fold-const.h"
+#include "attribs.h"
+#include "cgraph.h"
+
+namespace Rust {
+namespace Compile {
+
+std::vector<tree>
+FunctionMerger::merge (const std::vector<tree> &fns)
+{
+  FunctionMerger merger;
+  std::unordered_map<hashval_t, std::vector<tree>> buckets;
+  std::vector<tree> defined;
+
+  for (tree fn : fns)
+    {
+      if (fn == error_mark_node || !merger.mergeable (fn))
+	{
+	  defined.push_back (fn);
+	  continue;
+	}
+
+      // callees are usually pushed before their callers, so a caller of a
+      // duplicate already sees the function it was merged with
+      std::vector<tree> &bucket = buckets[merger.fingerprint (fn)];
+      tree target = NULL_TREE;
+      for (tree candidate : bucket)
+	{
+	  if (merger.same_function (candidate, fn))
+	    {
+	      target = candidate;
+	      break;
+	    }
+	}
+
+      if (target == NULL_TREE
+	  || cgraph_node::create_same_body_alias (fn, target) == nullptr)
+	{
+	  bucket.push_back (fn);
+	  defined.push_back (fn);
+	  continue;
+	}
+
+      DECL_SAVED_TREE (fn) = NULL_TREE;
+      merger.aliases[fn] = target;
+    }
+
+  if (!merger.aliases.empty ())
+    symtab->process_same_body_aliases ();
+
+  return defined;
+}
+
+bool
+FunctionMerger::mergeable (tree fndecl) const
+{
+  if (DECL_SAVED_TREE (fndecl) == NULL_TREE)
+    return false;
+
+  // aliases of these would change what the linker or the program sees
+  if (DECL_WEAK (fndecl) || DECL_COMDAT (fndecl) || DECL_STATIC_CHAIN (fndecl)
+      || MAIN_NAME_P (DECL_NAME (fndecl))
+      || lookup_attribute ("target_clones", DECL_ATTRIBUTES (fndecl)))
+    return false;
+
+  // already given to the middle-end
+  cgraph_node *node = cgraph_node::get (fndecl);
+  return node == nullptr || !node->definition;
+}
+
+tree
+FunctionMerger::canonical (tree fndecl) const
+{
+  auto it = aliases.find (fndecl);
+  return it == aliases.end () ? fndecl : it->second;
+}
+
+hashval_t
+FunctionMerger::fingerprint (tree fndecl) const
+{
+  inchash::hash hstate;
+
+  for (tree parm = DECL_ARGUMENTS (fndecl); parm; parm = DECL_CHAIN (parm))
+    hstate.add_int (TYPE_MODE (TREE_TYPE (parm)));
+  hstate.add_int (TYPE_MODE (TREE_TYPE (TREE_TYPE (fndecl))));
+  hash_tree (DECL_SAVED_TREE (fndecl), hstate);
+
+  return hstate.end ();
+}
+
+/* Only what is equal between functions same_function accepts goes into the
+ * hash: the shape of the trees, their constants and the machine modes of
+ * their types. */
+void
+FunctionMerger::hash_tree (tree t, inchash::hash &hstate) const
+{
+  if (t == NULL_TREE)
+    {
+      hstate.add_int (0);
+      return;
+    }
+
+  enum tree_code code = TREE_CODE (t);
+  hstate.add_int (code);
+
+  switch (code)
+    {
+    case INTEGER_CST:
+      hstate.add_wide_int (wi::to_widest (t));
+      return;
+
+      case STATEMENT_LIST: {
+	tree_stmt_iterator it = tsi_start (t);
+	for (; !tsi_end_p (it); tsi_next (&it))
+	  hash_tree (tsi_stmt (it), hstate);
+	return;
+      }
+
+    case BIND_EXPR:
+      hash_tree (BIND_EXPR_BODY (t), hstate);
+      return;
+
+      case CONSTRUCTOR: {
+	unsigned HOST_WIDE_INT i;
+	tree value;
+	hstate.add_int (CONSTRUCTOR_NELTS (t));
+	FOR_EACH_CONSTRUCTOR_VALUE (CONSTRUCTOR_ELTS (t), i, value)
+	  hash_tree (value, hstate);
+	return;
+      }
+
+    case TREE_LIST:
+      hash_tree (TREE_VALUE (t), hstate);
+      hash_tree (TREE_CHAIN (t), hstate);
+      return;
+
+    case FUNCTION_DECL:
+      hstate.add_ptr (canonical (t));
+      return;
+
+    default:
+      break;
+    }
+
+  if (!EXPR_P (t))
+    return;
+
+  if (TREE_TYPE (t) != NULL_TREE)
+    hstate.add_int (TYPE_MODE (TREE_TYPE (t)));
+
+  int length = TREE_OPERAND_LENGTH (t);
+  hstate.add_int (length);
+  for (int i = 0; i < length; i++)
+    hash_tree (TREE_OPERAND (t, i), hstate);
+}
+
+bool
+FunctionMerger::same_function (tree a, tree b)
+{
+  locals.clear ();
+  matched.clear ();
+
+  if (!same_type (TREE_TYPE (a), TREE_TYPE (b))
+      || !attribute_list_equal (DECL_ATTRIBUTES (a), DECL_ATTRIBUTES (b)))
+    return false;
+
+  if (DECL_DECLARED_INLINE_P (a) != DECL_DECLARED_INLINE_P (b)
+      || DECL_UNINLINABLE (a) != DECL_UNINLINABLE (b)
+      || DECL_DISREGARD_INLINE_LIMITS (a) != DECL_DISREGARD_INLINE_LIMITS (b)
+      || TREE_READONLY (a) != TREE_READONLY (b)
+      || DECL_PURE_P (a) != DECL_PURE_P (b)
+      || TREE_THIS_VOLATILE (a) != TREE_THIS_VOLATILE (b)
+      || TREE_NOTHROW (a) != TREE_NOTHROW (b)
+      || DECL_FUNCTION_SPECIFIC_TARGET (a) != DECL_FUNCTION_SPECIFIC_TARGET (b)
+      || DECL_FUNCTION_SPECIFIC_OPTIMIZATION (a)
+	   != DECL_FUNCTION_SPECIFIC_OPTIMIZATION (b))
+    return false;
+
+  // the alias is emitted in the section of the function it names
+  const char *section_a = DECL_SECTION_NAME (a);
+  const char *section_b = DECL_SECTION_NAME (b);
+  if ((section_a == nullptr) != (section_b == nullptr)
+      || (section_a != nullptr && strcmp (section_a, section_b) != 0))
+    return false;
+
+  if (!same_decl (DECL_RESULT (a), DECL_RESULT (b)))
+    return false;
+
+  tree parm_a = DECL_ARGUMENTS (a);
+  tree parm_b = DECL_ARGUMENTS (b);
+  for (; parm_a && parm_b;
+       parm_a = DECL_CHAIN (parm_a), parm_b = DECL_CHAIN (parm_b))
+    {
+      if (!same_decl (parm_a, parm_b))
+	return false;
+    }
+  if (parm_a || parm_b)
+    return false;
+
+  return same_tree (DECL_SAVED_TREE (a), DECL_SAVED_TREE (b));
+}
+
+bool
+FunctionMerger::same_tree (tree a, tree b)
+{
+  if (a == b)
+    return true;
+  if (a == NULL_TREE || b == NULL_TREE || TREE_CODE (a) != TREE_CODE (b))
+    return false;
+
+  if (DECL_P (a))
+    return same_decl (a, b);
+  if (TYPE_P (a))
+    return same_type (a, b);
+
+  switch (TREE_CODE (a))
+    {
+    case INTEGER_CST:
+      return same_type (TREE_TYPE (a), TREE_TYPE (b))
+	     && wi::eq_p (wi::to_widest (a), wi::to_widest (b));
+
+    case REAL_CST:
+      return same_type (TREE_TYPE (a), TREE_TYPE (b))
+	     && real_identical (TREE_REAL_CST_PTR (a), TREE_REAL_CST_PTR (b));
+
+    case STRING_CST:
+      return same_type (TREE_TYPE (a), TREE_TYPE (b))
+	     && TREE_STRING_LENGTH (a) == TREE_STRING_LENGTH (b)
+	     && memcmp (TREE_STRING_POINTER (a), TREE_STRING_POINTER (b),
+			TREE_STRING_LENGTH (a))
+		  == 0;
+
+    case COMPLEX_CST:
+    case VECTOR_CST:
+      return same_type (TREE_TYPE (a), TREE_TYPE (b))
+	     && operand_equal_p (a, b, 0);
+
+      case STATEMENT_LIST: {
+	tree_stmt_iterator it_a = tsi_start (a);
+	tree_stmt_iterator it_b = tsi_start (b);
+	for (; !tsi_end_p (it_a) && !tsi_end_p (it_b);
+	     tsi_next (&it_a), tsi_next (&it_b))
+	  {
+	    if (!same_tree (tsi_stmt (it_a), tsi_stmt (it_b)))
+	      return false;
+	  }
+	return tsi_end_p (it_a) && tsi_end_p (it_b);
+      }
+
+      case BIND_EXPR: {
+	tree var_a = BIND_EXPR_VARS (a);
+	tree var_b = BIND_EXPR_VARS (b);
+	for (; var_a && var_b;
+	     var_a = DECL_CHAIN (var_a), var_b = DECL_CHAIN (var_b))
+	  {
+	    if (!same_decl (var_a, var_b))
+	      return false;
+	  }
+	return var_a == var_b
+	       && same_tree (BIND_EXPR_BODY (a), BIND_EXPR_BODY (b));
+      }
+
+      case CONSTRUCTOR: {
+	if (!same_type (TREE_TYPE (a), TREE_TYPE (b))
+	    || CONSTRUCTOR_NELTS (a) != CONSTRUCTOR_NELTS (b))
+	  return false;
+
+	for (unsigned i = 0; i < CONSTRUCTOR_NELTS (a); i++)
+	  {
+	    constructor_elt *elt_a = CONSTRUCTOR_ELT (a, i);
+	    constructor_elt *elt_b = CONSTRUCTOR_ELT (b, i);
+	    if (!same_tree (elt_a->index, elt_b->index)
+		|| !same_tree (elt_a->value, elt_b->value))
+	      return false;
+	  }
+	return true;
+      }
+
+    case TREE_LIST:
+      return same_tree (TREE_PURPOSE (a), TREE_PURPOSE (b))
+	     && same_tree (TREE_VALUE (a), TREE_VALUE (b))
+	     && same_tree (TREE_CHAIN (a), TREE_CHAIN (b));
+
+    default:
+      break;
+    }
+
+  if (!EXPR_P (a))
+    return false;
+
+  if (!same_type (TREE_TYPE (a), TREE_TYPE (b))
+      || TREE_SIDE_EFFECTS (a) != TREE_SIDE_EFFECTS (b)
+      || TREE_THIS_VOLATILE (a) != TREE_THIS_VOLATILE (b))
+    return false;
+
+  if (TREE_CODE (a) == CALL_EXPR && CALL_EXPR_IFN (a) != CALL_EXPR_IFN (b))
+    return false;
+
+  int length = TREE_OPERAND_LENGTH (a);
+  if (length != TREE_OPERAND_LENGTH (b))
+    return false;
+
+  for (int i = 0; i < length; i++)
+    if (!same_tree (TREE_OPERAND (a, i), TREE_OPERAND (b, i)))
+      return false;
+
+  return true;
+}
+
+bool
+FunctionMerger::same_decl (tree a, tree b)
+{
+  if (TREE_CODE (a) != TREE_CODE (b))
+    return false;
+
+  switch (TREE_CODE (a))
+    {
+    case FUNCTION_DECL:
+      return canonical (a) == canonical (b);
+
+    case FIELD_DECL:
+      return same_field (a, b);
+
+    case VAR_DECL:
+      if (TREE_STATIC (a) || DECL_EXTERNAL (a) || TREE_STATIC (b)
+	  || DECL_EXTERNAL (b))
+	return a == b;
+      /* FALLTHROUGH. */
+    case PARM_DECL:
+    case RESULT_DECL:
+      case LABEL_DECL: {
+	auto it = locals.find (a);
+	if (it != locals.end ())
+	  return it->second == b;
+	if (matched.find (b) != matched.end ())
+	  return false;
+
+	if (!same_type (TREE_TYPE (a), TREE_TYPE (b))
+	    || TREE_ADDRESSABLE (a) != TREE_ADDRESSABLE (b)
+	    || TREE_THIS_VOLATILE (a) != TREE_THIS_VOLATILE (b)
+	    || DECL_ALIGN (a) != DECL_ALIGN (b))
+	  return false;
+	if (TREE_CODE (a) != LABEL_DECL
+	    && DECL_BY_REFERENCE (a) != DECL_BY_REFERENCE (b))
+	  return false;
+
+	locals[a] = b;
+	matched.insert (b);
+
+	// the named return value optimization and the ABI lowering make a
+	// decl stand for another tree, which the body does not show
+	if (TREE_CODE (a) != LABEL_DECL)
+	  {
+	    if (DECL_HAS_VALUE_EXPR_P (a) != DECL_HAS_VALUE_EXPR_P (b))
+	      return false;
+	    if (DECL_HAS_VALUE_EXPR_P (a)
+		&& !same_tree (DECL_VALUE_EXPR (a), DECL_VALUE_EXPR (b)))
+	      return false;
+	  }
+
+	return TREE_CODE (a) != VAR_DECL
+	       || same_tree (DECL_INITIAL (a), DECL_INITIAL (b));
+      }
+
+    default:
+      return a == b;
+    }
+}
+
+bool
+FunctionMerger::same_field (tree a, tree b) const
+{
+  if (a == b)
+    return true;
+  if (flag_strict_aliasing || TREE_CODE (b) != FIELD_DECL)
+    return false;
+
+  return operand_equal_p (DECL_FIELD_OFFSET (a), DECL_FIELD_OFFSET (b), 0)
+	 && tree_int_cst_equal (DECL_FIELD_BIT_OFFSET (a),
+				DECL_FIELD_BIT_OFFSET (b))
+	 && DECL_BIT_FIELD (a) == DECL_BIT_FIELD (b)
+	 && operand_equal_p (DECL_SIZE (a), DECL_SIZE (b), 0)
+	 && same_type (TREE_TYPE (a), TREE_TYPE (b));
+}
+
+bool
+FunctionMerger::same_type (tree a, tree b) const
+{
+  if (a == b)
+    return true;
+  if (a == NULL_TREE || b == NULL_TREE || TREE_CODE (a) != TREE_CODE (b)
+      || TYPE_QUALS (a) != TYPE_QUALS (b))
+    return false;
+  if (TYPE_MAIN_VARIANT (a) == TYPE_MAIN_VARIANT (b))
+    return true;
+
+  // accesses through types the alias oracle tells apart must stay apart
+  if (flag_strict_aliasing)
+    return false;
+
+  if (TYPE_MODE (a) != TYPE_MODE (b))
+    return false;
+
+  switch (TREE_CODE (a))
+    {
+    case INTEGER_TYPE:
+    case BOOLEAN_TYPE:
+    case ENUMERAL_TYPE:
+    case REAL_TYPE:
+      return TYPE_PRECISION (a) == TYPE_PRECISION (b)
+	     && TYPE_UNSIGNED (a) == TYPE_UNSIGNED (b);
+
+    // what a pointer points to is only seen through the type of a
+    // dereference, which is compared with the expression
+    case POINTER_TYPE:
+    case REFERENCE_TYPE:
+      return TYPE_REF_CAN_ALIAS_ALL (a) == TYPE_REF_CAN_ALIAS_ALL (b);
+
+      case ARRAY_TYPE: {
+	tree domain_a = TYPE_DOMAIN (a);
+	tree domain_b = TYPE_DOMAIN (b);
+	if ((domain_a == NULL_TREE) != (domain_b == NULL_TREE))
+	  return false;
+	if (domain_a != NULL_TREE
+	    && (!operand_equal_p (TYPE_MIN_VALUE (domain_a),
+				  TYPE_MIN_VALUE (domain_b), 0)
+		|| !operand_equal_p (TYPE_MAX_VALUE (domain_a),
+				     TYPE_MAX_VALUE (domain_b), 0)))
+	  return false;
+	return same_type (TREE_TYPE (a), TREE_TYPE (b));
+      }
+
+    case RECORD_TYPE:
+    case UNION_TYPE:
+      case QUAL_UNION_TYPE: {
+	if (TYPE_ALIGN (a) != TYPE_ALIGN (b)
+	    || !operand_equal_p (TYPE_SIZE (a), TYPE_SIZE (b), 0))
+	  return false;
+
+	tree field_a = TYPE_FIELDS (a);
+	tree field_b = TYPE_FIELDS (b);
+	for (; field_a && field_b;
+	     field_a = DECL_CHAIN (field_a), field_b = DECL_CHAIN (field_b))
+	  {
+	    if (!same_field (field_a, field_b))
+	      return false;
+	  }
+	return field_a == field_b;
+      }
+
+    case FUNCTION_TYPE:
+      case METHOD_TYPE: {
+	if (!same_type (TREE_TYPE (a), TREE_TYPE (b)))
+	  return false;
+
+	tree arg_a = TYPE_ARG_TYPES (a);
+	tree arg_b = TYPE_ARG_TYPES (b);
+	for (; arg_a && arg_b;
+	     arg_a = TREE_CHAIN (arg_a), arg_b = TREE_CHAIN (arg_b))
+	  {
+	    if (!same_type (TREE_VALUE (arg_a), TREE_VALUE (arg_b)))
+	      return false;
+	  }
+	return arg_a == arg_b;
+      }
+
+    default:
+      return false;
+    }
+}
+
+} // namespace Compile
+} // namespace Rust
@@ -0,0 +1,69 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_COMPILE_FN_MERGE
+#define RUST_COMPILE_FN_MERGE
+
+#include "rust-system.h"
+#include "tree.h"
+
+namespace Rust {
+namespace Compile {
+
+/* Merges the functions whose GENERIC is the same, as different instances of
+ * a generic function often compile to. A duplicate becomes an alias of the
+ * first function with its body instead of being handed to the middle-end,
+ * which at -O0 and -O1 would otherwise compile every copy.
+ *
+ * Types compare by identity, except without -fstrict-aliasing where types
+ * which are laid out the same are interchangeable, so Vec<u32>::len and
+ * Vec<i32>::len merge. */
+class FunctionMerger
+{
+public:
+  // The functions of FNS still to be defined once the duplicates are aliases
+  static std::vector<tree> merge (const std::vector<tree> &fns);
+
+private:
+  FunctionMerger () {}
+
+  bool mergeable (tree fndecl) const;
+  tree canonical (tree fndecl) const;
+
+  hashval_t fingerprint (tree fndecl) const;
+  void hash_tree (tree t, inchash::hash &hstate) const;
+
+  bool same_function (tree a, tree b);
+  bool same_tree (tree a, tree b);
+  bool same_decl (tree a, tree b);
+  bool same_field (tree a, tree b) const;
+  bool same_type (tree a, tree b) const;
+
+  // each duplicate and the function it is an alias of
+  std::map<tree, tree> aliases;
+
+  // the local declarations of the two functions being compared matched so
+  // far, both ways
+  std::map<tree, tree> locals;
+  std::set<tree> matched;
+};
+
+} // namespace Compile
+} // namespace Rust
+
+#endif // RUST_COMPILE_FN_MERGE
@@ -91,7 +91,9 @@ CompileTraitItem::visit (HIR::TraitItemFunc &func)
     = compile_function (ctx, function.get_function_name (),
 			function.get_self (), function.get_function_params (),
 			function.get_qualifiers (), vis,
-			func.get_outer_attrs (), func.get_locus (),
+			func.get_outer_attrs (),
+			Analysis::BuiltinAttrSet (func.get_outer_attrs ()),
+			func.get_locus (),
 			func.get_block_expr ().get (), canonical_path, fntype,
 			function.has_return_type ());
   reference = address_expression (fndecl, ref_locus);
@@ -27,6 +27,7 @@
 #include "print-tree.h"
 #include "fold-const.h"
 #include "langhooks.h"
+#include "memmodel.h"
 
 namespace Rust {
 namespace Compile {
@@ -44,6 +45,52 @@ wrapping_op_handler (Context *ctx, TyTy::FnType *fntype, tree_code op);
 static tree
 copy_nonoverlapping_handler (Context *ctx, TyTy::FnType *fntype);
 
+enum bit_count_kind
+{
+  COUNT_ONES,
+  COUNT_LEADING_ZEROS,
+  COUNT_TRAILING_ZEROS,
+};
+
+static tree
+bit_count_handler (Context *ctx, TyTy::FnType *fntype, bit_count_kind kind,
+		   bool nonzero);
+static tree
+byte_swap_handler (Context *ctx, TyTy::FnType *fntype, bool reverse_bits);
+static tree
+saturating_op_handler (Context *ctx, TyTy::FnType *fntype, tree_code op);
+static tree
+op_with_overflow_handler (Context *ctx, TyTy::FnType *fntype, tree_code op);
+static tree
+unchecked_op_handler (Context *ctx, TyTy::FnType *fntype, tree_code op);
+static tree
+expect_handler (Context *ctx, TyTy::FnType *fntype, bool likely);
+static tree
+assume_handler (Context *ctx, TyTy::FnType *fntype);
+static tree
+prefetch_handler (Context *ctx, TyTy::FnType *fntype, bool write);
+static tree
+black_box_handler (Context *ctx, TyTy::FnType *fntype);
+static tree
+simd_binop_handler (Context *ctx, TyTy::FnType *fntype, tree_code op);
+static tree
+simd_neg_handler (Context *ctx, TyTy::FnType *fntype);
+static tree
+simd_cmp_handler (Context *ctx, TyTy::FnType *fntype, tree_code op);
+static tree
+simd_extract_handler (Context *ctx, TyTy::FnType *fntype);
+static tree
+simd_insert_handler (Context *ctx, TyTy::FnType *fntype);
+static tree
+simd_shuffle_handler (Context *ctx, TyTy::FnType *fntype);
+static tree
+simd_reduce_handler (Context *ctx, TyTy::FnType *fntype, tree_code op,
+		     bool ordered);
+static tree
+simd_reduce_mask_handler (Context *ctx, TyTy::FnType *fntype, tree_code op);
+static tree
+atomic_handler (Context *ctx, TyTy::FnType *fntype);
+
 static inline tree
 rotate_left_handler (Context *ctx, TyTy::FnType *fntype)
 {
@@ -71,17 +118,168 @@ wrapping_mul_handler (Context *ctx, TyTy::FnType *fntype)
   return wrapping_op_handler (ctx, fntype, MULT_EXPR);
 }
 
+template <bit_count_kind kind, bool nonzero>
+static tree
+bit_count (Context *ctx, TyTy::FnType *fntype)
+{
+  return bit_count_handler (ctx, fntype, kind, nonzero);
+}
+
+static inline tree
+bswap_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  return byte_swap_handler (ctx, fntype, false);
+}
+static inline tree
+bitreverse_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  return byte_swap_handler (ctx, fntype, true);
+}
+
+template <tree_code op>
+static tree
+saturating_op (Context *ctx, TyTy::FnType *fntype)
+{
+  return saturating_op_handler (ctx, fntype, op);
+}
+
+template <tree_code op>
+static tree
+op_with_overflow (Context *ctx, TyTy::FnType *fntype)
+{
+  return op_with_overflow_handler (ctx, fntype, op);
+}
+
+template <tree_code op>
+static tree
+unchecked_op (Context *ctx, TyTy::FnType *fntype)
+{
+  return unchecked_op_handler (ctx, fntype, op);
+}
+
+template <bool likely>
+static tree
+expect (Context *ctx, TyTy::FnType *fntype)
+{
+  return expect_handler (ctx, fntype, likely);
+}
+
+template <bool write>
+static tree
+prefetch (Context *ctx, TyTy::FnType *fntype)
+{
+  return prefetch_handler (ctx, fntype, write);
+}
+
+template <tree_code op>
+static tree
+simd_binop (Context *ctx, TyTy::FnType *fntype)
+{
+  return simd_binop_handler (ctx, fntype, op);
+}
+
+template <tree_code op>
+static tree
+simd_cmp (Context *ctx, TyTy::FnType *fntype)
+{
+  return simd_cmp_handler (ctx, fntype, op);
+}
+
+template <tree_code op, bool ordered>
+static tree
+simd_reduce (Context *ctx, TyTy::FnType *fntype)
+{
+  return simd_reduce_handler (ctx, fntype, op, ordered);
+}
+
+template <tree_code op>
+static tree
+simd_reduce_mask (Context *ctx, TyTy::FnType *fntype)
+{
+  return simd_reduce_mask_handler (ctx, fntype, op);
+}
+
 static const std::map<std::string,
 		      std::function<tree (Context *, TyTy::FnType *)>>
-  generic_intrinsics = {{"offset", &offset_handler},
-			{"size_of", &sizeof_handler},
-			{"transmute", &transmute_handler},
-			{"rotate_left", &rotate_left_handler},
-			{"rotate_right", &rotate_right_handler},
-			{"wrapping_add", &wrapping_add_handler},
-			{"wrapping_sub", &wrapping_sub_handler},
-			{"wrapping_mul", &wrapping_mul_handler},
-			{"copy_nonoverlapping", &copy_nonoverlapping_handler}};
+  generic_intrinsics
+  = {{"offset", &offset_handler},
+     {"size_of", &sizeof_handler},
+     {"transmute", &transmute_handler},
+     {"rotate_left", &rotate_left_handler},
+     {"rotate_right", &rotate_right_handler},
+     {"wrapping_add", &wrapping_add_handler},
+     {"wrapping_sub", &wrapping_sub_handler},
+     {"wrapping_mul", &wrapping_mul_handler},
+     {"copy_nonoverlapping", &copy_nonoverlapping_handler},
+     {"ctpop", &bit_count<COUNT_ONES, false>},
+     {"ctlz", &bit_count<COUNT_LEADING_ZEROS, false>},
+     {"cttz", &bit_count<COUNT_TRAILING_ZEROS, false>},
+     {"ctlz_nonzero", &bit_count<COUNT_LEADING_ZEROS, true>},
+     {"cttz_nonzero", &bit_count<COUNT_TRAILING_ZEROS, true>},
+     {"bswap", &bswap_handler},
+     {"bitreverse", &bitreverse_handler},
+     {"saturating_add", &saturating_op<PLUS_EXPR>},
+     {"saturating_sub", &saturating_op<MINUS_EXPR>},
+     {"add_with_overflow", &op_with_overflow<PLUS_EXPR>},
+     {"sub_with_overflow", &op_with_overflow<MINUS_EXPR>},
+     {"mul_with_overflow", &op_with_overflow<MULT_EXPR>},
+     {"exact_div", &unchecked_op<EXACT_DIV_EXPR>},
+     {"unchecked_add", &unchecked_op<PLUS_EXPR>},
+     {"unchecked_sub", &unchecked_op<MINUS_EXPR>},
+     {"unchecked_mul", &unchecked_op<MULT_EXPR>},
+     {"unchecked_div", &unchecked_op<TRUNC_DIV_EXPR>},
+     {"unchecked_rem", &unchecked_op<TRUNC_MOD_EXPR>},
+     {"unchecked_shl", &unchecked_op<LSHIFT_EXPR>},
+     {"unchecked_shr", &unchecked_op<RSHIFT_EXPR>},
+     {"likely", &expect<true>},
+     {"unlikely", &expect<false>},
+     {"assume", &assume_handler},
+     {"prefetch_read_data", &prefetch<false>},
+     {"prefetch_write_data", &prefetch<true>},
+     {"prefetch_read_instruction", &prefetch<false>},
+     {"prefetch_write_instruction", &prefetch<true>},
+     {"black_box", &black_box_handler},
+
+     // extern "platform-intrinsic", see library/core/src/intrinsics/simd.rs
+     {"simd_add", &simd_binop<PLUS_EXPR>},
+     {"simd_sub", &simd_binop<MINUS_EXPR>},
+     {"simd_mul", &simd_binop<MULT_EXPR>},
+     {"simd_div", &simd_binop<TRUNC_DIV_EXPR>},
+     {"simd_rem", &simd_binop<TRUNC_MOD_EXPR>},
+     {"simd_shl", &simd_binop<LSHIFT_EXPR>},
+     {"simd_shr", &simd_binop<RSHIFT_EXPR>},
+     {"simd_and", &simd_binop<BIT_AND_EXPR>},
+     {"simd_or", &simd_binop<BIT_IOR_EXPR>},
+     {"simd_xor", &simd_binop<BIT_XOR_EXPR>},
+     {"simd_fmin", &simd_binop<MIN_EXPR>},
+     {"simd_fmax", &simd_binop<MAX_EXPR>},
+     {"simd_neg", &simd_neg_handler},
+     {"simd_eq", &simd_cmp<EQ_EXPR>},
+     {"simd_ne", &simd_cmp<NE_EXPR>},
+     {"simd_lt", &simd_cmp<LT_EXPR>},
+     {"simd_le", &simd_cmp<LE_EXPR>},
+     {"simd_gt", &simd_cmp<GT_EXPR>},
+     {"simd_ge", &simd_cmp<GE_EXPR>},
+     {"simd_extract", &simd_extract_handler},
+     {"simd_insert", &simd_insert_handler},
+     {"simd_shuffle", &simd_shuffle_handler},
+     {"simd_shuffle2", &simd_shuffle_handler},
+     {"simd_shuffle4", &simd_shuffle_handler},
+     {"simd_shuffle8", &simd_shuffle_handler},
+     {"simd_shuffle16", &simd_shuffle_handler},
+     {"simd_shuffle32", &simd_shuffle_handler},
+     {"simd_shuffle64", &simd_shuffle_handler},
+     {"simd_reduce_add_ordered", &simd_reduce<PLUS_EXPR, true>},
+     {"simd_reduce_mul_ordered", &simd_reduce<MULT_EXPR, true>},
+     {"simd_reduce_add_unordered", &simd_reduce<PLUS_EXPR, false>},
+     {"simd_reduce_mul_unordered", &simd_reduce<MULT_EXPR, false>},
+     {"simd_reduce_min", &simd_reduce<MIN_EXPR, false>},
+     {"simd_reduce_max", &simd_reduce<MAX_EXPR, false>},
+     {"simd_reduce_and", &simd_reduce<BIT_AND_EXPR, false>},
+     {"simd_reduce_or", &simd_reduce<BIT_IOR_EXPR, false>},
+     {"simd_reduce_xor", &simd_reduce<BIT_XOR_EXPR, false>},
+     {"simd_reduce_all", &simd_reduce_mask<BIT_AND_EXPR>},
+     {"simd_reduce_any", &simd_reduce_mask<BIT_IOR_EXPR>}};
 
 Intrinsics::Intrinsics (Context *ctx) : ctx (ctx) {}
 
@@ -100,6 +298,10 @@ Intrinsics::compile (TyTy::FnType *fntype)
   if (it != generic_intrinsics.end ())
     return it->second (ctx, fntype);
 
+  // the atomic intrinsics come in one flavour per memory ordering
+  if (fntype->get_identifier ().rfind ("atomic_", 0) == 0)
+    return atomic_handler (ctx, fntype);
+
   Location locus = ctx->get_mappings ()->lookup_location (fntype->get_ref ());
   rust_error_at (locus, "unknown builtin intrinsic: %s",
 		 fntype->get_identifier ().c_str ());
@@ -219,6 +421,146 @@ finalize_intrinsic_block (Context *ctx, tree fndecl)
   maybe_save_constexpr_fundef (fndecl);
 }
 
+// Whether a value of our TYPE can be passed as the builtin's BUILTIN_TYPE:
+// vectors are reinterpreted, since core::arch and GCC rarely agree on the
+// lanes of e.g. __m128i, and scalars converted.
+static bool
+target_builtin_type_compatible_p (tree type, tree builtin_type)
+{
+  if (VECTOR_TYPE_P (type) != VECTOR_TYPE_P (builtin_type))
+    return false;
+  if (VECTOR_TYPE_P (type))
+    return tree_int_cst_equal (TYPE_SIZE (type), TYPE_SIZE (builtin_type));
+
+  return (INTEGRAL_TYPE_P (type) || SCALAR_FLOAT_TYPE_P (type)
+	  || POINTER_TYPE_P (type))
+	 && (INTEGRAL_TYPE_P (builtin_type) || SCALAR_FLOAT_TYPE_P (builtin_type)
+	     || POINTER_TYPE_P (builtin_type));
+}
+
+static tree
+target_builtin_convert (tree type, tree expr)
+{
+  if (VECTOR_TYPE_P (type))
+    return fold_build1 (VIEW_CONVERT_EXPR, type, expr);
+  return fold_convert (type, expr);
+}
+
+/**
+ * extern "C" { #[link_name = "llvm.x86.sse2.pmadd.wd"] fn f(a: T, b: T) -> U; }
+ *
+ * We define f ourselves as an always inline function calling the target
+ * builtin, converting the arguments and result on the way.
+ */
+tree
+Intrinsics::compile_target_builtin (TyTy::FnType *fntype, tree builtin)
+{
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  const char *builtin_name = IDENTIFIER_POINTER (DECL_NAME (builtin));
+  tree builtin_fntype = TREE_TYPE (builtin);
+
+  std::vector<tree> builtin_params;
+  for (tree arg = TYPE_ARG_TYPES (builtin_fntype);
+       arg != NULL_TREE && !VOID_TYPE_P (TREE_VALUE (arg));
+       arg = TREE_CHAIN (arg))
+    builtin_params.push_back (TREE_VALUE (arg));
+
+  if (builtin_params.size () != fntype->get_params ().size ())
+    {
+      rust_error_at (fntype->get_locus (),
+		     "%qs takes %lu arguments but the target builtin %qs "
+		     "takes %lu",
+		     fntype->get_identifier ().c_str (),
+		     (unsigned long) fntype->get_params ().size (), builtin_name,
+		     (unsigned long) builtin_params.size ());
+      return error_mark_node;
+    }
+
+  for (size_t i = 0; i < builtin_params.size (); i++)
+    {
+      TyTy::BaseType *param_tyty = fntype->get_params ().at (i).second;
+      tree param_type = TyTyResolveCompile::compile (ctx, param_tyty);
+      if (param_type == error_mark_node)
+	return error_mark_node;
+
+      if (!target_builtin_type_compatible_p (param_type, builtin_params[i]))
+	{
+	  rust_error_at (fntype->get_locus (),
+			 "argument %lu of %qs has type %qs, which does not "
+			 "match the target builtin %qs",
+			 (unsigned long) i + 1,
+			 fntype->get_identifier ().c_str (),
+			 param_tyty->as_string ().c_str (), builtin_name);
+	  return error_mark_node;
+	}
+    }
+
+  tree builtin_result = TREE_TYPE (builtin_fntype);
+  bool returns_unit = fntype->get_return_type ()->is_unit ();
+  if (returns_unit != VOID_TYPE_P (builtin_result)
+      || (!returns_unit
+	  && !target_builtin_type_compatible_p (
+	    TyTyResolveCompile::compile (ctx, fntype->get_return_type ()),
+	    builtin_result)))
+    {
+      rust_error_at (fntype->get_locus (),
+		     "return type %qs of %qs does not match the target "
+		     "builtin %qs",
+		     fntype->get_return_type ()->as_string ().c_str (),
+		     fntype->get_identifier ().c_str (), builtin_name);
+      return error_mark_node;
+    }
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  // plenty of target builtins touch memory or machine state
+  TREE_READONLY (fndecl) = 0;
+  TREE_SIDE_EFFECTS (fndecl) = 1;
+
+  // and some want immediate operands, which are only constants once we are
+  // inlined into the caller
+  DECL_ATTRIBUTES (fndecl) = tree_cons (get_identifier ("always_inline"),
+					NULL_TREE, DECL_ATTRIBUTES (fndecl));
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // TARGET BUILTIN FN BODY BEGIN
+  std::vector<tree> args;
+  for (size_t i = 0; i < param_vars.size (); i++)
+    {
+      tree arg
+	= ctx->get_backend ()->var_expression (param_vars[i], Location ());
+      args.push_back (target_builtin_convert (builtin_params[i], arg));
+    }
+
+  tree call
+    = ctx->get_backend ()->call_expression (build_fold_addr_expr (builtin),
+					    args, nullptr, Location ());
+  if (returns_unit)
+    ctx->add_statement (call);
+  else
+    {
+      tree result_type = TREE_TYPE (DECL_RESULT (fndecl));
+      auto return_statement = ctx->get_backend ()->return_statement (
+	fndecl, {target_builtin_convert (result_type, call)}, Location ());
+      ctx->add_statement (return_statement);
+    }
+  // TARGET BUILTIN FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
 static tree
 offset_handler (Context *ctx, TyTy::FnType *fntype)
 {
@@ -515,5 +857,1624 @@ copy_nonoverlapping_handler (Context *ctx, TyTy::FnType *fntype)
   return fndecl;
 }
 
+/**
+ * The integer intrinsics below take any of the basic integer types, which
+ * rustc only checks once they are monomorphized. Check parameter INDEX of
+ * FNTYPE is one of them and return its type.
+ */
+static tree
+integer_param_type (Context *ctx, TyTy::FnType *fntype, size_t index)
+{
+  TyTy::BaseType *param_tyty = fntype->get_params ().at (index).second;
+  switch (param_tyty->destructure ()->get_kind ())
+    {
+    case TyTy::TypeKind::INT:
+    case TyTy::TypeKind::UINT:
+    case TyTy::TypeKind::ISIZE:
+    case TyTy::TypeKind::USIZE:
+      return TyTyResolveCompile::compile (ctx, param_tyty);
+
+    default:
+      rust_error_at (fntype->get_locus (),
+		     "invalid monomorphization of %qs intrinsic: expected "
+		     "basic integer type, found %qs",
+		     fntype->get_identifier ().c_str (),
+		     param_tyty->as_string ().c_str ());
+      return error_mark_node;
+    }
+}
+
+// __builtin_{popcount, clz, ctz} of the unsigned X, using the variant for the
+// narrowest of unsigned int, long and long long that holds it and splitting
+// a 128 bit X in halves. As for the builtins, the zeros of 0 are undefined.
+static tree
+count_bits (bit_count_kind kind, tree x)
+{
+  static const built_in_function fns[][3]
+    = {{BUILT_IN_POPCOUNT, BUILT_IN_POPCOUNTL, BUILT_IN_POPCOUNTLL},
+       {BUILT_IN_CLZ, BUILT_IN_CLZL, BUILT_IN_CLZLL},
+       {BUILT_IN_CTZ, BUILT_IN_CTZL, BUILT_IN_CTZLL}};
+  tree arg_types[] = {unsigned_type_node, long_unsigned_type_node,
+		      long_long_unsigned_type_node};
+
+  unsigned precision = TYPE_PRECISION (TREE_TYPE (x));
+  for (unsigned i = 0; i < 3; i++)
+    {
+      unsigned arg_precision = TYPE_PRECISION (arg_types[i]);
+      if (precision > arg_precision)
+	continue;
+
+      tree fn = builtin_decl_explicit (fns[kind][i]);
+      rust_assert (fn != NULL_TREE);
+      tree count = build_call_expr (fn, 1, fold_convert (arg_types[i], x));
+
+      // the zeros x was extended with lead
+      if (kind == COUNT_LEADING_ZEROS && precision < arg_precision)
+	count = fold_build2 (MINUS_EXPR, integer_type_node, count,
+			     build_int_cst (integer_type_node,
+					    arg_precision - precision));
+      return count;
+    }
+
+  tree half_type = long_long_unsigned_type_node;
+  unsigned half = TYPE_PRECISION (half_type);
+  rust_assert (precision == 2 * half);
+
+  x = save_expr (x);
+  tree high = save_expr (
+    fold_convert (half_type,
+		  fold_build2 (RSHIFT_EXPR, TREE_TYPE (x), x,
+			       build_int_cst (integer_type_node, half))));
+  tree low = save_expr (fold_convert (half_type, x));
+  tree half_count = build_int_cst (integer_type_node, half);
+
+  switch (kind)
+    {
+    case COUNT_ONES:
+      return fold_build2 (PLUS_EXPR, integer_type_node,
+			  count_bits (kind, high), count_bits (kind, low));
+
+    case COUNT_LEADING_ZEROS:
+      return fold_build3 (
+	COND_EXPR, integer_type_node,
+	fold_build2 (NE_EXPR, boolean_type_node, high,
+		     build_zero_cst (half_type)),
+	count_bits (kind, high),
+	fold_build2 (PLUS_EXPR, integer_type_node, half_count,
+		     count_bits (kind, low)));
+
+    case COUNT_TRAILING_ZEROS:
+      return fold_build3 (
+	COND_EXPR, integer_type_node,
+	fold_build2 (NE_EXPR, boolean_type_node, low,
+		     build_zero_cst (half_type)),
+	count_bits (kind, low),
+	fold_build2 (PLUS_EXPR, integer_type_node, half_count,
+		     count_bits (kind, high)));
+    }
+
+  gcc_unreachable ();
+}
+
+/**
+ * fn ctpop<T>(x: T) -> T;
+ * fn {ctlz, cttz}<T>(x: T) -> T;
+ * unsafe fn {ctlz, cttz}_nonzero<T>(x: T) -> T;
+ */
+static tree
+bit_count_handler (Context *ctx, TyTy::FnType *fntype, bit_count_kind kind,
+		   bool nonzero)
+{
+  rust_assert (fntype->get_params ().size () == 1);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree int_type = integer_param_type (ctx, fntype, 0);
+  if (int_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN bit_count FN BODY BEGIN
+  auto x_var = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  tree x = save_expr (fold_convert (unsigned_type_for (int_type), x_var));
+
+  tree count = count_bits (kind, x);
+  if (kind != COUNT_ONES && !nonzero)
+    count = fold_build3 (COND_EXPR, integer_type_node,
+			 fold_build2 (EQ_EXPR, boolean_type_node, x,
+				      build_zero_cst (TREE_TYPE (x))),
+			 build_int_cst (integer_type_node,
+					TYPE_PRECISION (int_type)),
+			 count);
+
+  tree result_type = TREE_TYPE (DECL_RESULT (fndecl));
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl,
+					     {fold_convert (result_type,
+							    count)},
+					     Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN bit_count FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+// Swap the bytes of the unsigned X with __builtin_bswap{16, 32, 64, 128}.
+static tree
+swap_bytes (tree x)
+{
+  tree type = TREE_TYPE (x);
+  built_in_function code;
+  switch (TYPE_PRECISION (type))
+    {
+    case 8:
+      return x;
+    case 16:
+      code = BUILT_IN_BSWAP16;
+      break;
+    case 32:
+      code = BUILT_IN_BSWAP32;
+      break;
+    case 64:
+      code = BUILT_IN_BSWAP64;
+      break;
+    case 128:
+      code = BUILT_IN_BSWAP128;
+      break;
+    default:
+      gcc_unreachable ();
+    }
+
+  tree fn = builtin_decl_explicit (code);
+  rust_assert (fn != NULL_TREE);
+  tree arg_type = TREE_VALUE (TYPE_ARG_TYPES (TREE_TYPE (fn)));
+  return fold_convert (type,
+		       build_call_expr (fn, 1, fold_convert (arg_type, x)));
+}
+
+// The constant of TYPE whose every byte is BYTE.
+static tree
+byte_pattern (tree type, unsigned HOST_WIDE_INT byte)
+{
+  unsigned precision = TYPE_PRECISION (type);
+  wide_int pattern = wi::zero (precision);
+  for (unsigned i = 0; i < precision; i += BITS_PER_UNIT)
+    pattern = wi::bit_or (wi::lshift (pattern, BITS_PER_UNIT),
+			  wi::uhwi (byte, precision));
+  return wide_int_to_tree (type, pattern);
+}
+
+/**
+ * fn bswap<T>(x: T) -> T;
+ * fn bitreverse<T>(x: T) -> T;
+ */
+static tree
+byte_swap_handler (Context *ctx, TyTy::FnType *fntype, bool reverse_bits)
+{
+  rust_assert (fntype->get_params ().size () == 1);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree int_type = integer_param_type (ctx, fntype, 0);
+  if (int_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN byte_swap FN BODY BEGIN
+  auto x_var = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  tree type = unsigned_type_for (int_type);
+  tree x = fold_convert (type, x_var);
+
+  // reverse the bits within each byte, swapping neighbouring bits, pairs and
+  // nibbles in turn, then the bytes themselves
+  if (reverse_bits)
+    {
+      static const struct
+      {
+	unsigned shift;
+	unsigned HOST_WIDE_INT mask;
+      } steps[] = {{1, 0x55}, {2, 0x33}, {4, 0x0f}};
+
+      for (auto &step : steps)
+	{
+	  x = save_expr (x);
+	  tree shift = build_int_cst (integer_type_node, step.shift);
+	  tree mask = byte_pattern (type, step.mask);
+	  tree odd = fold_build2 (BIT_AND_EXPR, type,
+				  fold_build2 (RSHIFT_EXPR, type, x, shift),
+				  mask);
+	  tree even
+	    = fold_build2 (LSHIFT_EXPR, type,
+			   fold_build2 (BIT_AND_EXPR, type, x, mask), shift);
+	  x = fold_build2 (BIT_IOR_EXPR, type, odd, even);
+	}
+    }
+  x = swap_bytes (x);
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl,
+					     {fold_convert (int_type, x)},
+					     Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN byte_swap FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+// Call __builtin_{add, sub, mul}_overflow for OP on LHS and RHS, which stores
+// the wrapped result in a new temporary of FNDECL returned in *RESULT.
+static tree
+overflow_builtin_call (Context *ctx, tree fndecl, tree_code op, tree lhs,
+		       tree rhs, Bvariable **result)
+{
+  built_in_function code;
+  switch (op)
+    {
+    case PLUS_EXPR:
+      code = BUILT_IN_ADD_OVERFLOW;
+      break;
+    case MINUS_EXPR:
+      code = BUILT_IN_SUB_OVERFLOW;
+      break;
+    case MULT_EXPR:
+      code = BUILT_IN_MUL_OVERFLOW;
+      break;
+    default:
+      gcc_unreachable ();
+    }
+
+  tree init_stmt = NULL_TREE;
+  *result = ctx->get_backend ()->temporary_variable (fndecl,
+						     ctx->peek_enclosing_scope (),
+						     TREE_TYPE (lhs), NULL_TREE,
+						     true, Location (),
+						     &init_stmt);
+  ctx->add_statement (init_stmt);
+
+  tree result_expr = ctx->get_backend ()->var_expression (*result, Location ());
+  tree fn = builtin_decl_explicit (code);
+  rust_assert (fn != NULL_TREE);
+  return build_call_expr (fn, 3, lhs, rhs, build_fold_addr_expr (result_expr));
+}
+
+/**
+ * fn saturating_{add, sub}<T>(a: T, b: T) -> T;
+ */
+static tree
+saturating_op_handler (Context *ctx, TyTy::FnType *fntype, tree_code op)
+{
+  rust_assert (fntype->get_params ().size () == 2);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree int_type = integer_param_type (ctx, fntype, 0);
+  if (int_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN saturating_<op> FN BODY BEGIN
+  auto a = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto b = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+
+  Bvariable *wrapped = nullptr;
+  tree overflowed = overflow_builtin_call (ctx, fndecl, op, a, b, &wrapped);
+
+  // unsigned values only ever overflow away from zero for an add and below
+  // it for a sub, signed ones in the direction of b
+  tree towards_max = op == PLUS_EXPR ? boolean_true_node : boolean_false_node;
+  if (!TYPE_UNSIGNED (int_type))
+    {
+      tree b_negative = fold_build2 (LT_EXPR, boolean_type_node, b,
+				     build_zero_cst (int_type));
+      towards_max = op == PLUS_EXPR
+		      ? fold_build1 (TRUTH_NOT_EXPR, boolean_type_node,
+				     b_negative)
+		      : b_negative;
+    }
+  tree saturated
+    = fold_build3 (COND_EXPR, int_type, towards_max,
+		   TYPE_MAX_VALUE (int_type), TYPE_MIN_VALUE (int_type));
+
+  tree result
+    = fold_build3 (COND_EXPR, int_type, overflowed, saturated,
+		   ctx->get_backend ()->var_expression (wrapped, Location ()));
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {result}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN saturating_<op> FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn {add, sub, mul}_with_overflow<T>(x: T, y: T) -> (T, bool);
+ */
+static tree
+op_with_overflow_handler (Context *ctx, TyTy::FnType *fntype, tree_code op)
+{
+  rust_assert (fntype->get_params ().size () == 2);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree int_type = integer_param_type (ctx, fntype, 0);
+  if (int_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN <op>_with_overflow FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto y = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+
+  Bvariable *wrapped = nullptr;
+  tree overflowed
+    = save_expr (overflow_builtin_call (ctx, fndecl, op, x, y, &wrapped));
+
+  // the builtin has to run before the wrapped result is read
+  tree result_type = TREE_TYPE (DECL_RESULT (fndecl));
+  tree tuple = ctx->get_backend ()->constructor_expression (
+    result_type, false,
+    {ctx->get_backend ()->var_expression (wrapped, Location ()), overflowed},
+    -1, Location ());
+  tree result = build2 (COMPOUND_EXPR, result_type, overflowed, tuple);
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {result}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN <op>_with_overflow FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * unsafe fn exact_div<T>(x: T, y: T) -> T;
+ * unsafe fn unchecked_{add, sub, mul, div, rem, shl, shr}<T>(x: T, y: T) -> T;
+ *
+ * The caller promises the operation neither overflows nor divides by zero,
+ * so these are the bare operations without the checks of the operators.
+ */
+static tree
+unchecked_op_handler (Context *ctx, TyTy::FnType *fntype, tree_code op)
+{
+  rust_assert (fntype->get_params ().size () == 2);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree int_type = integer_param_type (ctx, fntype, 0);
+  if (int_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN unchecked_<op> FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto y = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+
+  // the amount of a shift may be of any integer type
+  if (op != LSHIFT_EXPR && op != RSHIFT_EXPR)
+    y = fold_convert (int_type, y);
+  tree result = fold_build2 (op, int_type, x, y);
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {result}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN unchecked_<op> FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn likely(b: bool) -> bool;
+ * fn unlikely(b: bool) -> bool;
+ */
+static tree
+expect_handler (Context *ctx, TyTy::FnType *fntype, bool likely)
+{
+  rust_assert (fntype->get_params ().size () == 1);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN expect FN BODY BEGIN
+  auto b = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+
+  // __builtin_expect ((long) b, likely) != 0, the hint survives inlining the
+  // call into the condition it is used in
+  tree expect = builtin_decl_explicit (BUILT_IN_EXPECT);
+  rust_assert (expect != NULL_TREE);
+  tree expected
+    = build_call_expr (expect, 2, fold_convert (long_integer_type_node, b),
+		       build_int_cst (long_integer_type_node, likely));
+  tree result_type = TREE_TYPE (DECL_RESULT (fndecl));
+  tree result = fold_build2 (NE_EXPR, result_type, expected,
+			     build_zero_cst (long_integer_type_node));
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {result}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN expect FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * unsafe fn assume(b: bool);
+ */
+static tree
+assume_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  rust_assert (fntype->get_params ().size () == 1);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  // the call has no result, it must not be thrown away before it is inlined
+  TREE_READONLY (fndecl) = 0;
+  TREE_SIDE_EFFECTS (fndecl) = 1;
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN assume FN BODY BEGIN
+  auto b = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+
+  // if (!b) __builtin_unreachable ();
+  tree unreachable = builtin_decl_explicit (BUILT_IN_UNREACHABLE);
+  rust_assert (unreachable != NULL_TREE);
+  tree assumption = build3 (COND_EXPR, void_type_node, b,
+			    build_empty_stmt (BUILTINS_LOCATION),
+			    build_call_expr (unreachable, 0));
+  ctx->add_statement (assumption);
+  // BUILTIN assume FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * unsafe fn prefetch_{read, write}_{data, instruction}<T>(data: *const T,
+ *   locality: i32);
+ *
+ * GCC has no separate prefetch for instructions, they are prefetched as data.
+ */
+static tree
+prefetch_handler (Context *ctx, TyTy::FnType *fntype, bool write)
+{
+  rust_assert (fntype->get_params ().size () == 2);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  TREE_READONLY (fndecl) = 0;
+  TREE_SIDE_EFFECTS (fndecl) = 1;
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN prefetch FN BODY BEGIN
+  auto data = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto locality
+    = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+
+  // __builtin_prefetch wants a constant locality, which the parameter only
+  // becomes once inlined: pick the call for each of the four at runtime and
+  // leave the rest to folding
+  tree prefetch = builtin_decl_explicit (BUILT_IN_PREFETCH);
+  rust_assert (prefetch != NULL_TREE);
+  tree rw = build_int_cst (integer_type_node, write);
+  tree call = NULL_TREE;
+  for (int level = 3; level >= 0; level--)
+    {
+      tree level_call
+	= build_call_expr (prefetch, 3, fold_convert (const_ptr_type_node, data),
+			   rw, build_int_cst (integer_type_node, level));
+      if (call == NULL_TREE)
+	call = level_call;
+      else
+	call = build3 (COND_EXPR, void_type_node,
+		       fold_build2 (EQ_EXPR, boolean_type_node, locality,
+				    build_int_cst (TREE_TYPE (locality),
+						   level)),
+		       level_call, call);
+    }
+  ctx->add_statement (call);
+  // BUILTIN prefetch FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn black_box<T>(dummy: T) -> T;
+ *
+ * Hide dummy from the optimizers by handing its address to an empty asm
+ * statement that may read and write all of memory, as rustc does.
+ */
+static tree
+black_box_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  rust_assert (fntype->get_params ().size () == 1);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  TREE_READONLY (fndecl) = 0;
+  TREE_SIDE_EFFECTS (fndecl) = 1;
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN black_box FN BODY BEGIN
+  auto dummy = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  TREE_ADDRESSABLE (dummy) = 1;
+
+  // asm volatile ("" : : "r" (&dummy) : "memory");
+  tree inputs
+    = build_tree_list (build_tree_list (NULL_TREE, build_string (1, "r")),
+		       build_fold_addr_expr (dummy));
+  tree clobbers = build_tree_list (NULL_TREE, build_string (6, "memory"));
+  tree barrier = build5 (ASM_EXPR, void_type_node, build_string (0, ""),
+			 NULL_TREE, inputs, clobbers, NULL_TREE);
+  ASM_VOLATILE_P (barrier) = 1;
+  ctx->add_statement (barrier);
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {dummy}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN black_box FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * The simd_* intrinsics work on #[repr(simd)] structs, which are compiled to
+ * GCC vector types. Check that the first COUNT parameters of FNTYPE are such
+ * vectors and return their type.
+ */
+static tree
+simd_param_type (Context *ctx, TyTy::FnType *fntype, size_t count)
+{
+  tree vector_type = NULL_TREE;
+  for (size_t i = 0; i < count; i++)
+    {
+      TyTy::BaseType *param_tyty = fntype->get_params ().at (i).second;
+      tree param_type = TyTyResolveCompile::compile (ctx, param_tyty);
+      if (param_type == error_mark_node)
+	return error_mark_node;
+
+      if (TREE_CODE (param_type) != VECTOR_TYPE)
+	{
+	  rust_error_at (fntype->get_locus (),
+			 "invalid monomorphization of %qs intrinsic: expected "
+			 "SIMD input type, found non-SIMD %qs",
+			 fntype->get_identifier ().c_str (),
+			 param_tyty->as_string ().c_str ());
+	  return error_mark_node;
+	}
+
+      if (vector_type != NULL_TREE
+	  && TYPE_MAIN_VARIANT (vector_type) != TYPE_MAIN_VARIANT (param_type))
+	{
+	  rust_error_at (fntype->get_locus (),
+			 "invalid monomorphization of %qs intrinsic: expected "
+			 "the SIMD inputs to have the same type",
+			 fntype->get_identifier ().c_str ());
+	  return error_mark_node;
+	}
+      vector_type = param_type;
+    }
+
+  return vector_type;
+}
+
+static unsigned HOST_WIDE_INT
+simd_lanes (tree vector_type)
+{
+  return TYPE_VECTOR_SUBPARTS (vector_type).to_constant ();
+}
+
+// The lanes of VECTOR as an array, like the C front end does for vector
+// subscripts. A variable INDEX needs VECTOR to live in memory.
+static tree
+simd_lane_ref (tree vector, tree index)
+{
+  tree vector_type = TREE_TYPE (vector);
+  tree lane_type = TREE_TYPE (vector_type);
+  tree array_type
+    = build_array_type_nelts (lane_type, simd_lanes (vector_type));
+
+  if (TREE_CODE (index) != INTEGER_CST)
+    TREE_ADDRESSABLE (vector) = 1;
+
+  tree array = build1 (VIEW_CONVERT_EXPR, array_type, vector);
+  return build4 (ARRAY_REF, lane_type, array, index, NULL_TREE, NULL_TREE);
+}
+
+// Lane INDEX of VECTOR when INDEX is known.
+static tree
+simd_lane (tree vector, unsigned HOST_WIDE_INT index)
+{
+  tree lane_type = TREE_TYPE (TREE_TYPE (vector));
+  tree lane_size = TYPE_SIZE (lane_type);
+  return build3 (BIT_FIELD_REF, lane_type, vector, lane_size,
+		 bitsize_int (index * tree_to_uhwi (lane_size)));
+}
+
+/**
+ * fn simd_{add, sub, mul, div, rem, shl, shr, and, or, xor}<T>(x: T, y: T)
+ *   -> T;
+ * fn simd_{fmin, fmax}<T>(x: T, y: T) -> T;
+ */
+static tree
+simd_binop_handler (Context *ctx, TyTy::FnType *fntype, tree_code op)
+{
+  rust_assert (fntype->get_params ().size () == 2);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 2);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  bool is_float = FLOAT_TYPE_P (TREE_TYPE (vector_type));
+  if (is_float && op == TRUNC_DIV_EXPR)
+    op = RDIV_EXPR;
+
+  bool valid = is_float ? op == PLUS_EXPR || op == MINUS_EXPR
+			    || op == MULT_EXPR || op == RDIV_EXPR
+			    || op == MIN_EXPR || op == MAX_EXPR
+			: op != MIN_EXPR && op != MAX_EXPR;
+  if (!valid)
+    {
+      rust_error_at (fntype->get_locus (),
+		     "invalid monomorphization of %qs intrinsic: unsupported "
+		     "operation on %qs with %s elements",
+		     fntype->get_identifier ().c_str (),
+		     fntype->get_params ().at (0).second->as_string ().c_str (),
+		     is_float ? "floating-point" : "integer");
+      return error_mark_node;
+    }
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  // setup the params
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_<op> FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto y = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+
+  // lane-wise, and wrapping for integers like wrapping_<op>
+  auto op_expr = build2 (op, vector_type, x, y);
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {op_expr}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_<op> FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn simd_neg<T>(x: T) -> T;
+ */
+static tree
+simd_neg_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  rust_assert (fntype->get_params ().size () == 1);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 1);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_neg FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto neg_expr = build1 (NEGATE_EXPR, vector_type, x);
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {neg_expr}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_neg FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn simd_{eq, ne, lt, le, gt, ge}<T, U>(x: T, y: T) -> U;
+ *
+ * U is an integer vector with as many lanes as T, each lane is all ones
+ * where the comparison holds and zero where it does not.
+ */
+static tree
+simd_cmp_handler (Context *ctx, TyTy::FnType *fntype, tree_code op)
+{
+  rust_assert (fntype->get_params ().size () == 2);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 2);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  tree mask_type
+    = TyTyResolveCompile::compile (ctx, fntype->get_return_type ());
+  if (mask_type == error_mark_node)
+    return error_mark_node;
+  if (TREE_CODE (mask_type) != VECTOR_TYPE
+      || !INTEGRAL_TYPE_P (TREE_TYPE (mask_type))
+      || simd_lanes (mask_type) != simd_lanes (vector_type))
+    {
+      rust_error_at (fntype->get_locus (),
+		     "invalid monomorphization of %qs intrinsic: expected "
+		     "return type with integer elements and %lu lanes, found %qs",
+		     fntype->get_identifier ().c_str (),
+		     (unsigned long) simd_lanes (vector_type),
+		     fntype->get_return_type ()->as_string ().c_str ());
+      return error_mark_node;
+    }
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_<cmp> FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto y = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+
+  // see build_vec_cmp in the C front end
+  tree cmp_type = truth_type_for (vector_type);
+  tree cmp = build2 (op, cmp_type, x, y);
+  tree mask_expr
+    = build3 (VEC_COND_EXPR, mask_type, cmp, build_minus_one_cst (mask_type),
+	      build_zero_cst (mask_type));
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {mask_expr}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_<cmp> FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn simd_extract<T, U>(x: T, idx: u32) -> U;
+ */
+static tree
+simd_extract_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  rust_assert (fntype->get_params ().size () == 2);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 1);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_extract FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto idx = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+
+  tree lane = simd_lane_ref (x, fold_convert (sizetype, idx));
+  tree result_type = TREE_TYPE (DECL_RESULT (fndecl));
+  tree result_expr = ctx->get_backend ()->convert_expression (result_type, lane,
+							      Location ());
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {result_expr},
+					     Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_extract FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn simd_insert<T, U>(x: T, idx: u32, val: U) -> T;
+ */
+static tree
+simd_insert_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  rust_assert (fntype->get_params ().size () == 3);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 1);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_insert FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto idx = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+  auto val = ctx->get_backend ()->var_expression (param_vars[2], Location ());
+
+  // x is our own copy so the lane can be stored straight into it
+  tree lane = simd_lane_ref (x, fold_convert (sizetype, idx));
+  tree store = ctx->get_backend ()->assignment_statement (
+    lane, fold_convert (TREE_TYPE (lane), val), Location ());
+  ctx->add_statement (store);
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {x}, Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_insert FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn simd_shuffle<T, I, U>(x: T, y: T, idx: I) -> U;
+ *
+ * I is [u32; N] and U a vector of N lanes of the element type of T. Lane i of
+ * the result is lane idx[i] of x and y concatenated.
+ */
+static tree
+simd_shuffle_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  rust_assert (fntype->get_params ().size () == 3);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 2);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  TyTy::BaseType *idx_tyty = fntype->get_params ().at (2).second;
+  tree idx_type = TyTyResolveCompile::compile (ctx, idx_tyty);
+  tree result_type
+    = TyTyResolveCompile::compile (ctx, fntype->get_return_type ());
+  if (idx_type == error_mark_node || result_type == error_mark_node)
+    return error_mark_node;
+
+  if (TREE_CODE (idx_type) != ARRAY_TYPE
+      || !tree_fits_uhwi_p (array_type_nelts (idx_type)))
+    {
+      rust_error_at (fntype->get_locus (),
+		     "invalid monomorphization of %qs intrinsic: simd_shuffle "
+		     "index must be an array of %<u32%>, got %qs",
+		     fntype->get_identifier ().c_str (),
+		     idx_tyty->as_string ().c_str ());
+      return error_mark_node;
+    }
+
+  unsigned HOST_WIDE_INT out_lanes
+    = tree_to_uhwi (array_type_nelts (idx_type)) + 1;
+  if (TREE_CODE (result_type) != VECTOR_TYPE
+      || simd_lanes (result_type) != out_lanes
+      || TYPE_MAIN_VARIANT (TREE_TYPE (result_type))
+	   != TYPE_MAIN_VARIANT (TREE_TYPE (vector_type)))
+    {
+      rust_error_at (fntype->get_locus (),
+		     "invalid monomorphization of %qs intrinsic: expected "
+		     "return type of %lu lanes of the input element type, "
+		     "found %qs",
+		     fntype->get_identifier ().c_str (),
+		     (unsigned long) out_lanes,
+		     fntype->get_return_type ()->as_string ().c_str ());
+      return error_mark_node;
+    }
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_shuffle FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  auto y = ctx->get_backend ()->var_expression (param_vars[1], Location ());
+  auto idx = ctx->get_backend ()->var_expression (param_vars[2], Location ());
+
+  unsigned HOST_WIDE_INT in_lanes = simd_lanes (vector_type);
+  tree lane_type = TREE_TYPE (vector_type);
+  tree idx_elem_type = TREE_TYPE (idx_type);
+
+  tree shuffle_expr;
+  if (out_lanes == in_lanes)
+    {
+      // the index is a constant once we are inlined, so this ends up as a
+      // single permute instruction
+      tree mask_elem_type
+	= build_nonstandard_integer_type (tree_to_uhwi (TYPE_SIZE (lane_type)),
+					  1);
+      tree mask_type = build_vector_type (mask_elem_type, out_lanes);
+
+      vec<constructor_elt, va_gc> *mask_elts;
+      vec_alloc (mask_elts, out_lanes);
+      for (unsigned HOST_WIDE_INT i = 0; i < out_lanes; i++)
+	{
+	  tree elt = build4 (ARRAY_REF, idx_elem_type, idx, size_int (i),
+			     NULL_TREE, NULL_TREE);
+	  CONSTRUCTOR_APPEND_ELT (mask_elts, NULL_TREE,
+				  fold_convert (mask_elem_type, elt));
+	}
+      tree mask = build_constructor (mask_type, mask_elts);
+
+      shuffle_expr = build3 (VEC_PERM_EXPR, result_type, x, y, mask);
+    }
+  else
+    {
+      // a permute cannot change the number of lanes with a variable mask,
+      // so pick every lane on its own and leave it to forwprop to turn
+      // the result back into a permute
+      vec<constructor_elt, va_gc> *lanes;
+      vec_alloc (lanes, out_lanes);
+      tree in_lanes_expr = build_int_cst (idx_elem_type, in_lanes);
+      for (unsigned HOST_WIDE_INT i = 0; i < out_lanes; i++)
+	{
+	  tree elt = build4 (ARRAY_REF, idx_elem_type, idx, size_int (i),
+			     NULL_TREE, NULL_TREE);
+	  elt = save_expr (elt);
+
+	  tree from_x = simd_lane_ref (x, fold_convert (sizetype, elt));
+	  tree from_y = simd_lane_ref (
+	    y, fold_convert (sizetype,
+			     build2 (MINUS_EXPR, idx_elem_type, elt,
+				     in_lanes_expr)));
+	  tree in_x = build2 (LT_EXPR, boolean_type_node, elt, in_lanes_expr);
+	  tree lane = build3 (COND_EXPR, lane_type, in_x, from_x, from_y);
+	  CONSTRUCTOR_APPEND_ELT (lanes, NULL_TREE, lane);
+	}
+      shuffle_expr = build_constructor (result_type, lanes);
+    }
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {shuffle_expr},
+					     Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_shuffle FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn simd_reduce_{add, mul}_ordered<T, U>(x: T, acc: U) -> U;
+ * fn simd_reduce_{add, mul}_unordered<T, U>(x: T) -> U;
+ * fn simd_reduce_{min, max, and, or, xor}<T, U>(x: T) -> U;
+ */
+static tree
+simd_reduce_handler (Context *ctx, TyTy::FnType *fntype, tree_code op,
+		     bool ordered)
+{
+  rust_assert (fntype->get_params ().size () == (ordered ? 2 : 1));
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 1);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  bool is_float = FLOAT_TYPE_P (TREE_TYPE (vector_type));
+  if (is_float
+      && (op == BIT_AND_EXPR || op == BIT_IOR_EXPR || op == BIT_XOR_EXPR))
+    {
+      rust_error_at (fntype->get_locus (),
+		     "invalid monomorphization of %qs intrinsic: unsupported "
+		     "operation on %qs with floating-point elements",
+		     fntype->get_identifier ().c_str (),
+		     fntype->get_params ().at (0).second->as_string ().c_str ());
+      return error_mark_node;
+    }
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_reduce_<op> FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  tree lane_type = TREE_TYPE (vector_type);
+  unsigned HOST_WIDE_INT lanes = simd_lanes (vector_type);
+
+  tree reduction;
+  if (ordered)
+    {
+      // strictly left to right from the accumulator, which matters for
+      // floats
+      auto acc
+	= ctx->get_backend ()->var_expression (param_vars[1], Location ());
+      reduction = fold_convert (lane_type, acc);
+      for (unsigned HOST_WIDE_INT i = 0; i < lanes; i++)
+	reduction = build2 (op, lane_type, reduction, simd_lane (x, i));
+    }
+  else
+    {
+      // combine the lanes pairwise, which keeps the dependency chain at
+      // log2 (lanes) and is the shape the SLP vectorizer looks for
+      std::vector<tree> partial;
+      for (unsigned HOST_WIDE_INT i = 0; i < lanes; i++)
+	partial.push_back (simd_lane (x, i));
+      while (partial.size () > 1)
+	{
+	  std::vector<tree> next;
+	  for (size_t i = 0; i + 1 < partial.size (); i += 2)
+	    next.push_back (build2 (op, lane_type, partial[i], partial[i + 1]));
+	  if (partial.size () % 2 != 0)
+	    next.push_back (partial.back ());
+	  partial = std::move (next);
+	}
+      reduction = partial.front ();
+    }
+
+  tree result_type = TREE_TYPE (DECL_RESULT (fndecl));
+  tree result_expr
+    = ctx->get_backend ()->convert_expression (result_type, reduction,
+					       Location ());
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {result_expr},
+					     Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_reduce_<op> FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * fn simd_reduce_{all, any}<T>(x: T) -> bool;
+ *
+ * x is a mask as returned by the simd_<cmp> intrinsics.
+ */
+static tree
+simd_reduce_mask_handler (Context *ctx, TyTy::FnType *fntype, tree_code op)
+{
+  rust_assert (fntype->get_params ().size () == 1);
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  tree vector_type = simd_param_type (ctx, fntype, 1);
+  if (vector_type == error_mark_node)
+    return error_mark_node;
+
+  if (!INTEGRAL_TYPE_P (TREE_TYPE (vector_type)))
+    {
+      rust_error_at (fntype->get_locus (),
+		     "invalid monomorphization of %qs intrinsic: expected "
+		     "a SIMD mask with integer elements, found %qs",
+		     fntype->get_identifier ().c_str (),
+		     fntype->get_params ().at (0).second->as_string ().c_str ());
+      return error_mark_node;
+    }
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN simd_reduce_<all, any> FN BODY BEGIN
+  auto x = ctx->get_backend ()->var_expression (param_vars[0], Location ());
+  tree lane_type = TREE_TYPE (vector_type);
+
+  tree reduction = simd_lane (x, 0);
+  for (unsigned HOST_WIDE_INT i = 1; i < simd_lanes (vector_type); i++)
+    reduction = build2 (op, lane_type, reduction, simd_lane (x, i));
+
+  tree result_expr = build2 (NE_EXPR, TREE_TYPE (DECL_RESULT (fndecl)),
+			     reduction, build_zero_cst (lane_type));
+
+  auto return_statement
+    = ctx->get_backend ()->return_statement (fndecl, {result_expr},
+					     Location ());
+  ctx->add_statement (return_statement);
+  // BUILTIN simd_reduce_<all, any> FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
+/**
+ * The atomic intrinsics are named atomic_<op>[_<ordering>[_<ordering>]],
+ * e.g. atomic_load_acquire or atomic_cxchg_acqrel_relaxed. The orderings
+ * default to seqcst, and core before 1.64 still spells them acq, rel and
+ * failrelaxed. See library/core/src/intrinsics.rs.
+ */
+static bool
+parse_atomic_ordering (const std::string &ordering, memmodel *model)
+{
+  std::string name = ordering;
+  if (name.rfind ("fail", 0) == 0)
+    name = name.substr (4);
+
+  if (name == "seqcst")
+    *model = MEMMODEL_SEQ_CST;
+  else if (name == "acquire" || name == "acq")
+    *model = MEMMODEL_ACQUIRE;
+  else if (name == "release" || name == "rel")
+    *model = MEMMODEL_RELEASE;
+  else if (name == "acqrel")
+    *model = MEMMODEL_ACQ_REL;
+  else if (name == "relaxed" || name == "unordered")
+    *model = MEMMODEL_RELAXED;
+  else
+    return false;
+  return true;
+}
+
+// The strongest ordering a failed compare-exchange may have after succeeding
+// with SUCCESS: it does not store, so it cannot release.
+static memmodel
+atomic_failure_ordering (memmodel success)
+{
+  switch (success)
+    {
+    case MEMMODEL_ACQ_REL:
+      return MEMMODEL_ACQUIRE;
+    case MEMMODEL_RELEASE:
+      return MEMMODEL_RELAXED;
+    default:
+      return success;
+    }
+}
+
+static tree
+atomic_ordering_expr (memmodel model)
+{
+  return build_int_cst (integer_type_node, model);
+}
+
+// Call the __atomic_* builtin BASE, given for one byte, for a type of
+// 1 << SIZE_LOG2 bytes.
+static tree
+atomic_builtin_call (Context *ctx, built_in_function base, int size_log2,
+		     const std::vector<tree> &args)
+{
+  tree fn = builtin_decl_explicit ((built_in_function) (base + size_log2));
+  rust_assert (fn != NULL_TREE);
+
+  auto fn_addr = build_fold_addr_expr_loc (BUILTINS_LOCATION, fn);
+  return ctx->get_backend ()->call_expression (fn_addr, args, nullptr,
+					       Location ());
+}
+
+/**
+ * fn atomic_load_<ordering><T>(src: *const T) -> T;
+ * fn atomic_store_<ordering><T>(dst: *mut T, val: T);
+ * fn atomic_{xchg, xadd, xsub, and, nand, or, xor}_<ordering><T>(dst: *mut T,
+ *   val: T) -> T;
+ * fn atomic_{max, min, umax, umin}_<ordering><T>(dst: *mut T, val: T) -> T;
+ * fn atomic_cxchg{,weak}_<success>_<failure><T>(dst: *mut T, old: T, new: T)
+ *   -> (T, bool);
+ * fn atomic_{fence, singlethreadfence}_<ordering>();
+ */
+static tree
+atomic_handler (Context *ctx, TyTy::FnType *fntype)
+{
+  const std::string &name = fntype->get_identifier ();
+
+  std::vector<std::string> parts;
+  size_t start = strlen ("atomic_");
+  while (start <= name.size ())
+    {
+      size_t end = name.find ('_', start);
+      if (end == std::string::npos)
+	end = name.size ();
+      parts.push_back (name.substr (start, end - start));
+      start = end + 1;
+    }
+
+  const std::string &op = parts.at (0);
+  bool is_fence = op == "fence" || op == "singlethreadfence";
+  bool is_load = op == "load";
+  bool is_store = op == "store";
+  bool is_cxchg = op == "cxchg" || op == "cxchgweak";
+  bool is_minmax = op == "max" || op == "min" || op == "umax" || op == "umin";
+
+  // only a compare-exchange has a second ordering, for its failure
+  memmodel success = MEMMODEL_SEQ_CST;
+  memmodel failure = MEMMODEL_SEQ_CST;
+  bool has_failure = false;
+  bool valid = parts.size () <= 2 || (is_cxchg && parts.size () == 3);
+  for (size_t i = 1; valid && i < parts.size (); i++)
+    {
+      memmodel model;
+      valid = parse_atomic_ordering (parts[i], &model);
+
+      // atomic_cxchg_failrelaxed means seqcst on success
+      bool is_failure
+	= (i == 2 || parts[i].rfind ("fail", 0) == 0) && !has_failure;
+      if (is_failure)
+	{
+	  failure = model;
+	  has_failure = true;
+	}
+      else
+	success = model;
+    }
+  if (!has_failure)
+    failure = atomic_failure_ordering (success);
+  if (has_failure && !is_cxchg)
+    valid = false;
+
+  static const std::map<std::string, built_in_function> rmw_ops
+    = {{"xchg", BUILT_IN_ATOMIC_EXCHANGE_1},
+       {"xadd", BUILT_IN_ATOMIC_FETCH_ADD_1},
+       {"xsub", BUILT_IN_ATOMIC_FETCH_SUB_1},
+       {"and", BUILT_IN_ATOMIC_FETCH_AND_1},
+       {"nand", BUILT_IN_ATOMIC_FETCH_NAND_1},
+       {"or", BUILT_IN_ATOMIC_FETCH_OR_1},
+       {"xor", BUILT_IN_ATOMIC_FETCH_XOR_1}};
+  auto rmw = rmw_ops.find (op);
+
+  if (!valid
+      || (!is_fence && !is_load && !is_store && !is_cxchg && !is_minmax
+	  && rmw == rmw_ops.end ()))
+    {
+      rust_error_at (fntype->get_locus (), "unknown atomic intrinsic: %s",
+		     name.c_str ());
+      return error_mark_node;
+    }
+
+  size_t expected_params = is_fence ? 0 : is_load ? 1 : is_cxchg ? 3 : 2;
+  if (fntype->get_params ().size () != expected_params)
+    {
+      rust_error_at (fntype->get_locus (),
+		     "intrinsic %qs expects %lu parameters, found %lu",
+		     name.c_str (), (unsigned long) expected_params,
+		     (unsigned long) fntype->get_params ().size ());
+      return error_mark_node;
+    }
+
+  tree lookup = NULL_TREE;
+  if (check_for_cached_intrinsic (ctx, fntype, &lookup))
+    return lookup;
+
+  // the builtins come in sizes of 1 to 16 bytes, wider or odd sized types
+  // have no atomic operations
+  tree value_type = NULL_TREE;
+  tree int_type = NULL_TREE;
+  int size_log2 = 0;
+  if (!is_fence)
+    {
+      TyTy::BaseType *ptr_tyty = fntype->get_params ().at (0).second;
+      tree ptr_type = TyTyResolveCompile::compile (ctx, ptr_tyty);
+      if (ptr_type == error_mark_node)
+	return error_mark_node;
+      rust_assert (POINTER_TYPE_P (ptr_type));
+      value_type = TREE_TYPE (ptr_type);
+
+      bool is_scalar = INTEGRAL_TYPE_P (value_type)
+		       || POINTER_TYPE_P (value_type);
+      HOST_WIDE_INT size = int_size_in_bytes (value_type);
+      size_log2 = exact_log2 (size);
+      if (!is_scalar || size_log2 < 0 || size_log2 > 4
+	  || builtin_decl_explicit (
+	       (built_in_function) (BUILT_IN_ATOMIC_LOAD_1 + size_log2))
+	       == NULL_TREE)
+	{
+	  rust_error_at (fntype->get_locus (),
+			 "invalid monomorphization of %qs intrinsic: "
+			 "unsupported type %qs for atomic operations",
+			 name.c_str (), ptr_tyty->as_string ().c_str ());
+	  return error_mark_node;
+	}
+      int_type = build_nonstandard_integer_type (BITS_PER_UNIT * size, 1);
+    }
+
+  auto fndecl = compile_intrinsic_function (ctx, fntype);
+
+  // atomics are all about their side effects
+  TREE_READONLY (fndecl) = 0;
+  TREE_SIDE_EFFECTS (fndecl) = 1;
+
+  std::vector<Bvariable *> param_vars;
+  compile_fn_params (ctx, fntype, fndecl, &param_vars);
+
+  if (!ctx->get_backend ()->function_set_parameters (fndecl, param_vars))
+    return error_mark_node;
+
+  enter_intrinsic_block (ctx, fndecl);
+
+  // BUILTIN atomic_<op> FN BODY BEGIN
+  std::vector<tree> args;
+  for (auto &param : param_vars)
+    args.push_back (ctx->get_backend ()->var_expression (param, Location ()));
+
+  tree result = NULL_TREE;
+  if (is_fence)
+    {
+      auto fence = op == "fence" ? BUILT_IN_ATOMIC_THREAD_FENCE
+				 : BUILT_IN_ATOMIC_SIGNAL_FENCE;
+      ctx->add_statement (
+	atomic_builtin_call (ctx, fence, 0, {atomic_ordering_expr (success)}));
+    }
+  else if (is_load)
+    {
+      tree load = atomic_builtin_call (ctx, BUILT_IN_ATOMIC_LOAD_1, size_log2,
+				       {args[0], atomic_ordering_expr (success)});
+      result = fold_convert (value_type, load);
+    }
+  else if (is_store)
+    {
+      ctx->add_statement (
+	atomic_builtin_call (ctx, BUILT_IN_ATOMIC_STORE_1, size_log2,
+			     {args[0], fold_convert (int_type, args[1]),
+			      atomic_ordering_expr (success)}));
+    }
+  else if (rmw != rmw_ops.end ())
+    {
+      tree old = atomic_builtin_call (ctx, rmw->second, size_log2,
+				      {args[0], fold_convert (int_type, args[1]),
+				       atomic_ordering_expr (success)});
+      result = fold_convert (value_type, old);
+    }
+  else
+    {
+      // compare-exchange and the min/max loops built on it need the current
+      // value in memory for the builtin to update
+      tree enclosing_scope = ctx->peek_enclosing_scope ();
+      tree init = is_cxchg ? fold_convert (int_type, args[1]) : NULL_TREE;
+      if (is_minmax)
+	init = fold_convert (
+	  int_type, atomic_builtin_call (ctx, BUILT_IN_ATOMIC_LOAD_1, size_log2,
+					 {args[0], atomic_ordering_expr (
+						     MEMMODEL_RELAXED)}));
+
+      tree init_stmt = NULL_TREE;
+      Bvariable *expected
+	= ctx->get_backend ()->temporary_variable (fndecl, enclosing_scope,
+						   int_type, init, true,
+						   Location (), &init_stmt);
+      ctx->add_statement (init_stmt);
+
+      tree expected_expr
+	= ctx->get_backend ()->var_expression (expected, Location ());
+      tree expected_addr = build_fold_addr_expr (expected_expr);
+
+      if (is_cxchg)
+	{
+	  tree weak = op == "cxchgweak" ? boolean_true_node : boolean_false_node;
+	  tree exchanged
+	    = atomic_builtin_call (ctx, BUILT_IN_ATOMIC_COMPARE_EXCHANGE_1,
+				   size_log2,
+				   {args[0], expected_addr,
+				    fold_convert (int_type, args[2]), weak,
+				    atomic_ordering_expr (success),
+				    atomic_ordering_expr (failure)});
+
+	  // the result is (old value, whether it was replaced)
+	  tree exchanged_expr = save_expr (exchanged);
+	  tree result_type = TREE_TYPE (DECL_RESULT (fndecl));
+	  tree tuple = ctx->get_backend ()->constructor_expression (
+	    result_type, false,
+	    {fold_convert (value_type, expected_expr), exchanged_expr}, -1,
+	    Location ());
+	  result = build2 (COMPOUND_EXPR, result_type, exchanged_expr, tuple);
+	}
+      else
+	{
+	  // loop { desired = max (expected, val); exit if cas succeeds }
+	  bool is_signed = op == "max" || op == "min";
+	  tree cmp_type
+	    = build_nonstandard_integer_type (TYPE_PRECISION (int_type),
+					      !is_signed);
+	  tree_code cmp_op
+	    = (op == "max" || op == "umax") ? MAX_EXPR : MIN_EXPR;
+	  tree desired
+	    = fold_convert (int_type,
+			    build2 (cmp_op, cmp_type,
+				    fold_convert (cmp_type, expected_expr),
+				    fold_convert (cmp_type, args[1])));
+
+	  tree exchanged
+	    = atomic_builtin_call (ctx, BUILT_IN_ATOMIC_COMPARE_EXCHANGE_1,
+				   size_log2,
+				   {args[0], expected_addr, desired,
+				    boolean_true_node,
+				    atomic_ordering_expr (success),
+				    atomic_ordering_expr (failure)});
+	  tree loop = ctx->get_backend ()->loop_expression (
+	    ctx->get_backend ()->exit_expression (exchanged, Location ()),
+	    Location ());
+	  ctx->add_statement (loop);
+
+	  result = fold_convert (value_type, expected_expr);
+	}
+    }
+
+  if (result != NULL_TREE)
+    {
+      auto return_statement
+	= ctx->get_backend ()->return_statement (fndecl, {result}, Location ());
+      ctx->add_statement (return_statement);
+    }
+  // BUILTIN atomic_<op> FN BODY END
+
+  finalize_intrinsic_block (ctx, fndecl);
+
+  return fndecl;
+}
+
 } // namespace Compile
 } // namespace Rust
@@ -30,6 +30,10 @@ public:
 
   tree compile (TyTy::FnType *fntype);
 
+  // An extern function bound to the target builtin BUILTIN by its
+  // #[link_name], see rust-target-builtins.def.
+  tree compile_target_builtin (TyTy::FnType *fntype, tree builtin);
+
 private:
   Context *ctx;
 };
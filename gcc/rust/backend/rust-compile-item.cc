@@ -20,6 +20,7 @@
 #include "rust-compile-implitem.h"
 #include "rust-compile-expr.h"
 #include "rust-compile-extern.h"
+#include "rust-compile-param-usage.h"
 #include "rust-constexpr.h"
 
 namespace Rust {
@@ -52,21 +53,53 @@ CompileItem::visit (HIR::StaticItem &var)
   HIR::Expr *const_value_expr = var.get_expr ();
   ctx->push_const_context ();
   tree value = compile_constant_item (ctx, resolved_type, canonical_path,
-				      const_value_expr, var.get_locus ());
+				      const_value_expr, var.get_locus (), true);
   ctx->pop_const_context ();
 
+  // a constant over its evaluation budget is left as a call, but there is no
+  // run time initialization of statics to fall back to
+  tree init = value == error_mark_node ? error_mark_node : DECL_INITIAL (value);
+  if (init != error_mark_node && TREE_CODE (init) == CALL_EXPR)
+    {
+      rust_error_at (var.get_locus (),
+		     "static initializer could not be evaluated within "
+		     "%<-frust-const-eval-limit=%wd%>",
+		     flag_rust_const_eval_limit);
+      init = error_mark_node;
+    }
+  else if (init != error_mark_node && !mark_constant_initializer (init))
+    {
+      rust_error_at (var.get_locus (),
+		     "static initializer could not be evaluated at compile "
+		     "time");
+      init = error_mark_node;
+    }
+
   std::string name = canonical_path->get ();
   std::string asm_name = ctx->mangle_item (resolved_type, *canonical_path);
 
   bool is_external = false;
   bool is_hidden = false;
-  bool in_unique_section = true;
+  // the unique section is named when the decl is built, before it is known
+  // to be thread local, so leave the .tdata/.tbss choice to varasm
+  bool is_thread_local
+    = has_thread_local_attribute (var.get_outer_attrs (),
+				  var.get_builtin_attrs ());
+  bool in_unique_section = !is_thread_local;
 
   Bvariable *static_global
     = ctx->get_backend ()->global_variable (name, asm_name, type, is_external,
 					    is_hidden, in_unique_section,
 					    var.get_locus ());
-  ctx->get_backend ()->global_variable_set_init (static_global, value);
+  if (is_thread_local)
+    setup_thread_local_decl (static_global->get_decl ());
+
+  // like rustc, put what nothing can write to in .rodata, which the processes
+  // running the program share
+  if (!var.is_mut () && !has_interior_mutability (ctx, resolved_type))
+    TREE_READONLY (static_global->get_decl ()) = 1;
+
+  ctx->get_backend ()->global_variable_set_init (static_global, init);
 
   ctx->insert_var_decl (var.get_mappings ().get_hirid (), static_global);
   ctx->push_var (static_global);
@@ -120,6 +153,7 @@ CompileItem::visit (HIR::Function &function)
 
   rust_assert (fntype_tyty->get_kind () == TyTy::TypeKind::FNDEF);
   TyTy::FnType *fntype = static_cast<TyTy::FnType *> (fntype_tyty);
+  const TyTy::FnType *generic = fntype;
   if (fntype->has_subsititions_defined ())
     {
       // we cant do anything for this only when it is used and a concrete type
@@ -161,6 +195,33 @@ CompileItem::visit (HIR::Function &function)
 	}
     }
 
+  // an instance differing from one already compiled only in type parameters
+  // the body never looks at would compile to the same function
+  if (flag_rust_polymorphize && fntype->has_subsititions_defined ())
+    {
+      DefId id = fntype->get_id ();
+      const std::vector<bool> *used = ctx->lookup_type_param_usage (id);
+      if (used == nullptr)
+	{
+	  ctx->insert_type_param_usage (
+	    id, TypeParamUsage::analyze (*generic,
+					 *function.get_definition ().get ()));
+	  used = ctx->lookup_type_param_usage (id);
+	}
+
+      tree shared = NULL_TREE;
+      if (std::find (used->begin (), used->end (), false) != used->end ()
+	  && ctx->lookup_shared_instance (fntype, *used, &shared))
+	{
+	  tree dummy = NULL_TREE;
+	  if (!ctx->lookup_function_decl (fntype->get_ty_ref (), &dummy))
+	    ctx->insert_function_decl (fntype, shared);
+
+	  reference = address_expression (shared, ref_locus);
+	  return;
+	}
+    }
+
   if (fntype->has_subsititions_defined ())
     {
       // override the Hir Lookups for the substituions in this context
@@ -175,7 +236,8 @@ CompileItem::visit (HIR::Function &function)
 			function.get_self_param (),
 			function.get_function_params (),
 			function.get_qualifiers (), function.get_visibility (),
-			function.get_outer_attrs (), function.get_locus (),
+			function.get_outer_attrs (),
+			function.get_builtin_attrs (), function.get_locus (),
 			function.get_definition ().get (), canonical_path,
 			fntype, function.has_function_return_type ());
   reference = address_expression (fndecl, ref_locus);
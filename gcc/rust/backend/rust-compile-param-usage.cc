@@ -0,0 +1,644 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-compile-param-usage.h"
+
+namespace Rust {
+namespace Compile {
+
+TypeParamUsage::TypeParamUsage (const TyTy::FnType &fntype)
+  : tyctx (*Resolver::TypeCheckContext::get ())
+{
+  for (const auto &subst : fntype.get_substs ())
+    params.push_back (subst.get_param_ty ()->get_symbol ());
+  used.resize (params.size (), false);
+}
+
+std::vector<bool>
+TypeParamUsage::analyze (const TyTy::FnType &fntype, HIR::BlockExpr &body)
+{
+  TypeParamUsage usage (fntype);
+
+  // the parameters appearing in the signature give the GENERIC function a
+  // different type, so they can never be shared
+  for (const auto &param : fntype.get_params ())
+    usage.type (param.second);
+  usage.type (fntype.get_return_type ());
+
+  if (!usage.all_used ())
+    {
+      usage.type_of (body.get_mappings ().get_hirid ());
+      body.accept_vis (usage);
+    }
+
+  return usage.used;
+}
+
+bool
+TypeParamUsage::all_used () const
+{
+  for (bool u : used)
+    if (!u)
+      return false;
+  return true;
+}
+
+void
+TypeParamUsage::mark_all ()
+{
+  std::fill (used.begin (), used.end (), true);
+}
+
+void
+TypeParamUsage::type_of (HirId id)
+{
+  TyTy::BaseType *ty = nullptr;
+  if (!tyctx.lookup_type (id, &ty))
+    {
+      mark_all ();
+      return;
+    }
+
+  type (ty);
+}
+
+void
+TypeParamUsage::type (const TyTy::BaseType *type)
+{
+  if (!all_used ())
+    type->accept_vis (*this);
+}
+
+void
+TypeParamUsage::arguments (const TyTy::SubstitutionRef &ref)
+{
+  if (!ref.has_substitutions ())
+    return;
+
+  TyTy::SubstitutionArgumentMappings args = ref.get_used_arguments ();
+  if (args.is_error ())
+    {
+      mark_all ();
+      return;
+    }
+
+  for (const auto &arg : args.get_mappings ())
+    {
+      if (arg.is_error ())
+	{
+	  mark_all ();
+	  return;
+	}
+      type (arg.get_tyty ());
+    }
+}
+
+void
+TypeParamUsage::expr (HIR::Expr *expr)
+{
+  if (all_used ())
+    return;
+
+  type_of (expr->get_mappings ().get_hirid ());
+  expr->accept_vis (*this);
+}
+
+void
+TypeParamUsage::pattern (HIR::Pattern *pattern)
+{
+  // patterns only have a type when they bind, any other pattern is checked
+  // against the type of the expression it matches
+  TyTy::BaseType *ty = nullptr;
+  if (tyctx.lookup_type (pattern->get_pattern_mappings ().get_hirid (), &ty))
+    type (ty);
+}
+
+void
+TypeParamUsage::visit (HIR::PathInExpression &path)
+{
+  // T::item and Self::item are resolved against the substituted type
+  const auto &segments = path.get_segments ();
+  if (segments.size () < 2)
+    return;
+
+  const std::string &first = segments.front ().get_segment ().as_string ();
+  if (first == "Self")
+    {
+      mark_all ();
+      return;
+    }
+
+  for (size_t i = 0; i < params.size (); i++)
+    if (params[i] == first)
+      used[i] = true;
+}
+
+void
+TypeParamUsage::visit (HIR::QualifiedPathInExpression &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::BorrowExpr &expr)
+{
+  this->expr (expr.get_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::DereferenceExpr &expr)
+{
+  this->expr (expr.get_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::ErrorPropagationExpr &expr)
+{
+  this->expr (expr.get_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::NegationExpr &expr)
+{
+  this->expr (expr.get_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::ArithmeticOrLogicalExpr &expr)
+{
+  this->expr (expr.get_lhs ());
+  this->expr (expr.get_rhs ());
+}
+
+void
+TypeParamUsage::visit (HIR::ComparisonExpr &expr)
+{
+  this->expr (expr.get_lhs ());
+  this->expr (expr.get_rhs ());
+}
+
+void
+TypeParamUsage::visit (HIR::LazyBooleanExpr &expr)
+{
+  this->expr (expr.get_lhs ());
+  this->expr (expr.get_rhs ());
+}
+
+void
+TypeParamUsage::visit (HIR::TypeCastExpr &expr)
+{
+  this->expr (expr.get_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::AssignmentExpr &expr)
+{
+  this->expr (expr.get_lhs ());
+  this->expr (expr.get_rhs ());
+}
+
+void
+TypeParamUsage::visit (HIR::CompoundAssignmentExpr &expr)
+{
+  this->expr (expr.get_left_expr ().get ());
+  this->expr (expr.get_right_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::GroupedExpr &expr)
+{
+  this->expr (expr.get_expr_in_parens ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::ArrayElemsValues &elems)
+{
+  for (auto &elem : elems.get_values ())
+    expr (elem.get ());
+}
+
+void
+TypeParamUsage::visit (HIR::ArrayElemsCopied &elems)
+{
+  expr (elems.get_elem_to_copy ());
+  expr (elems.get_num_copies_expr ());
+}
+
+void
+TypeParamUsage::visit (HIR::ArrayExpr &expr)
+{
+  expr.get_internal_elements ()->accept_vis (*this);
+}
+
+void
+TypeParamUsage::visit (HIR::ArrayIndexExpr &expr)
+{
+  this->expr (expr.get_array_expr ());
+  this->expr (expr.get_index_expr ());
+}
+
+void
+TypeParamUsage::visit (HIR::TupleExpr &expr)
+{
+  for (auto &elem : expr.get_tuple_elems ())
+    this->expr (elem.get ());
+}
+
+void
+TypeParamUsage::visit (HIR::TupleIndexExpr &expr)
+{
+  this->expr (expr.get_tuple_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::StructExprFieldIdentifier &)
+{}
+
+void
+TypeParamUsage::visit (HIR::StructExprFieldIdentifierValue &field)
+{
+  expr (field.get_value ());
+}
+
+void
+TypeParamUsage::visit (HIR::StructExprFieldIndexValue &field)
+{
+  expr (field.get_value ());
+}
+
+void
+TypeParamUsage::visit (HIR::StructExprStructFields &expr)
+{
+  for (auto &field : expr.get_fields ())
+    field->accept_vis (*this);
+
+  if (expr.has_struct_base ())
+    this->expr (expr.struct_base->get_base ());
+}
+
+void
+TypeParamUsage::visit (HIR::StructExprStructBase &expr)
+{
+  this->expr (expr.get_struct_base ()->get_base ());
+}
+
+void
+TypeParamUsage::visit (HIR::CallExpr &expr)
+{
+  this->expr (expr.get_fnexpr ());
+  for (auto &arg : expr.get_arguments ())
+    this->expr (arg.get ());
+}
+
+void
+TypeParamUsage::visit (HIR::MethodCallExpr &expr)
+{
+  // the method is resolved from the receiver, and its own type holds the
+  // substitutions it is called with
+  type_of (expr.get_method_name ().get_mappings ().get_hirid ());
+
+  TyTy::BaseType *receiver = nullptr;
+  if (tyctx.lookup_receiver (expr.get_mappings ().get_hirid (), &receiver))
+    type (receiver);
+
+  this->expr (expr.get_receiver ().get ());
+  for (auto &arg : expr.get_arguments ())
+    this->expr (arg.get ());
+}
+
+void
+TypeParamUsage::visit (HIR::FieldAccessExpr &expr)
+{
+  this->expr (expr.get_receiver_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::ClosureExprInner &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::BlockExpr &expr)
+{
+  for (auto &stmt : expr.get_statements ())
+    stmt->accept_vis (*this);
+
+  if (expr.has_expr ())
+    this->expr (expr.get_final_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::ClosureExprInnerTyped &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::BreakExpr &expr)
+{
+  if (expr.has_break_expr ())
+    this->expr (expr.get_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::RangeFromToExpr &expr)
+{
+  this->expr (expr.get_from_expr ().get ());
+  this->expr (expr.get_to_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::RangeFromExpr &expr)
+{
+  this->expr (expr.get_from_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::RangeToExpr &expr)
+{
+  this->expr (expr.get_to_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::RangeFromToInclExpr &expr)
+{
+  this->expr (expr.get_from_expr ().get ());
+  this->expr (expr.get_to_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::RangeToInclExpr &expr)
+{
+  this->expr (expr.get_to_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::ReturnExpr &expr)
+{
+  if (expr.has_return_expr ())
+    this->expr (expr.get_expr ());
+}
+
+void
+TypeParamUsage::visit (HIR::UnsafeBlockExpr &expr)
+{
+  this->expr (expr.get_block_expr ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::LoopExpr &expr)
+{
+  this->expr (expr.get_loop_block ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::WhileLoopExpr &expr)
+{
+  this->expr (expr.get_predicate_expr ().get ());
+  this->expr (expr.get_loop_block ().get ());
+}
+
+void
+TypeParamUsage::visit (HIR::WhileLetLoopExpr &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::ForLoopExpr &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::IfExpr &expr)
+{
+  this->expr (expr.get_if_condition ());
+  this->expr (expr.get_if_block ());
+}
+
+void
+TypeParamUsage::visit (HIR::IfExprConseqElse &expr)
+{
+  this->expr (expr.get_if_condition ());
+  this->expr (expr.get_if_block ());
+  this->expr (expr.get_else_block ());
+}
+
+void
+TypeParamUsage::visit (HIR::IfExprConseqIf &expr)
+{
+  this->expr (expr.get_if_condition ());
+  this->expr (expr.get_if_block ());
+  this->expr (expr.get_conseq_if_expr ());
+}
+
+void
+TypeParamUsage::visit (HIR::IfExprConseqIfLet &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::IfLetExpr &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::IfLetExprConseqElse &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::IfLetExprConseqIf &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::IfLetExprConseqIfLet &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::MatchExpr &expr)
+{
+  this->expr (expr.get_scrutinee_expr ().get ());
+
+  for (auto &match_case : expr.get_match_cases ())
+    {
+      HIR::MatchArm &arm = match_case.get_arm ();
+      for (auto &pat : arm.get_patterns ())
+	pattern (pat.get ());
+      if (arm.has_match_arm_guard ())
+	this->expr (arm.get_guard_expr ().get ());
+
+      this->expr (match_case.get_expr ().get ());
+    }
+}
+
+void
+TypeParamUsage::visit (HIR::AwaitExpr &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::AsyncBlockExpr &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (HIR::LetStmt &stmt)
+{
+  pattern (stmt.get_pattern ());
+  if (stmt.has_init_expr ())
+    expr (stmt.get_init_expr ());
+}
+
+void
+TypeParamUsage::visit (HIR::ExprStmtWithoutBlock &stmt)
+{
+  expr (stmt.get_expr ());
+}
+
+void
+TypeParamUsage::visit (HIR::ExprStmtWithBlock &stmt)
+{
+  expr (stmt.get_expr ());
+}
+
+void
+TypeParamUsage::visit (const TyTy::InferType &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (const TyTy::ADTType &type)
+{
+  // the fields are written in terms of the ADT's own parameters, what this
+  // use depends on is what they are substituted with
+  arguments (type);
+}
+
+void
+TypeParamUsage::visit (const TyTy::TupleType &type)
+{
+  for (size_t i = 0; i < type.num_fields (); i++)
+    this->type (type.get_field (i));
+}
+
+void
+TypeParamUsage::visit (const TyTy::FnType &type)
+{
+  arguments (type);
+  for (const auto &param : type.get_params ())
+    this->type (param.second);
+  this->type (type.get_return_type ());
+}
+
+void
+TypeParamUsage::visit (const TyTy::FnPtr &type)
+{
+  for (size_t i = 0; i < type.num_params (); i++)
+    this->type (type.param_at (i));
+  this->type (type.get_return_type ());
+}
+
+void
+TypeParamUsage::visit (const TyTy::ArrayType &type)
+{
+  this->type (type.get_element_type ());
+}
+
+void
+TypeParamUsage::visit (const TyTy::SliceType &type)
+{
+  this->type (type.get_element_type ());
+}
+
+void
+TypeParamUsage::visit (const TyTy::ErrorType &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (const TyTy::ReferenceType &type)
+{
+  this->type (type.get_base ());
+}
+
+void
+TypeParamUsage::visit (const TyTy::PointerType &type)
+{
+  this->type (type.get_base ());
+}
+
+void
+TypeParamUsage::visit (const TyTy::ParamType &type)
+{
+  for (size_t i = 0; i < params.size (); i++)
+    {
+      if (params[i] == type.get_symbol ())
+	{
+	  used[i] = true;
+	  return;
+	}
+    }
+
+  if (type.can_resolve ())
+    {
+      const TyTy::BaseType *resolved = type.resolve ();
+      if (resolved != &type)
+	this->type (resolved);
+    }
+}
+
+void
+TypeParamUsage::visit (const TyTy::PlaceholderType &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (const TyTy::ProjectionType &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (const TyTy::DynamicObjectType &)
+{
+  mark_all ();
+}
+
+void
+TypeParamUsage::visit (const TyTy::ClosureType &)
+{
+  mark_all ();
+}
+
+} // namespace Compile
+} // namespace Rust
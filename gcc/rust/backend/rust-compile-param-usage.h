@@ -0,0 +1,151 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_COMPILE_PARAM_USAGE
+#define RUST_COMPILE_PARAM_USAGE
+
+#include "rust-hir-visitor.h"
+#include "rust-hir-full.h"
+#include "rust-hir-type-check.h"
+#include "rust-tyty-visitor.h"
+
+namespace Rust {
+namespace Compile {
+
+/* Finds which type parameters of a generic function its instances depend on.
+ * A parameter is used when it appears in the signature, in the type of any
+ * expression, pattern or local of the body, or names an associated item in a
+ * path such as T::CONST. Instances which only differ in the unused parameters
+ * compile to the same GENERIC, so they can share a single function.
+ *
+ * Anything the walk cannot see through, such as closures, projections or
+ * trait objects, marks every parameter as used. */
+class TypeParamUsage : public HIR::HIRFullVisitorBase,
+		       public TyTy::TyConstVisitor
+{
+public:
+  static std::vector<bool> analyze (const TyTy::FnType &fntype,
+				    HIR::BlockExpr &body);
+
+private:
+  TypeParamUsage (const TyTy::FnType &fntype);
+
+  bool all_used () const;
+  void mark_all ();
+
+  void type_of (HirId id);
+  void type (const TyTy::BaseType *type);
+  void arguments (const TyTy::SubstitutionRef &ref);
+  void expr (HIR::Expr *expr);
+  void pattern (HIR::Pattern *pattern);
+
+  using HIR::HIRFullVisitorBase::visit;
+
+  void visit (HIR::PathInExpression &path) override;
+  void visit (HIR::QualifiedPathInExpression &path) override;
+  void visit (HIR::BorrowExpr &expr) override;
+  void visit (HIR::DereferenceExpr &expr) override;
+  void visit (HIR::ErrorPropagationExpr &expr) override;
+  void visit (HIR::NegationExpr &expr) override;
+  void visit (HIR::ArithmeticOrLogicalExpr &expr) override;
+  void visit (HIR::ComparisonExpr &expr) override;
+  void visit (HIR::LazyBooleanExpr &expr) override;
+  void visit (HIR::TypeCastExpr &expr) override;
+  void visit (HIR::AssignmentExpr &expr) override;
+  void visit (HIR::CompoundAssignmentExpr &expr) override;
+  void visit (HIR::GroupedExpr &expr) override;
+  void visit (HIR::ArrayElemsValues &elems) override;
+  void visit (HIR::ArrayElemsCopied &elems) override;
+  void visit (HIR::ArrayExpr &expr) override;
+  void visit (HIR::ArrayIndexExpr &expr) override;
+  void visit (HIR::TupleExpr &expr) override;
+  void visit (HIR::TupleIndexExpr &expr) override;
+  void visit (HIR::StructExprFieldIdentifier &field) override;
+  void visit (HIR::StructExprFieldIdentifierValue &field) override;
+  void visit (HIR::StructExprFieldIndexValue &field) override;
+  void visit (HIR::StructExprStructFields &expr) override;
+  void visit (HIR::StructExprStructBase &expr) override;
+  void visit (HIR::CallExpr &expr) override;
+  void visit (HIR::MethodCallExpr &expr) override;
+  void visit (HIR::FieldAccessExpr &expr) override;
+  void visit (HIR::ClosureExprInner &expr) override;
+  void visit (HIR::BlockExpr &expr) override;
+  void visit (HIR::ClosureExprInnerTyped &expr) override;
+  void visit (HIR::BreakExpr &expr) override;
+  void visit (HIR::RangeFromToExpr &expr) override;
+  void visit (HIR::RangeFromExpr &expr) override;
+  void visit (HIR::RangeToExpr &expr) override;
+  void visit (HIR::RangeFromToInclExpr &expr) override;
+  void visit (HIR::RangeToInclExpr &expr) override;
+  void visit (HIR::ReturnExpr &expr) override;
+  void visit (HIR::UnsafeBlockExpr &expr) override;
+  void visit (HIR::LoopExpr &expr) override;
+  void visit (HIR::WhileLoopExpr &expr) override;
+  void visit (HIR::WhileLetLoopExpr &expr) override;
+  void visit (HIR::ForLoopExpr &expr) override;
+  void visit (HIR::IfExpr &expr) override;
+  void visit (HIR::IfExprConseqElse &expr) override;
+  void visit (HIR::IfExprConseqIf &expr) override;
+  void visit (HIR::IfExprConseqIfLet &expr) override;
+  void visit (HIR::IfLetExpr &expr) override;
+  void visit (HIR::IfLetExprConseqElse &expr) override;
+  void visit (HIR::IfLetExprConseqIf &expr) override;
+  void visit (HIR::IfLetExprConseqIfLet &expr) override;
+  void visit (HIR::MatchExpr &expr) override;
+  void visit (HIR::AwaitExpr &expr) override;
+  void visit (HIR::AsyncBlockExpr &expr) override;
+  void visit (HIR::LetStmt &stmt) override;
+  void visit (HIR::ExprStmtWithoutBlock &stmt) override;
+  void visit (HIR::ExprStmtWithBlock &stmt) override;
+
+  void visit (const TyTy::InferType &type) override;
+  void visit (const TyTy::ADTType &type) override;
+  void visit (const TyTy::TupleType &type) override;
+  void visit (const TyTy::FnType &type) override;
+  void visit (const TyTy::FnPtr &type) override;
+  void visit (const TyTy::ArrayType &type) override;
+  void visit (const TyTy::SliceType &type) override;
+  void visit (const TyTy::BoolType &) override {}
+  void visit (const TyTy::IntType &) override {}
+  void visit (const TyTy::UintType &) override {}
+  void visit (const TyTy::FloatType &) override {}
+  void visit (const TyTy::USizeType &) override {}
+  void visit (const TyTy::ISizeType &) override {}
+  void visit (const TyTy::ErrorType &type) override;
+  void visit (const TyTy::CharType &) override {}
+  void visit (const TyTy::ReferenceType &type) override;
+  void visit (const TyTy::PointerType &type) override;
+  void visit (const TyTy::ParamType &type) override;
+  void visit (const TyTy::StrType &) override {}
+  void visit (const TyTy::NeverType &) override {}
+  void visit (const TyTy::PlaceholderType &type) override;
+  void visit (const TyTy::ProjectionType &type) override;
+  void visit (const TyTy::DynamicObjectType &type) override;
+  void visit (const TyTy::ClosureType &type) override;
+
+  // the symbols of the type parameters, and which of them are used
+  std::vector<std::string> params;
+  std::vector<bool> used;
+
+  Resolver::TypeCheckContext &tyctx;
+};
+
+} // namespace Compile
+} // namespace Rust
+
+#endif // RUST_COMPILE_PARAM_USAGE
@@ -46,16 +46,12 @@ CompilePatternCaseLabelExpr::visit (HIR::PathInExpression &pattern)
   rust_assert (ok);
 
   TyTy::VariantDef *variant = nullptr;
-  ok = adt->lookup_variant_by_id (variant_id, &variant);
+  int variant_index = 0;
+  ok = adt->lookup_variant_by_id (variant_id, &variant, &variant_index);
   rust_assert (ok);
 
-  HIR::Expr *discrim_expr = variant->get_discriminant ();
-  tree discrim_expr_node = CompileExpr::Compile (discrim_expr, ctx);
-  tree folded_discrim_expr = fold_expr (discrim_expr_node);
-  tree case_low = folded_discrim_expr;
-
   case_label_expr
-    = build_case_label (case_low, NULL_TREE, associated_case_label);
+    = enum_variant_case_label (adt, variant_index, associated_case_label);
 }
 
 void
@@ -211,17 +207,12 @@ CompilePatternBindings::visit (HIR::TupleStructPattern &pattern)
 
 	if (adt->is_enum ())
 	  {
-	    // we are offsetting by + 1 here since the first field in the record
-	    // is always the discriminator
-	    size_t tuple_field_index = 1;
+	    size_t tuple_field_index = 0;
 	    for (auto &pattern : items_no_range.get_patterns ())
 	      {
-		tree variant_accessor
-		  = ctx->get_backend ()->struct_field_expression (
-		    match_scrutinee_expr, variant_index, pattern->get_locus ());
-
-		tree binding = ctx->get_backend ()->struct_field_expression (
-		  variant_accessor, tuple_field_index++, pattern->get_locus ());
+		tree binding = enum_variant_field_expression (
+		  adt, match_scrutinee_expr, variant_index, tuple_field_index++,
+		  pattern->get_locus ());
 
 		ctx->insert_pattern_binding (
 		  pattern->get_pattern_mappings ().get_hirid (), binding);
@@ -305,14 +296,10 @@ CompilePatternBindings::visit (HIR::StructPattern &pattern)
 	    tree binding = error_mark_node;
 	    if (adt->is_enum ())
 	      {
-		tree variant_accessor
-		  = ctx->get_backend ()->struct_field_expression (
-		    match_scrutinee_expr, variant_index, ident.get_locus ());
-
-		// we are offsetting by + 1 here since the first field in the
-		// record is always the discriminator
-		binding = ctx->get_backend ()->struct_field_expression (
-		  variant_accessor, offs + 1, ident.get_locus ());
+		binding
+		  = enum_variant_field_expression (adt, match_scrutinee_expr,
+						   variant_index, offs,
+						   ident.get_locus ());
 	      }
 	    else
 	      {
@@ -95,15 +95,8 @@ ResolvePathRef::resolve (const HIR::PathIdentSegment &final_segment,
       tree compiled_adt_type = TyTyResolveCompile::compile (ctx, adt);
 
       // make the ctor for the union
-      HIR::Expr *discrim_expr = variant->get_discriminant ();
-      tree discrim_expr_node = CompileExpr::Compile (discrim_expr, ctx);
-      tree folded_discrim_expr = fold_expr (discrim_expr_node);
-      tree qualifier = folded_discrim_expr;
-
-      return ctx->get_backend ()->constructor_expression (compiled_adt_type,
-							  true, {qualifier},
-							  union_disriminator,
-							  expr_locus);
+      return enum_variant_constructor (adt, compiled_adt_type, variant,
+				       union_disriminator, {}, expr_locus);
     }
 
   HirId ref;
@@ -118,7 +111,7 @@ ResolvePathRef::resolve (const HIR::PathIdentSegment &final_segment,
   if (ctx->lookup_const_decl (ref, &constant_expr))
     {
       TREE_USED (constant_expr) = 1;
-      return constant_expr;
+      return constant_use (constant_expr);
     }
 
   // this might be a variable reference or a function reference
@@ -163,7 +156,7 @@ ResolvePathRef::resolve (const HIR::PathIdentSegment &final_segment,
     {
       TREE_USED (resolved_item) = 1;
     }
-  return resolved_item;
+  return constant_use (resolved_item);
 }
 
 tree
@@ -297,5 +290,37 @@ HIRCompileBase::query_compile (HirId ref, TyTy::BaseType *lookup,
   return error_mark_node;
 }
 
+void
+HIRCompileBase::mark_retained_uses (HirId id)
+{
+  const std::vector<HirId> *uses
+    = ctx->get_mappings ()->lookup_retained_uses (id);
+  if (uses == nullptr)
+    return;
+
+  for (HirId ref : *uses)
+    {
+      tree decl = NULL_TREE;
+      Bvariable *var = nullptr;
+      if (ctx->lookup_const_decl (ref, &decl)
+	  || ctx->lookup_pattern_binding (ref, &decl))
+	TREE_USED (decl) = 1;
+      else if (ctx->lookup_var_decl (ref, &var))
+	var->get_tree (Location ());
+      else
+	{
+	  // a constant which has not been compiled yet
+	  HIR::Item *item = ctx->get_mappings ()->lookup_hir_item (ref);
+	  if (item == nullptr
+	      || item->get_item_kind () != HIR::Item::ItemKind::Constant)
+	    continue;
+
+	  decl = CompileItem::compile (item, ctx, nullptr, true);
+	  if (decl != error_mark_node)
+	    TREE_USED (decl) = 1;
+	}
+    }
+}
+
 } // namespace Compile
 } // namespace Rust
@@ -17,6 +17,7 @@
 // <http://www.gnu.org/licenses/>.
 
 #include "rust-compile-type.h"
+#include "rust-compile-abi.h"
 #include "rust-compile-expr.h"
 #include "rust-constexpr.h"
 
@@ -26,6 +27,7 @@ namespace Rust {
 namespace Compile {
 
 static const std::string RUST_ENUM_DISR_FIELD_NAME = "RUST$ENUM$DISR";
+static const std::string RUST_ENUM_NICHE_FIELD_NAME = "RUST$ENUM$NICHE";
 
 TyTyResolveCompile::TyTyResolveCompile (Context *ctx, bool trait_object_mode)
   : ctx (ctx), trait_object_mode (trait_object_mode),
@@ -84,6 +86,87 @@ TyTyResolveCompile::get_implicit_enumeral_node_type (Context *ctx)
   return enum_node;
 }
 
+bool
+TyTyResolveCompile::get_enum_niche (const TyTy::ADTType &type,
+				    EnumNiche *niche)
+{
+  if (!type.is_enum () || type.number_of_variants () < 2)
+    return false;
+
+  // the layout is only ours to choose without a repr
+  TyTy::ADTType::ReprOptions repr = type.get_repr_options ();
+  if (repr.is_c || repr.pack || repr.align)
+    return false;
+
+  int dataful = -1;
+  for (size_t i = 0; i < type.number_of_variants (); i++)
+    {
+      if (type.get_variants ().at (i)->num_fields () == 0)
+	continue;
+      if (dataful != -1)
+	return false;
+      dataful = i;
+    }
+  if (dataful == -1)
+    return false;
+
+  TyTy::VariantDef *variant = type.get_variants ().at (dataful);
+  const TyTy::BaseType *field
+    = variant->get_field_at_index (0)->get_field_type ()->destructure ();
+
+  // how many invalid values the field has, starting from START, and the
+  // range of valid ones
+  unsigned HOST_WIDE_INT start = 0, count = 0;
+  unsigned HOST_WIDE_INT valid_start = 0, valid_end = HOST_WIDE_INT_M1U;
+  switch (field->get_kind ())
+    {
+      case TyTy::TypeKind::REF: {
+	// only thin references, fat ones are records
+	auto ref = static_cast<const TyTy::ReferenceType *> (field);
+	auto base = ref->get_base ()->destructure ()->get_kind ();
+	if (base == TyTy::TypeKind::SLICE || base == TyTy::TypeKind::STR
+	    || base == TyTy::TypeKind::DYNAMIC)
+	  return false;
+	count = 1;
+	valid_start = 1;
+      }
+      break;
+
+    case TyTy::TypeKind::FNPTR:
+      count = 1;
+      valid_start = 1;
+      break;
+
+    case TyTy::TypeKind::BOOL:
+      start = 2;
+      count = 254;
+      valid_end = 1;
+      break;
+
+    case TyTy::TypeKind::CHAR:
+      start = 0x110000;
+      count = 0xffffffff - 0x110000;
+      valid_end = 0x10ffff;
+      break;
+
+    default:
+      return false;
+    }
+
+  if (type.number_of_variants () - 1 > count)
+    return false;
+
+  if (niche != nullptr)
+    {
+      niche->dataful_variant = dataful;
+      niche->niche_field = type.number_of_variants ();
+      niche->niche_start = start;
+      niche->valid_start = valid_start;
+      niche->valid_end = valid_end;
+    }
+  return true;
+}
+
 void
 TyTyResolveCompile::visit (const TyTy::ErrorType &)
 {
@@ -140,17 +223,22 @@ TyTyResolveCompile::visit (const TyTy::FnType &type)
   if (!type.get_return_type ()->is_unit ())
     {
       auto hir_type = type.get_return_type ();
-      auto ret = TyTyResolveCompile::compile (ctx, hir_type, trait_object_mode);
+      auto ret = TyTyResolveCompile::compile (ctx, hir_type);
       results.push_back (Backend::typed_identifier (
 	"_", ret,
 	ctx->get_mappings ()->lookup_location (hir_type->get_ref ())));
     }
 
+  // in trait object mode only the receiver is the erased object, the result
+  // and the other parameters are passed as they are
+  bool is_receiver = type.is_method ();
   for (auto &param_pair : type.get_params ())
     {
       auto param_tyty = param_pair.second;
       auto compiled_param_type
-	= TyTyResolveCompile::compile (ctx, param_tyty, trait_object_mode);
+	= TyTyResolveCompile::compile (ctx, param_tyty,
+				       trait_object_mode && is_receiver);
+      is_receiver = false;
 
       auto compiled_param = Backend::typed_identifier (
 	param_pair.first->as_string (), compiled_param_type,
@@ -168,6 +256,10 @@ TyTyResolveCompile::visit (const TyTy::FnType &type)
       = ctx->get_backend ()->function_type_varadic (receiver, parameters,
 						    results, NULL,
 						    type.get_ident ().locus);
+
+  if (type.get_abi () == ABI::RUST && translated != error_mark_node)
+    translated = build_pointer_type (
+      AbiLowering::rust_function_type (TREE_TYPE (translated)));
 }
 
 void
@@ -186,6 +278,12 @@ TyTyResolveCompile::visit (const TyTy::FnPtr &type)
 
   translated = ctx->get_backend ()->function_ptr_type (result_type, parameters,
 						       type.get_ident ().locus);
+
+  // only Rust functions have their scalar pair parameters split, an extern fn
+  // pointer keeps the C calling convention of what it points to
+  if (type.get_abi () == ABI::RUST && translated != error_mark_node)
+    translated = build_pointer_type (
+      AbiLowering::rust_function_type (TREE_TYPE (translated)));
 }
 
 void
@@ -210,9 +308,17 @@ TyTyResolveCompile::visit (const TyTy::ADTType &type)
 	  fields.push_back (std::move (f));
 	}
 
-      type_record = type.is_union ()
-		      ? ctx->get_backend ()->union_type (fields)
-		      : ctx->get_backend ()->struct_type (fields);
+      // without a repr the field order is ours to pick, so let the backend
+      // sort out the padding
+      TyTy::ADTType::ReprOptions repr = type.get_repr_options ();
+      if (repr.is_simd && !type.is_union ())
+	type_record = compile_simd_type (type, fields);
+      else if (type.is_union ())
+	type_record = ctx->get_backend ()->union_type (fields);
+      else if (repr.is_c || repr.pack)
+	type_record = ctx->get_backend ()->struct_type (fields);
+      else
+	type_record = ctx->get_backend ()->reordered_struct_type (fields);
     }
   else
     {
@@ -241,18 +347,28 @@ TyTyResolveCompile::visit (const TyTy::ADTType &type)
       // I ran into some issues lets reuse our normal union and ask Ada people
       // about it.
 
+      // Enums with a niche (see EnumNiche) leave RUST$ENUM$DISR out of every
+      // variant and instead end the union with an integer the size of the
+      // field holding the niche.
+
+      EnumNiche niche;
+      bool has_niche = get_enum_niche (type, &niche);
+
       std::vector<tree> variant_records;
       for (auto &variant : type.get_variants ())
 	{
 	  std::vector<Backend::typed_identifier> fields;
 
 	  // add in the qualifier field for the variant
-	  tree enumeral_type
-	    = TyTyResolveCompile::get_implicit_enumeral_node_type (ctx);
-	  Backend::typed_identifier f (RUST_ENUM_DISR_FIELD_NAME, enumeral_type,
-				       ctx->get_mappings ()->lookup_location (
-					 variant->get_id ()));
-	  fields.push_back (std::move (f));
+	  if (!has_niche)
+	    {
+	      tree enumeral_type
+		= TyTyResolveCompile::get_implicit_enumeral_node_type (ctx);
+	      Backend::typed_identifier f (
+		RUST_ENUM_DISR_FIELD_NAME, enumeral_type,
+		ctx->get_mappings ()->lookup_location (variant->get_id ()));
+	      fields.push_back (std::move (f));
+	    }
 
 	  // compile the rest of the fields
 	  for (size_t i = 0; i < variant->num_fields (); i++)
@@ -279,7 +395,8 @@ TyTyResolveCompile::visit (const TyTy::ADTType &type)
 	    variant->get_ident ().locus);
 
 	  // set the qualifier to be a builtin
-	  DECL_ARTIFICIAL (TYPE_FIELDS (variant_record)) = 1;
+	  if (!has_niche)
+	    DECL_ARTIFICIAL (TYPE_FIELDS (variant_record)) = 1;
 
 	  // add them to the list
 	  variant_records.push_back (named_variant_record);
@@ -301,8 +418,28 @@ TyTyResolveCompile::visit (const TyTy::ADTType &type)
 	  enum_fields.push_back (std::move (f));
 	}
 
+      if (has_niche)
+	{
+	  tree dataful_record = variant_records.at (niche.dataful_variant);
+	  tree niche_field_type = TREE_TYPE (TYPE_FIELDS (dataful_record));
+	  tree niche_type = ctx->get_backend ()->integer_type (
+	    true, TREE_INT_CST_LOW (TYPE_SIZE (niche_field_type)));
+
+	  Backend::typed_identifier f (RUST_ENUM_NICHE_FIELD_NAME, niche_type,
+				       ctx->get_mappings ()->lookup_location (
+					 type.get_ty_ref ()));
+	  enum_fields.push_back (std::move (f));
+	}
+
       // finally make the union or the enum
       type_record = ctx->get_backend ()->union_type (enum_fields);
+      if (has_niche)
+	{
+	  tree field = TYPE_FIELDS (type_record);
+	  while (DECL_CHAIN (field) != NULL_TREE)
+	    field = DECL_CHAIN (field);
+	  DECL_ARTIFICIAL (field) = 1;
+	}
     }
 
   // Handle repr options
@@ -329,6 +466,7 @@ TyTyResolveCompile::visit (const TyTy::ADTType &type)
     = type.get_ident ().path.get () + type.subst_as_string ();
   translated = ctx->get_backend ()->named_type (named_struct_str, type_record,
 						type.get_ident ().locus);
+  ctx->insert_compiled_adt (named_struct_str, translated, type.is_enum ());
 }
 
 void
@@ -371,11 +509,18 @@ TyTyResolveCompile::visit (const TyTy::ArrayType &type)
   tree element_type
     = TyTyResolveCompile::compile (ctx, type.get_element_type ());
 
-  ctx->push_const_context ();
-  tree capacity_expr = CompileExpr::Compile (&type.get_capacity_expr (), ctx);
-  ctx->pop_const_context ();
+  HIR::Expr &capacity = type.get_capacity_expr ();
+  HirId capacity_id = capacity.get_mappings ().get_hirid ();
+  tree folded_capacity_expr = NULL_TREE;
+  if (!ctx->lookup_const_value (capacity_id, "", &folded_capacity_expr))
+    {
+      ctx->push_const_context ();
+      tree capacity_expr = CompileExpr::Compile (&capacity, ctx);
+      ctx->pop_const_context ();
 
-  tree folded_capacity_expr = fold_expr (capacity_expr);
+      folded_capacity_expr = fold_expr (capacity_expr);
+      ctx->insert_const_value (capacity_id, "", folded_capacity_expr);
+    }
 
   translated
     = ctx->get_backend ()->array_type (element_type, folded_capacity_expr);
@@ -556,6 +701,15 @@ TyTyResolveCompile::visit (const TyTy::ReferenceType &type)
       return;
     }
 
+  // like slices, the trait object is already the fat pointer
+  bool is_trait_object
+    = type.get_base ()->destructure ()->get_kind () == TyTy::TypeKind::DYNAMIC;
+  if (is_trait_object && !trait_object_mode)
+    {
+      translated = TyTyResolveCompile::compile (ctx, type.get_base ());
+      return;
+    }
+
   tree base_compiled_type
     = TyTyResolveCompile::compile (ctx, type.get_base (), trait_object_mode);
   if (type.is_mutable ())
@@ -600,6 +754,14 @@ TyTyResolveCompile::visit (const TyTy::PointerType &type)
       return;
     }
 
+  bool is_trait_object
+    = type.get_base ()->destructure ()->get_kind () == TyTy::TypeKind::DYNAMIC;
+  if (is_trait_object && !trait_object_mode)
+    {
+      translated = TyTyResolveCompile::compile (ctx, type.get_base ());
+      return;
+    }
+
   tree base_compiled_type
     = TyTyResolveCompile::compile (ctx, type.get_base (), trait_object_mode);
   if (type.is_mutable ())
@@ -638,7 +800,8 @@ TyTyResolveCompile::visit (const TyTy::DynamicObjectType &type)
       return;
     }
 
-  // create implicit struct
+  // create implicit struct, a fat pointer to the object and to the read-only
+  // vtable shared by every trait object of the same concrete type
   auto items = type.get_object_items ();
   std::vector<Backend::typed_identifier> fields;
 
@@ -653,12 +816,15 @@ TyTyResolveCompile::visit (const TyTy::DynamicObjectType &type)
 
   tree vtable_size = build_int_cst (size_type_node, items.size ());
   tree vtable_type = ctx->get_backend ()->array_type (uintptr_ty, vtable_size);
-  Backend::typed_identifier vtf ("vtable", vtable_type,
+  tree vtable_ptr_type
+    = build_pointer_type (build_qualified_type (vtable_type, TYPE_QUAL_CONST));
+  Backend::typed_identifier vtf ("vtable", vtable_ptr_type,
 				 ctx->get_mappings ()->lookup_location (
 				   type.get_ty_ref ()));
   fields.push_back (std::move (vtf));
 
   tree type_record = ctx->get_backend ()->struct_type (fields);
+  SLICE_FLAG (type_record) = 1;
   translated = ctx->get_backend ()->named_type (type.get_name (), type_record,
 						type.get_ident ().locus);
 }
@@ -687,6 +853,70 @@ TyTyResolveCompile::create_slice_type_record (const TyTy::SliceType &type)
   return record;
 }
 
+// #[repr(simd)] structs such as `struct f32x4(f32, f32, f32, f32);` are
+// passed around in vector registers, so they become GCC vector types whose
+// lanes are the fields. The backend indexes the lanes for field accesses and
+// struct expressions.
+
+tree
+TyTyResolveCompile::compile_simd_type (
+  const TyTy::ADTType &type,
+  const std::vector<Backend::typed_identifier> &fields)
+{
+  Location locus = type.get_ident ().locus;
+  if (fields.empty ())
+    {
+      rust_error_at (locus, "SIMD vector cannot be empty");
+      return error_mark_node;
+    }
+
+  tree lane_type = fields.front ().type;
+  if (lane_type == error_mark_node)
+    return error_mark_node;
+
+  bool is_scalar = (INTEGRAL_TYPE_P (lane_type)
+		    && TREE_CODE (lane_type) != BOOLEAN_TYPE)
+		   || SCALAR_FLOAT_TYPE_P (lane_type);
+  if (!is_scalar)
+    {
+      rust_error_at (locus, "SIMD vector element type should be a primitive "
+			    "scalar (integer/float) type");
+      return error_mark_node;
+    }
+
+  for (auto &field : fields)
+    {
+      tree t = field.type;
+      if (t == error_mark_node)
+	return error_mark_node;
+
+      if (TREE_CODE (t) != TREE_CODE (lane_type)
+	  || TYPE_PRECISION (t) != TYPE_PRECISION (lane_type)
+	  || TYPE_UNSIGNED (t) != TYPE_UNSIGNED (lane_type))
+	{
+	  rust_error_at (locus, "SIMD vector should be homogeneous");
+	  return error_mark_node;
+	}
+    }
+
+  if (!pow2p_hwi (fields.size ()))
+    {
+      rust_error_at (locus,
+		     "SIMD vector length must be a power of two, not %lu",
+		     (unsigned long) fields.size ());
+      return error_mark_node;
+    }
+
+  tree vector = build_vector_type (lane_type, fields.size ());
+
+  // vector types are shared, so give repr(align) a copy of its own to change
+  TyTy::ADTType::ReprOptions repr = type.get_repr_options ();
+  if (repr.align || repr.pack)
+    vector = build_distinct_type_copy (vector);
+
+  return vector;
+}
+
 tree
 TyTyResolveCompile::create_str_type_record (const TyTy::StrType &type)
 {
@@ -24,6 +24,36 @@
 namespace Rust {
 namespace Compile {
 
+// An enum where a single variant holds data, and the first field of that
+// variant has bit patterns which are never valid for its type (a null
+// reference, a bool of 2, a char past U+10FFFF), needs no discriminant field:
+// the data-less variants are encoded as those invalid values instead. They
+// are read and written through an integer field overlaying the data, placed
+// in the union after the variants. This is what makes Option<&T> pointer
+// sized.
+struct EnumNiche
+{
+  // index of the variant holding data
+  int dataful_variant;
+
+  // index of the overlaying integer field in the union
+  int niche_field;
+
+  // the value encoding the first data-less variant, the others follow on
+  unsigned HOST_WIDE_INT niche_start;
+
+  // the values the field can really hold, which all mean the variant with
+  // data; VALID_END of -1 stands for the largest value of the niche type
+  unsigned HOST_WIDE_INT valid_start;
+  unsigned HOST_WIDE_INT valid_end;
+
+  unsigned HOST_WIDE_INT value_for_variant (int variant_index) const
+  {
+    rust_assert (variant_index != dataful_variant);
+    return niche_start + variant_index - (variant_index > dataful_variant);
+  }
+};
+
 class TyTyResolveCompile : protected TyTy::TyConstVisitor
 {
 public:
@@ -32,6 +62,8 @@ public:
 
   static tree get_implicit_enumeral_node_type (Context *ctx);
 
+  static bool get_enum_niche (const TyTy::ADTType &type, EnumNiche *niche);
+
   void visit (const TyTy::InferType &) override;
   void visit (const TyTy::ADTType &) override;
   void visit (const TyTy::TupleType &) override;
@@ -63,6 +95,8 @@ public:
 protected:
   tree create_slice_type_record (const TyTy::SliceType &type);
   tree create_str_type_record (const TyTy::StrType &type);
+  tree compile_simd_type (const TyTy::ADTType &type,
+			  const std::vector<Backend::typed_identifier> &fields);
 
 private:
   TyTyResolveCompile (Context *ctx, bool trait_object_mode);
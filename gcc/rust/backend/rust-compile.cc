@@ -17,6 +17,7 @@
 // <http://www.gnu.org/licenses/>.
 
 #include "rust-compile.h"
+#include "rust-compile-abi.h"
 #include "rust-compile-item.h"
 #include "rust-compile-implitem.h"
 #include "rust-compile-expr.h"
@@ -42,15 +43,94 @@ CompileCrate::Compile (HIR::Crate &crate, Context *ctx)
 {
   CompileCrate c (crate, ctx);
   c.go ();
+
+  // every body is complete and constant evaluation is over, give the
+  // functions their Rust ABI signatures
+  AbiLowering::lower (ctx);
 }
 
 void
 CompileCrate::go ()
 {
+  if (flag_rust_lazy_codegen)
+    {
+      compile_roots (crate.items);
+      return;
+    }
+
   for (auto &item : crate.items)
     CompileItem::compile (item.get (), ctx);
 }
 
+// A function has to be emitted if it is the entry point or can be linked
+// against from outside the crate; everything else is only compiled when a
+// root refers to it
+static bool
+is_codegen_root (HIR::Function &function)
+{
+  if (function.get_function_name ().compare ("main") == 0)
+    return true;
+
+  if (function.get_visibility ().get_vis_type ()
+      == HIR::Visibility::VisType::PUBLIC)
+    return true;
+
+  return function.get_builtin_attrs ().has (
+    Analysis::BuiltinAttrKind::NO_MANGLE);
+}
+
+/* Compile only the items that codegen has to start from. Paths, method
+   calls, operator overloads and vtables compile what they refer to on demand
+   through query_compile, so the call graph reachable from these roots is
+   walked as it is lowered and nothing else is built.  Generic functions are
+   never roots, they are instantiated by their uses. */
+void
+CompileCrate::compile_roots (std::vector<std::unique_ptr<HIR::Item>> &items)
+{
+  for (auto &item : items)
+    {
+      switch (item->get_item_kind ())
+	{
+	  case HIR::Item::ItemKind::Function: {
+	    HIR::Function &function = static_cast<HIR::Function &> (*item);
+	    if (is_codegen_root (function))
+	      CompileItem::compile (item.get (), ctx);
+	    break;
+	  }
+
+	  case HIR::Item::ItemKind::Impl: {
+	    HIR::ImplBlock &impl_block = static_cast<HIR::ImplBlock &> (*item);
+	    for (auto &impl_item : impl_block.get_impl_items ())
+	      {
+		if (impl_item->get_impl_item_type ()
+		    != HIR::ImplItem::ImplItemType::FUNCTION)
+		  continue;
+
+		HIR::Function &function
+		  = static_cast<HIR::Function &> (*impl_item);
+		if (is_codegen_root (function))
+		  CompileInherentImplItem::Compile (impl_item.get (), ctx);
+	      }
+	    break;
+	  }
+
+	  case HIR::Item::ItemKind::Module: {
+	    HIR::Module &module = static_cast<HIR::Module &> (*item);
+	    compile_roots (module.get_items ());
+	    break;
+	  }
+
+	// constants are folded where they are used
+	case HIR::Item::ItemKind::Constant:
+	  break;
+
+	default:
+	  CompileItem::compile (item.get (), ctx);
+	  break;
+	}
+    }
+}
+
 // Shared methods in compilation
 
 tree
@@ -191,19 +271,39 @@ HIRCompileBase::coerce_to_dyn_object (tree compiled_ref,
   tree dynamic_object = TyTyResolveCompile::compile (ctx, ty);
   tree dynamic_object_fields = TYPE_FIELDS (dynamic_object);
   tree vtable_field = DECL_CHAIN (dynamic_object_fields);
-  rust_assert (TREE_CODE (TREE_TYPE (vtable_field)) == ARRAY_TYPE);
+  rust_assert (POINTER_TYPE_P (TREE_TYPE (vtable_field)));
 
   //' this assumes ordering and current the structure is
   // __trait_object_ptr
-  // [list of function ptrs]
-
-  std::vector<std::pair<Resolver::TraitReference *, HIR::ImplBlock *>>
-    probed_bounds_for_receiver = Resolver::TypeBoundsProbe::Probe (actual);
+  // __vtable_ptr
+  tree vtable_address = NULL_TREE;
+  if (!ctx->lookup_vtable (actual, ty, &vtable_address))
+    {
+      tree vtable_type = TREE_TYPE (TREE_TYPE (vtable_field));
+      vtable_address = compile_vtable (actual, ty, vtable_type, locus);
+      ctx->insert_vtable (actual, ty, vtable_address);
+    }
 
   tree address_of_compiled_ref = null_pointer_node;
   if (!actual->is_unit ())
     address_of_compiled_ref = address_expression (compiled_ref, locus);
 
+  std::vector<tree> dyn_ctor = {address_of_compiled_ref, vtable_address};
+  return ctx->get_backend ()->constructor_expression (dynamic_object, false,
+						      dyn_ctor, -1, locus);
+}
+
+// Emit the vtable of trait object type TY for the concrete type ACTUAL as a
+// read-only global of VTABLE_TYPE, an array of function pointers in the order
+// of the object's items, and return its address.
+tree
+HIRCompileBase::compile_vtable (const TyTy::BaseType *actual,
+				const TyTy::DynamicObjectType *ty,
+				tree vtable_type, Location locus)
+{
+  std::vector<std::pair<Resolver::TraitReference *, HIR::ImplBlock *>>
+    probed_bounds_for_receiver = Resolver::TypeBoundsProbe::Probe (actual);
+
   std::vector<tree> vtable_ctor_elems;
   std::vector<unsigned long> vtable_ctor_idx;
   unsigned long i = 0;
@@ -215,16 +315,41 @@ HIRCompileBase::coerce_to_dyn_object (tree compiled_ref,
       auto address = compute_address_for_trait_item (item, predicate,
 						     probed_bounds_for_receiver,
 						     actual, actual, locus);
+      if (address == error_mark_node)
+	return error_mark_node;
+
       vtable_ctor_elems.push_back (address);
       vtable_ctor_idx.push_back (i++);
     }
 
   tree vtable_ctor = ctx->get_backend ()->array_constructor_expression (
-    TREE_TYPE (vtable_field), vtable_ctor_idx, vtable_ctor_elems, locus);
+    TYPE_MAIN_VARIANT (vtable_type), vtable_ctor_idx, vtable_ctor_elems,
+    locus);
+  if (vtable_ctor == error_mark_node
+      || !mark_constant_initializer (vtable_ctor))
+    return error_mark_node;
 
-  std::vector<tree> dyn_ctor = {address_of_compiled_ref, vtable_ctor};
-  return ctx->get_backend ()->constructor_expression (dynamic_object, false,
-						      dyn_ctor, -1, locus);
+  // the vtables are internal to the crate like rustc's, each object file has
+  // its own copy of those it uses
+  char *asm_name;
+  ASM_FORMAT_PRIVATE_NAME (asm_name, "vtable", ctx->get_var_decls ().size ());
+
+  bool is_external = false;
+  bool is_hidden = true;
+  bool in_unique_section = false;
+  Bvariable *vtable
+    = ctx->get_backend ()->global_variable ("vtable", asm_name, vtable_type,
+					    is_external, is_hidden,
+					    in_unique_section, locus);
+  tree vtable_decl = vtable->get_decl ();
+  TREE_READONLY (vtable_decl) = 1;
+  DECL_ARTIFICIAL (vtable_decl) = 1;
+  DECL_IGNORED_P (vtable_decl) = 1;
+
+  ctx->get_backend ()->global_variable_set_init (vtable, vtable_ctor);
+  ctx->push_var (vtable);
+
+  return build_fold_addr_expr_loc (locus.gcc_location (), vtable_decl);
 }
 
 tree
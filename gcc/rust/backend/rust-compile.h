@@ -36,6 +36,7 @@ public:
 private:
   CompileCrate (HIR::Crate &crate, Context *ctx);
   void go ();
+  void compile_roots (std::vector<std::unique_ptr<HIR::Item>> &items);
 
   HIR::Crate &crate;
   Context *ctx;
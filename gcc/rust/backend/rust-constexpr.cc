@@ -113,9 +113,19 @@ struct constexpr_global_ctx
   vec<tree> *cleanups;
   /* Number of heap VAR_DECL deallocations.  */
   unsigned heap_dealloc_count;
+  /* Work done so far, reported by -frust-dump-const-eval.  */
+  HOST_WIDE_INT call_count;
+  HOST_WIDE_INT loop_iteration_count;
+  HOST_WIDE_INT store_count;
+  /* Operation budget of this evaluation, zero if unlimited, and whether it
+     ran out.  */
+  HOST_WIDE_INT ops_budget;
+  bool budget_exhausted;
   /* Constructor.  */
   constexpr_global_ctx ()
-    : constexpr_ops_count (0), cleanups (NULL), heap_dealloc_count (0)
+    : constexpr_ops_count (0), cleanups (NULL), heap_dealloc_count (0),
+      call_count (0), loop_iteration_count (0), store_count (0),
+      ops_budget (0), budget_exhausted (false)
   {}
 };
 
@@ -554,15 +564,17 @@ cx_error_context (void)
   return r;
 }
 
+static bool const_eval_profiling = false;
+static std::vector<ConstEvalStats> const_eval_stats;
+
 // this is ported from cxx_eval_outermost_constant_expr
-tree
-fold_expr (tree expr)
+static tree
+fold_expr_1 (tree expr, constexpr_global_ctx &global_ctx)
 {
   bool allow_non_constant = false;
   bool strict = true;
   bool manifestly_const_eval = false;
 
-  constexpr_global_ctx global_ctx;
   constexpr_ctx ctx
     = {&global_ctx, NULL,
        NULL,	    NULL,
@@ -584,6 +596,44 @@ fold_expr (tree expr)
   return folded;
 }
 
+tree
+fold_expr (tree expr)
+{
+  constexpr_global_ctx global_ctx;
+  return fold_expr_1 (expr, global_ctx);
+}
+
+tree
+fold_constant_item (tree expr, const std::string &name, bool *exhausted)
+{
+  constexpr_global_ctx global_ctx;
+  global_ctx.ops_budget = flag_rust_const_eval_limit;
+  tree folded = fold_expr_1 (expr, global_ctx);
+
+  *exhausted = global_ctx.budget_exhausted;
+  if (const_eval_profiling)
+    const_eval_stats.push_back ({name, EXPR_LOCATION (expr),
+				 global_ctx.constexpr_ops_count,
+				 global_ctx.call_count,
+				 global_ctx.loop_iteration_count,
+				 global_ctx.store_count,
+				 global_ctx.budget_exhausted});
+
+  return *exhausted ? expr : folded;
+}
+
+void
+set_const_eval_profiling (bool enabled)
+{
+  const_eval_profiling = enabled;
+}
+
+const std::vector<ConstEvalStats> &
+get_const_eval_stats ()
+{
+  return const_eval_stats;
+}
+
 static bool
 same_type_ignoring_tlq_and_bounds_p (tree type1, tree type2)
 {
@@ -1911,8 +1961,19 @@ eval_constant_expression (const constexpr_ctx *ctx, tree t, bool lval,
       return t;
     }
 
+  // Constant items over their -frust-const-eval-limit budget are quietly
+  // left for run time
+  ++ctx->global->constexpr_ops_count;
+  if (ctx->global->ops_budget != 0
+      && ctx->global->constexpr_ops_count >= ctx->global->ops_budget)
+    {
+      ctx->global->budget_exhausted = true;
+      *non_constant_p = true;
+      return t;
+    }
+
   // Avoid excessively long constexpr evaluations
-  if (++ctx->global->constexpr_ops_count >= constexpr_ops_limit)
+  if (ctx->global->constexpr_ops_count >= constexpr_ops_limit)
     {
       rust_error_at (
 	Location (loc),
@@ -2646,6 +2707,8 @@ eval_store_expression (const constexpr_ctx *ctx, tree t, bool lval,
     /* Just ignore clobbers.  */
     return void_node;
 
+  ctx->global->store_count++;
+
   /* First we figure out where we're storing to.  */
   tree target = TREE_OPERAND (t, 0);
 
@@ -3371,6 +3434,8 @@ eval_call_expression (const constexpr_ctx *ctx, tree t, bool lval,
   constexpr_call new_call = {NULL, NULL, NULL, 0, ctx->manifestly_const_eval};
   int depth_ok;
 
+  ctx->global->call_count++;
+
   if (fun == NULL_TREE)
     {
       // return cxx_eval_internal_function (ctx, t, lval,
@@ -4942,6 +5007,7 @@ eval_loop_expr (const constexpr_ctx *ctx, tree t, bool *non_constant_p,
 	ctx->global->values.remove (save_expr);
       save_exprs.truncate (0);
 
+      ctx->global->loop_iteration_count++;
       if (++count >= constexpr_loop_limit)
 	{
 	  if (!ctx->quiet)
@@ -23,7 +23,30 @@
 namespace Rust {
 namespace Compile {
 
+// What folding a single constant item cost
+struct ConstEvalStats
+{
+  std::string name;
+  location_t locus;
+  HOST_WIDE_INT ops;
+  HOST_WIDE_INT calls;
+  HOST_WIDE_INT loop_iterations;
+  HOST_WIDE_INT stores;
+  bool exhausted;
+};
+
 extern tree fold_expr (tree);
+
+// Fold the initializer of the constant item NAME.  Gives up once
+// -frust-const-eval-limit operations have been evaluated, in which case
+// EXPR is returned unchanged and EXHAUSTED is set.
+extern tree
+fold_constant_item (tree expr, const std::string &name, bool *exhausted);
+
+extern void
+set_const_eval_profiling (bool enabled);
+extern const std::vector<ConstEvalStats> &
+get_const_eval_stats ();
 extern void
 maybe_save_constexpr_fundef (tree fun);
 
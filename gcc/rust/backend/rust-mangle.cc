@@ -242,50 +242,432 @@ v0_add_identifier (std::string &mangled, const std::string &identifier)
 
   // If the first character of the identifier is a digit or an underscore, we
   // add an extra underscore
-  if (identifier[0] == '_')
+  if (ISDIGIT (identifier[0]) || identifier[0] == '_')
     mangled.append ("_");
 
   mangled.append (identifier);
 }
 
+// The fingerprint hashed into a legacy symbol. Profiles find functions by
+// their symbol, so it leaves out what unrelated edits change, such as the
+// parameter patterns and the ids of unresolved type parameters, and names
+// ADTs by their canonical path rather than by their fields
 static std::string
-v0_type_prefix (const TyTy::BaseType *ty)
+legacy_fingerprint (const TyTy::BaseType *ty)
 {
-  auto ty_prefix = v0_simple_type_prefix (ty);
-  if (!ty_prefix.empty ())
-    return ty_prefix;
+  switch (ty->get_kind ())
+    {
+      case TyTy::TypeKind::PARAM: {
+	auto param = static_cast<const TyTy::ParamType *> (ty);
+	if (!param->can_resolve ())
+	  return param->get_symbol ();
+	return legacy_fingerprint (param->resolve ());
+      }
+
+      case TyTy::TypeKind::FNDEF: {
+	auto fn = static_cast<const TyTy::FnType *> (ty);
+	std::string buffer = "fn<";
+	for (auto &mapping : fn->get_substs ())
+	  buffer += legacy_fingerprint (mapping.get_param_ty ()) + ",";
+	buffer += ">(";
+	for (auto &param : fn->get_params ())
+	  buffer += legacy_fingerprint (param.second) + ",";
+	return buffer + ")->" + legacy_fingerprint (fn->get_return_type ());
+      }
+
+      case TyTy::TypeKind::ADT: {
+	auto adt = static_cast<const TyTy::ADTType *> (ty);
+	const Resolver::CanonicalPath &path = adt->get_ident ().path;
+	std::string buffer;
+	for (size_t i = 0; i < path.size (); i++)
+	  buffer += "::" + path.get_seg_at (i).second;
+	buffer += "<";
+	for (auto &mapping : adt->get_substs ())
+	  buffer += legacy_fingerprint (mapping.get_param_ty ()) + ",";
+	return buffer + ">";
+      }
+
+      case TyTy::TypeKind::REF: {
+	auto ref = static_cast<const TyTy::ReferenceType *> (ty);
+	return (ref->is_mutable () ? "&mut " : "&")
+	       + legacy_fingerprint (ref->get_base ());
+      }
+
+      case TyTy::TypeKind::POINTER: {
+	auto ptr = static_cast<const TyTy::PointerType *> (ty);
+	return (ptr->is_mutable () ? "*mut " : "*const ")
+	       + legacy_fingerprint (ptr->get_base ());
+      }
+
+      case TyTy::TypeKind::SLICE: {
+	auto slice = static_cast<const TyTy::SliceType *> (ty);
+	return "[" + legacy_fingerprint (slice->get_element_type ()) + "]";
+      }
+
+      case TyTy::TypeKind::TUPLE: {
+	auto tuple = static_cast<const TyTy::TupleType *> (ty);
+	std::string buffer = "(";
+	for (size_t i = 0; i < tuple->num_fields (); i++)
+	  buffer += legacy_fingerprint (tuple->get_field (i)) + ",";
+	return buffer + ")";
+      }
 
-  // FIXME: We need to fetch more type prefixes
-  gcc_unreachable ();
+    default:
+      return ty->as_string ();
+    }
 }
 
 static std::string
 legacy_mangle_item (const TyTy::BaseType *ty,
 		    const Resolver::CanonicalPath &path)
 {
-  const std::string hash = legacy_hash (ty->as_string ());
+  const std::string hash = legacy_hash (legacy_fingerprint (ty));
   const std::string hash_sig = legacy_mangle_name (hash);
 
   return kMangledSymbolPrefix + legacy_mangle_canonical_path (path) + hash_sig
 	 + kMangledSymbolDelim;
 }
 
+// Mangling state for one v0 symbol. Every path and type is remembered by the
+// offset it was emitted at, so that when the same one comes up again it is
+// replaced by a `B <base-62-number>` backref. This is the "Backreferences"
+// part of the v0 mangling RFC, without which the name of a generic instance
+// repeats each of its argument types in full for every use.
+class V0Mangler
+{
+public:
+  V0Mangler () : mangled ("_R") {}
+
+  std::string &get_mangled () { return mangled; }
+
+  void add_path (const Resolver::CanonicalPath &path, size_t len, char ns);
+  void add_generic_args (const TyTy::SubstitutionRef &ref);
+  void add_type (const TyTy::BaseType *ty);
+
+private:
+  bool add_backref (const std::string &key);
+  void add_segment (const std::string &seg);
+  void add_opaque_type (const TyTy::BaseType *ty);
+  void add_const (const TyTy::ArrayType &array);
+  const std::string &type_key (const TyTy::BaseType *ty);
+
+  std::string mangled;
+
+  // key of a path or type -> offset of its first occurrence, counted from the
+  // end of the "_R" prefix
+  std::map<std::string, size_t> backrefs;
+
+  // building a key walks the whole type, so remember them
+  std::map<const TyTy::BaseType *, std::string> type_keys;
+};
+
+// Emit a backref if KEY has been emitted before and return true, otherwise
+// record that it starts at the current offset.
+bool
+V0Mangler::add_backref (const std::string &key)
+{
+  auto it = backrefs.find (key);
+  if (it != backrefs.end ())
+    {
+      mangled += "B";
+      v0_add_integer_62 (mangled, it->second);
+      return true;
+    }
+
+  backrefs.insert ({key, mangled.size () - 2});
+  return false;
+}
+
+// Segments that are not plain identifiers, such as `<impl Foo>`, are reduced
+// to one and kept apart by a disambiguator hashed from their real text.
+void
+V0Mangler::add_segment (const std::string &seg)
+{
+  bool plain = !seg.empty ();
+  for (auto c : seg)
+    plain = plain && (ISALNUM (c) || c == '_');
+
+  if (plain)
+    {
+      v0_add_identifier (mangled, seg);
+      return;
+    }
+
+  Hash::FNV128 hasher;
+  hasher.write ((const unsigned char *) seg.c_str (), seg.size ());
+  uint64_t hi, lo;
+  hasher.sum (&hi, &lo);
+  v0_add_disambiguator (mangled, lo);
+
+  std::string ident;
+  for (auto c : seg)
+    {
+      if (ISALNUM (c))
+	ident += c;
+      else if (!ident.empty () && ident.back () != '_')
+	ident += '_';
+    }
+  if (ident.empty ())
+    ident = "_";
+  v0_add_identifier (mangled, ident);
+}
+
+// Types with no v0 encoding here yet (closures, trait objects, ...) are
+// written as a crate root named after them, which keeps the symbol well formed
+// and the disambiguator keeps different types apart.
+void
+V0Mangler::add_opaque_type (const TyTy::BaseType *ty)
+{
+  mangled += "C";
+  add_segment ("<" + ty->as_string () + ">");
+}
+
+// Add the first LEN segments of PATH, where the last one lives in the
+// namespace NS ('v' for values, 't' for types).
+void
+V0Mangler::add_path (const Resolver::CanonicalPath &path, size_t len, char ns)
+{
+  std::string key = "p";
+  key += ns;
+  key += std::to_string (path.get_crate_num ());
+  for (size_t i = 0; i < len; i++)
+    key += ":" + path.get_seg_at (i).second;
+
+  if (add_backref (key))
+    return;
+
+  if (len == 1)
+    {
+      mangled += "C";
+      add_segment (path.get_seg_at (0).second);
+      return;
+    }
+
+  mangled += "N";
+  mangled += ns;
+  add_path (path, len - 1, 't');
+  add_segment (path.get_seg_at (len - 1).second);
+}
+
+void
+V0Mangler::add_generic_args (const TyTy::SubstitutionRef &ref)
+{
+  for (auto &mapping : ref.get_substs ())
+    add_type (mapping.get_param_ty ()->resolve ());
+}
+
+// Array lengths are only known here when they were written as a literal, any
+// other length is left as the `p` placeholder.
+void
+V0Mangler::add_const (const TyTy::ArrayType &array)
+{
+  const HIR::Expr &capacity = array.get_capacity_expr ();
+  if (capacity.get_expression_type () == HIR::Expr::ExprType::Lit)
+    {
+      auto &lit = static_cast<const HIR::LiteralExpr &> (capacity);
+      std::string value = lit.get_literal ().as_string ();
+      char *end = nullptr;
+      unsigned long long n = strtoull (value.c_str (), &end, 10);
+      if (!value.empty () && *end == '\0')
+	{
+	  char hex[16 + 1];
+	  snprintf (hex, sizeof hex, "%llx", n);
+	  mangled += "j";
+	  mangled += hex;
+	  mangled += "_";
+	  return;
+	}
+    }
+
+  mangled += "p";
+}
+
+// A key naming TY structurally, ADTs by their canonical path, so that two
+// distinct TyTy nodes for the same type share their backref.
+const std::string &
+V0Mangler::type_key (const TyTy::BaseType *ty)
+{
+  auto it = type_keys.find (ty);
+  if (it != type_keys.end ())
+    return it->second;
+
+  auto sub = [&] (const TyTy::BaseType *t) {
+    const std::string &k = type_key (t);
+    return std::to_string (k.size ()) + ":" + k;
+  };
+
+  std::string key = v0_simple_type_prefix (ty);
+  if (key.empty ())
+    {
+      switch (ty->get_kind ())
+	{
+	  case TyTy::TypeKind::REF: {
+	    auto ref = static_cast<const TyTy::ReferenceType *> (ty);
+	    key = (ref->is_mutable () ? "Q" : "R") + sub (ref->get_base ());
+	  }
+	  break;
+
+	  case TyTy::TypeKind::POINTER: {
+	    auto ptr = static_cast<const TyTy::PointerType *> (ty);
+	    key = (ptr->is_mutable () ? "O" : "P") + sub (ptr->get_base ());
+	  }
+	  break;
+
+	  case TyTy::TypeKind::SLICE: {
+	    auto slice = static_cast<const TyTy::SliceType *> (ty);
+	    key = "S" + sub (slice->get_element_type ());
+	  }
+	  break;
+
+	  case TyTy::TypeKind::TUPLE: {
+	    auto tuple = static_cast<const TyTy::TupleType *> (ty);
+	    key = "T";
+	    for (size_t i = 0; i < tuple->num_fields (); i++)
+	      key += sub (tuple->get_field (i));
+	  }
+	  break;
+
+	  case TyTy::TypeKind::ADT: {
+	    auto adt = static_cast<const TyTy::ADTType *> (ty);
+	    const Resolver::CanonicalPath &path = adt->get_ident ().path;
+	    key = "a" + std::to_string (path.get_crate_num ());
+	    for (size_t i = 0; i < path.size (); i++)
+	      key += ":" + path.get_seg_at (i).second;
+	    key += "<";
+	    for (auto &mapping : adt->get_substs ())
+	      key += sub (mapping.get_param_ty ()->resolve ());
+	  }
+	  break;
+
+	  case TyTy::TypeKind::FNPTR: {
+	    auto fn = static_cast<const TyTy::FnPtr *> (ty);
+	    key = "F";
+	    for (size_t i = 0; i < fn->num_params (); i++)
+	      key += sub (fn->param_at (i));
+	    key += "E" + sub (fn->get_return_type ());
+	  }
+	  break;
+
+	default:
+	  key = "?" + ty->as_string ();
+	  break;
+	}
+    }
+
+  return type_keys.insert ({ty, std::move (key)}).first->second;
+}
+
+void
+V0Mangler::add_type (const TyTy::BaseType *ty)
+{
+  // basic types are a single letter, shorter than any backref
+  std::string prefix = v0_simple_type_prefix (ty);
+  if (!prefix.empty ())
+    {
+      mangled += prefix;
+      return;
+    }
+
+  if (add_backref (type_key (ty)))
+    return;
+
+  switch (ty->get_kind ())
+    {
+      case TyTy::TypeKind::REF: {
+	auto ref = static_cast<const TyTy::ReferenceType *> (ty);
+	mangled += ref->is_mutable () ? "Q" : "R";
+	add_type (ref->get_base ());
+      }
+      break;
+
+      case TyTy::TypeKind::POINTER: {
+	auto ptr = static_cast<const TyTy::PointerType *> (ty);
+	mangled += ptr->is_mutable () ? "O" : "P";
+	add_type (ptr->get_base ());
+      }
+      break;
+
+      case TyTy::TypeKind::SLICE: {
+	auto slice = static_cast<const TyTy::SliceType *> (ty);
+	mangled += "S";
+	add_type (slice->get_element_type ());
+      }
+      break;
+
+      case TyTy::TypeKind::ARRAY: {
+	auto array = static_cast<const TyTy::ArrayType *> (ty);
+	mangled += "A";
+	add_type (array->get_element_type ());
+	add_const (*array);
+      }
+      break;
+
+      case TyTy::TypeKind::TUPLE: {
+	auto tuple = static_cast<const TyTy::TupleType *> (ty);
+	mangled += "T";
+	for (size_t i = 0; i < tuple->num_fields (); i++)
+	  add_type (tuple->get_field (i));
+	mangled += "E";
+      }
+      break;
+
+      case TyTy::TypeKind::ADT: {
+	auto adt = static_cast<const TyTy::ADTType *> (ty);
+	const Resolver::CanonicalPath &path = adt->get_ident ().path;
+	if (path.is_empty ())
+	  {
+	    add_opaque_type (ty);
+	    break;
+	  }
+
+	bool generic = !adt->get_substs ().empty ();
+	if (generic)
+	  mangled += "I";
+	add_path (path, path.size (), 't');
+	if (generic)
+	  {
+	    add_generic_args (*adt);
+	    mangled += "E";
+	  }
+      }
+      break;
+
+      case TyTy::TypeKind::FNPTR: {
+	auto fn = static_cast<const TyTy::FnPtr *> (ty);
+	mangled += "F";
+	for (size_t i = 0; i < fn->num_params (); i++)
+	  add_type (fn->param_at (i));
+	mangled += "E";
+	add_type (fn->get_return_type ());
+      }
+      break;
+
+    default:
+      add_opaque_type (ty);
+      break;
+    }
+}
+
 static std::string
 v0_mangle_item (const TyTy::BaseType *ty, const Resolver::CanonicalPath &path)
 {
-  // we can get this from the canonical_path
-  auto mappings = Analysis::Mappings::get ();
-  std::string crate_name;
-  bool ok = mappings->get_crate_name (path.get_crate_num (), crate_name);
-  rust_assert (ok);
+  V0Mangler mangler;
 
-  std::string mangled;
-  // FIXME: Add real algorithm once all pieces are implemented
-  auto ty_prefix = v0_type_prefix (ty);
-  v0_add_identifier (mangled, crate_name);
-  v0_add_disambiguator (mangled, 62);
+  const TyTy::FnType *fn = nullptr;
+  if (ty->get_kind () == TyTy::TypeKind::FNDEF)
+    fn = static_cast<const TyTy::FnType *> (ty);
 
-  gcc_unreachable ();
+  bool generic = fn != nullptr && !fn->get_substs ().empty ();
+  if (generic)
+    mangler.get_mangled () += "I";
+  mangler.add_path (path, path.size (), 'v');
+  if (generic)
+    {
+      mangler.add_generic_args (*fn);
+      mangler.get_mangled () += "E";
+    }
+
+  return mangler.get_mangled ();
 }
 
 std::string
@@ -20,28 +20,6 @@ PrivacyReporter::go (HIR::Crate &crate)
     item->accept_vis (*this);
 }
 
-static bool
-is_child_module (Analysis::Mappings &mappings, NodeId parent,
-		 NodeId possible_child)
-{
-  auto children = mappings.lookup_module_children (parent);
-
-  if (!children)
-    return false;
-
-  // Visit all toplevel children
-  for (auto &child : *children)
-    if (child == possible_child)
-      return true;
-
-  // Now descend recursively in the child module tree
-  for (auto &child : *children)
-    if (is_child_module (mappings, child, possible_child))
-      return true;
-
-  return false;
-}
-
 // FIXME: This function needs a lot of refactoring
 void
 PrivacyReporter::check_for_privacy_violation (const NodeId &use_id,
@@ -59,11 +37,27 @@ PrivacyReporter::check_for_privacy_violation (const NodeId &use_id,
   if (ref_node_id == UNKNOWN_NODEID)
     return;
 
+  if (!is_accessible (ref_node_id))
+    rust_error_at (locus, "definition is private in this context");
+}
+
+bool
+PrivacyReporter::is_accessible (NodeId ref_node_id)
+{
+  // Items are referenced many times from the same module, answer each pair
+  // once
+  auto key = std::make_pair (ref_node_id, current_module.is_some ()
+					    ? current_module.get ()
+					    : UNKNOWN_NODEID);
+  auto cached = accessible_cache.find (key);
+  if (cached != accessible_cache.end ())
+    return cached->second;
+
   ModuleVisibility vis;
 
   // FIXME: Can we really return here if the item has no visibility?
   if (!mappings.lookup_visibility (ref_node_id, vis))
-    return;
+    return accessible_cache[key] = true;
 
   auto valid = true;
 
@@ -75,7 +69,7 @@ PrivacyReporter::check_for_privacy_violation (const NodeId &use_id,
 	// If we are in the crate, everything is restricted correctly, but we
 	// can't get a module for it
 	if (current_module.is_none ())
-	  return;
+	  break;
 
 	auto module = mappings.lookup_defid (vis.get_module_id ());
 	rust_assert (module != nullptr);
@@ -89,7 +83,7 @@ PrivacyReporter::check_for_privacy_violation (const NodeId &use_id,
 
 	// FIXME: This needs a LOT of TLC: hinting about the definition, a
 	// string to say if it's a module, function, type, etc...
-	if (!is_child_module (mappings, mod_node_id, current_module.get ()))
+	if (!mappings.is_module_descendant (mod_node_id, current_module.get ()))
 	  valid = false;
       }
       break;
@@ -98,8 +92,7 @@ PrivacyReporter::check_for_privacy_violation (const NodeId &use_id,
       break;
     }
 
-  if (!valid)
-    rust_error_at (locus, "definition is private in this context");
+  return accessible_cache[key] = valid;
 }
 
 void
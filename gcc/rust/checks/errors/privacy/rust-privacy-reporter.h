@@ -58,6 +58,12 @@ private:
   void check_for_privacy_violation (const NodeId &use_id,
 				    const Location &locus);
 
+  /**
+   * Is the item REF_NODE_ID visible from the current module? The answers are
+   * memoized per item and module.
+   */
+  bool is_accessible (NodeId ref_node_id);
+
   /**
    * Internal function used by `check_type_privacy` when dealing with complex
 types
@@ -165,6 +171,8 @@ types
 
   // `None` means we're in the root module - the crate
   Optional<NodeId> current_module;
+
+  std::map<std::pair<NodeId, NodeId>, bool> accessible_cache;
 };
 
 } // namespace Privacy
@@ -34,7 +34,13 @@ void
 ConstChecker::go (HIR::Crate &crate)
 {
   for (auto &item : crate.items)
-    item->accept_vis (*this);
+    check (*item);
+}
+
+void
+ConstChecker::check (HIR::Item &item)
+{
+  item.accept_vis (*this);
 }
 
 bool
@@ -33,6 +33,9 @@ public:
 
   void go (HIR::Crate &crate);
 
+  // check a single top level item, for use in an ItemPassManager
+  void check (HIR::Item &item);
+
   /**
    * Check if an item is a const extern item or not
    * TODO: Move this to a const compilation context class or an attribute
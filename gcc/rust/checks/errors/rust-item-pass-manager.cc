@@ -0,0 +1,45 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-item-pass-manager.h"
+#include "rust-hir-full.h"
+
+namespace Rust {
+namespace HIR {
+
+void
+ItemPassManager::add_pass (timevar_id_t tv, ItemPass pass)
+{
+  passes.push_back ({tv, std::move (pass)});
+}
+
+void
+ItemPassManager::run (Crate &crate)
+{
+  for (auto &item : crate.items)
+    {
+      for (auto &pass : passes)
+	{
+	  auto_timevar tv (pass.tv);
+	  pass.run (*item);
+	}
+    }
+}
+
+} // namespace HIR
+} // namespace Rust
@@ -0,0 +1,61 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_ITEM_PASS_MANAGER_H
+#define RUST_ITEM_PASS_MANAGER_H
+
+#include "rust-system.h"
+#include "rust-hir-full-decls.h"
+#include "timevar.h"
+
+namespace Rust {
+namespace HIR {
+
+/**
+ * Runs checkers which look at each item of a crate independently of the
+ * others in a single loop over the crate items. Every registered pass sees an
+ * item right after the previous one did, while its subtree is still in the
+ * cache, instead of each pass walking the whole crate on its own.
+ */
+class ItemPassManager
+{
+public:
+  typedef std::function<void (Item &)> ItemPass;
+
+  /**
+   * Register a pass, called once for every item of the crate and accounted
+   * under the timevar TV
+   */
+  void add_pass (timevar_id_t tv, ItemPass pass);
+
+  void run (Crate &crate);
+
+private:
+  struct Pass
+  {
+    timevar_id_t tv;
+    ItemPass run;
+  };
+
+  std::vector<Pass> passes;
+};
+
+} // namespace HIR
+} // namespace Rust
+
+#endif // RUST_ITEM_PASS_MANAGER_H
@@ -0,0 +1,838 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+
+#include "rust-match-checker.h"
+#include "tm.h"
+
+namespace Rust {
+namespace HIR {
+
+// Disjoint ranges of values, in increasing order
+typedef std::vector<std::pair<widest_int, widest_int>> Ranges;
+
+// The values of TY as ranges, if it is an integer, char or bool type
+static bool
+integral_domain (const TyTy::BaseType *ty, Ranges &ranges)
+{
+  unsigned precision;
+  signop sign;
+  switch (ty->get_kind ())
+    {
+    case TyTy::TypeKind::BOOL:
+      ranges.push_back ({widest_int (0), widest_int (1)});
+      return true;
+
+    case TyTy::TypeKind::CHAR:
+      // the unicode scalar values, which exclude the surrogates
+      ranges.push_back ({widest_int (0), widest_int (0xd7ff)});
+      ranges.push_back ({widest_int (0xe000), widest_int (0x10ffff)});
+      return true;
+
+    case TyTy::TypeKind::INT:
+      sign = SIGNED;
+      precision = 8 << static_cast<const TyTy::IntType *> (ty)->get_int_kind ();
+      break;
+
+    case TyTy::TypeKind::UINT:
+      sign = UNSIGNED;
+      precision
+	= 8 << static_cast<const TyTy::UintType *> (ty)->get_uint_kind ();
+      break;
+
+    case TyTy::TypeKind::ISIZE:
+      sign = SIGNED;
+      precision = POINTER_SIZE;
+      break;
+
+    case TyTy::TypeKind::USIZE:
+      sign = UNSIGNED;
+      precision = POINTER_SIZE;
+      break;
+
+    default:
+      return false;
+    }
+
+  ranges.push_back ({widest_int::from (wi::min_value (precision, sign), sign),
+		     widest_int::from (wi::max_value (precision, sign), sign)});
+  return true;
+}
+
+// The code point of the single character encoded in STR
+static bool
+decode_char (const std::string &str, widest_int *value)
+{
+  if (str.empty ())
+    return false;
+
+  unsigned char lead = str[0];
+  size_t length = lead < 0x80 ? 1 : lead < 0xe0 ? 2 : lead < 0xf0 ? 3 : 4;
+  if (str.size () != length)
+    return false;
+
+  uint32_t code = length == 1 ? lead : lead & (0x7f >> length);
+  for (size_t i = 1; i < length; i++)
+    code = (code << 6) | (str[i] & 0x3f);
+
+  *value = code;
+  return true;
+}
+
+// The value of the literal LIT, negated if NEGATIVE, as one of the values of
+// the integral type TY
+static bool
+literal_value (const Literal &lit, bool negative, const TyTy::BaseType *ty,
+	       widest_int *value)
+{
+  const std::string &str = lit.as_string ();
+  switch (lit.get_lit_type ())
+    {
+    case Literal::BOOL:
+      if (negative || ty->get_kind () != TyTy::TypeKind::BOOL)
+	return false;
+      *value = str == "true" ? 1 : 0;
+      return true;
+
+    case Literal::CHAR:
+      if (negative || ty->get_kind () != TyTy::TypeKind::CHAR)
+	return false;
+      return decode_char (str, value);
+
+    case Literal::BYTE:
+      if (negative || str.empty ())
+	return false;
+      *value = static_cast<unsigned char> (str[0]);
+      break;
+
+      case Literal::INT: {
+	// integer literals are left as decimal digits by the lexer
+	if (str.empty () || str.size () > 40)
+	  return false;
+
+	widest_int v = 0;
+	for (char c : str)
+	  {
+	    if (!ISDIGIT (c))
+	      return false;
+	    v = v * 10 + (c - '0');
+	  }
+	*value = negative ? wi::neg (v) : v;
+      }
+      break;
+
+    default:
+      return false;
+    }
+
+  Ranges domain;
+  if (ty->get_kind () == TyTy::TypeKind::BOOL
+      || ty->get_kind () == TyTy::TypeKind::CHAR
+      || !integral_domain (ty, domain))
+    return false;
+
+  return wi::ges_p (*value, domain[0].first)
+	 && wi::les_p (*value, domain[0].second);
+}
+
+// Whether the rows headed by PATTERN are kept when specializing by CTOR,
+// which is either the constructor of the row being checked or one of the
+// parts it was split into
+static bool
+covers (const MatchChecker::Constructor &pattern,
+	const MatchChecker::Constructor &ctor)
+{
+  if (pattern.kind != ctor.kind)
+    return false;
+
+  switch (pattern.kind)
+    {
+    case MatchChecker::Constructor::SINGLE:
+      return true;
+
+    case MatchChecker::Constructor::RANGE:
+      return wi::les_p (pattern.lo, ctor.lo) && wi::les_p (ctor.hi, pattern.hi);
+
+    default:
+      return pattern.index == ctor.index;
+    }
+}
+
+static MatchChecker::Constructor
+range_constructor (const widest_int &lo, const widest_int &hi)
+{
+  MatchChecker::Constructor ctor;
+  ctor.kind = MatchChecker::Constructor::RANGE;
+  ctor.index = 0;
+  ctor.lo = lo;
+  ctor.hi = hi;
+  return ctor;
+}
+
+// Split LO..=HI at the boundaries of the ranges of PRESENT, so that each part
+// is either inside or outside of every one of them
+static void
+split_range (const widest_int &lo, const widest_int &hi,
+	     const std::vector<MatchChecker::Constructor> &present,
+	     std::vector<MatchChecker::Constructor> &parts)
+{
+  std::vector<widest_int> borders;
+  for (auto &ctor : present)
+    if (ctor.kind == MatchChecker::Constructor::RANGE)
+      {
+	borders.push_back (ctor.lo);
+	borders.push_back (ctor.hi + 1);
+      }
+
+  std::sort (borders.begin (), borders.end (),
+	     [] (const widest_int &a, const widest_int &b) {
+	       return wi::lts_p (a, b);
+	     });
+
+  widest_int start = lo;
+  for (auto &border : borders)
+    if (wi::gts_p (border, start) && wi::les_p (border, hi))
+      {
+	parts.push_back (range_constructor (start, border - 1));
+	start = border;
+      }
+  parts.push_back (range_constructor (start, hi));
+}
+
+MatchChecker::MatchChecker ()
+  : tyctx (*Resolver::TypeCheckContext::get ()), opaque_count (0)
+{
+  wildcard_pattern.ctor.kind = Constructor::WILDCARD;
+  wildcard_pattern.ctor.index = 0;
+  wildcard = &wildcard_pattern;
+}
+
+void
+MatchChecker::go ()
+{
+  MatchChecker checker;
+  for (auto &expr : checker.tyctx.get_match_exprs ())
+    checker.check (*expr.second);
+}
+
+void
+MatchChecker::check (MatchExpr &expr)
+{
+  TyTy::BaseType *scrutinee = nullptr;
+  if (!tyctx.lookup_type (
+	expr.get_scrutinee_expr ()->get_mappings ().get_hirid (), &scrutinee))
+    return;
+
+  patterns.clear ();
+  literals.clear ();
+
+  Types types = {scrutinee->destructure ()};
+  std::vector<Row> matrix;
+  for (auto &kase : expr.get_match_cases ())
+    {
+      MatchArm &arm = kase.get_arm ();
+      for (auto &pattern : arm.get_patterns ())
+	{
+	  Row row = {deconstruct (pattern.get (), types[0])};
+	  if (!is_useful (matrix, row, types, nullptr))
+	    rust_warning_at (pattern->get_locus (), 0, "unreachable pattern");
+
+	  // the guard may reject the values of the pattern, so a guarded arm
+	  // does not cover them
+	  if (!arm.has_match_arm_guard ())
+	    matrix.push_back (std::move (row));
+	}
+    }
+
+  // the patterns outside of the analysis cover nothing, so the values they
+  // might match are still reported
+  std::vector<std::string> witness;
+  if (is_useful (matrix, {wildcard}, types, &witness))
+    rust_error_at (expr.get_locus (),
+		   "non-exhaustive patterns: %qs not covered",
+		   witness[0].c_str ());
+  else
+    tyctx.insert_exhaustive_match (expr.get_mappings ().get_hirid ());
+}
+
+MatchChecker::DeconstructedPat *
+MatchChecker::make (Constructor::Kind kind, size_t index)
+{
+  patterns.emplace_back (new DeconstructedPat ());
+  DeconstructedPat *pattern = patterns.back ().get ();
+  pattern->ctor.kind = kind;
+  pattern->ctor.index = index;
+  return pattern;
+}
+
+const MatchChecker::DeconstructedPat *
+MatchChecker::opaque ()
+{
+  return make (Constructor::OPAQUE, opaque_count++);
+}
+
+const MatchChecker::DeconstructedPat *
+MatchChecker::deconstruct (Pattern *pattern, const TyTy::BaseType *ty)
+{
+  switch (pattern->get_pattern_type ())
+    {
+    case Pattern::PatternType::WILDCARD:
+      return wildcard;
+
+      case Pattern::PatternType::IDENTIFIER: {
+	// `x @ pattern` only matches what its pattern does
+	IdentifierPattern &ident = *static_cast<IdentifierPattern *> (pattern);
+	if (ident.has_pattern_to_bind ())
+	  return deconstruct (ident.get_to_bind ().get (), ty);
+	return wildcard;
+      }
+
+    case Pattern::PatternType::LITERAL:
+      return deconstruct_literal (
+	static_cast<LiteralPattern *> (pattern)->get_literal (), ty);
+
+    case Pattern::PatternType::RANGE:
+      return deconstruct_range (*static_cast<RangePattern *> (pattern), ty);
+
+      case Pattern::PatternType::TUPLE: {
+	TuplePattern &tuple = *static_cast<TuplePattern *> (pattern);
+	if (ty->get_kind () != TyTy::TypeKind::TUPLE
+	    || !tuple.has_tuple_pattern_items ())
+	  break;
+
+	DeconstructedPat *result = make (Constructor::SINGLE);
+	Types types = field_types (result->ctor, ty);
+	bool ok;
+	if (tuple.get_items ()->get_pattern_type ()
+	    == TuplePatternItems::TuplePatternItemType::MULTIPLE)
+	  {
+	    auto &items = static_cast<TuplePatternItemsMultiple &> (
+	      *tuple.get_items ());
+	    ok = deconstruct_fields (items.get_patterns (), nullptr, types,
+				     result);
+	  }
+	else
+	  {
+	    auto &items
+	      = static_cast<TuplePatternItemsRanged &> (*tuple.get_items ());
+	    ok = deconstruct_fields (items.get_lower_patterns (),
+				     &items.get_upper_patterns (), types,
+				     result);
+	  }
+	if (!ok)
+	  break;
+	return result;
+      }
+
+    case Pattern::PatternType::PATH:
+    case Pattern::PatternType::STRUCT:
+    case Pattern::PatternType::TUPLE_STRUCT:
+      return deconstruct_adt (*pattern, ty);
+
+    default:
+      break;
+    }
+
+  return opaque ();
+}
+
+const MatchChecker::DeconstructedPat *
+MatchChecker::deconstruct_literal (const Literal &lit, const TyTy::BaseType *ty)
+{
+  widest_int value;
+  if (literal_value (lit, false, ty, &value))
+    {
+      DeconstructedPat *result = make (Constructor::RANGE);
+      result->ctor.lo = value;
+      result->ctor.hi = value;
+      return result;
+    }
+
+  switch (lit.get_lit_type ())
+    {
+    case Literal::STRING:
+    case Literal::BYTE_STRING:
+      case Literal::FLOAT: {
+	// these are only equal to themselves
+	std::string key
+	  = std::to_string (lit.get_lit_type ()) + ":" + lit.as_string ();
+	auto it = literals.insert ({key, literals.size ()}).first;
+	return make (Constructor::LITERAL, it->second);
+      }
+
+    default:
+      return opaque ();
+    }
+}
+
+const MatchChecker::DeconstructedPat *
+MatchChecker::deconstruct_range (RangePattern &pattern,
+				 const TyTy::BaseType *ty)
+{
+  // bounds naming constants would need their value
+  RangePatternBound *bounds[]
+    = {pattern.get_lower_bound ().get (), pattern.get_upper_bound ().get ()};
+  widest_int values[2];
+  for (size_t i = 0; i < 2; i++)
+    {
+      if (bounds[i]->get_bound_type ()
+	  != RangePatternBound::RangePatternBoundType::LITERAL)
+	return opaque ();
+
+      auto bound = static_cast<RangePatternBoundLiteral *> (bounds[i]);
+      if (!literal_value (bound->get_literal (), bound->get_has_minus (), ty,
+			  &values[i]))
+	return opaque ();
+    }
+
+  if (wi::gts_p (values[0], values[1]))
+    return opaque ();
+
+  DeconstructedPat *result = make (Constructor::RANGE);
+  result->ctor.lo = values[0];
+  result->ctor.hi = values[1];
+  return result;
+}
+
+const MatchChecker::DeconstructedPat *
+MatchChecker::deconstruct_adt (Pattern &pattern, const TyTy::BaseType *ty)
+{
+  if (ty->get_kind () != TyTy::TypeKind::ADT)
+    return opaque ();
+
+  auto adt = static_cast<const TyTy::ADTType *> (ty);
+  if (adt->is_union () || adt->number_of_variants () == 0)
+    return opaque ();
+
+  PathInExpression *path = nullptr;
+  switch (pattern.get_pattern_type ())
+    {
+    case Pattern::PatternType::STRUCT:
+      path = &static_cast<StructPattern &> (pattern).get_path ();
+      break;
+    case Pattern::PatternType::TUPLE_STRUCT:
+      path = &static_cast<TupleStructPattern &> (pattern).get_path ();
+      break;
+    default:
+      // a path naming anything but a variant is a constant
+      if (!adt->is_enum ())
+	return opaque ();
+      path = static_cast<PathInExpression *> (&pattern);
+      break;
+    }
+
+  TyTy::VariantDef *variant = adt->get_variants ().at (0);
+  int variant_index = 0;
+  if (adt->is_enum ())
+    {
+      HirId variant_id = UNKNOWN_HIRID;
+      if (!tyctx.lookup_variant_definition (path->get_mappings ().get_hirid (),
+					    &variant_id)
+	  || !adt->lookup_variant_by_id (variant_id, &variant, &variant_index))
+	return opaque ();
+    }
+
+  DeconstructedPat *result
+    = make (adt->is_enum () ? Constructor::VARIANT : Constructor::SINGLE,
+	    variant_index);
+  Types types = field_types (result->ctor, ty);
+  switch (pattern.get_pattern_type ())
+    {
+      case Pattern::PatternType::TUPLE_STRUCT: {
+	auto &items = static_cast<TupleStructPattern &> (pattern).get_items ();
+	bool ok;
+	if (items->get_item_type () == TupleStructItems::ItemType::NO_RANGE)
+	  ok = deconstruct_fields (
+	    static_cast<TupleStructItemsNoRange &> (*items).get_patterns (),
+	    nullptr, types, result);
+	else
+	  {
+	    auto &range = static_cast<TupleStructItemsRange &> (*items);
+	    ok = deconstruct_fields (range.get_lower_patterns (),
+				     &range.get_upper_patterns (), types,
+				     result);
+	  }
+	if (!ok)
+	  return opaque ();
+      }
+      break;
+
+      case Pattern::PatternType::STRUCT: {
+	// the fields left out, and those binding their value, match anything
+	result->fields.assign (types.size (), wildcard);
+
+	auto &elems = static_cast<StructPattern &> (pattern)
+			.get_struct_pattern_elems ()
+			.get_struct_pattern_fields ();
+	for (auto &field : elems)
+	  {
+	    size_t index = 0;
+	    Pattern *sub = nullptr;
+	    switch (field->get_item_type ())
+	      {
+		case StructPatternField::ItemType::TUPLE_PAT: {
+		  auto &tuple_field
+		    = static_cast<StructPatternFieldTuplePat &> (*field);
+		  index = tuple_field.get_index ();
+		  sub = tuple_field.get_tuple_pattern ().get ();
+		}
+		break;
+
+		case StructPatternField::ItemType::IDENT_PAT: {
+		  auto &ident_field
+		    = static_cast<StructPatternFieldIdentPat &> (*field);
+		  if (!variant->lookup_field (ident_field.get_identifier (),
+					      nullptr, &index))
+		    return opaque ();
+		  sub = ident_field.get_ident_pattern ().get ();
+		}
+		break;
+
+	      default:
+		continue;
+	      }
+
+	    if (index >= types.size ())
+	      return opaque ();
+	    result->fields[index] = deconstruct (sub, types[index]);
+	  }
+      }
+      break;
+
+    default:
+      if (!types.empty ())
+	return opaque ();
+      break;
+    }
+
+  return result;
+}
+
+// Deconstruct the patterns of the fields of RESULT, whose types are TYPES.
+// When UPPER is given, the patterns were split by a `..`, which stands for as
+// many wildcards as there are fields between LOWER and UPPER.
+bool
+MatchChecker::deconstruct_fields (
+  const std::vector<std::unique_ptr<Pattern>> &lower,
+  const std::vector<std::unique_ptr<Pattern>> *upper, const Types &types,
+  DeconstructedPat *result)
+{
+  size_t num_upper = upper != nullptr ? upper->size () : 0;
+  if (upper == nullptr ? lower.size () != types.size ()
+		       : lower.size () + num_upper > types.size ())
+    return false;
+
+  size_t first_upper = types.size () - num_upper;
+  for (size_t i = 0; i < types.size (); i++)
+    {
+      if (i < lower.size ())
+	result->fields.push_back (deconstruct (lower[i].get (), types[i]));
+      else if (i < first_upper)
+	result->fields.push_back (wildcard);
+      else
+	result->fields.push_back (
+	  deconstruct (upper->at (i - first_upper).get (), types[i]));
+    }
+  return true;
+}
+
+MatchChecker::Types
+MatchChecker::field_types (const Constructor &ctor, const TyTy::BaseType *ty)
+{
+  Types types;
+  if (ctor.kind == Constructor::SINGLE
+      && ty->get_kind () == TyTy::TypeKind::TUPLE)
+    {
+      auto tuple = static_cast<const TyTy::TupleType *> (ty);
+      for (size_t i = 0; i < tuple->num_fields (); i++)
+	types.push_back (tuple->get_field (i)->destructure ());
+    }
+  else if (ctor.kind == Constructor::SINGLE
+	   || ctor.kind == Constructor::VARIANT)
+    {
+      auto adt = static_cast<const TyTy::ADTType *> (ty);
+      TyTy::VariantDef *variant = adt->get_variants ().at (ctor.index);
+      for (size_t i = 0; i < variant->num_fields (); i++)
+	types.push_back (
+	  variant->get_field_at_index (i)->get_field_type ()->destructure ());
+    }
+
+  return types;
+}
+
+bool
+MatchChecker::constructors_of (const TyTy::BaseType *ty,
+			       const std::vector<Constructor> &present,
+			       std::vector<Constructor> &ctors,
+			       std::vector<Constructor> &missing)
+{
+  Constructor ctor = wildcard->ctor;
+  switch (ty->get_kind ())
+    {
+      case TyTy::TypeKind::ADT: {
+	auto adt = static_cast<const TyTy::ADTType *> (ty);
+	if (adt->is_union ())
+	  return false;
+
+	if (adt->is_enum ())
+	  {
+	    std::vector<bool> seen (adt->number_of_variants (), false);
+	    for (auto &p : present)
+	      if (p.kind == Constructor::VARIANT)
+		seen[p.index] = true;
+
+	    ctor.kind = Constructor::VARIANT;
+	    for (size_t i = 0; i < seen.size (); i++)
+	      {
+		ctor.index = i;
+		ctors.push_back (ctor);
+		if (!seen[i])
+		  missing.push_back (ctor);
+	      }
+	    return true;
+	  }
+      }
+      gcc_fallthrough ();
+
+      case TyTy::TypeKind::TUPLE: {
+	ctor.kind = Constructor::SINGLE;
+	ctors.push_back (ctor);
+	bool seen = false;
+	for (auto &p : present)
+	  seen |= p.kind == Constructor::SINGLE;
+	if (!seen)
+	  missing.push_back (ctor);
+	return true;
+      }
+
+    default:
+      break;
+    }
+
+  Ranges domain;
+  if (!integral_domain (ty, domain))
+    return false;
+
+  for (auto &range : domain)
+    split_range (range.first, range.second, present, ctors);
+
+  for (auto &part : ctors)
+    if (std::none_of (present.begin (), present.end (),
+		      [&] (const Constructor &p) { return covers (p, part); }))
+      missing.push_back (part);
+
+  return true;
+}
+
+bool
+MatchChecker::specialize (const Row &row, const Constructor &ctor,
+			  size_t arity, Row &specialized)
+{
+  const DeconstructedPat *head = row[0];
+  if (head->ctor.kind == Constructor::WILDCARD)
+    specialized.assign (arity, wildcard);
+  else if (covers (head->ctor, ctor))
+    specialized = head->fields;
+  else
+    return false;
+
+  specialized.insert (specialized.end (), row.begin () + 1, row.end ());
+  return true;
+}
+
+bool
+MatchChecker::is_useful_for (const Constructor &ctor,
+			     const std::vector<Row> &matrix, const Row &row,
+			     const Types &types,
+			     std::vector<std::string> *witness)
+{
+  Types sub_types = field_types (ctor, types[0]);
+  size_t arity = sub_types.size ();
+  sub_types.insert (sub_types.end (), types.begin () + 1, types.end ());
+
+  std::vector<Row> specialized;
+  for (auto &other : matrix)
+    {
+      Row s;
+      if (specialize (other, ctor, arity, s))
+	specialized.push_back (std::move (s));
+    }
+
+  Row sub_row;
+  if (!specialize (row, ctor, arity, sub_row))
+    return false;
+
+  if (!is_useful (specialized, sub_row, sub_types, witness))
+    return false;
+
+  if (witness != nullptr)
+    {
+      std::vector<std::string> fields (witness->begin (),
+				       witness->begin () + arity);
+      witness->erase (witness->begin (), witness->begin () + arity);
+      witness->insert (witness->begin (), to_string (ctor, types[0], fields));
+    }
+  return true;
+}
+
+bool
+MatchChecker::is_useful (const std::vector<Row> &matrix, const Row &row,
+			 const Types &types, std::vector<std::string> *witness)
+{
+  if (row.empty ())
+    return matrix.empty ();
+
+  const Constructor &head = row[0]->ctor;
+  std::vector<Constructor> present;
+  for (auto &other : matrix)
+    if (other[0]->ctor.kind != Constructor::WILDCARD)
+      present.push_back (other[0]->ctor);
+
+  if (head.kind != Constructor::WILDCARD)
+    {
+      // a range is useful when one of its parts is
+      std::vector<Constructor> parts;
+      if (head.kind == Constructor::RANGE)
+	split_range (head.lo, head.hi, present, parts);
+      else
+	parts.push_back (head);
+
+      for (auto &part : parts)
+	if (is_useful_for (part, matrix, row, types, witness))
+	  return true;
+      return false;
+    }
+
+  std::vector<Constructor> ctors, missing;
+  bool finite = constructors_of (types[0], present, ctors, missing);
+  if (finite && ctors.empty ())
+    return false;
+
+  // when some values are not covered by any constructor of the column, only
+  // the rows starting with a wildcard can match them
+  if (!finite || !missing.empty ())
+    {
+      std::vector<Row> rest;
+      for (auto &other : matrix)
+	if (other[0]->ctor.kind == Constructor::WILDCARD)
+	  rest.push_back (Row (other.begin () + 1, other.end ()));
+
+      if (!is_useful (rest, Row (row.begin () + 1, row.end ()),
+		      Types (types.begin () + 1, types.end ()), witness))
+	return false;
+
+      if (witness != nullptr)
+	{
+	  bool covered = std::any_of (present.begin (), present.end (),
+				      [] (const Constructor &p) {
+					return p.kind != Constructor::OPAQUE
+					       && p.kind != Constructor::LITERAL;
+				      });
+	  std::vector<std::string> fields;
+	  if (finite && covered)
+	    fields.assign (field_types (missing[0], types[0]).size (), "_");
+	  witness->insert (witness->begin (),
+			   finite && covered
+			     ? to_string (missing[0], types[0], fields)
+			     : "_");
+	}
+      return true;
+    }
+
+  for (auto &ctor : ctors)
+    if (is_useful_for (ctor, matrix, row, types, witness))
+      return true;
+  return false;
+}
+
+static std::string
+value_string (const widest_int &value, const TyTy::BaseType *ty)
+{
+  if (ty->get_kind () == TyTy::TypeKind::BOOL)
+    return wi::eq_p (value, 0) ? "false" : "true";
+
+  if (ty->get_kind () == TyTy::TypeKind::CHAR)
+    {
+      unsigned HOST_WIDE_INT code = value.to_uhwi ();
+      if (code >= 0x20 && code < 0x7f && code != '\'' && code != '\\')
+	return std::string ("'") + static_cast<char> (code) + "'";
+
+      char buf[16];
+      snprintf (buf, sizeof (buf), "'\\u{%x}'", static_cast<unsigned> (code));
+      return buf;
+    }
+
+  char buf[WIDE_INT_PRINT_BUFFER_SIZE];
+  print_dec (value, buf, SIGNED);
+  return buf;
+}
+
+std::string
+MatchChecker::to_string (const Constructor &ctor, const TyTy::BaseType *ty,
+			 const std::vector<std::string> &fields)
+{
+  switch (ctor.kind)
+    {
+    case Constructor::RANGE:
+      if (wi::eq_p (ctor.lo, ctor.hi))
+	return value_string (ctor.lo, ty);
+      return value_string (ctor.lo, ty) + "..=" + value_string (ctor.hi, ty);
+
+    case Constructor::SINGLE:
+    case Constructor::VARIANT:
+      break;
+
+    default:
+      return "_";
+    }
+
+  std::string str;
+  TyTy::VariantDef *variant = nullptr;
+  if (ty->get_kind () == TyTy::TypeKind::ADT)
+    {
+      auto adt = static_cast<const TyTy::ADTType *> (ty);
+      variant = adt->get_variants ().at (ctor.index);
+      str = adt->get_identifier ();
+      if (adt->is_enum ())
+	str += "::" + variant->get_identifier ();
+    }
+
+  bool named = variant != nullptr
+	       && variant->get_variant_type ()
+		    == TyTy::VariantDef::VariantType::STRUCT;
+  if (variant != nullptr && variant->is_dataless_variant ())
+    return str;
+
+  str += named ? " { " : "(";
+  for (size_t i = 0; i < fields.size (); i++)
+    {
+      if (i > 0)
+	str += ", ";
+      if (named)
+	str += variant->get_field_at_index (i)->get_name () + ": ";
+      str += fields[i];
+    }
+  str += named ? " }" : "";
+  if (!named)
+    str += fields.size () == 1 && variant == nullptr ? ",)" : ")";
+
+  return str;
+}
+
+} // namespace HIR
+} // namespace Rust
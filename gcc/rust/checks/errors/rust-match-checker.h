@@ -0,0 +1,133 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+
+#ifndef RUST_MATCH_CHECKER_H
+#define RUST_MATCH_CHECKER_H
+
+#include "rust-hir-full.h"
+#include "rust-hir-type-check.h"
+
+namespace Rust {
+namespace HIR {
+
+/* Checks that the arms of every match expression cover all the values of its
+ * scrutinee, and warns about the patterns which can never be reached.
+ *
+ * Both questions are answered with the usefulness algorithm over a matrix of
+ * patterns, one row per arm: a row is useful when some value matches it and
+ * none of the rows above it, and a match is exhaustive when a wildcard is not
+ * useful after all of its arms. Integer, char and bool ranges are split at the
+ * boundaries of the ranges found in their column, so the work depends on the
+ * number of patterns rather than on the number of values, and a column whose
+ * rows are all wildcards is skipped without enumerating the variants of its
+ * type.
+ *
+ * Patterns outside of the analysis, such as ranges bounded by constants, match
+ * some values but are never assumed to cover any, as rustc does: they do not
+ * make the arms after them unreachable, and a match needs other arms covering
+ * their values to be exhaustive. */
+class MatchChecker
+{
+public:
+  // Check the match expressions recorded by the type checker
+  static void go ();
+
+  // What a pattern is built from, regardless of its fields
+  struct Constructor
+  {
+    enum Kind
+    {
+      // matches anything
+      WILDCARD,
+      // the only constructor of a struct or of a tuple
+      SINGLE,
+      // variant INDEX of an enum
+      VARIANT,
+      // the integers, chars or bools from LO to HI included
+      RANGE,
+      // a string or float literal, only covering itself
+      LITERAL,
+      // a pattern outside of the analysis, covering nothing
+      OPAQUE,
+    };
+
+    Kind kind;
+    // the variant of a VARIANT, or the value of a LITERAL or OPAQUE
+    size_t index;
+    widest_int lo;
+    widest_int hi;
+  };
+
+  struct DeconstructedPat
+  {
+    Constructor ctor;
+    std::vector<const DeconstructedPat *> fields;
+  };
+
+  typedef std::vector<const DeconstructedPat *> Row;
+  typedef std::vector<const TyTy::BaseType *> Types;
+
+private:
+  MatchChecker ();
+
+  void check (MatchExpr &expr);
+
+  const DeconstructedPat *deconstruct (Pattern *pattern,
+				       const TyTy::BaseType *ty);
+  const DeconstructedPat *deconstruct_literal (const Literal &lit,
+					       const TyTy::BaseType *ty);
+  const DeconstructedPat *
+  deconstruct_range (RangePattern &pattern, const TyTy::BaseType *ty);
+  const DeconstructedPat *deconstruct_adt (Pattern &pattern,
+					   const TyTy::BaseType *ty);
+  bool deconstruct_fields (const std::vector<std::unique_ptr<Pattern>> &lower,
+			   const std::vector<std::unique_ptr<Pattern>> *upper,
+			   const Types &types, DeconstructedPat *result);
+  DeconstructedPat *make (Constructor::Kind kind, size_t index = 0);
+  const DeconstructedPat *opaque ();
+
+  bool is_useful (const std::vector<Row> &matrix, const Row &row,
+		  const Types &types, std::vector<std::string> *witness);
+  bool is_useful_for (const Constructor &ctor, const std::vector<Row> &matrix,
+		      const Row &row, const Types &types,
+		      std::vector<std::string> *witness);
+
+  bool constructors_of (const TyTy::BaseType *ty,
+			const std::vector<Constructor> &present,
+			std::vector<Constructor> &ctors,
+			std::vector<Constructor> &missing);
+  Types field_types (const Constructor &ctor, const TyTy::BaseType *ty);
+  bool specialize (const Row &row, const Constructor &ctor, size_t arity,
+		   Row &specialized);
+  std::string to_string (const Constructor &ctor, const TyTy::BaseType *ty,
+			 const std::vector<std::string> &fields);
+
+  Resolver::TypeCheckContext &tyctx;
+
+  std::vector<std::unique_ptr<DeconstructedPat>> patterns;
+  DeconstructedPat wildcard_pattern;
+  const DeconstructedPat *wildcard;
+  std::map<std::string, size_t> literals;
+  size_t opaque_count;
+};
+
+} // namespace HIR
+} // namespace Rust
+
+#endif // RUST_MATCH_CHECKER_H
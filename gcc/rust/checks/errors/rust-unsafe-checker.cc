@@ -35,7 +35,13 @@ void
 UnsafeChecker::go (HIR::Crate &crate)
 {
   for (auto &item : crate.items)
-    item->accept_vis (*this);
+    check (*item);
+}
+
+void
+UnsafeChecker::check (HIR::Item &item)
+{
+  item.accept_vis (*this);
 }
 
 static void
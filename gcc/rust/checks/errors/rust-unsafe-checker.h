@@ -33,6 +33,9 @@ public:
 
   void go (HIR::Crate &crate);
 
+  // check a single top level item, for use in an ItemPassManager
+  void check (HIR::Item &item);
+
 private:
   /**
    * Check if a mutable static or external static item is used outside of an
@@ -63,7 +63,7 @@ private:
   std::vector<HirId> getEntryPoint () { return entryPoints; }
 };
 
-std::set<HirId>
+DenseIdSet
 MarkLive::Analysis (HIR::Crate &crate)
 {
   MarkLive marklive (FindEntryPoint::find (crate));
@@ -84,9 +84,9 @@ MarkLive::go (HIR::Crate &crate)
     {
       HirId hirId = worklist.back ();
       worklist.pop_back ();
-      scannedSymbols.emplace (hirId);
+      scannedSymbols.insert (hirId);
       HIR::Item *item = mappings->lookup_hir_item (hirId);
-      liveSymbols.emplace (hirId);
+      liveSymbols.insert (hirId);
       if (item != nullptr)
 	{
 	  item->accept_vis (*this);
@@ -261,11 +261,11 @@ MarkLive::visit (HIR::TypeAlias &alias)
 void
 MarkLive::mark_hir_id (HirId id)
 {
-  if (scannedSymbols.find (id) == scannedSymbols.end ())
+  if (!scannedSymbols.contains (id))
     {
       worklist.push_back (id);
     }
-  liveSymbols.emplace (id);
+  liveSymbols.insert (id);
 }
 
 void
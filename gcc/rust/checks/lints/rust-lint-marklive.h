@@ -23,6 +23,7 @@
 #include "rust-hir-map.h"
 #include "rust-lint-marklive-base.h"
 #include "rust-name-resolver.h"
+#include "rust-dense-id-map.h"
 
 namespace Rust {
 namespace Analysis {
@@ -32,7 +33,7 @@ class MarkLive : public MarkLiveBase
   using Rust::Analysis::MarkLiveBase::visit;
 
 public:
-  static std::set<HirId> Analysis (HIR::Crate &crate);
+  static DenseIdSet Analysis (HIR::Crate &crate);
   void go (HIR::Crate &crate);
 
   void visit (HIR::PathInExpression &expr) override;
@@ -287,8 +288,8 @@ public:
 
 private:
   std::vector<HirId> worklist;
-  std::set<HirId> liveSymbols;
-  std::set<HirId> scannedSymbols;
+  DenseIdSet liveSymbols;
+  DenseIdSet scannedSymbols;
   Analysis::Mappings *mappings;
   Resolver::Resolver *resolver;
   Resolver::TypeCheckContext *tyctx;
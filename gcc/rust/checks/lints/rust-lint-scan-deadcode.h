@@ -42,7 +42,7 @@ class ScanDeadcode : public MarkLiveBase
 public:
   static void Scan (HIR::Crate &crate)
   {
-    std::set<HirId> live_symbols = Analysis::MarkLive::Analysis (crate);
+    DenseIdSet live_symbols = Analysis::MarkLive::Analysis (crate);
     ScanDeadcode sdc (live_symbols);
     for (auto it = crate.items.begin (); it != crate.items.end (); it++)
       {
@@ -61,14 +61,14 @@ public:
 	      = mappings->lookup_associated_impl (hirId);
 	    if (!implBlock->has_trait_ref ())
 	      {
-		rust_warning_at (function.get_locus (), 0,
+		rust_warning_at (function.get_locus (), OPT_Wdead_code,
 				 "associated function is never used: %<%s%>",
 				 function.get_function_name ().c_str ());
 	      }
 	  }
 	else
 	  {
-	    rust_warning_at (function.get_locus (), 0,
+	    rust_warning_at (function.get_locus (), OPT_Wdead_code,
 			     "function is never used: %<%s%>",
 			     function.get_function_name ().c_str ());
 	  }
@@ -82,7 +82,7 @@ public:
       {
 	bool name_starts_underscore = stct.get_identifier ().at (0) == '_';
 	if (!name_starts_underscore)
-	  rust_warning_at (stct.get_locus (), 0,
+	  rust_warning_at (stct.get_locus (), OPT_Wdead_code,
 			   "struct is never constructed: %<%s%>",
 			   stct.get_identifier ().c_str ());
       }
@@ -95,7 +95,7 @@ public:
 	    if (should_warn (field_hir_id)
 		&& !field.get_visibility ().is_public ())
 	      {
-		rust_warning_at (field.get_locus (), 0,
+		rust_warning_at (field.get_locus (), OPT_Wdead_code,
 				 "field is never read: %<%s%>",
 				 field.get_field_name ().c_str ());
 	      }
@@ -109,7 +109,7 @@ public:
     HirId hirId = stct.get_mappings ().get_hirid ();
     if (should_warn (hirId) && !stct.get_visibility ().is_public ())
       {
-	rust_warning_at (stct.get_locus (), 0,
+	rust_warning_at (stct.get_locus (), OPT_Wdead_code,
 			 "struct is never constructed: %<%s%>",
 			 stct.get_identifier ().c_str ());
       }
@@ -133,11 +133,11 @@ public:
   }
 
 private:
-  std::set<HirId> live_symbols;
+  DenseIdSet live_symbols;
   Resolver::Resolver *resolver;
   Analysis::Mappings *mappings;
 
-  ScanDeadcode (std::set<HirId> &live_symbols)
+  ScanDeadcode (DenseIdSet &live_symbols)
     : live_symbols (live_symbols), resolver (Resolver::Resolver::get ()),
       mappings (Analysis::Mappings::get ()){};
 
@@ -145,7 +145,7 @@ private:
   {
     // TODO: There are more condition to check if should warn, i.e visibility,
     // attributes.
-    return live_symbols.find (hirId) == live_symbols.end ();
+    return !live_symbols.contains (hirId);
   }
 };
 
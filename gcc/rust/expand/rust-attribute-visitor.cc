@@ -18,6 +18,7 @@
 
 #include "rust-attribute-visitor.h"
 #include "rust-session-manager.h"
+#include "rust-derive.h"
 
 namespace Rust {
 
@@ -1224,6 +1225,10 @@ AttrVisitor::visit (AST::BlockExpr &expr)
       return;
     }
 
+  // the parser found nothing to strip or expand inside the braces
+  if (expr.is_expansion_free ())
+    return;
+
   /* strip test based on inner attrs - spec says there are inner
    * attributes, not just outer attributes of inner stmts */
   expander.expand_cfg_attrs (expr.get_inner_attrs ());
@@ -2157,8 +2162,14 @@ AttrVisitor::visit (AST::Module &module)
       module.load_items ();
     }
 
+  // the external modules this one declares are loaded as its items are
+  // visited, get the kernel reading their files in the meantime
+  AST::Module::prefetch_files (module.get_items ());
+
   // strip items if required
   expand_pointer_allow_strip (module.get_items ());
+
+  DeriveExpander::expand (module.get_items ());
 }
 void
 AttrVisitor::visit (AST::ExternCrate &extern_crate)
@@ -2215,6 +2226,10 @@ AttrVisitor::visit (AST::Function &function)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (function.is_expansion_free ())
+    return;
+
   // just expand sub-stuff - can't actually strip generic params themselves
   for (auto &param : function.get_generic_params ())
     param->accept_vis (*this);
@@ -2263,6 +2278,10 @@ AttrVisitor::visit (AST::TypeAlias &type_alias)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (type_alias.is_expansion_free ())
+    return;
+
   // just expand sub-stuff - can't actually strip generic params themselves
   for (auto &param : type_alias.get_generic_params ())
     param->accept_vis (*this);
@@ -2286,6 +2305,10 @@ AttrVisitor::visit (AST::StructStruct &struct_item)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (struct_item.is_expansion_free ())
+    return;
+
   // just expand sub-stuff - can't actually strip generic params themselves
   for (auto &param : struct_item.get_generic_params ())
     param->accept_vis (*this);
@@ -2308,6 +2331,10 @@ AttrVisitor::visit (AST::TupleStruct &tuple_struct)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (tuple_struct.is_expansion_free ())
+    return;
+
   // just expand sub-stuff - can't actually strip generic params themselves
   for (auto &param : tuple_struct.get_generic_params ())
     param->accept_vis (*this);
@@ -2392,6 +2419,10 @@ AttrVisitor::visit (AST::Enum &enum_item)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (enum_item.is_expansion_free ())
+    return;
+
   // just expand sub-stuff - can't actually strip generic params themselves
   for (auto &param : enum_item.get_generic_params ())
     param->accept_vis (*this);
@@ -2414,6 +2445,10 @@ AttrVisitor::visit (AST::Union &union_item)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (union_item.is_expansion_free ())
+    return;
+
   // just expand sub-stuff - can't actually strip generic params themselves
   for (auto &param : union_item.get_generic_params ())
     param->accept_vis (*this);
@@ -2436,6 +2471,10 @@ AttrVisitor::visit (AST::ConstantItem &const_item)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (const_item.is_expansion_free ())
+    return;
+
   expander.push_context (MacroExpander::ContextType::TYPE);
 
   // strip any sub-types
@@ -2470,6 +2509,10 @@ AttrVisitor::visit (AST::StaticItem &static_item)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (static_item.is_expansion_free ())
+    return;
+
   expander.push_context (MacroExpander::ContextType::TYPE);
 
   // strip any sub-types
@@ -2611,6 +2654,10 @@ AttrVisitor::visit (AST::Trait &trait)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (trait.is_expansion_free ())
+    return;
+
   // strip test based on inner attrs
   expander.expand_cfg_attrs (trait.get_inner_attrs ());
   if (expander.fails_cfg_with_expand (trait.get_inner_attrs ()))
@@ -2650,6 +2697,10 @@ AttrVisitor::visit (AST::InherentImpl &impl)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (impl.is_expansion_free ())
+    return;
+
   // strip test based on inner attrs
   expander.expand_cfg_attrs (impl.get_inner_attrs ());
   if (expander.fails_cfg_with_expand (impl.get_inner_attrs ()))
@@ -2694,6 +2745,10 @@ AttrVisitor::visit (AST::TraitImpl &impl)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (impl.is_expansion_free ())
+    return;
+
   // strip test based on inner attrs
   expander.expand_cfg_attrs (impl.get_inner_attrs ());
   if (expander.fails_cfg_with_expand (impl.get_inner_attrs ()))
@@ -2841,6 +2896,10 @@ AttrVisitor::visit (AST::ExternBlock &block)
       return;
     }
 
+  // the parser found nothing to strip or expand past the outer attributes
+  if (block.is_expansion_free ())
+    return;
+
   // strip test based on inner attrs
   expander.expand_cfg_attrs (block.get_inner_attrs ());
   if (expander.fails_cfg_with_expand (block.get_inner_attrs ()))
@@ -0,0 +1,565 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-derive.h"
+#include "rust-diagnostics.h"
+
+namespace Rust {
+
+void
+DeriveExpander::expand (std::vector<std::unique_ptr<AST::Item>> &items)
+{
+  for (auto it = items.begin (); it != items.end (); it++)
+    {
+      AST::Kind kind = (*it)->get_ast_kind ();
+      if (kind != AST::Kind::STRUCT_STRUCT && kind != AST::Kind::TUPLE_STRUCT
+	  && kind != AST::Kind::ENUM && kind != AST::Kind::UNION)
+	continue;
+
+      auto &item = static_cast<AST::VisItem &> (**it);
+      std::vector<std::unique_ptr<AST::Item>> impls;
+      for (auto &attr : item.get_outer_attrs ())
+	{
+	  if (attr.get_path () != "derive")
+	    continue;
+
+	  if (kind == AST::Kind::UNION)
+	    {
+	      rust_sorry_at (attr.get_locus (), "derive on unions");
+	      continue;
+	    }
+
+	  attr.parse_attr_to_meta_item ();
+	  if (!attr.has_attr_input () || !attr.is_parsed_to_meta_item ())
+	    {
+	      rust_error_at (attr.get_locus (),
+			     "malformed %<derive%> attribute input");
+	      continue;
+	    }
+
+	  auto &input = static_cast<AST::AttrInputMetaItemContainer &> (
+	    attr.get_attr_input ());
+	  DeriveExpander expander (item, attr.get_locus ());
+	  for (auto &meta : input.get_items ())
+	    {
+	      // only the last segment of paths such as `core::clone::Clone`
+	      // names the trait
+	      std::string trait = meta->as_string ();
+	      size_t sep = trait.rfind ("::");
+	      if (sep != std::string::npos)
+		trait = trait.substr (sep + 2);
+
+	      auto impl = expander.derive (trait);
+	      if (impl != nullptr)
+		impls.push_back (std::move (impl));
+	    }
+	}
+
+      for (auto &impl : impls)
+	it = items.insert (it + 1, std::move (impl));
+    }
+}
+
+DeriveExpander::DeriveExpander (AST::VisItem &item, Location locus)
+  : locus (locus), builder (locus), generic_params (nullptr),
+    has_where_clause (false), is_enum (false)
+{
+  switch (item.get_ast_kind ())
+    {
+      case AST::Kind::STRUCT_STRUCT: {
+	auto &s = static_cast<AST::StructStruct &> (item);
+	name = s.get_struct_name ();
+	generic_params = &s.get_generic_params ();
+	has_where_clause = s.has_where_clause ();
+
+	Variant variant ({name}, s.is_unit_struct () ? Variant::UNIT
+						     : Variant::STRUCT);
+	for (auto &field : s.get_fields ())
+	  {
+	    variant.fields.push_back (field.get_field_name ());
+	    variant.types.push_back (field.get_field_type ().get ());
+	  }
+	variants.push_back (std::move (variant));
+      }
+      break;
+
+      case AST::Kind::TUPLE_STRUCT: {
+	auto &s = static_cast<AST::TupleStruct &> (item);
+	name = s.get_struct_name ();
+	generic_params = &s.get_generic_params ();
+	has_where_clause = s.has_where_clause ();
+
+	Variant variant ({name}, Variant::TUPLE);
+	for (auto &field : s.get_fields ())
+	  {
+	    variant.fields.push_back (std::to_string (variant.fields.size ()));
+	    variant.types.push_back (field.get_field_type ().get ());
+	  }
+	variants.push_back (std::move (variant));
+      }
+      break;
+
+      case AST::Kind::ENUM: {
+	auto &e = static_cast<AST::Enum &> (item);
+	name = e.get_identifier ();
+	generic_params = &e.get_generic_params ();
+	has_where_clause = e.has_where_clause ();
+	is_enum = true;
+
+	for (auto &enum_item : e.get_variants ())
+	  {
+	    std::vector<std::string> path = {name, enum_item->get_identifier ()};
+	    switch (enum_item->get_ast_kind ())
+	      {
+		case AST::Kind::ENUM_ITEM_TUPLE: {
+		  auto &tuple = static_cast<AST::EnumItemTuple &> (*enum_item);
+		  Variant variant (std::move (path), Variant::TUPLE);
+		  for (auto &field : tuple.get_tuple_fields ())
+		    {
+		      variant.fields.push_back (
+			std::to_string (variant.fields.size ()));
+		      variant.types.push_back (field.get_field_type ().get ());
+		    }
+		  variants.push_back (std::move (variant));
+		}
+		break;
+
+		case AST::Kind::ENUM_ITEM_STRUCT: {
+		  auto &fields = static_cast<AST::EnumItemStruct &> (*enum_item);
+		  Variant variant (std::move (path), Variant::STRUCT);
+		  for (auto &field : fields.get_struct_fields ())
+		    {
+		      variant.fields.push_back (field.get_field_name ());
+		      variant.types.push_back (field.get_field_type ().get ());
+		    }
+		  variants.push_back (std::move (variant));
+		}
+		break;
+
+	      default:
+		variants.push_back (Variant (std::move (path), Variant::UNIT));
+		break;
+	      }
+	  }
+      }
+      break;
+
+    default:
+      gcc_unreachable ();
+    }
+}
+
+std::unique_ptr<AST::Item>
+DeriveExpander::derive (const std::string &trait)
+{
+  if (has_where_clause)
+    {
+      rust_sorry_at (locus, "derive on items with a where clause");
+      return nullptr;
+    }
+
+  if (trait == "Clone")
+    return derive_clone ();
+  if (trait == "Copy" || trait == "Eq")
+    return trait_impl (trait, {});
+  if (trait == "PartialEq")
+    return derive_partial_eq ();
+  if (trait == "Hash")
+    return derive_hash ();
+  if (trait == "Default")
+    {
+      if (is_enum)
+	{
+	  rust_sorry_at (locus, "deriving %<Default%> on enums");
+	  return nullptr;
+	}
+      return derive_default ();
+    }
+
+  if (trait == "Debug" || trait == "PartialOrd" || trait == "Ord")
+    {
+      rust_sorry_at (locus, "deriving %qs", trait.c_str ());
+      return nullptr;
+    }
+
+  rust_error_at (locus, "cannot find derive macro %qs in this scope",
+		 trait.c_str ());
+  return nullptr;
+}
+
+// fn clone (&self) -> Self
+std::unique_ptr<AST::Item>
+DeriveExpander::derive_clone ()
+{
+  std::unique_ptr<AST::Expr> value;
+  if (!is_enum)
+    {
+      auto &variant = variants.front ();
+      std::vector<std::unique_ptr<AST::Expr>> clones;
+      for (auto &field : fields_of (variant, "self"))
+	clones.push_back (builder.method_call (std::move (field), "clone"));
+
+      value = construct (variant, std::move (clones));
+    }
+  else
+    {
+      std::vector<AST::MatchCase> cases;
+      for (auto &variant : variants)
+	{
+	  std::vector<std::unique_ptr<AST::Expr>> clones;
+	  for (auto &field : fields_of (variant, "__self"))
+	    clones.push_back (builder.method_call (std::move (field), "clone"));
+
+	  cases.push_back (
+	    builder.match_case (pattern (variant, "__self"),
+				construct (variant, std::move (clones))));
+	}
+
+      value = builder.match (builder.deref (builder.path ({"self"})),
+			     std::move (cases));
+    }
+
+  std::vector<std::unique_ptr<AST::TraitImplItem>> items;
+  items.push_back (method ("clone", {},
+			   builder.type (builder.type_path ("Self")),
+			   builder.block ({}, std::move (value))));
+
+  return trait_impl ("Clone", std::move (items));
+}
+
+// fn eq (&self, other: &Self) -> bool
+std::unique_ptr<AST::Item>
+DeriveExpander::derive_partial_eq ()
+{
+  auto all_equal = [this] (std::vector<std::unique_ptr<AST::Expr>> lhs,
+			   std::vector<std::unique_ptr<AST::Expr>> rhs) {
+    std::unique_ptr<AST::Expr> result;
+    for (size_t i = 0; i < lhs.size (); i++)
+      {
+	auto eq = builder.comparison (std::move (lhs[i]), std::move (rhs[i]),
+				      ComparisonOperator::EQUAL);
+	result = result == nullptr
+		   ? std::move (eq)
+		   : builder.lazy_and (std::move (result), std::move (eq));
+      }
+    return result == nullptr ? builder.literal_bool (true) : std::move (result);
+  };
+
+  std::unique_ptr<AST::Expr> value;
+  if (!is_enum)
+    {
+      auto &variant = variants.front ();
+      value
+	= all_equal (fields_of (variant, "self"), fields_of (variant, "other"));
+    }
+  else if (variants.empty ())
+    value = builder.literal_bool (true);
+  else
+    {
+      // match *self { V (__self_0..) => match *other { V (__arg_0..) => ..,
+      //                                                _ => false } .. }
+      std::vector<AST::MatchCase> cases;
+      for (auto &variant : variants)
+	{
+	  std::vector<AST::MatchCase> other_cases;
+	  other_cases.push_back (builder.match_case (
+	    pattern (variant, "__arg"), all_equal (fields_of (variant, "__self"),
+						   fields_of (variant, "__arg"))));
+	  if (variants.size () > 1)
+	    other_cases.push_back (
+	      builder.match_case (builder.wildcard (),
+				  builder.literal_bool (false)));
+
+	  cases.push_back (builder.match_case (
+	    pattern (variant, "__self"),
+	    builder.match (builder.deref (builder.path ({"other"})),
+			   std::move (other_cases))));
+	}
+
+      value = builder.match (builder.deref (builder.path ({"self"})),
+			     std::move (cases));
+    }
+
+  std::vector<AST::FunctionParam> params;
+  params.push_back (
+    AST::FunctionParam (builder.identifier_pattern ("other"),
+			builder.reference_type (builder.type_path ("Self")), {},
+			locus));
+
+  std::vector<std::unique_ptr<AST::TraitImplItem>> items;
+  items.push_back (method ("eq", std::move (params),
+			   builder.type (builder.type_path ("bool")),
+			   builder.block ({}, std::move (value))));
+
+  return trait_impl ("PartialEq", std::move (items));
+}
+
+// fn hash<H: Hasher> (&self, state: &mut H)
+std::unique_ptr<AST::Item>
+DeriveExpander::derive_hash ()
+{
+  auto hash_all = [this] (std::vector<std::unique_ptr<AST::Expr>> values) {
+    std::vector<std::unique_ptr<AST::Stmt>> stmts;
+    for (auto &value : values)
+      {
+	std::vector<std::unique_ptr<AST::Expr>> args;
+	args.push_back (builder.identifier ("state"));
+	stmts.push_back (builder.statementify (
+	  builder.method_call (std::move (value), "hash", std::move (args))));
+      }
+    return stmts;
+  };
+
+  std::unique_ptr<AST::BlockExpr> body;
+  if (!is_enum)
+    body = builder.block (hash_all (fields_of (variants.front (), "self")));
+  else
+    {
+      // the discriminant is hashed as an isize, followed by the fields
+      std::vector<AST::MatchCase> cases;
+      for (size_t i = 0; i < variants.size (); i++)
+	{
+	  std::vector<std::unique_ptr<AST::Expr>> values;
+	  values.push_back (builder.literal_isize (i));
+	  for (auto &field : fields_of (variants[i], "__self"))
+	    values.push_back (std::move (field));
+
+	  cases.push_back (
+	    builder.match_case (pattern (variants[i], "__self"),
+				builder.block (hash_all (std::move (values)))));
+	}
+
+      std::vector<std::unique_ptr<AST::Stmt>> stmts;
+      stmts.push_back (builder.statementify (
+	builder.match (builder.deref (builder.path ({"self"})),
+		       std::move (cases))));
+      body = builder.block (std::move (stmts));
+    }
+
+  std::vector<std::unique_ptr<AST::TypeParamBound>> bounds;
+  bounds.push_back (builder.trait_bound ("Hasher"));
+  std::vector<std::unique_ptr<AST::GenericParam>> method_generics;
+  method_generics.push_back (std::unique_ptr<AST::GenericParam> (
+    new AST::TypeParam ("H", locus, std::move (bounds))));
+
+  std::vector<AST::FunctionParam> params;
+  params.push_back (
+    AST::FunctionParam (builder.identifier_pattern ("state"),
+			builder.reference_type (builder.type_path ("H"), true),
+			{}, locus));
+
+  std::vector<std::unique_ptr<AST::TraitImplItem>> items;
+  items.push_back (method ("hash", std::move (params), nullptr,
+			   std::move (body), std::move (method_generics)));
+
+  return trait_impl ("Hash", std::move (items));
+}
+
+// fn default () -> Self
+std::unique_ptr<AST::Item>
+DeriveExpander::derive_default ()
+{
+  auto &variant = variants.front ();
+  std::vector<std::unique_ptr<AST::Expr>> values;
+  for (auto &type : variant.types)
+    values.push_back (
+      builder.qualified_call (type->clone_type (), "Default", "default"));
+
+  AST::FunctionQualifiers qualifiers (locus, AsyncConstStatus::NONE, false);
+  std::unique_ptr<AST::TraitImplItem> function (new AST::Function (
+    "default", qualifiers, {}, {}, builder.type (builder.type_path ("Self")),
+    AST::WhereClause::create_empty (),
+    builder.block ({}, construct (variant, std::move (values))),
+    AST::Visibility::create_private (), {}, locus));
+
+  std::vector<std::unique_ptr<AST::TraitImplItem>> items;
+  items.push_back (std::move (function));
+
+  return trait_impl ("Default", std::move (items));
+}
+
+/* impl<'a, T: TRAIT, const N: usize> TRAIT for Name<'a, T, N> { ITEMS }
+
+   The generic parameters are rebuilt rather than cloned from the item so each
+   gets its own NodeId; their bounds other than TRAIT are not carried over.  */
+std::unique_ptr<AST::Item>
+DeriveExpander::trait_impl (
+  const std::string &trait,
+  std::vector<std::unique_ptr<AST::TraitImplItem>> items)
+{
+  std::vector<std::unique_ptr<AST::GenericParam>> impl_generics;
+  std::vector<AST::Lifetime> lifetime_args;
+  std::vector<AST::GenericArg> generic_args;
+  for (auto &param : *generic_params)
+    {
+      switch (param->get_kind ())
+	{
+	  case AST::GenericParam::Kind::Lifetime: {
+	    auto &lifetime_param = static_cast<AST::LifetimeParam &> (*param);
+	    AST::Lifetime lifetime = lifetime_param.get_lifetime ();
+	    AST::Lifetime::LifetimeType type = lifetime.get_lifetime_type ();
+	    std::string lifetime_name = lifetime.get_lifetime_name ();
+
+	    impl_generics.push_back (std::unique_ptr<AST::GenericParam> (
+	      new AST::LifetimeParam (AST::Lifetime (type, lifetime_name, locus),
+				      {}, AST::Attribute::create_empty (),
+				      locus)));
+	    lifetime_args.push_back (AST::Lifetime (type, lifetime_name, locus));
+	  }
+	  break;
+
+	  case AST::GenericParam::Kind::Type: {
+	    auto &type_param = static_cast<AST::TypeParam &> (*param);
+	    std::string type_name = type_param.get_type_representation ();
+
+	    std::vector<std::unique_ptr<AST::TypeParamBound>> bounds;
+	    bounds.push_back (builder.trait_bound (trait));
+	    impl_generics.push_back (std::unique_ptr<AST::GenericParam> (
+	      new AST::TypeParam (type_name, locus, std::move (bounds))));
+	    generic_args.push_back (AST::GenericArg::create_type (
+	      builder.type (builder.type_path (type_name))));
+	  }
+	  break;
+
+	  case AST::GenericParam::Kind::Const: {
+	    auto &const_param = static_cast<AST::ConstGenericParam &> (*param);
+
+	    impl_generics.push_back (std::unique_ptr<AST::GenericParam> (
+	      new AST::ConstGenericParam (const_param.get_name (),
+					  const_param.get_type ()->clone_type (),
+					  AST::GenericArg::create_error (),
+					  AST::Attribute::create_empty (),
+					  locus)));
+	    generic_args.push_back (
+	      AST::GenericArg::create_ambiguous (const_param.get_name (), locus));
+	  }
+	  break;
+	}
+    }
+
+  auto self_type = builder.type (builder.type_path (name,
+						    std::move (generic_args),
+						    std::move (lifetime_args)));
+
+  return std::unique_ptr<AST::Item> (
+    new AST::TraitImpl (builder.type_path (trait), false, false,
+			std::move (items), std::move (impl_generics),
+			std::move (self_type), AST::WhereClause::create_empty (),
+			AST::Visibility::create_private (), {}, {}, locus));
+}
+
+// A `&self` method
+std::unique_ptr<AST::TraitImplItem>
+DeriveExpander::method (
+  std::string method_name, std::vector<AST::FunctionParam> params,
+  std::unique_ptr<AST::Type> return_type, std::unique_ptr<AST::BlockExpr> body,
+  std::vector<std::unique_ptr<AST::GenericParam>> method_generics)
+{
+  AST::FunctionQualifiers qualifiers (locus, AsyncConstStatus::NONE, false);
+  AST::SelfParam self_param (AST::Lifetime::error (), false, locus);
+
+  return std::unique_ptr<AST::TraitImplItem> (
+    new AST::Method (std::move (method_name), qualifiers,
+		     std::move (method_generics), std::move (self_param),
+		     std::move (params), std::move (return_type),
+		     AST::WhereClause::create_empty (), std::move (body),
+		     AST::Visibility::create_private (), {}, locus));
+}
+
+/* The fields of VARIANT: those of the struct VALUE (`self.a`, `other.0`), or
+   for an enum the bindings VALUE_0, VALUE_1... made by pattern ().  */
+std::vector<std::unique_ptr<AST::Expr>>
+DeriveExpander::fields_of (const Variant &variant, const std::string &value)
+{
+  std::vector<std::unique_ptr<AST::Expr>> values;
+  for (size_t i = 0; i < variant.fields.size (); i++)
+    {
+      if (is_enum)
+	values.push_back (builder.identifier (value + "_" + std::to_string (i)));
+      else if (variant.shape == Variant::TUPLE)
+	values.push_back (builder.tuple_index (builder.path ({value}), i));
+      else
+	values.push_back (
+	  builder.field_access (builder.path ({value}), variant.fields[i]));
+    }
+
+  return values;
+}
+
+/* A pattern matching VARIANT and binding its fields to PREFIX_0,
+   PREFIX_1...  */
+std::unique_ptr<AST::Pattern>
+DeriveExpander::pattern (const Variant &variant, const std::string &prefix)
+{
+  switch (variant.shape)
+    {
+      case Variant::TUPLE: {
+	std::vector<std::unique_ptr<AST::Pattern>> fields;
+	for (size_t i = 0; i < variant.fields.size (); i++)
+	  fields.push_back (
+	    builder.identifier_pattern (prefix + "_" + std::to_string (i)));
+
+	return builder.tuple_struct_pattern (variant.path, std::move (fields));
+      }
+
+      case Variant::STRUCT: {
+	std::vector<std::pair<std::string, std::unique_ptr<AST::Pattern>>>
+	  fields;
+	for (size_t i = 0; i < variant.fields.size (); i++)
+	  fields.push_back (
+	    {variant.fields[i],
+	     builder.identifier_pattern (prefix + "_" + std::to_string (i))});
+
+	return builder.struct_pattern (variant.path, std::move (fields));
+      }
+
+    case Variant::UNIT:
+      break;
+    }
+
+  return builder.path_pattern (variant.path);
+}
+
+// Build VARIANT out of VALUES, one for each of its fields
+std::unique_ptr<AST::Expr>
+DeriveExpander::construct (const Variant &variant,
+			   std::vector<std::unique_ptr<AST::Expr>> values)
+{
+  switch (variant.shape)
+    {
+    case Variant::TUPLE:
+      return builder.call (builder.path (variant.path), std::move (values));
+
+      case Variant::STRUCT: {
+	std::vector<std::unique_ptr<AST::StructExprField>> fields;
+	for (size_t i = 0; i < values.size (); i++)
+	  fields.push_back (
+	    builder.struct_expr_field (variant.fields[i], std::move (values[i])));
+
+	return builder.struct_expr (builder.path_in_expression (variant.path),
+				    std::move (fields));
+      }
+
+    case Variant::UNIT:
+      break;
+    }
+
+  return builder.path (variant.path);
+}
+
+} // namespace Rust
@@ -0,0 +1,102 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_DERIVE_H
+#define RUST_DERIVE_H
+
+#include "rust-ast-full.h"
+#include "rust-ast-builder.h"
+
+namespace Rust {
+
+/* Expands the builtin #[derive] attributes on structs and enums. The trait
+ * implementations are built directly as AST nodes rather than as tokens run
+ * back through the parser, so derive-heavy crates don't pay for a second
+ * parse of every generated impl.
+ *
+ * The implementations refer to the traits by their bare name, as they are
+ * resolved where the item is declared. */
+class DeriveExpander
+{
+public:
+  /* Insert the implementations derived by each item of ITEMS right after
+   * it. */
+  static void expand (std::vector<std::unique_ptr<AST::Item>> &items);
+
+private:
+  // A struct, or an enum variant, seen as the set of values it is built from
+  struct Variant
+  {
+    enum Shape
+    {
+      UNIT,
+      TUPLE,
+      STRUCT
+    };
+
+    Variant (std::vector<std::string> path, Shape shape)
+      : path (std::move (path)), shape (shape)
+    {}
+
+    // Path used to build or match the value: `Foo` or `Foo::Bar`
+    std::vector<std::string> path;
+    Shape shape;
+    // Field names of a STRUCT variant, tuple indices of a TUPLE one
+    std::vector<std::string> fields;
+    std::vector<AST::Type *> types;
+  };
+
+  DeriveExpander (AST::VisItem &item, Location locus);
+
+  std::unique_ptr<AST::Item> derive (const std::string &trait);
+
+  std::unique_ptr<AST::Item> derive_clone ();
+  std::unique_ptr<AST::Item> derive_partial_eq ();
+  std::unique_ptr<AST::Item> derive_hash ();
+  std::unique_ptr<AST::Item> derive_default ();
+
+  std::unique_ptr<AST::Item>
+  trait_impl (const std::string &trait,
+	      std::vector<std::unique_ptr<AST::TraitImplItem>> items);
+  std::unique_ptr<AST::TraitImplItem>
+  method (std::string method_name, std::vector<AST::FunctionParam> params,
+	  std::unique_ptr<AST::Type> return_type,
+	  std::unique_ptr<AST::BlockExpr> body,
+	  std::vector<std::unique_ptr<AST::GenericParam>> method_generics = {});
+
+  std::vector<std::unique_ptr<AST::Expr>> fields_of (const Variant &variant,
+						     const std::string &value);
+  std::unique_ptr<AST::Pattern> pattern (const Variant &variant,
+					 const std::string &prefix);
+  std::unique_ptr<AST::Expr>
+  construct (const Variant &variant,
+	     std::vector<std::unique_ptr<AST::Expr>> values);
+
+  Location locus;
+  AST::AstBuilder builder;
+
+  std::string name;
+  std::vector<std::unique_ptr<AST::GenericParam>> *generic_params;
+  bool has_where_clause;
+  bool is_enum;
+  std::vector<Variant> variants;
+};
+
+} // namespace Rust
+
+#endif // RUST_DERIVE_H
@@ -32,7 +32,7 @@ std::unique_ptr<AST::Expr>
 make_string (Location locus, std::string value)
 {
   return std::unique_ptr<AST::Expr> (
-    new AST::LiteralExpr (value, AST::Literal::STRING,
+    new AST::LiteralExpr (std::move (value), AST::Literal::STRING,
 			  PrimitiveCoreType::CORETYPE_STR, {}, locus));
 }
 
@@ -231,30 +231,32 @@ source_relative_path (std::string path, Location locus)
   return dirname + path;
 }
 
-/* Read the full contents of the file FILENAME and return them in a vector.
+/* Read the full contents of the file FILENAME and return them in a string,
+   which the literal include_bytes! or include_str! expands to then owns.
    FIXME: platform specific.  */
 
-std::vector<uint8_t>
+std::string
 load_file_bytes (const char *filename)
 {
   RAIIFile file_wrap (filename);
   if (file_wrap.get_raw () == nullptr)
     {
       rust_error_at (Location (), "cannot open filename %s: %m", filename);
-      return std::vector<uint8_t> ();
+      return std::string ();
     }
+  Session::get_instance ().add_dependency (filename);
 
   FILE *f = file_wrap.get_raw ();
   fseek (f, 0L, SEEK_END);
   long fsize = ftell (f);
   fseek (f, 0L, SEEK_SET);
 
-  std::vector<uint8_t> buf (fsize);
+  std::string buf (fsize, '\0');
 
-  if (fread (&buf[0], fsize, 1, f) != 1)
+  if (fsize > 0 && fread (&buf[0], fsize, 1, f) != 1)
     {
       rust_error_at (Location (), "error reading file %s: %m", filename);
-      return std::vector<uint8_t> ();
+      return std::string ();
     }
 
   return buf;
@@ -310,28 +312,15 @@ MacroBuiltin::include_bytes (Location invoc_locus, AST::MacroInvocData &invoc)
   std::string target_filename
     = source_relative_path (lit_expr->as_string (), invoc_locus);
 
-  std::vector<uint8_t> bytes = load_file_bytes (target_filename.c_str ());
-
-  /* Is there a more efficient way to do this?  */
-  std::vector<std::unique_ptr<AST::Expr>> elts;
-  for (uint8_t b : bytes)
-    {
-      elts.emplace_back (
-	new AST::LiteralExpr (std::string (1, (char) b), AST::Literal::BYTE,
-			      PrimitiveCoreType::CORETYPE_U8,
-			      {} /* outer_attrs */, invoc_locus));
-    }
-
-  auto elems = std::unique_ptr<AST::ArrayElems> (
-    new AST::ArrayElemsValues (std::move (elts), invoc_locus));
+  std::string bytes = load_file_bytes (target_filename.c_str ());
 
-  auto array = std::unique_ptr<AST::Expr> (
-    new AST::ArrayExpr (std::move (elems), {}, {}, invoc_locus));
-
-  auto borrow = std::unique_ptr<AST::Expr> (
-    new AST::BorrowExpr (std::move (array), false, false, {}, invoc_locus));
-
-  auto node = AST::SingleASTNode (std::move (borrow));
+  /* A byte string literal already has the type &'static [u8; N], and is
+     compiled to a single read-only string constant, where an array of one
+     literal per byte costs several nodes for every byte of the file.  */
+  auto node = AST::SingleASTNode (std::unique_ptr<AST::Expr> (
+    new AST::LiteralExpr (std::move (bytes), AST::Literal::BYTE_STRING,
+			  PrimitiveCoreType::CORETYPE_UNKNOWN, {},
+			  invoc_locus)));
   return AST::ASTFragment ({node});
 }
 
@@ -353,12 +342,10 @@ MacroBuiltin::include_str (Location invoc_locus, AST::MacroInvocData &invoc)
   std::string target_filename
     = source_relative_path (lit_expr->as_string (), invoc_locus);
 
-  std::vector<uint8_t> bytes = load_file_bytes (target_filename.c_str ());
+  std::string str = load_file_bytes (target_filename.c_str ());
 
   /* FIXME: Enforce that the file contents are valid UTF-8.  */
-  std::string str ((const char *) &bytes[0], bytes.size ());
-
-  auto node = AST::SingleASTNode (make_string (invoc_locus, str));
+  auto node = AST::SingleASTNode (make_string (invoc_locus, std::move (str)));
   return AST::ASTFragment ({node});
 }
 
@@ -557,6 +544,7 @@ MacroBuiltin::include (Location invoc_locus, AST::MacroInvocData &invoc)
     }
 
   rust_debug ("Attempting to parse included file %s", target_filename);
+  Session::get_instance ().add_dependency (target_filename);
 
   Lexer lex (target_filename, std::move (target_file), linemap);
   Parser<Lexer> parser (lex);
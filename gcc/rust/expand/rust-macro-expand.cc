@@ -23,8 +23,76 @@
 #include "rust-diagnostics.h"
 #include "rust-parse.h"
 #include "rust-attribute-visitor.h"
+#include "rust-derive.h"
+#include "rust-trace.h"
 
 namespace Rust {
+
+/* Cheap check run before the full matcher of a rule: the leading tokens of the
+ * matcher are matched by id alone (see match_token), so compare them against
+ * the start of the invocation and rule out arms that could never match. A
+ * leading fragment or repetition can start with anything, so the check stops
+ * there. */
+static bool
+rule_prefix_may_match (
+  AST::MacroRule &rule,
+  const std::vector<std::unique_ptr<AST::Token>> &invoc_stream)
+{
+  if (rule.is_error ())
+    return true;
+
+  // the first token of the stream is the invocation's opening delimiter,
+  // which match_matcher accepts whatever the matcher's delimiter is
+  size_t offs = 1;
+  for (auto &match : rule.get_matcher ().get_matches ())
+    {
+      TokenId id = offs < invoc_stream.size ()
+		     ? invoc_stream.at (offs)->get_id ()
+		     : END_OF_FILE;
+
+      switch (match->get_macro_match_type ())
+	{
+	  case AST::MacroMatch::MacroMatchType::Tok: {
+	    AST::Token *tok = static_cast<AST::Token *> (match.get ());
+	    if (tok->get_id () != id)
+	      return false;
+	    offs++;
+	  }
+	  break;
+
+	case AST::MacroMatch::MacroMatchType::Matcher:
+	  return id == LEFT_PAREN || id == LEFT_SQUARE || id == LEFT_CURLY;
+
+	case AST::MacroMatch::MacroMatchType::Fragment:
+	case AST::MacroMatch::MacroMatchType::Repetition:
+	  return true;
+	}
+    }
+
+  return true;
+}
+
+/* Key identifying the tokens of an invocation for the match cache. Matching
+ * only looks at the kind, text and type hint of each token, so locations are
+ * left out; this lets invocations in different places share a cache entry. */
+static std::string
+invocation_cache_key (
+  const std::vector<std::unique_ptr<AST::Token>> &invoc_stream)
+{
+  std::string key;
+  for (auto &tok : invoc_stream)
+    {
+      const_TokenPtr t = tok->get_tok_ptr ();
+      key += std::to_string (t->get_id ()) + ","
+	     + std::to_string (t->get_type_hint ());
+      if (t->has_str ())
+	key += "," + std::to_string (t->get_str ().size ()) + ":"
+	       + t->get_str ();
+      key += ";";
+    }
+  return key;
+}
+
 AST::ASTFragment
 MacroExpander::expand_decl_macro (Location invoc_locus,
 				  AST::MacroInvocData &invoc,
@@ -72,13 +140,59 @@ MacroExpander::expand_decl_macro (Location invoc_locus,
 
   AST::DelimTokenTree &invoc_token_tree = invoc.get_delim_tok_tree ();
 
+  // flatten the invocation once, every rule is matched against this stream
+  // and the fragments of the matching rule refer to offsets into it
+  auto invoc_stream = invoc_token_tree.to_token_stream ();
+
+  MacroStats *stats = nullptr;
+  long start = 0;
+  if (cfg.collect_stats)
+    {
+      stats = &macro_stats[rules_def.get_node_id ()];
+      stats->name = rules_def.get_rule_name ();
+      stats->locus = rules_def.get_locus ();
+      stats->invocations++;
+      stats->max_expansion_depth
+	= std::max (stats->max_expansion_depth, expansion_depth);
+      start = get_run_time ();
+    }
+
+  // identical invocations of a macro always match the same arm in the same
+  // way, so reuse the result of a previous match if there is one
+  auto &cache = match_cache[rules_def.get_node_id ()];
+  std::string cache_key = invocation_cache_key (invoc_stream);
+  auto cached = cache.find (cache_key);
+  if (cached != cache.end ())
+    {
+      match_cache_hits++;
+      AST::MacroRule &rule
+	= rules_def.get_rules ().at (cached->second.rule_index);
+      std::map<std::string, MatchedFragmentContainer> matched_fragments
+	= cached->second.fragments;
+      if (stats != nullptr)
+	stats->matching_time += get_run_time () - start;
+      return transcribe_rule (rule, invoc_token_tree, invoc_stream,
+			      matched_fragments, semicolon, peek_context (),
+			      stats);
+    }
+  match_cache_misses++;
+
   // find matching arm
   AST::MacroRule *matched_rule = nullptr;
+  size_t matched_rule_index = 0;
   std::map<std::string, MatchedFragmentContainer> matched_fragments;
   for (auto &rule : rules_def.get_rules ())
     {
+      if (!rule_prefix_may_match (rule, invoc_stream))
+	{
+	  matched_rule_index++;
+	  continue;
+	}
+
+      if (stats != nullptr)
+	stats->arms_tried++;
       sub_stack.push ();
-      bool did_match_rule = try_match_rule (rule, invoc_token_tree);
+      bool did_match_rule = try_match_rule (rule, invoc_stream);
       matched_fragments = sub_stack.pop ();
 
       if (did_match_rule)
@@ -95,6 +209,13 @@ MacroExpander::expand_decl_macro (Location invoc_locus,
 	  matched_rule = &rule;
 	  break;
 	}
+      matched_rule_index++;
+    }
+
+  if (stats != nullptr)
+    {
+      stats->matching_time += get_run_time () - start;
+      stats->tokens_matched += invoc_stream.size ();
     }
 
   if (matched_rule == nullptr)
@@ -105,8 +226,14 @@ MacroExpander::expand_decl_macro (Location invoc_locus,
       return AST::ASTFragment::create_error ();
     }
 
-  return transcribe_rule (*matched_rule, invoc_token_tree, matched_fragments,
-			  semicolon, peek_context ());
+  // the parsed nodes belong to this expansion only, later hits reparse
+  CachedRuleMatch cached_match{matched_rule_index, matched_fragments};
+  for (auto &it : cached_match.fragments)
+    it.second.clear_parsed_nodes ();
+  cache.insert ({cache_key, std::move (cached_match)});
+
+  return transcribe_rule (*matched_rule, invoc_token_tree, invoc_stream,
+			  matched_fragments, semicolon, peek_context (), stats);
 }
 
 void
@@ -120,6 +247,10 @@ MacroExpander::expand_invoc (AST::MacroInvocation &invoc, bool has_semicolon)
 
   AST::MacroInvocData &invoc_data = invoc.get_invoc_data ();
 
+  TraceScope trace ("expansion", "macro");
+  if (trace.is_active ())
+    trace.add_arg ("macro", invoc_data.get_path ().as_string ());
+
   // ??
   // switch on type of macro:
   //  - '!' syntax macro (inner switch)
@@ -299,6 +430,7 @@ MacroExpander::expand_crate ()
   // expand attributes recursively and strip items if required
   AttrVisitor attr_visitor (*this);
   auto &items = crate.items;
+  AST::Module::prefetch_files (items);
   for (auto it = items.begin (); it != items.end ();)
     {
       auto &item = *it;
@@ -323,6 +455,9 @@ MacroExpander::expand_crate ()
 	it++;
     }
 
+  // builtin derives, once cfg-stripping has settled which items remain
+  DeriveExpander::expand (items);
+
   pop_context ();
 
   // TODO: should recursive attribute and macro expansion be done in the same
@@ -342,10 +477,11 @@ MacroExpander::depth_exceeds_recursion_limit () const
 }
 
 bool
-MacroExpander::try_match_rule (AST::MacroRule &match_rule,
-			       AST::DelimTokenTree &invoc_token_tree)
+MacroExpander::try_match_rule (
+  AST::MacroRule &match_rule,
+  const std::vector<std::unique_ptr<AST::Token>> &invoc_stream)
 {
-  MacroInvocLexer lex (invoc_token_tree.to_token_stream ());
+  MacroInvocLexer lex (invoc_stream);
   Parser<MacroInvocLexer> parser (lex);
 
   AST::MacroMatcher &matcher = match_rule.get_matcher ();
@@ -364,12 +500,16 @@ MacroExpander::try_match_rule (AST::MacroRule &match_rule,
 
 bool
 MacroExpander::match_fragment (Parser<MacroInvocLexer> &parser,
-			       AST::MacroMatchFragment &fragment)
+			       AST::MacroMatchFragment &fragment,
+			       std::shared_ptr<AST::SingleASTNode> *parsed)
 {
   switch (fragment.get_frag_spec ().get_kind ())
     {
-    case AST::MacroFragSpec::EXPR:
-      parser.parse_expr ();
+      case AST::MacroFragSpec::EXPR: {
+	auto expr = parser.parse_expr ();
+	if (parsed != nullptr && expr != nullptr)
+	  *parsed = std::make_shared<AST::SingleASTNode> (std::move (expr));
+      }
       break;
 
     case AST::MacroFragSpec::BLOCK:
@@ -388,8 +528,11 @@ MacroExpander::match_fragment (Parser<MacroInvocLexer> &parser,
       parser.parse_item (false);
       break;
 
-    case AST::MacroFragSpec::TY:
-      parser.parse_type ();
+      case AST::MacroFragSpec::TY: {
+	auto type = parser.parse_type ();
+	if (parsed != nullptr && type != nullptr)
+	  *parsed = std::make_shared<AST::SingleASTNode> (std::move (type));
+      }
       break;
 
     case AST::MacroFragSpec::PAT:
@@ -481,7 +624,12 @@ MacroExpander::match_matcher (Parser<MacroInvocLexer> &parser,
 	  case AST::MacroMatch::MacroMatchType::Fragment: {
 	    AST::MacroMatchFragment *fragment
 	      = static_cast<AST::MacroMatchFragment *> (match.get ());
-	    if (!match_fragment (parser, *fragment))
+
+	    // only keep the parsed node of simple metavariables, which are
+	    // substituted exactly once
+	    std::shared_ptr<AST::SingleASTNode> parsed = nullptr;
+	    if (!match_fragment (parser, *fragment,
+				 in_repetition ? nullptr : &parsed))
 	      return false;
 
 	    // matched fragment get the offset in the token stream
@@ -490,8 +638,9 @@ MacroExpander::match_matcher (Parser<MacroInvocLexer> &parser,
 	      sub_stack.append_fragment (
 		MatchedFragment (fragment->get_ident (), offs_begin, offs_end));
 	    else
-	      sub_stack.insert_metavar (
-		MatchedFragment (fragment->get_ident (), offs_begin, offs_end));
+	      sub_stack.insert_metavar (MatchedFragment (fragment->get_ident (),
+							 offs_begin, offs_end,
+							 parsed));
 	  }
 	  break;
 
@@ -943,20 +1092,81 @@ tokens_to_str (std::vector<std::unique_ptr<AST::Token>> &tokens)
   return str;
 }
 
+/* A transcriber which is only a single `$e:expr` or `$t:ty` metavariable, such
+ * as `{ $e }`, expands to exactly the node that was parsed when matching that
+ * fragment. Returns that node so it can be used as the expansion rather than
+ * substituting its tokens and parsing them again, or nullptr when this does
+ * not apply. */
+static std::shared_ptr<AST::SingleASTNode>
+take_spliceable_fragment (
+  std::vector<std::unique_ptr<AST::Token>> &macro_rule_tokens,
+  std::map<std::string, MatchedFragmentContainer> &matched_fragments,
+  bool semicolon, AST::DelimType invoc_delimiter,
+  MacroExpander::ContextType ctx)
+{
+  // opening delimiter, `$`, name and closing delimiter
+  if (macro_rule_tokens.size () != 4
+      || macro_rule_tokens.at (1)->get_id () != DOLLAR_SIGN
+      || macro_rule_tokens.at (2)->get_id () != IDENTIFIER)
+    return nullptr;
+
+  auto it = matched_fragments.find (macro_rule_tokens.at (2)->get_str ());
+  if (it == matched_fragments.end () || !it->second.is_single_fragment ())
+    return nullptr;
+
+  std::shared_ptr<AST::SingleASTNode> node
+    = it->second.get_single_fragment ().parsed_node;
+  if (node == nullptr)
+    return nullptr;
+
+  // only splice where transcribe_context would parse exactly one node of the
+  // same kind
+  AST::SingleASTNode::NodeType expected;
+  if (ctx == MacroExpander::ContextType::TYPE)
+    expected = AST::SingleASTNode::NodeType::TYPE;
+  else if (ctx == MacroExpander::ContextType::BLOCK && !semicolon
+	   && invoc_delimiter != AST::DelimType::CURLY)
+    expected = AST::SingleASTNode::NodeType::EXPRESSION;
+  else
+    return nullptr;
+
+  if (node->get_kind () != expected)
+    return nullptr;
+
+  // the node can only be used once
+  it->second.clear_parsed_nodes ();
+  return node;
+}
+
 AST::ASTFragment
 MacroExpander::transcribe_rule (
   AST::MacroRule &match_rule, AST::DelimTokenTree &invoc_token_tree,
+  std::vector<std::unique_ptr<AST::Token>> &invoc_stream,
   std::map<std::string, MatchedFragmentContainer> &matched_fragments,
-  bool semicolon, ContextType ctx)
+  bool semicolon, ContextType ctx, MacroStats *stats)
 {
+  long start = stats != nullptr ? get_run_time () : 0;
+
   // we can manipulate the token tree to substitute the dollar identifiers so
   // that when we call parse its already substituted for us
   AST::MacroTranscriber &transcriber = match_rule.get_transcriber ();
   AST::DelimTokenTree &transcribe_tree = transcriber.get_token_tree ();
 
-  auto invoc_stream = invoc_token_tree.to_token_stream ();
   auto macro_rule_tokens = transcribe_tree.to_token_stream ();
 
+  auto spliced
+    = take_spliceable_fragment (macro_rule_tokens, matched_fragments,
+				semicolon, invoc_token_tree.get_delim_type (),
+				ctx);
+  if (spliced != nullptr)
+    {
+      std::vector<AST::SingleASTNode> nodes;
+      nodes.push_back (std::move (*spliced));
+      if (stats != nullptr)
+	stats->transcription_time += get_run_time () - start;
+      return AST::ASTFragment (std::move (nodes));
+    }
+
   auto substitute_context
     = SubstituteCtx (invoc_stream, macro_rule_tokens, matched_fragments);
   std::vector<std::unique_ptr<AST::Token>> substituted_tokens
@@ -965,6 +1175,14 @@ MacroExpander::transcribe_rule (
   rust_debug ("substituted tokens: %s",
 	      tokens_to_str (substituted_tokens).c_str ());
 
+  if (stats != nullptr)
+    {
+      long now = get_run_time ();
+      stats->transcription_time += now - start;
+      stats->tokens_emitted += substituted_tokens.size ();
+      start = now;
+    }
+
   // parse it to an ASTFragment
   MacroInvocLexer lex (std::move (substituted_tokens));
   Parser<MacroInvocLexer> parser (lex);
@@ -1002,6 +1220,8 @@ MacroExpander::transcribe_rule (
   auto fragment
     = transcribe_context (ctx, parser, semicolon,
 			  invoc_token_tree.get_delim_type (), last_token_id);
+  if (stats != nullptr)
+    stats->reparsing_time += get_run_time () - start;
 
   // emit any errors
   if (parser.has_errors ())
@@ -46,19 +46,42 @@ struct ExpansionCfg
   bool trace_mac = false;   // trace macro
   bool should_test = false; // strip #[test] nodes if false
   bool keep_macs = false;   // keep macro definitions
+  bool collect_stats = false; // record what each macro costs to expand
   std::string crate_name = "";
 };
 
+// What expanding the invocations of one macro_rules definition cost
+struct MacroStats
+{
+  std::string name;
+  Location locus;
+  size_t invocations = 0;
+  // arms whose matcher was run, the others are ruled out by their first token
+  size_t arms_tried = 0;
+  size_t tokens_matched = 0;
+  size_t tokens_emitted = 0;
+  // run time in microseconds
+  long matching_time = 0;
+  long transcription_time = 0;
+  long reparsing_time = 0;
+  unsigned int max_expansion_depth = 0;
+};
+
 struct MatchedFragment
 {
   std::string fragment_ident;
   size_t token_offset_begin;
   size_t token_offset_end;
 
+  /* The expression or type parsed when matching the fragment, if any. It can
+   * be spliced into the expansion once instead of reparsing the tokens. */
+  std::shared_ptr<AST::SingleASTNode> parsed_node;
+
   MatchedFragment (std::string identifier, size_t token_offset_begin,
-		   size_t token_offset_end)
+		   size_t token_offset_end,
+		   std::shared_ptr<AST::SingleASTNode> parsed_node = nullptr)
     : fragment_ident (identifier), token_offset_begin (token_offset_begin),
-      token_offset_end (token_offset_end)
+      token_offset_end (token_offset_end), parsed_node (parsed_node)
   {}
 
   /**
@@ -137,6 +160,15 @@ public:
 
   const Kind &get_kind () const { return kind; }
 
+  /**
+   * Drop the parsed nodes of the fragments, leaving only their token offsets
+   */
+  void clear_parsed_nodes ()
+  {
+    for (auto &fragment : fragments)
+      fragment.parsed_node = nullptr;
+  }
+
 private:
   /**
    * Fragments matched `match_amount` times. This can be an empty vector
@@ -209,6 +241,16 @@ private:
   std::vector<std::map<std::string, MatchedFragmentContainer>> stack;
 };
 
+/* The result of matching an invocation against the rules of a macro, which is
+ * cached so that later invocations with the same tokens can skip straight to
+ * the transcription. The fragments only hold offsets into the invocation's
+ * token stream, so they are valid for any stream made of the same tokens. */
+struct CachedRuleMatch
+{
+  size_t rule_index;
+  std::map<std::string, MatchedFragmentContainer> fragments;
+};
+
 // Object used to store shared data (between functions) for macro expansion.
 struct MacroExpander
 {
@@ -256,16 +298,19 @@ struct MacroExpander
 
   bool depth_exceeds_recursion_limit () const;
 
-  bool try_match_rule (AST::MacroRule &match_rule,
-		       AST::DelimTokenTree &invoc_token_tree);
+  bool
+  try_match_rule (AST::MacroRule &match_rule,
+		  const std::vector<std::unique_ptr<AST::Token>> &invoc_stream);
 
   AST::ASTFragment transcribe_rule (
     AST::MacroRule &match_rule, AST::DelimTokenTree &invoc_token_tree,
+    std::vector<std::unique_ptr<AST::Token>> &invoc_stream,
     std::map<std::string, MatchedFragmentContainer> &matched_fragments,
-    bool semicolon, ContextType ctx);
+    bool semicolon, ContextType ctx, MacroStats *stats = nullptr);
 
   bool match_fragment (Parser<MacroInvocLexer> &parser,
-		       AST::MacroMatchFragment &fragment);
+		       AST::MacroMatchFragment &fragment,
+		       std::shared_ptr<AST::SingleASTNode> *parsed = nullptr);
 
   bool match_token (Parser<MacroInvocLexer> &parser, AST::Token &token);
 
@@ -313,6 +358,15 @@ struct MacroExpander
 
   ContextType peek_context () { return context.back (); }
 
+  size_t get_match_cache_hits () const { return match_cache_hits; }
+  size_t get_match_cache_misses () const { return match_cache_misses; }
+
+  // filled in when cfg.collect_stats is set, by macro definition
+  const std::map<NodeId, MacroStats> &get_macro_stats () const
+  {
+    return macro_stats;
+  }
+
   void set_expanded_fragment (AST::ASTFragment &&fragment)
   {
     expanded_fragment = std::move (fragment);
@@ -356,6 +410,14 @@ private:
   std::vector<ContextType> context;
   AST::ASTFragment expanded_fragment;
 
+  // Matched rules of each macro definition, keyed by the invocation tokens
+  std::map<NodeId, std::unordered_map<std::string, CachedRuleMatch>>
+    match_cache;
+  size_t match_cache_hits = 0;
+  size_t match_cache_misses = 0;
+
+  std::map<NodeId, MacroStats> macro_stats;
+
 public:
   Resolver::Resolver *resolver;
   Analysis::Mappings *mappings;
@@ -25,10 +25,19 @@ namespace Rust {
 class MacroInvocLexer
 {
 public:
-  MacroInvocLexer (std::vector<std::unique_ptr<AST::Token>> stream)
-    : offs (0), token_stream (std::move (stream))
+  MacroInvocLexer (std::vector<std::unique_ptr<AST::Token>> &&stream)
+    : offs (0), owned_stream (std::move (stream)), token_stream (owned_stream)
   {}
 
+  // Lex a stream owned by the caller, which must outlive the lexer. This lets
+  // several lexers share one flattened copy of a token tree.
+  MacroInvocLexer (const std::vector<std::unique_ptr<AST::Token>> &stream)
+    : offs (0), token_stream (stream)
+  {}
+
+  MacroInvocLexer (const MacroInvocLexer &other) = delete;
+  MacroInvocLexer &operator= (const MacroInvocLexer &other) = delete;
+
   // Returns token n tokens ahead of current position.
   const_TokenPtr peek_token (int n);
 
@@ -57,7 +66,8 @@ public:
 
 private:
   size_t offs;
-  std::vector<std::unique_ptr<AST::Token>> token_stream;
+  std::vector<std::unique_ptr<AST::Token>> owned_stream;
+  const std::vector<std::unique_ptr<AST::Token>> &token_stream;
 };
 } // namespace Rust
 
@@ -675,9 +675,11 @@ ASTLowerTypePath::visit (AST::TypePathSegmentGeneric &segment)
 				 UNKNOWN_LOCAL_DEFID);
 
   translated_segment
-    = new HIR::TypePathSegmentGeneric (std::move (mapping), segment_name,
+    = new HIR::TypePathSegmentGeneric (std::move (mapping),
+				       std::move (segment_name),
 				       has_separating_scope_resolution,
-				       generic_args, segment.get_locus ());
+				       std::move (generic_args),
+				       segment.get_locus ());
 }
 
 void
@@ -810,7 +812,8 @@ ASTLoweringBase::lower_qualifiers (const AST::FunctionQualifiers &qualifiers)
     = qualifiers.is_unsafe () ? Unsafety::Unsafe : Unsafety::Normal;
   bool has_extern = qualifiers.is_extern ();
 
-  ABI abi = ABI::RUST;
+  // a bare extern qualifier means the C ABI
+  ABI abi = has_extern ? ABI::C : ABI::RUST;
   if (qualifiers.has_abi ())
     {
       const std::string &extern_abi = qualifiers.get_extern_abi ();
@@ -826,27 +829,32 @@ ASTLoweringBase::lower_qualifiers (const AST::FunctionQualifiers &qualifiers)
 void
 ASTLoweringBase::handle_outer_attributes (const HIR::Item &item)
 {
-  for (const auto &attr : item.get_outer_attrs ())
+  const AST::AttrVec &attrs = item.get_outer_attrs ();
+  const auto &entries = item.get_builtin_attrs ().get_entries ();
+
+  // the entries are in the order of the attributes, any attribute between two
+  // of them is not a builtin one
+  auto entry = entries.begin ();
+  for (size_t i = 0; i < attrs.size (); i++)
     {
-      const auto &str_path = attr.get_path ().as_string ();
-      if (!is_known_attribute (str_path))
+      const AST::Attribute &attr = attrs.at (i);
+      if (entry == entries.end () || entry->second != i)
 	{
 	  rust_error_at (attr.get_locus (), "unknown attribute");
 	  continue;
 	}
 
-      bool is_lang_item = str_path.compare ("lang") == 0
+      Analysis::BuiltinAttrKind kind = (entry++)->first;
+      bool is_lang_item = kind == Analysis::BuiltinAttrKind::LANG
 			  && attr.has_attr_input ()
 			  && attr.get_attr_input ().get_attr_input_type ()
 			       == AST::AttrInput::AttrInputType::LITERAL;
 
-      bool is_doc_item = str_path.compare ("doc") == 0;
-
-      if (is_doc_item)
+      if (kind == Analysis::BuiltinAttrKind::DOC)
 	handle_doc_item_attribute (item, attr);
       else if (is_lang_item)
 	handle_lang_item_attribute (item, attr);
-      else if (!attribute_handled_in_another_pass (str_path))
+      else if (!attribute_handled_in_another_pass (kind))
 	{
 	  rust_error_at (attr.get_locus (), "unhandled attribute: [%s]",
 			 attr.get_path ().as_string ().c_str ());
@@ -893,21 +901,11 @@ ASTLoweringBase::handle_lang_item_attribute (const HIR::Item &item,
 			      item.get_mappings ().get_defid ());
 }
 
-bool
-ASTLoweringBase::is_known_attribute (const std::string &attribute_path) const
-{
-  const auto &lookup = attr_mappings->lookup_builtin (attribute_path);
-  return !lookup.is_error ();
-}
-
 bool
 ASTLoweringBase::attribute_handled_in_another_pass (
-  const std::string &attribute_path) const
+  Analysis::BuiltinAttrKind kind) const
 {
-  const auto &lookup = attr_mappings->lookup_builtin (attribute_path);
-  if (lookup.is_error ())
-    return false;
-
+  const auto &lookup = attr_mappings->lookup_builtin (kind);
   if (lookup.handler == Analysis::CompilerPass::UNKNOWN)
     return false;
 
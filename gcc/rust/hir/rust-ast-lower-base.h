@@ -272,10 +272,7 @@ protected:
   void handle_doc_item_attribute (const HIR::Item &item,
 				  const AST::Attribute &attr);
 
-  bool is_known_attribute (const std::string &attribute_path) const;
-
-  bool
-  attribute_handled_in_another_pass (const std::string &attribute_path) const;
+  bool attribute_handled_in_another_pass (Analysis::BuiltinAttrKind kind) const;
 
   std::unique_ptr<TuplePatternItems>
   lower_tuple_pattern_multiple (AST::TuplePatternItemsMultiple &pattern);
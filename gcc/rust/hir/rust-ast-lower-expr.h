@@ -87,9 +87,7 @@ public:
 	return nullptr;
       }
 
-    resolver.mappings->insert_hir_expr (resolver.translated);
-    resolver.mappings->insert_location (
-      resolver.translated->get_mappings ().get_hirid (), expr->get_locus ());
+    resolver.insert_translated (expr, resolver.translated);
 
     if (terminated != nullptr)
       *terminated = resolver.terminated;
@@ -211,29 +209,23 @@ public:
 
   void visit (AST::MethodCallExpr &expr) override
   {
-    HIR::PathExprSegment method_path
-      = lower_path_expr_seg (expr.get_method_name ());
-
-    HIR::Expr *receiver
-      = ASTLoweringExpr::translate (expr.get_receiver_expr ().get ());
-
-    auto const &in_params = expr.get_params ();
-    std::vector<std::unique_ptr<HIR::Expr> > params;
-    for (auto &param : in_params)
+    // Builder chains `a.b ().c ()...` nest through their receivers: lower the
+    // innermost receiver, then each call around the previous one
+    std::vector<AST::MethodCallExpr *> chain = {&expr};
+    AST::Expr *receiver = expr.get_receiver_expr ().get ();
+    while (receiver->get_ast_kind () == AST::Kind::METHOD_CALL_EXPR)
       {
-	auto trans = ASTLoweringExpr::translate (param.get ());
-	params.push_back (std::unique_ptr<HIR::Expr> (trans));
+	chain.push_back (static_cast<AST::MethodCallExpr *> (receiver));
+	receiver = chain.back ()->get_receiver_expr ().get ();
       }
 
-    auto crate_num = mappings->get_current_crate ();
-    Analysis::NodeMapping mapping (crate_num, expr.get_node_id (),
-				   mappings->get_next_hir_id (crate_num),
-				   UNKNOWN_LOCAL_DEFID);
-
-    translated
-      = new HIR::MethodCallExpr (mapping, std::unique_ptr<HIR::Expr> (receiver),
-				 method_path, std::move (params),
-				 expr.get_outer_attrs (), expr.get_locus ());
+    translated = ASTLoweringExpr::translate (receiver);
+    for (auto it = chain.rbegin (); it != chain.rend (); it++)
+      {
+	translated = lower_method_call (**it, translated);
+	if (*it != &expr)
+	  insert_translated (*it, translated);
+      }
   }
 
   void visit (AST::AssignmentExpr &expr) override
@@ -356,22 +348,24 @@ public:
 
   void visit (AST::ArithmeticOrLogicalExpr &expr) override
   {
-    HIR::Expr *lhs = ASTLoweringExpr::translate (expr.get_left_expr ().get ());
-    rust_assert (lhs != nullptr);
-    HIR::Expr *rhs = ASTLoweringExpr::translate (expr.get_right_expr ().get ());
-    rust_assert (rhs != nullptr);
-
-    auto crate_num = mappings->get_current_crate ();
-    Analysis::NodeMapping mapping (crate_num, expr.get_node_id (),
-				   mappings->get_next_hir_id (crate_num),
-				   UNKNOWN_LOCAL_DEFID);
+    // Operator chains `a + b + ... + z` nest to the left: lower the leftmost
+    // operand, then each operator around the previous one
+    std::vector<AST::ArithmeticOrLogicalExpr *> chain = {&expr};
+    AST::Expr *operand = expr.get_left_expr ().get ();
+    while (operand->get_ast_kind () == AST::Kind::ARITHMETIC_OR_LOGICAL_EXPR)
+      {
+	chain.push_back (static_cast<AST::ArithmeticOrLogicalExpr *> (operand));
+	operand = chain.back ()->get_left_expr ().get ();
+      }
 
-    translated
-      = new HIR::ArithmeticOrLogicalExpr (mapping,
-					  std::unique_ptr<HIR::Expr> (lhs),
-					  std::unique_ptr<HIR::Expr> (rhs),
-					  expr.get_expr_type (),
-					  expr.get_locus ());
+    translated = ASTLoweringExpr::translate (operand);
+    rust_assert (translated != nullptr);
+    for (auto it = chain.rbegin (); it != chain.rend (); it++)
+      {
+	translated = lower_arithmetic_or_logical (**it, translated);
+	if (*it != &expr)
+	  insert_translated (*it, translated);
+      }
   }
 
   void visit (AST::ComparisonExpr &expr) override
@@ -774,6 +768,57 @@ private:
       translated_array_elems (nullptr), terminated (false)
   {}
 
+  // Register EXPR, lowered to LOWERED, as translate does
+  void insert_translated (AST::Expr *expr, HIR::Expr *lowered)
+  {
+    mappings->insert_hir_expr (lowered);
+    mappings->insert_location (lowered->get_mappings ().get_hirid (),
+			       expr->get_locus ());
+  }
+
+  HIR::Expr *lower_method_call (AST::MethodCallExpr &expr,
+				HIR::Expr *receiver)
+  {
+    HIR::PathExprSegment method_path
+      = lower_path_expr_seg (expr.get_method_name ());
+
+    auto const &in_params = expr.get_params ();
+    std::vector<std::unique_ptr<HIR::Expr> > params;
+    for (auto &param : in_params)
+      {
+	auto trans = ASTLoweringExpr::translate (param.get ());
+	params.push_back (std::unique_ptr<HIR::Expr> (trans));
+      }
+
+    auto crate_num = mappings->get_current_crate ();
+    Analysis::NodeMapping mapping (crate_num, expr.get_node_id (),
+				   mappings->get_next_hir_id (crate_num),
+				   UNKNOWN_LOCAL_DEFID);
+
+    return new HIR::MethodCallExpr (mapping,
+				    std::unique_ptr<HIR::Expr> (receiver),
+				    std::move (method_path), std::move (params),
+				    expr.get_outer_attrs (), expr.get_locus ());
+  }
+
+  HIR::Expr *lower_arithmetic_or_logical (AST::ArithmeticOrLogicalExpr &expr,
+					  HIR::Expr *lhs)
+  {
+    HIR::Expr *rhs = ASTLoweringExpr::translate (expr.get_right_expr ().get ());
+    rust_assert (rhs != nullptr);
+
+    auto crate_num = mappings->get_current_crate ();
+    Analysis::NodeMapping mapping (crate_num, expr.get_node_id (),
+				   mappings->get_next_hir_id (crate_num),
+				   UNKNOWN_LOCAL_DEFID);
+
+    return new HIR::ArithmeticOrLogicalExpr (mapping,
+					     std::unique_ptr<HIR::Expr> (lhs),
+					     std::unique_ptr<HIR::Expr> (rhs),
+					     expr.get_expr_type (),
+					     expr.get_locus ());
+  }
+
   HIR::Expr *translated;
   HIR::ArrayElems *translated_array_elems;
   bool terminated;
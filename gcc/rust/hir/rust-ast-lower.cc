@@ -408,6 +408,7 @@ ASTLowerPathInExpression::visit (AST::PathInExpression &expr)
 {
   std::vector<HIR::PathExprSegment> path_segments;
   auto &segments = expr.get_segments ();
+  path_segments.reserve (segments.size ());
   for (auto &s : segments)
     {
       path_segments.push_back (lower_path_expr_seg ((s)));
@@ -454,6 +455,7 @@ ASTLowerQualPathInExpression::visit (AST::QualifiedPathInExpression &expr)
 
   std::vector<HIR::PathExprSegment> path_segments;
   auto &segments = expr.get_segments ();
+  path_segments.reserve (segments.size ());
   for (auto &s : segments)
     {
       path_segments.push_back (lower_path_expr_seg ((s)));
@@ -468,7 +470,8 @@ ASTLowerQualPathInExpression::visit (AST::QualifiedPathInExpression &expr)
 				 mappings->get_next_hir_id (crate_num),
 				 UNKNOWN_LOCAL_DEFID);
 
-  translated = new HIR::QualifiedPathInExpression (mapping, qual_path_type,
+  translated = new HIR::QualifiedPathInExpression (mapping,
+						   std::move (qual_path_type),
 						   std::move (path_segments),
 						   expr.get_locus (),
 						   expr.get_outer_attrs ());
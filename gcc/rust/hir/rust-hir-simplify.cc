@@ -0,0 +1,898 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-hir-simplify.h"
+#include "rust-hir-map.h"
+#include "tm.h"
+
+namespace Rust {
+namespace HIR {
+
+Simplifier::Simplifier ()
+  : discarded (nullptr), resolver (*Resolver::Resolver::get ()),
+    tyctx (*Resolver::TypeCheckContext::get ()),
+    mappings (*Analysis::Mappings::get ())
+{}
+
+void
+Simplifier::simplify (HIR::Crate &crate)
+{
+  Simplifier simplifier;
+  for (auto &item : crate.items)
+    item->accept_vis (simplifier);
+}
+
+template <typename T>
+void
+Simplifier::fold (std::unique_ptr<T> &slot)
+{
+  slot->accept_vis (*this);
+  if (replacement == nullptr)
+    return;
+
+  mappings.insert_hir_expr (replacement.get ());
+  slot = std::move (replacement);
+}
+
+void
+Simplifier::walk (Expr *expr)
+{
+  expr->accept_vis (*this);
+  replacement = nullptr;
+}
+
+void
+Simplifier::discard (Expr *expr, std::vector<HirId> &uses)
+{
+  std::vector<HirId> *saved = discarded;
+  discarded = &uses;
+  walk (expr);
+  discarded = saved;
+}
+
+void
+Simplifier::fold_to (Expr &expr, std::string value, Literal::LitType type,
+		     std::initializer_list<Expr *> operands)
+{
+  // the operands may be literals standing in for constants themselves
+  std::vector<HirId> uses;
+  for (auto operand : operands)
+    {
+      auto retained
+	= mappings.lookup_retained_uses (operand->get_mappings ().get_hirid ());
+      if (retained != nullptr)
+	uses.insert (uses.end (), retained->begin (), retained->end ());
+    }
+  if (!uses.empty ())
+    mappings.insert_retained_uses (expr.get_mappings ().get_hirid (),
+				   std::move (uses));
+
+  replacement = std::unique_ptr<LiteralExpr> (
+    new LiteralExpr (expr.get_mappings (), std::move (value), type,
+		     PrimitiveCoreType::CORETYPE_UNKNOWN, expr.get_locus (),
+		     AST::AttrVec ()));
+}
+
+void
+Simplifier::record_use (NodeId ast_node_id)
+{
+  NodeId ref_node_id = UNKNOWN_NODEID;
+  if (!resolver.lookup_resolved_name (ast_node_id, &ref_node_id))
+    return;
+
+  HirId ref = UNKNOWN_HIRID;
+  if (mappings.lookup_node_to_hir (ref_node_id, &ref))
+    discarded->push_back (ref);
+}
+
+bool
+Simplifier::int_type (HirId id, unsigned *precision, signop *sign) const
+{
+  TyTy::BaseType *type = nullptr;
+  if (!tyctx.lookup_type (id, &type))
+    return false;
+
+  switch (type->get_kind ())
+    {
+    case TyTy::TypeKind::INT:
+      *sign = SIGNED;
+      *precision = 8 << static_cast<TyTy::IntType *> (type)->get_int_kind ();
+      break;
+
+    case TyTy::TypeKind::UINT:
+      *sign = UNSIGNED;
+      *precision = 8 << static_cast<TyTy::UintType *> (type)->get_uint_kind ();
+      break;
+
+    case TyTy::TypeKind::ISIZE:
+      *sign = SIGNED;
+      *precision = POINTER_SIZE;
+      break;
+
+    case TyTy::TypeKind::USIZE:
+      *sign = UNSIGNED;
+      *precision = POINTER_SIZE;
+      break;
+
+    default:
+      return false;
+    }
+
+  // the literals we build are printed through a HOST_WIDE_INT
+  return *precision <= HOST_BITS_PER_WIDE_INT;
+}
+
+static bool
+fits_type (const widest_int &value, unsigned precision, signop sign)
+{
+  widest_int min = widest_int::from (wi::min_value (precision, sign), sign);
+  widest_int max = widest_int::from (wi::max_value (precision, sign), sign);
+  return wi::ges_p (value, min) && wi::les_p (value, max);
+}
+
+static std::string
+int_literal_string (const widest_int &value)
+{
+  if (wi::neg_p (value))
+    return "-" + std::to_string (wi::neg (value).to_uhwi ());
+
+  return std::to_string (value.to_uhwi ());
+}
+
+bool
+Simplifier::int_literal (Expr *expr, widest_int *value, unsigned *precision,
+			 signop *sign) const
+{
+  if (expr->get_expression_type () != Expr::ExprType::Lit)
+    return false;
+
+  auto literal = static_cast<LiteralExpr *> (expr);
+  if (literal->get_lit_type () != Literal::INT)
+    return false;
+
+  if (!int_type (literal->get_mappings ().get_hirid (), precision, sign))
+    return false;
+
+  // integer literals are left as decimal digits by the lexer, and the ones
+  // we fold may be negative
+  const std::string &digits = literal->get_literal ().as_string ();
+  size_t start = !digits.empty () && digits[0] == '-' ? 1 : 0;
+  if (start == digits.size ())
+    return false;
+
+  widest_int v = 0;
+  for (size_t i = start; i < digits.size (); i++)
+    {
+      if (!ISDIGIT (digits[i]) || i - start > 40)
+	return false;
+      v = v * 10 + (digits[i] - '0');
+    }
+  *value = start ? wi::neg (v) : v;
+
+  return fits_type (*value, *precision, *sign);
+}
+
+bool
+Simplifier::bool_literal (Expr *expr, bool *value) const
+{
+  if (expr->get_expression_type () != Expr::ExprType::Lit)
+    return false;
+
+  auto literal = static_cast<LiteralExpr *> (expr);
+  if (literal->get_lit_type () != Literal::BOOL)
+    return false;
+
+  *value = literal->get_literal ().as_string ().compare ("true") == 0;
+  return true;
+}
+
+static const char *
+bool_string (bool value)
+{
+  return value ? "true" : "false";
+}
+
+LiteralExpr *
+Simplifier::constant_value (HirId ref)
+{
+  Item *item = mappings.lookup_hir_item (ref);
+  if (item == nullptr || item->get_item_kind () != Item::ItemKind::Constant)
+    return nullptr;
+
+  auto constant = static_cast<ConstantItem *> (item);
+  if (folded_consts.find (ref) == folded_consts.end ())
+    constant->accept_vis (*this);
+
+  Expr *value = constant->get_expr ();
+  if (value->get_expression_type () != Expr::ExprType::Lit)
+    return nullptr;
+
+  auto literal = static_cast<LiteralExpr *> (value);
+  Literal::LitType type = literal->get_lit_type ();
+  if (type != Literal::INT && type != Literal::BOOL)
+    return nullptr;
+
+  return literal;
+}
+
+void
+Simplifier::visit (PathInExpression &path)
+{
+  if (discarded != nullptr)
+    {
+      record_use (path.get_mappings ().get_nodeid ());
+      return;
+    }
+
+  NodeId ref_node_id = UNKNOWN_NODEID;
+  HirId ref = UNKNOWN_HIRID;
+  if (!resolver.lookup_resolved_name (path.get_mappings ().get_nodeid (),
+				      &ref_node_id)
+      || !mappings.lookup_node_to_hir (ref_node_id, &ref))
+    return;
+
+  LiteralExpr *value = constant_value (ref);
+  if (value == nullptr)
+    return;
+
+  widest_int v;
+  unsigned precision;
+  signop sign;
+  bool b;
+  if (value->get_lit_type () == Literal::INT
+	? !int_literal (value, &v, &precision, &sign)
+	: !bool_literal (value, &b))
+    return;
+
+  // the path is typed as the constant, there is nothing left to coerce
+  fold_to (path, value->get_literal ().as_string (), value->get_lit_type (),
+	   {value});
+  mappings.insert_retained_uses (path.get_mappings ().get_hirid (), {ref});
+}
+
+void
+Simplifier::visit (BorrowExpr &expr)
+{
+  fold (expr.get_expr ());
+}
+
+void
+Simplifier::visit (DereferenceExpr &expr)
+{
+  walk (expr.get_expr ().get ());
+}
+
+void
+Simplifier::visit (ErrorPropagationExpr &expr)
+{
+  walk (expr.get_expr ().get ());
+}
+
+void
+Simplifier::visit (NegationExpr &expr)
+{
+  fold (expr.get_expr ());
+  if (discarded != nullptr)
+    return;
+
+  Expr *operand = expr.get_expr ().get ();
+  widest_int v;
+  unsigned precision;
+  signop sign;
+  bool b;
+  switch (expr.get_expr_type ())
+    {
+    case NegationOperator::NEGATE:
+      if (int_literal (operand, &v, &precision, &sign) && sign == SIGNED
+	  && fits_type (wi::neg (v), precision, sign))
+	fold_to (expr, int_literal_string (wi::neg (v)), Literal::INT,
+		 {operand});
+      break;
+
+    case NegationOperator::NOT:
+      if (bool_literal (operand, &b))
+	fold_to (expr, bool_string (!b), Literal::BOOL, {operand});
+      else if (int_literal (operand, &v, &precision, &sign))
+	fold_to (expr, int_literal_string (wi::ext (wi::bit_not (v), precision, sign)),
+		 Literal::INT, {operand});
+      break;
+    }
+}
+
+void
+Simplifier::visit (ArithmeticOrLogicalExpr &expr)
+{
+  fold (expr.get_left_expr ());
+  fold (expr.get_right_expr ());
+  if (discarded != nullptr)
+    return;
+
+  TyTy::FnType *overload = nullptr;
+  if (tyctx.lookup_operator_overload (expr.get_mappings ().get_hirid (),
+				      &overload))
+    return;
+
+  Expr *lhs = expr.get_lhs ();
+  Expr *rhs = expr.get_rhs ();
+  bool a, b;
+  if (bool_literal (lhs, &a) && bool_literal (rhs, &b))
+    {
+      switch (expr.get_expr_type ())
+	{
+	case ArithmeticOrLogicalOperator::BITWISE_AND:
+	  fold_to (expr, bool_string (a && b), Literal::BOOL, {lhs, rhs});
+	  break;
+	case ArithmeticOrLogicalOperator::BITWISE_OR:
+	  fold_to (expr, bool_string (a || b), Literal::BOOL, {lhs, rhs});
+	  break;
+	case ArithmeticOrLogicalOperator::BITWISE_XOR:
+	  fold_to (expr, bool_string (a != b), Literal::BOOL, {lhs, rhs});
+	  break;
+	default:
+	  break;
+	}
+      return;
+    }
+
+  widest_int x, y;
+  unsigned precision, rhs_precision;
+  signop sign, rhs_sign;
+  if (!int_literal (lhs, &x, &precision, &sign)
+      || !int_literal (rhs, &y, &rhs_precision, &rhs_sign))
+    return;
+
+  widest_int result;
+  switch (expr.get_expr_type ())
+    {
+    case ArithmeticOrLogicalOperator::ADD:
+      result = x + y;
+      break;
+    case ArithmeticOrLogicalOperator::SUBTRACT:
+      result = x - y;
+      break;
+    case ArithmeticOrLogicalOperator::MULTIPLY:
+      result = x * y;
+      break;
+    case ArithmeticOrLogicalOperator::DIVIDE:
+      if (y == 0)
+	return;
+      result = wi::div_trunc (x, y, SIGNED);
+      break;
+    case ArithmeticOrLogicalOperator::MODULUS:
+      if (y == 0)
+	return;
+      result = wi::mod_trunc (x, y, SIGNED);
+      break;
+    case ArithmeticOrLogicalOperator::BITWISE_AND:
+      result = x & y;
+      break;
+    case ArithmeticOrLogicalOperator::BITWISE_OR:
+      result = x | y;
+      break;
+    case ArithmeticOrLogicalOperator::BITWISE_XOR:
+      result = x ^ y;
+      break;
+
+    // shifting by the width of the type or more overflows, otherwise the
+    // bits shifted out are dropped
+    case ArithmeticOrLogicalOperator::LEFT_SHIFT:
+      if (wi::neg_p (y) || wi::geu_p (y, precision))
+	return;
+      result = wi::ext (wi::lshift (x, y), precision, sign);
+      break;
+    case ArithmeticOrLogicalOperator::RIGHT_SHIFT:
+      if (wi::neg_p (y) || wi::geu_p (y, precision))
+	return;
+      result = wi::arshift (x, y);
+      break;
+    }
+
+  if (fits_type (result, precision, sign))
+    fold_to (expr, int_literal_string (result), Literal::INT, {lhs, rhs});
+}
+
+void
+Simplifier::visit (ComparisonExpr &expr)
+{
+  fold (expr.get_left_expr ());
+  fold (expr.get_right_expr ());
+  if (discarded != nullptr)
+    return;
+
+  TyTy::FnType *overload = nullptr;
+  if (tyctx.lookup_operator_overload (expr.get_mappings ().get_hirid (),
+				      &overload))
+    return;
+
+  // both sides have the same type, so bools compare as the integers 0 and 1
+  Expr *lhs = expr.get_lhs ();
+  Expr *rhs = expr.get_rhs ();
+  widest_int x, y;
+  unsigned precision;
+  signop sign;
+  bool a, b;
+  if (bool_literal (lhs, &a) && bool_literal (rhs, &b))
+    {
+      x = a ? 1 : 0;
+      y = b ? 1 : 0;
+    }
+  else if (!int_literal (lhs, &x, &precision, &sign)
+	   || !int_literal (rhs, &y, &precision, &sign))
+    return;
+
+  bool result = false;
+  switch (expr.get_kind ())
+    {
+    case ComparisonOperator::EQUAL:
+      result = x == y;
+      break;
+    case ComparisonOperator::NOT_EQUAL:
+      result = x != y;
+      break;
+    case ComparisonOperator::GREATER_THAN:
+      result = wi::gts_p (x, y);
+      break;
+    case ComparisonOperator::LESS_THAN:
+      result = wi::lts_p (x, y);
+      break;
+    case ComparisonOperator::GREATER_OR_EQUAL:
+      result = wi::ges_p (x, y);
+      break;
+    case ComparisonOperator::LESS_OR_EQUAL:
+      result = wi::les_p (x, y);
+      break;
+    }
+
+  fold_to (expr, bool_string (result), Literal::BOOL, {lhs, rhs});
+}
+
+void
+Simplifier::visit (LazyBooleanExpr &expr)
+{
+  fold (expr.get_left_expr ());
+  fold (expr.get_right_expr ());
+  if (discarded != nullptr)
+    return;
+
+  // `false && f ()` still has to keep f () around for its uses, so only
+  // fold when both sides are literals
+  Expr *lhs = expr.get_lhs ();
+  Expr *rhs = expr.get_rhs ();
+  bool a, b;
+  if (!bool_literal (lhs, &a) || !bool_literal (rhs, &b))
+    return;
+
+  bool result = expr.get_expr_type () == LazyBooleanOperator::LOGICAL_AND
+		  ? a && b
+		  : a || b;
+  fold_to (expr, bool_string (result), Literal::BOOL, {lhs, rhs});
+}
+
+void
+Simplifier::visit (TypeCastExpr &expr)
+{
+  fold (expr.get_casted_expr ());
+  if (discarded != nullptr)
+    return;
+
+  unsigned precision;
+  signop sign;
+  if (!int_type (expr.get_mappings ().get_hirid (), &precision, &sign))
+    return;
+
+  // integer casts truncate or extend to the target type
+  Expr *operand = expr.get_casted_expr ().get ();
+  widest_int v;
+  unsigned from_precision;
+  signop from_sign;
+  bool b;
+  if (bool_literal (operand, &b))
+    v = b ? 1 : 0;
+  else if (!int_literal (operand, &v, &from_precision, &from_sign))
+    return;
+
+  fold_to (expr, int_literal_string (wi::ext (v, precision, sign)),
+	   Literal::INT, {operand});
+}
+
+void
+Simplifier::visit (AssignmentExpr &expr)
+{
+  walk (expr.get_lhs ());
+  fold (expr.get_right_expr ());
+}
+
+void
+Simplifier::visit (CompoundAssignmentExpr &expr)
+{
+  walk (expr.get_left_expr ().get ());
+  fold (expr.get_right_expr ());
+}
+
+void
+Simplifier::visit (GroupedExpr &expr)
+{
+  fold (expr.get_expr_in_parens ());
+  if (discarded != nullptr)
+    return;
+
+  Expr *inner = expr.get_expr_in_parens ().get ();
+  if (inner->get_expression_type () != Expr::ExprType::Lit)
+    return;
+
+  auto literal = static_cast<LiteralExpr *> (inner);
+  Literal::LitType type = literal->get_lit_type ();
+  if (type == Literal::INT || type == Literal::BOOL)
+    fold_to (expr, literal->get_literal ().as_string (), type, {inner});
+}
+
+void
+Simplifier::visit (ArrayElemsValues &elems)
+{
+  for (auto &elem : elems.get_values ())
+    fold (elem);
+}
+
+void
+Simplifier::visit (ArrayElemsCopied &elems)
+{
+  // the number of copies is a constant expression, left to the const
+  // evaluator
+  walk (elems.get_elem_to_copy ());
+}
+
+void
+Simplifier::visit (ArrayExpr &expr)
+{
+  expr.get_internal_elements ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (ArrayIndexExpr &expr)
+{
+  walk (expr.get_array_expr ());
+  walk (expr.get_index_expr ());
+}
+
+void
+Simplifier::visit (TupleExpr &expr)
+{
+  for (auto &elem : expr.get_tuple_elems ())
+    fold (elem);
+}
+
+void
+Simplifier::visit (TupleIndexExpr &expr)
+{
+  walk (expr.get_tuple_expr ().get ());
+}
+
+void
+Simplifier::visit (StructExprFieldIdentifier &field)
+{
+  if (discarded != nullptr)
+    record_use (field.get_mappings ().get_nodeid ());
+}
+
+void
+Simplifier::visit (StructExprFieldIdentifierValue &field)
+{
+  walk (field.get_value ());
+}
+
+void
+Simplifier::visit (StructExprFieldIndexValue &field)
+{
+  walk (field.get_value ());
+}
+
+void
+Simplifier::visit (StructExprStructFields &expr)
+{
+  for (auto &field : expr.get_fields ())
+    field->accept_vis (*this);
+  if (expr.has_struct_base ())
+    walk (expr.struct_base->get_base ());
+}
+
+void
+Simplifier::visit (StructExprStructBase &expr)
+{
+  walk (expr.get_struct_base ()->get_base ());
+}
+
+void
+Simplifier::visit (CallExpr &expr)
+{
+  walk (expr.get_fnexpr ());
+  for (auto &arg : expr.get_arguments ())
+    fold (arg);
+}
+
+void
+Simplifier::visit (MethodCallExpr &expr)
+{
+  walk (expr.get_receiver ().get ());
+  for (auto &arg : expr.get_arguments ())
+    fold (arg);
+}
+
+void
+Simplifier::visit (FieldAccessExpr &expr)
+{
+  walk (expr.get_receiver_expr ().get ());
+}
+
+void
+Simplifier::visit (BlockExpr &expr)
+{
+  for (auto &stmt : expr.get_statements ())
+    stmt->accept_vis (*this);
+  if (expr.has_expr ())
+    fold (expr.get_final_expr ());
+}
+
+void
+Simplifier::visit (BreakExpr &expr)
+{
+  if (expr.has_break_expr ())
+    fold (expr.get_expr ());
+}
+
+void
+Simplifier::visit (RangeFromToExpr &expr)
+{
+  fold (expr.get_from_expr ());
+  fold (expr.get_to_expr ());
+}
+
+void
+Simplifier::visit (RangeFromExpr &expr)
+{
+  fold (expr.get_from_expr ());
+}
+
+void
+Simplifier::visit (RangeToExpr &expr)
+{
+  fold (expr.get_to_expr ());
+}
+
+void
+Simplifier::visit (RangeFromToInclExpr &expr)
+{
+  fold (expr.get_from_expr ());
+  fold (expr.get_to_expr ());
+}
+
+void
+Simplifier::visit (RangeToInclExpr &expr)
+{
+  fold (expr.get_to_expr ());
+}
+
+void
+Simplifier::visit (ReturnExpr &expr)
+{
+  if (expr.has_return_expr ())
+    fold (expr.get_returned_expr ());
+}
+
+void
+Simplifier::visit (UnsafeBlockExpr &expr)
+{
+  expr.get_block_expr ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (LoopExpr &expr)
+{
+  expr.get_loop_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (WhileLoopExpr &expr)
+{
+  fold (expr.get_predicate_expr ());
+  expr.get_loop_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (WhileLetLoopExpr &expr)
+{
+  walk (expr.get_cond ().get ());
+  expr.get_loop_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (ForLoopExpr &expr)
+{
+  walk (expr.get_iterator_expr ().get ());
+  expr.get_loop_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::fold_conditional (IfExpr &expr, Expr *conseq)
+{
+  fold (expr.get_condition_expr ());
+
+  bool taken;
+  if (discarded != nullptr
+      || !bool_literal (expr.get_if_condition (), &taken))
+    {
+      expr.get_if_block ()->accept_vis (*this);
+      if (conseq != nullptr)
+	walk (conseq);
+      return;
+    }
+
+  // codegen only lowers the branch which is taken, what the other one uses
+  // is kept with the if expression
+  std::vector<HirId> uses;
+  if (taken)
+    {
+      expr.get_if_block ()->accept_vis (*this);
+      if (conseq != nullptr)
+	discard (conseq, uses);
+    }
+  else
+    {
+      discard (expr.get_if_block (), uses);
+      if (conseq != nullptr)
+	walk (conseq);
+    }
+
+  if (!uses.empty ())
+    mappings.insert_retained_uses (expr.get_mappings ().get_hirid (),
+				   std::move (uses));
+}
+
+void
+Simplifier::visit (IfExpr &expr)
+{
+  fold_conditional (expr, nullptr);
+}
+
+void
+Simplifier::visit (IfExprConseqElse &expr)
+{
+  fold_conditional (expr, expr.get_else_block ());
+}
+
+void
+Simplifier::visit (IfExprConseqIf &expr)
+{
+  fold_conditional (expr, expr.get_conseq_if_expr ());
+}
+
+void
+Simplifier::visit (IfExprConseqIfLet &expr)
+{
+  walk (expr.get_if_condition ());
+  expr.get_if_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (IfLetExpr &expr)
+{
+  walk (expr.get_scrutinee_expr ().get ());
+  expr.get_if_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (IfLetExprConseqElse &expr)
+{
+  walk (expr.get_scrutinee_expr ().get ());
+  expr.get_if_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (IfLetExprConseqIf &expr)
+{
+  walk (expr.get_scrutinee_expr ().get ());
+  expr.get_if_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (IfLetExprConseqIfLet &expr)
+{
+  walk (expr.get_scrutinee_expr ().get ());
+  expr.get_if_block ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (MatchExpr &expr)
+{
+  walk (expr.get_scrutinee_expr ().get ());
+  for (auto &match_case : expr.get_match_cases ())
+    {
+      MatchArm &arm = match_case.get_arm ();
+      if (arm.has_match_arm_guard ())
+	fold (arm.get_guard_expr ());
+      fold (match_case.get_expr ());
+    }
+}
+
+void
+Simplifier::visit (Module &module)
+{
+  for (auto &item : module.get_items ())
+    item->accept_vis (*this);
+}
+
+void
+Simplifier::visit (Function &function)
+{
+  function.get_definition ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (ConstantItem &const_item)
+{
+  // constants are folded on their first use, which may come before the item
+  if (!folded_consts.insert (const_item.get_mappings ().get_hirid ()).second)
+    return;
+
+  std::vector<HirId> *saved = discarded;
+  discarded = nullptr;
+  fold (const_item.get_const_expr ());
+  discarded = saved;
+}
+
+void
+Simplifier::visit (TraitItemFunc &item)
+{
+  if (item.has_block_defined ())
+    item.get_block_expr ()->accept_vis (*this);
+}
+
+void
+Simplifier::visit (Trait &trait)
+{
+  for (auto &item : trait.get_trait_items ())
+    item->accept_vis (*this);
+}
+
+void
+Simplifier::visit (ImplBlock &impl)
+{
+  for (auto &item : impl.get_impl_items ())
+    item->accept_vis (*this);
+}
+
+void
+Simplifier::visit (LetStmt &stmt)
+{
+  if (stmt.has_init_expr ())
+    fold (stmt.get_initializer ());
+}
+
+void
+Simplifier::visit (ExprStmtWithoutBlock &stmt)
+{
+  fold (stmt.get_stmt_expr ());
+}
+
+void
+Simplifier::visit (ExprStmtWithBlock &stmt)
+{
+  stmt.get_expr ()->accept_vis (*this);
+}
+
+} // namespace HIR
+} // namespace Rust
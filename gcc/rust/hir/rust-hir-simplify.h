@@ -0,0 +1,147 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_HIR_SIMPLIFY_H
+#define RUST_HIR_SIMPLIFY_H
+
+#include "rust-hir-visitor.h"
+#include "rust-hir-full.h"
+#include "rust-hir-type-check.h"
+#include "rust-name-resolver.h"
+
+namespace Rust {
+namespace HIR {
+
+/* Simplifies the bodies of a type checked crate before they are lowered to
+ * GENERIC, so that codegen and the GCC folders see less of the code.
+ *
+ * Operators whose operands are all integer or boolean literals, casts of such
+ * literals and uses of constants whose value is a literal are folded into a
+ * single literal. The literal takes over the mappings of the expression it
+ * replaces, so the types and adjustments recorded for that HirId still apply.
+ * Folding gives up whenever the value would not fit its type, is divided by
+ * zero or goes through an operator overload, leaving the diagnostic to the
+ * usual path.
+ *
+ * An `if` whose condition folds to a literal keeps both of its blocks, and
+ * codegen only lowers the taken one. The locals and constants named by the
+ * code which is dropped this way, or folded away, are recorded with the
+ * mappings as retained uses so codegen still marks them as used. */
+class Simplifier : public HIRFullVisitorBase
+{
+public:
+  static void simplify (HIR::Crate &crate);
+
+private:
+  using HIRFullVisitorBase::visit;
+
+  void visit (PathInExpression &path) override;
+  void visit (BorrowExpr &expr) override;
+  void visit (DereferenceExpr &expr) override;
+  void visit (ErrorPropagationExpr &expr) override;
+  void visit (NegationExpr &expr) override;
+  void visit (ArithmeticOrLogicalExpr &expr) override;
+  void visit (ComparisonExpr &expr) override;
+  void visit (LazyBooleanExpr &expr) override;
+  void visit (TypeCastExpr &expr) override;
+  void visit (AssignmentExpr &expr) override;
+  void visit (CompoundAssignmentExpr &expr) override;
+  void visit (GroupedExpr &expr) override;
+  void visit (ArrayElemsValues &elems) override;
+  void visit (ArrayElemsCopied &elems) override;
+  void visit (ArrayExpr &expr) override;
+  void visit (ArrayIndexExpr &expr) override;
+  void visit (TupleExpr &expr) override;
+  void visit (TupleIndexExpr &expr) override;
+  void visit (StructExprFieldIdentifier &field) override;
+  void visit (StructExprFieldIdentifierValue &field) override;
+  void visit (StructExprFieldIndexValue &field) override;
+  void visit (StructExprStructFields &expr) override;
+  void visit (StructExprStructBase &expr) override;
+  void visit (CallExpr &expr) override;
+  void visit (MethodCallExpr &expr) override;
+  void visit (FieldAccessExpr &expr) override;
+  void visit (BlockExpr &expr) override;
+  void visit (BreakExpr &expr) override;
+  void visit (RangeFromToExpr &expr) override;
+  void visit (RangeFromExpr &expr) override;
+  void visit (RangeToExpr &expr) override;
+  void visit (RangeFromToInclExpr &expr) override;
+  void visit (RangeToInclExpr &expr) override;
+  void visit (ReturnExpr &expr) override;
+  void visit (UnsafeBlockExpr &expr) override;
+  void visit (LoopExpr &expr) override;
+  void visit (WhileLoopExpr &expr) override;
+  void visit (WhileLetLoopExpr &expr) override;
+  void visit (ForLoopExpr &expr) override;
+  void visit (IfExpr &expr) override;
+  void visit (IfExprConseqElse &expr) override;
+  void visit (IfExprConseqIf &expr) override;
+  void visit (IfExprConseqIfLet &expr) override;
+  void visit (IfLetExpr &expr) override;
+  void visit (IfLetExprConseqElse &expr) override;
+  void visit (IfLetExprConseqIf &expr) override;
+  void visit (IfLetExprConseqIfLet &expr) override;
+  void visit (MatchExpr &expr) override;
+  void visit (Module &module) override;
+  void visit (Function &function) override;
+  void visit (ConstantItem &const_item) override;
+  void visit (TraitItemFunc &item) override;
+  void visit (Trait &trait) override;
+  void visit (ImplBlock &impl) override;
+  void visit (LetStmt &stmt) override;
+  void visit (ExprStmtWithoutBlock &stmt) override;
+  void visit (ExprStmtWithBlock &stmt) override;
+
+  Simplifier ();
+
+  // Simplify the expression owned by SLOT, replacing it if it folded
+  template <typename T> void fold (std::unique_ptr<T> &slot);
+
+  // Simplify an expression which cannot be replaced where it is
+  void walk (Expr *expr);
+
+  // Walk code which is never lowered, recording what it uses into USES
+  void discard (Expr *expr, std::vector<HirId> &uses);
+
+  // Replace EXPR by a literal with value VALUE, once OPERANDS are folded
+  void fold_to (Expr &expr, std::string value, Literal::LitType type,
+		std::initializer_list<Expr *> operands);
+
+  void fold_conditional (IfExpr &expr, Expr *conseq);
+  void record_use (NodeId ast_node_id);
+  LiteralExpr *constant_value (HirId ref);
+
+  bool int_type (HirId id, unsigned *precision, signop *sign) const;
+  bool int_literal (Expr *expr, widest_int *value, unsigned *precision,
+		    signop *sign) const;
+  bool bool_literal (Expr *expr, bool *value) const;
+
+  std::unique_ptr<LiteralExpr> replacement;
+  std::vector<HirId> *discarded;
+  std::set<HirId> folded_consts;
+
+  Resolver::Resolver &resolver;
+  Resolver::TypeCheckContext &tyctx;
+  Analysis::Mappings &mappings;
+};
+
+} // namespace HIR
+} // namespace Rust
+
+#endif // RUST_HIR_SIMPLIFY_H
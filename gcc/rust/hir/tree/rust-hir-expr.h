@@ -174,7 +174,7 @@ public:
 
   std::unique_ptr<Expr> &get_expr () { return main_or_left_expr; }
 
-  ExprType get_expression_type () const override final
+  ExprType get_expression_type () const override
   {
     return ExprType::Operator;
   }
@@ -390,6 +390,15 @@ public:
   Expr *get_lhs () { return main_or_left_expr.get (); }
   Expr *get_rhs () { return right_expr.get (); }
 
+  std::unique_ptr<Expr> &get_left_expr () { return main_or_left_expr; }
+  std::unique_ptr<Expr> &get_right_expr () { return right_expr; }
+
+  // ExprType names the operator in this class
+  Expr::ExprType get_expression_type () const override final
+  {
+    return Expr::ExprType::ArithmeticOrLogical;
+  }
+
 protected:
   /* Use covariance to implement clone function as returning this object rather
    * than base */
@@ -462,6 +471,9 @@ public:
   Expr *get_lhs () { return main_or_left_expr.get (); }
   Expr *get_rhs () { return right_expr.get (); }
 
+  std::unique_ptr<Expr> &get_left_expr () { return main_or_left_expr; }
+  std::unique_ptr<Expr> &get_right_expr () { return right_expr; }
+
   ExprType get_kind () { return expr_type; }
 
   /* TODO: implement via a function call to std::cmp::PartialEq::eq(&op1, &op2)
@@ -537,6 +549,9 @@ public:
 
   Expr *get_rhs () { return right_expr.get (); }
 
+  std::unique_ptr<Expr> &get_left_expr () { return main_or_left_expr; }
+  std::unique_ptr<Expr> &get_right_expr () { return right_expr; }
+
 protected:
   /* Use covariance to implement clone function as returning this object rather
    * than base */
@@ -670,6 +685,9 @@ public:
   Expr *get_lhs () { return main_or_left_expr.get (); }
   Expr *get_rhs () { return right_expr.get (); }
 
+  std::unique_ptr<Expr> &get_left_expr () { return main_or_left_expr; }
+  std::unique_ptr<Expr> &get_right_expr () { return right_expr; }
+
 protected:
   /* Use covariance to implement clone function as returning this object rather
    * than base */
@@ -2817,6 +2835,7 @@ public:
   void accept_vis (HIRExpressionVisitor &vis) override;
 
   Expr *get_expr () { return return_expr.get (); }
+  std::unique_ptr<Expr> &get_returned_expr () { return return_expr; }
 
   ExprType get_expression_type () const override final
   {
@@ -3205,6 +3224,7 @@ public:
   void accept_vis (HIRFullVisitor &vis) override;
   void accept_vis (HIRExpressionVisitor &vis) override;
 
+  std::unique_ptr<Pattern> &get_pattern () { return pattern; }
   std::unique_ptr<Expr> &get_iterator_expr () { return iterator_expr; }
 
 protected:
@@ -3285,6 +3305,7 @@ public:
   void vis_if_block (HIRFullVisitor &vis) { if_block->accept_vis (vis); }
 
   Expr *get_if_condition () { return condition.get (); }
+  std::unique_ptr<Expr> &get_condition_expr () { return condition; }
   BlockExpr *get_if_block () { return if_block.get (); }
 
   ExprType get_expression_type () const final override { return ExprType::If; }
@@ -1206,7 +1206,7 @@ public:
 
   const FunctionQualifiers &get_qualifiers () const { return qualifiers; }
 
-  Identifier get_function_name () const { return function_name; }
+  const Identifier &get_function_name () const { return function_name; }
 
   // TODO: is this better? Or is a "vis_block" better?
   WhereClause &get_where_clause () { return where_clause; }
@@ -1334,7 +1334,7 @@ public:
     return existing_type;
   }
 
-  Identifier get_new_type_name () const { return new_type_name; }
+  const Identifier &get_new_type_name () const { return new_type_name; }
 
   ItemKind get_item_kind () const override { return ItemKind::TypeAlias; }
 
@@ -2113,8 +2113,9 @@ public:
   Type *get_type () { return type.get (); }
 
   Expr *get_expr () { return const_expr.get (); }
+  std::unique_ptr<Expr> &get_const_expr () { return const_expr; }
 
-  std::string get_identifier () { return identifier; }
+  const std::string &get_identifier () const { return identifier; }
 
   Analysis::NodeMapping get_impl_mappings () const override
   {
@@ -27,14 +27,14 @@ namespace HIR {
 // The "identifier" (not generic args) aspect of each path expression segment
 class PathIdentSegment
 {
-  std::string segment_name;
+  Symbol segment_name;
 
   // TODO: should this have location info stored?
 
   // only allow identifiers, "super", "self", "Self", "crate", or "$crate"
 public:
-  PathIdentSegment (std::string segment_name)
-    : segment_name (std::move (segment_name))
+  PathIdentSegment (const std::string &segment_name)
+    : segment_name (Symbol::intern (segment_name))
   {}
 
   /* TODO: insert check in constructor for this? Or is this a semantic error
@@ -47,9 +47,11 @@ public:
   static PathIdentSegment create_error () { return PathIdentSegment (""); }
 
   // Returns whether PathIdentSegment is in an error state.
-  bool is_error () const { return segment_name.empty (); }
+  bool is_error () const { return segment_name.is_empty (); }
 
-  std::string as_string () const { return segment_name; }
+  const std::string &as_string () const { return segment_name.as_string (); }
+
+  Symbol get_symbol () const { return segment_name; }
 };
 
 // A binding of an identifier to a type used in generic arguments in paths
@@ -89,6 +89,12 @@ public:
   // Returns whether the IdentifierPattern has a pattern to bind.
   bool has_pattern_to_bind () const { return to_bind != nullptr; }
 
+  std::unique_ptr<Pattern> &get_to_bind ()
+  {
+    rust_assert (has_pattern_to_bind ());
+    return to_bind;
+  }
+
   // Constructor
   IdentifierPattern (Analysis::NodeMapping mappings, Identifier ident,
 		     Location locus, bool is_ref = false,
@@ -249,6 +255,8 @@ public:
 
   Literal get_literal () const { return literal; }
 
+  bool get_has_minus () const { return has_minus; }
+
   void accept_vis (HIRFullVisitor &vis) override;
 
   RangePatternBoundType get_bound_type () const override
@@ -572,6 +580,10 @@ public:
 
   void accept_vis (HIRFullVisitor &vis) override;
 
+  TupleIndex get_index () const { return index; }
+
+  std::unique_ptr<Pattern> &get_tuple_pattern () { return tuple_pattern; }
+
   ItemType get_item_type () const override final { return ItemType::TUPLE_PAT; }
 
 protected:
@@ -624,6 +636,10 @@ public:
 
   void accept_vis (HIRFullVisitor &vis) override;
 
+  Identifier get_identifier () const { return ident; }
+
+  std::unique_ptr<Pattern> &get_ident_pattern () { return ident_pattern; }
+
   ItemType get_item_type () const override final { return ItemType::IDENT_PAT; }
 
 protected:
@@ -1140,6 +1156,16 @@ public:
 
   void accept_vis (HIRFullVisitor &vis) override;
 
+  std::vector<std::unique_ptr<Pattern> > &get_lower_patterns ()
+  {
+    return lower_patterns;
+  }
+
+  std::vector<std::unique_ptr<Pattern> > &get_upper_patterns ()
+  {
+    return upper_patterns;
+  }
+
   TuplePatternItemType get_pattern_type () const override
   {
     return TuplePatternItemType::RANGED;
@@ -141,6 +141,7 @@ public:
   HIR::Type *get_type () { return type.get (); }
 
   HIR::Expr *get_init_expr () { return init_expr.get (); }
+  std::unique_ptr<Expr> &get_initializer () { return init_expr; }
 
   HIR::Pattern *get_pattern () { return variables_pattern.get (); }
 
@@ -207,6 +208,7 @@ public:
   void accept_vis (HIRStmtVisitor &vis) override;
 
   Expr *get_expr () { return expr.get (); }
+  std::unique_ptr<Expr> &get_stmt_expr () { return expr; }
 
 protected:
   /* Use covariance to implement clone function as returning this object rather
@@ -817,6 +817,11 @@ public:
     return params;
   }
 
+  const FunctionQualifiers &get_function_qualifiers () const
+  {
+    return function_qualifiers;
+  }
+
   // TODO: would a "vis_type" be better?
   std::unique_ptr<Type> &get_return_type ()
   {
@@ -24,7 +24,9 @@
 #include "rust-token.h"
 #include "rust-location.h"
 #include "rust-hir-map.h"
+#include "rust-builtin-attributes.h"
 #include "rust-diagnostics.h"
+#include "rust-pool-allocator.h"
 
 namespace Rust {
 typedef std::string Identifier;
@@ -45,7 +47,7 @@ class HIRTypeVisitor;
 // forward decl for use in token tree method
 class Token;
 
-class Node
+class Node : public PoolAllocated
 {
 public:
   // Kind for downcasting various HIR nodes to other base classes when visiting
@@ -171,6 +173,7 @@ protected:
 class Item : public Stmt
 {
   AST::AttrVec outer_attrs;
+  Analysis::BuiltinAttrSet builtin_attrs;
 
   // TODO: should outer attrs be defined here or in each derived class?
 
@@ -211,16 +214,28 @@ public:
   add_crate_name (std::vector<std::string> &names ATTRIBUTE_UNUSED) const
   {}
 
-  AST::AttrVec &get_outer_attrs () { return outer_attrs; }
   const AST::AttrVec &get_outer_attrs () const { return outer_attrs; }
 
+  const Analysis::BuiltinAttrSet &get_builtin_attrs () const
+  {
+    return builtin_attrs;
+  }
+
+  // Append ATTRS to the outer attributes, keeping the builtin set up to date
+  void append_outer_attrs (const AST::AttrVec &attrs)
+  {
+    outer_attrs.insert (outer_attrs.end (), attrs.begin (), attrs.end ());
+    builtin_attrs = Analysis::BuiltinAttrSet (outer_attrs);
+  }
+
   bool is_item () const override final { return true; }
 
 protected:
   // Constructor
   Item (Analysis::NodeMapping mappings,
 	AST::AttrVec outer_attribs = AST::AttrVec ())
-    : Stmt (std::move (mappings)), outer_attrs (std::move (outer_attribs))
+    : Stmt (std::move (mappings)), outer_attrs (std::move (outer_attribs)),
+      builtin_attrs (outer_attrs)
   {}
 
   // Clone function implementation as pure virtual method
@@ -252,6 +267,7 @@ public:
   {
     Lit,
     Operator,
+    ArithmeticOrLogical,
     Grouped,
     Array,
     ArrayIndex,
@@ -489,7 +505,7 @@ protected:
 
 /* Abstract base class representing a type param bound - Lifetime and TraitBound
  * extends it */
-class TypeParamBound
+class TypeParamBound : public PoolAllocated
 {
 public:
   enum BoundType
@@ -582,7 +598,7 @@ protected:
 
 /* Base generic parameter in HIR. Abstract - can be represented by a Lifetime or
  * Type param */
-class GenericParam
+class GenericParam : public PoolAllocated
 {
 public:
   virtual ~GenericParam () {}
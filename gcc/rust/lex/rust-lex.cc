@@ -117,17 +117,175 @@ is_non_decimal_int_literal_separator (char character)
   return character == 'x' || character == 'o' || character == 'b';
 }
 
+/* Bulk scanning of the input buffer. Comments, string bodies, identifiers and
+ * indentation are mostly made of bytes the lexer has nothing to do for, so
+ * like search_line_fast in libcpp these are skipped 16 bytes at a time. GCC's
+ * generic vectors are used for the compares, which become SSE2 or NEON
+ * instructions where the target has them, and the first hit of a block is
+ * found with pmovmskb on x86. Each scanner returns the length of the run at
+ * the start of DATA[0, SIZE) that holds none of the bytes it stops at. */
+
+#if defined(__GNUC__) && GCC_VERSION >= 4008
+#define RUST_LEX_VECTOR_SCAN
+typedef unsigned char lex_v16qu __attribute__ ((__vector_size__ (16)));
+typedef signed char lex_v16qs __attribute__ ((__vector_size__ (16)));
+
+static inline lex_v16qu
+lex_splat (unsigned char c)
+{
+  lex_v16qu v;
+  memset (&v, c, sizeof (v));
+  return v;
+}
+
+// Index of the first byte of HIT that is set, or 16 when there is none.
+static inline unsigned
+lex_first_hit (lex_v16qs hit)
+{
+#ifdef __SSE2__
+  typedef char v16qi __attribute__ ((__vector_size__ (16)));
+  unsigned mask = __builtin_ia32_pmovmskb128 ((v16qi) hit);
+  return mask == 0 ? 16 : __builtin_ctz (mask);
+#else
+  uint64_t words[2];
+  memcpy (words, &hit, sizeof (words));
+  if ((words[0] | words[1]) == 0)
+    return 16;
+
+  const unsigned char *bytes = reinterpret_cast<const unsigned char *> (words);
+  unsigned i = 0;
+  while (bytes[i] == 0)
+    i++;
+  return i;
+#endif
+}
+#endif
+
+template <typename Stop>
+static inline size_t
+lex_scan_run (const unsigned char *data, size_t size, const Stop &stop)
+{
+  size_t i = 0;
+#ifdef RUST_LEX_VECTOR_SCAN
+  for (; i + 16 <= size; i += 16)
+    {
+      lex_v16qu block;
+      memcpy (&block, data + i, sizeof (block));
+      unsigned found = lex_first_hit (stop.block (block));
+      if (found < 16)
+	return i + found;
+    }
+#endif
+  while (i < size && !stop.byte (data[i]))
+    i++;
+  return i;
+}
+
+// Stops at anything but a space.
+struct LexStopNonSpace
+{
+  bool byte (unsigned char c) const { return c != ' '; }
+#ifdef RUST_LEX_VECTOR_SCAN
+  lex_v16qs block (lex_v16qu v) const { return v != lex_splat (' '); }
+#endif
+};
+
+// Stops at anything that cannot continue an ASCII identifier.
+struct LexStopNonIdentifier
+{
+  bool byte (unsigned char c) const
+  {
+    return !(ISALNUM (c) || c == '_');
+  }
+#ifdef RUST_LEX_VECTOR_SCAN
+  lex_v16qs block (lex_v16qu v) const
+  {
+    lex_v16qs ident = (v >= lex_splat ('a')) & (v <= lex_splat ('z'));
+    ident |= (v >= lex_splat ('A')) & (v <= lex_splat ('Z'));
+    ident |= (v >= lex_splat ('0')) & (v <= lex_splat ('9'));
+    ident |= v == lex_splat ('_');
+    return ~ident;
+  }
+#endif
+};
+
+// Stops at any of up to four bytes, repeat one to look for fewer.
+struct LexStopAt
+{
+  unsigned char a, b, c, d;
+
+  LexStopAt (unsigned char a, unsigned char b, unsigned char c,
+	     unsigned char d)
+    : a (a), b (b), c (c), d (d)
+  {}
+
+  bool byte (unsigned char x) const
+  {
+    return x == a || x == b || x == c || x == d;
+  }
+#ifdef RUST_LEX_VECTOR_SCAN
+  lex_v16qs block (lex_v16qu v) const
+  {
+    return (v == lex_splat (a)) | (v == lex_splat (b)) | (v == lex_splat (c))
+	   | (v == lex_splat (d));
+  }
+#endif
+};
+
+// Stops where a string body needs a closer look: the closing quote, an
+// escape or the start of a multi-byte codepoint.
+struct LexStopInString
+{
+  bool byte (unsigned char c) const
+  {
+    return c == '"' || c == '\\' || c >= 0x80;
+  }
+#ifdef RUST_LEX_VECTOR_SCAN
+  lex_v16qs block (lex_v16qu v) const
+  {
+    return (v == lex_splat ('"')) | (v == lex_splat ('\\'))
+	   | (v >= lex_splat (0x80));
+  }
+#endif
+};
+
+// Stops at the quote that may close a raw string or the start of a
+// multi-byte codepoint.
+struct LexStopInRawString
+{
+  bool byte (unsigned char c) const { return c == '"' || c >= 0x80; }
+#ifdef RUST_LEX_VECTOR_SCAN
+  lex_v16qs block (lex_v16qu v) const
+  {
+    return (v == lex_splat ('"')) | (v >= lex_splat (0x80));
+  }
+#endif
+};
+
+template <typename Stop>
+size_t
+Lexer::scan_input (const Stop &stop)
+{
+  return lex_scan_run (input_data + input_offset, input_size - input_offset,
+		       stop);
+}
+
 Lexer::Lexer (const std::string &input)
   : input (RAIIFile::create_error ()), current_line (1), current_column (1),
-    line_map (nullptr), raw_input_source (new BufferInputSource (input, 0)),
-    input_queue{*raw_input_source}, token_queue (TokenSource (this))
+    line_map (nullptr), pending_line (0),
+    raw_input_source (new BufferInputSource (input, 0)),
+    input_data (raw_input_source->get_data ()),
+    input_size (raw_input_source->get_size ()), input_offset (0),
+    token_queue (TokenSource (this))
 {}
 
 Lexer::Lexer (const char *filename, RAIIFile file_input, Linemap *linemap)
   : input (std::move (file_input)), current_line (1), current_column (1),
-    line_map (linemap),
+    line_map (linemap), pending_line (0),
     raw_input_source (new FileInputSource (input.get_raw ())),
-    input_queue{*raw_input_source}, token_queue (TokenSource (this))
+    input_data (raw_input_source->get_data ()),
+    input_size (raw_input_source->get_size ()), input_offset (0),
+    token_queue (TokenSource (this))
 {
   // inform line_table that file is being entered and is in line 1
   if (linemap)
@@ -146,45 +304,76 @@ Lexer::~Lexer ()
   // line_map->stop();
 }
 
-/* TODO: need to optimise somehow to avoid the virtual function call in the
- * tight loop. Best idea at the moment is CRTP, but that might make lexer
- * implementation annoying when storing the "base class" (i.e. would need
- * template parameter everywhere), although in practice it would mostly just
- * look ugly and make enclosing classes like Parser also require a type
- * parameter. At this point a macro might be better. OK I guess macros can be
- * replaced by constexpr if or something if possible. */
-Location
-Lexer::get_current_location ()
+Lexer::FileInputSource::FileInputSource (FILE *input)
+  : mapped (nullptr), mapped_size (0)
 {
-  if (line_map)
-    return line_map->get_location (current_column);
-  else
-    // If we have no linemap, we're lexing something without proper locations
-    return Location ();
+  if (input == nullptr)
+    return;
+
+  if (!try_map (input))
+    read_all (input);
 }
 
-int
-Lexer::peek_input (int n)
+Lexer::FileInputSource::~FileInputSource ()
 {
-  return input_queue.peek (n);
+#if HAVE_MMAP_FILE
+  if (mapped != nullptr)
+    munmap (mapped, mapped_size);
+#endif
 }
 
-int
-Lexer::peek_input ()
+bool
+Lexer::FileInputSource::try_map (FILE *input)
 {
-  return peek_input (0);
+#if HAVE_MMAP_FILE
+  // only regular files that have not been read from yet can be mapped
+  int fd = fileno (input);
+  struct stat st;
+  if (fd < 0 || fstat (fd, &st) != 0 || !S_ISREG (st.st_mode)
+      || st.st_size <= 0 || ftell (input) != 0)
+    return false;
+
+  void *addr = mmap (nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  if (addr == MAP_FAILED)
+    return false;
+
+  mapped = addr;
+  mapped_size = st.st_size;
+  data = static_cast<const unsigned char *> (addr);
+  size = mapped_size;
+  return true;
+#else
+  return false;
+#endif
 }
 
 void
-Lexer::skip_input (int n)
+Lexer::FileInputSource::read_all (FILE *input)
 {
-  input_queue.skip (n);
+  char buf[BUFSIZ];
+  size_t n;
+  while ((n = fread (buf, 1, sizeof (buf), input)) > 0)
+    contents.append (buf, n);
+
+  data = reinterpret_cast<const unsigned char *> (contents.data ());
+  size = contents.size ();
 }
 
-void
-Lexer::skip_input ()
+Location
+Lexer::get_current_location ()
 {
-  skip_input (0);
+  if (line_map)
+    {
+      if (pending_line != 0)
+	{
+	  line_map->start_line (pending_line, max_column_hint);
+	  pending_line = 0;
+	}
+      return line_map->get_location (current_column);
+    }
+  else
+    // If we have no linemap, we're lexing something without proper locations
+    return Location ();
 }
 
 void
@@ -195,42 +384,92 @@ Lexer::replace_current_token (TokenPtr replacement)
   rust_debug ("called 'replace_current_token' - this is deprecated");
 }
 
-/* shitty anonymous namespace that can only be accessed inside the compilation
- * unit - used for classify_keyword binary search in sorted array of keywords
- * created with x-macros. */
+/* anonymous namespace that can only be accessed inside the compilation unit -
+ * used for classify_keyword lookups in a hash table of the keywords created
+ * with x-macros. */
 namespace {
-// TODO: make constexpr when update to c++20
-const std::string keyword_index[] = {
-#define RS_TOKEN(x, y)
-#define RS_TOKEN_KEYWORD(name, keyword) keyword,
-  RS_TOKEN_LIST
-#undef RS_TOKEN_KEYWORD
-#undef RS_TOKEN
+struct KeywordEntry
+{
+  const char *keyword;
+  size_t length;
+  TokenId id;
 };
 
-constexpr TokenId keyword_keys[] = {
+constexpr KeywordEntry keyword_list[] = {
 #define RS_TOKEN(x, y)
-#define RS_TOKEN_KEYWORD(name, keyword) name,
+#define RS_TOKEN_KEYWORD(name, keyword) {keyword, sizeof (keyword) - 1, name},
   RS_TOKEN_LIST
 #undef RS_TOKEN_KEYWORD
 #undef RS_TOKEN
 };
 
-constexpr int num_keywords = sizeof (keyword_index) / sizeof (*keyword_index);
+constexpr int num_keywords = sizeof (keyword_list) / sizeof (*keyword_list);
+
+// must be a power of two, and large enough to keep probe chains short
+constexpr size_t keyword_table_size = 256;
+
+/* Hash of an identifier from its length and a few of its bytes, which is
+ * enough to spread the keywords over the table with very few collisions. */
+inline size_t
+keyword_hash (const char *str, size_t length)
+{
+  size_t h = length * 31;
+  h += (unsigned char) str[0] * 7;
+  h += (unsigned char) str[length - 1] * 3;
+  if (length > 2)
+    h += (unsigned char) str[1] * 13;
+  return h & (keyword_table_size - 1);
+}
+
+// Open addressed table of indexes into keyword_list, -1 is an empty slot.
+class KeywordTable
+{
+public:
+  KeywordTable ()
+  {
+    for (size_t i = 0; i < keyword_table_size; i++)
+      slots[i] = -1;
+
+    for (int i = 0; i < num_keywords; i++)
+      {
+	const KeywordEntry &kw = keyword_list[i];
+	size_t h = keyword_hash (kw.keyword, kw.length);
+	while (slots[h] != -1)
+	  h = (h + 1) & (keyword_table_size - 1);
+	slots[h] = i;
+      }
+  }
+
+  const KeywordEntry *lookup (const char *str, size_t length) const
+  {
+    for (size_t h = keyword_hash (str, length); slots[h] != -1;
+	 h = (h + 1) & (keyword_table_size - 1))
+      {
+	const KeywordEntry &kw = keyword_list[slots[h]];
+	if (kw.length == length && memcmp (kw.keyword, str, length) == 0)
+	  return &kw;
+      }
+    return nullptr;
+  }
+
+private:
+  int slots[keyword_table_size];
+};
+
+const KeywordTable keyword_table;
 } // namespace
 
 /* Determines whether the string passed in is a keyword or not. If it is, it
  * returns the keyword name.  */
 TokenId
-Lexer::classify_keyword (const std::string &str)
+Lexer::classify_keyword (const char *str, size_t length)
 {
-  const std::string *last = keyword_index + num_keywords;
-  const std::string *idx = std::lower_bound (keyword_index, last, str);
-
-  if (idx == last || str != *idx)
+  if (length == 0)
     return IDENTIFIER;
 
-  // TODO: possibly replace this x-macro system with something like hash map?
+  const KeywordEntry *kw = keyword_table.lookup (str, length);
+  if (kw == nullptr)
+    return IDENTIFIER;
 
   // We now have the expected token ID of the reserved keyword. However, some
   // keywords are reserved starting in certain editions. For example, `try` is
@@ -238,7 +477,7 @@ Lexer::classify_keyword (const std::string &str)
   // reserved keywords in the future.
   //
   // https://doc.rust-lang.org/reference/keywords.html#reserved-keywords
-  auto id = keyword_keys[idx - keyword_index];
+  auto id = kw->id;
 
   // `try` is not a reserved keyword before 2018
   if (Session::get_instance ().options.get_edition ()
@@ -249,6 +488,12 @@ Lexer::classify_keyword (const std::string &str)
   return id;
 }
 
+TokenId
+Lexer::classify_keyword (const std::string &str)
+{
+  return classify_keyword (str.data (), str.size ());
+}
+
 TokenPtr
 Lexer::build_token ()
 {
@@ -366,7 +611,7 @@ Lexer::build_token ()
 		  current_line++;
 		  current_column = 1;
 		  // tell line_table that new line starts
-		  start_line (current_line, max_column_hint);
+		  start_line (current_line);
 		  break;
 		}
 	      else
@@ -387,13 +632,18 @@ Lexer::build_token ()
 	  current_line++;
 	  current_column = 1;
 	  // tell line_table that new line starts
-	  start_line (current_line, max_column_hint);
+	  start_line (current_line);
 	  continue;
 	case '\r': // cr
 	  // Ignore, we expect a newline (lf) soon.
 	  continue;
 	case ' ': // space
-	  current_column++;
+	  {
+	    // indentation comes in runs, take all of it at once
+	    size_t run = scan_input (LexStopNonSpace ());
+	    input_offset += run;
+	    current_column += run + 1;
+	  }
 	  continue;
 	case '\t': // tab
 	  // width of a tab is not well-defined, assume 8 spaces
@@ -508,15 +758,12 @@ Lexer::build_token ()
 	      // (but not an inner or outer doc comment)
 	      skip_input ();
 	      current_column += 2;
-	      current_char = peek_input ();
 
 	      // basically ignore until line finishes
-	      while (current_char != '\n' && current_char != EOF)
-		{
-		  skip_input ();
-		  current_column++; // not used
-		  current_char = peek_input ();
-		}
+	      size_t run = scan_input (LexStopAt ('\n', '\n', '\n', '\n'));
+	      input_offset += run;
+	      current_column += run; // not used
+	      current_char = peek_input ();
 	      continue;
 	    }
 	  else if (peek_input () == '/'
@@ -553,13 +800,19 @@ Lexer::build_token ()
 		      break;
 		    }
 		  str += current_char;
+
+		  size_t run = scan_input (LexStopAt ('\n', '\r', '\r', '\r'));
+		  str.append (reinterpret_cast<const char *> (input_data
+							      + input_offset),
+			      run);
+		  input_offset += run;
 		  current_char = peek_input ();
 		}
 	      skip_input ();
 	      current_line++;
 	      current_column = 1;
 	      // tell line_table that new line starts
-	      start_line (current_line, max_column_hint);
+	      start_line (current_line);
 
 	      str.shrink_to_fit ();
 	      if (is_inner)
@@ -636,12 +889,14 @@ Lexer::build_token ()
 		      current_line++;
 		      current_column = 1;
 		      // tell line_table that new line starts
-		      start_line (current_line, max_column_hint);
+		      start_line (current_line);
 		      continue;
 		    }
 
 		  skip_input ();
-		  current_column++;
+		  size_t run = scan_input (LexStopAt ('/', '*', '\n', '\n'));
+		  input_offset += run;
+		  current_column += run + 1;
 		}
 
 	      // refresh new token
@@ -705,14 +960,19 @@ Lexer::build_token ()
 		      current_line++;
 		      current_column = 1;
 		      // tell line_table that new line starts
-		      start_line (current_line, max_column_hint);
+		      start_line (current_line);
 		      str += '\n';
 		      continue;
 		    }
 
 		  str += current_char;
 		  skip_input ();
-		  current_column++;
+		  size_t run = scan_input (LexStopAt ('/', '*', '\n', '\r'));
+		  str.append (reinterpret_cast<const char *> (input_data
+							      + input_offset),
+			      run);
+		  input_offset += run;
+		  current_column += run + 1;
 		}
 
 	      str.shrink_to_fit ();
@@ -1419,7 +1679,7 @@ Lexer::parse_partial_string_continue ()
 	  current_line++;
 	  current_column = 1;
 	  // tell line_table that new line starts
-	  start_line (current_line, max_column_hint);
+	  start_line (current_line);
 
 	  // reset "length"
 	  additional_length_offset = 1;
@@ -1946,6 +2206,14 @@ Lexer::parse_string (Location loc)
 
       str += current_char32;
       skip_codepoint_input ();
+
+      // plain ascii up to the next quote, escape or multi-byte codepoint
+      size_t run = scan_input (LexStopInString ());
+      str.append (reinterpret_cast<const char *> (input_data + input_offset),
+		  run);
+      input_offset += run;
+      length += run;
+
       current_char32 = peek_codepoint_input ();
     }
 
@@ -1976,24 +2244,20 @@ Lexer::parse_string (Location loc)
 TokenPtr
 Lexer::parse_identifier_or_keyword (Location loc)
 {
-  std::string str;
-  str.reserve (16); // default
-  str += current_char;
+  // the first char has already been consumed, so the name starts just before
+  // the current input position
+  rust_assert (input_offset > 0
+	       && input_data[input_offset - 1] == current_char);
+  const char *start
+    = reinterpret_cast<const char *> (input_data + input_offset - 1);
 
   bool first_is_underscore = current_char == '_';
 
-  int length = 1;
+  // take the entire name
+  size_t run = scan_input (LexStopNonIdentifier ());
+  input_offset += run;
+  int length = 1 + run;
   current_char = peek_input ();
-  // loop through entire name
-  while (ISALPHA (current_char) || ISDIGIT (current_char)
-	 || current_char == '_')
-    {
-      length++;
-
-      str += current_char;
-      skip_input ();
-      current_char = peek_input ();
-    }
 
   current_column += length;
 
@@ -2001,11 +2265,10 @@ Lexer::parse_identifier_or_keyword (Location loc)
   if (first_is_underscore && length == 1)
     return Token::make (UNDERSCORE, loc);
 
-  str.shrink_to_fit ();
-
-  TokenId keyword = classify_keyword (str);
+  // classify straight from the input buffer, so only identifiers need a string
+  TokenId keyword = classify_keyword (start, length);
   if (keyword == IDENTIFIER)
-    return Token::make_identifier (loc, std::move (str));
+    return Token::make_identifier (loc, std::string (start, length));
   else
     return Token::make (keyword, loc);
 }
@@ -2075,6 +2338,14 @@ Lexer::parse_raw_string (Location loc, int initial_hash_count)
 
       str += current_char32;
       skip_codepoint_input ();
+
+      // plain ascii up to the next quote or multi-byte codepoint
+      size_t run = scan_input (LexStopInRawString ());
+      str.append (reinterpret_cast<const char *> (input_data + input_offset),
+		  run);
+      input_offset += run;
+      length += run;
+
       current_char32 = peek_codepoint_input ();
     }
 
@@ -2119,8 +2390,10 @@ Lexer::parse_non_decimal_int_literal (Location loc, IsDigitFunc is_digit_func,
       current_char = peek_input ();
     }
 
-  // convert value to decimal representation
-  long dec_num = std::strtol (existent_str.c_str (), nullptr, base);
+  // convert value to decimal representation, unsigned so that hex tables
+  // of u64 constants survive
+  unsigned long long dec_num
+    = std::strtoull (existent_str.c_str (), nullptr, base);
 
   existent_str = std::to_string (dec_num);
 
@@ -2398,6 +2671,9 @@ Lexer::parse_char_or_lifetime (Location loc)
 int
 Lexer::get_input_codepoint_length ()
 {
+  if (input_ascii_at_offset ())
+    return 1;
+
   uint8_t input = peek_input ();
 
   if ((int8_t) input == EOF)
@@ -2482,6 +2758,9 @@ Lexer::get_input_codepoint_length ()
 Codepoint
 Lexer::peek_codepoint_input ()
 {
+  if (input_ascii_at_offset ())
+    return {input_data[input_offset]};
+
   uint8_t input = peek_input ();
 
   if ((int8_t) input == EOF)
@@ -2552,6 +2831,12 @@ Lexer::peek_codepoint_input ()
 void
 Lexer::skip_codepoint_input ()
 {
+  if (input_ascii_at_offset ())
+    {
+      input_offset++;
+      return;
+    }
+
   int toSkip = get_input_codepoint_length ();
   gcc_assert (toSkip >= 1);
 
@@ -2720,10 +3005,10 @@ Lexer::split_current_token (TokenId new_left, TokenId new_right)
 }
 
 void
-Lexer::start_line (int current_line, int current_column)
+Lexer::start_line (int current_line)
 {
   if (line_map)
-    line_map->start_line (current_line, current_column);
+    pending_line = current_line;
 }
 
 } // namespace Rust
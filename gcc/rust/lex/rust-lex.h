@@ -89,17 +89,40 @@ private:
   Location get_current_location ();
 
   // Skips the current input char.
-  void skip_input ();
+  void skip_input () { skip_input (0); }
   // Advances current input char to n + 1 chars ahead of current position.
-  void skip_input (int n);
+  void skip_input (int n)
+  {
+    rust_assert (n >= 0);
+    input_offset += n + 1;
+    if (input_offset > input_size)
+      input_offset = input_size;
+  }
 
-  // Returns char n chars ahead of current position.
-  int peek_input ();
   // Peeks the current char.
-  int peek_input (int n);
+  int peek_input () { return peek_input (0); }
+  // Returns char n chars ahead of current position.
+  int peek_input (int n)
+  {
+    rust_assert (n >= 0);
+    size_t pos = input_offset + n;
+    return pos < input_size ? input_data[pos] : EOF;
+  }
+
+  // Whether the current char is a whole ascii codepoint, which lets the
+  // codepoint functions skip utf-8 decoding.
+  bool input_ascii_at_offset () const
+  {
+    return input_offset < input_size && input_data[input_offset] < 0x80;
+  }
+
+  // Length of the run of input from the current position up to the first
+  // char STOP stops at, see lex_scan_run.
+  template <typename Stop> size_t scan_input (const Stop &stop);
 
   // Classifies keyword (i.e. gets id for keyword).
   TokenId classify_keyword (const std::string &str);
+  TokenId classify_keyword (const char *str, size_t length);
 
   // Builds a token from the input queue.
   TokenPtr build_token ();
@@ -178,7 +201,7 @@ public:
   std::string get_filename () { return std::string (input.get_filename ()); }
 
 private:
-  void start_line (int current_line, int current_column);
+  void start_line (int current_line);
 
   // File for use as input.
   RAIIFile input;
@@ -192,60 +215,69 @@ private:
   int current_char;
   // Line map.
   Linemap *line_map;
+  /* The line the lexer has moved to but which has no location yet, or 0. The
+   * line map only gets the lines a location is taken on, not the blank and
+   * comment lines nor those inside of multi-line literals. */
+  int pending_line;
 
   /* Max column number that can be quickly allocated - higher may require
    * allocating new linemap */
   static const int max_column_hint = 80;
 
-  // Input source wrapper thing.
+  /* The whole input is held in one contiguous buffer, so peeking and skipping
+   * input chars is plain indexing rather than a call per char. */
   class InputSource
   {
   public:
     virtual ~InputSource () {}
 
-    // Overload operator () to return next char from input stream.
-    virtual int next () = 0;
+    const unsigned char *get_data () const { return data; }
+    size_t get_size () const { return size; }
+
+  protected:
+    InputSource () : data (nullptr), size (0) {}
+
+    const unsigned char *data;
+    size_t size;
   };
 
   class FileInputSource : public InputSource
   {
   private:
-    // Input source file.
-    FILE *input;
+    // Contents of the file when it could not be mapped.
+    std::string contents;
+    // The mapped region of the file, if any.
+    void *mapped;
+    size_t mapped_size;
 
-  public:
-    // Create new input source from file.
-    FileInputSource (FILE *input) : input (input) {}
+    bool try_map (FILE *input);
+    void read_all (FILE *input);
 
-    int next () override { return fgetc (input); }
+  public:
+    // Map the file if possible, otherwise read all of it into memory.
+    FileInputSource (FILE *input);
+    ~FileInputSource ();
   };
 
   class BufferInputSource : public InputSource
   {
-  private:
-    const std::string &buffer;
-    size_t offs;
-
   public:
-    // Create new input source from file.
+    // Create new input source from a string which must outlive the lexer.
     BufferInputSource (const std::string &b, size_t offset)
-      : buffer (b), offs (offset)
-    {}
-
-    int next () override
     {
-      if (offs >= buffer.size ())
-	return EOF;
-
-      return buffer.at (offs++);
+      if (offset < b.size ())
+	{
+	  data = reinterpret_cast<const unsigned char *> (b.data ()) + offset;
+	  size = b.size () - offset;
+	}
     }
   };
 
-  // The input source for the lexer.
-  // InputSource input_source;
-  // Input file queue.
+  // The input source for the lexer, and a cursor into its buffer.
   std::unique_ptr<InputSource> raw_input_source;
-  buffered_queue<int, InputSource &> input_queue;
+  const unsigned char *input_data;
+  size_t input_size;
+  size_t input_offset;
 
   // Token source wrapper thing.
   struct TokenSource
@@ -122,7 +122,7 @@ Token::get_str () const
   // HACK: allow referencing an empty string
   static const std::string empty = "";
 
-  if (str == NULL)
+  if (str.is_null ())
     {
       rust_error_at (get_locus (),
 		     "attempted to get string for %<%s%>, which has no string. "
@@ -130,6 +130,6 @@ Token::get_str () const
 		     get_token_description ());
       return empty;
     }
-  return *str;
+  return str.as_string ();
 }
 } // namespace Rust
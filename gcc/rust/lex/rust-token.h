@@ -21,6 +21,8 @@
 
 #include "rust-linemap.h"
 #include "rust-codepoint.h"
+#include "rust-symbol.h"
+#include "rust-pool-allocator.h"
 
 // order: config, system, coretypes, input
 #include "config.h"
@@ -244,46 +246,47 @@ private:
   TokenId token_id;
   // Token location.
   Location locus;
-  // Associated text (if any) of token.
-  std::unique_ptr<std::string> str;
+  /* Associated text (if any) of token. All token text is interned so tokens
+   * own no heap memory and are cheap to create and destroy. */
+  Symbol str;
   // TODO: maybe remove issues and just store std::string as value?
   /* Type hint for token based on lexer data (e.g. type suffix). Does not exist
    * for most tokens. */
   PrimitiveCoreType type_hint;
 
-  // Token constructor from token id and location. Has a null string.
-  Token (TokenId token_id, Location location)
-    : token_id (token_id), locus (location), str (nullptr),
-      type_hint (CORETYPE_UNKNOWN)
-  {}
+  /* Tokens are created through the factory methods below, this tag keeps the
+   * constructors usable by allocate_shared but not by anything else. */
+  struct PrivateTag
+  {
+    explicit PrivateTag () {}
+  };
 
-  // Token constructor from token id, location, and a string.
-  Token (TokenId token_id, Location location, std::string &&paramStr)
-    : token_id (token_id), locus (location),
-      str (new std::string (std::move (paramStr))), type_hint (CORETYPE_UNKNOWN)
-  {}
+  template <typename... Args> static TokenPtr allocate (Args &&... args)
+  {
+    return std::allocate_shared<Token> (PoolAllocator<Token> (), PrivateTag (),
+					std::forward<Args> (args)...);
+  }
 
-  // Token constructor from token id, location, and a char.
-  Token (TokenId token_id, Location location, char paramChar)
-    : token_id (token_id), locus (location),
-      str (new std::string (1, paramChar)), type_hint (CORETYPE_UNKNOWN)
+public:
+  // Token constructor from token id and location. Has a null string.
+  Token (PrivateTag, TokenId token_id, Location location)
+    : token_id (token_id), locus (location), type_hint (CORETYPE_UNKNOWN)
   {}
 
-  // Token constructor from token id, location, and a "codepoint".
-  Token (TokenId token_id, Location location, Codepoint paramCodepoint)
-    : token_id (token_id), locus (location),
-      str (new std::string (paramCodepoint.as_string ())),
+  // Token constructor from token id, location, and a string.
+  Token (PrivateTag, TokenId token_id, Location location,
+	 const std::string &paramStr)
+    : token_id (token_id), locus (location), str (Symbol::intern (paramStr)),
       type_hint (CORETYPE_UNKNOWN)
   {}
 
   // Token constructor from token id, location, a string, and type hint.
-  Token (TokenId token_id, Location location, std::string &&paramStr,
-	 PrimitiveCoreType parType)
-    : token_id (token_id), locus (location),
-      str (new std::string (std::move (paramStr))), type_hint (parType)
+  Token (PrivateTag, TokenId token_id, Location location,
+	 const std::string &paramStr, PrimitiveCoreType parType)
+    : token_id (token_id), locus (location), str (Symbol::intern (paramStr)),
+      type_hint (parType)
   {}
 
-public:
   // No default constructor.
   Token () = delete;
   // Do not copy/assign tokens.
@@ -296,88 +299,72 @@ public:
 
   ~Token () = default;
 
-  /* TODO: make_shared (which saves a heap allocation) does not work with the
-   * private constructor */
-
   // Makes and returns a new TokenPtr (with null string).
   static TokenPtr make (TokenId token_id, Location locus)
   {
-    // return std::make_shared<Token> (token_id, locus);
-    return TokenPtr (new Token (token_id, locus));
+    return allocate (token_id, locus);
   }
 
   // Makes and returns a new TokenPtr of type IDENTIFIER.
   static TokenPtr make_identifier (Location locus, std::string &&str)
   {
-    // return std::make_shared<Token> (IDENTIFIER, locus, str);
-    return TokenPtr (new Token (IDENTIFIER, locus, std::move (str)));
+    return allocate (IDENTIFIER, locus, str);
   }
 
   // Makes and returns a new TokenPtr of type INT_LITERAL.
   static TokenPtr make_int (Location locus, std::string &&str,
 			    PrimitiveCoreType type_hint = CORETYPE_UNKNOWN)
   {
-    // return std::make_shared<Token> (INT_LITERAL, locus, str, type_hint);
-    return TokenPtr (
-      new Token (INT_LITERAL, locus, std::move (str), type_hint));
+    return allocate (INT_LITERAL, locus, str, type_hint);
   }
 
   // Makes and returns a new TokenPtr of type FLOAT_LITERAL.
   static TokenPtr make_float (Location locus, std::string &&str,
 			      PrimitiveCoreType type_hint = CORETYPE_UNKNOWN)
   {
-    // return std::make_shared<Token> (FLOAT_LITERAL, locus, str, type_hint);
-    return TokenPtr (
-      new Token (FLOAT_LITERAL, locus, std::move (str), type_hint));
+    return allocate (FLOAT_LITERAL, locus, str, type_hint);
   }
 
   // Makes and returns a new TokenPtr of type STRING_LITERAL.
   static TokenPtr make_string (Location locus, std::string &&str)
   {
-    // return std::make_shared<Token> (STRING_LITERAL, locus, str,
-    // CORETYPE_STR);
-    return TokenPtr (
-      new Token (STRING_LITERAL, locus, std::move (str), CORETYPE_STR));
+    return allocate (STRING_LITERAL, locus, str, CORETYPE_STR);
   }
 
   // Makes and returns a new TokenPtr of type CHAR_LITERAL.
   static TokenPtr make_char (Location locus, Codepoint char_lit)
   {
-    // return std::make_shared<Token> (CHAR_LITERAL, locus, char_lit);
-    return TokenPtr (new Token (CHAR_LITERAL, locus, char_lit));
+    return allocate (CHAR_LITERAL, locus, char_lit.as_string ());
   }
 
   // Makes and returns a new TokenPtr of type BYTE_CHAR_LITERAL.
   static TokenPtr make_byte_char (Location locus, char byte_char)
   {
-    // return std::make_shared<Token> (BYTE_CHAR_LITERAL, locus, byte_char);
-    return TokenPtr (new Token (BYTE_CHAR_LITERAL, locus, byte_char));
+    return allocate (BYTE_CHAR_LITERAL, locus, std::string (1, byte_char));
   }
 
   // Makes and returns a new TokenPtr of type BYTE_STRING_LITERAL (fix).
   static TokenPtr make_byte_string (Location locus, std::string &&str)
   {
-    // return std::make_shared<Token> (BYTE_STRING_LITERAL, locus, str);
-    return TokenPtr (new Token (BYTE_STRING_LITERAL, locus, std::move (str)));
+    return allocate (BYTE_STRING_LITERAL, locus, str);
   }
 
   // Makes and returns a new TokenPtr of type INNER_DOC_COMMENT.
   static TokenPtr make_inner_doc_comment (Location locus, std::string &&str)
   {
-    return TokenPtr (new Token (INNER_DOC_COMMENT, locus, std::move (str)));
+    return allocate (INNER_DOC_COMMENT, locus, str);
   }
 
   // Makes and returns a new TokenPtr of type OUTER_DOC_COMMENT.
   static TokenPtr make_outer_doc_comment (Location locus, std::string &&str)
   {
-    return TokenPtr (new Token (OUTER_DOC_COMMENT, locus, std::move (str)));
+    return allocate (OUTER_DOC_COMMENT, locus, str);
   }
 
   // Makes and returns a new TokenPtr of type LIFETIME.
   static TokenPtr make_lifetime (Location locus, std::string &&str)
   {
-    // return std::make_shared<Token> (LIFETIME, locus, str);
-    return TokenPtr (new Token (LIFETIME, locus, std::move (str)));
+    return allocate (LIFETIME, locus, str);
   }
 
   // Gets id of the token.
@@ -398,6 +385,9 @@ returning empty string instead.", get_token_description()); return "";
 return *str;
 }*/
 
+  // Gets the interned string of the token.
+  Symbol get_symbol () const { return str; }
+
   // Gets token's type hint info.
   PrimitiveCoreType get_type_hint () const
   {
@@ -439,7 +429,7 @@ return *str;
 
   /* Returns whether the token actually has a string (regardless of whether it
    * should or not). */
-  bool has_str () const { return str != nullptr; }
+  bool has_str () const { return !str.is_null (); }
 
   // Returns whether the token should have a string.
   bool should_have_str () const
@@ -21,10 +21,13 @@
 #include "rust-hir-full.h"
 #include "rust-hir-map.h"
 #include "rust-ast-dump.h"
+#include "rust-name-resolver.h"
 #include "rust-abi.h"
 #include "rust-object-export.h"
+#include "rust-metadata-compress.h"
 
 #include "md5.h"
+#include "selftest.h"
 
 namespace Rust {
 namespace Metadata {
@@ -59,11 +62,127 @@ ExportContext::emit_trait (const HIR::Trait &trait)
     = mappings->lookup_ast_item (trait.get_mappings ().get_nodeid (), &item);
   rust_assert (ok);
 
-  std::stringstream oss;
-  AST::Dump dumper (oss);
+  buffer.str ("");
+  buffer.clear ();
+  AST::Dump dumper (buffer);
   dumper.go (*item);
 
-  public_interface_buffer += oss.str ();
+  items.push_back (
+    {MetadataItemKind::TRAIT, trait.get_name (), buffer.str ()});
+}
+
+// Whether FN is marked #[inline], in which case dependents get its whole body
+// so that calls to it can be inlined across the crate boundary.
+static bool
+is_exported_for_inlining (const HIR::Function &fn)
+{
+  const AST::Attribute *attr
+    = fn.get_builtin_attrs ().get (fn.get_outer_attrs (),
+				   Analysis::BuiltinAttrKind::INLINE);
+  if (attr == nullptr)
+    return false;
+
+  // #[inline(never)] gains nothing from having its body around
+  return !attr->has_attr_input ()
+	 || attr->get_attr_input ().as_string ().find ("never")
+	      == std::string::npos;
+}
+
+// Dumps an inline function while checking that a dependent crate can make
+// sense of the body: every path has to resolve to a binding of the function
+// itself, a builtin type or another item of the interface.  Anything else,
+// such as a private helper, is not there when the dependent crate parses the
+// body back.
+class InlineFunctionDump : public AST::Dump
+{
+public:
+  InlineFunctionDump (std::ostream &stream,
+		      const std::set<NodeId> &exported_items)
+    : AST::Dump (stream), resolver (Resolver::Resolver::get ()),
+      exported_items (exported_items), self_contained (true)
+  {}
+
+  bool is_self_contained () const { return self_contained; }
+
+protected:
+  using AST::Dump::visit;
+
+  void visit (AST::IdentifierPattern &pattern) override
+  {
+    locals.insert (pattern.get_node_id ());
+    AST::Dump::visit (pattern);
+  }
+
+  void visit (AST::IdentifierExpr &expr) override
+  {
+    check_resolved (expr.get_node_id ());
+    AST::Dump::visit (expr);
+  }
+
+  void visit (AST::PathInExpression &path) override
+  {
+    for (auto &segment : path.get_segments ())
+      {
+	// the types of generic arguments are not visited on their own
+	if (segment.has_generic_args ())
+	  self_contained = false;
+	check_resolved (segment.get_node_id ());
+      }
+    AST::Dump::visit (path);
+  }
+
+  void visit (AST::TypePath &path) override
+  {
+    for (auto &segment : path.get_segments ())
+      {
+	if (segment->get_type () != AST::TypePathSegment::SegmentType::REG)
+	  self_contained = false;
+	check_resolved (segment->get_node_id ());
+      }
+    AST::Dump::visit (path);
+  }
+
+  void visit (AST::QualifiedPathInExpression &path) override
+  {
+    self_contained = false;
+    AST::Dump::visit (path);
+  }
+
+private:
+  void check_resolved (NodeId ref)
+  {
+    NodeId def = UNKNOWN_NODEID;
+    if (!resolver->lookup_resolved_name (ref, &def)
+	&& !resolver->lookup_resolved_type (ref, &def))
+      {
+	// resolved later by the type checker, e.g. an associated function
+	self_contained = false;
+	return;
+      }
+
+    if (locals.find (def) != locals.end ()
+	|| exported_items.find (def) != exported_items.end ())
+      return;
+
+    for (auto &builtin : resolver->get_builtin_types ())
+      {
+	if (builtin->get_node_id () == def)
+	  return;
+      }
+
+    self_contained = false;
+  }
+
+  Resolver::Resolver *resolver;
+  const std::set<NodeId> &exported_items;
+  std::set<NodeId> locals;
+  bool self_contained;
+};
+
+void
+ExportContext::add_exported_item (const HIR::VisItem &item)
+{
+  exported_items.insert (item.get_mappings ().get_nodeid ());
 }
 
 void
@@ -81,73 +200,58 @@ ExportContext::emit_function (const HIR::Function &fn)
   // FIXME add assertion that item must be a vis_item;
   AST::VisItem &vis_item = static_cast<AST::VisItem &> (*item);
 
-  // if its a generic function we need to output the full declaration
-  // otherwise we can let people link against this
-
-  std::stringstream oss;
-  AST::Dump dumper (oss);
-  if (!fn.has_generics ())
+  // if its a generic function we need to output the full declaration, the
+  // same goes for an inline function so that it can be inlined, as long as
+  // dependents can resolve everything its body refers to; otherwise we can
+  // let people link against this
+  buffer.str ("");
+  buffer.clear ();
+  bool has_body = false;
+  if (fn.has_generics ())
     {
-      // FIXME assert that this is actually an AST::Function
-      AST::Function &function = static_cast<AST::Function &> (vis_item);
-
-      // we can emit an extern block with abi of "rust"
-      Identifier item_name = function.get_function_name ();
-
-      // always empty for extern linkage
-      AST::WhereClause where_clause = AST::WhereClause::create_empty ();
-      std::vector<std::unique_ptr<AST::GenericParam>> generic_params;
-
-      AST::Visibility vis = function.get_visibility ();
-      std::unique_ptr<AST::Type> return_type
-	= std::unique_ptr<AST::Type> (nullptr);
-      if (function.has_return_type ())
-	{
-	  return_type = function.get_return_type ()->clone_type ();
-	}
-
-      std::vector<AST::NamedFunctionParam> function_params;
-      for (AST::FunctionParam &param : function.get_function_params ())
+      AST::Dump dumper (buffer);
+      dumper.go (*item);
+      has_body = true;
+    }
+  else if (is_exported_for_inlining (fn))
+    {
+      InlineFunctionDump dumper (buffer, exported_items);
+      dumper.go (*item);
+      has_body = dumper.is_complete () && dumper.is_self_contained ();
+      if (!has_body)
 	{
-	  std::string name = param.get_pattern ()->as_string ();
-	  std::unique_ptr<AST::Type> param_type
-	    = param.get_type ()->clone_type ();
-
-	  AST::NamedFunctionParam p (name, std::move (param_type), {},
-				     param.get_locus ());
-	  function_params.push_back (std::move (p));
+	  buffer.str ("");
+	  buffer.clear ();
 	}
-
-      AST::ExternalItem *external_item = new AST::ExternalFunctionItem (
-	item_name, {} /* generic_params */, std::move (return_type),
-	where_clause, std::move (function_params), false /* has_variadics */,
-	{} /* variadic_outer_attrs */, vis, function.get_outer_attrs (),
-	function.get_locus ());
-
-      std::vector<std::unique_ptr<AST::ExternalItem>> external_items;
-      external_items.push_back (
-	std::unique_ptr<AST::ExternalItem> (external_item));
-
-      AST::ExternBlock extern_block (get_string_from_abi (Rust::ABI::RUST),
-				     std::move (external_items),
-				     vis_item.get_visibility (), {}, {},
-				     fn.get_locus ());
-
-      dumper.go (extern_block);
     }
-  else
+
+  if (!has_body)
     {
-      dumper.go (*item);
+      // FIXME assert that this is actually an AST::Function
+      AST::Function &function = static_cast<AST::Function &> (vis_item);
+
+      // we can emit an extern block with abi of "rust", straight from the
+      // function's own signature
+      AST::Dump dumper (buffer);
+      dumper.go_extern_signature (function,
+				  get_string_from_abi (Rust::ABI::RUST));
     }
 
   // store the dump
-  public_interface_buffer += oss.str ();
+  items.push_back (
+    {MetadataItemKind::FUNCTION, fn.get_function_name (), buffer.str ()});
+}
+
+const std::vector<MetadataItem> &
+ExportContext::get_items () const
+{
+  return items;
 }
 
-const std::string &
-ExportContext::get_interface_buffer () const
+std::vector<MetadataItem>
+ExportContext::take_items ()
 {
-  return public_interface_buffer;
+  return std::move (items);
 }
 
 // implicitly by using HIR nodes we know that these have passed CFG expansion
@@ -181,29 +285,28 @@ private:
   ExportContext &ctx;
 };
 
-PublicInterface::PublicInterface (HIR::Crate &crate)
-  : crate (crate), mappings (*Analysis::Mappings::get ()), context ()
+PublicInterface::PublicInterface (const std::vector<MetadataItem> &items)
+  : items (items), mappings (*Analysis::Mappings::get ())
 {}
 
-void
-PublicInterface::Export (HIR::Crate &crate)
+std::vector<MetadataItem>
+PublicInterface::Gather (HIR::Crate &crate)
 {
-  PublicInterface interface (crate);
-  interface.gather_export_data ();
-  interface.write_to_object_file ();
-}
+  ExportContext context;
+  for (auto &item : crate.items)
+    {
+      bool is_vis_item = item->get_hir_kind () == HIR::Node::BaseKind::VIS_ITEM;
+      if (!is_vis_item)
+	continue;
 
-void
-PublicInterface::ExportTo (HIR::Crate &crate, const std::string &output_path)
-{
-  PublicInterface interface (crate);
-  interface.gather_export_data ();
-  interface.write_to_path (output_path);
-}
+      HIR::VisItem &vis_item = static_cast<HIR::VisItem &> (*item.get ());
+      HIR::Item::ItemKind kind = vis_item.get_item_kind ();
+      bool is_exported = kind == HIR::Item::ItemKind::Function
+			 || kind == HIR::Item::ItemKind::Trait;
+      if (is_exported && is_crate_public (vis_item))
+	context.add_exported_item (vis_item);
+    }
 
-void
-PublicInterface::gather_export_data ()
-{
   ExportVisItems visitor (context);
   for (auto &item : crate.items)
     {
@@ -215,36 +318,121 @@ PublicInterface::gather_export_data ()
       if (is_crate_public (vis_item))
 	vis_item.accept_vis (visitor);
     }
+
+  return context.take_items ();
 }
 
 void
-PublicInterface::write_to_object_file () const
+PublicInterface::Export (const std::vector<MetadataItem> &items)
 {
-  // done
-  const auto &buf = context.get_interface_buffer ();
-  std::string size_buffer = std::to_string (buf.size ());
+  PublicInterface interface (items);
+  interface.write_to_object_file ();
+}
+
+void
+PublicInterface::ExportTo (const std::vector<MetadataItem> &items,
+			   const std::string &output_path)
+{
+  PublicInterface interface (items);
+  interface.write_to_path (output_path);
+}
+
+static void
+encode_u32 (std::string &buf, uint32_t value)
+{
+  for (int i = 0; i < 4; i++)
+    buf += static_cast<char> ((value >> (i * 8)) & 0xff);
+}
+
+static void
+encode_str (std::string &buf, const std::string &str)
+{
+  encode_u32 (buf, str.size ());
+  buf += str;
+}
+
+static void
+encode_item (std::string &buf, const MetadataItem &item)
+{
+  buf += static_cast<char> (item.kind);
+  encode_str (buf, item.name);
+  encode_str (buf, item.body);
+}
+
+std::string
+PublicInterface::InterfaceHash (const std::vector<MetadataItem> &items)
+{
+  // moving items around in the source must not change the hash
+  std::vector<std::string> encoded;
+  encoded.reserve (items.size ());
+  for (const auto &item : items)
+    {
+      std::string buf;
+      encode_item (buf, item);
+      encoded.push_back (std::move (buf));
+    }
+  std::sort (encoded.begin (), encoded.end ());
+
+  struct md5_ctx ctx;
+  unsigned char hash[16];
+
+  std::string crate_name;
+  auto mappings = Analysis::Mappings::get ();
+  encode_str (crate_name, mappings->get_current_crate_name ());
+
+  md5_init_ctx (&ctx);
+  md5_process_bytes (crate_name.data (), crate_name.size (), &ctx);
+  for (const auto &buf : encoded)
+    md5_process_bytes (buf.data (), buf.size (), &ctx);
+  md5_finish_ctx (&ctx, hash);
+
+  return std::string ((const char *) hash, sizeof (hash));
+}
+
+std::string
+PublicInterface::encode () const
+{
+  // everything covered by the checksum
+  std::string payload;
+  encode_str (payload, mappings.get_current_crate_name ());
+  payload += InterfaceHash (items);
+  encode_u32 (payload, items.size ());
+  for (const auto &item : items)
+    encode_item (payload, item);
 
-  // md5 this
   struct md5_ctx chksm;
   unsigned char checksum[16];
 
   md5_init_ctx (&chksm);
-  md5_process_bytes (buf.c_str (), buf.size (), &chksm);
+  md5_process_bytes (payload.data (), payload.size (), &chksm);
   md5_finish_ctx (&chksm, checksum);
 
-  // MAGIC MD5 DLIM  DLIM buffer-size DELIM contents
-  const std::string current_crate_name = mappings.get_current_crate_name ();
-
-  // extern void
-  rust_write_export_data (kMagicHeader, sizeof (kMagicHeader));
-  rust_write_export_data ((const char *) checksum, sizeof (checksum));
-  rust_write_export_data (kSzDelim, sizeof (kSzDelim));
-  rust_write_export_data (current_crate_name.c_str (),
-			  current_crate_name.size ());
-  rust_write_export_data (kSzDelim, sizeof (kSzDelim));
-  rust_write_export_data (size_buffer.c_str (), size_buffer.size ());
-  rust_write_export_data (kSzDelim, sizeof (kSzDelim));
-  rust_write_export_data (buf.c_str (), buf.size ());
+  std::string body;
+  body.reserve (sizeof (checksum) + payload.size ());
+  body.append ((const char *) checksum, sizeof (checksum));
+  body += payload;
+
+  MetadataCompression compression = flag_rust_compress_metadata
+				      ? metadata_compression_method ()
+				      : MetadataCompression::NONE;
+
+  std::string buf;
+  buf.append (kMagicHeader, sizeof (kMagicHeader));
+  encode_u32 (buf, kMetadataVersion);
+  buf += static_cast<char> (compression);
+  if (compression == MetadataCompression::NONE)
+    buf += body;
+  else
+    encode_str (buf, compress_metadata (body));
+
+  return buf;
+}
+
+void
+PublicInterface::write_to_object_file () const
+{
+  const std::string buf = encode ();
+  rust_write_export_data (buf.data (), buf.size ());
 }
 
 void
@@ -262,20 +450,7 @@ PublicInterface::write_to_path (const std::string &path) const
       return;
     }
 
-  // done
-  const auto &buf = context.get_interface_buffer ();
-  std::string size_buffer = std::to_string (buf.size ());
-
-  // md5 this
-  struct md5_ctx chksm;
-  unsigned char checksum[16];
-
-  md5_init_ctx (&chksm);
-  md5_process_bytes (buf.c_str (), buf.size (), &chksm);
-  md5_finish_ctx (&chksm, checksum);
-
-  // MAGIC MD5 DLIM  DLIM buffer-size DELIM contents
-  const std::string current_crate_name = mappings.get_current_crate_name ();
+  const std::string buf = encode ();
 
   // write to path
   FILE *nfd = fopen (path.c_str (), "wb");
@@ -286,16 +461,7 @@ PublicInterface::write_to_path (const std::string &path) const
       return;
     }
 
-  // write data
-  if (fwrite (kMagicHeader, sizeof (kMagicHeader), 1, nfd) < 1)
-    {
-      rust_error_at (Location (), "failed to write to file %<%s%>: %s",
-		     path.c_str (), xstrerror (errno));
-      fclose (nfd);
-      return;
-    }
-
-  if (fwrite (checksum, sizeof (checksum), 1, nfd) < 1)
+  if (fwrite (buf.data (), buf.size (), 1, nfd) < 1)
     {
       rust_error_at (Location (), "failed to write to file %<%s%>: %s",
 		     path.c_str (), xstrerror (errno));
@@ -303,56 +469,6 @@ PublicInterface::write_to_path (const std::string &path) const
       return;
     }
 
-  if (fwrite (kSzDelim, sizeof (kSzDelim), 1, nfd) < 1)
-    {
-      rust_error_at (Location (), "failed to write to file %<%s%>: %s",
-		     path.c_str (), xstrerror (errno));
-      fclose (nfd);
-      return;
-    }
-
-  if (fwrite (current_crate_name.c_str (), current_crate_name.size (), 1, nfd)
-      < 1)
-    {
-      rust_error_at (Location (), "failed to write to file %<%s%>: %s",
-		     path.c_str (), xstrerror (errno));
-      fclose (nfd);
-      return;
-    }
-
-  if (fwrite (kSzDelim, sizeof (kSzDelim), 1, nfd) < 1)
-    {
-      rust_error_at (Location (), "failed to write to file %<%s%>: %s",
-		     path.c_str (), xstrerror (errno));
-      fclose (nfd);
-      return;
-    }
-
-  if (fwrite (size_buffer.c_str (), size_buffer.size (), 1, nfd) < 1)
-    {
-      rust_error_at (Location (), "failed to write to file %<%s%>: %s",
-		     path.c_str (), xstrerror (errno));
-      fclose (nfd);
-      return;
-    }
-
-  if (fwrite (kSzDelim, sizeof (kSzDelim), 1, nfd) < 1)
-    {
-      rust_error_at (Location (), "failed to write to file %<%s%>: %s",
-		     path.c_str (), xstrerror (errno));
-      fclose (nfd);
-      return;
-    }
-
-  if (!buf.empty ())
-    if (fwrite (buf.c_str (), buf.size (), 1, nfd) < 1)
-      {
-	rust_error_at (Location (), "failed to write to file %<%s%>: %s",
-		       path.c_str (), xstrerror (errno));
-	fclose (nfd);
-	return;
-      }
-
   // done
   fclose (nfd);
 }
@@ -383,3 +499,52 @@ PublicInterface::expected_metadata_filename ()
 
 } // namespace Metadata
 } // namespace Rust
+
+#if CHECKING_P
+
+#include "rust-lex.h"
+#include "rust-parse.h"
+
+namespace selftest {
+
+// The signature of a non-generic function is exported as an extern block,
+// which the importing crate has to be able to parse back
+static void
+rust_export_extern_signature_roundtrip (void)
+{
+  Rust::Lexer lex ("fn f (_: i32, x: i32) -> i32 { x }");
+  Rust::Parser<Rust::Lexer> parser (lex);
+  std::unique_ptr<Rust::AST::Item> item = parser.parse_item (false);
+  ASSERT_TRUE (item != nullptr);
+  ASSERT_TRUE (parser.get_errors ().empty ());
+
+  std::stringstream exported;
+  Rust::AST::Dump dumper (exported);
+  dumper.go_extern_signature (static_cast<Rust::AST::Function &> (*item),
+			      Rust::get_string_from_abi (Rust::ABI::RUST));
+
+  Rust::Lexer relex (exported.str ());
+  Rust::Parser<Rust::Lexer> reparser (relex);
+  std::unique_ptr<Rust::AST::Crate> crate = reparser.parse_crate ();
+  ASSERT_TRUE (reparser.get_errors ().empty ());
+  ASSERT_EQ (crate->items.size (), 1);
+
+  auto &block = static_cast<Rust::AST::ExternBlock &> (*crate->items[0]);
+  ASSERT_EQ (block.get_extern_items ().size (), 1);
+
+  auto &fn = static_cast<Rust::AST::ExternalFunctionItem &> (
+    *block.get_extern_items ()[0]);
+  ASSERT_EQ (fn.get_function_params ().size (), 2);
+  ASSERT_FALSE (fn.get_function_params ()[0].has_name ());
+  ASSERT_EQ (fn.get_function_params ()[1].get_name (), "x");
+}
+
+void
+rust_export_metadata_test (void)
+{
+  rust_export_extern_signature_roundtrip ();
+}
+
+} // namespace selftest
+
+#endif // CHECKING_P
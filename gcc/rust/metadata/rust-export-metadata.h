@@ -29,6 +29,41 @@ namespace Metadata {
 static const char kMagicHeader[4] = {'G', 'R', 'S', 'T'};
 static const char kSzDelim[1] = {'$'};
 
+// Version of the binary metadata layout following the magic header. Bump this
+// whenever the encoding changes so stale .rox files are rejected on import
+// instead of being misread.
+static const uint32_t kMetadataVersion = 4;
+
+// The metadata is laid out as:
+//
+//   MAGIC VERSION:u32 COMPRESSION:u8 BODY
+//   BODY = MD5[16] CRATE-NAME:str INTERFACE-HASH[16] ITEM-COUNT:u32 ITEM*
+//
+// with BODY stored as a str holding it compressed when COMPRESSION, a
+// MetadataCompression, is not NONE.
+//
+// where each ITEM is KIND:u8 NAME:str BODY:str, every str is a u32 length
+// followed by that many bytes, and all integers are little-endian. The MD5
+// covers everything after itself. Framing each item lets an importer index
+// the public interface by name without touching the bodies. A
+// GENERIC_INSTANCE item has no body, its name is the symbol of an instance
+// the crate defines for its dependents. The INTERFACE-HASH is an MD5 of the
+// items that does not depend on their order, see
+// PublicInterface::InterfaceHash.
+enum class MetadataItemKind : uint8_t
+{
+  FUNCTION = 0,
+  TRAIT = 1,
+  GENERIC_INSTANCE = 2,
+};
+
+struct MetadataItem
+{
+  MetadataItemKind kind;
+  std::string name;
+  std::string body;
+};
+
 class ExportContext
 {
 public:
@@ -44,42 +79,71 @@ public:
 
   void emit_function (const HIR::Function &fn);
 
-  const std::string &get_interface_buffer () const;
+  // ITEM is in the interface, so exported bodies may refer to it
+  void add_exported_item (const HIR::VisItem &item);
+
+  const std::vector<MetadataItem> &get_items () const;
+
+  std::vector<MetadataItem> take_items ();
 
 private:
   Analysis::Mappings *mappings;
 
   std::vector<std::reference_wrapper<const HIR::Module>> module_stack;
-  std::string public_interface_buffer;
+  std::vector<MetadataItem> items;
+  std::set<NodeId> exported_items;
+
+  // shared by every emitted item instead of a new stream per item
+  std::stringstream buffer;
 };
 
 class PublicInterface
 {
 public:
-  static void Export (HIR::Crate &crate);
+  // snapshot the exported items; this needs the AST of the crate, so it must
+  // run before the AST is released after lowering
+  static std::vector<MetadataItem> Gather (HIR::Crate &crate);
+
+  static void Export (const std::vector<MetadataItem> &items);
+
+  static void ExportTo (const std::vector<MetadataItem> &items,
+			const std::string &output_path);
 
-  static void ExportTo (HIR::Crate &crate, const std::string &output_path);
+  /* A stable hash of what dependents see of the crate: its name and the
+   * exported items, which have bodies only for generic and inline functions.
+   * It only changes when the interface does, so a build system can skip
+   * rebuilding dependents when it stays the same. Returns the 16 raw bytes of
+   * the hash. */
+  static std::string InterfaceHash (const std::vector<MetadataItem> &items);
 
   static bool is_crate_public (const HIR::VisItem &item);
 
   static std::string expected_metadata_filename ();
 
 protected:
-  void gather_export_data ();
+  std::string encode () const;
 
   void write_to_object_file () const;
 
   void write_to_path (const std::string &path) const;
 
 private:
-  PublicInterface (HIR::Crate &crate);
+  PublicInterface (const std::vector<MetadataItem> &items);
 
-  HIR::Crate &crate;
+  const std::vector<MetadataItem> &items;
   Analysis::Mappings &mappings;
-  ExportContext context;
 };
 
 } // namespace Metadata
 } // namespace Rust
 
+#if CHECKING_P
+
+namespace selftest {
+extern void
+rust_export_metadata_test (void);
+} // namespace selftest
+
+#endif // CHECKING_P
+
 #endif // RUST_EXPORT_METADATA_H
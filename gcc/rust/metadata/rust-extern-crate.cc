@@ -19,6 +19,7 @@
 #include "rust-extern-crate.h"
 #include "rust-diagnostics.h"
 #include "rust-export-metadata.h"
+#include "rust-metadata-compress.h"
 
 #include "md5.h"
 
@@ -32,11 +33,66 @@ ExternCrate::~ExternCrate () {}
 bool
 ExternCrate::ok () const
 {
-  return !import_stream.saw_error ();
+  return !import_stream.saw_error ()
+	 && (decompressed == nullptr || !decompressed->saw_error ());
+}
+
+// Read LENGTH raw bytes into OUT, folding them into the running checksum.
+static bool
+read_bytes (Import::Stream &stream, Location locus, size_t length,
+	    struct md5_ctx *chksm, std::string *out)
+{
+  const char *bytes = "";
+  if (length > 0 && !stream.peek (length, &bytes))
+    {
+      stream.set_saw_error ();
+      rust_error_at (locus, "unexpected end of crate metadata");
+      return false;
+    }
+
+  out->assign (bytes, length);
+  stream.advance (length);
+  if (chksm != nullptr)
+    md5_process_bytes (out->data (), length, chksm);
+
+  return true;
+}
+
+static bool
+read_u32 (Import::Stream &stream, Location locus, struct md5_ctx *chksm,
+	  uint32_t *value)
+{
+  std::string buf;
+  if (!read_bytes (stream, locus, 4, chksm, &buf))
+    return false;
+
+  *value = 0;
+  for (int i = 0; i < 4; i++)
+    *value |= static_cast<uint32_t> (static_cast<unsigned char> (buf[i]))
+	      << (i * 8);
+
+  return true;
+}
+
+static bool
+read_str (Import::Stream &stream, Location locus, struct md5_ctx *chksm,
+	  std::string *out)
+{
+  uint32_t length = 0;
+  if (!read_u32 (stream, locus, chksm, &length))
+    return false;
+
+  return read_bytes (stream, locus, length, chksm, out);
 }
 
 bool
 ExternCrate::load (Location locus)
+{
+  return read (locus) && decode (locus);
+}
+
+bool
+ExternCrate::read (Location locus)
 {
   // match header
   import_stream.require_bytes (locus, Metadata::kMagicHeader,
@@ -44,98 +100,120 @@ ExternCrate::load (Location locus)
   if (import_stream.saw_error ())
     return false;
 
-  // parse 16 bytes md5
-  unsigned char checksum[16];
-  bool ok
-    = import_stream.do_peek (sizeof (checksum), (const char **) &checksum);
-  if (!ok)
+  uint32_t version = 0;
+  if (!read_u32 (import_stream, locus, nullptr, &version))
     return false;
 
-  import_stream.advance (sizeof (checksum));
+  if (version != Metadata::kMetadataVersion)
+    {
+      import_stream.set_saw_error ();
+      rust_error_at (locus,
+		     "crate metadata has version %u but version %u is "
+		     "expected; recompile the crate",
+		     version, Metadata::kMetadataVersion);
+      return false;
+    }
 
-  // parse delim
-  import_stream.require_bytes (locus, Metadata::kSzDelim,
-			       sizeof (Metadata::kSzDelim));
-  if (import_stream.saw_error ())
+  std::string method;
+  if (!read_bytes (import_stream, locus, 1, nullptr, &method))
     return false;
 
-  // parse crate name
-  bool saw_delim = false;
-  while (!import_stream.saw_error () && !import_stream.at_eof ())
-    {
-      unsigned char byte = import_stream.get_char ();
-      saw_delim
-	= memcmp (&byte, Metadata::kSzDelim, sizeof (Metadata::kSzDelim)) == 0;
-      if (saw_delim)
-	break;
+  compression = static_cast<Metadata::MetadataCompression> (method[0]);
+  if (compression == Metadata::MetadataCompression::NONE)
+    return true;
 
-      crate_name += byte;
-    }
-  if (!saw_delim || crate_name.empty ())
+  if (!Metadata::can_decompress_metadata (compression))
     {
       import_stream.set_saw_error ();
-      rust_error_at (locus, "failed to read crate name field");
-
+      rust_error_at (locus,
+		     "crate metadata is compressed with an unsupported "
+		     "method %u",
+		     (unsigned) (unsigned char) method[0]);
       return false;
     }
 
-  // read until delim which is the size of the meta data
-  std::string metadata_length_buffer;
-  saw_delim = false;
-  while (!import_stream.saw_error () && !import_stream.at_eof ())
-    {
-      unsigned char byte = import_stream.get_char ();
-      saw_delim
-	= memcmp (&byte, Metadata::kSzDelim, sizeof (Metadata::kSzDelim)) == 0;
-      if (saw_delim)
-	break;
+  return read_str (import_stream, locus, nullptr, &compressed);
+}
 
-      metadata_length_buffer += byte;
-    }
-  if (!saw_delim || metadata_length_buffer.empty ())
+bool
+ExternCrate::decode (Location locus)
+{
+  // a compressed body is decompressed in one go and read from memory
+  Import::Stream *body = &import_stream;
+  if (compression != Metadata::MetadataCompression::NONE)
     {
-      import_stream.set_saw_error ();
-      rust_error_at (locus, "failed to read metatadata size");
+      decompressed.reset (new Stream_from_string (
+	Metadata::decompress_metadata (compression, compressed.data (),
+				       compressed.size ())));
+      std::string ().swap (compressed);
+      body = decompressed.get ();
+    }
+  Import::Stream &stream = *body;
+
+  if (!read_bytes (stream, locus, 16, nullptr, &checksum))
+    return false;
+
+  // everything from here on is covered by the checksum
+  struct md5_ctx chksm;
+  md5_init_ctx (&chksm);
 
+  if (!read_str (stream, locus, &chksm, &crate_name))
+    return false;
+
+  if (crate_name.empty ())
+    {
+      stream.set_saw_error ();
+      rust_error_at (locus, "failed to read crate name field");
       return false;
     }
 
-  // interpret the string size
-  int expected_buffer_length = -1;
-  ok = ExternCrate::string_to_int (locus, metadata_length_buffer, false,
-				   &expected_buffer_length);
-  if (!ok)
+  if (!read_bytes (stream, locus, 16, &chksm, &interface_hash))
     return false;
 
-  // read the parsed size and it should be eof
-  metadata_buffer.reserve (expected_buffer_length);
-  for (int i = 0; i < expected_buffer_length && !import_stream.saw_error ()
-		  && !import_stream.at_eof ();
-       i++)
+  uint32_t item_count = 0;
+  if (!read_u32 (stream, locus, &chksm, &item_count))
+    return false;
+
+  for (uint32_t i = 0; i < item_count; i++)
     {
-      metadata_buffer += import_stream.get_char ();
+      std::string kind;
+      if (!read_bytes (stream, locus, 1, &chksm, &kind))
+	return false;
+
+      Metadata::MetadataItem item;
+      item.kind = static_cast<Metadata::MetadataItemKind> (kind[0]);
+      switch (item.kind)
+	{
+	case Metadata::MetadataItemKind::FUNCTION:
+	case Metadata::MetadataItemKind::TRAIT:
+	case Metadata::MetadataItemKind::GENERIC_INSTANCE:
+	  break;
+
+	default:
+	  stream.set_saw_error ();
+	  rust_error_at (locus, "unknown item kind %u in crate metadata",
+			 (unsigned) (unsigned char) kind[0]);
+	  return false;
+	}
+
+      if (!read_str (stream, locus, &chksm, &item.name))
+	return false;
+      if (!read_str (stream, locus, &chksm, &item.body))
+	return false;
+
+      items.push_back (std::move (item));
     }
 
-  // compute the md5
-  struct md5_ctx chksm;
   unsigned char computed_checksum[16];
-
-  md5_init_ctx (&chksm);
-  md5_process_bytes (metadata_buffer.c_str (), metadata_buffer.size (), &chksm);
   md5_finish_ctx (&chksm, computed_checksum);
-
-  // FIXME i think the encoding and decoding of md5 is going wrong or else we
-  // are not computing it correctly
-  //
-  // compare the checksums
-  // if (memcmp(computed_checksum, checksum, sizeof (checksum)) != 0)
-  //   {
-  //     rust_error_at (locus,
-  //       	     "checksum mismatch in metadata: %<%.*s%> vs %<%.*s%>",
-  //       	     sizeof (computed_checksum), computed_checksum,
-  //       	     sizeof (checksum), checksum);
-  //     return false;
-  //   }
+  if (memcmp (computed_checksum, checksum.data (), sizeof (computed_checksum))
+      != 0)
+    {
+      stream.set_saw_error ();
+      rust_error_at (locus, "checksum mismatch in metadata for crate %<%s%>",
+		     crate_name.c_str ());
+      return false;
+    }
 
   // all good
   return true;
@@ -147,10 +225,28 @@ ExternCrate::get_crate_name () const
   return crate_name;
 }
 
+const std::vector<Metadata::MetadataItem> &
+ExternCrate::get_items () const
+{
+  return items;
+}
+
 const std::string &
-ExternCrate::get_metadata () const
+ExternCrate::get_checksum () const
+{
+  return checksum;
+}
+
+const std::string &
+ExternCrate::get_interface_hash () const
+{
+  return interface_hash;
+}
+
+std::vector<Metadata::MetadataItem>
+ExternCrate::take_items ()
 {
-  return metadata_buffer;
+  return std::move (items);
 }
 
 // Turn a string into a integer with appropriate error handling.
@@ -21,6 +21,8 @@
 
 #include "rust-system.h"
 #include "rust-imports.h"
+#include "rust-export-metadata.h"
+#include "rust-metadata-compress.h"
 
 namespace Rust {
 namespace Imports {
@@ -33,20 +35,45 @@ public:
 
   bool ok () const;
 
+  // read () then decode ()
   bool load (Location locus);
 
+  /* Check the header of the metadata and read its body, still compressed.
+   * This only reads from the stream and does not touch any state shared with
+   * the rest of the compiler, so it may run on any thread. */
+  bool read (Location locus);
+
+  // Decompress the body, if needed, and decode the items from it
+  bool decode (Location locus);
+
   const std::string &get_crate_name () const;
 
-  const std::string &get_metadata () const;
+  const std::vector<Metadata::MetadataItem> &get_items () const;
+
+  std::vector<Metadata::MetadataItem> take_items ();
+
+  // the raw md5 of the metadata, used to key caches of its decoded state
+  const std::string &get_checksum () const;
+
+  // the stable hash of the crate's public interface
+  const std::string &get_interface_hash () const;
 
   static bool string_to_int (Location locus, const std::string &s,
 			     bool is_neg_ok, int *ret);
 
 private:
   Import::Stream &import_stream;
+  // how the body is compressed and, between read and decode, its bytes
+  Metadata::MetadataCompression compression
+    = Metadata::MetadataCompression::NONE;
+  std::string compressed;
+  // the body of compressed metadata, once decompressed
+  std::unique_ptr<Import::Stream> decompressed;
 
   std::string crate_name;
-  std::string metadata_buffer;
+  std::string checksum;
+  std::string interface_hash;
+  std::vector<Metadata::MetadataItem> items;
 };
 
 } // namespace Imports
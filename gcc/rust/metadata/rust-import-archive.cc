@@ -7,6 +7,7 @@
 #include "rust-system.h"
 #include "rust-diagnostics.h"
 #include "rust-imports.h"
+#include "rust-session-manager.h"
 
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -831,6 +832,89 @@ Stream_concatenate::do_advance (size_t skip)
     }
 }
 
+// With -frust-metadata-cache, the offsets of the archive members which
+// contain export data are kept in the cache, stamped with the size and
+// modification time of the archive.  Importing from the same archive again
+// then reads those members directly instead of every header and object of
+// the archive.
+
+static const char archive_index_header[] = "gccrs-archive-index";
+
+static std::string
+archive_index_path (const std::string &filename)
+{
+  char hash[9];
+  snprintf (hash, sizeof hash, "%08x",
+	    static_cast<unsigned> (htab_hash_string (filename.c_str ())));
+  return Session::get_instance ().options.get_metadata_cache_dir () + "/"
+	 + lbasename (filename.c_str ()) + "-" + hash + ".index";
+}
+
+// Read the index of FILENAME, open as FD, into *MEMBERS.  Return false if
+// there is none or it does not describe the archive as it is now.
+
+static bool
+read_archive_index (const std::string &filename, int fd,
+		    std::vector<off_t> *members)
+{
+  if (!Session::get_instance ().options.metadata_cache_dir_set ())
+    return false;
+
+  struct stat st;
+  if (fstat (fd, &st) < 0)
+    return false;
+
+  std::ifstream in (archive_index_path (filename));
+  if (in.fail ())
+    return false;
+
+  std::string header;
+  long long size = 0, mtime = 0;
+  size_t count = 0;
+  in >> header >> size >> mtime >> count;
+  if (in.fail () || header.compare (archive_index_header) != 0
+      || size != static_cast<long long> (st.st_size)
+      || mtime != static_cast<long long> (st.st_mtime) || count == 0)
+    return false;
+
+  members->resize (count);
+  for (off_t &off : *members)
+    {
+      long long member_off = 0;
+      in >> member_off;
+      off = member_off;
+    }
+  return !in.fail ();
+}
+
+static void
+write_archive_index (const std::string &filename, int fd,
+		     const std::vector<off_t> &members)
+{
+  struct stat st;
+  if (fstat (fd, &st) < 0)
+    return;
+
+  // write to a private file and rename it into place so that concurrent
+  // compilations never see a partial index
+  const std::string path = archive_index_path (filename);
+  const std::string tmp_path = path + "." + std::to_string (getpid ());
+
+  std::ofstream out (tmp_path);
+  if (out.fail ())
+    return;
+
+  out << archive_index_header << " " << static_cast<long long> (st.st_size)
+      << " " << static_cast<long long> (st.st_mtime) << "\n";
+  out << members.size () << "\n";
+  for (off_t off : members)
+    out << static_cast<long long> (off) << "\n";
+  out.close ();
+
+  if (out.fail () || rename (tmp_path.c_str (), path.c_str ()) != 0)
+    unlink (tmp_path.c_str ());
+}
+
 // Import data from an archive.  We walk through the archive and
 // import data from each member.
 
@@ -842,7 +926,42 @@ Import::find_archive_export_data (const std::string &filename, int fd,
   if (!afile.initialize ())
     return NULL;
 
+  std::vector<off_t> indexed;
+  if (read_archive_index (filename, fd, &indexed))
+    {
+      Stream_concatenate *ret = new Stream_concatenate;
+      bool complete = true;
+      for (off_t off : indexed)
+	{
+	  std::string name;
+	  off_t size;
+	  off_t nested_off;
+	  int member_fd;
+	  off_t member_off;
+	  std::string member_name;
+	  Import::Stream *is = NULL;
+	  if (off >= afile.first_member_offset () && off < afile.filesize ()
+	      && afile.read_header (off, &name, &size, &nested_off, NULL)
+	      && !name.empty () && name != "/"
+	      && afile.get_file_and_offset (off, name, nested_off, &member_fd,
+					    &member_off, &member_name))
+	    is = Import::find_object_export_data (member_name, member_fd,
+						  member_off, location);
+	  if (is == NULL)
+	    {
+	      complete = false;
+	      break;
+	    }
+	  ret->add (is);
+	}
+
+      if (complete)
+	return ret;
+      delete ret;
+    }
+
   Stream_concatenate *ret = new Stream_concatenate;
+  std::vector<off_t> with_data;
 
   bool any_data = false;
   bool any_members = false;
@@ -863,6 +982,7 @@ Import::find_archive_export_data (const std::string &filename, int fd,
       if (is != NULL)
 	{
 	  ret->add (is);
+	  with_data.push_back (p->off);
 	  any_data = true;
 	}
     }
@@ -879,6 +999,9 @@ Import::find_archive_export_data (const std::string &filename, int fd,
       return NULL;
     }
 
+  if (Session::get_instance ().options.metadata_cache_dir_set ())
+    write_archive_index (filename, fd, with_data);
+
   return ret;
 }
 
@@ -21,6 +21,9 @@
 #include "rust-imports.h"
 #include "rust-object-export.h"
 #include "rust-export-metadata.h"
+#include "rust-session-manager.h"
+
+#include <dirent.h>
 
 #ifndef O_BINARY
 #define O_BINARY 0
@@ -39,6 +42,58 @@ add_search_path (const std::string &path)
   search_path.push_back (path);
 }
 
+// The entries of each directory an import was looked for in.  These are
+// read once, so that trying every name a crate may be stored under at every
+// search path entry does not take an open () per name.  A directory which
+// cannot be listed is not cached, and everything in it is opened.  Extern
+// crates are located from several threads at once, so the cache is locked;
+// a listing is never changed once it has been read.
+static std::map<std::string, std::set<std::string> > directory_entries;
+static std::mutex directory_entries_mutex;
+
+static const std::set<std::string> *
+list_directory (const std::string &dir)
+{
+  std::lock_guard<std::mutex> lock (directory_entries_mutex);
+  auto it = directory_entries.find (dir);
+  if (it != directory_entries.end ())
+    return &it->second;
+
+  DIR *d = opendir (dir.empty () ? "." : dir.c_str ());
+  if (d == NULL)
+    {
+      // a search path entry which does not exist holds nothing
+      if (errno == ENOENT || errno == ENOTDIR)
+	return &directory_entries[dir];
+      return NULL;
+    }
+
+  std::set<std::string> &entries = directory_entries[dir];
+  while (struct dirent *entry = readdir (d))
+    entries.insert (entry->d_name);
+  closedir (d);
+
+  return &entries;
+}
+
+// Open PATH for reading, unless the listing of its directory says it does
+// not exist.
+
+int
+Import::open_file (const std::string &path)
+{
+  const char *basename = lbasename (path.c_str ());
+  const std::set<std::string> *entries
+    = list_directory (path.substr (0, basename - path.c_str ()));
+  if (entries != NULL && entries->find (basename) == entries->end ())
+    {
+      errno = ENOENT;
+      return -1;
+    }
+
+  return open (path.c_str (), O_RDONLY | O_BINARY);
+}
+
 // Find import data.  This searches the file system for FILENAME and
 // returns a pointer to a Stream object to read the data that it
 // exports.  If the file is not found, it returns NULL.
@@ -140,7 +195,7 @@ Import::try_package_in_directory (const std::string &filename,
 				  Location location)
 {
   std::string found_filename = filename;
-  int fd = open (found_filename.c_str (), O_RDONLY | O_BINARY);
+  int fd = Import::open_file (found_filename);
 
   if (fd >= 0)
     {
@@ -166,7 +221,10 @@ Import::try_package_in_directory (const std::string &filename,
   // The export data may not be in this file.
   Stream *s = Import::find_export_data (found_filename, fd, location);
   if (s != NULL)
-    return s;
+    {
+      Session::get_instance ().add_dependency (found_filename);
+      return s;
+    }
 
   close (fd);
 
@@ -184,7 +242,7 @@ int
 Import::try_suffixes (std::string *pfilename)
 {
   std::string filename = *pfilename + ".rox";
-  int fd = open (filename.c_str (), O_RDONLY | O_BINARY);
+  int fd = Import::open_file (filename);
   if (fd >= 0)
     {
       *pfilename = filename;
@@ -194,7 +252,7 @@ Import::try_suffixes (std::string *pfilename)
   const char *basename = lbasename (pfilename->c_str ());
   size_t basename_pos = basename - pfilename->c_str ();
   filename = pfilename->substr (0, basename_pos) + "lib" + basename + ".so";
-  fd = open (filename.c_str (), O_RDONLY | O_BINARY);
+  fd = Import::open_file (filename);
   if (fd >= 0)
     {
       *pfilename = filename;
@@ -202,7 +260,7 @@ Import::try_suffixes (std::string *pfilename)
     }
 
   filename = pfilename->substr (0, basename_pos) + "lib" + basename + ".a";
-  fd = open (filename.c_str (), O_RDONLY | O_BINARY);
+  fd = Import::open_file (filename);
   if (fd >= 0)
     {
       *pfilename = filename;
@@ -210,7 +268,7 @@ Import::try_suffixes (std::string *pfilename)
     }
 
   filename = *pfilename + ".o";
-  fd = open (filename.c_str (), O_RDONLY | O_BINARY);
+  fd = Import::open_file (filename);
   if (fd >= 0)
     {
       *pfilename = filename;
@@ -314,7 +372,7 @@ Import::read (size_t length, std::string *out)
       *out = std::string ("");
       return;
     }
-  *out = std::string (data, length);
+  out->assign (data, length);
   this->advance (length);
 }
 
@@ -370,22 +428,57 @@ Import::Stream::require_bytes (Location location, const char *bytes,
 
 // Class Stream_from_file.
 
-Stream_from_file::Stream_from_file (int fd) : fd_ (fd), data_ ()
+// A failed read or seek is an error rather than a fatal error: the stream may
+// be read on a worker thread, which must not end the compilation itself.  The
+// stream is marked as bad, so whoever reads the metadata stops and fails.
+
+Stream_from_file::Stream_from_file (int fd)
+  : fd_ (fd), data_ (), mapped_ (NULL), mapped_size_ (0), mapped_pos_ (0)
 {
   if (lseek (fd, 0, SEEK_SET) != 0)
     {
-      rust_fatal_error (Linemap::unknown_location (), "lseek failed: %m");
+      rust_error_at (Linemap::unknown_location (), "lseek failed: %m");
       this->set_saw_error ();
     }
+
+#if HAVE_MMAP_FILE
+  // Map regular files so that the data can be peeked at in place, without a
+  // read and lseek round trip for every field.
+  struct stat st;
+  if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0)
+    {
+      void *addr = mmap (NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (addr != MAP_FAILED)
+	{
+	  this->mapped_ = static_cast<const char *> (addr);
+	  this->mapped_size_ = st.st_size;
+	}
+    }
+#endif
 }
 
-Stream_from_file::~Stream_from_file () { close (this->fd_); }
+Stream_from_file::~Stream_from_file ()
+{
+#if HAVE_MMAP_FILE
+  if (this->mapped_ != NULL)
+    munmap (const_cast<char *> (this->mapped_), this->mapped_size_);
+#endif
+  close (this->fd_);
+}
 
 // Read next bytes.
 
 bool
 Stream_from_file::do_peek (size_t length, const char **bytes)
 {
+  if (this->mapped_ != NULL)
+    {
+      if (length > this->mapped_size_ - this->mapped_pos_)
+	return false;
+      *bytes = this->mapped_ + this->mapped_pos_;
+      return true;
+    }
+
   if (this->data_.length () >= length)
     {
       *bytes = this->data_.data ();
@@ -398,7 +491,7 @@ Stream_from_file::do_peek (size_t length, const char **bytes)
   if (got < 0)
     {
       if (!this->saw_error ())
-	rust_fatal_error (Linemap::unknown_location (), "read failed: %m");
+	rust_error_at (Linemap::unknown_location (), "read failed: %m");
       this->set_saw_error ();
       return false;
     }
@@ -406,7 +499,7 @@ Stream_from_file::do_peek (size_t length, const char **bytes)
   if (lseek (this->fd_, -got, SEEK_CUR) < 0)
     {
       if (!this->saw_error ())
-	rust_fatal_error (Linemap::unknown_location (), "lseek failed: %m");
+	rust_error_at (Linemap::unknown_location (), "lseek failed: %m");
       this->set_saw_error ();
       return false;
     }
@@ -423,10 +516,18 @@ Stream_from_file::do_peek (size_t length, const char **bytes)
 void
 Stream_from_file::do_advance (size_t skip)
 {
+  if (this->mapped_ != NULL)
+    {
+      this->mapped_pos_ += skip;
+      if (this->mapped_pos_ > this->mapped_size_)
+	this->mapped_pos_ = this->mapped_size_;
+      return;
+    }
+
   if (lseek (this->fd_, skip, SEEK_CUR) < 0)
     {
       if (!this->saw_error ())
-	rust_fatal_error (Linemap::unknown_location (), "lseek failed: %m");
+	rust_error_at (Linemap::unknown_location (), "lseek failed: %m");
       this->set_saw_error ();
     }
   if (!this->data_.empty ())
@@ -153,6 +153,8 @@ public:
   void clear_stream () { this->stream_ = NULL; }
 
 private:
+  static int open_file (const std::string &path);
+
   static Stream *try_package_in_directory (const std::string &, Location);
 
   static int try_suffixes (std::string *);
@@ -250,6 +252,13 @@ private:
   int fd_;
   // Data read from the file.
   std::string data_;
+  // The whole file mapped read-only, or NULL if it could not be mapped, in
+  // which case the file is read through fd_.
+  const char *mapped_;
+  // The size of the mapping.
+  size_t mapped_size_;
+  // The current position within the mapping.
+  size_t mapped_pos_;
 };
 
 } // namespace Rust
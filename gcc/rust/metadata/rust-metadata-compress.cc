@@ -0,0 +1,99 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-metadata-compress.h"
+
+#include "backend.h"
+#include "tree.h"
+#include "gimple.h"
+#include "cgraph.h"
+#include "lto-streamer.h"
+#include "lto-compress.h"
+
+namespace Rust {
+namespace Metadata {
+
+/* The compression streams of lto-compress.cc hand their output to a callback
+ * in blocks, append those to the string given as the opaque token. */
+static void
+append_block (const char *data, unsigned length, void *opaque)
+{
+  static_cast<std::string *> (opaque)->append (data, length);
+}
+
+MetadataCompression
+metadata_compression_method ()
+{
+#ifdef HAVE_ZSTD_H
+  return MetadataCompression::ZSTD;
+#else
+  return MetadataCompression::ZLIB;
+#endif
+}
+
+std::string
+compress_metadata (const std::string &data)
+{
+  std::string compressed;
+  lto_compression_stream *stream
+    = lto_start_compression (append_block, &compressed);
+  lto_compress_block (stream, data.data (), data.size ());
+  lto_end_compression (stream);
+
+  return compressed;
+}
+
+bool
+can_decompress_metadata (MetadataCompression method)
+{
+  switch (method)
+    {
+    case MetadataCompression::NONE:
+    case MetadataCompression::ZLIB:
+      return true;
+
+    case MetadataCompression::ZSTD:
+#ifdef HAVE_ZSTD_H
+      return true;
+#else
+      return false;
+#endif
+    }
+
+  return false;
+}
+
+std::string
+decompress_metadata (MetadataCompression method, const char *data,
+		     size_t length)
+{
+  rust_assert (method != MetadataCompression::NONE);
+  rust_assert (can_decompress_metadata (method));
+
+  std::string decompressed;
+  lto_compression_stream *stream
+    = lto_start_uncompression (append_block, &decompressed);
+  lto_uncompress_block (stream, data, length);
+  lto_end_uncompression (stream, method == MetadataCompression::ZSTD ? ZSTD
+								     : ZLIB);
+
+  return decompressed;
+}
+
+} // namespace Metadata
+} // namespace Rust
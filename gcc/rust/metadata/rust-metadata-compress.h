@@ -0,0 +1,52 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_METADATA_COMPRESS_H
+#define RUST_METADATA_COMPRESS_H
+
+#include "rust-system.h"
+
+namespace Rust {
+namespace Metadata {
+
+// How the part of the metadata after the version is stored
+enum class MetadataCompression : uint8_t
+{
+  NONE = 0,
+  ZLIB = 1,
+  ZSTD = 2,
+};
+
+// The compression compress_metadata uses: zstd when GCC is built with it,
+// zlib otherwise, as for the LTO sections
+MetadataCompression metadata_compression_method ();
+
+// Compress DATA with the method above
+std::string compress_metadata (const std::string &data);
+
+// Whether buffers compressed with METHOD can be read by this compiler
+bool can_decompress_metadata (MetadataCompression method);
+
+// Decompress the LENGTH bytes at DATA, compressed with METHOD
+std::string decompress_metadata (MetadataCompression method, const char *data,
+				 size_t length);
+
+} // namespace Metadata
+} // namespace Rust
+
+#endif // RUST_METADATA_COMPRESS_H
@@ -19,8 +19,9 @@
 /* Template implementation for Rust::Parser. Previously in rust-parse.cc (before
  * Parser was template). Separated from rust-parse.h for readability. */
 
-/* DO NOT INCLUDE ANYWHERE - this is automatically included with rust-parse.h
- * This is also the reason why there are no include guards. */
+/* DO NOT INCLUDE ANYWHERE - this is only included by rust-parse.cc, which
+ * explicitly instantiates the parser for every token source. This is also the
+ * reason why there are no include guards. */
 
 #define INCLUDE_ALGORITHM
 #include "rust-diagnostics.h"
@@ -537,6 +538,7 @@ template <typename ManagedTokenSource>
 AST::Attribute
 Parser<ManagedTokenSource>::parse_attribute_body ()
 {
+  attrs_and_macros_seen++;
   Location locus = lexer.peek_token ()->get_locus ();
 
   AST::SimplePath attr_path = parse_simple_path ();
@@ -879,6 +881,8 @@ template <typename ManagedTokenSource>
 AST::DelimTokenTree
 Parser<ManagedTokenSource>::parse_delim_token_tree ()
 {
+  // token trees are only parsed for attribute inputs and macros
+  attrs_and_macros_seen++;
   const_TokenPtr t = lexer.peek_token ();
   lexer.skip_token ();
   Location initial_loc = t->get_locus ();
@@ -984,6 +988,7 @@ template <typename ManagedTokenSource>
 std::unique_ptr<AST::TokenTree>
 Parser<ManagedTokenSource>::parse_token_tree ()
 {
+  attrs_and_macros_seen++;
   const_TokenPtr t = lexer.peek_token ();
 
   switch (t->get_id ())
@@ -1062,7 +1067,7 @@ Parser<ManagedTokenSource>::parse_item (bool called_from_statement)
     case UNSAFE: // maybe - unsafe traits are a thing
       // if any of these (should be all possible VisItem prefixes), parse a
       // VisItem
-      return parse_vis_item (std::move (outer_attrs));
+      return parse_item_vis_item (std::move (outer_attrs));
       break;
     case SUPER:
     case SELF:
@@ -1077,7 +1082,7 @@ Parser<ManagedTokenSource>::parse_item (bool called_from_statement)
       if (t->get_str () == "union"
 	  && lexer.peek_token (1)->get_id () == IDENTIFIER)
 	{
-	  return parse_vis_item (std::move (outer_attrs));
+	  return parse_item_vis_item (std::move (outer_attrs));
 	  // or should this go straight to parsing union?
 	}
       else if (t->get_str () == "macro_rules")
@@ -1107,6 +1112,20 @@ Parser<ManagedTokenSource>::parse_item (bool called_from_statement)
     }
 }
 
+/* Parses the VisItem of parse_item, recording whether anything after its outer
+ * attributes will need cfg-stripping or macro expansion. */
+template <typename ManagedTokenSource>
+std::unique_ptr<AST::VisItem>
+Parser<ManagedTokenSource>::parse_item_vis_item (AST::AttrVec outer_attrs)
+{
+  size_t seen = attrs_and_macros_seen;
+  std::unique_ptr<AST::VisItem> item = parse_vis_item (std::move (outer_attrs));
+  if (item != nullptr && seen == attrs_and_macros_seen)
+    item->mark_expansion_free ();
+
+  return item;
+}
+
 // Parses a contiguous block of outer attributes.
 template <typename ManagedTokenSource>
 AST::AttrVec
@@ -1375,6 +1394,8 @@ template <typename ManagedTokenSource>
 std::unique_ptr<AST::MacroRulesDefinition>
 Parser<ManagedTokenSource>::parse_macro_rules_def (AST::AttrVec outer_attrs)
 {
+  attrs_and_macros_seen++;
+
   // ensure that first token is identifier saying "macro_rules"
   const_TokenPtr t = lexer.peek_token ();
   if (t->get_id () != IDENTIFIER || t->get_str () != "macro_rules")
@@ -7329,6 +7350,7 @@ Parser<ManagedTokenSource>::parse_block_expr (AST::AttrVec outer_attrs,
 	}
     }
 
+  size_t seen = attrs_and_macros_seen;
   AST::AttrVec inner_attrs = parse_inner_attributes ();
 
   // parse statements and expression
@@ -7380,10 +7402,14 @@ Parser<ManagedTokenSource>::parse_block_expr (AST::AttrVec outer_attrs,
 
   stmts.shrink_to_fit ();
 
-  return std::unique_ptr<AST::BlockExpr> (
+  std::unique_ptr<AST::BlockExpr> block (
     new AST::BlockExpr (std::move (stmts), std::move (expr),
 			std::move (inner_attrs), std::move (outer_attrs), locus,
 			end_locus));
+  if (seen == attrs_and_macros_seen)
+    block->mark_expansion_free ();
+
+  return block;
 }
 
 /* Parses a "grouped" expression (expression in parentheses), used to control
@@ -14913,7 +14939,7 @@ Parser<ManagedTokenSource>::debug_dump_lex_output (std::ostream &out)
 			 + std::string (", typehint=")
 			 + std::string (tok->get_type_hint_str ()))
 		      : "";
-      out << lexer.get_line_map ()->to_string (loc);
+      out << Linemap::location_to_string (loc);
 
       lexer.skip_token ();
       tok = lexer.peek_token ();
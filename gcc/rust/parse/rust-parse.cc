@@ -17,9 +17,14 @@ along with GCC; see the file COPYING3.  If not see
 #include "rust-parse.h"
 #include "rust-linemap.h"
 #include "rust-diagnostics.h"
+#include "rust-macro-invoc-lexer.h"
+#include "rust-parse-impl.h"
 
 namespace Rust {
 
+template class Parser<Lexer>;
+template class Parser<MacroInvocLexer>;
+
 std::string
 extract_module_path (const AST::AttrVec &inner_attrs,
 		     const AST::AttrVec &outer_attrs, const std::string &name)
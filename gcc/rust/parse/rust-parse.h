@@ -209,6 +209,7 @@ private:
 
   // Top-level item-related
   std::unique_ptr<AST::VisItem> parse_vis_item (AST::AttrVec outer_attrs);
+  std::unique_ptr<AST::VisItem> parse_item_vis_item (AST::AttrVec outer_attrs);
   std::unique_ptr<AST::MacroItem> parse_macro_item (AST::AttrVec outer_attrs);
 
   // VisItem subclass-related
@@ -662,7 +663,9 @@ private:
 
 public:
   // Construct parser with specified "managed" token source.
-  Parser (ManagedTokenSource &tokenSource) : lexer (tokenSource) {}
+  Parser (ManagedTokenSource &tokenSource)
+    : lexer (tokenSource), attrs_and_macros_seen (0)
+  {}
 
   // Parse items without parsing an entire crate. This function is the main
   // parsing loop of AST::Crate::parse_crate().
@@ -694,6 +697,9 @@ private:
   std::vector<Error> error_table;
   // The names of inline modules while parsing.
   std::vector<std::string> inline_module_stack;
+  /* Number of attributes, token trees and macro definitions parsed so far,
+   * used to find items and blocks with nothing to expand inside. */
+  size_t attrs_and_macros_seen;
 
   class InlineModuleStackScope
   {
@@ -724,9 +730,15 @@ extract_module_path (const AST::AttrVec &inner_attrs,
 bool
 is_match_compatible (const AST::MacroMatch &last_match,
 		     const AST::MacroMatch &current_match);
-} // namespace Rust
 
-// as now template, include implementations of all methods
-#include "rust-parse-impl.h"
+class MacroInvocLexer;
+
+/* The parser is only ever built on these token sources. Its methods are
+ * defined in rust-parse-impl.h and instantiated once, in rust-parse.cc,
+ * instead of in every file parsing something. */
+extern template class Parser<Lexer>;
+extern template class Parser<MacroInvocLexer>;
+
+} // namespace Rust
 
 #endif // RUST_PARSE_H
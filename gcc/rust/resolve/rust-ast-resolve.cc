@@ -35,11 +35,7 @@ namespace Resolver {
 NameResolution *
 NameResolution::get ()
 {
-  static NameResolution *instance;
-  if (instance == nullptr)
-    instance = new NameResolution ();
-
-  return instance;
+  return &CompilationContext::current ().get_name_resolution ();
 }
 
 NameResolution::NameResolution ()
@@ -22,6 +22,7 @@
 #include "rust-name-resolver.h"
 #include "rust-ast-full.h"
 #include "rust-hir-map.h"
+#include "rust-compilation-context.h"
 
 namespace Rust {
 namespace Resolver {
@@ -38,6 +39,7 @@ public:
 private:
   void go (AST::Crate &crate);
 
+  friend class Rust::CompilationContext;
   NameResolution ();
 
   Resolver *resolver;
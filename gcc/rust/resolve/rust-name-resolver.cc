@@ -46,7 +46,7 @@ namespace Rust {
 namespace Resolver {
 
 Rib::Rib (CrateNum crateNum, NodeId node_id)
-  : crate_num (crateNum), node_id (node_id),
+  : crate_num (crateNum), node_id (node_id), scope (nullptr), depth (0),
     mappings (Analysis::Mappings::get ())
 {}
 
@@ -69,9 +69,15 @@ Rib::insert_name (
     }
 
   path_mappings[path] = id;
+  if (scope != nullptr)
+    scope->bind_name (path, depth, id);
+
   reverse_path_mappings.insert (std::pair<NodeId, CanonicalPath> (id, path));
-  decls_within_rib.insert (std::pair<NodeId, Location> (id, locus));
-  references[id] = {};
+  bool declared
+    = decls_within_rib.insert (std::pair<NodeId, Location> (id, locus)).second;
+  if (declared && scope != nullptr)
+    scope->declare (id);
+  reference_counts.erase (id);
 }
 
 bool
@@ -90,7 +96,11 @@ Rib::clear_name (const CanonicalPath &ident, NodeId id)
 {
   auto ii = path_mappings.find (ident);
   if (ii != path_mappings.end ())
-    path_mappings.erase (ii);
+    {
+      path_mappings.erase (ii);
+      if (scope != nullptr)
+	scope->unbind_name (ident, depth);
+    }
 
   auto ij = reverse_path_mappings.find (id);
   if (ij != reverse_path_mappings.end ())
@@ -98,34 +108,33 @@ Rib::clear_name (const CanonicalPath &ident, NodeId id)
 
   auto ik = decls_within_rib.find (id);
   if (ik != decls_within_rib.end ())
-    decls_within_rib.erase (ik);
+    {
+      decls_within_rib.erase (ik);
+      if (scope != nullptr)
+	scope->undeclare (id);
+    }
 }
 
 void
 Rib::append_reference_for_def (NodeId def, NodeId ref)
 {
-  references[def].insert (ref);
+  reference_counts[def]++;
 }
 
 bool
 Rib::have_references_for_node (NodeId def) const
 {
-  auto it = references.find (def);
-  if (it == references.end ())
+  auto it = reference_counts.find (def);
+  if (it == reference_counts.end ())
     return false;
 
-  return !it->second.empty ();
+  return it->second != 0;
 }
 
 bool
 Rib::decl_was_declared_here (NodeId def) const
 {
-  for (auto &it : decls_within_rib)
-    {
-      if (it.first == def)
-	return true;
-    }
-  return false;
+  return decls_within_rib.find (def) != decls_within_rib.end ();
 }
 
 void
@@ -167,15 +176,66 @@ Scope::insert (const CanonicalPath &ident, NodeId id, Location locus)
 bool
 Scope::lookup (const CanonicalPath &ident, NodeId *id)
 {
-  NodeId lookup = UNKNOWN_NODEID;
-  iterate ([&] (Rib *r) mutable -> bool {
-    if (r->lookup_name (ident, &lookup))
-      return false;
-    return true;
-  });
+  *id = UNKNOWN_NODEID;
+
+  auto it = bindings.find (ident);
+  if (it == bindings.end ())
+    return false;
+
+  *id = it->second.back ().second;
+  return *id != UNKNOWN_NODEID;
+}
+
+void
+Scope::bind_name (const CanonicalPath &ident, size_t depth, NodeId id)
+{
+  auto &decls = bindings[ident];
+
+  // names are nearly always added to the rib on the top of the stack
+  auto it = decls.end ();
+  while (it != decls.begin () && (it - 1)->first >= depth)
+    --it;
+
+  if (it != decls.end () && it->first == depth)
+    it->second = id;
+  else
+    decls.insert (it, {depth, id});
+}
 
-  *id = lookup;
-  return lookup != UNKNOWN_NODEID;
+void
+Scope::unbind_name (const CanonicalPath &ident, size_t depth)
+{
+  auto it = bindings.find (ident);
+  if (it == bindings.end ())
+    return;
+
+  auto &decls = it->second;
+  for (auto d = decls.begin (); d != decls.end (); ++d)
+    {
+      if (d->first == depth)
+	{
+	  decls.erase (d);
+	  break;
+	}
+    }
+
+  if (decls.empty ())
+    bindings.erase (it);
+}
+
+void
+Scope::declare (NodeId id)
+{
+  declarations[id]++;
+}
+
+void
+Scope::undeclare (NodeId id)
+{
+  auto it = declarations.find (id);
+  rust_assert (it != declarations.end ());
+  if (--it->second == 0)
+    declarations.erase (it);
 }
 
 void
@@ -207,13 +267,22 @@ Scope::peek ()
 void
 Scope::push (NodeId id)
 {
-  stack.push_back (new Rib (get_crate_num (), id));
+  Rib *r = new Rib (get_crate_num (), id);
+  r->scope = this;
+  r->depth = stack.size ();
+  stack.push_back (r);
 }
 
 Rib *
 Scope::pop ()
 {
   Rib *r = peek ();
+  for (auto &it : r->path_mappings)
+    unbind_name (it.first, r->depth);
+  for (auto &it : r->decls_within_rib)
+    undeclare (it.first);
+
+  r->scope = nullptr;
   stack.pop_back ();
   return r;
 }
@@ -236,16 +305,7 @@ Scope::append_reference_for_def (NodeId refId, NodeId defId)
 bool
 Scope::decl_was_declared_here (NodeId def) const
 {
-  bool found = false;
-  iterate ([&] (const Rib *r) -> bool {
-    if (r->decl_was_declared_here (def))
-      {
-	found = true;
-	return false;
-      }
-    return true;
-  });
-  return found;
+  return declarations.find (def) != declarations.end ();
 }
 
 Resolver::Resolver ()
@@ -262,18 +322,14 @@ Resolver::Resolver ()
 Resolver *
 Resolver::get ()
 {
-  static Resolver *instance;
-  if (instance == nullptr)
-    instance = new Resolver ();
-
-  return instance;
+  return &CompilationContext::current ().get_resolver ();
 }
 
 void
 Resolver::push_new_name_rib (Rib *r)
 {
-  rust_assert (name_ribs.find (r->get_node_id ()) == name_ribs.end ());
-  name_ribs[r->get_node_id ()] = r;
+  rust_assert (!name_ribs.contains (r->get_node_id ()));
+  name_ribs.insert (r->get_node_id (), r);
 }
 
 void
@@ -282,54 +338,54 @@ Resolver::push_new_type_rib (Rib *r)
   if (type_ribs.size () == 0)
     global_type_node_id = r->get_node_id ();
 
-  rust_assert (type_ribs.find (r->get_node_id ()) == type_ribs.end ());
-  type_ribs[r->get_node_id ()] = r;
+  rust_assert (!type_ribs.contains (r->get_node_id ()));
+  type_ribs.insert (r->get_node_id (), r);
 }
 
 void
 Resolver::push_new_label_rib (Rib *r)
 {
-  rust_assert (label_ribs.find (r->get_node_id ()) == label_ribs.end ());
-  label_ribs[r->get_node_id ()] = r;
+  rust_assert (!label_ribs.contains (r->get_node_id ()));
+  label_ribs.insert (r->get_node_id (), r);
 }
 
 void
 Resolver::push_new_macro_rib (Rib *r)
 {
-  rust_assert (label_ribs.find (r->get_node_id ()) == label_ribs.end ());
-  macro_ribs[r->get_node_id ()] = r;
+  rust_assert (!label_ribs.contains (r->get_node_id ()));
+  macro_ribs.insert (r->get_node_id (), r);
 }
 
 bool
 Resolver::find_name_rib (NodeId id, Rib **rib)
 {
-  auto it = name_ribs.find (id);
-  if (it == name_ribs.end ())
+  auto lookup = name_ribs.lookup (id);
+  if (lookup == nullptr)
     return false;
 
-  *rib = it->second;
+  *rib = *lookup;
   return true;
 }
 
 bool
 Resolver::find_type_rib (NodeId id, Rib **rib)
 {
-  auto it = type_ribs.find (id);
-  if (it == type_ribs.end ())
+  auto lookup = type_ribs.lookup (id);
+  if (lookup == nullptr)
     return false;
 
-  *rib = it->second;
+  *rib = *lookup;
   return true;
 }
 
 bool
 Resolver::find_macro_rib (NodeId id, Rib **rib)
 {
-  auto it = macro_ribs.find (id);
-  if (it == macro_ribs.end ())
+  auto lookup = macro_ribs.lookup (id);
+  if (lookup == nullptr)
     return false;
 
-  *rib = it->second;
+  *rib = *lookup;
   return true;
 }
 
@@ -421,18 +477,19 @@ Resolver::generate_builtins ()
 void
 Resolver::insert_resolved_name (NodeId refId, NodeId defId)
 {
-  resolved_names[refId] = defId;
+  resolved_names.insert (refId, defId);
+  resolved_name_targets.insert (defId);
   get_name_scope ().append_reference_for_def (refId, defId);
 }
 
 bool
 Resolver::lookup_resolved_name (NodeId refId, NodeId *defId)
 {
-  auto it = resolved_names.find (refId);
-  if (it == resolved_names.end ())
+  auto lookup = resolved_names.lookup (refId);
+  if (lookup == nullptr)
     return false;
 
-  *defId = it->second;
+  *defId = *lookup;
   return true;
 }
 
@@ -442,80 +499,77 @@ Resolver::insert_resolved_type (NodeId refId, NodeId defId)
   // auto it = resolved_types.find (refId);
   // rust_assert (it == resolved_types.end ());
 
-  resolved_types[refId] = defId;
+  resolved_types.insert (refId, defId);
   get_type_scope ().append_reference_for_def (refId, defId);
 }
 
 bool
 Resolver::lookup_resolved_type (NodeId refId, NodeId *defId)
 {
-  auto it = resolved_types.find (refId);
-  if (it == resolved_types.end ())
+  auto lookup = resolved_types.lookup (refId);
+  if (lookup == nullptr)
     return false;
 
-  *defId = it->second;
+  *defId = *lookup;
   return true;
 }
 
 void
 Resolver::insert_resolved_label (NodeId refId, NodeId defId)
 {
-  auto it = resolved_labels.find (refId);
-  rust_assert (it == resolved_labels.end ());
+  rust_assert (!resolved_labels.contains (refId));
 
-  resolved_labels[refId] = defId;
+  resolved_labels.insert (refId, defId);
   get_label_scope ().append_reference_for_def (refId, defId);
 }
 
 bool
 Resolver::lookup_resolved_label (NodeId refId, NodeId *defId)
 {
-  auto it = resolved_labels.find (refId);
-  if (it == resolved_labels.end ())
+  auto lookup = resolved_labels.lookup (refId);
+  if (lookup == nullptr)
     return false;
 
-  *defId = it->second;
+  *defId = *lookup;
   return true;
 }
 
 void
 Resolver::insert_resolved_macro (NodeId refId, NodeId defId)
 {
-  auto it = resolved_macros.find (refId);
-  rust_assert (it == resolved_macros.end ());
+  rust_assert (!resolved_macros.contains (refId));
 
-  resolved_labels[refId] = defId;
+  resolved_labels.insert (refId, defId);
   get_label_scope ().append_reference_for_def (refId, defId);
 }
 
 bool
 Resolver::lookup_resolved_macro (NodeId refId, NodeId *defId)
 {
-  auto it = resolved_macros.find (refId);
-  if (it == resolved_macros.end ())
+  auto lookup = resolved_macros.lookup (refId);
+  if (lookup == nullptr)
     return false;
 
-  *defId = it->second;
+  *defId = *lookup;
   return true;
 }
 
 void
 Resolver::insert_resolved_misc (NodeId refId, NodeId defId)
 {
-  auto it = misc_resolved_items.find (refId);
-  rust_assert (it == misc_resolved_items.end ());
+  rust_assert (!misc_resolved_items.contains (refId));
 
-  misc_resolved_items[refId] = defId;
+  misc_resolved_items.insert (refId, defId);
 }
 
 bool
 Resolver::lookup_resolved_misc (NodeId refId, NodeId *defId)
 {
-  auto it = misc_resolved_items.find (refId);
-  if (it == misc_resolved_items.end ())
+  auto lookup = misc_resolved_items.lookup (refId);
+  if (lookup == nullptr)
     return false;
 
-  *defId = it->second;
+  *defId = *lookup;
   return true;
 }
 
@@ -22,11 +22,15 @@
 #include "rust-system.h"
 #include "rust-canonical-path.h"
 #include "rust-hir-map.h"
+#include "rust-dense-id-map.h"
 #include "rust-hir-type-check.h"
+#include "rust-compilation-context.h"
 
 namespace Rust {
 namespace Resolver {
 
+class Scope;
+
 class Rib
 {
 public:
@@ -53,12 +57,22 @@ public:
   std::map<NodeId, Location> &get_declarations () { return decls_within_rib; }
 
 private:
+  friend class Scope;
+
   CrateNum crate_num;
   NodeId node_id;
+
+  // the scope this rib is currently pushed on, which is told about every
+  // name added or removed so it can keep its lookup index up to date
+  Scope *scope;
+  size_t depth;
+
   std::map<CanonicalPath, NodeId> path_mappings;
   std::map<NodeId, CanonicalPath> reverse_path_mappings;
   std::map<NodeId, Location> decls_within_rib;
-  std::map<NodeId, std::set<NodeId>> references;
+  // the number of resolved uses of each declaration; nothing needs to know
+  // where the uses are so they are not kept
+  std::map<NodeId, size_t> reference_counts;
   Analysis::Mappings *mappings;
 };
 
@@ -87,8 +101,26 @@ public:
   CrateNum get_crate_num () const { return crate_num; }
 
 private:
+  friend class Rib;
+
+  void bind_name (const CanonicalPath &ident, size_t depth, NodeId id);
+  void unbind_name (const CanonicalPath &ident, size_t depth);
+  void declare (NodeId id);
+  void undeclare (NodeId id);
+
   CrateNum crate_num;
   std::vector<Rib *> stack;
+
+  // every name visible from the top of the stack, mapped to the ribs which
+  // declare it as (rib depth, node id) pairs with the innermost one last. This
+  // lets lookup find the nearest declaration without walking the stack
+  std::unordered_map<CanonicalPath, std::vector<std::pair<size_t, NodeId>>>
+    bindings;
+
+  // the number of ribs on the stack declaring each node, so that paths in
+  // item bodies don't walk the ribs, the crate root one with every top-level
+  // item among them, to check where their target was declared
+  std::unordered_map<NodeId, size_t> declarations;
 };
 
 class Resolver
@@ -116,6 +148,11 @@ public:
 
   void insert_resolved_name (NodeId refId, NodeId defId);
   bool lookup_resolved_name (NodeId refId, NodeId *defId);
+  // whether any name anywhere has been resolved to DEFID
+  bool is_name_referenced (NodeId defId) const
+  {
+    return resolved_name_targets.contains (defId);
+  }
 
   void insert_resolved_type (NodeId refId, NodeId defId);
   bool lookup_resolved_type (NodeId refId, NodeId *defId);
@@ -169,6 +206,7 @@ public:
   }
 
 private:
+  friend class Rust::CompilationContext;
   Resolver ();
 
   void generate_builtins ();
@@ -187,10 +225,10 @@ private:
   NodeId unit_ty_node_id;
 
   // map a AST Node to a Rib
-  std::map<NodeId, Rib *> name_ribs;
-  std::map<NodeId, Rib *> type_ribs;
-  std::map<NodeId, Rib *> label_ribs;
-  std::map<NodeId, Rib *> macro_ribs;
+  DenseIdMap<Rib *> name_ribs;
+  DenseIdMap<Rib *> type_ribs;
+  DenseIdMap<Rib *> label_ribs;
+  DenseIdMap<Rib *> macro_ribs;
 
   // Rust uses DefIds to namespace these under a crate_num
   // but then it uses the def_collector to assign local_defids
@@ -200,13 +238,14 @@ private:
 
   // these are of the form ref->Def-NodeId
   // we need two namespaces one for names and ones for types
-  std::map<NodeId, NodeId> resolved_names;
-  std::map<NodeId, NodeId> resolved_types;
-  std::map<NodeId, NodeId> resolved_labels;
-  std::map<NodeId, NodeId> resolved_macros;
+  DenseIdMap<NodeId> resolved_names;
+  DenseIdSet resolved_name_targets;
+  DenseIdMap<NodeId> resolved_types;
+  DenseIdMap<NodeId> resolved_labels;
+  DenseIdMap<NodeId> resolved_macros;
 
   // misc
-  std::map<NodeId, NodeId> misc_resolved_items;
+  DenseIdMap<NodeId> misc_resolved_items;
 
   // keep track of the current module scope ids
   std::vector<NodeId> current_module_stack;
@@ -108,6 +108,9 @@ public:
   // make type immutable
   virtual tree immutable_type (tree base) = 0;
 
+  // make a pointer type restrict qualified
+  virtual tree restrict_type (tree base) = 0;
+
   // Get a function type.  The receiver, parameter, and results are
   // generated from the types in the Function_type.  The Function_type
   // is provided so that the names are available.  This should return
@@ -138,6 +141,14 @@ public:
   // Get a struct type.
   virtual tree struct_type (const std::vector<typed_identifier> &fields) = 0;
 
+  // Get a struct type whose fields may be laid out in any order, for structs
+  // without a fixed representation.  Fields are still referred to by their
+  // index in FIELDS in struct_field_expression, constructor_expression and
+  // type_field_offset.
+  virtual tree
+  reordered_struct_type (const std::vector<typed_identifier> &fields)
+    = 0;
+
   // Get a union type.
   virtual tree union_type (const std::vector<typed_identifier> &fields) = 0;
 
@@ -187,7 +198,9 @@ public:
   // Return an expression for the complex value VAL in BTYPE.
   virtual tree complex_constant_expression (tree btype, mpc_t val) = 0;
 
-  // Return an expression for the string value VAL.
+  // Return an expression for the string value VAL.  The constant is NUL
+  // terminated, which the length of a Rust string does not count, so that
+  // identical literals can be merged by the assembler and linker.
   virtual tree string_constant_expression (const std::string &val) = 0;
 
   // Get a char literal
@@ -500,6 +513,9 @@ public:
 
   // Utility.
 
+  // Hand the completed definition of FUNCTION to the middle-end.
+  virtual void write_function_definition (tree function) = 0;
+
   // Write the definitions for all TYPE_DECLS, CONSTANT_DECLS,
   // FUNCTION_DECLS, and VARIABLE_DECLS declared globally.
   virtual void
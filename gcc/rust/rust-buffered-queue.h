@@ -23,12 +23,18 @@
 
 namespace Rust {
 /* Buffered queue implementation. Items are of type T, queue source is of type
- * Source. Note that this is owning of the source. */
+ * Source. Note that this is owning of the source.
+ *
+ * The queue is a circular buffer whose capacity is a power of two, so an
+ * item's slot is found by masking and peeking, skipping and refilling never
+ * move the items already queued. The buffer only grows, by doubling, when
+ * more items are looked ahead at than it can hold. */
 template <typename T, typename Source> class buffered_queue
 {
 public:
   // Construct empty queue from Source src.
-  buffered_queue (Source src) : source (src), start (0), end (0), buffer () {}
+  buffered_queue (Source src) : source (src), start (0), count (0), buffer ()
+  {}
 
   /* disable copying (since source is probably non-copyable)
    * TODO is this actually a good idea? If source is non-copyable, it would
@@ -46,122 +52,54 @@ public:
     // n should not be behind
     rust_assert (n >= 0);
 
-    int num_queued_items = end - start;
-    int num_items_required = n + 1;
-
     // if required items go past end of queue, add them to queue
-    if (num_items_required > num_queued_items)
+    size_t num_items_required = n + 1;
+    if (num_items_required > count)
       {
-	int num_items_to_read = num_items_required - num_queued_items;
+	if (num_items_required > buffer.size ())
+	  grow (num_items_required);
 
-	/* if queue length + extra items is larger than buffer size, expand
-	 * buffer */
-	if (end + num_items_to_read > (int) buffer.size ())
+	while (count < num_items_required)
 	  {
-	    // Resize the buffer by 1.5x
-	    int new_size = (buffer.size () + num_items_to_read);
-	    new_size += (new_size >> 1);
-
-	    // old method:
-	    /*
-		  // create new queue buffer with new size
-		  std::vector<T> new_queue (new_size);
-		  std::copy (buffer.begin () + start, buffer.begin () + end,
-			     new_queue.begin ());
-		  start = 0;
-		  end = num_queued_items;
-		  // TODO: would move be better here? optimisation for move with
-		  // shared pointer?
-
-		  // swap member buffer and new queue buffer
-		  std::swap (buffer, new_queue);
-	    */
-
-	    // TODO: determine overhead of this approach vs copy. Should be
-	    // lower.
-	    std::vector<T> new_queue;
-	    new_queue.reserve (new_size);
-	    new_queue.insert (new_queue.begin (),
-			      std::make_move_iterator (buffer.begin () + start),
-			      std::make_move_iterator (buffer.begin () + end));
-	    start = 0;
-	    end = num_queued_items;
-	    // fill up rest of vector with junk so that indexing can work
-	    new_queue.insert (new_queue.begin () + end,
-			      new_size - new_queue.size (), T ());
-
-	    buffer = std::move (new_queue);
-	    /* this should be best method - std::move(range) would have
-	     * allocation problems; initial construction would require
-	     * reallocation upon resizing */
-
-	    // validate that buffer is large enough now
-	    rust_assert (end + num_items_to_read <= (int) buffer.size ());
+	    slot (count) = source.next ();
+	    count++;
 	  }
-
-	/* iterate through buffer and invoke operator () on source on values
-	 * past original end */
-	for (int i = 0; i < num_items_to_read; i++)
-	  buffer[end + i] = source.next ();
-
-	// move end based on additional items added
-	end += num_items_to_read;
       }
 
-    rust_assert (0 <= start);
-    rust_assert (start <= end);
-    rust_assert (end <= (int) buffer.size ());
-
-    rust_assert (start + n < end);
-
-    // return value at start + n in buffer
-    return buffer[start + n];
+    return slot (n);
   }
 
-  /* TODO: add faster peek current token to remove overhead of conditional
-   * branches? */
-
   // Advances start by n + 1.
   void skip (int n)
   {
     // Call peek to ensure requested n is actually in queue.
     peek (n);
 
-    // Clear queue values from start to n (inclusive).
-    for (int i = 0; i < (n + 1); i++)
-      buffer[start + i] = T ();
-
-    // Move start forward by n + 1.
-    start += (n + 1);
-
-    // Ensure start is not impossible somehow
-    rust_assert (0 <= start);
-    rust_assert (start <= end);
+    // Release what the skipped items own, trivial items can be left as is
+    if (!std::is_scalar<T>::value)
+      {
+	for (int i = 0; i < (n + 1); i++)
+	  slot (i) = T ();
+      }
 
-    // Compact buffer if empty
-    if (start == end)
-      start = end = 0;
+    start = (start + n + 1) & mask ();
+    count -= n + 1;
   }
 
-  /* Inserts element at front of vector. Really dirty hack with terrible
-   * performance, only use when really needed. */
+  // Inserts element at front of queue.
   void insert_at_front (T elem_to_insert)
   {
-    // TODO: test as this may not work properly
-
-    // Insert actual element in buffer at start.
-    buffer.insert (buffer.begin (), elem_to_insert);
+    if (count == buffer.size ())
+      grow (count + 1);
 
-    /* Increase the end number since added element means all others have shifted
-     * one along */
-    end++;
+    start = (start - 1) & mask ();
+    slot (0) = std::move (elem_to_insert);
+    count++;
   }
 
   // Insert at arbitrary position (attempt)
   void insert (int index, T elem_to_insert)
   {
-    // TODO: test as this may not work properly
-
     // n should not be behind
     rust_assert (index >= 0);
 
@@ -171,9 +109,15 @@ public:
     else
       peek (index);
 
-    buffer.insert (buffer.begin () + start + index, std::move (elem_to_insert));
+    if (count == buffer.size ())
+      grow (count + 1);
+
+    // shift the items from index onwards back by one to make room
+    for (size_t i = count; i > (size_t) index; i--)
+      slot (i) = std::move (slot (i - 1));
+    slot (index) = std::move (elem_to_insert);
 
-    end++;
+    count++;
   }
 
   // Replaces the current value in the buffer. Total HACK.
@@ -182,21 +126,44 @@ public:
     // call peek to ensure value exists
     peek (0);
 
-    buffer[start] = std::move (replacement);
+    slot (0) = std::move (replacement);
 
     // don't move start or end
   }
 
 private:
+  static const size_t initial_capacity = 16;
+
+  size_t mask () const { return buffer.size () - 1; }
+
+  // The storage of the item n places after the start of the queue.
+  T &slot (size_t n) { return buffer[(start + n) & mask ()]; }
+
+  // Reallocate to the smallest power of two holding required items, moving
+  // the queued items to the front of the new buffer in order.
+  void grow (size_t required)
+  {
+    size_t new_size = buffer.empty () ? initial_capacity : buffer.size ();
+    while (new_size < required)
+      new_size <<= 1;
+
+    std::vector<T> new_buffer (new_size);
+    for (size_t i = 0; i < count; i++)
+      new_buffer[i] = std::move (slot (i));
+
+    buffer = std::move (new_buffer);
+    start = 0;
+  }
+
   // Source of tokens for queue.
   Source source;
 
-  // Begin of range in buffer, inclusive.
-  int start;
-  // End of range in buffer, exclusive.
-  int end;
+  // Slot of the first queued item in buffer.
+  size_t start;
+  // Number of items queued from start.
+  size_t count;
 
-  // Queue buffer.
+  // Queue buffer, its size is zero or a power of two.
   std::vector<T> buffer;
 };
 } // namespace Rust
@@ -0,0 +1,97 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-compilation-context.h"
+#include "rust-hir-map.h"
+#include "rust-name-resolver.h"
+#include "rust-ast-resolve.h"
+#include "rust-hir-type-check.h"
+
+namespace Rust {
+
+// the context made current on this thread, if any
+static thread_local CompilationContext *thread_context = nullptr;
+
+CompilationContext::CompilationContext () {}
+
+CompilationContext::~CompilationContext () { reset (); }
+
+CompilationContext &
+CompilationContext::current ()
+{
+  if (thread_context != nullptr)
+    return *thread_context;
+
+  // never destroyed, as the singletons this replaces never were
+  static CompilationContext *process_context = new CompilationContext ();
+  return *process_context;
+}
+
+void
+CompilationContext::set_current (CompilationContext *ctx)
+{
+  thread_context = ctx;
+}
+
+Analysis::Mappings &
+CompilationContext::get_mappings ()
+{
+  if (mappings == nullptr)
+    mappings.reset (new Analysis::Mappings ());
+
+  return *mappings;
+}
+
+Resolver::Resolver &
+CompilationContext::get_resolver ()
+{
+  if (resolver == nullptr)
+    resolver.reset (new Resolver::Resolver ());
+
+  return *resolver;
+}
+
+Resolver::NameResolution &
+CompilationContext::get_name_resolution ()
+{
+  if (name_resolution == nullptr)
+    name_resolution.reset (new Resolver::NameResolution ());
+
+  return *name_resolution;
+}
+
+Resolver::TypeCheckContext &
+CompilationContext::get_type_check_context ()
+{
+  if (type_check_context == nullptr)
+    type_check_context.reset (new Resolver::TypeCheckContext ());
+
+  return *type_check_context;
+}
+
+void
+CompilationContext::reset ()
+{
+  // each of these refers to the ones after it
+  type_check_context.reset ();
+  name_resolution.reset ();
+  resolver.reset ();
+  mappings.reset ();
+}
+
+} // namespace Rust
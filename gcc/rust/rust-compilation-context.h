@@ -0,0 +1,72 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_COMPILATION_CONTEXT_H
+#define RUST_COMPILATION_CONTEXT_H
+
+#include "rust-system.h"
+
+namespace Rust {
+namespace Analysis {
+class Mappings;
+}
+namespace Resolver {
+class Resolver;
+class NameResolution;
+class TypeCheckContext;
+} // namespace Resolver
+
+/* The state the front end builds up while compiling a crate: the HIR
+ * mappings, the name resolver and the type-check context. The get ()
+ * accessors of those classes return the instances of the context current on
+ * the calling thread, which creates them on first use. A driver compiling
+ * more than one crate in a process resets the context between crates, and a
+ * pass running on worker threads gives each worker a context of its own. */
+class CompilationContext
+{
+public:
+  CompilationContext ();
+  ~CompilationContext ();
+
+  /* The context made current on this thread, or else the context of the
+   * process. The process context must only be used from one thread. */
+  static CompilationContext &current ();
+
+  // Make CTX current on this thread; nullptr makes it use the process context
+  static void set_current (CompilationContext *ctx);
+
+  Analysis::Mappings &get_mappings ();
+  Resolver::Resolver &get_resolver ();
+  Resolver::NameResolution &get_name_resolution ();
+  Resolver::TypeCheckContext &get_type_check_context ();
+
+  /* Drop everything recorded for the crates compiled so far, the next
+   * accessor call starts from a fresh instance. Nothing built from the old
+   * instances, such as a visitor holding on to them, may be used after. */
+  void reset ();
+
+private:
+  std::unique_ptr<Analysis::Mappings> mappings;
+  std::unique_ptr<Resolver::Resolver> resolver;
+  std::unique_ptr<Resolver::NameResolution> name_resolution;
+  std::unique_ptr<Resolver::TypeCheckContext> type_check_context;
+};
+
+} // namespace Rust
+
+#endif // RUST_COMPILATION_CONTEXT_H
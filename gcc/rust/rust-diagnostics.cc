@@ -21,6 +21,9 @@
 #include "rust-system.h"
 #include "rust-diagnostics.h"
 
+extern bool
+saw_errors (void);
+
 static std::string
 mformat_value ()
 {
@@ -162,8 +165,14 @@ rust_error_at (const Location location, const char *fmt, ...)
   va_list ap;
 
   va_start (ap, fmt);
-  rust_be_error_at (location, expand_message (fmt, ap));
+  std::string message = expand_message (fmt, ap);
   va_end (ap);
+
+  if (Rust::DiagnosticBuffer *buffer = Rust::DiagnosticBuffer::current ())
+    buffer->record (Rust::DiagnosticBuffer::ERROR, location, 0,
+		    std::move (message));
+  else
+    rust_be_error_at (location, message);
 }
 
 void
@@ -173,8 +182,14 @@ rust_error_at (const RichLocation &location, const ErrorCode code,
   va_list ap;
 
   va_start (ap, fmt);
-  rust_be_error_at (location, code, expand_message (fmt, ap));
+  std::string message = expand_message (fmt, ap);
   va_end (ap);
+
+  if (Rust::DiagnosticBuffer *buffer = Rust::DiagnosticBuffer::current ())
+    buffer->record (Rust::DiagnosticBuffer::ERROR, location, code.m_str,
+		    std::move (message));
+  else
+    rust_be_error_at (location, code, message);
 }
 
 void
@@ -183,8 +198,14 @@ rust_warning_at (const Location location, int opt, const char *fmt, ...)
   va_list ap;
 
   va_start (ap, fmt);
-  rust_be_warning_at (location, opt, expand_message (fmt, ap));
+  std::string message = expand_message (fmt, ap);
   va_end (ap);
+
+  if (Rust::DiagnosticBuffer *buffer = Rust::DiagnosticBuffer::current ())
+    buffer->record (Rust::DiagnosticBuffer::WARNING, location, opt,
+		    std::move (message));
+  else
+    rust_be_warning_at (location, opt, message);
 }
 
 void
@@ -203,8 +224,14 @@ rust_inform (const Location location, const char *fmt, ...)
   va_list ap;
 
   va_start (ap, fmt);
-  rust_be_inform (location, expand_message (fmt, ap));
+  std::string message = expand_message (fmt, ap);
   va_end (ap);
+
+  if (Rust::DiagnosticBuffer *buffer = Rust::DiagnosticBuffer::current ())
+    buffer->record (Rust::DiagnosticBuffer::INFORM, location, 0,
+		    std::move (message));
+  else
+    rust_be_inform (location, message);
 }
 
 // Rich Locations
@@ -214,16 +241,19 @@ rust_error_at (const RichLocation &location, const char *fmt, ...)
   va_list ap;
 
   va_start (ap, fmt);
-  rust_be_error_at (location, expand_message (fmt, ap));
+  std::string message = expand_message (fmt, ap);
   va_end (ap);
+
+  if (Rust::DiagnosticBuffer *buffer = Rust::DiagnosticBuffer::current ())
+    buffer->record (Rust::DiagnosticBuffer::ERROR, location, nullptr,
+		    std::move (message));
+  else
+    rust_be_error_at (location, message);
 }
 
 void
-rust_debug_loc (const Location location, const char *fmt, ...)
+rust_debug_emit (const Location location, const char *fmt, ...)
 {
-  if (!rust_be_debug_p ())
-    return;
-
   va_list ap;
 
   va_start (ap, fmt);
@@ -252,4 +282,117 @@ Error::Error (const Location location, const char *fmt, ...) : locus (location)
 
   message.shrink_to_fit ();
 }
+
+// the buffer a DiagnosticBuffer::Scope of this thread records into, and the
+// order key of the scope
+static thread_local DiagnosticBuffer *current_buffer = nullptr;
+static thread_local uint64_t current_order_key = 0;
+
+DiagnosticBuffer::Scope::Scope (DiagnosticBuffer &buffer, uint64_t order_key)
+  : outer_buffer (current_buffer), outer_key (current_order_key)
+{
+  current_buffer = &buffer;
+  current_order_key = order_key;
+}
+
+DiagnosticBuffer::Scope::~Scope ()
+{
+  current_buffer = outer_buffer;
+  current_order_key = outer_key;
+}
+
+DiagnosticBuffer *
+DiagnosticBuffer::current ()
+{
+  return current_buffer;
+}
+
+void
+DiagnosticBuffer::record (Kind kind, Location locus, int opt,
+			  std::string message)
+{
+  diagnostics.push_back ({current_order_key, kind, opt, false, {locus}, nullptr,
+			  std::move (message)});
+  if (kind == ERROR)
+    error_count++;
+}
+
+void
+DiagnosticBuffer::record (Kind kind, const RichLocation &locus,
+			  const char *code, std::string message)
+{
+  const rich_location &gcc_loc = locus.get ();
+  std::vector<Location> locations;
+  for (unsigned i = 0; i < gcc_loc.get_num_locations (); i++)
+    locations.push_back (Location (gcc_loc.get_loc (i)));
+
+  diagnostics.push_back ({current_order_key, kind, 0, true,
+			  std::move (locations), code, std::move (message)});
+  if (kind == ERROR)
+    error_count++;
+}
+
+void
+DiagnosticBuffer::Diagnostic::emit () const
+{
+  if (rich)
+    {
+      RichLocation locus (locations[0]);
+      for (size_t i = 1; i < locations.size (); i++)
+	locus.add_range (locations[i]);
+
+      if (code != nullptr)
+	rust_be_error_at (locus, ErrorCode (code), message);
+      else
+	rust_be_error_at (locus, message);
+      return;
+    }
+
+  switch (kind)
+    {
+    case ERROR:
+      rust_be_error_at (locations[0], message);
+      break;
+    case WARNING:
+      rust_be_warning_at (locations[0], opt, message);
+      break;
+    case INFORM:
+      rust_be_inform (locations[0], message);
+      break;
+    }
+}
+
+void
+DiagnosticBuffer::emit (const std::vector<DiagnosticBuffer *> &buffers)
+{
+  std::vector<const Diagnostic *> ordered;
+  for (auto buffer : buffers)
+    for (auto &diagnostic : buffer->diagnostics)
+      ordered.push_back (&diagnostic);
+
+  std::stable_sort (ordered.begin (), ordered.end (),
+		    [] (const Diagnostic *a, const Diagnostic *b) {
+		      return a->order_key < b->order_key;
+		    });
+  for (auto diagnostic : ordered)
+    diagnostic->emit ();
+
+  for (auto buffer : buffers)
+    {
+      buffer->diagnostics.clear ();
+      buffer->error_count = 0;
+    }
+}
+
+bool
+DiagnosticBuffer::saw_errors (const std::vector<DiagnosticBuffer *> &buffers)
+{
+  if (::saw_errors ())
+    return true;
+
+  for (auto buffer : buffers)
+    if (buffer->has_errors ())
+      return true;
+  return false;
+}
 } // namespace Rust
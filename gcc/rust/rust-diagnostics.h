@@ -155,10 +155,91 @@ struct Error
     rust_fatal_error (locus, "%s", message.c_str ());
   }
 };
+
+/* The diagnostics of a pass whose items are handled by several workers. While
+ * a DiagnosticBuffer::Scope is live on a thread, the rust_error_at,
+ * rust_warning_at and rust_inform calls of that thread are recorded in the
+ * buffer of the scope, under the order key of the item being handled, instead
+ * of being emitted. At the end of the pass DiagnosticBuffer::emit replays the
+ * buffers of every worker in the order of their keys, so the output does not
+ * depend on how the items were scheduled. Each worker records into its own
+ * buffer, and the buffers are only emitted once the workers are done.
+ *
+ * Fatal and internal errors still stop the compilation straight away, and
+ * rust_debug output is never buffered. */
+class DiagnosticBuffer
+{
+public:
+  enum Kind
+  {
+    ERROR,
+    WARNING,
+    INFORM,
+  };
+
+  // Records the diagnostics of the current thread into BUFFER, under
+  // ORDER_KEY, for the lifetime of the scope
+  class Scope
+  {
+  public:
+    Scope (DiagnosticBuffer &buffer, uint64_t order_key);
+    ~Scope ();
+
+  private:
+    DiagnosticBuffer *outer_buffer;
+    uint64_t outer_key;
+  };
+
+  DiagnosticBuffer () : error_count (0) {}
+
+  // The buffer the current thread records into, or nullptr
+  static DiagnosticBuffer *current ();
+
+  void record (Kind kind, Location locus, int opt, std::string message);
+  void record (Kind kind, const RichLocation &locus, const char *code,
+	       std::string message);
+
+  bool has_errors () const { return error_count != 0; }
+
+  /* Emits the diagnostics of BUFFERS in the order of their keys, and in the
+   * order of BUFFERS then of recording for equal keys, and clears them. */
+  static void emit (const std::vector<DiagnosticBuffer *> &buffers);
+
+  // saw_errors (), counting the errors recorded in BUFFERS but not emitted yet
+  static bool saw_errors (const std::vector<DiagnosticBuffer *> &buffers);
+
+private:
+  struct Diagnostic
+  {
+    uint64_t order_key;
+    Kind kind;
+    int opt;
+    // a rich location is recorded as its primary location first, then the
+    // other ranges
+    bool rich;
+    std::vector<Location> locations;
+    const char *code;
+    std::string message;
+
+    void emit () const;
+  };
+
+  std::vector<Diagnostic> diagnostics;
+  size_t error_count;
+};
 } // namespace Rust
 
 // rust_debug uses normal printf formatting, not GCC diagnostic formatting.
+// The arguments are only evaluated when debug output is enabled, so passing
+// the as_string () of a deep type costs nothing otherwise.
 #define rust_debug(...) rust_debug_loc (Location (), __VA_ARGS__)
+#define rust_debug_loc(location, ...)                                          \
+  do                                                                           \
+    {                                                                          \
+      if (rust_be_debug_p ())                                                  \
+	rust_debug_emit (location, __VA_ARGS__);                               \
+    }                                                                          \
+  while (0)
 
 // rust_sorry_at wraps GCC diagnostic "sorry_at" to accept "Location" instead of
 // "location_t"
@@ -166,7 +247,7 @@ struct Error
   sorry_at (location.gcc_location (), __VA_ARGS__)
 
 void
-rust_debug_loc (const Location location, const char *fmt,
-		...) ATTRIBUTE_PRINTF_2;
+rust_debug_emit (const Location location, const char *fmt,
+		 ...) ATTRIBUTE_PRINTF_2;
 
 #endif // !defined(RUST_DIAGNOSTICS_H)
@@ -138,6 +138,8 @@ public:
 
   tree immutable_type (tree);
 
+  tree restrict_type (tree);
+
   tree function_type (const typed_identifier &,
 		      const std::vector<typed_identifier> &,
 		      const std::vector<typed_identifier> &, tree,
@@ -152,6 +154,8 @@ public:
 
   tree struct_type (const std::vector<typed_identifier> &);
 
+  tree reordered_struct_type (const std::vector<typed_identifier> &);
+
   tree union_type (const std::vector<typed_identifier> &);
 
   tree array_type (tree, tree);
@@ -300,6 +304,8 @@ public:
   bool function_set_parameters (tree function,
 				const std::vector<Bvariable *> &);
 
+  void write_function_definition (tree function);
+
   void write_global_definitions (const std::vector<tree> &,
 				 const std::vector<tree> &,
 				 const std::vector<tree> &,
@@ -310,11 +316,23 @@ public:
 private:
   tree fill_in_fields (tree, const std::vector<typed_identifier> &);
 
+  tree field_at_index (tree, size_t);
+
   tree fill_in_array (tree, tree, tree);
 
   tree non_zero_size_type (tree);
 
   tree convert_tree (tree, tree, Location);
+
+  // For the types made by reordered_struct_type whose fields did move: the
+  // first FIELD_DECL of the type -> the FIELD_DECLs in the order the fields
+  // were declared in, and the declaration index of each FIELD_DECL in order.
+  struct ReorderedFields
+  {
+    std::vector<tree> by_index;
+    std::vector<size_t> index_at;
+  };
+  std::map<tree, ReorderedFields> reordered_fields;
 };
 
 // A helper function to create a GCC identifier from a C++ string.
@@ -670,10 +688,35 @@ Gcc_backend::immutable_type (tree base)
 {
   if (base == error_mark_node)
     return error_mark_node;
-  tree constified = build_qualified_type (base, TYPE_QUAL_CONST);
+  tree constified
+    = build_qualified_type (base, TYPE_QUALS (base) | TYPE_QUAL_CONST);
   return constified;
 }
 
+// Get restrict qualified pointer type
+
+tree
+Gcc_backend::restrict_type (tree base)
+{
+  if (base == error_mark_node)
+    return error_mark_node;
+  gcc_assert (POINTER_TYPE_P (base));
+  return build_qualified_type (base, TYPE_QUALS (base) | TYPE_QUAL_RESTRICT);
+}
+
+// References are never null, tell the optimizers so when FNTYPE returns one.
+
+static tree
+mark_nonnull_result (tree fntype)
+{
+  if (TREE_CODE (TREE_TYPE (fntype)) != REFERENCE_TYPE)
+    return fntype;
+
+  tree attrs = tree_cons (get_identifier ("returns_nonnull"), NULL_TREE,
+			  TYPE_ATTRIBUTES (fntype));
+  return build_type_attribute_variant (fntype, attrs);
+}
+
 // Make a function type.
 
 tree
@@ -732,6 +775,7 @@ Gcc_backend::function_type (const typed_identifier &receiver,
   if (fntype == error_mark_node)
     return error_mark_node;
 
+  fntype = mark_nonnull_result (fntype);
   return build_pointer_type (fntype);
 }
 
@@ -788,6 +832,7 @@ Gcc_backend::function_type_varadic (
   if (fntype == error_mark_node)
     return error_mark_node;
 
+  fntype = mark_nonnull_result (fntype);
   return build_pointer_type (fntype);
 }
 
@@ -818,6 +863,7 @@ Gcc_backend::function_ptr_type (tree result_type,
   if (fntype == error_mark_node)
     return error_mark_node;
 
+  fntype = mark_nonnull_result (fntype);
   return build_pointer_type (fntype);
 }
 
@@ -829,6 +875,50 @@ Gcc_backend::struct_type (const std::vector<typed_identifier> &fields)
   return this->fill_in_fields (make_node (RECORD_TYPE), fields);
 }
 
+// Make a struct type with its fields sorted by decreasing alignment, which
+// leaves no padding between them.  The sort is stable so fields of the same
+// alignment keep their relative order.
+
+tree
+Gcc_backend::reordered_struct_type (const std::vector<typed_identifier> &fields)
+{
+  std::vector<size_t> order;
+  for (size_t i = 0; i < fields.size (); i++)
+    {
+      if (fields[i].type == error_mark_node)
+	return error_mark_node;
+      order.push_back (i);
+    }
+
+  std::stable_sort (order.begin (), order.end (), [&] (size_t a, size_t b) {
+    return TYPE_ALIGN (fields[a].type) > TYPE_ALIGN (fields[b].type);
+  });
+
+  bool moved = false;
+  std::vector<typed_identifier> sorted;
+  for (size_t i = 0; i < order.size (); i++)
+    {
+      moved = moved || order[i] != i;
+      sorted.push_back (fields[order[i]]);
+    }
+  if (!moved)
+    return struct_type (fields);
+
+  tree type = this->fill_in_fields (make_node (RECORD_TYPE), sorted);
+  if (type == error_mark_node)
+    return type;
+
+  ReorderedFields reordered;
+  reordered.by_index.resize (fields.size ());
+  reordered.index_at = order;
+  tree field = TYPE_FIELDS (type);
+  for (size_t i = 0; i < order.size (); i++, field = DECL_CHAIN (field))
+    reordered.by_index[order[i]] = field;
+
+  reordered_fields[TYPE_FIELDS (type)] = std::move (reordered);
+  return type;
+}
+
 // Make a union type.
 
 tree
@@ -870,6 +960,25 @@ Gcc_backend::fill_in_fields (tree fill,
   return fill;
 }
 
+// Return the FIELD_DECL of the field at INDEX of the struct or union TYPE, as
+// it was given to struct_type, reordered_struct_type or union_type.
+
+tree
+Gcc_backend::field_at_index (tree type, size_t index)
+{
+  tree field = TYPE_FIELDS (type);
+  auto it = reordered_fields.find (field);
+  if (it != reordered_fields.end ())
+    return it->second.by_index.at (index);
+
+  for (; index > 0; --index)
+    {
+      field = DECL_CHAIN (field);
+      gcc_assert (field != NULL_TREE);
+    }
+  return field;
+}
+
 // Make an array type.
 
 tree
@@ -987,12 +1096,7 @@ Gcc_backend::type_field_offset (tree struct_tree, size_t index)
   if (struct_tree == error_mark_node)
     return 0;
   gcc_assert (TREE_CODE (struct_tree) == RECORD_TYPE);
-  tree field = TYPE_FIELDS (struct_tree);
-  for (; index > 0; --index)
-    {
-      field = DECL_CHAIN (field);
-      gcc_assert (field != NULL_TREE);
-    }
+  tree field = field_at_index (struct_tree, index);
   HOST_WIDE_INT offset_wide = int_byte_position (field);
   int64_t ret = static_cast<int64_t> (offset_wide);
   gcc_assert (ret == offset_wide);
@@ -1082,7 +1186,7 @@ Gcc_backend::string_constant_expression (const std::string &val)
   tree const_char_type = build_qualified_type (char_type_node, TYPE_QUAL_CONST);
   tree string_type = build_array_type (const_char_type, index_type);
   TYPE_STRING_FLAG (string_type) = 1;
-  tree string_val = build_string (val.length (), val.data ());
+  tree string_val = build_string (val.length () + 1, val.c_str ());
   TREE_TYPE (string_val) = string_type;
 
   return string_val;
@@ -1198,6 +1302,25 @@ Gcc_backend::struct_field_expression (tree struct_tree, size_t index,
   if (struct_tree == error_mark_node
       || TREE_TYPE (struct_tree) == error_mark_node)
     return error_mark_node;
+
+  // the fields of a repr(simd) struct are the lanes of its vector, which we
+  // index like the C front end does for vector subscripts
+  tree type = TREE_TYPE (struct_tree);
+  if (TREE_CODE (type) == VECTOR_TYPE)
+    {
+      tree lane_type = TREE_TYPE (type);
+      tree array_type
+	= build_array_type_nelts (lane_type,
+				  TYPE_VECTOR_SUBPARTS (type).to_constant ());
+      tree array = build1_loc (location.gcc_location (), VIEW_CONVERT_EXPR,
+			       array_type, struct_tree);
+      tree ret = build4_loc (location.gcc_location (), ARRAY_REF, lane_type,
+			     array, size_int (index), NULL_TREE, NULL_TREE);
+      if (TREE_CONSTANT (struct_tree))
+	ret = fold (ret);
+      return ret;
+    }
+
   gcc_assert (TREE_CODE (TREE_TYPE (struct_tree)) == RECORD_TYPE
 	      || TREE_CODE (TREE_TYPE (struct_tree)) == UNION_TYPE);
   tree field = TYPE_FIELDS (TREE_TYPE (struct_tree));
@@ -1207,11 +1330,7 @@ Gcc_backend::struct_field_expression (tree struct_tree, size_t index,
       // and then turns out to be erroneous.
       return error_mark_node;
     }
-  for (unsigned int i = index; i > 0; --i)
-    {
-      field = DECL_CHAIN (field);
-      gcc_assert (field != NULL_TREE);
-    }
+  field = field_at_index (TREE_TYPE (struct_tree), index);
   if (TREE_TYPE (field) == error_mark_node)
     return error_mark_node;
   tree ret = fold_build3_loc (location.gcc_location (), COMPONENT_REF,
@@ -1445,6 +1564,38 @@ is_overflowing_expr (ArithmeticOrLogicalOperator op)
     }
 }
 
+// Return false if LEFT OP RIGHT is known not to overflow because both operands
+// are constants, true otherwise. The optimizers drop the checks they can prove
+// redundant from value ranges anyway, this keeps trivially safe ones from
+// being emitted in the first place at -O0.
+static bool
+constant_operation_may_overflow (ArithmeticOrLogicalOperator op, tree left,
+				 tree right)
+{
+  if (TREE_CODE (left) != INTEGER_CST || TREE_CODE (right) != INTEGER_CST
+      || TREE_TYPE (left) != TREE_TYPE (right))
+    return true;
+
+  signop sign = TYPE_SIGN (TREE_TYPE (left));
+  wi::overflow_type overflow = wi::OVF_NONE;
+  switch (op)
+    {
+    case ArithmeticOrLogicalOperator::ADD:
+      wi::add (wi::to_wide (left), wi::to_wide (right), sign, &overflow);
+      break;
+    case ArithmeticOrLogicalOperator::SUBTRACT:
+      wi::sub (wi::to_wide (left), wi::to_wide (right), sign, &overflow);
+      break;
+    case ArithmeticOrLogicalOperator::MULTIPLY:
+      wi::mul (wi::to_wide (left), wi::to_wide (right), sign, &overflow);
+      break;
+    default:
+      return true;
+    }
+
+  return overflow != wi::OVF_NONE;
+}
+
 static std::pair<tree, tree>
 fetch_overflow_builtins (ArithmeticOrLogicalOperator op)
 {
@@ -1476,10 +1627,6 @@ fetch_overflow_builtins (ArithmeticOrLogicalOperator op)
 
   // FIXME: ARTHUR: This is really ugly. The builtin context should take care of
   // that
-  TREE_SIDE_EFFECTS (abort) = 1;
-  TREE_READONLY (abort) = 0;
-
-  // FIXME: ARTHUR: Same here. Remove these!
   TREE_SIDE_EFFECTS (builtin) = 1;
   TREE_READONLY (builtin) = 0;
 
@@ -1500,10 +1647,12 @@ Gcc_backend::arithmetic_or_logical_expression_checked (
 
   auto loc = location.gcc_location ();
 
-  // FIXME: Add `if (!debug_mode)`
-  // No overflow checks for floating point operations or divisions. In that
-  // case, simply assign the result of the operation to the receiver variable
-  if (is_floating_point (left) || !is_overflowing_expr (op))
+  // No overflow checks for floating point operations or divisions, nor when
+  // both operands are constants whose result fits. In that case, simply
+  // assign the result of the operation to the receiver variable. Whether to
+  // check at all is up to the caller, see -frust-overflow-checks.
+  if (is_floating_point (left) || !is_overflowing_expr (op)
+      || !constant_operation_may_overflow (op, left, right))
     return assignment_statement (
       receiver_var->get_tree (location),
       arithmetic_or_logical_expression (op, left, right, location), location);
@@ -1516,12 +1665,10 @@ Gcc_backend::arithmetic_or_logical_expression_checked (
   auto abort = builtins.first;
   auto builtin = builtins.second;
 
+  // abort is cold and noreturn, so the overflow branch is predicted not
+  // taken and its call goes to the unlikely section
   auto abort_call = build_call_expr_loc (loc, abort, 0);
 
-  // FIXME: ARTHUR: Is that needed?
-  TREE_SIDE_EFFECTS (abort_call) = 1;
-  TREE_READONLY (abort_call) = 0;
-
   auto builtin_call
     = build_call_expr_loc (loc, builtin, 3, left, right, result_ref);
   auto overflow_check
@@ -1596,6 +1743,36 @@ Gcc_backend::constructor_expression (tree type_tree, bool is_variant,
   bool is_constant = true;
   tree field = TYPE_FIELDS (type_tree);
 
+  if (TREE_CODE (type_tree) == VECTOR_TYPE)
+    {
+      // a repr(simd) struct, one value per lane
+      gcc_assert (!is_variant && union_index == -1);
+      gcc_assert (known_eq (TYPE_VECTOR_SUBPARTS (type_tree), vals.size ()));
+
+      tree lane_type = TREE_TYPE (type_tree);
+      bool all_literals = true;
+      for (auto &val : vals)
+	{
+	  if (val == error_mark_node || TREE_TYPE (val) == error_mark_node)
+	    return error_mark_node;
+
+	  tree lane = this->convert_tree (lane_type, val, location);
+	  CONSTRUCTOR_APPEND_ELT (init, NULL_TREE, lane);
+	  if (!TREE_CONSTANT (lane))
+	    is_constant = false;
+	  if (!CONSTANT_CLASS_P (lane))
+	    all_literals = false;
+	}
+
+      if (all_literals)
+	return build_vector_from_ctor (type_tree, init);
+
+      tree ret = build_constructor (type_tree, init);
+      if (is_constant)
+	TREE_CONSTANT (ret) = 1;
+      return ret;
+    }
+
   if (is_variant)
     {
       gcc_assert (union_index != -1);
@@ -1656,8 +1833,30 @@ Gcc_backend::constructor_expression (tree type_tree, bool is_variant,
       else
 	{
 	  gcc_assert (TREE_CODE (type_tree) == RECORD_TYPE);
-	  for (std::vector<tree>::const_iterator p = vals.begin ();
-	       p != vals.end (); ++p, field = DECL_CHAIN (field))
+
+	  // the elements have to follow the fields in memory, but the
+	  // values are still evaluated in the order they were given
+	  std::vector<tree> ordered_vals (vals);
+	  auto reordered = reordered_fields.find (field);
+	  if (reordered != reordered_fields.end ())
+	    {
+	      for (auto &val : ordered_vals)
+		if (TREE_SIDE_EFFECTS (val))
+		  {
+		    val = save_expr (val);
+		    append_to_statement_list (val, &sink);
+		  }
+
+	      std::vector<size_t> &index_at = reordered->second.index_at;
+	      gcc_assert (index_at.size () == vals.size ());
+
+	      std::vector<tree> given (ordered_vals);
+	      for (size_t i = 0; i < index_at.size (); i++)
+		ordered_vals[i] = given[index_at[i]];
+	    }
+
+	  for (std::vector<tree>::const_iterator p = ordered_vals.begin ();
+	       p != ordered_vals.end (); ++p, field = DECL_CHAIN (field))
 	    {
 	      gcc_assert (field != NULL_TREE);
 	      tree val = (*p);
@@ -1750,6 +1949,36 @@ Gcc_backend::array_constructor_expression (
   return ret;
 }
 
+// Return true if every byte of the constant VALUE, an element of type
+// ELEM_TYPE, is the same and store it in *BYTE.
+
+static bool
+constant_byte_pattern (tree value, tree elem_type, unsigned char *byte)
+{
+  if (initializer_zerop (value))
+    {
+      *byte = 0;
+      return true;
+    }
+
+  if (!CONSTANT_CLASS_P (value)
+      || int_size_in_bytes (TREE_TYPE (value)) != int_size_in_bytes (elem_type))
+    return false;
+
+  unsigned char buffer[16];
+  HOST_WIDE_INT size = int_size_in_bytes (elem_type);
+  if (size <= 0 || size > (HOST_WIDE_INT) sizeof buffer
+      || native_encode_expr (value, buffer, size) != size)
+    return false;
+
+  for (HOST_WIDE_INT i = 1; i < size; i++)
+    if (buffer[i] != buffer[0])
+      return false;
+
+  *byte = buffer[0];
+  return true;
+}
+
 // Build insns to create an array, initialize all elements of the array to
 // value, and return it
 tree
@@ -1765,6 +1994,41 @@ Gcc_backend::array_initializer (tree fndecl, tree block, tree array_type,
 						   NULL_TREE, true, locus, &t);
   tree arr = tmp_array->get_tree (locus);
   stmts.push_back (t);
+  *tmp = arr;
+
+  // A value whose bytes are all the same, zero above all, is a memset of the
+  // whole array rather than a loop:
+  //   memset (&arr, byte, length * sizeof (elem));
+  unsigned char byte;
+  if (constant_byte_pattern (value, TREE_TYPE (array_type), &byte))
+    {
+      auto &builtins = Rust::Compile::BuiltinsContext::get ();
+      tree memset_fn = NULL_TREE;
+      builtins.lookup_simple_builtin ("memset", &memset_fn);
+      rust_assert (memset_fn);
+
+      tree size
+	= fold_build2_loc (locus.gcc_location (), MULT_EXPR, size_type_node,
+			   fold_convert (size_type_node, length),
+			   TYPE_SIZE_UNIT (TREE_TYPE (array_type)));
+      tree call
+	= build_call_expr_loc (locus.gcc_location (), memset_fn, 3,
+			       build_fold_addr_expr_loc (locus.gcc_location (),
+							 arr),
+			       build_int_cst (integer_type_node, byte), size);
+      stmts.push_back (call);
+      return this->statement_list (stmts);
+    }
+
+  // The value is evaluated once, not once per element.
+  if (TREE_SIDE_EFFECTS (value))
+    {
+      Bvariable *tmp_value
+	= this->temporary_variable (fndecl, block, TREE_TYPE (array_type),
+				    value, false, locus, &t);
+      value = tmp_value->get_tree (locus);
+      stmts.push_back (t);
+    }
 
   // Temporary for the array length used for initialization loop guard.
   Bvariable *tmp_len = this->temporary_variable (fndecl, block, size_type_node,
@@ -1815,9 +2079,8 @@ Gcc_backend::array_initializer (tree fndecl, tree block, tree array_type,
   tree loop_body = this->statement_list (loop_stmts);
   stmts.push_back (this->loop_expression (loop_body, locus));
 
-  // Return the temporary in the provided pointer and the statement list which
-  // initializes it.
-  *tmp = tmp_array->get_tree (locus);
+  // The temporary was returned in the provided pointer, return the statement
+  // list which initializes it.
   return this->statement_list (stmts);
 }
 
@@ -2087,7 +2350,9 @@ Gcc_backend::exception_handler_statement (tree try_stmt, tree except_stmt,
       || finally_stmt == error_mark_node)
     return error_mark_node;
 
-  if (except_stmt != NULL_TREE)
+  // with -frust-panic=abort there is nothing to catch, and without
+  // exceptions the finally block is only run on leaving the try block
+  if (except_stmt != NULL_TREE && flag_rust_panic != 1)
     try_stmt = build2_loc (location.gcc_location (), TRY_CATCH_EXPR,
 			   void_type_node, try_stmt,
 			   build2_loc (location.gcc_location (), CATCH_EXPR,
@@ -2331,7 +2596,8 @@ Gcc_backend::convert_tree (tree type_tree, tree expr_tree, Location location)
     return fold_convert_loc (location.gcc_location (), type_tree, expr_tree);
   else if (TREE_CODE (type_tree) == RECORD_TYPE
 	   || TREE_CODE (type_tree) == UNION_TYPE
-	   || TREE_CODE (type_tree) == ARRAY_TYPE)
+	   || TREE_CODE (type_tree) == ARRAY_TYPE
+	   || TREE_CODE (type_tree) == VECTOR_TYPE)
     {
       gcc_assert (int_size_in_bytes (type_tree)
 		  == int_size_in_bytes (TREE_TYPE (expr_tree)));
@@ -2388,14 +2654,15 @@ Gcc_backend::global_variable (const std::string &var_name,
   return new Bvariable (decl, orig_type_tree);
 }
 
-// Set the initial value of a global variable.
+// Set the initial value of a global variable, which has to be a valid static
+// initializer: there is no run time initialization of globals.
 
 void
 Gcc_backend::global_variable_set_init (Bvariable *var, tree expr_tree)
 {
   if (expr_tree == error_mark_node)
     return;
-  gcc_assert (TREE_CONSTANT (expr_tree));
+  gcc_assert (initializer_constant_valid_p (expr_tree, TREE_TYPE (expr_tree)));
   tree var_decl = var->get_decl ();
   if (var_decl == error_mark_node)
     return;
@@ -2648,6 +2915,11 @@ Gcc_backend::function (tree functype, const std::string &name,
   if ((flags & function_in_unique_section) != 0)
     resolve_unique_section (decl, 0, 1);
 
+  // with -frust-panic=abort no Rust function, nor any foreign one as there is
+  // no "C-unwind" ABI, may unwind into its caller
+  if (flag_rust_panic == 1)
+    TREE_NOTHROW (decl) = 1;
+
   rust_preserve_from_gc (decl);
   return decl;
 }
@@ -2665,6 +2937,10 @@ Gcc_backend::function_defer_statement (tree function, tree undefer_tree,
       || function == error_mark_node)
     return error_mark_node;
 
+  // the deferred calls only run here when unwinding
+  if (flag_rust_panic == 1)
+    return undefer_tree;
+
   if (DECL_STRUCT_FUNCTION (function) == NULL)
     push_struct_function (function);
   else
@@ -2715,6 +2991,19 @@ Gcc_backend::function_set_parameters (
 // FUNCTION_DECLS, and VARIABLE_DECLS declared globally, as well as
 // emit early debugging information.
 
+void
+Gcc_backend::write_function_definition (tree decl)
+{
+  if (decl == error_mark_node)
+    return;
+
+  rust_preserve_from_gc (decl);
+  if (DECL_STRUCT_FUNCTION (decl) == NULL)
+    allocate_struct_function (decl, false);
+  dump_function (TDI_original, decl);
+  cgraph_node::finalize_function (decl, true);
+}
+
 void
 Gcc_backend::write_global_definitions (
   const std::vector<tree> &type_decls, const std::vector<tree> &constant_decls,
@@ -2768,11 +3057,7 @@ Gcc_backend::write_global_definitions (
       tree decl = (*p);
       if (decl != error_mark_node)
 	{
-	  rust_preserve_from_gc (decl);
-	  if (DECL_STRUCT_FUNCTION (decl) == NULL)
-	    allocate_struct_function (decl, false);
-	  dump_function (TDI_original, decl);
-	  cgraph_node::finalize_function (decl, true);
+	  write_function_definition (decl);
 
 	  defs[i] = decl;
 	  ++i;
@@ -38,6 +38,8 @@
 #include "rust-privacy-ctx.h"
 #include "rust-ast-resolve-item.h"
 #include "rust-optional.h"
+#include "rust-bench.h"
+#include "rust-export-metadata.h"
 
 #include <mpfr.h>
 // note: header files must be in this order or else forward declarations don't
@@ -65,6 +67,7 @@
 
 #include "rust-system.h"
 #include "rust-session-manager.h"
+#include "rust-builtins.h"
 
 // Language-dependent contents of a type. GTY() mark used for garbage collector.
 struct GTY (()) lang_type
@@ -136,7 +139,10 @@ grs_langhook_init (void)
 
   mpfr_set_default_prec (128);
 
-  using_eh_for_cleanups ();
+  // with -frust-panic=abort nothing unwinds, so cleanups only ever run on the
+  // normal paths
+  if (flag_rust_panic != 1)
+    using_eh_for_cleanups ();
 
   // initialise compiler session
   Rust::Session::get_instance ().init ();
@@ -180,6 +186,13 @@ grs_langhook_parse_file (void)
   Rust::Session::get_instance ().handle_input_files (num_in_fnames, in_fnames);
 }
 
+/* Language-specific end of compilation, run after the middle-end. */
+static void
+grs_langhook_finish (void)
+{
+  Rust::Session::get_instance ().finish ();
+}
+
 /* Seems to get the exact type for a specific type - e.g. for scalar float with
  * 32-bit bitsize, it returns float, and for 64-bit bitsize, it returns double.
  * Used to map RTL nodes to machine modes or something like that. */
@@ -235,10 +248,13 @@ grs_langhook_type_for_mode (machine_mode mode, int unsignedp)
   return NULL;
 }
 
-// Record a builtin function. We just ignore builtin functions.
+// Record a builtin function. We only keep track of the target builtins, the
+// generic ones are set up by BuiltinsContext itself.
 static tree
-grs_langhook_builtin_function (tree decl ATTRIBUTE_UNUSED)
+grs_langhook_builtin_function (tree decl)
 {
+  if (DECL_BUILT_IN_CLASS (decl) == BUILT_IN_MD)
+    Rust::Compile::BuiltinsContext::get ().register_target_builtin (decl);
   return decl;
 }
 
@@ -301,6 +317,16 @@ grs_langhook_post_options (const char **pfilename ATTRIBUTE_UNUSED)
   if (flag_excess_precision /*_cmdline*/ == EXCESS_PRECISION_DEFAULT)
     flag_excess_precision /*_cmdline*/ = EXCESS_PRECISION_STANDARD;
 
+  // -frust-panic=abort, as rustc's -C panic=abort: no EH tables or landing
+  // pads are generated
+  if (flag_rust_panic == 1)
+    flag_exceptions = 0;
+
+  // the driver turns -frust-codegen-units= into the LTO options doing the
+  // partitioning, there is nothing to split without them
+  if (flag_rust_codegen_units > 1 && flag_lto == NULL)
+    warning (0, "%<-frust-codegen-units=%> has no effect without %<-flto%>");
+
   /* Returning false means that the backend should be used.  */
   return false;
 }
@@ -319,16 +345,14 @@ grs_langhook_gimplify_expr (tree *expr_p ATTRIBUTE_UNUSED,
   return GS_UNHANDLED;
 }
 
+static GTY (()) tree rust_personality_decl;
+
 static tree
 grs_langhook_eh_personality (void)
 {
-  static tree personality_decl;
-  if (personality_decl == NULL_TREE)
-    {
-      personality_decl = build_personality_function ("gccrs");
-      rust_preserve_from_gc (personality_decl);
-    }
-  return personality_decl;
+  if (rust_personality_decl == NULL_TREE)
+    rust_personality_decl = build_personality_function ("gccrs");
+  return rust_personality_decl;
 }
 
 tree
@@ -364,15 +388,30 @@ convert (tree type, tree expr)
   gcc_unreachable ();
 }
 
-/* FIXME: This is a hack to preserve trees that we create from the
-   garbage collector.  */
+/* The trees built by the backend are referenced from the compile context
+   only, which the garbage collector does not see. They are kept alive here
+   until the finished definitions have been handed over to cgraph and
+   varpool.  */
 
-static GTY (()) tree rust_gc_root;
+static GTY (()) vec<tree, va_gc> *rust_gc_roots;
 
 void
 rust_preserve_from_gc (tree t)
 {
-  rust_gc_root = tree_cons (NULL_TREE, t, rust_gc_root);
+  vec_safe_push (rust_gc_roots, t);
+}
+
+size_t
+rust_gc_roots_mark ()
+{
+  return vec_safe_length (rust_gc_roots);
+}
+
+void
+rust_release_gc_roots (size_t mark)
+{
+  if (mark < vec_safe_length (rust_gc_roots))
+    rust_gc_roots->truncate (mark);
 }
 
 /* Convert an identifier for use in an error message.  */
@@ -394,8 +433,10 @@ rust_localize_identifier (const char *ident)
 #undef LANG_HOOKS_HANDLE_OPTION
 #undef LANG_HOOKS_POST_OPTIONS
 #undef LANG_HOOKS_PARSE_FILE
+#undef LANG_HOOKS_FINISH
 #undef LANG_HOOKS_TYPE_FOR_MODE
 #undef LANG_HOOKS_BUILTIN_FUNCTION
+#undef LANG_HOOKS_BUILTIN_FUNCTION_EXT_SCOPE
 #undef LANG_HOOKS_GLOBAL_BINDINGS_P
 #undef LANG_HOOKS_PUSHDECL
 #undef LANG_HOOKS_GETDECLS
@@ -415,8 +456,10 @@ rust_localize_identifier (const char *ident)
  * This hook must create a complete parse tree in a global var, and then return.
  */
 #define LANG_HOOKS_PARSE_FILE grs_langhook_parse_file
+#define LANG_HOOKS_FINISH grs_langhook_finish
 #define LANG_HOOKS_TYPE_FOR_MODE grs_langhook_type_for_mode
 #define LANG_HOOKS_BUILTIN_FUNCTION grs_langhook_builtin_function
+#define LANG_HOOKS_BUILTIN_FUNCTION_EXT_SCOPE grs_langhook_builtin_function
 #define LANG_HOOKS_GLOBAL_BINDINGS_P grs_langhook_global_bindings_p
 #define LANG_HOOKS_PUSHDECL grs_langhook_pushdecl
 #define LANG_HOOKS_GETDECLS grs_langhook_getdecls
@@ -439,6 +482,8 @@ run_rust_tests ()
   rust_crate_name_validation_test ();
   rust_simple_path_resolve_test ();
   rust_optional_test ();
+  rust_bench_test ();
+  rust_export_metadata_test ();
 }
 } // namespace selftest
 
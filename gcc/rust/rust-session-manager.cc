@@ -27,22 +27,30 @@
 #include "rust-hir-type-check.h"
 #include "rust-privacy-check.h"
 #include "rust-const-checker.h"
+#include "rust-match-checker.h"
+#include "rust-item-pass-manager.h"
 #include "rust-tycheck-dump.h"
 #include "rust-compile.h"
+#include "rust-constexpr.h"
 #include "rust-cfg-parser.h"
 #include "rust-lint-scan-deadcode.h"
 #include "rust-lint-unused-var.h"
 #include "rust-hir-dump.h"
+#include "rust-hir-simplify.h"
 #include "rust-ast-dump.h"
 #include "rust-export-metadata.h"
 #include "rust-imports.h"
 #include "rust-extern-crate.h"
 #include "rust-attributes.h"
+#include "rust-trace.h"
 
 #include "diagnostic.h"
+#include "ggc.h"
 #include "input.h"
 #include "selftest.h"
 #include "target.h"
+#include "timevar.h"
+#include "version.h"
 
 extern bool
 saw_errors (void);
@@ -64,6 +72,18 @@ const char *kHIRDumpFile = "gccrs.hir.dump";
 const char *kHIRPrettyDumpFile = "gccrs.hir-pretty.dump";
 const char *kHIRTypeResolutionDumpFile = "gccrs.type-resolution.dump";
 const char *kTargetOptionsDumpFile = "gccrs.target-options.dump";
+const char *kMacroCacheDumpFile = "gccrs.macro-cache.dump";
+const char *kTypeCacheDumpFile = "gccrs.type-cache.dump";
+const char *kMonoDumpFile = "gccrs.mono.dump";
+const char *kConstEvalDumpFile = "gccrs.const-eval.dump";
+const char *kUnifyStatsDumpFile = "gccrs.unify-stats.dump";
+const char *kMemDumpFile = "gccrs.mem.dump";
+const char *kTypeSizesDumpFile = "gccrs.type-sizes.dump";
+const char *kMacroStatsDumpFile = "gccrs.macro-stats.dump";
+
+// how many of the most expensive constant items the const-eval dump reports
+const size_t kConstEvalDumpTop = 20;
+const size_t kMacroStatsDumpTop = 20;
 
 const std::string kDefaultCrateName = "rust_out";
 const size_t kMaxNameLength = 64;
@@ -140,6 +160,9 @@ Session::init ()
   options.target_data.insert_key_value_pair ("target_endian", BYTES_BIG_ENDIAN
 								? "big"
 								: "little");
+  options.target_data.insert_key_value_pair ("panic", flag_rust_panic == 1
+							 ? "abort"
+							 : "unwind");
 
   // setup singleton linemap
   linemap = rust_get_linemap ();
@@ -151,6 +174,53 @@ Session::init ()
   mappings = Analysis::Mappings::get ();
 }
 
+/* Quote the characters of NAME which are significant to Make as the C front
+ * end does: spaces, tabs and '#' get a backslash, doubling the backslashes
+ * before spaces and tabs, and '$' becomes "$$".  A target, as given to -MQ,
+ * also has its colons escaped. */
+static std::string
+quote_make_name (const char *name, bool is_target)
+{
+  std::string quoted;
+  unsigned slashes = 0;
+  for (const char *p = name; *p != '\0'; p++)
+    {
+      switch (*p)
+	{
+	case '\\':
+	  slashes++;
+	  quoted += *p;
+	  continue;
+
+	case ' ':
+	case '\t':
+	  quoted.append (slashes + 1, '\\');
+	  break;
+
+	case '$':
+	  quoted += '$';
+	  break;
+
+	case ':':
+	  if (is_target)
+	    quoted += '\\';
+	  break;
+
+	case '#':
+	  quoted += '\\';
+	  break;
+
+	default:
+	  break;
+	}
+
+      slashes = 0;
+      quoted += *p;
+    }
+
+  return quoted;
+}
+
 /* Initialise default options. Actually called before handle_option, unlike init
  * itself. */
 void
@@ -226,10 +296,48 @@ Session::handle_option (
     case OPT_frust_compile_until_:
       options.set_compile_step (flag_rust_compile_until);
       break;
+    case OPT_frust_check_bodies_in_:
+      options.set_check_bodies_file (arg);
+      break;
     case OPT_frust_metadata_output_:
       options.set_metadata_output (arg);
       break;
 
+    case OPT_frust_metadata_ready_:
+      options.set_metadata_ready (arg);
+      break;
+
+    case OPT_frust_metadata_cache_:
+      options.set_metadata_cache_dir (arg);
+      break;
+
+    case OPT_M:
+    case OPT_MM:
+      options.deps_enabled = true;
+      break;
+
+    case OPT_MD:
+    case OPT_MMD:
+      options.deps_enabled = true;
+      options.deps_filename = arg;
+      break;
+
+    case OPT_MF:
+      options.deps_filename_user = arg;
+      break;
+
+    case OPT_MP:
+      options.deps_phony = true;
+      break;
+
+    case OPT_MQ:
+      options.deps_targets.push_back (quote_make_name (arg, true));
+      break;
+
+    case OPT_MT:
+      options.deps_targets.push_back (arg);
+      break;
+
     default:
       break;
     }
@@ -321,6 +429,38 @@ Session::enable_dump (std::string arg)
     {
       options.enable_dump_option (CompileOptions::HIR_DUMP_PRETTY);
     }
+  else if (arg == "macro-cache")
+    {
+      options.enable_dump_option (CompileOptions::MACRO_CACHE_DUMP);
+    }
+  else if (arg == "type-cache")
+    {
+      options.enable_dump_option (CompileOptions::TYPE_CACHE_DUMP);
+    }
+  else if (arg == "mono")
+    {
+      options.enable_dump_option (CompileOptions::MONO_DUMP);
+    }
+  else if (arg == "const-eval")
+    {
+      options.enable_dump_option (CompileOptions::CONST_EVAL_DUMP);
+    }
+  else if (arg == "unify-stats")
+    {
+      options.enable_dump_option (CompileOptions::UNIFY_STATS_DUMP);
+    }
+  else if (arg == "mem")
+    {
+      options.enable_dump_option (CompileOptions::MEM_DUMP);
+    }
+  else if (arg == "type-sizes")
+    {
+      options.enable_dump_option (CompileOptions::TYPE_SIZES_DUMP);
+    }
+  else if (arg == "macro-stats")
+    {
+      options.enable_dump_option (CompileOptions::MACRO_STATS_DUMP);
+    }
   else
     {
       rust_error_at (
@@ -362,7 +502,18 @@ Session::handle_input_files (int num_files, const char **files)
   mappings->set_current_crate (crate_num);
 
   rust_debug ("Attempting to parse file: %s", file);
+  add_dependency (file);
+  if (flag_rust_trace)
+    Trace::start ();
   compile_crate (file);
+  if (flag_rust_trace)
+    Trace::finish (flag_rust_trace);
+
+  if (options.deps_enabled && !saw_errors ())
+    write_dependencies (file);
+
+  if (options.dump_option_enabled (CompileOptions::MEM_DUMP))
+    dump_mem ();
 }
 
 void
@@ -436,7 +587,13 @@ Session::compile_crate (const char *filename)
   Parser<Lexer> parser (lex);
 
   // generate crate from parser
-  std::unique_ptr<AST::Crate> ast_crate = parser.parse_crate ();
+  std::unique_ptr<AST::Crate> ast_crate;
+  {
+    auto_timevar tv (TV_RUST_PARSE);
+    TraceScope trace ("pipeline", "parse");
+    ast_crate = parser.parse_crate ();
+  }
+  record_memory ("parse");
 
   // handle crate name
   handle_crate_name (*ast_crate.get ());
@@ -488,16 +645,22 @@ Session::compile_crate (const char *filename)
   if (flag_syntax_only || last_step == CompileOptions::CompileStep::Ast)
     return;
 
-  // register plugins pipeline stage
-  register_plugins (parsed_crate);
-  rust_debug ("\033[0;31mSUCCESSFULLY REGISTERED PLUGINS \033[0m");
-  if (options.dump_option_enabled (CompileOptions::REGISTER_PLUGINS_DUMP))
-    {
-      // TODO: what do I dump here?
-    }
+  {
+    auto_timevar tv (TV_RUST_INJECTION);
+    TraceScope trace ("pipeline", "injection");
 
-  // injection pipeline stage
-  injection (parsed_crate);
+    // register plugins pipeline stage
+    register_plugins (parsed_crate);
+    rust_debug ("\033[0;31mSUCCESSFULLY REGISTERED PLUGINS \033[0m");
+    if (options.dump_option_enabled (CompileOptions::REGISTER_PLUGINS_DUMP))
+      {
+	// TODO: what do I dump here?
+      }
+
+    // injection pipeline stage
+    injection (parsed_crate);
+  }
+  record_memory ("injection");
   rust_debug ("\033[0;31mSUCCESSFULLY FINISHED INJECTION \033[0m");
   if (options.dump_option_enabled (CompileOptions::INJECTION_DUMP))
     {
@@ -507,13 +670,30 @@ Session::compile_crate (const char *filename)
   if (last_step == CompileOptions::CompileStep::AttributeCheck)
     return;
 
-  Analysis::AttributeChecker ().go (parsed_crate);
+  {
+    auto_timevar tv (TV_RUST_ATTRIBUTE_CHECK);
+    TraceScope trace ("pipeline", "attribute check");
+    Analysis::AttributeChecker ().go (parsed_crate);
+  }
 
   if (last_step == CompileOptions::CompileStep::Expansion)
     return;
 
+  prefetch_extern_crates (parsed_crate);
+
   // expansion pipeline stage
-  expansion (parsed_crate);
+  {
+    auto_timevar tv (TV_RUST_EXPANSION);
+    TraceScope trace ("pipeline", "expansion");
+    expansion (parsed_crate);
+  }
+
+  // the prefetched crates expansion did not reach were stripped by cfg
+  for (auto &prefetched : prefetched_extern_crates)
+    delete prefetched.second;
+  prefetched_extern_crates.clear ();
+
+  record_memory ("expansion");
   rust_debug ("\033[0;31mSUCCESSFULLY FINISHED EXPANSION \033[0m");
   if (options.dump_option_enabled (CompileOptions::EXPANSION_DUMP))
     {
@@ -527,8 +707,16 @@ Session::compile_crate (const char *filename)
   if (last_step == CompileOptions::CompileStep::NameResolution)
     return;
 
+  // extern crates are only resolved once we know what this crate uses
+  resolve_extern_crates ();
+
   // resolution pipeline stage
-  Resolver::NameResolution::Resolve (parsed_crate);
+  {
+    auto_timevar tv (TV_RUST_NAME_RESOLUTION);
+    TraceScope trace ("pipeline", "name resolution");
+    Resolver::NameResolution::Resolve (parsed_crate);
+  }
+  record_memory ("name resolution");
   if (options.dump_option_enabled (CompileOptions::RESOLUTION_DUMP))
     {
       // TODO: what do I dump here? resolved names? AST with resolved names?
@@ -541,13 +729,25 @@ Session::compile_crate (const char *filename)
     return;
 
   // lower AST to HIR
-  std::unique_ptr<HIR::Crate> lowered
-    = HIR::ASTLowering::Resolve (parsed_crate);
+  std::unique_ptr<HIR::Crate> lowered;
+  {
+    auto_timevar tv (TV_RUST_LOWERING);
+    TraceScope trace ("pipeline", "lowering");
+    lowered = HIR::ASTLowering::Resolve (parsed_crate);
+  }
   if (saw_errors ())
     return;
 
   // add the mappings to it
   HIR::Crate &hir = mappings->insert_hir_crate (std::move (lowered));
+
+  // metadata is printed from the AST of the exported items, snapshot it so
+  // the AST can be released now that everything has been lowered
+  std::vector<Metadata::MetadataItem> exported_items
+    = Metadata::PublicInterface::Gather (hir);
+  mappings->release_ast_crates ();
+  record_memory ("lowering");
+
   if (options.dump_option_enabled (CompileOptions::HIR_DUMP))
     {
       dump_hir (hir);
@@ -561,11 +761,29 @@ Session::compile_crate (const char *filename)
     return;
 
   // type resolve
-  Resolver::TypeResolution::Resolve (hir);
+  TyTy::set_unify_profiling (
+    options.dump_option_enabled (CompileOptions::UNIFY_STATS_DUMP));
+  {
+    auto_timevar tv (TV_RUST_TYPE_CHECK);
+    TraceScope trace ("pipeline", "type check");
+    // the later passes need every body, so they can only be skipped when
+    // nothing runs after type checking
+    if (options.check_bodies_file_set ()
+	&& last_step == CompileOptions::CompileStep::Privacy)
+      Resolver::TypeCheckContext::get ()->restrict_bodies_to (
+	options.get_check_bodies_file ());
+    check_extern_crate_bodies ();
+    Resolver::TypeResolution::Resolve (hir);
+  }
+  record_memory ("type check");
+  if (options.dump_option_enabled (CompileOptions::UNIFY_STATS_DUMP))
+    dump_unify_stats ();
   if (options.dump_option_enabled (CompileOptions::TYPE_RESOLUTION_DUMP))
     {
       dump_type_resolution (hir);
     }
+  if (flag_rust_drop_inference_locations)
+    mappings->release_inference_locations ();
 
   if (saw_errors ())
     return;
@@ -574,19 +792,46 @@ Session::compile_crate (const char *filename)
     return;
 
   // Various HIR error passes. The privacy pass happens before the unsafe checks
-  Privacy::Resolver::resolve (hir);
+  {
+    auto_timevar tv (TV_RUST_PRIVACY);
+    TraceScope trace ("pipeline", "privacy");
+    Privacy::Resolver::resolve (hir);
+  }
+  record_memory ("privacy");
   if (saw_errors ())
     return;
 
   if (last_step == CompileOptions::CompileStep::Unsafety)
     return;
 
-  HIR::UnsafeChecker ().go (hir);
+  // the unsafe and const checks look at every item on its own, so they share
+  // a single walk over the crate
+  {
+    HIR::UnsafeChecker unsafe_checker;
+    HIR::ConstChecker const_checker;
+
+    HIR::ItemPassManager checks;
+    TraceScope trace ("pipeline", "unsafe and const checks");
+    checks.add_pass (TV_RUST_UNSAFE, [&] (HIR::Item &item) {
+      unsafe_checker.check (item);
+    });
+    if (last_step != CompileOptions::CompileStep::Const)
+      checks.add_pass (TV_RUST_CONST, [&] (HIR::Item &item) {
+	const_checker.check (item);
+      });
+    checks.run (hir);
+  }
+  record_memory ("unsafe and const checks");
 
   if (last_step == CompileOptions::CompileStep::Const)
     return;
 
-  HIR::ConstChecker ().go (hir);
+  {
+    auto_timevar tv (TV_RUST_MATCH);
+    TraceScope trace ("pipeline", "match checking");
+    HIR::MatchChecker::go ();
+  }
+  record_memory ("match checking");
 
   if (saw_errors ())
     return;
@@ -594,37 +839,93 @@ Session::compile_crate (const char *filename)
   if (last_step == CompileOptions::CompileStep::Compilation)
     return;
 
+  // dependent crates only need the interface, so they can start building
+  // while this one is compiled. The instances shared by codegen are left out
+  // and get instantiated again downstream.
+  if (flag_rust_emit_metadata_early)
+    {
+      auto_timevar tv (TV_RUST_METADATA);
+      TraceScope trace ("pipeline", "early metadata");
+      write_metadata_file (exported_items);
+      if (saw_errors ())
+	return;
+    }
+
+  {
+    auto_timevar tv (TV_RUST_SIMPLIFY);
+    TraceScope trace ("pipeline", "simplification");
+    HIR::Simplifier::simplify (hir);
+  }
+  record_memory ("simplification");
+
+  // the target builtins, thousands of decls on some targets, are only bound
+  // to from codegen on, so runs stopping before it don't declare them
+  targetm.init_builtins ();
+
   // do compile to gcc generic
   Compile::Context ctx (backend);
-  Compile::CompileCrate::Compile (hir, &ctx);
+  Compile::set_const_eval_profiling (
+    options.dump_option_enabled (CompileOptions::CONST_EVAL_DUMP));
+  {
+    auto_timevar tv (TV_RUST_COMPILE);
+    TraceScope trace ("pipeline", "compilation");
+    Compile::CompileCrate::Compile (hir, &ctx);
+  }
+  record_memory ("compilation", &ctx);
+  if (options.dump_option_enabled (CompileOptions::TYPE_CACHE_DUMP))
+    dump_type_cache (ctx);
+  if (options.dump_option_enabled (CompileOptions::MONO_DUMP))
+    dump_mono (ctx);
+  if (options.dump_option_enabled (CompileOptions::TYPE_SIZES_DUMP))
+    dump_type_sizes (ctx);
+  if (options.dump_option_enabled (CompileOptions::CONST_EVAL_DUMP))
+    dump_const_eval ();
 
   // we can't do static analysis if there are errors to worry about
   if (!saw_errors ())
     {
       // lints
-      Analysis::ScanDeadcode::Scan (hir);
-      Analysis::UnusedVariables::Lint (ctx);
+      {
+	auto_timevar tv (TV_RUST_LINTS);
+	TraceScope trace ("pipeline", "lints");
+	if (warn_dead_code)
+	  Analysis::ScanDeadcode::Scan (hir);
+	Analysis::UnusedVariables::Lint (ctx);
+      }
 
       // metadata
-      bool specified_emit_metadata
-	= flag_rust_embed_metadata || options.metadata_output_path_set ();
-      if (!specified_emit_metadata)
-	{
-	  Metadata::PublicInterface::ExportTo (
-	    hir, Metadata::PublicInterface::expected_metadata_filename ());
-	}
-      else
+      auto_timevar tv (TV_RUST_METADATA);
+      TraceScope trace ("pipeline", "metadata");
+      for (const auto &symbol : ctx.get_shared_instances ())
+	exported_items.push_back (
+	  {Metadata::MetadataItemKind::GENERIC_INSTANCE, symbol, ""});
+
+      if (flag_rust_embed_metadata)
+	Metadata::PublicInterface::Export (exported_items);
+      if (!flag_rust_emit_metadata_early)
+	write_metadata_file (exported_items);
+
+      if (flag_rust_print_interface_hash)
 	{
-	  if (flag_rust_embed_metadata)
-	    Metadata::PublicInterface::Export (hir);
-	  if (options.metadata_output_path_set ())
-	    Metadata::PublicInterface::ExportTo (
-	      hir, options.get_metadata_output ());
+	  std::string hash
+	    = Metadata::PublicInterface::InterfaceHash (exported_items);
+	  for (unsigned char c : hash)
+	    fprintf (stdout, "%02x", c);
+	  fprintf (stdout, "\n");
 	}
     }
 
   // pass to GCC middle-end
-  ctx.write_to_backend ();
+  {
+    auto_timevar tv (TV_RUST_COMPILE);
+    TraceScope trace ("pipeline", "write to backend");
+    ctx.write_to_backend ();
+  }
+
+  // the trees of the context which did not make it into a definition, and
+  // the temporaries of folding and constant evaluation, are garbage now
+  ggc_collect ();
+  record_memory ("write to backend");
 }
 
 void
@@ -791,6 +1092,8 @@ Session::expansion (AST::Crate &crate)
   // create macro expansion config?
   // if not, would at least have to configure recursion_limit
   ExpansionCfg cfg;
+  cfg.collect_stats
+    = options.dump_option_enabled (CompileOptions::MACRO_STATS_DUMP);
 
   // create extctxt? from parse session, cfg, and resolver?
   /* expand by calling cxtctxt object's monotonic_expander's expand_crate
@@ -798,6 +1101,11 @@ Session::expansion (AST::Crate &crate)
   MacroExpander expander (crate, cfg, *this);
   expander.expand_crate ();
 
+  if (options.dump_option_enabled (CompileOptions::MACRO_CACHE_DUMP))
+    dump_macro_cache (expander);
+  if (options.dump_option_enabled (CompileOptions::MACRO_STATS_DUMP))
+    dump_macro_stats (expander);
+
   // error reporting - check unused macros, get missing fragment specifiers
 
   // build test harness
@@ -809,6 +1117,563 @@ Session::expansion (AST::Crate &crate)
   rust_debug ("finished expansion");
 }
 
+void
+Session::dump_macro_cache (const MacroExpander &expander) const
+{
+  std::ofstream out;
+  out.open (kMacroCacheDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kMacroCacheDumpFile);
+      return;
+    }
+
+  size_t hits = expander.get_match_cache_hits ();
+  size_t misses = expander.get_match_cache_misses ();
+  size_t total = hits + misses;
+  out << "macro match cache hits: " << hits << "\n";
+  out << "macro match cache misses: " << misses << "\n";
+  out << "macro match cache hit rate: "
+      << (total == 0 ? 0 : (hits * 100) / total) << "%\n";
+  out.close ();
+}
+
+/* List the macro_rules definitions that took the most time to expand, with
+ * what went into it: invocations, arms whose matcher had to run, tokens
+ * matched and emitted, the time split between matching, transcription and
+ * reparsing the result, and how deeply nested their invocations got. */
+void
+Session::dump_macro_stats (const MacroExpander &expander) const
+{
+  std::ofstream out;
+  out.open (kMacroStatsDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kMacroStatsDumpFile);
+      return;
+    }
+
+  std::vector<MacroStats> stats;
+  size_t total_invocations = 0;
+  for (const auto &entry : expander.get_macro_stats ())
+    {
+      stats.push_back (entry.second);
+      total_invocations += entry.second.invocations;
+    }
+
+  auto cost = [] (const MacroStats &item) {
+    return item.matching_time + item.transcription_time + item.reparsing_time;
+  };
+  std::stable_sort (stats.begin (), stats.end (),
+		    [&] (const MacroStats &a, const MacroStats &b) {
+		      if (cost (a) != cost (b))
+			return cost (a) > cost (b);
+		      return a.invocations > b.invocations;
+		    });
+
+  out << stats.size () << " macros expanded, " << total_invocations
+      << " invocations\n";
+  for (size_t i = 0; i < stats.size () && i < kMacroStatsDumpTop; i++)
+    {
+      const MacroStats &item = stats[i];
+      expanded_location loc = expand_location (item.locus.gcc_location ());
+      out << item.name << "! (" << (loc.file ? loc.file : "<unknown>") << ":"
+	  << loc.line << "): " << item.invocations << " invocations, "
+	  << cost (item) << "us\n";
+      out << "  arms tried: " << item.arms_tried << " ("
+	  << (double) item.arms_tried / item.invocations
+	  << " per invocation)\n";
+      out << "  tokens matched: " << item.tokens_matched
+	  << ", tokens emitted: " << item.tokens_emitted << "\n";
+      out << "  matching: " << item.matching_time
+	  << "us, transcription: " << item.transcription_time
+	  << "us, reparsing: " << item.reparsing_time << "us\n";
+      out << "  max expansion depth: " << item.max_expansion_depth << "\n";
+    }
+  out.close ();
+}
+
+void
+Session::dump_type_cache (const Compile::Context &ctx) const
+{
+  std::ofstream out;
+  out.open (kTypeCacheDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kTypeCacheDumpFile);
+      return;
+    }
+
+  out << "compiled type cache hits: " << ctx.get_type_cache_hits () << "\n";
+  out << "compiled type cache misses: " << ctx.get_type_cache_misses ()
+      << "\n";
+  out << "compiled type cache hash collisions: "
+      << ctx.get_type_cache_collisions () << "\n";
+  out.close ();
+}
+
+static tree
+count_tree_nodes_r (tree *, int *, void *data)
+{
+  (*static_cast<size_t *> (data))++;
+  return NULL_TREE;
+}
+
+/* List every generic function with how many times it was monomorphized and,
+ * for each instance, its substituted type and the size of its GENERIC body.
+ * Functions with the most instances come first. */
+void
+Session::dump_mono (const Compile::Context &ctx) const
+{
+  std::ofstream out;
+  out.open (kMonoDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kMonoDumpFile);
+      return;
+    }
+
+  struct Instance
+  {
+    std::string type;
+    std::string symbol;
+    size_t body_size;
+  };
+  struct Generic
+  {
+    std::string name;
+    DefId id;
+    size_t body_size;
+    std::vector<Instance> instances;
+  };
+
+  std::vector<Generic> generics;
+  for (const auto &entry : ctx.get_mono_fns ())
+    {
+      const TyTy::BaseType *first = entry.second.front ().first;
+      rust_assert (first->get_kind () == TyTy::TypeKind::FNDEF);
+      const TyTy::FnType *fntype = static_cast<const TyTy::FnType *> (first);
+      if (!fntype->has_subsititions_defined ())
+	continue;
+
+      Generic generic{fntype->get_identifier (), entry.first, 0, {}};
+
+      // the same decl is recorded again for each reference that reuses it
+      std::set<tree> seen;
+      for (const auto &instance : entry.second)
+	{
+	  tree fndecl = instance.second;
+	  if (!seen.insert (fndecl).second)
+	    continue;
+
+	  size_t body_size = 0;
+	  if (DECL_SAVED_TREE (fndecl) != NULL_TREE)
+	    walk_tree_without_duplicates (&DECL_SAVED_TREE (fndecl),
+					  count_tree_nodes_r, &body_size);
+
+	  std::string symbol;
+	  if (DECL_ASSEMBLER_NAME_SET_P (fndecl))
+	    symbol = IDENTIFIER_POINTER (DECL_ASSEMBLER_NAME_RAW (fndecl));
+
+	  generic.body_size += body_size;
+	  generic.instances.push_back (
+	    {instance.first->as_string (), symbol, body_size});
+	}
+      generics.push_back (std::move (generic));
+    }
+
+  std::stable_sort (generics.begin (), generics.end (),
+		    [] (const Generic &a, const Generic &b) {
+		      return a.instances.size () > b.instances.size ();
+		    });
+
+  for (const auto &generic : generics)
+    {
+      out << generic.name << " [" << generic.id.as_string ()
+	  << "]: " << generic.instances.size () << " instances, "
+	  << generic.body_size << " tree nodes\n";
+      for (const auto &instance : generic.instances)
+	{
+	  out << "  " << instance.type << ": " << instance.body_size
+	      << " tree nodes";
+	  if (!instance.symbol.empty ())
+	    out << " (" << instance.symbol << ")";
+	  out << "\n";
+	}
+    }
+  out.close ();
+}
+
+/* Print the fields of RECORD, a struct or an enum variant, in the order they
+ * are laid out with the padding between them.  The discriminant of an enum
+ * variant is left out, it is printed once for the whole enum. */
+static void
+dump_record_layout (Backend *backend, std::ofstream &out, tree record,
+		    const std::string &indent)
+{
+  int64_t end = 0;
+  for (tree field = TYPE_FIELDS (record); field != NULL_TREE;
+       field = DECL_CHAIN (field))
+    {
+      if (TREE_CODE (field) != FIELD_DECL)
+	continue;
+
+      int64_t offset = int_byte_position (field);
+      int64_t size = backend->type_size (TREE_TYPE (field));
+      if (DECL_ARTIFICIAL (field))
+	{
+	  end = offset + size;
+	  continue;
+	}
+
+      if (offset > end)
+	out << indent << "padding: " << offset - end << " bytes\n";
+      const char *name
+	= DECL_NAME (field) ? IDENTIFIER_POINTER (DECL_NAME (field)) : "";
+      out << indent << "field `." << name << "`: " << size
+	  << " bytes, offset: " << offset << " bytes, alignment: "
+	  << backend->type_field_alignment (TREE_TYPE (field)) << " bytes\n";
+      end = std::max (end, offset + size);
+    }
+
+  int64_t size = backend->type_size (record);
+  if (size > end && TREE_CODE (record) == RECORD_TYPE)
+    out << indent << "end padding: " << size - end << " bytes\n";
+}
+
+/* Print the layout of every compiled struct, union and enum, the largest
+ * first, like rustc's -Zprint-type-sizes.  Enums list the space taken by
+ * their discriminant, then each variant with its own fields. */
+void
+Session::dump_type_sizes (const Compile::Context &ctx) const
+{
+  std::ofstream out;
+  out.open (kTypeSizesDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kTypeSizesDumpFile);
+      return;
+    }
+
+  struct Layout
+  {
+    std::string name;
+    tree type;
+    bool is_enum;
+    int64_t size;
+  };
+
+  std::vector<Layout> layouts;
+  for (const auto &entry : ctx.get_compiled_adts ())
+    {
+      tree type = entry.second.first;
+      // generic definitions compiled with their type parameters unresolved
+      // have no layout
+      if (!COMPLETE_TYPE_P (type)
+	  || TREE_CODE (TYPE_SIZE_UNIT (type)) != INTEGER_CST)
+	continue;
+
+      layouts.push_back (
+	{entry.first, type, entry.second.second, backend->type_size (type)});
+    }
+
+  std::stable_sort (layouts.begin (), layouts.end (),
+		    [] (const Layout &a, const Layout &b) {
+		      return a.size > b.size;
+		    });
+
+  for (const auto &layout : layouts)
+    {
+      out << "type: `" << layout.name << "`: " << layout.size
+	  << " bytes, alignment: " << backend->type_alignment (layout.type)
+	  << " bytes\n";
+      if (!layout.is_enum)
+	{
+	  dump_record_layout (backend, out, layout.type, "    ");
+	  continue;
+	}
+
+      // each variant record starts with the discriminant, unless the enum
+      // keeps it in a niche and ends with an artificial integer covering it
+      int64_t discriminant_size = 0;
+      bool has_niche = false;
+      for (tree variant = TYPE_FIELDS (layout.type); variant != NULL_TREE;
+	   variant = DECL_CHAIN (variant))
+	{
+	  if (TREE_CODE (variant) != FIELD_DECL)
+	    continue;
+	  if (DECL_ARTIFICIAL (variant))
+	    {
+	      has_niche = true;
+	      continue;
+	    }
+
+	  tree first = TYPE_FIELDS (TREE_TYPE (variant));
+	  if (first != NULL_TREE && DECL_ARTIFICIAL (first))
+	    discriminant_size = backend->type_size (TREE_TYPE (first));
+	}
+
+      if (has_niche)
+	out << "    discriminant: 0 bytes, stored in a niche\n";
+      else
+	out << "    discriminant: " << discriminant_size << " bytes\n";
+
+      for (tree variant = TYPE_FIELDS (layout.type); variant != NULL_TREE;
+	   variant = DECL_CHAIN (variant))
+	{
+	  if (TREE_CODE (variant) != FIELD_DECL || DECL_ARTIFICIAL (variant))
+	    continue;
+
+	  out << "    variant `" << IDENTIFIER_POINTER (DECL_NAME (variant))
+	      << "`: " << backend->type_size (TREE_TYPE (variant))
+	      << " bytes\n";
+	  dump_record_layout (backend, out, TREE_TYPE (variant), "        ");
+	}
+    }
+  out.close ();
+}
+
+/* List the constant items that took the most operations to evaluate, with
+ * the calls, loop iterations and stores that went into each. */
+void
+Session::dump_const_eval () const
+{
+  std::ofstream out;
+  out.open (kConstEvalDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kConstEvalDumpFile);
+      return;
+    }
+
+  std::vector<Compile::ConstEvalStats> stats
+    = Compile::get_const_eval_stats ();
+  std::stable_sort (stats.begin (), stats.end (),
+		    [] (const Compile::ConstEvalStats &a,
+			const Compile::ConstEvalStats &b) {
+		      return a.ops > b.ops;
+		    });
+
+  HOST_WIDE_INT total_ops = 0;
+  for (const auto &item : stats)
+    total_ops += item.ops;
+
+  out << stats.size () << " constant items evaluated, " << total_ops
+      << " operations\n";
+  for (size_t i = 0; i < stats.size () && i < kConstEvalDumpTop; i++)
+    {
+      const Compile::ConstEvalStats &item = stats[i];
+      expanded_location loc = expand_location (item.locus);
+      out << item.name << " (" << (loc.file ? loc.file : "<unknown>") << ":"
+	  << loc.line << "): " << item.ops << " operations, " << item.calls
+	  << " calls, " << item.loop_iterations << " loop iterations, "
+	  << item.stores << " stores";
+      if (item.exhausted)
+	out << " [budget exhausted, computed at run time]";
+      out << "\n";
+    }
+  out.close ();
+}
+
+/* Report how many unifications type checking did for each kind of expected
+ * type and how many of them took the fast path. */
+void
+Session::dump_unify_stats () const
+{
+  std::ofstream out;
+  out.open (kUnifyStatsDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kUnifyStatsDumpFile);
+      return;
+    }
+
+  const TyTy::UnifyStats &stats = TyTy::get_unify_stats ();
+  size_t total_calls = 0;
+  size_t total_fast_paths = 0;
+  for (int i = 0; i <= TyTy::TypeKind::ERROR; i++)
+    {
+      total_calls += stats.calls[i];
+      total_fast_paths += stats.fast_paths[i];
+    }
+
+  out << total_calls << " unifications, " << total_fast_paths
+      << " by fast path\n";
+  for (int i = 0; i <= TyTy::TypeKind::ERROR; i++)
+    {
+      if (stats.calls[i] == 0)
+	continue;
+
+      TyTy::TypeKind kind = static_cast<TyTy::TypeKind> (i);
+      out << TyTy::TypeKindFormat::to_string (kind) << ": " << stats.calls[i]
+	  << " unifications, " << stats.fast_paths[i] << " by fast path\n";
+    }
+  out.close ();
+}
+
+void
+Session::record_memory (const char *stage, const Compile::Context *ctx)
+{
+  if (!options.dump_option_enabled (CompileOptions::MEM_DUMP))
+    return;
+
+  MemorySnapshot snapshot;
+  snapshot.stage = stage;
+  snapshot.peak_rss_kb = 0;
+#if defined (HAVE_GETRUSAGE) && defined (HAVE_SYS_RESOURCE_H)
+  struct rusage usage;
+  if (getrusage (RUSAGE_SELF, &usage) == 0)
+    snapshot.peak_rss_kb = usage.ru_maxrss;
+#endif
+  snapshot.ggc_bytes = timevar_ggc_mem_total;
+  snapshot.pool_objects = SizeClassPool::get ().get_live_objects ();
+  snapshot.pool_bytes = SizeClassPool::get ().get_reserved_bytes ();
+  snapshot.node_ids = mappings->get_num_node_ids ();
+  snapshot.hir_ids = mappings->get_num_hir_ids ();
+  snapshot.mapping_entries = mappings->get_num_entries ();
+  snapshot.types = TyTy::BaseType::num_created;
+  snapshot.mono_instances = 0;
+  if (ctx != nullptr)
+    {
+      for (const auto &fn : ctx->get_mono_fns ())
+	snapshot.mono_instances += fn.second.size ();
+    }
+
+  memory_snapshots.push_back (snapshot);
+}
+
+/* One row per stage that ran: peak resident set size, bytes allocated from
+ * the GC heap, the AST and HIR nodes live in the node pool and what has been
+ * created in the mappings and type checker up to that point. */
+void
+Session::dump_mem () const
+{
+  std::ofstream out;
+  out.open (kMemDumpFile);
+  if (out.fail ())
+    {
+      rust_error_at (Linemap::unknown_location (), "cannot open %s:%m; ignored",
+		     kMemDumpFile);
+      return;
+    }
+
+  out << "stage\tpeak-rss-kb\tggc-bytes\tpool-objects\tpool-bytes"
+	 "\tnode-ids\thir-ids\tmapping-entries\ttypes\tmono-instances\n";
+  for (const auto &snapshot : memory_snapshots)
+    {
+      out << snapshot.stage << "\t" << snapshot.peak_rss_kb << "\t"
+	  << snapshot.ggc_bytes << "\t" << snapshot.pool_objects << "\t"
+	  << snapshot.pool_bytes << "\t" << snapshot.node_ids << "\t"
+	  << snapshot.hir_ids << "\t" << snapshot.mapping_entries << "\t"
+	  << snapshot.types << "\t" << snapshot.mono_instances << "\n";
+    }
+  out.close ();
+}
+
+/* While the metadata of an extern crate is prefetched on a worker thread, the
+ * files it is read from, which add_dependency records there instead of in the
+ * session. */
+static thread_local std::vector<std::string> *prefetch_dependencies = nullptr;
+
+void
+Session::add_dependency (const std::string &path)
+{
+  if (prefetch_dependencies != nullptr)
+    {
+      prefetch_dependencies->push_back (path);
+      return;
+    }
+
+  if (seen_dependencies.insert (path).second)
+    dependencies.push_back (path);
+}
+
+/* Append STR to OUT with a leading space, wrapping the line before it if it
+ * would go past the 72nd column as the C preprocessor does. */
+static void
+write_dependency_word (std::string &out, const std::string &str,
+		       size_t &column)
+{
+  if (column != 0)
+    {
+      if (column + str.size () > 72)
+	{
+	  out += " \\\n ";
+	  column = 1;
+	}
+      else
+	{
+	  out += ' ';
+	  column++;
+	}
+    }
+
+  out += str;
+  column += str.size ();
+}
+
+/* Write the make dependencies of the crate compiled from FILENAME: the rule
+ * of the object file on every source file, included file and extern crate it
+ * was built from, and with -MP a phony rule for each of them but FILENAME.
+ * There are no system files to leave out for -MM and -MMD. */
+void
+Session::write_dependencies (const char *filename) const
+{
+  std::string out;
+  size_t column = 0;
+
+  if (options.deps_targets.empty ())
+    {
+      std::string target = lbasename (filename);
+      size_t dot = target.rfind ('.');
+      if (dot != std::string::npos)
+	target.erase (dot);
+      write_dependency_word (out, quote_make_name ((target + ".o").c_str (),
+						   true),
+			     column);
+    }
+  for (const auto &target : options.deps_targets)
+    write_dependency_word (out, target, column);
+
+  out += ':';
+  column++;
+  for (const auto &dep : dependencies)
+    write_dependency_word (out, quote_make_name (dep.c_str (), false), column);
+  out += '\n';
+
+  if (options.deps_phony)
+    for (const auto &dep : dependencies)
+      if (dep.compare (filename) != 0)
+	out += "\n" + quote_make_name (dep.c_str (), false) + ":\n";
+
+  const std::string &path = !options.deps_filename_user.empty ()
+			      ? options.deps_filename_user
+			      : options.deps_filename;
+  if (path.empty ())
+    {
+      fputs (out.c_str (), stdout);
+      return;
+    }
+
+  FILE *f = fopen (path.c_str (), "w");
+  if (f == nullptr)
+    {
+      rust_error_at (Location (), "cannot open %qs for writing: %m",
+		     path.c_str ());
+      return;
+    }
+  fputs (out.c_str (), f);
+  if (fclose (f) != 0)
+    rust_error_at (Location (), "cannot write %qs: %m", path.c_str ());
+}
+
 void
 Session::dump_lex (Parser<Lexer> &parser) const
 {
@@ -930,38 +1795,176 @@ Session::dump_type_resolution (HIR::Crate &hir) const
 
 // imports
 
-NodeId
+/* The metadata of an extern crate, read from its package but not registered in
+ * the mappings yet. */
+struct Session::PrefetchedExternCrate
+{
+  std::string crate_name;
+  Location locus;
+
+  std::unique_ptr<Import::Stream> stream;
+  std::unique_ptr<Imports::ExternCrate> extern_crate;
+  bool ok = false;
+
+  // what reading the package reported, replayed when the crate is registered
+  DiagnosticBuffer diagnostics;
+  std::vector<std::string> dependencies;
+
+  /* Locate the package of the crate and read its metadata, leaving it
+   * compressed. This only touches the file system and this object, and its
+   * diagnostics are recorded into a buffer when it runs on a worker, so it
+   * runs on any thread. */
+  void read ()
+  {
+    std::string relative_import_path = "";
+    stream.reset (
+      Import::open_package (crate_name, locus, relative_import_path));
+    if (stream == nullptr)
+      return;
+
+    extern_crate.reset (new Imports::ExternCrate (*stream));
+    ok = extern_crate->read (locus);
+  }
+};
+
+// Append the extern crate declarations of ITEMS, including those of the
+// inline modules among them, to OUT.
+static void
+collect_extern_crates (std::vector<std::unique_ptr<AST::Item>> &items,
+		       std::vector<AST::ExternCrate *> &out)
+{
+  for (auto &item : items)
+    {
+      if (item->get_ast_kind () == AST::Kind::EXTERN_CRATE)
+	{
+	  auto &extern_crate = static_cast<AST::ExternCrate &> (*item);
+	  if (!extern_crate.references_self ())
+	    out.push_back (&extern_crate);
+	}
+      else if (item->get_ast_kind () == AST::Kind::MODULE)
+	collect_extern_crates (static_cast<AST::Module &> (*item).get_items (),
+			       out);
+    }
+}
+
+/* Locating the package of an extern crate and reading its metadata does not
+ * depend on the other crates. The crates declared outside of macros are known
+ * once the crate is parsed, so this is done for all of them up front, spread
+ * over a few threads. A worker only does file I/O: its diagnostics and
+ * dependencies are recorded with the crate and reported from the main thread,
+ * and the metadata is decompressed and decoded by load_extern_crate on the
+ * main thread too. Registering a crate in the mappings also waits for
+ * load_extern_crate, so crate numbers are handed out in the order expansion
+ * reaches the declarations, and a declaration stripped by cfg is never
+ * registered nor reported. Crates declared by macros are read when expanded,
+ * as before. */
+void
+Session::prefetch_extern_crates (AST::Crate &crate)
+{
+  auto_timevar tv (TV_RUST_EXTERN_CRATE);
+  TraceScope trace ("extern crate", "prefetch");
+
+  std::vector<AST::ExternCrate *> decls;
+  collect_extern_crates (crate.items, decls);
+
+  std::vector<AST::ExternCrate *> unloaded;
+  std::set<std::string> seen;
+  for (AST::ExternCrate *decl : decls)
+    {
+      const std::string &name = decl->get_referenced_crate ();
+      CrateNum crate_num = UNKNOWN_CREATENUM;
+      if (!mappings->lookup_crate_name (name, crate_num)
+	  && seen.insert (name).second)
+	unloaded.push_back (decl);
+    }
+
+  // a single crate is not worth a thread
+  if (unloaded.size () < 2)
+    return;
+
+  std::vector<PrefetchedExternCrate *> work;
+  for (AST::ExternCrate *decl : unloaded)
+    {
+      PrefetchedExternCrate *prefetched = new PrefetchedExternCrate ();
+      prefetched->crate_name = decl->get_referenced_crate ();
+      prefetched->locus = decl->get_locus ();
+      prefetched_extern_crates[prefetched->crate_name] = prefetched;
+      work.push_back (prefetched);
+    }
+
+  if (trace.is_active ())
+    trace.add_arg ("crates", std::to_string (work.size ()));
+
+  std::atomic<size_t> next (0);
+  auto worker = [&work, &next] () {
+    for (size_t i = next++; i < work.size (); i = next++)
+      {
+	PrefetchedExternCrate &prefetched = *work[i];
+	DiagnosticBuffer::Scope scope (prefetched.diagnostics, 0);
+	prefetch_dependencies = &prefetched.dependencies;
+	prefetched.read ();
+	prefetch_dependencies = nullptr;
+      }
+  };
+
+  size_t n_threads = std::thread::hardware_concurrency ();
+  n_threads = std::max<size_t> (1, std::min (n_threads, work.size ()));
+
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < n_threads; t++)
+    threads.emplace_back (worker);
+  worker ();
+  for (std::thread &thread : threads)
+    thread.join ();
+}
+
+CrateNum
 Session::load_extern_crate (const std::string &crate_name, Location locus)
 {
+  auto_timevar tv (TV_RUST_EXTERN_CRATE);
+  TraceScope trace ("extern crate", "load");
+  if (trace.is_active ())
+    trace.add_arg ("crate", crate_name);
+
   // has it already been loaded?
   CrateNum found_crate_num = UNKNOWN_CREATENUM;
   bool found = mappings->lookup_crate_name (crate_name, found_crate_num);
   if (found)
+    return found_crate_num;
+
+  std::unique_ptr<PrefetchedExternCrate> crate;
+  auto prefetched = prefetched_extern_crates.find (crate_name);
+  if (prefetched != prefetched_extern_crates.end ())
     {
-      NodeId resolved_node_id = UNKNOWN_NODEID;
-      bool resolved
-	= mappings->crate_num_to_nodeid (found_crate_num, resolved_node_id);
-      rust_assert (resolved);
+      crate.reset (prefetched->second);
+      prefetched_extern_crates.erase (prefetched);
 
-      return resolved_node_id;
+      DiagnosticBuffer::emit ({&crate->diagnostics});
+      for (const std::string &path : crate->dependencies)
+	add_dependency (path);
+    }
+  else
+    {
+      crate.reset (new PrefetchedExternCrate ());
+      crate->crate_name = crate_name;
+      crate->locus = locus;
+      crate->read ();
     }
 
-  std::string relative_import_path = "";
-  Import::Stream *s
-    = Import::open_package (crate_name, locus, relative_import_path);
-  if (s == NULL)
+  if (crate->stream == nullptr)
     {
       rust_error_at (locus, "failed to locate crate %<%s%>",
 		     crate_name.c_str ());
-      return UNKNOWN_NODEID;
+      return UNKNOWN_CREATENUM;
     }
 
-  Imports::ExternCrate extern_crate (*s);
-  bool ok = extern_crate.load (locus);
-  if (!ok)
+  /* Decompression goes through lto-compress.cc, which keeps a shared zstd
+   * context, timevars and statistics, so it only runs on the main thread. */
+  Imports::ExternCrate &extern_crate = *crate->extern_crate;
+  if (!crate->ok || !extern_crate.decode (locus))
     {
       rust_error_at (locus, "failed to load crate metadata");
-      return UNKNOWN_NODEID;
+      return UNKNOWN_CREATENUM;
     }
 
   // ensure the current vs this crate name don't collide
@@ -970,37 +1973,296 @@ Session::load_extern_crate (const std::string &crate_name, Location locus)
     {
       rust_error_at (locus, "current crate name %<%s%> collides with this",
 		     current_crate_name.c_str ());
-      return UNKNOWN_NODEID;
+      return UNKNOWN_CREATENUM;
     }
 
-  // setup mappings
-  CrateNum saved_crate_num = mappings->get_current_crate ();
+  // the crate is resolved in resolve_extern_crates once the current crate has
+  // been expanded
   CrateNum crate_num
     = mappings->get_next_crate_num (extern_crate.get_crate_name ());
-  mappings->set_current_crate (crate_num);
+  pending_extern_crates.push_back ({crate_num, extern_crate.get_crate_name (),
+				    extern_crate.get_checksum (),
+				    extern_crate.take_items (),
+				    {},
+				    {}});
 
-  // then lets parse this as a 2nd crate
-  Lexer lex (extern_crate.get_metadata ());
-  Parser<Lexer> parser (lex);
-  std::unique_ptr<AST::Crate> metadata_crate = parser.parse_crate ();
-  AST::Crate &parsed_crate
-    = mappings->insert_ast_crate (std::move (metadata_crate), crate_num);
+  return crate_num;
+}
 
-  // name resolve it
-  Resolver::NameResolution::Resolve (parsed_crate);
+/* Write the .rox file of the crate, unless its metadata only goes into the
+ * object file, then create the file signalling that it is ready. */
+void
+Session::write_metadata_file (const std::vector<Metadata::MetadataItem> &items)
+{
+  std::string rox;
+  if (options.metadata_output_path_set ())
+    rox = options.get_metadata_output ();
+  else if (!flag_rust_embed_metadata)
+    rox = Metadata::PublicInterface::expected_metadata_filename ();
 
-  // perform hir lowering
-  std::unique_ptr<HIR::Crate> lowered
-    = HIR::ASTLowering::Resolve (parsed_crate);
-  HIR::Crate &hir = mappings->insert_hir_crate (std::move (lowered));
+  if (!rox.empty ())
+    {
+      Metadata::PublicInterface::ExportTo (items, rox);
+      if (flag_rust_emit_metadata_early)
+	early_metadata_files.push_back (rox);
+    }
+
+  if (saw_errors () || !options.metadata_ready_path_set ())
+    return;
+
+  const std::string &path = options.get_metadata_ready ();
+  FILE *ready = fopen (path.c_str (), "w");
+  if (ready == NULL)
+    {
+      rust_error_at (Location (), "failed to open file %<%s%> for writing: %s",
+		     path.c_str (), xstrerror (errno));
+      return;
+    }
+  fclose (ready);
+  if (flag_rust_emit_metadata_early)
+    early_metadata_files.push_back (path);
+}
+
+/* An early .rox describes a crate which compiled, so once codegen or the
+ * middle-end fails, remove it and its ready file again so that neither build
+ * systems nor dependent crates pick up the interface of a broken crate. */
+void
+Session::finish ()
+{
+  if (!saw_errors ())
+    return;
+
+  for (const auto &path : early_metadata_files)
+    unlink (path.c_str ());
+  early_metadata_files.clear ();
+}
+
+void
+Session::check_extern_crate_bodies ()
+{
+  for (HIR::Crate *crate : extern_hir_crates)
+    {
+      CrateNum saved_crate_num = mappings->get_current_crate ();
+      mappings->set_current_crate (crate->get_mappings ().get_crate_num ());
+
+      Resolver::TypeResolution::ResolveReferencedBodies (*crate);
+
+      mappings->set_current_crate (saved_crate_num);
+    }
+  extern_hir_crates.clear ();
+}
+
+// The distinct identifiers used in SOURCE.
+static std::vector<std::string>
+collect_identifiers (const std::string &source)
+{
+  std::set<std::string> seen;
+  Lexer lex (source);
+  for (const_TokenPtr tok = lex.peek_token (); tok->get_id () != END_OF_FILE;
+       tok = lex.peek_token ())
+    {
+      if (tok->get_id () == IDENTIFIER)
+	seen.insert (tok->get_str ());
+      lex.skip_token ();
+    }
+
+  return std::vector<std::string> (seen.begin (), seen.end ());
+}
 
-  // perform type resolution
-  Resolver::TypeResolution::Resolve (hir);
+static const char kExternCrateCacheHeader[] = "gccrs-metadata-cache";
 
-  // always restore the crate_num
-  mappings->set_current_crate (saved_crate_num);
+std::string
+Session::extern_crate_cache_path (const PendingExternCrate &crate) const
+{
+  static const char hex[] = "0123456789abcdef";
+
+  std::string path = options.get_metadata_cache_dir () + "/" + crate.crate_name;
+  path += '-';
+  for (unsigned char byte : crate.checksum)
+    {
+      path += hex[byte >> 4];
+      path += hex[byte & 0xf];
+    }
+  path += ".cache";
+
+  return path;
+}
+
+/* The cache records, for every item of an extern crate, the identifiers its
+ * body uses. That is everything resolve_extern_crates needs to work out which
+ * items are reachable without lexing them again. Entries are keyed by the
+ * metadata checksum and stamped with the compiler version, and anything that
+ * does not match is ignored. */
+bool
+Session::read_extern_crate_cache (PendingExternCrate &crate) const
+{
+  std::ifstream in (extern_crate_cache_path (crate));
+  if (in.fail ())
+    return false;
+
+  std::string header, compiler_version;
+  uint32_t format_version = 0;
+  size_t item_count = 0;
+  in >> header >> format_version;
+  std::getline (in >> std::ws, compiler_version);
+  in >> item_count;
+  if (in.fail () || header.compare (kExternCrateCacheHeader) != 0
+      || format_version != Metadata::kMetadataVersion
+      || compiler_version.compare (version_string) != 0
+      || item_count != crate.items.size ())
+    return false;
+
+  std::vector<std::vector<std::string>> names (item_count);
+  for (auto &item_names : names)
+    {
+      size_t count = 0;
+      in >> count;
+      item_names.resize (count);
+      for (auto &name : item_names)
+	in >> name;
+    }
+  if (in.fail ())
+    return false;
+
+  crate.names = std::move (names);
+  crate.have_names.assign (item_count, true);
+  return true;
+}
+
+void
+Session::write_extern_crate_cache (PendingExternCrate &crate) const
+{
+  for (size_t i = 0; i < crate.items.size (); i++)
+    {
+      if (!crate.have_names[i])
+	crate.names[i] = collect_identifiers (crate.items[i].body);
+    }
+
+  // write to a private file and rename it into place so that concurrent
+  // compilations never see a partial entry
+  const std::string path = extern_crate_cache_path (crate);
+  const std::string tmp_path = path + "." + std::to_string (getpid ());
+
+  std::ofstream out (tmp_path);
+  if (out.fail ())
+    return;
+
+  out << kExternCrateCacheHeader << " " << Metadata::kMetadataVersion << " "
+      << version_string << "\n";
+  out << crate.names.size () << "\n";
+  for (const auto &item_names : crate.names)
+    {
+      out << item_names.size () << "\n";
+      for (const auto &name : item_names)
+	out << name << "\n";
+    }
+  out.close ();
+
+  if (out.fail () || rename (tmp_path.c_str (), path.c_str ()) != 0)
+    unlink (tmp_path.c_str ());
+}
+
+void
+Session::resolve_extern_crates ()
+{
+  auto_timevar tv (TV_RUST_EXTERN_CRATE);
+  TraceScope trace ("extern crate", "resolve");
+
+  std::vector<bool> update_cache (pending_extern_crates.size (), false);
+  for (size_t c = 0; c < pending_extern_crates.size (); c++)
+    {
+      PendingExternCrate &pending = pending_extern_crates[c];
+      pending.names.resize (pending.items.size ());
+      pending.have_names.assign (pending.items.size (), false);
+      if (options.metadata_cache_dir_set ())
+	update_cache[c] = !read_extern_crate_cache (pending);
+
+      /* Every identifier the current crate mentions, including those used
+       * inside macro invocations, has been lexed and so interned by now. An
+       * exported function whose name was never interned cannot be referred to
+       * and does not need to be resolved, lowered or typechecked. Traits are
+       * always kept as they can be used through lang items and method calls
+       * without being named. Names used in the bodies of kept items are added
+       * to the demand in turn, until nothing new is reached. */
+      std::vector<bool> keep (pending.items.size (), false);
+      for (const auto &item : pending.items)
+	if (item.kind == Metadata::MetadataItemKind::GENERIC_INSTANCE)
+	  mappings->insert_shared_instance (item.name);
+
+      bool changed = true;
+      while (changed)
+	{
+	  changed = false;
+	  for (size_t i = 0; i < pending.items.size (); i++)
+	    {
+	      const Metadata::MetadataItem &item = pending.items[i];
+	      if (keep[i])
+		continue;
+
+	      bool needed = item.kind == Metadata::MetadataItemKind::TRAIT
+			    || Symbol::is_interned (item.name);
+	      if (!needed)
+		continue;
+
+	      keep[i] = true;
+	      changed = true;
+
+	      if (!pending.have_names[i])
+		{
+		  pending.names[i] = collect_identifiers (item.body);
+		  pending.have_names[i] = true;
+		}
+	      for (const auto &name : pending.names[i])
+		Symbol::intern (name);
+	    }
+	}
+
+      std::string metadata;
+      for (size_t i = 0; i < pending.items.size (); i++)
+	{
+	  if (keep[i])
+	    metadata += pending.items[i].body;
+	}
+
+      // setup mappings
+      CrateNum saved_crate_num = mappings->get_current_crate ();
+      mappings->set_current_crate (pending.crate_num);
+
+      // then lets parse this as a 2nd crate
+      Lexer lex (metadata);
+      Parser<Lexer> parser (lex);
+      std::unique_ptr<AST::Crate> metadata_crate = parser.parse_crate ();
+      AST::Crate &parsed_crate
+	= mappings->insert_ast_crate (std::move (metadata_crate),
+				      pending.crate_num);
+
+      // name resolve it
+      Resolver::NameResolution::Resolve (parsed_crate);
+
+      // perform hir lowering
+      std::unique_ptr<HIR::Crate> lowered
+	= HIR::ASTLowering::Resolve (parsed_crate);
+      HIR::Crate &hir = mappings->insert_hir_crate (std::move (lowered));
+
+      /* Only the signatures are needed to type check the current crate, the
+       * bodies of generic functions are checked once name resolution shows
+       * something refers to them, see check_extern_crate_bodies. */
+      Resolver::TypeResolution::ResolveSignatures (hir);
+      extern_hir_crates.push_back (&hir);
+
+      // always restore the crate_num
+      mappings->set_current_crate (saved_crate_num);
+    }
+
+  /* Lexing the items nothing reached interns their names, so this has to wait
+   * until every pending crate has been filtered. */
+  for (size_t c = 0; c < pending_extern_crates.size (); c++)
+    {
+      if (update_cache[c])
+	write_extern_crate_cache (pending_extern_crates[c]);
+    }
 
-  return parsed_crate.get_node_id ();
+  pending_extern_crates.clear ();
 }
 //
 
@@ -23,6 +23,7 @@
 #include "rust-linemap.h"
 #include "rust-backend.h"
 #include "rust-hir-map.h"
+#include "rust-export-metadata.h"
 #include "safe-ctype.h"
 
 #include "config.h"
@@ -42,6 +43,12 @@ struct Crate;
 namespace HIR {
 struct Crate;
 }
+// expander forward decl
+struct MacroExpander;
+// compile context forward decl
+namespace Compile {
+class Context;
+}
 
 /* Data related to target, most useful for conditional compilation and
  * whatever. */
@@ -176,6 +183,14 @@ struct CompileOptions
     HIR_DUMP,
     HIR_DUMP_PRETTY,
     TYPE_RESOLUTION_DUMP,
+    MACRO_CACHE_DUMP,
+    TYPE_CACHE_DUMP,
+    MONO_DUMP,
+    CONST_EVAL_DUMP,
+    UNIFY_STATS_DUMP,
+    MEM_DUMP,
+    TYPE_SIZES_DUMP,
+    MACRO_STATS_DUMP,
   };
 
   std::set<DumpOption> dump_options;
@@ -190,6 +205,17 @@ struct CompileOptions
   bool debug_assertions = false;
   bool proc_macro = false;
   std::string metadata_output_path;
+  std::string metadata_ready_path;
+  std::string metadata_cache_dir;
+  std::string check_bodies_file;
+
+  // make dependencies: -M and -MM write them to stdout, -MD and -MMD to the
+  // file the driver names, and -MF to its argument in both cases
+  bool deps_enabled = false;
+  std::string deps_filename;
+  std::string deps_filename_user;
+  std::vector<std::string> deps_targets;
+  bool deps_phony = false;
 
   enum class Edition
   {
@@ -235,6 +261,14 @@ struct CompileOptions
     enable_dump_option (DumpOption::HIR_DUMP);
     enable_dump_option (DumpOption::HIR_DUMP_PRETTY);
     enable_dump_option (DumpOption::TYPE_RESOLUTION_DUMP);
+    enable_dump_option (DumpOption::MACRO_CACHE_DUMP);
+    enable_dump_option (DumpOption::TYPE_CACHE_DUMP);
+    enable_dump_option (DumpOption::MONO_DUMP);
+    enable_dump_option (DumpOption::CONST_EVAL_DUMP);
+    enable_dump_option (DumpOption::UNIFY_STATS_DUMP);
+    enable_dump_option (DumpOption::MEM_DUMP);
+    enable_dump_option (DumpOption::TYPE_SIZES_DUMP);
+    enable_dump_option (DumpOption::MACRO_STATS_DUMP);
   }
 
   void set_crate_name (std::string name)
@@ -278,6 +312,45 @@ struct CompileOptions
   {
     return !metadata_output_path.empty ();
   }
+
+  void set_metadata_ready (const std::string &path)
+  {
+    metadata_ready_path = path;
+  }
+
+  const std::string &get_metadata_ready () const
+  {
+    return metadata_ready_path;
+  }
+
+  bool metadata_ready_path_set () const
+  {
+    return !metadata_ready_path.empty ();
+  }
+
+  void set_metadata_cache_dir (const std::string &dir)
+  {
+    metadata_cache_dir = dir;
+  }
+
+  const std::string &get_metadata_cache_dir () const
+  {
+    return metadata_cache_dir;
+  }
+
+  bool metadata_cache_dir_set () const { return !metadata_cache_dir.empty (); }
+
+  void set_check_bodies_file (const std::string &file)
+  {
+    check_bodies_file = file;
+  }
+
+  const std::string &get_check_bodies_file () const
+  {
+    return check_bodies_file;
+  }
+
+  bool check_bodies_file_set () const { return !check_bodies_file.empty (); }
 };
 
 /* Defines a compiler session. This is for a single compiler invocation, so
@@ -302,6 +375,56 @@ struct Session
   // mappings
   Analysis::Mappings *mappings;
 
+  /* Extern crates whose metadata has been read but which have not been
+   * resolved yet. This is delayed until the current crate is fully expanded so
+   * that only the items it can actually refer to are processed. */
+  struct PendingExternCrate
+  {
+    CrateNum crate_num;
+    std::string crate_name;
+    std::string checksum;
+    std::vector<Metadata::MetadataItem> items;
+
+    // the identifiers used by the body of each item, once known
+    std::vector<std::vector<std::string>> names;
+    std::vector<bool> have_names;
+  };
+  std::vector<PendingExternCrate> pending_extern_crates;
+
+  /* Extern crates whose metadata was read on worker threads before expansion,
+   * by name, until expansion reaches their declaration and load_extern_crate
+   * registers them. */
+  struct PrefetchedExternCrate;
+  std::map<std::string, PrefetchedExternCrate *> prefetched_extern_crates;
+
+  // every file the crate is built from, in the order they are read, for the
+  // make dependencies
+  std::vector<std::string> dependencies;
+  std::set<std::string> seen_dependencies;
+
+  // extern crates whose function bodies have not been type checked yet
+  std::vector<HIR::Crate *> extern_hir_crates;
+
+  // resource use taken after each stage of compile_crate for -frust-dump-mem
+  struct MemorySnapshot
+  {
+    std::string stage;
+    long peak_rss_kb;
+    size_t ggc_bytes;
+    size_t pool_objects;
+    size_t pool_bytes;
+    size_t node_ids;
+    size_t hir_ids;
+    size_t mapping_entries;
+    size_t types;
+    size_t mono_instances;
+  };
+  std::vector<MemorySnapshot> memory_snapshots;
+
+  // the .rox and ready files written by -frust-emit-metadata-early, removed
+  // again if the crate then fails to compile
+  std::vector<std::string> early_metadata_files;
+
 public:
   /* Get a reference to the static session instance */
   static Session &get_instance ();
@@ -313,6 +436,10 @@ public:
    * grs_langhook_init(). Note that this is called after option handling. */
   void init ();
 
+  /* Corresponds to langhook grs_langhook_finish(), called once the
+   * middle-end is done with the crate. */
+  void finish ();
+
   // delete those constructors so we don't access the singleton in any
   // other way than via `get_instance()`
   Session (Session const &) = delete;
@@ -334,10 +461,22 @@ public:
     return extra_files.back ().c_str ();
   }
 
-  NodeId load_extern_crate (const std::string &crate_name, Location locus);
+  // Record that the crate is built from the file at PATH
+  void add_dependency (const std::string &path);
+
+  CrateNum load_extern_crate (const std::string &crate_name, Location locus);
+
+  /* Locate and read the metadata of the extern crates CRATE declares outside
+   * of macros in parallel, for load_extern_crate to decode and register in the
+   * order expansion reaches them. */
+  void prefetch_extern_crates (AST::Crate &crate);
+
+  void resolve_extern_crates ();
+  void check_extern_crate_bodies ();
 
 private:
   void compile_crate (const char *filename);
+  void write_metadata_file (const std::vector<Metadata::MetadataItem> &items);
   bool enable_dump (std::string arg);
 
   void dump_lex (Parser<Lexer> &parser) const;
@@ -347,6 +486,21 @@ private:
   void dump_hir (HIR::Crate &crate) const;
   void dump_hir_pretty (HIR::Crate &crate) const;
   void dump_type_resolution (HIR::Crate &crate) const;
+  void dump_macro_cache (const MacroExpander &expander) const;
+  void dump_macro_stats (const MacroExpander &expander) const;
+  void dump_type_cache (const Compile::Context &ctx) const;
+  void dump_mono (const Compile::Context &ctx) const;
+  void dump_type_sizes (const Compile::Context &ctx) const;
+  void dump_const_eval () const;
+  void dump_unify_stats () const;
+  void record_memory (const char *stage,
+		      const Compile::Context *ctx = nullptr);
+  void dump_mem () const;
+  void write_dependencies (const char *filename) const;
+
+  std::string extern_crate_cache_path (const PendingExternCrate &crate) const;
+  bool read_extern_crate_cache (PendingExternCrate &crate) const;
+  void write_extern_crate_cache (PendingExternCrate &crate) const;
 
   // pipeline stages - TODO maybe move?
   /* Register plugins pipeline stage. TODO maybe move to another object?
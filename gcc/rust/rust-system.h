@@ -43,6 +43,9 @@
 #include <memory>
 #include <utility>
 #include <fstream>
+#include <atomic>
+#include <mutex>
+#include <thread>
 
 // Rust frontend requires C++11 minimum, so will have unordered_map and set
 #include <unordered_map>
@@ -80,6 +83,14 @@ constexpr static const char *file_separator = "/";
 extern void
 rust_preserve_from_gc (tree t);
 
+// The preserved trees form a stack: the trees preserved after a mark are
+// released together once the middle-end holds on to them.
+extern size_t
+rust_gc_roots_mark ();
+
+extern void
+rust_release_gc_roots (size_t mark);
+
 extern const char *
 rust_localize_identifier (const char *ident);
 
@@ -74,6 +74,15 @@ lang_specific_driver (struct cl_decoded_option **in_decoded_options,
   /* The first input file with an extension of .rs.  */
   const char *first_rust_file = NULL;
 
+  /* The argument to -frust-codegen-units=, if there is one.  */
+  const char *codegen_units = NULL;
+
+  /* True if we saw -flto or -fno-lto.  */
+  bool saw_lto = false;
+
+  /* True if we saw -c or -S, and so will not be linking.  */
+  bool no_link = false;
+
   argc = *in_decoded_options_count;
   decoded_options = *in_decoded_options;
   added_libraries = *in_added_libraries;
@@ -103,6 +112,20 @@ lang_specific_driver (struct cl_decoded_option **in_decoded_options,
 	  shared_libgcc = 0;
 	  break;
 
+	case OPT_c:
+	case OPT_S:
+	  no_link = true;
+	  break;
+
+	case OPT_flto:
+	case OPT_flto_:
+	  saw_lto = true;
+	  break;
+
+	case OPT_frust_codegen_units_:
+	  codegen_units = arg;
+	  break;
+
 	case OPT_SPECIAL_input_file:
 	  if (first_rust_file == NULL)
 	    {
@@ -131,7 +154,7 @@ lang_specific_driver (struct cl_decoded_option **in_decoded_options,
 #endif
 
   /* Make sure to have room for the trailing NULL argument.  */
-  num_args = argc + shared_libgcc * 5 + 10;
+  num_args = argc + shared_libgcc * 5 + 13;
   new_decoded_options = XNEWVEC (struct cl_decoded_option, num_args);
 
   i = 0;
@@ -169,6 +192,23 @@ lang_specific_driver (struct cl_decoded_option **in_decoded_options,
       j++;
     }
 
+  /* The parallel middle-end and back-end runs of -frust-codegen-units= are
+     the ltrans stage of LTO: the crate is written out as IL, partitioned
+     at link time and the partitions compiled by as many jobs.  An object
+     that is not linked here keeps its code as well, so that it can still
+     be linked without LTO.  */
+  if (codegen_units != NULL && atoi (codegen_units) > 1 && !saw_lto)
+    {
+      generate_option (OPT_flto_, codegen_units, 1, CL_DRIVER,
+		       &new_decoded_options[j++]);
+      generate_option (OPT__param_lto_partitions_, codegen_units,
+		       atoi (codegen_units), CL_DRIVER,
+		       &new_decoded_options[j++]);
+      if (no_link)
+	generate_option (OPT_ffat_lto_objects, NULL, 1, CL_DRIVER,
+			 &new_decoded_options[j++]);
+    }
+
   if (saw_libc)
     new_decoded_options[j++] = *saw_libc;
   if (shared_libgcc && !static_link)
@@ -30,6 +30,27 @@ resolve_operator_overload_fn (
   TyTy::FnType **resolved_fn, HIR::ImplItem **impl_item,
   Adjustment::AdjustmentType *requires_ref_adjustment);
 
+// The resolution of a deref lang item only depends on the receiver, except
+// inside the impl of that lang item itself where resolving it again would be
+// a recursive operator overload.
+static bool
+deref_candidate_memoizable (Analysis::RustLangItem::ItemType lang_item_type,
+			    const TyTy::BaseType *ty)
+{
+  if (!ty->is_concrete ())
+    return false;
+
+  auto context = TypeCheckContext::get ();
+  TypeCheckContextItem &fn_context = context->peek_context ();
+  if (fn_context.get_type () != TypeCheckContextItem::ItemType::IMPL_ITEM)
+    return true;
+
+  HIR::Function *fn = fn_context.get_impl_item ().second;
+  return fn->get_function_name ().compare (
+	   Analysis::RustLangItem::ToString (lang_item_type))
+	 != 0;
+}
+
 TyTy::BaseType *
 Adjuster::adjust_type (const std::vector<Adjustment> &adjustments)
 {
@@ -43,13 +64,39 @@ Adjustment
 Adjuster::try_deref_type (const TyTy::BaseType *ty,
 			  Analysis::RustLangItem::ItemType deref_lang_item)
 {
+  auto context = TypeCheckContext::get ();
+
   HIR::ImplItem *impl_item = nullptr;
   TyTy::FnType *fn = nullptr;
   Adjustment::AdjustmentType requires_ref_adjustment
     = Adjustment::AdjustmentType::ERROR;
-  bool operator_overloaded
-    = resolve_operator_overload_fn (deref_lang_item, ty, &fn, &impl_item,
-				    &requires_ref_adjustment);
+  bool operator_overloaded = false;
+
+  // the same receiver types are autoderefed for every method call on them so
+  // remember what the lang item resolved to
+  bool use_memo = deref_candidate_memoizable (deref_lang_item, ty);
+  const TypeCheckContext::DerefCandidate *memo = nullptr;
+  if (use_memo && context->lookup_deref_candidate (deref_lang_item, ty, &memo))
+    {
+      fn = memo->fn;
+      impl_item = memo->impl_item;
+      requires_ref_adjustment = memo->requires_ref_adjustment;
+      operator_overloaded = fn != nullptr;
+    }
+  else
+    {
+      operator_overloaded
+	= resolve_operator_overload_fn (deref_lang_item, ty, &fn, &impl_item,
+					&requires_ref_adjustment);
+
+      // a generic deref impl is instantiated with fresh inference variables
+      // at each use so only a concrete resolution can be shared
+      if (use_memo && (!operator_overloaded || fn->is_concrete ()))
+	context->insert_deref_candidate (deref_lang_item, ty,
+					 operator_overloaded ? fn : nullptr,
+					 impl_item, requires_ref_adjustment);
+    }
+
   if (!operator_overloaded)
     {
       return Adjustment::get_error ();
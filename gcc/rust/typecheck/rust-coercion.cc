@@ -22,6 +22,34 @@
 namespace Rust {
 namespace Resolver {
 
+// Whether the coercion of RECEIVER to EXPECTED only depends on the two types.
+// The autoderef it performs resolves the Deref lang items, which is not the
+// case inside the impl of those lang items.
+static bool
+coercion_memoizable (const TyTy::BaseType *receiver,
+		     const TyTy::BaseType *expected)
+{
+  if (!receiver->is_concrete () || !expected->is_concrete ())
+    return false;
+
+  auto context = TypeCheckContext::get ();
+  if (!context->have_function_context ())
+    return true;
+
+  TypeCheckContextItem &fn_context = context->peek_context ();
+  if (fn_context.get_type () != TypeCheckContextItem::ItemType::IMPL_ITEM)
+    return true;
+
+  const std::string &fn_name
+    = fn_context.get_impl_item ().second->get_function_name ();
+  return fn_name.compare (
+	   Analysis::RustLangItem::ToString (Analysis::RustLangItem::DEREF))
+	   != 0
+	 && fn_name.compare (
+	      Analysis::RustLangItem::ToString (Analysis::RustLangItem::DEREF_MUT))
+	      != 0;
+}
+
 TypeCoercionRules::CoercionResult
 TypeCoercionRules::Coerce (TyTy::BaseType *receiver, TyTy::BaseType *expected,
 			   Location locus)
@@ -49,6 +77,27 @@ TypeCoercionRules::TypeCoercionRules (TyTy::BaseType *expected, Location locus,
 
 bool
 TypeCoercionRules::do_coercion (TyTy::BaseType *receiver)
+{
+  // the same pairs of types are coerced at many sites, such as &String
+  // arguments to &str parameters, so replay the adjustments found the first
+  // time instead of going through the autoderef and unsize rules again
+  bool use_memo = coercion_memoizable (receiver, expected);
+  const TypeCheckContext::CoercionCandidate *memo = nullptr;
+  if (use_memo && context->lookup_coercion (receiver, expected, &memo))
+    {
+      try_result = CoercionResult{memo->adjustments, memo->result->clone ()};
+      return true;
+    }
+
+  bool ok = search_coercion (receiver);
+  if (ok && use_memo)
+    context->insert_coercion (receiver, expected, try_result.adjustments,
+			      try_result.tyty);
+  return ok;
+}
+
+bool
+TypeCoercionRules::search_coercion (TyTy::BaseType *receiver)
 {
   // FIXME this is not finished and might be super simplified
   // see:
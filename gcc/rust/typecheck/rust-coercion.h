@@ -73,6 +73,8 @@ protected:
 
   bool do_coercion (TyTy::BaseType *receiver);
 
+  bool search_coercion (TyTy::BaseType *receiver);
+
 private:
   // context info
   Analysis::Mappings *mappings;
@@ -57,27 +57,11 @@ MethodResolver::select (const TyTy::BaseType &receiver)
   };
 
   // assemble inherent impl items
+  Symbol method_name = segment_name.get_symbol ();
   std::vector<impl_item_candidate> inherent_impl_fns;
-  mappings->iterate_impl_items (
-    [&] (HirId id, HIR::ImplItem *item, HIR::ImplBlock *impl) mutable -> bool {
-      bool is_trait_impl = impl->has_trait_ref ();
-      if (is_trait_impl)
-	return true;
-
-      bool is_fn
-	= item->get_impl_item_type () == HIR::ImplItem::ImplItemType::FUNCTION;
-      if (!is_fn)
-	return true;
-
-      HIR::Function *func = static_cast<HIR::Function *> (item);
-      if (!func->is_method ())
-	return true;
-
-      bool name_matches
-	= func->get_function_name ().compare (segment_name.as_string ()) == 0;
-      if (!name_matches)
-	return true;
-
+  mappings->iterate_impl_methods (
+    method_name, false,
+    [&] (HIR::Function *func, HIR::ImplBlock *impl) mutable -> bool {
       TyTy::BaseType *ty = nullptr;
       if (!query_type (func->get_mappings ().get_hirid (), &ty))
 	return true;
@@ -102,49 +86,39 @@ MethodResolver::select (const TyTy::BaseType &receiver)
     const TraitItemReference *item_ref;
   };
 
-  std::vector<trait_item_candidate> trait_fns;
-  mappings->iterate_impl_blocks ([&] (HirId id,
-				      HIR::ImplBlock *impl) mutable -> bool {
-    bool is_trait_impl = impl->has_trait_ref ();
-    if (!is_trait_impl)
+  // look for impl implementations first, the trait impl blocks which do not
+  // implement this method can still provide it from the associated trait
+  std::set<HirId> implemented_by_impl;
+  mappings->iterate_impl_methods (
+    method_name, true,
+    [&] (HIR::Function *func, HIR::ImplBlock *impl) mutable -> bool {
+      TyTy::BaseType *ty = nullptr;
+      if (!query_type (func->get_mappings ().get_hirid (), &ty))
+	return true;
+      if (ty->get_kind () == TyTy::TypeKind::ERROR)
+	return true;
+
+      rust_assert (ty->get_kind () == TyTy::TypeKind::FNDEF);
+      TyTy::FnType *fnty = static_cast<TyTy::FnType *> (ty);
+
+      inherent_impl_fns.push_back ({func, impl, fnty});
+      implemented_by_impl.insert (impl->get_mappings ().get_hirid ());
       return true;
+    });
 
-    // look for impl implementation else lookup the associated trait item
-    for (auto &impl_item : impl->get_impl_items ())
-      {
-	bool is_fn = impl_item->get_impl_item_type ()
-		     == HIR::ImplItem::ImplItemType::FUNCTION;
-	if (!is_fn)
-	  continue;
-
-	HIR::Function *func = static_cast<HIR::Function *> (impl_item.get ());
-	if (!func->is_method ())
-	  continue;
-
-	bool name_matches
-	  = func->get_function_name ().compare (segment_name.as_string ()) == 0;
-	if (!name_matches)
-	  continue;
-
-	TyTy::BaseType *ty = nullptr;
-	if (!query_type (func->get_mappings ().get_hirid (), &ty))
-	  continue;
-	if (ty->get_kind () == TyTy::TypeKind::ERROR)
-	  continue;
-
-	rust_assert (ty->get_kind () == TyTy::TypeKind::FNDEF);
-	TyTy::FnType *fnty = static_cast<TyTy::FnType *> (ty);
-
-	inherent_impl_fns.push_back ({func, impl, fnty});
-	return true;
-      }
+  std::vector<trait_item_candidate> trait_fns;
+  mappings->iterate_trait_impl_blocks ([&] (HirId id,
+					    HIR::ImplBlock *impl) mutable
+				       -> bool {
+    if (implemented_by_impl.find (id) != implemented_by_impl.end ())
+      return true;
 
     TraitReference *trait_ref
       = TraitResolver::Resolve (*impl->get_trait_ref ().get ());
     rust_assert (!trait_ref->is_error ());
 
     auto item_ref
-      = trait_ref->lookup_trait_item (segment_name.as_string (),
+      = trait_ref->lookup_trait_item (method_name.as_string (),
 				      TraitItemReference::TraitItemType::FN);
     if (item_ref->is_error ())
       return true;
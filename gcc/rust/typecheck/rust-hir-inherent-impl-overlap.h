@@ -64,6 +64,8 @@ private:
 
 class OverlappingImplItemPass : public TypeCheckBase
 {
+  typedef std::map<std::string, std::vector<HIR::ImplItem *> > ImplItemsByName;
+
 public:
   static void go ()
   {
@@ -86,9 +88,9 @@ public:
   void process_impl_item (HirId id, HIR::ImplItem *impl_item,
 			  HIR::ImplBlock *impl)
   {
-    // lets make a mapping of impl-item Self type to (impl-item,name):
+    // lets make a mapping of impl-item Self type to its items by name:
     // {
-    //   impl-type -> [ (item, name), ... ]
+    //   impl-type -> { name -> [ item, ... ], ... }
     // }
 
     HirId impl_type_id = impl->get_type ()->get_mappings ().get_hirid ();
@@ -100,67 +102,89 @@ public:
     ok = ImplItemToName::resolve (impl_item, impl_item_name);
     rust_assert (ok);
 
-    std::pair<HIR::ImplItem *, std::string> elem (impl_item, impl_item_name);
-    impl_mappings[impl_type].insert (std::move (elem));
+    auto &items = impl_mappings[impl_type];
+    if (items.empty ())
+      {
+	// only impl types with the same head, or without one, can overlap
+	std::string head;
+	if (!get_type_head (impl_type, head))
+	  head = "";
+	impl_heads[head].push_back (impl_type);
+      }
+    items[impl_item_name].push_back (impl_item);
   }
 
   void scan ()
   {
-    // we can now brute force the map looking for can_eq on each of the
-    // impl_items_types to look for possible colliding impl blocks;
+    // look for can_eq between the impl types that could overlap, to find
+    // possibly colliding impl blocks
     for (auto it = impl_mappings.begin (); it != impl_mappings.end (); it++)
       {
 	TyTy::BaseType *query = it->first;
 
-	for (auto iy = impl_mappings.begin (); iy != impl_mappings.end (); iy++)
+	std::string head;
+	if (get_type_head (query, head))
 	  {
-	    TyTy::BaseType *candidate = iy->first;
-	    if (query == candidate)
-	      continue;
-
-	    if (query->can_eq (candidate, false))
+	    for (auto &bucket : {head, std::string ("")})
 	      {
-		// we might be in the case that we have:
-		//
-		// *const T vs *const [T]
-		//
-		// so lets use an equality check when the
-		// candidates are both generic to be sure we dont emit a false
-		// positive
-
-		bool a = query->is_concrete ();
-		bool b = candidate->is_concrete ();
-		bool both_generic = !a && !b;
-		if (both_generic)
-		  {
-		    if (!query->is_equal (*candidate))
-		      continue;
-		  }
-
-		possible_collision (it->second, iy->second);
+		auto candidates = impl_heads.find (bucket);
+		if (candidates == impl_heads.end ())
+		  continue;
+
+		for (auto candidate : candidates->second)
+		  check_overlap (query, it->second, candidate);
 	      }
 	  }
+	else
+	  {
+	    for (auto iy = impl_mappings.begin (); iy != impl_mappings.end ();
+		 iy++)
+	      check_overlap (query, it->second, iy->first);
+	  }
       }
   }
 
-  void possible_collision (
-    std::set<std::pair<HIR::ImplItem *, std::string> > query,
-    std::set<std::pair<HIR::ImplItem *, std::string> > candidate)
+  void check_overlap (TyTy::BaseType *query, const ImplItemsByName &items,
+		      TyTy::BaseType *candidate)
   {
-    for (auto &q : query)
+    if (query == candidate)
+      return;
+
+    if (!query->can_eq (candidate, false))
+      return;
+
+    // we might be in the case that we have:
+    //
+    // *const T vs *const [T]
+    //
+    // so lets use an equality check when the
+    // candidates are both generic to be sure we dont emit a false
+    // positive
+
+    bool a = query->is_concrete ();
+    bool b = candidate->is_concrete ();
+    bool both_generic = !a && !b;
+    if (both_generic)
       {
-	HIR::ImplItem *query_impl_item = q.first;
-	std::string query_impl_item_name = q.second;
+	if (!query->is_equal (*candidate))
+	  return;
+      }
 
-	for (auto &c : candidate)
-	  {
-	    HIR::ImplItem *candidate_impl_item = c.first;
-	    std::string candidate_impl_item_name = c.second;
+    possible_collision (items, impl_mappings[candidate]);
+  }
 
-	    if (query_impl_item_name.compare (candidate_impl_item_name) == 0)
-	      collision_detected (query_impl_item, candidate_impl_item,
-				  candidate_impl_item_name);
-	  }
+  void possible_collision (const ImplItemsByName &query,
+			   const ImplItemsByName &candidate)
+  {
+    for (auto &q : query)
+      {
+	auto c = candidate.find (q.first);
+	if (c == candidate.end ())
+	  continue;
+
+	for (auto query_impl_item : q.second)
+	  for (auto candidate_impl_item : c->second)
+	    collision_detected (query_impl_item, candidate_impl_item, q.first);
       }
   }
 
@@ -175,9 +199,11 @@ public:
 private:
   OverlappingImplItemPass () : TypeCheckBase () {}
 
-  std::map<TyTy::BaseType *,
-	   std::set<std::pair<HIR::ImplItem *, std::string> > >
-    impl_mappings;
+  std::map<TyTy::BaseType *, ImplItemsByName> impl_mappings;
+
+  // impl types bucketed by their head, the empty head holds the impl types
+  // that have none
+  std::map<std::string, std::vector<TyTy::BaseType *> > impl_heads;
 };
 
 } // namespace Resolver
@@ -190,7 +190,7 @@ public:
 
   void visit (HIR::TypeAlias &alias) override
   {
-    Identifier name = alias.get_new_type_name ();
+    const Identifier &name = alias.get_new_type_name ();
     if (search.as_string ().compare (name) == 0)
       {
 	HirId tyid = alias.get_mappings ().get_hirid ();
@@ -209,7 +209,7 @@ public:
 
   void visit (HIR::ConstantItem &constant) override
   {
-    Identifier name = constant.get_identifier ();
+    const Identifier &name = constant.get_identifier ();
     if (search.as_string ().compare (name) == 0)
       {
 	HirId tyid = constant.get_mappings ().get_hirid ();
@@ -228,7 +228,7 @@ public:
 
   void visit (HIR::Function &function) override
   {
-    Identifier name = function.get_function_name ();
+    const Identifier &name = function.get_function_name ();
     if (search.as_string ().compare (name) == 0)
       {
 	HirId tyid = function.get_mappings ().get_hirid ();
@@ -264,11 +264,14 @@ protected:
 
   void process_impl_items_for_candidates ()
   {
-    mappings->iterate_impl_items ([&] (HirId id, HIR::ImplItem *item,
-				       HIR::ImplBlock *impl) mutable -> bool {
-      process_impl_item_candidate (id, item, impl);
-      return true;
-    });
+    // the index only holds the impl items named like the segment, the type
+    // of their impl block is still checked against the receiver
+    Symbol name = search.get_symbol ();
+    mappings->iterate_impl_items_named (
+      name, [&] (HirId id, HIR::ImplItem *item, HIR::ImplBlock *impl) -> bool {
+	process_impl_item_candidate (id, item, impl);
+	return true;
+      });
   }
 
   void process_impl_item_candidate (HirId id, HIR::ImplItem *item,
@@ -98,6 +98,11 @@ TraitResolver::TraitResolver ()
 TraitReference *
 TraitResolver::resolve_path (HIR::TypePath &path)
 {
+  TraitReference *tref = nullptr;
+  if (context->lookup_trait_path_reference (path.get_mappings ().get_hirid (),
+					    &tref))
+    return tref;
+
   NodeId ref;
   if (!resolver->lookup_resolved_type (path.get_mappings ().get_nodeid (),
 				       &ref))
@@ -106,6 +111,14 @@ TraitResolver::resolve_path (HIR::TypePath &path)
       return &TraitReference::error_node ();
     }
 
+  // another path to the same trait was resolved before
+  if (context->lookup_trait_node_reference (ref, &tref))
+    {
+      context->insert_trait_path_reference (path.get_mappings ().get_hirid (),
+					    ref, tref);
+      return tref;
+    }
+
   HirId hir_node = UNKNOWN_HIRID;
   if (!mappings->lookup_node_to_hir (ref, &hir_node))
     {
@@ -119,7 +132,11 @@ TraitResolver::resolve_path (HIR::TypePath &path)
   resolved_item->accept_vis (*this);
   rust_assert (resolved_trait_reference != nullptr);
 
-  return resolve_trait (resolved_trait_reference);
+  tref = resolve_trait (resolved_trait_reference);
+  if (!tref->is_error ())
+    context->insert_trait_path_reference (path.get_mappings ().get_hirid (),
+					  ref, tref);
+  return tref;
 }
 
 TraitReference *
@@ -237,6 +254,11 @@ TraitResolver::resolve_trait (HIR::Trait *trait_reference)
 TraitReference *
 TraitResolver::lookup_path (HIR::TypePath &path)
 {
+  TraitReference *memo = nullptr;
+  if (context->lookup_trait_path_reference (path.get_mappings ().get_hirid (),
+					    &memo))
+    return memo;
+
   NodeId ref;
   if (!resolver->lookup_resolved_type (path.get_mappings ().get_nodeid (),
 				       &ref))
@@ -245,6 +267,9 @@ TraitResolver::lookup_path (HIR::TypePath &path)
       return &TraitReference::error_node ();
     }
 
+  if (context->lookup_trait_node_reference (ref, &memo))
+    return memo;
+
   HirId hir_node = UNKNOWN_HIRID;
   if (!mappings->lookup_node_to_hir (ref, &hir_node))
     {
@@ -595,7 +620,8 @@ TraitItemReference::is_object_safe () const
 void
 PathProbeImplTrait::process_trait_impl_items_for_candidates ()
 {
-  mappings->iterate_impl_items (
+  mappings->iterate_impl_items_named (
+    search.get_symbol (),
     [&] (HirId id, HIR::ImplItem *item, HIR::ImplBlock *impl) mutable -> bool {
       // just need to check if this is an impl block for this trait the next
       // function checks the receiver
@@ -62,6 +62,8 @@ public:
 private:
   void scan ();
 
+  void build_trait_impl_index ();
+
 private:
   TypeBoundsProbe (const TyTy::BaseType *receiver)
     : TypeCheckBase (), receiver (receiver)
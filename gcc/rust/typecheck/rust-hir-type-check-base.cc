@@ -302,44 +302,56 @@ TypeCheckBase::parse_repr_options (const AST::AttrVec &attrs, Location locus)
 	  AST::AttrInputMetaItemContainer *meta_items
 	    = option.parse_to_meta_item ();
 
-	  const std::string inline_option
-	    = meta_items->get_items ().at (0)->as_string ();
-
-	  // TODO: it would probably be better to make the MetaItems more aware
-	  // of constructs with nesting like #[repr(packed(2))] rather than
-	  // manually parsing the string "packed(2)" here.
+	  for (auto &item : meta_items->get_items ())
+	    {
+	      const std::string inline_option = item->as_string ();
+	      if (inline_option.compare ("C") == 0)
+		{
+		  repr.is_c = true;
+		  continue;
+		}
+	      if (inline_option.compare ("simd") == 0)
+		{
+		  repr.is_simd = true;
+		  continue;
+		}
 
-	  size_t oparen = inline_option.find ('(', 0);
-	  bool is_pack = false, is_align = false;
-	  unsigned char value = 1;
+	      // TODO: it would probably be better to make the MetaItems more
+	      // aware of constructs with nesting like #[repr(packed(2))] rather
+	      // than manually parsing the string "packed(2)" here.
 
-	  if (oparen == std::string::npos)
-	    {
-	      is_pack = inline_option.compare ("packed") == 0;
-	      is_align = inline_option.compare ("align") == 0;
-	    }
+	      size_t oparen = inline_option.find ('(', 0);
+	      bool is_pack = false, is_align = false;
+	      unsigned char value = 1;
 
-	  else
-	    {
-	      std::string rep = inline_option.substr (0, oparen);
-	      is_pack = rep.compare ("packed") == 0;
-	      is_align = rep.compare ("align") == 0;
+	      if (oparen == std::string::npos)
+		{
+		  is_pack = inline_option.compare ("packed") == 0;
+		  is_align = inline_option.compare ("align") == 0;
+		}
 
-	      size_t cparen = inline_option.find (')', oparen);
-	      if (cparen == std::string::npos)
+	      else
 		{
-		  rust_error_at (locus, "malformed attribute");
+		  std::string rep = inline_option.substr (0, oparen);
+		  is_pack = rep.compare ("packed") == 0;
+		  is_align = rep.compare ("align") == 0;
+
+		  size_t cparen = inline_option.find (')', oparen);
+		  if (cparen == std::string::npos)
+		    {
+		      rust_error_at (locus, "malformed attribute");
+		    }
+
+		  std::string value_str = inline_option.substr (oparen, cparen);
+		  value = strtoul (value_str.c_str () + 1, NULL, 10);
 		}
 
-	      std::string value_str = inline_option.substr (oparen, cparen);
-	      value = strtoul (value_str.c_str () + 1, NULL, 10);
+	      if (is_pack)
+		repr.pack = value;
+	      else if (is_align)
+		repr.align = value;
 	    }
 
-	  if (is_pack)
-	    repr.pack = value;
-	  else if (is_align)
-	    repr.align = value;
-
 	  // Multiple repr options must be specified with e.g. #[repr(C,
 	  // packed(2))].
 	  break;
@@ -492,6 +504,38 @@ TypeCheckBase::resolve_generic_params (
     }
 }
 
+// The head of a type is what decides which impl blocks could possibly be
+// equal to it, types without a head (inference variables, generic params,
+// placeholders and projections) can be equal to anything.
+bool
+TypeCheckBase::get_type_head (const TyTy::BaseType *type, std::string &head)
+{
+  switch (type->get_kind ())
+    {
+    case TyTy::TypeKind::INFER:
+    case TyTy::TypeKind::PARAM:
+    case TyTy::TypeKind::PLACEHOLDER:
+    case TyTy::TypeKind::PROJECTION:
+    case TyTy::TypeKind::ERROR:
+      return false;
+
+    case TyTy::TypeKind::ADT:
+      head = "adt:"
+	     + static_cast<const TyTy::ADTType *> (type)->get_identifier ();
+      return true;
+
+    // fn pointers can be equal to fn items
+    case TyTy::TypeKind::FNDEF:
+    case TyTy::TypeKind::FNPTR:
+      head = "fn";
+      return true;
+
+    default:
+      head = TyTy::TypeKindFormat::to_string (type->get_kind ());
+      return true;
+    }
+}
+
 bool
 TypeCheckBase::query_type (HirId reference, TyTy::BaseType **result)
 {
@@ -502,7 +546,7 @@ TypeCheckBase::query_type (HirId reference, TyTy::BaseType **result)
   if (item != nullptr)
     {
       rust_debug_loc (item->get_locus (), "resolved item {%u} to", reference);
-      *result = TypeCheckItem::Resolve (*item);
+      *result = TypeCheckItem::ResolveSignature (*item);
       return true;
     }
 
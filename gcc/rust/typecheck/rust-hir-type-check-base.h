@@ -46,6 +46,8 @@ public:
 				    TyTy::TyWithLocation to,
 				    Location cast_locus);
 
+  static bool get_type_head (const TyTy::BaseType *type, std::string &head);
+
 protected:
   TypeCheckBase ();
 
@@ -40,8 +40,13 @@ TypeCheckExpr::Resolve (HIR::Expr *expr)
 {
   TypeCheckExpr resolver;
   expr->accept_vis (resolver);
+  return resolver.result (expr);
+}
 
-  if (resolver.infered == nullptr)
+TyTy::BaseType *
+TypeCheckExpr::result (HIR::Expr *expr)
+{
+  if (infered == nullptr)
     {
       // FIXME
       // this is an internal error message for debugging and should be removed
@@ -51,10 +56,10 @@ TypeCheckExpr::Resolve (HIR::Expr *expr)
     }
 
   auto ref = expr->get_mappings ().get_hirid ();
-  resolver.infered->set_ref (ref);
-  resolver.context->insert_type (expr->get_mappings (), resolver.infered);
+  infered->set_ref (ref);
+  context->insert_type (expr->get_mappings (), infered);
 
-  return resolver.infered;
+  return infered;
 }
 
 void
@@ -280,7 +285,32 @@ TypeCheckExpr::visit (HIR::LiteralExpr &expr)
 void
 TypeCheckExpr::visit (HIR::ArithmeticOrLogicalExpr &expr)
 {
-  auto lhs = TypeCheckExpr::Resolve (expr.get_lhs ());
+  // Operator chains nest to the left: resolve the leftmost operand, then each
+  // operator around the previous one
+  std::vector<HIR::ArithmeticOrLogicalExpr *> chain = {&expr};
+  HIR::Expr *operand = expr.get_lhs ();
+  while (operand->get_expression_type ()
+	 == HIR::Expr::ExprType::ArithmeticOrLogical)
+    {
+      chain.push_back (static_cast<HIR::ArithmeticOrLogicalExpr *> (operand));
+      operand = chain.back ()->get_lhs ();
+    }
+
+  auto lhs = TypeCheckExpr::Resolve (operand);
+  for (size_t i = chain.size () - 1; i > 0; i--)
+    {
+      TypeCheckExpr resolver;
+      resolver.check_arithmetic_or_logical (*chain[i], lhs);
+      lhs = resolver.result (chain[i]);
+    }
+
+  check_arithmetic_or_logical (expr, lhs);
+}
+
+void
+TypeCheckExpr::check_arithmetic_or_logical (HIR::ArithmeticOrLogicalExpr &expr,
+					    TyTy::BaseType *lhs)
+{
   auto rhs = TypeCheckExpr::Resolve (expr.get_rhs ());
 
   auto lang_item_type
@@ -1005,7 +1035,31 @@ TypeCheckExpr::visit (HIR::FieldAccessExpr &expr)
 void
 TypeCheckExpr::visit (HIR::MethodCallExpr &expr)
 {
-  auto receiver_tyty = TypeCheckExpr::Resolve (expr.get_receiver ().get ());
+  // Builder chains nest through their receivers: resolve the innermost
+  // receiver, then each call around the previous one
+  std::vector<HIR::MethodCallExpr *> chain = {&expr};
+  HIR::Expr *receiver = expr.get_receiver ().get ();
+  while (receiver->get_expression_type () == HIR::Expr::ExprType::MethodCall)
+    {
+      chain.push_back (static_cast<HIR::MethodCallExpr *> (receiver));
+      receiver = chain.back ()->get_receiver ().get ();
+    }
+
+  auto receiver_tyty = TypeCheckExpr::Resolve (receiver);
+  for (size_t i = chain.size () - 1; i > 0; i--)
+    {
+      TypeCheckExpr resolver;
+      resolver.check_method_call (*chain[i], receiver_tyty);
+      receiver_tyty = resolver.result (chain[i]);
+    }
+
+  check_method_call (expr, receiver_tyty);
+}
+
+void
+TypeCheckExpr::check_method_call (HIR::MethodCallExpr &expr,
+				  TyTy::BaseType *receiver_tyty)
+{
   if (receiver_tyty->get_kind () == TyTy::TypeKind::ERROR)
     {
       rust_error_at (expr.get_receiver ()->get_locus (),
@@ -1219,6 +1273,96 @@ TypeCheckExpr::visit (HIR::WhileLoopExpr &expr)
   infered = TyTy::TupleType::get_unit_type (expr.get_mappings ().get_hirid ());
 }
 
+bool
+TypeCheckExpr::is_lang_item_type (
+  TyTy::BaseType *ty, Analysis::RustLangItem::ItemType lang_item_type)
+{
+  if (ty->get_kind () != TyTy::TypeKind::ADT)
+    return false;
+
+  DefId lang_item_id = UNKNOWN_DEFID;
+  if (!mappings->lookup_lang_item (lang_item_type, &lang_item_id))
+    return false;
+
+  HIR::Item *item = mappings->lookup_defid (lang_item_id);
+  if (item == nullptr)
+    return false;
+
+  // substitutions of the lang item keep the ty_ref of its definition
+  TyTy::BaseType *item_type = nullptr;
+  return context->lookup_type (item->get_mappings ().get_hirid (), &item_type)
+	 && item_type->get_ty_ref () == ty->get_ty_ref ();
+}
+
+void
+TypeCheckExpr::visit (HIR::ForLoopExpr &expr)
+{
+  // there is no Iterator desugaring yet so the only thing we can loop over is
+  // a Range or RangeInclusive of integers, which the backend compiles as a
+  // counted loop
+  TyTy::BaseType *iterator_ty
+    = TypeCheckExpr::Resolve (expr.get_iterator_expr ().get ());
+  if (iterator_ty->get_kind () == TyTy::TypeKind::ERROR)
+    return;
+
+  bool is_range
+    = is_lang_item_type (iterator_ty, Analysis::RustLangItem::ItemType::RANGE)
+      || is_lang_item_type (iterator_ty,
+			    Analysis::RustLangItem::ItemType::RANGE_INCLUSIVE);
+
+  TyTy::BaseType *element_ty = nullptr;
+  if (is_range)
+    {
+      TyTy::ADTType *adt = static_cast<TyTy::ADTType *> (iterator_ty);
+      element_ty = adt->get_variants ().at (0)->get_field_at_index (0)
+		     ->get_field_type ()
+		     ->destructure ();
+    }
+
+  bool is_integral
+    = element_ty != nullptr
+      && (element_ty->get_kind () == TyTy::TypeKind::INT
+	  || element_ty->get_kind () == TyTy::TypeKind::UINT
+	  || element_ty->get_kind () == TyTy::TypeKind::ISIZE
+	  || element_ty->get_kind () == TyTy::TypeKind::USIZE
+	  || (element_ty->get_kind () == TyTy::TypeKind::INFER
+	      && static_cast<TyTy::InferType *> (element_ty)->get_infer_kind ()
+		   == TyTy::InferType::INTEGRAL));
+  if (!is_integral)
+    {
+      rust_sorry_at (expr.get_iterator_expr ()->get_locus (),
+		     "%<for%> loops are only supported over integer ranges, "
+		     "found %s",
+		     iterator_ty->as_string ().c_str ());
+      return;
+    }
+
+  HIR::Pattern *pattern = expr.get_pattern ().get ();
+  if (pattern->get_pattern_type () != HIR::Pattern::PatternType::IDENTIFIER
+      && pattern->get_pattern_type () != HIR::Pattern::PatternType::WILDCARD)
+    {
+      rust_sorry_at (pattern->get_locus (),
+		     "unsupported pattern in %<for%> loop");
+      return;
+    }
+  context->insert_type (pattern->get_pattern_mappings (), element_ty);
+
+  context->push_new_while_loop_context (expr.get_mappings ().get_hirid ());
+  TyTy::BaseType *block_expr
+    = TypeCheckExpr::Resolve (expr.get_loop_block ().get ());
+  context->pop_loop_context ();
+
+  if (!block_expr->is_unit ())
+    {
+      rust_error_at (expr.get_loop_block ()->get_locus (),
+		     "expected %<()%> got %s",
+		     block_expr->as_string ().c_str ());
+      return;
+    }
+
+  infered = TyTy::TupleType::get_unit_type (expr.get_mappings ().get_hirid ());
+}
+
 void
 TypeCheckExpr::visit (HIR::BreakExpr &expr)
 {
@@ -1360,6 +1504,7 @@ TypeCheckExpr::visit (HIR::MatchExpr &expr)
   // unify the scruintee and arms
   TyTy::BaseType *scrutinee_tyty
     = TypeCheckExpr::Resolve (expr.get_scrutinee_expr ().get ());
+  context->insert_match_expr (expr.get_mappings ().get_hirid (), &expr);
 
   std::vector<TyTy::BaseType *> kase_block_tys;
   for (auto &kase : expr.get_match_cases ())
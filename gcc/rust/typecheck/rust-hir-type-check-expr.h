@@ -69,6 +69,7 @@ public:
   void visit (HIR::RangeFullExpr &expr) override;
   void visit (HIR::RangeFromToInclExpr &expr) override;
   void visit (HIR::WhileLoopExpr &expr) override;
+  void visit (HIR::ForLoopExpr &expr) override;
 
   // TODO
   void visit (HIR::ClosureExprInnerTyped &) override {}
@@ -76,7 +77,6 @@ public:
   void visit (HIR::ErrorPropagationExpr &expr) override {}
   void visit (HIR::RangeToInclExpr &expr) override {}
   void visit (HIR::WhileLetLoopExpr &expr) override {}
-  void visit (HIR::ForLoopExpr &expr) override {}
   void visit (HIR::IfExprConseqIfLet &expr) override {}
   void visit (HIR::IfLetExprConseqElse &expr) override {}
   void visit (HIR::IfLetExprConseqIf &expr) override {}
@@ -104,9 +104,22 @@ protected:
 			     HIR::OperatorExprMeta expr, TyTy::BaseType *lhs,
 			     TyTy::BaseType *rhs);
 
+  bool is_lang_item_type (TyTy::BaseType *ty,
+			  Analysis::RustLangItem::ItemType lang_item_type);
+
 private:
   TypeCheckExpr ();
 
+  /* Record and return the type inferred for EXPR, the tail of Resolve */
+  TyTy::BaseType *result (HIR::Expr *expr);
+
+  /* The bodies of the visitors of chained operators and method calls, given
+   * the type of the left operand or of the receiver already resolved */
+  void check_arithmetic_or_logical (HIR::ArithmeticOrLogicalExpr &expr,
+				    TyTy::BaseType *lhs);
+  void check_method_call (HIR::MethodCallExpr &expr,
+			  TyTy::BaseType *receiver_tyty);
+
   TyTy::BaseType *resolve_root_path (HIR::PathInExpression &expr,
 				     size_t *offset,
 				     NodeId *root_resolved_node_id);
@@ -295,12 +295,16 @@ TypeCheckImplItem::visit (HIR::Function &function)
 				  function.is_method ()
 				    ? TyTy::FnType::FNTYPE_IS_METHOD_FLAG
 				    : TyTy::FnType::FNTYPE_DEFAULT_FLAGS,
-				  ABI::RUST, std::move (params), ret_type,
+				  function.get_qualifiers ().get_abi (),
+				  std::move (params), ret_type,
 				  std::move (substitutions));
 
   context->insert_type (function.get_mappings (), fnType);
   result = fnType;
 
+  if (context->body_is_deferred (function.get_locus ()))
+    return;
+
   // need to get the return type from this
   TyTy::FnType *resolve_fn_type = fnType;
   auto expected_ret_tyty = resolve_fn_type->get_return_type ();
@@ -407,7 +411,7 @@ TypeCheckImplItemWithTrait::visit (HIR::ConstantItem &constant)
   // merge the attributes
   const HIR::TraitItem *hir_trait_item
     = resolved_trait_item.get_raw_item ()->get_hir_trait_item ();
-  merge_attributes (constant.get_outer_attrs (), *hir_trait_item);
+  merge_attributes (constant, *hir_trait_item);
 
   // check the types are compatible
   auto trait_item_type = resolved_trait_item.get_tyty_for_receiver (self);
@@ -456,7 +460,7 @@ TypeCheckImplItemWithTrait::visit (HIR::TypeAlias &type)
   // merge the attributes
   const HIR::TraitItem *hir_trait_item
     = resolved_trait_item.get_raw_item ()->get_hir_trait_item ();
-  merge_attributes (type.get_outer_attrs (), *hir_trait_item);
+  merge_attributes (type, *hir_trait_item);
 
   // check the types are compatible
   auto trait_item_type = resolved_trait_item.get_tyty_for_receiver (self);
@@ -515,7 +519,7 @@ TypeCheckImplItemWithTrait::visit (HIR::Function &function)
   // merge the attributes
   const HIR::TraitItem *hir_trait_item
     = resolved_trait_item.get_raw_item ()->get_hir_trait_item ();
-  merge_attributes (function.get_outer_attrs (), *hir_trait_item);
+  merge_attributes (function, *hir_trait_item);
 
   // check the types are compatible
   auto trait_item_type = resolved_trait_item.get_tyty_for_receiver (self);
@@ -532,13 +536,10 @@ TypeCheckImplItemWithTrait::visit (HIR::Function &function)
 }
 
 void
-TypeCheckImplItemWithTrait::merge_attributes (AST::AttrVec &impl_item_attrs,
+TypeCheckImplItemWithTrait::merge_attributes (HIR::Item &impl_item,
 					      const HIR::TraitItem &trait_item)
 {
-  for (const auto &attr : trait_item.get_outer_attrs ())
-    {
-      impl_item_attrs.push_back (attr);
-    }
+  impl_item.append_outer_attrs (trait_item.get_outer_attrs ());
 }
 
 bool
@@ -79,7 +79,7 @@ public:
 protected:
   // this allows us to inherit the must_use specified on a trait definition onto
   // its implementation
-  void merge_attributes (AST::AttrVec &impl_item_attrs,
+  void merge_attributes (HIR::Item &impl_item,
 			 const HIR::TraitItem &trait_item);
 
 private:
@@ -29,12 +29,43 @@
 namespace Rust {
 namespace Resolver {
 
-TypeCheckItem::TypeCheckItem () : TypeCheckBase (), infered (nullptr) {}
+TypeCheckItem::TypeCheckItem ()
+  : TypeCheckBase (), infered (nullptr), signature_only (false)
+{}
 
 TyTy::BaseType *
 TypeCheckItem::Resolve (HIR::Item &item)
 {
   // is it already resolved?
+  auto context = TypeCheckContext::get ();
+  TyTy::BaseType *resolved = nullptr;
+  bool already_resolved
+    = context->lookup_type (item.get_mappings ().get_hirid (), &resolved);
+  if (already_resolved)
+    {
+      // only the signature may have been needed so far
+      if (!context->body_is_deferred (item.get_locus ())
+	  && context->take_pending_body (item.get_mappings ().get_hirid ()))
+	{
+	  rust_assert (resolved->get_kind () == TyTy::TypeKind::FNDEF);
+	  TypeCheckItem resolver;
+	  resolver.check_function_body (static_cast<HIR::Function &> (item),
+					static_cast<TyTy::FnType *> (resolved));
+	}
+      return resolved;
+    }
+
+  rust_assert (item.get_hir_kind () == HIR::Node::BaseKind::VIS_ITEM);
+  HIR::VisItem &vis_item = static_cast<HIR::VisItem &> (item);
+
+  TypeCheckItem resolver;
+  vis_item.accept_vis (resolver);
+  return resolver.infered;
+}
+
+TyTy::BaseType *
+TypeCheckItem::ResolveSignature (HIR::Item &item)
+{
   auto context = TypeCheckContext::get ();
   TyTy::BaseType *resolved = nullptr;
   bool already_resolved
@@ -46,6 +77,7 @@ TypeCheckItem::Resolve (HIR::Item &item)
   HIR::VisItem &vis_item = static_cast<HIR::VisItem &> (item);
 
   TypeCheckItem resolver;
+  resolver.signature_only = true;
   vis_item.accept_vis (resolver);
   return resolver.infered;
 }
@@ -415,15 +447,29 @@ TypeCheckItem::visit (HIR::Function &function)
   auto fnType = new TyTy::FnType (function.get_mappings ().get_hirid (),
 				  function.get_mappings ().get_defid (),
 				  function.get_function_name (), ident,
-				  TyTy::FnType::FNTYPE_DEFAULT_FLAGS, ABI::RUST,
+				  TyTy::FnType::FNTYPE_DEFAULT_FLAGS,
+				  function.get_qualifiers ().get_abi (),
 				  std::move (params), ret_type,
 				  std::move (substitutions));
 
   context->insert_type (function.get_mappings (), fnType);
+  infered = fnType;
+
+  if (signature_only)
+    {
+      context->insert_pending_body (function.get_mappings ().get_hirid ());
+      return;
+    }
 
+  check_function_body (function, fnType);
+}
+
+void
+TypeCheckItem::check_function_body (HIR::Function &function,
+				    TyTy::FnType *fn_type)
+{
   // need to get the return type from this
-  TyTy::FnType *resolved_fn_type = fnType;
-  auto expected_ret_tyty = resolved_fn_type->get_return_type ();
+  auto expected_ret_tyty = fn_type->get_return_type ();
   context->push_return_type (TypeCheckContextItem (&function),
 			     expected_ret_tyty);
 
@@ -439,15 +485,18 @@ TypeCheckItem::visit (HIR::Function &function)
 		 function.get_definition ()->get_locus ());
 
   context->pop_return_type ();
-
-  infered = fnType;
 }
 
 void
 TypeCheckItem::visit (HIR::Module &module)
 {
   for (auto &item : module.get_items ())
-    TypeCheckItem::Resolve (*item.get ());
+    {
+      if (signature_only)
+	TypeCheckItem::ResolveSignature (*item.get ());
+      else
+	TypeCheckItem::Resolve (*item.get ());
+    }
 }
 
 void
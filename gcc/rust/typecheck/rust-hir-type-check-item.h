@@ -29,6 +29,10 @@ class TypeCheckItem : private TypeCheckBase, private HIR::HIRVisItemVisitor
 public:
   static TyTy::BaseType *Resolve (HIR::Item &item);
 
+  // resolve the type of an item that is referenced from elsewhere, the body of
+  // a function is left to be checked when the function itself is resolved
+  static TyTy::BaseType *ResolveSignature (HIR::Item &item);
+
   static TyTy::BaseType *ResolveImplItem (HIR::ImplBlock &impl_block,
 					  HIR::ImplItem &item);
 
@@ -65,10 +69,13 @@ protected:
 
   TyTy::BaseType *resolve_impl_block_self (HIR::ImplBlock &impl_block);
 
+  void check_function_body (HIR::Function &function, TyTy::FnType *fn_type);
+
 private:
   TypeCheckItem ();
 
   TyTy::BaseType *infered;
+  bool signature_only;
 };
 
 } // namespace Resolver
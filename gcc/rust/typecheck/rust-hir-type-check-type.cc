@@ -80,7 +80,8 @@ TypeCheckType::visit (HIR::BareFunctionType &fntype)
 
   translated = new TyTy::FnPtr (fntype.get_mappings ().get_hirid (),
 				fntype.get_locus (), std::move (params),
-				TyTy::TyVar (return_type->get_ref ()));
+				TyTy::TyVar (return_type->get_ref ()),
+				fntype.get_function_qualifiers ().get_abi ());
 }
 
 void
@@ -23,6 +23,8 @@
 #include "rust-hir-type-check-pattern.h"
 #include "rust-hir-type-check-struct-field.h"
 #include "rust-hir-inherent-impl-overlap.h"
+#include "rust-name-resolver.h"
+#include "rust-trace.h"
 
 extern bool
 saw_errors (void);
@@ -30,11 +32,39 @@ saw_errors (void);
 namespace Rust {
 namespace Resolver {
 
+// check the body of a top-level item, as one event of -frust-trace
+static void
+resolve_traced (HIR::Item &item)
+{
+  TraceScope trace ("type check", "item");
+  if (trace.is_active ())
+    {
+      auto mappings = Analysis::Mappings::get ();
+      NodeId id = item.get_mappings ().get_nodeid ();
+      const CanonicalPath *path = nullptr;
+      if (mappings->lookup_canonical_path (id, &path))
+	trace.add_arg ("path", path->get ());
+
+      // impl blocks have no path of their own
+      location_t locus = item.get_locus ().gcc_location ();
+      if (LOCATION_FILE (locus) != nullptr)
+	trace.add_arg ("locus", std::string (LOCATION_FILE (locus)) + ":"
+				  + std::to_string (LOCATION_LINE (locus)));
+    }
+
+  TypeCheckItem::Resolve (item);
+}
+
 void
 TypeResolution::Resolve (HIR::Crate &crate)
 {
+  // resolve every item signature first so that function bodies, which only
+  // depend on signatures, can then be checked independently of each other
   for (auto it = crate.items.begin (); it != crate.items.end (); it++)
-    TypeCheckItem::Resolve (*it->get ());
+    TypeCheckItem::ResolveSignature (*it->get ());
+
+  for (auto it = crate.items.begin (); it != crate.items.end (); it++)
+    resolve_traced (*it->get ());
 
   if (saw_errors ())
     return;
@@ -47,37 +77,67 @@ TypeResolution::Resolve (HIR::Crate &crate)
   auto context = TypeCheckContext::get ();
 
   // default inference variables if possible
-  context->iterate ([&] (HirId id, TyTy::BaseType *ty) mutable -> bool {
-    // nothing to do
-    if (ty->get_kind () != TyTy::TypeKind::INFER)
-      return true;
-
-    TyTy::InferType *infer_var = static_cast<TyTy::InferType *> (ty);
-    TyTy::BaseType *default_type;
-    bool ok = infer_var->default_type (&default_type);
-    if (!ok)
-      {
-	rust_error_at (mappings->lookup_location (id),
-		       "type annotations needed");
-	return true;
-      }
-    else
-      {
-	auto result
-	  = TypeCheckBase::unify_site (id, TyTy::TyWithLocation (ty),
-				       TyTy::TyWithLocation (default_type),
-				       Location ());
-	rust_assert (result);
-	rust_assert (result->get_kind () != TyTy::TypeKind::ERROR);
-	result->set_ref (id);
-	context->insert_type (
-	  Analysis::NodeMapping (mappings->get_current_crate (), 0, id,
-				 UNKNOWN_LOCAL_DEFID),
-	  result);
-      }
-
-    return true;
-  });
+  for (HirId id : context->get_inference_variables ())
+    {
+      TyTy::BaseType *ty = nullptr;
+      bool ok = context->lookup_type (id, &ty);
+      rust_assert (ok);
+      // defaulting an earlier variable may have resolved this one
+      if (ty->get_kind () != TyTy::TypeKind::INFER)
+	continue;
+
+      TyTy::InferType *infer_var = static_cast<TyTy::InferType *> (ty);
+      TyTy::BaseType *default_type;
+      ok = infer_var->default_type (&default_type);
+      if (!ok)
+	{
+	  rust_error_at (mappings->lookup_location (id),
+			 "type annotations needed");
+	  continue;
+	}
+
+      auto result
+	= TypeCheckBase::unify_site (id, TyTy::TyWithLocation (ty),
+				     TyTy::TyWithLocation (default_type),
+				     Location ());
+      rust_assert (result);
+      rust_assert (result->get_kind () != TyTy::TypeKind::ERROR);
+      result->set_ref (id);
+      context->insert_type (
+	Analysis::NodeMapping (mappings->get_current_crate (), 0, id,
+			       UNKNOWN_LOCAL_DEFID),
+	result);
+    }
+}
+
+void
+TypeResolution::ResolveSignatures (HIR::Crate &crate)
+{
+  for (auto it = crate.items.begin (); it != crate.items.end (); it++)
+    TypeCheckItem::ResolveSignature (*it->get ());
+}
+
+void
+TypeResolution::ResolveReferencedBodies (HIR::Crate &crate)
+{
+  auto mappings = Analysis::Mappings::get ();
+  auto resolver = Resolver::get ();
+  auto context = TypeCheckContext::get ();
+  CrateNum crate_num = crate.get_mappings ().get_crate_num ();
+
+  // walk the pending bodies rather than the items of the crate, which would
+  // miss the functions nested in modules
+  for (HirId id : context->get_pending_bodies ())
+    {
+      HIR::Item *item = mappings->lookup_hir_item (id);
+      if (item == nullptr
+	  || item->get_mappings ().get_crate_num () != crate_num)
+	continue;
+
+      // Resolve takes the pending body of an already resolved signature
+      if (resolver->is_name_referenced (item->get_mappings ().get_nodeid ()))
+	resolve_traced (*item);
+    }
 }
 
 // rust-hir-trait-ref.h
@@ -286,7 +346,8 @@ TraitItemReference::get_type_from_fn (/*const*/ HIR::TraitItemFunc &fn) const
 			function.is_method ()
 			  ? TyTy::FnType::FNTYPE_IS_METHOD_FLAG
 			  : TyTy::FnType::FNTYPE_DEFAULT_FLAGS,
-			ABI::RUST, std::move (params), ret_type, substitutions);
+			function.get_qualifiers ().get_abi (), std::move (params),
+			ret_type, substitutions);
 
   context->insert_type (fn.get_mappings (), resolved);
   return resolved;
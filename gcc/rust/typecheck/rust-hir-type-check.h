@@ -24,6 +24,7 @@
 #include "rust-tyty.h"
 #include "rust-hir-trait-ref.h"
 #include "rust-autoderef.h"
+#include "rust-compilation-context.h"
 
 namespace Rust {
 namespace Resolver {
@@ -117,14 +118,11 @@ public:
 			 TyTy::BaseType *return_type);
   void pop_return_type ();
 
-  void iterate (std::function<bool (HirId, TyTy::BaseType *)> cb)
-  {
-    for (auto it = resolved.begin (); it != resolved.end (); it++)
-      {
-	if (!cb (it->first, it->second))
-	  return;
-      }
-  }
+  /* The ids whose type is still an inference variable, in increasing order.
+   * The list is a copy, so the types can be replaced while going over it. */
+  std::vector<HirId> get_inference_variables () const;
+
+  bool have_function_context () const { return !return_type_stack.empty (); }
 
   bool have_loop_context () const { return !loop_type_stack.empty (); }
 
@@ -173,6 +171,127 @@ public:
     return true;
   }
 
+  // memo of the trait a trait path resolved to, keyed by the HirId of the
+  // path and by the NodeId of the trait the path names
+  void insert_trait_path_reference (HirId path_id, NodeId trait_node_id,
+				    TraitReference *ref)
+  {
+    trait_path_refs[path_id] = ref;
+    trait_node_refs[trait_node_id] = ref;
+  }
+
+  bool lookup_trait_path_reference (HirId path_id, TraitReference **ref)
+  {
+    auto it = trait_path_refs.find (path_id);
+    if (it == trait_path_refs.end ())
+      return false;
+
+    *ref = it->second;
+    return true;
+  }
+
+  bool lookup_trait_node_reference (NodeId trait_node_id, TraitReference **ref)
+  {
+    auto it = trait_node_refs.find (trait_node_id);
+    if (it == trait_node_refs.end ())
+      return false;
+
+    *ref = it->second;
+    return true;
+  }
+
+  // memo of the Deref/DerefMut operator overload a concrete receiver type
+  // resolved to during autoderef; a null fn records that there is none
+  struct DerefCandidate
+  {
+    const TyTy::BaseType *receiver;
+    TyTy::FnType *fn;
+    HIR::ImplItem *impl_item;
+    Adjustment::AdjustmentType requires_ref_adjustment;
+  };
+
+  void insert_deref_candidate (Analysis::RustLangItem::ItemType lang_item,
+			       const TyTy::BaseType *receiver, TyTy::FnType *fn,
+			       HIR::ImplItem *impl_item,
+			       Adjustment::AdjustmentType requires_ref_adjustment)
+  {
+    auto key = std::make_pair (lang_item, receiver->as_string ());
+    deref_candidates[key].push_back (
+      {receiver->clone (), fn, impl_item, requires_ref_adjustment});
+  }
+
+  bool lookup_deref_candidate (Analysis::RustLangItem::ItemType lang_item,
+			       const TyTy::BaseType *receiver,
+			       const DerefCandidate **candidate)
+  {
+    auto key = std::make_pair (lang_item, receiver->as_string ());
+    auto it = deref_candidates.find (key);
+    if (it == deref_candidates.end ())
+      return false;
+
+    // distinct types can print the same so confirm the receiver matches
+    for (auto &c : it->second)
+      {
+	if (c.receiver->is_equal (*receiver))
+	  {
+	    *candidate = &c;
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  // memo of the successful coercion of a concrete receiver type to a concrete
+  // expected type, so that each coercion site replays the adjustments instead
+  // of searching for them again
+  struct CoercionCandidate
+  {
+    const TyTy::BaseType *receiver;
+    const TyTy::BaseType *expected;
+    std::vector<Adjustment> adjustments;
+    const TyTy::BaseType *result;
+  };
+
+  void insert_coercion (const TyTy::BaseType *receiver,
+			const TyTy::BaseType *expected,
+			const std::vector<Adjustment> &adjustments,
+			const TyTy::BaseType *result)
+  {
+    auto key = std::make_pair (receiver->as_string (), expected->as_string ());
+    coercions[key].push_back ({receiver->clone (), expected->clone (),
+			       adjustments, result->clone ()});
+  }
+
+  bool lookup_coercion (const TyTy::BaseType *receiver,
+			const TyTy::BaseType *expected,
+			const CoercionCandidate **candidate)
+  {
+    auto key = std::make_pair (receiver->as_string (), expected->as_string ());
+    auto it = coercions.find (key);
+    if (it == coercions.end ())
+      return false;
+
+    // distinct types can print the same so confirm both types match
+    for (auto &c : it->second)
+      {
+	if (c.receiver->is_equal (*receiver) && c.expected->is_equal (*expected))
+	  {
+	    *candidate = &c;
+	    return true;
+	  }
+      }
+    return false;
+  }
+
+  // memo of generic ADTs and fns already substituted with concrete generic
+  // arguments, keyed by the type reference of the generic
+  void insert_instantiation (HirId generic_ref,
+			     const TyTy::SubstitutionArgumentMappings &args,
+			     TyTy::BaseType *instance);
+  bool lookup_instantiation (HirId generic_ref,
+			     const TyTy::SubstitutionArgumentMappings &args,
+			     TyTy::BaseType **instance);
+
   void insert_receiver (HirId id, TyTy::BaseType *t)
   {
     receiver_context[id] = t;
@@ -319,6 +438,26 @@ public:
     return true;
   }
 
+  // match expressions, for the exhaustiveness check after type checking
+  void insert_match_expr (HirId id, HIR::MatchExpr *expr)
+  {
+    match_exprs[id] = expr;
+  }
+
+  const std::map<HirId, HIR::MatchExpr *> &get_match_exprs () const
+  {
+    return match_exprs;
+  }
+
+  // the match expressions the exhaustiveness check proved exhaustive, which
+  // lets codegen assume no other value reaches them
+  void insert_exhaustive_match (HirId id) { exhaustive_matches.insert (id); }
+
+  bool is_exhaustive_match (HirId id) const
+  {
+    return exhaustive_matches.find (id) != exhaustive_matches.end ();
+  }
+
   void insert_operator_overload (HirId id, TyTy::FnType *call_site)
   {
     auto it = operator_overloads.find (id);
@@ -372,16 +511,141 @@ public:
     return true;
   }
 
+  // the trait impl blocks bucketed by the head of their Self type, blanket
+  // impls whose Self type has no head are kept in the bucket named by the
+  // empty string
+  void insert_trait_impl_head (const std::string &head, HIR::ImplBlock *impl,
+			       TyTy::BaseType *impl_type)
+  {
+    trait_impl_heads[head].push_back ({impl, impl_type});
+  }
+
+  const std::vector<std::pair<HIR::ImplBlock *, TyTy::BaseType *>> *
+  lookup_trait_impl_head (const std::string &head) const
+  {
+    auto it = trait_impl_heads.find (head);
+    if (it == trait_impl_heads.end ())
+      return nullptr;
+
+    return &it->second;
+  }
+
+  void iterate_trait_impl_heads (
+    std::function<bool (HIR::ImplBlock *, TyTy::BaseType *)> cb)
+  {
+    for (auto it = trait_impl_heads.begin (); it != trait_impl_heads.end ();
+	 it++)
+      {
+	for (auto &impl : it->second)
+	  {
+	    if (!cb (impl.first, impl.second))
+	      return;
+	  }
+      }
+  }
+
+  size_t get_num_indexed_trait_impls () const { return indexed_trait_impls; }
+
+  // the index is only partial while it is being built, probes made while
+  // resolving the Self types of the impl blocks must not use it
+  bool is_indexing_trait_impls () const { return indexing_trait_impls; }
+
+  void reset_trait_impl_heads ()
+  {
+    trait_impl_heads.clear ();
+    probed_bounds.clear ();
+    indexing_trait_impls = true;
+  }
+
+  void set_indexed_trait_impls (size_t num_trait_impls)
+  {
+    indexed_trait_impls = num_trait_impls;
+    indexing_trait_impls = false;
+  }
+
+  void insert_probed_bounds (
+    const std::string &receiver,
+    std::vector<std::pair<TraitReference *, HIR::ImplBlock *>> bounds)
+  {
+    probed_bounds[receiver] = std::move (bounds);
+  }
+
+  bool lookup_probed_bounds (
+    const std::string &receiver,
+    std::vector<std::pair<TraitReference *, HIR::ImplBlock *>> *bounds)
+  {
+    auto it = probed_bounds.find (receiver);
+    if (it == probed_bounds.end ())
+      return false;
+
+    *bounds = it->second;
+    return true;
+  }
+
+  // functions whose signature was resolved on demand through a query and
+  // whose body is checked when the function itself is reached
+  void insert_pending_body (HirId id) { pending_bodies.insert (id); }
+
+  bool take_pending_body (HirId id)
+  {
+    auto it = pending_bodies.find (id);
+    if (it == pending_bodies.end ())
+      return false;
+
+    pending_bodies.erase (it);
+    return true;
+  }
+
+  std::vector<HirId> get_pending_bodies () const
+  {
+    return std::vector<HirId> (pending_bodies.begin (), pending_bodies.end ());
+  }
+
+  // only check the bodies of the functions declared in FILE, the others keep
+  // their body pending
+  void restrict_bodies_to (std::string file) { body_file = std::move (file); }
+
+  bool body_is_deferred (Location locus) const
+  {
+    if (body_file.empty ())
+      return false;
+
+    const char *file = LOCATION_FILE (locus.gcc_location ());
+    return file == nullptr || body_file.compare (file) != 0;
+  }
+
 private:
+  friend class Rust::CompilationContext;
   TypeCheckContext ();
 
   std::map<NodeId, HirId> node_id_refs;
-  std::map<HirId, TyTy::BaseType *> resolved;
+  void set_resolved (HirId id, TyTy::BaseType *type);
+
+  DenseIdMap<TyTy::BaseType *> resolved;
+  // the ids of RESOLVED whose type is an inference variable, so that they can
+  // be defaulted without going over every resolved type
+  std::set<HirId> inference_vars;
   std::vector<std::unique_ptr<TyTy::BaseType>> builtins;
   std::vector<std::pair<TypeCheckContextItem, TyTy::BaseType *>>
     return_type_stack;
   std::vector<TyTy::BaseType *> loop_type_stack;
   std::map<DefId, TraitReference> trait_context;
+  std::map<HirId, TraitReference *> trait_path_refs;
+  std::map<NodeId, TraitReference *> trait_node_refs;
+  std::map<std::pair<Analysis::RustLangItem::ItemType, std::string>,
+	   std::vector<DerefCandidate>>
+    deref_candidates;
+  std::map<std::pair<std::string, std::string>,
+	   std::vector<CoercionCandidate>>
+    coercions;
+
+  struct Instantiation
+  {
+    std::vector<TyTy::BaseType *> args;
+    TyTy::BaseType *instance;
+  };
+  std::map<std::pair<HirId, std::string>, std::vector<Instantiation>>
+    instantiations;
   std::map<HirId, TyTy::BaseType *> receiver_context;
   std::map<HirId, AssociatedImplTrait> associated_impl_traits;
 
@@ -401,17 +665,45 @@ private:
   // variants
   std::map<HirId, HirId> variants;
 
+  // match expressions
+  std::map<HirId, HIR::MatchExpr *> match_exprs;
+  std::set<HirId> exhaustive_matches;
+
   // unconstrained type-params check
   std::map<HirId, bool> unconstrained;
 
   // predicates
   std::map<HirId, TyTy::TypeBoundPredicate> predicates;
+
+  // trait impl index and bounds probe cache
+  std::map<std::string,
+	   std::vector<std::pair<HIR::ImplBlock *, TyTy::BaseType *>>>
+    trait_impl_heads;
+  size_t indexed_trait_impls;
+  bool indexing_trait_impls;
+  std::map<std::string,
+	   std::vector<std::pair<TraitReference *, HIR::ImplBlock *>>>
+    probed_bounds;
+
+  // queried functions with unchecked bodies
+  std::set<HirId> pending_bodies;
+
+  // the file of -frust-check-bodies-in, if any
+  std::string body_file;
 };
 
 class TypeResolution
 {
 public:
   static void Resolve (HIR::Crate &crate);
+
+  // resolve the item signatures of an extern crate, its function bodies are
+  // left pending until something is known to refer to them
+  static void ResolveSignatures (HIR::Crate &crate);
+
+  // check the pending bodies of the functions in CRATE that some resolved
+  // name refers to
+  static void ResolveReferencedBodies (HIR::Crate &crate);
 };
 
 } // namespace Resolver
@@ -18,10 +18,52 @@
 
 #include "rust-substitution-mapper.h"
 #include "rust-hir-type-check.h"
+#include "diagnostic.h"
 
 namespace Rust {
 namespace Resolver {
 
+// The same generic is named with the same concrete arguments all over a crate,
+// so the substitution done the first time is remembered. Each use still gets
+// its own copy since callers go on to set the reference of what they get.
+template <typename T>
+static T *
+instantiate_generic (T &type, TyTy::SubstitutionArgumentMappings &mappings)
+{
+  auto context = TypeCheckContext::get ();
+  bool cacheable = mappings.is_concrete ()
+		   && mappings.get_subst_cb () == nullptr
+		   && !mappings.trait_item_mode ();
+
+  TyTy::BaseType *instance = nullptr;
+  if (cacheable
+      && context->lookup_instantiation (type.get_ty_ref (), mappings,
+					&instance))
+    return static_cast<T *> (instance->clone ());
+
+  // an instantiation that was diagnosed must be diagnosed again at each use
+  int errors_before = errorcount;
+  T *concrete = type.handle_substitions (mappings);
+  if (cacheable && concrete != nullptr && errorcount == errors_before)
+    context->insert_instantiation (type.get_ty_ref (), mappings, concrete);
+
+  return concrete;
+}
+
+TyTy::FnType *
+SubstMapper::instantiate (TyTy::FnType &type,
+			  TyTy::SubstitutionArgumentMappings &mappings)
+{
+  return instantiate_generic (type, mappings);
+}
+
+TyTy::ADTType *
+SubstMapper::instantiate (TyTy::ADTType &type,
+			  TyTy::SubstitutionArgumentMappings &mappings)
+{
+  return instantiate_generic (type, mappings);
+}
+
 TyTy::BaseType *
 SubstMapperInternal::Resolve (TyTy::BaseType *base,
 			      TyTy::SubstitutionArgumentMappings &mappings)
@@ -60,7 +60,7 @@ public:
 	if (mappings.is_error ())
 	  return;
 
-	concrete = type.handle_substitions (mappings);
+	concrete = instantiate (type, mappings);
       }
 
     if (concrete != nullptr)
@@ -83,7 +83,7 @@ public:
 	if (mappings.is_error ())
 	  return;
 
-	concrete = type.handle_substitions (mappings);
+	concrete = instantiate (type, mappings);
       }
 
     if (concrete != nullptr)
@@ -142,6 +142,15 @@ public:
   void visit (TyTy::ClosureType &) override { gcc_unreachable (); }
 
 private:
+  // substitute the generic arguments, reusing an earlier instantiation of
+  // the same generic with the same concrete arguments
+  static TyTy::FnType *
+  instantiate (TyTy::FnType &type,
+	       TyTy::SubstitutionArgumentMappings &mappings);
+  static TyTy::ADTType *
+  instantiate (TyTy::ADTType &type,
+	       TyTy::SubstitutionArgumentMappings &mappings);
+
   SubstMapper (HirId ref, HIR::GenericArgs *generics, Location locus)
     : resolved (new TyTy::ErrorType (ref)), generics (generics), locus (locus)
   {}
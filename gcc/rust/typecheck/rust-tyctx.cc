@@ -24,14 +24,12 @@ namespace Resolver {
 TypeCheckContext *
 TypeCheckContext::get ()
 {
-  static TypeCheckContext *instance;
-  if (instance == nullptr)
-    instance = new TypeCheckContext ();
-
-  return instance;
+  return &CompilationContext::current ().get_type_check_context ();
 }
 
-TypeCheckContext::TypeCheckContext () {}
+TypeCheckContext::TypeCheckContext ()
+  : indexed_trait_impls (0), indexing_trait_impls (false)
+{}
 
 TypeCheckContext::~TypeCheckContext () {}
 
@@ -42,11 +40,11 @@ TypeCheckContext::lookup_builtin (NodeId id, TyTy::BaseType **type)
   if (ref_it == node_id_refs.end ())
     return false;
 
-  auto it = resolved.find (ref_it->second);
-  if (it == resolved.end ())
+  TyTy::BaseType *const *found = resolved.lookup (ref_it->second);
+  if (found == nullptr)
     return false;
 
-  *type = it->second;
+  *type = *found;
   return true;
 }
 
@@ -68,7 +66,7 @@ void
 TypeCheckContext::insert_builtin (HirId id, NodeId ref, TyTy::BaseType *type)
 {
   node_id_refs[ref] = id;
-  resolved[id] = type;
+  set_resolved (id, type);
   builtins.push_back (std::unique_ptr<TyTy::BaseType> (type));
 }
 
@@ -80,34 +78,50 @@ TypeCheckContext::insert_type (const Analysis::NodeMapping &mappings,
   NodeId ref = mappings.get_nodeid ();
   HirId id = mappings.get_hirid ();
   node_id_refs[ref] = id;
-  resolved[id] = type;
+  set_resolved (id, type);
 }
 
 void
 TypeCheckContext::insert_implicit_type (TyTy::BaseType *type)
 {
   rust_assert (type != nullptr);
-  resolved[type->get_ref ()] = type;
+  set_resolved (type->get_ref (), type);
 }
 
 void
 TypeCheckContext::insert_implicit_type (HirId id, TyTy::BaseType *type)
 {
   rust_assert (type != nullptr);
-  resolved[id] = type;
+  set_resolved (id, type);
+}
+
+void
+TypeCheckContext::set_resolved (HirId id, TyTy::BaseType *type)
+{
+  resolved.insert (id, type);
+  if (type->get_kind () == TyTy::TypeKind::INFER)
+    inference_vars.insert (id);
+  else
+    inference_vars.erase (id);
 }
 
 bool
 TypeCheckContext::lookup_type (HirId id, TyTy::BaseType **type) const
 {
-  auto it = resolved.find (id);
-  if (it == resolved.end ())
+  TyTy::BaseType *const *found = resolved.lookup (id);
+  if (found == nullptr)
     return false;
 
-  *type = it->second;
+  *type = *found;
   return true;
 }
 
+std::vector<HirId>
+TypeCheckContext::get_inference_variables () const
+{
+  return std::vector<HirId> (inference_vars.begin (), inference_vars.end ());
+}
+
 void
 TypeCheckContext::insert_type_by_node_id (NodeId ref, HirId id)
 {
@@ -154,5 +168,55 @@ TypeCheckContext::peek_context ()
   return return_type_stack.back ().first;
 }
 
+static std::string
+instantiation_key (const TyTy::SubstitutionArgumentMappings &args)
+{
+  std::string key;
+  for (auto &arg : args.get_mappings ())
+    key += arg.get_tyty ()->as_string () + ",";
+  return key;
+}
+
+void
+TypeCheckContext::insert_instantiation (
+  HirId generic_ref, const TyTy::SubstitutionArgumentMappings &args,
+  TyTy::BaseType *instance)
+{
+  Instantiation entry;
+  for (auto &arg : args.get_mappings ())
+    entry.args.push_back (arg.get_tyty ()->clone ());
+  entry.instance = instance->clone ();
+
+  auto key = std::make_pair (generic_ref, instantiation_key (args));
+  instantiations[key].push_back (std::move (entry));
+}
+
+bool
+TypeCheckContext::lookup_instantiation (
+  HirId generic_ref, const TyTy::SubstitutionArgumentMappings &args,
+  TyTy::BaseType **instance)
+{
+  auto key = std::make_pair (generic_ref, instantiation_key (args));
+  auto it = instantiations.find (key);
+  if (it == instantiations.end ())
+    return false;
+
+  // distinct types can print the same so confirm the arguments match
+  const std::vector<TyTy::SubstitutionArg> &mappings = args.get_mappings ();
+  for (auto &entry : it->second)
+    {
+      bool matches = entry.args.size () == mappings.size ();
+      for (size_t i = 0; matches && i < mappings.size (); i++)
+	matches = entry.args.at (i)->is_equal (*mappings.at (i).get_tyty ());
+
+      if (matches)
+	{
+	  *instance = entry.instance;
+	  return true;
+	}
+    }
+  return false;
+}
+
 } // namespace Resolver
 } // namespace Rust
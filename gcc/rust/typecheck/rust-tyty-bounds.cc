@@ -24,29 +24,107 @@ namespace Rust {
 namespace Resolver {
 
 void
-TypeBoundsProbe::scan ()
+TypeBoundsProbe::build_trait_impl_index ()
 {
-  std::vector<std::pair<HIR::TypePath *, HIR::ImplBlock *>>
-    possible_trait_paths;
-  mappings->iterate_impl_blocks (
+  context->reset_trait_impl_heads ();
+  mappings->iterate_trait_impl_blocks (
     [&] (HirId id, HIR::ImplBlock *impl) mutable -> bool {
-      // we are filtering for trait-impl-blocks
-      if (!impl->has_trait_ref ())
-	return true;
-
       TyTy::BaseType *impl_type = TypeCheckItem::ResolveImplBlockSelf (*impl);
       if (impl_type->get_kind () == TyTy::TypeKind::ERROR)
 	return true;
 
+      std::string head;
+      if (!get_type_head (impl_type, head))
+	head = "";
+
+      context->insert_trait_impl_head (head, impl, impl_type);
+      return true;
+    });
+
+  // only mark the blocks as indexed once every bucket is filled
+  context->set_indexed_trait_impls (mappings->get_num_trait_impl_blocks ());
+}
+
+void
+TypeBoundsProbe::scan ()
+{
+  // resolving the Self type of an impl block while the index is built can
+  // probe again, those probes walk every impl block instead
+  bool indexing = context->is_indexing_trait_impls ();
+
+  // new impl blocks are only added when another crate has been loaded
+  if (!indexing
+      && context->get_num_indexed_trait_impls ()
+	   != mappings->get_num_trait_impl_blocks ())
+    build_trait_impl_index ();
+
+  std::string head;
+  bool has_head = !indexing && get_type_head (receiver, head);
+
+  // the result only depends on the structure of the receiver when it is not
+  // an inference variable or generic
+  std::string receiver_key;
+  if (has_head)
+    {
+      receiver_key = receiver->as_string ();
+      if (context->lookup_probed_bounds (receiver_key, &trait_references))
+	return;
+    }
+
+  std::vector<std::pair<HIR::ImplBlock *, TyTy::BaseType *>> candidates;
+  if (has_head)
+    {
+      for (auto &bucket : {head, std::string ("")})
+	{
+	  auto impls = context->lookup_trait_impl_head (bucket);
+	  if (impls != nullptr)
+	    candidates.insert (candidates.end (), impls->begin (),
+			       impls->end ());
+	}
+    }
+  else if (indexing)
+    {
+      mappings->iterate_trait_impl_blocks (
+	[&] (HirId id, HIR::ImplBlock *impl) mutable -> bool {
+	  TyTy::BaseType *impl_type
+	    = TypeCheckItem::ResolveImplBlockSelf (*impl);
+	  if (impl_type->get_kind () != TyTy::TypeKind::ERROR)
+	    candidates.push_back ({impl, impl_type});
+	  return true;
+	});
+    }
+  else
+    {
+      context->iterate_trait_impl_heads (
+	[&] (HIR::ImplBlock *impl, TyTy::BaseType *impl_type) mutable -> bool {
+	  candidates.push_back ({impl, impl_type});
+	  return true;
+	});
+    }
+
+  // keep the order of the impl blocks consistent regardless of the bucket
+  // they came from
+  std::sort (candidates.begin (), candidates.end (),
+	     [] (const std::pair<HIR::ImplBlock *, TyTy::BaseType *> &a,
+		 const std::pair<HIR::ImplBlock *, TyTy::BaseType *> &b) {
+	       return a.first->get_mappings ().get_hirid ()
+		      < b.first->get_mappings ().get_hirid ();
+	     });
+
+  std::vector<std::pair<HIR::TypePath *, HIR::ImplBlock *>>
+    possible_trait_paths;
+  for (auto &candidate : candidates)
+    {
+      HIR::ImplBlock *impl = candidate.first;
+      TyTy::BaseType *impl_type = candidate.second;
       if (!receiver->can_eq (impl_type, false))
 	{
 	  if (!impl_type->can_eq (receiver, false))
-	    return true;
+	    continue;
 	}
 
       possible_trait_paths.push_back ({impl->get_trait_ref ().get (), impl});
-      return true;
-    });
+    }
 
   for (auto &path : possible_trait_paths)
     {
@@ -56,6 +134,9 @@ TypeBoundsProbe::scan ()
       if (!trait_ref->is_error ())
 	trait_references.push_back ({trait_ref, path.second});
     }
+
+  if (has_head)
+    context->insert_probed_bounds (receiver_key, trait_references);
 }
 
 TraitReference *
@@ -143,10 +224,12 @@ TypeBoundPredicate::TypeBoundPredicate (const TypeBoundPredicate &other)
     error_flag (other.error_flag)
 {
   substitutions.clear ();
+  substitutions.reserve (other.get_substs ().size ());
   for (const auto &p : other.get_substs ())
     substitutions.push_back (p.clone ());
 
   std::vector<SubstitutionArg> mappings;
+  mappings.reserve (other.used_arguments.get_mappings ().size ());
   for (size_t i = 0; i < other.used_arguments.get_mappings ().size (); i++)
     {
       const SubstitutionArg &oa = other.used_arguments.get_mappings ().at (i);
@@ -179,10 +262,12 @@ TypeBoundPredicate::operator= (const TypeBoundPredicate &other)
   used_arguments = SubstitutionArgumentMappings::error ();
 
   substitutions.clear ();
+  substitutions.reserve (other.get_substs ().size ());
   for (const auto &p : other.get_substs ())
     substitutions.push_back (p.clone ());
 
   std::vector<SubstitutionArg> mappings;
+  mappings.reserve (other.used_arguments.get_mappings ().size ());
   for (size_t i = 0; i < other.used_arguments.get_mappings ().size (); i++)
     {
       const SubstitutionArg &oa = other.used_arguments.get_mappings ().at (i);
@@ -420,7 +505,7 @@ TypeBoundPredicateItem::get_locus () const
 
 TypeBoundsMappings::TypeBoundsMappings (
   std::vector<TypeBoundPredicate> specified_bounds)
-  : specified_bounds (specified_bounds)
+  : specified_bounds (std::move (specified_bounds))
 {}
 
 std::vector<TypeBoundPredicate> &
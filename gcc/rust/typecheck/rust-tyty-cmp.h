@@ -784,7 +784,8 @@ public:
 
   void visit (const FnPtr &type) override
   {
-    if (base->num_params () != type.num_params ())
+    if (base->get_abi () != type.get_abi ()
+	|| base->num_params () != type.num_params ())
       {
 	BaseCmp::visit (type);
 	return;
@@ -814,7 +815,8 @@ public:
 
   void visit (const FnType &type) override
   {
-    if (base->num_params () != type.num_params ())
+    if (base->get_abi () != type.get_abi ()
+	|| base->num_params () != type.num_params ())
       {
 	BaseCmp::visit (type);
 	return;
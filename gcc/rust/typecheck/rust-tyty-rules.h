@@ -78,7 +78,12 @@ public:
 	return get_base ()->unify (other);
       }
 
-    other->accept_vis (*this);
+    bool fast_path = is_trivially_unified (other);
+    note_unify (get_base ()->get_kind (), fast_path);
+    if (fast_path)
+      resolved = other->clone ();
+    else
+      other->accept_vis (*this);
     if (resolved->get_kind () == TyTy::TypeKind::ERROR)
       return resolved;
 
@@ -190,6 +195,47 @@ protected:
 private:
   /* Returns a pointer to the ty that created this rule. */
   virtual BaseType *get_base () = 0;
+
+  /* Unifying a type with itself, with the same primitive, or with an equal
+     type that has nothing left to infer cannot learn anything, so the result is
+     just a copy of OTHER and the rules need not be dispatched. */
+  bool is_trivially_unified (const BaseType *other)
+  {
+    const BaseType *base = get_base ();
+    switch (base->get_kind ())
+      {
+      case TypeKind::BOOL:
+      case TypeKind::CHAR:
+      case TypeKind::INT:
+      case TypeKind::UINT:
+      case TypeKind::FLOAT:
+      case TypeKind::USIZE:
+      case TypeKind::ISIZE:
+      case TypeKind::STR:
+      case TypeKind::ADT:
+      case TypeKind::REF:
+      case TypeKind::POINTER:
+      case TypeKind::ARRAY:
+      case TypeKind::SLICE:
+      case TypeKind::TUPLE:
+	break;
+
+      default:
+	return false;
+      }
+
+    if (base == other)
+      return true;
+
+    if (base->get_kind () != other->get_kind ())
+      return false;
+
+    if (is_primitive_type_kind (base->get_kind ()))
+      return base->is_equal (*other);
+
+    return base->is_concrete () && other->is_concrete ()
+	   && base->is_equal (*other);
+  }
 };
 
 class InferRules : public BaseRules
@@ -543,6 +589,12 @@ public:
 
   void visit (FnPtr &type) override
   {
+    if (base->get_abi () != type.get_abi ())
+      {
+	BaseRules::visit (type);
+	return;
+      }
+
     auto this_ret_type = base->get_return_type ();
     auto other_ret_type = type.get_return_type ();
     auto unified_result = this_ret_type->unify (other_ret_type);
@@ -578,6 +630,12 @@ public:
 
   void visit (FnType &type) override
   {
+    if (base->get_abi () != type.get_abi ())
+      {
+	BaseRules::visit (type);
+	return;
+      }
+
     auto this_ret_type = base->get_return_type ();
     auto other_ret_type = type.get_return_type ();
     auto unified_result = this_ret_type->unify (other_ret_type);
@@ -132,6 +132,172 @@ is_primitive_type_kind (TypeKind kind)
     }
 }
 
+size_t BaseType::num_created = 0;
+
+static bool unify_profiling = false;
+static UnifyStats unify_stats = {};
+
+void
+set_unify_profiling (bool enabled)
+{
+  unify_profiling = enabled;
+}
+
+void
+note_unify (TypeKind kind, bool fast_path)
+{
+  if (!unify_profiling)
+    return;
+
+  unify_stats.calls[kind]++;
+  if (fast_path)
+    unify_stats.fast_paths[kind]++;
+}
+
+const UnifyStats &
+get_unify_stats ()
+{
+  return unify_stats;
+}
+
+// How can_eq settles a pair of kinds without going through the Cmp rules
+enum class KindCmp : uint8_t
+{
+  // structural types, or kinds which the rules resolve first
+  RULES,
+  EQUAL,
+  NOT_EQUAL,
+  // equal when the int, uint or float kinds match as well
+  SAME_WIDTH,
+  // the inference variables accepted by a scalar type
+  INFER_GENERAL,
+  INFER_NOT_FLOAT,
+  INFER_NOT_INTEGRAL,
+};
+
+static KindCmp
+kind_cmp (TypeKind base, TypeKind other)
+{
+  KindCmp infer;
+  switch (base)
+    {
+    case TypeKind::BOOL:
+    case TypeKind::CHAR:
+    case TypeKind::STR:
+    case TypeKind::NEVER:
+      infer = KindCmp::INFER_GENERAL;
+      break;
+    case TypeKind::INT:
+    case TypeKind::UINT:
+    case TypeKind::USIZE:
+    case TypeKind::ISIZE:
+      infer = KindCmp::INFER_NOT_FLOAT;
+      break;
+    case TypeKind::FLOAT:
+      infer = KindCmp::INFER_NOT_INTEGRAL;
+      break;
+    default:
+      return KindCmp::RULES;
+    }
+
+  switch (other)
+    {
+    case TypeKind::INFER:
+      return infer;
+    case TypeKind::PARAM:
+    case TypeKind::PLACEHOLDER:
+    case TypeKind::PROJECTION:
+      return KindCmp::RULES;
+    default:
+      break;
+    }
+
+  if (other != base)
+    return KindCmp::NOT_EQUAL;
+
+  bool sized = base == TypeKind::INT || base == TypeKind::UINT
+	       || base == TypeKind::FLOAT;
+  return sized ? KindCmp::SAME_WIDTH : KindCmp::EQUAL;
+}
+
+// kind_cmp as a TypeKind x TypeKind table, computed on first use
+static KindCmp
+lookup_kind_cmp (TypeKind base, TypeKind other)
+{
+  static const size_t num_kinds = TypeKind::ERROR + 1;
+  static KindCmp table[num_kinds][num_kinds];
+  static bool initialized = false;
+  if (!initialized)
+    {
+      for (size_t i = 0; i < num_kinds; i++)
+	for (size_t j = 0; j < num_kinds; j++)
+	  table[i][j] = kind_cmp (static_cast<TypeKind> (i),
+				  static_cast<TypeKind> (j));
+      initialized = true;
+    }
+
+  return table[base][other];
+}
+
+static bool
+same_width (const BaseType *base, const BaseType *other)
+{
+  switch (base->get_kind ())
+    {
+    case TypeKind::INT:
+      return static_cast<const IntType *> (base)->get_int_kind ()
+	     == static_cast<const IntType *> (other)->get_int_kind ();
+    case TypeKind::UINT:
+      return static_cast<const UintType *> (base)->get_uint_kind ()
+	     == static_cast<const UintType *> (other)->get_uint_kind ();
+    case TypeKind::FLOAT:
+      return static_cast<const FloatType *> (base)->get_float_kind ()
+	     == static_cast<const FloatType *> (other)->get_float_kind ();
+    default:
+      gcc_unreachable ();
+    }
+}
+
+/* Settle BASE->can_eq (OTHER) for the scalar types, which are compared by
+   their kind alone, without building a Cmp rule and dispatching on OTHER.
+   Returns false when the rules are needed, which includes every mismatch that
+   has to be reported. */
+static bool
+can_eq_by_kind (const BaseType *base, const BaseType *other, bool emit_errors,
+		bool *result)
+{
+  InferType::InferTypeKind infer_kind = InferType::InferTypeKind::GENERAL;
+  KindCmp cmp = lookup_kind_cmp (base->get_kind (), other->get_kind ());
+  if (other->get_kind () == TypeKind::INFER)
+    infer_kind = static_cast<const InferType *> (other)->get_infer_kind ();
+
+  switch (cmp)
+    {
+    case KindCmp::RULES:
+      return false;
+    case KindCmp::EQUAL:
+      *result = true;
+      break;
+    case KindCmp::NOT_EQUAL:
+      *result = false;
+      break;
+    case KindCmp::SAME_WIDTH:
+      *result = same_width (base, other);
+      break;
+    case KindCmp::INFER_GENERAL:
+      *result = infer_kind == InferType::InferTypeKind::GENERAL;
+      break;
+    case KindCmp::INFER_NOT_FLOAT:
+      *result = infer_kind != InferType::InferTypeKind::FLOAT;
+      break;
+    case KindCmp::INFER_NOT_INTEGRAL:
+      *result = infer_kind != InferType::InferTypeKind::INTEGRAL;
+      break;
+    }
+
+  return *result || !emit_errors;
+}
+
 bool
 BaseType::satisfies_bound (const TypeBoundPredicate &predicate) const
 {
@@ -352,7 +518,7 @@ TyVar::get_implicit_infer_var (Location locus)
 					       infer->get_ref (),
 					       UNKNOWN_LOCAL_DEFID),
 			infer);
-  mappings->insert_location (infer->get_ref (), locus);
+  mappings->insert_inference_location (infer->get_ref (), locus);
 
   return TyVar (infer->get_ref ());
 }
@@ -377,7 +543,16 @@ TyVar::subst_covariant_var (TyTy::BaseType *orig, TyTy::BaseType *subst)
 TyVar
 TyVar::clone () const
 {
-  TyTy::BaseType *c = get_tyty ()->clone ();
+  // A TyVar names the type registered for its reference, so a copy of any
+  // type that keeps that reference is simply the same TyVar. Deep cloning it
+  // only to read back the reference would throw the copy away. Inference
+  // variables are the exception as their clone is a fresh variable chained to
+  // this one.
+  TyTy::BaseType *ty = get_tyty ();
+  if (ty->get_kind () != TyTy::TypeKind::INFER)
+    return TyVar (ref);
+
+  TyTy::BaseType *c = ty->clone ();
   return TyVar (c->get_ref ());
 }
 
@@ -475,8 +650,8 @@ InferType::clone () const
 					       clone->get_ref (),
 					       UNKNOWN_LOCAL_DEFID),
 			clone);
-  mappings->insert_location (clone->get_ref (),
-			     mappings->lookup_location (get_ref ()));
+  mappings->insert_inference_location (clone->get_ref (),
+				       mappings->lookup_location (get_ref ()));
 
   // setup the chain to reference this
   clone->append_reference (get_ref ());
@@ -790,6 +965,7 @@ SubstitutionRef::adjust_mappings_for_this (
   SubstitutionArgumentMappings &mappings)
 {
   std::vector<SubstitutionArg> resolved_mappings;
+  resolved_mappings.reserve (substitutions.size ());
   for (size_t i = 0; i < substitutions.size (); i++)
     {
       auto &subst = substitutions.at (i);
@@ -834,6 +1010,7 @@ bool
 SubstitutionRef::are_mappings_bound (SubstitutionArgumentMappings &mappings)
 {
   std::vector<SubstitutionArg> resolved_mappings;
+  resolved_mappings.reserve (substitutions.size ());
   for (size_t i = 0; i < substitutions.size (); i++)
     {
       auto &subst = substitutions.at (i);
@@ -1097,6 +1274,7 @@ BaseType *
 ADTType::clone () const
 {
   std::vector<VariantDef *> cloned_variants;
+  cloned_variants.reserve (variants.size ());
   for (auto &variant : variants)
     cloned_variants.push_back (variant->clone ());
 
@@ -1110,6 +1288,7 @@ BaseType *
 ADTType::monomorphized_clone () const
 {
   std::vector<VariantDef *> cloned_variants;
+  cloned_variants.reserve (variants.size ());
   for (auto &variant : variants)
     cloned_variants.push_back (variant->monomorphized_clone ());
 
@@ -1286,6 +1465,7 @@ BaseType *
 TupleType::clone () const
 {
   std::vector<TyVar> cloned_fields;
+  cloned_fields.reserve (fields.size ());
   for (const auto &f : fields)
     cloned_fields.push_back (f.clone ());
 
@@ -1297,6 +1477,7 @@ BaseType *
 TupleType::monomorphized_clone () const
 {
   std::vector<TyVar> cloned_fields;
+  cloned_fields.reserve (fields.size ());
   for (const auto &f : fields)
     cloned_fields.push_back (f.monomorphized_clone ());
 
@@ -1423,6 +1604,7 @@ BaseType *
 FnType::clone () const
 {
   std::vector<std::pair<HIR::Pattern *, BaseType *>> cloned_params;
+  cloned_params.reserve (params.size ());
   for (auto &p : params)
     cloned_params.push_back ({p.first, p.second->clone ()});
 
@@ -1436,6 +1618,7 @@ BaseType *
 FnType::monomorphized_clone () const
 {
   std::vector<std::pair<HIR::Pattern *, BaseType *>> cloned_params;
+  cloned_params.reserve (params.size ());
   for (auto &p : params)
     cloned_params.push_back ({p.first, p.second->monomorphized_clone ()});
 
@@ -1585,7 +1768,12 @@ FnPtr::as_string () const
       params_str += p.get_tyty ()->as_string () + " ,";
     }
 
-  return "fnptr (" + params_str + ") -> " + get_return_type ()->as_string ();
+  std::string abi_str;
+  if (abi != ABI::RUST)
+    abi_str = "extern \"" + get_string_from_abi (abi) + "\" ";
+
+  return abi_str + "fnptr (" + params_str + ") -> "
+	 + get_return_type ()->as_string ();
 }
 
 BaseType *
@@ -1609,6 +1797,9 @@ FnPtr::is_equal (const BaseType &other) const
     return false;
 
   auto other2 = static_cast<const FnPtr &> (other);
+  if (get_abi () != other2.get_abi ())
+    return false;
+
   auto this_ret_type = get_return_type ();
   auto other_ret_type = other2.get_return_type ();
   if (this_ret_type->is_equal (*other_ret_type))
@@ -1629,11 +1820,12 @@ BaseType *
 FnPtr::clone () const
 {
   std::vector<TyVar> cloned_params;
+  cloned_params.reserve (params.size ());
   for (auto &p : params)
     cloned_params.push_back (TyVar (p.get_ref ()));
 
   return new FnPtr (get_ref (), get_ty_ref (), ident.locus,
-		    std::move (cloned_params), result_type,
+		    std::move (cloned_params), result_type, get_abi (),
 		    get_combined_refs ());
 }
 
@@ -1641,11 +1833,12 @@ BaseType *
 FnPtr::monomorphized_clone () const
 {
   std::vector<TyVar> cloned_params;
+  cloned_params.reserve (params.size ());
   for (auto &p : params)
     cloned_params.push_back (p.monomorphized_clone ());
 
   return new FnPtr (get_ref (), get_ty_ref (), ident.locus,
-		    std::move (cloned_params), result_type,
+		    std::move (cloned_params), result_type, get_abi (),
 		    get_combined_refs ());
 }
 
@@ -1902,6 +2095,10 @@ BoolType::unify (BaseType *other)
 bool
 BoolType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   BoolCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -1960,6 +2157,10 @@ IntType::unify (BaseType *other)
 bool
 IntType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   IntCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -2029,6 +2230,10 @@ UintType::unify (BaseType *other)
 bool
 UintType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   UintCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -2092,6 +2297,10 @@ FloatType::unify (BaseType *other)
 bool
 FloatType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   FloatCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -2147,6 +2356,10 @@ USizeType::unify (BaseType *other)
 bool
 USizeType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   USizeCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -2191,6 +2404,10 @@ ISizeType::unify (BaseType *other)
 bool
 ISizeType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   ISizeCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -2235,6 +2452,10 @@ CharType::unify (BaseType *other)
 bool
 CharType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   CharCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -2612,6 +2833,10 @@ StrType::unify (BaseType *other)
 bool
 StrType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   StrCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -2650,6 +2875,10 @@ NeverType::unify (BaseType *other)
 bool
 NeverType::can_eq (const BaseType *other, bool emit_errors) const
 {
+  bool result;
+  if (can_eq_by_kind (this, other, emit_errors, &result))
+    return result;
+
   NeverCmp r (this, emit_errors);
   return r.can_eq (other);
 }
@@ -76,6 +76,23 @@ public:
   static std::string to_string (TypeKind kind);
 };
 
+// How often unification ran for each kind of type on the expected side, and
+// how many of those were settled without dispatching through the rules
+struct UnifyStats
+{
+  size_t calls[TypeKind::ERROR + 1];
+  size_t fast_paths[TypeKind::ERROR + 1];
+};
+
+extern void
+set_unify_profiling (bool enabled);
+
+extern void
+note_unify (TypeKind kind, bool fast_path);
+
+extern const UnifyStats &
+get_unify_stats ();
+
 class BaseType;
 class TypeBoundPredicate;
 class TypeBoundPredicateItem
@@ -252,15 +269,19 @@ protected:
 	    std::set<HirId> refs = std::set<HirId> ())
     : TypeBoundsMappings ({}), kind (kind), ref (ref), ty_ref (ty_ref),
       combined (refs), ident (ident), mappings (Analysis::Mappings::get ())
-  {}
+  {
+    num_created++;
+  }
 
   BaseType (HirId ref, HirId ty_ref, TypeKind kind, RustIdent ident,
 	    std::vector<TypeBoundPredicate> specified_bounds,
 	    std::set<HirId> refs = std::set<HirId> ())
-    : TypeBoundsMappings (specified_bounds), kind (kind), ref (ref),
+    : TypeBoundsMappings (std::move (specified_bounds)), kind (kind), ref (ref),
       ty_ref (ty_ref), combined (refs), ident (ident),
       mappings (Analysis::Mappings::get ())
-  {}
+  {
+    num_created++;
+  }
 
   TypeKind kind;
   HirId ref;
@@ -269,6 +290,10 @@ protected:
   RustIdent ident;
 
   Analysis::Mappings *mappings;
+
+public:
+  // how many types have been constructed, for -frust-dump-mem
+  static size_t num_created;
 };
 
 // this is a placeholder for types that can change like inference variables
@@ -496,7 +521,7 @@ public:
 	     std::set<HirId> refs = std::set<HirId> ())
     : BaseType (ref, ref, TypeKind::TUPLE,
 		{Resolver::CanonicalPath::create_empty (), locus}, refs),
-      fields (fields)
+      fields (std::move (fields))
   {}
 
   TupleType (HirId ref, HirId ty_ref, Location locus,
@@ -504,7 +529,7 @@ public:
 	     std::set<HirId> refs = std::set<HirId> ())
     : BaseType (ref, ty_ref, TypeKind::TUPLE,
 		{Resolver::CanonicalPath::create_empty (), locus}, refs),
-      fields (fields)
+      fields (std::move (fields))
   {}
 
   static TupleType *get_unit_type (HirId ref)
@@ -673,8 +698,8 @@ public:
 				Location locus,
 				ParamSubstCb param_subst_cb = nullptr,
 				bool trait_item_flag = false)
-    : mappings (mappings), locus (locus), param_subst_cb (param_subst_cb),
-      trait_item_flag (trait_item_flag)
+    : mappings (std::move (mappings)), locus (locus),
+      param_subst_cb (param_subst_cb), trait_item_flag (trait_item_flag)
   {}
 
   SubstitutionArgumentMappings (const SubstitutionArgumentMappings &other)
@@ -694,6 +719,23 @@ public:
     return *this;
   }
 
+  SubstitutionArgumentMappings (SubstitutionArgumentMappings &&other)
+    : mappings (std::move (other.mappings)), locus (other.locus),
+      param_subst_cb (std::move (other.param_subst_cb)),
+      trait_item_flag (other.trait_item_flag)
+  {}
+
+  SubstitutionArgumentMappings &
+  operator= (SubstitutionArgumentMappings &&other)
+  {
+    mappings = std::move (other.mappings);
+    locus = other.locus;
+    param_subst_cb = std::move (other.param_subst_cb);
+    trait_item_flag = other.trait_item_flag;
+
+    return *this;
+  }
+
   static SubstitutionArgumentMappings error ()
   {
     return SubstitutionArgumentMappings ({}, Location (), nullptr, false);
@@ -784,7 +826,8 @@ class SubstitutionRef
 public:
   SubstitutionRef (std::vector<SubstitutionParamMapping> substitutions,
 		   SubstitutionArgumentMappings arguments)
-    : substitutions (substitutions), used_arguments (arguments)
+    : substitutions (std::move (substitutions)),
+      used_arguments (std::move (arguments))
   {}
 
   bool has_substitutions () const { return substitutions.size () > 0; }
@@ -816,6 +859,7 @@ public:
   std::vector<SubstitutionParamMapping> clone_substs () const
   {
     std::vector<SubstitutionParamMapping> clone;
+    clone.reserve (substitutions.size ());
 
     for (auto &sub : substitutions)
       clone.push_back (sub.clone ());
@@ -1077,10 +1121,10 @@ public:
 	      VariantType type, HIR::Expr *discriminant,
 	      std::vector<StructFieldType *> fields)
     : id (id), identifier (identifier), ident (ident), type (type),
-      discriminant (discriminant), fields (fields)
+      discriminant (discriminant), fields (std::move (fields))
   {
     rust_assert (
-      (type == VariantType::NUM && fields.empty ())
+      (type == VariantType::NUM && this->fields.empty ())
       || (type == VariantType::TUPLE || type == VariantType::STRUCT));
   }
 
@@ -1251,10 +1295,15 @@ public:
   // Representation options, specified via attributes e.g. #[repr(packed)]
   struct ReprOptions
   {
-    // bool is_c;
     // bool is_transparent;
     //...
 
+    // #[repr(C)]: the fields keep their declaration order
+    bool is_c = false;
+
+    // #[repr(simd)]: the fields are the lanes of a vector register
+    bool is_simd = false;
+
     // For align and pack: 0 = unspecified. Nonzero = byte alignment.
     // It is an error for both to be nonzero, this should be caught when
     // parsing the #[repr] attribute.
@@ -1270,7 +1319,8 @@ public:
 	   std::set<HirId> refs = std::set<HirId> ())
     : BaseType (ref, ref, TypeKind::ADT, ident, refs),
       SubstitutionRef (std::move (subst_refs), std::move (generic_arguments)),
-      identifier (identifier), variants (variants), adt_kind (adt_kind)
+      identifier (identifier), variants (std::move (variants)),
+      adt_kind (adt_kind)
   {}
 
   ADTType (HirId ref, HirId ty_ref, std::string identifier, RustIdent ident,
@@ -1281,7 +1331,8 @@ public:
 	   std::set<HirId> refs = std::set<HirId> ())
     : BaseType (ref, ty_ref, TypeKind::ADT, ident, refs),
       SubstitutionRef (std::move (subst_refs), std::move (generic_arguments)),
-      identifier (identifier), variants (variants), adt_kind (adt_kind)
+      identifier (identifier), variants (std::move (variants)),
+      adt_kind (adt_kind)
   {}
 
   ADTType (HirId ref, HirId ty_ref, std::string identifier, RustIdent ident,
@@ -1292,7 +1343,8 @@ public:
 	   std::set<HirId> refs = std::set<HirId> ())
     : BaseType (ref, ty_ref, TypeKind::ADT, ident, refs),
       SubstitutionRef (std::move (subst_refs), std::move (generic_arguments)),
-      identifier (identifier), variants (variants), adt_kind (adt_kind),
+      identifier (identifier), variants (std::move (variants)),
+      adt_kind (adt_kind),
       repr (repr)
   {}
 
@@ -1444,7 +1496,8 @@ public:
     : BaseType (ref, ty_ref, TypeKind::FNDEF, ident, refs),
       SubstitutionRef (std::move (subst_refs),
 		       SubstitutionArgumentMappings::error ()),
-      params (params), type (type), flags (flags), identifier (identifier),
+      params (std::move (params)), type (type), flags (flags),
+      identifier (identifier),
       id (id), abi (abi)
   {
     LocalDefId local_def_id = id.localDefId;
@@ -1554,23 +1607,26 @@ class FnPtr : public BaseType
 {
 public:
   FnPtr (HirId ref, Location locus, std::vector<TyVar> params,
-	 TyVar result_type, std::set<HirId> refs = std::set<HirId> ())
+	 TyVar result_type, ABI abi, std::set<HirId> refs = std::set<HirId> ())
     : BaseType (ref, ref, TypeKind::FNPTR,
 		{Resolver::CanonicalPath::create_empty (), locus}, refs),
-      params (std::move (params)), result_type (result_type)
+      params (std::move (params)), result_type (result_type), abi (abi)
   {}
 
   FnPtr (HirId ref, HirId ty_ref, Location locus, std::vector<TyVar> params,
-	 TyVar result_type, std::set<HirId> refs = std::set<HirId> ())
+	 TyVar result_type, ABI abi, std::set<HirId> refs = std::set<HirId> ())
     : BaseType (ref, ty_ref, TypeKind::FNPTR,
 		{Resolver::CanonicalPath::create_empty (), locus}, refs),
-      params (params), result_type (result_type)
+      params (std::move (params)), result_type (result_type), abi (abi)
   {}
 
   std::string get_name () const override final { return as_string (); }
 
   BaseType *get_return_type () const { return result_type.get_tyty (); }
 
+  // the ABI of the functions it points to, from its extern qualifier
+  ABI get_abi () const { return abi; }
+
   size_t num_params () const { return params.size (); }
 
   BaseType *param_at (size_t idx) const { return params.at (idx).get_tyty (); }
@@ -1613,6 +1669,7 @@ public:
 private:
   std::vector<TyVar> params;
   TyVar result_type;
+  ABI abi;
 };
 
 class ClosureType : public BaseType, public SubstitutionRef
@@ -25,6 +25,10 @@ get_abi_from_string (const std::string &abi)
     return Rust::ABI::RUST;
   else if (abi.compare ("rust-intrinsic") == 0)
     return Rust::ABI::INTRINSIC;
+  // the simd_* intrinsics are declared in their own extern block but are
+  // compiled like any other intrinsic
+  else if (abi.compare ("platform-intrinsic") == 0)
+    return Rust::ABI::INTRINSIC;
   else if (abi.compare ("C") == 0)
     return Rust::ABI::C;
   else if (abi.compare ("cdecl") == 0)
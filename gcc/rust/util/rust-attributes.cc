@@ -27,23 +27,34 @@ namespace Analysis {
 
 // https://doc.rust-lang.org/stable/nightly-rustc/src/rustc_feature/builtin_attrs.rs.html#248
 static const BuiltinAttrDefinition __definitions[]
-  = {{"inline", CODE_GENERATION},
-     {"cold", CODE_GENERATION},
-     {"cfg", EXPANSION},
-     {"cfg_attr", EXPANSION},
-     {"deprecated", STATIC_ANALYSIS},
-     {"allow", STATIC_ANALYSIS},
-     {"doc", HIR_LOWERING},
-     {"must_use", STATIC_ANALYSIS},
-     {"lang", HIR_LOWERING},
-     {"link_section", CODE_GENERATION},
-     {"no_mangle", CODE_GENERATION},
-     {"repr", CODE_GENERATION},
-     {"path", EXPANSION},
-     {"macro_use", NAME_RESOLUTION},
+  = {{"inline", CODE_GENERATION, BuiltinAttrKind::INLINE},
+     {"cold", CODE_GENERATION, BuiltinAttrKind::COLD},
+     {"cfg", EXPANSION, BuiltinAttrKind::CFG},
+     {"cfg_attr", EXPANSION, BuiltinAttrKind::CFG_ATTR},
+     {"derive", EXPANSION, BuiltinAttrKind::DERIVE},
+     {"deprecated", STATIC_ANALYSIS, BuiltinAttrKind::DEPRECATED},
+     {"allow", STATIC_ANALYSIS, BuiltinAttrKind::ALLOW},
+     {"doc", HIR_LOWERING, BuiltinAttrKind::DOC},
+     {"must_use", STATIC_ANALYSIS, BuiltinAttrKind::MUST_USE},
+     {"lang", HIR_LOWERING, BuiltinAttrKind::LANG},
+     {"link_section", CODE_GENERATION, BuiltinAttrKind::LINK_SECTION},
+     {"link_name", CODE_GENERATION, BuiltinAttrKind::LINK_NAME},
+     {"no_mangle", CODE_GENERATION, BuiltinAttrKind::NO_MANGLE},
+     {"thread_local", CODE_GENERATION, BuiltinAttrKind::THREAD_LOCAL},
+     {"target_feature", CODE_GENERATION, BuiltinAttrKind::TARGET_FEATURE},
+     {"target_clones", CODE_GENERATION, BuiltinAttrKind::TARGET_CLONES},
+     {"repr", CODE_GENERATION, BuiltinAttrKind::REPR},
+     {"path", EXPANSION, BuiltinAttrKind::PATH},
+     {"macro_use", NAME_RESOLUTION, BuiltinAttrKind::MACRO_USE},
      // From now on, these are reserved by the compiler and gated through
      // #![feature(rustc_attrs)]
-     {"rustc_inherit_overflow_checks", CODE_GENERATION}};
+     {"rustc_inherit_overflow_checks", CODE_GENERATION,
+      BuiltinAttrKind::RUSTC_INHERIT_OVERFLOW_CHECKS},
+     {"rustc_allocator", CODE_GENERATION, BuiltinAttrKind::RUSTC_ALLOCATOR},
+     {"rustc_allocator_zeroed", CODE_GENERATION,
+      BuiltinAttrKind::RUSTC_ALLOCATOR_ZEROED},
+     {"rustc_reallocator", CODE_GENERATION,
+      BuiltinAttrKind::RUSTC_REALLOCATOR}};
 
 BuiltinAttributeMappings *
 BuiltinAttributeMappings::get ()
@@ -65,12 +76,19 @@ BuiltinAttributeMappings::lookup_builtin (const std::string &attr_name) const
   return it->second;
 }
 
+const BuiltinAttrDefinition &
+BuiltinAttributeMappings::lookup_builtin (BuiltinAttrKind kind) const
+{
+  return __definitions[static_cast<size_t> (kind)];
+}
+
 BuiltinAttributeMappings::BuiltinAttributeMappings ()
 {
   size_t ndefinitions = sizeof (__definitions) / sizeof (BuiltinAttrDefinition);
   for (size_t i = 0; i < ndefinitions; i++)
     {
       const BuiltinAttrDefinition &def = __definitions[i];
+      rust_assert (static_cast<size_t> (def.kind) == i);
       mappings.insert ({def.name, def});
     }
 }
@@ -103,6 +121,43 @@ is_builtin (const AST::Attribute &attribute, BuiltinAttrDefinition &builtin)
   return !builtin.is_error ();
 }
 
+BuiltinAttrSet::BuiltinAttrSet (const AST::AttrVec &attrs) : flags (0)
+{
+  static_assert (sizeof (__definitions) / sizeof (BuiltinAttrDefinition)
+		   <= sizeof (flags) * CHAR_BIT,
+		 "every builtin attribute needs a bit of the set");
+
+  auto builtins = BuiltinAttributeMappings::get ();
+  for (size_t i = 0; i < attrs.size (); i++)
+    {
+      // same as is_builtin, without copying the definition
+      auto &segments = attrs[i].get_path ().get_segments ();
+      if (segments.size () != 1)
+	continue;
+
+      const BuiltinAttrDefinition &builtin
+	= builtins->lookup_builtin (segments.at (0).get_segment_name ());
+      if (builtin.is_error ())
+	continue;
+
+      flags |= bit (builtin.kind);
+      entries.push_back ({builtin.kind, i});
+    }
+}
+
+const AST::Attribute *
+BuiltinAttrSet::get (const AST::AttrVec &attrs, BuiltinAttrKind kind) const
+{
+  if (!has (kind))
+    return nullptr;
+
+  for (const auto &entry : entries)
+    if (entry.first == kind)
+      return &attrs.at (entry.second);
+
+  gcc_unreachable ();
+}
+
 /**
  * Check that the string given to #[doc(alias = ...)] or #[doc(alias(...))] is
  * valid.
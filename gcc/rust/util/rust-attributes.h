@@ -19,6 +19,7 @@
 #include "rust-ast.h"
 #include "rust-system.h"
 #include "rust-ast-visitor.h"
+#include "rust-builtin-attributes.h"
 
 namespace Rust {
 namespace Analysis {
@@ -39,10 +40,11 @@ struct BuiltinAttrDefinition
 {
   std::string name;
   CompilerPass handler;
+  BuiltinAttrKind kind;
 
   static BuiltinAttrDefinition get_error ()
   {
-    return BuiltinAttrDefinition{"", UNKNOWN};
+    return BuiltinAttrDefinition{"", UNKNOWN, BuiltinAttrKind ()};
   }
 
   static BuiltinAttrDefinition &error_node ()
@@ -62,6 +64,8 @@ public:
   const BuiltinAttrDefinition &
   lookup_builtin (const std::string &attr_name) const;
 
+  const BuiltinAttrDefinition &lookup_builtin (BuiltinAttrKind kind) const;
+
 private:
   BuiltinAttributeMappings ();
 
@@ -0,0 +1,210 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-bench.h"
+#include "rust-lex.h"
+#include "rust-parse.h"
+#include "rust-ast-resolve.h"
+#include "rust-ast-lower.h"
+#include "rust-hir-type-check.h"
+#include "rust-hir-map.h"
+
+#include "diagnostic.h"
+#include "options.h"
+#include "selftest.h"
+
+#if CHECKING_P
+
+namespace selftest {
+
+/* One unit of the canned crate. Every '@' is replaced by the number of the
+ * copy, so that the copies don't clash in the resolver. The input sticks to
+ * what works without libcore: no macros, no lang item traits. */
+static const char *bench_unit = R"(
+struct Point@ {
+    x: i32,
+    y: i32,
+}
+
+impl Point@ {
+    fn new(x: i32, y: i32) -> Point@ {
+        Point@ { x: x, y: y }
+    }
+
+    fn dot(&self, other: &Point@) -> i32 {
+        self.x * other.x + self.y * other.y
+    }
+}
+
+enum Shape@ {
+    Circle(i32),
+    Rect { w: i32, h: i32 },
+    Empty,
+}
+
+fn area@(s: Shape@) -> i32 {
+    match s {
+        Shape@::Circle(r) => 3 * r * r,
+        Shape@::Rect { w, h } => w * h,
+        Shape@::Empty => 0,
+    }
+}
+
+fn pick@<T>(a: T, b: T, first: bool) -> T {
+    if first {
+        a
+    } else {
+        b
+    }
+}
+
+fn sum@(n: i32) -> i32 {
+    let mut i = 0;
+    let mut total = 0;
+    while i < n {
+        total = total + pick@(i, n - i, i < n / 2);
+        i = i + 1;
+    }
+    let p = Point@::new(total, n);
+    p.dot(&p) + area@(Shape@::Rect { w: n, h: 2 })
+}
+)";
+
+// Number of copies of the unit in the canned crate
+static const int bench_units = 32;
+
+static std::string
+bench_source ()
+{
+  std::string source;
+  for (int i = 0; i < bench_units; i++)
+    {
+      std::string suffix = std::to_string (i);
+      for (const char *c = bench_unit; *c != '\0'; c++)
+	if (*c == '@')
+	  source += suffix;
+	else
+	  source += *c;
+    }
+
+  return source;
+}
+
+static void
+bench_report (const char *phase, long usecs, int iterations)
+{
+  fprintf (stderr, "rust bench: %-12s %10ld us total, %10.1f us/iteration\n",
+	   phase, usecs, (double) usecs / iterations);
+}
+
+static std::unique_ptr<Rust::AST::Crate>
+bench_parse (const std::string &source)
+{
+  Rust::Lexer lex (source);
+  Rust::Parser<Rust::Lexer> parser (lex);
+  std::unique_ptr<Rust::AST::Crate> crate = parser.parse_crate ();
+  ASSERT_TRUE (parser.get_errors ().empty ());
+
+  return crate;
+}
+
+static void
+bench_lexer (const std::string &source, int iterations)
+{
+  long start = get_run_time ();
+  for (int i = 0; i < iterations; i++)
+    {
+      Rust::Lexer lex (source);
+      while (lex.peek_token ()->get_id () != Rust::END_OF_FILE)
+	lex.skip_token ();
+    }
+  bench_report ("lexer", get_run_time () - start, iterations);
+}
+
+static void
+bench_parser (const std::string &source, int iterations)
+{
+  long start = get_run_time ();
+  for (int i = 0; i < iterations; i++)
+    bench_parse (source);
+  bench_report ("parser", get_run_time () - start, iterations);
+}
+
+/* Name resolution and type checking need a crate of their own at every
+ * iteration: each copy of the canned crate is registered as a new crate in
+ * the mappings, which are restored to the crate being compiled afterwards. */
+static void
+bench_analysis (const std::string &source, int iterations)
+{
+  auto mappings = Rust::Analysis::Mappings::get ();
+  CrateNum saved_crate = mappings->get_current_crate ();
+
+  long resolve_time = 0;
+  long lower_time = 0;
+  long typecheck_time = 0;
+  for (int i = 0; i < iterations; i++)
+    {
+      std::string crate_name = "bench_" + std::to_string (i);
+      CrateNum crate_num = mappings->get_next_crate_num (crate_name);
+      mappings->set_current_crate (crate_num);
+
+      Rust::AST::Crate &crate
+	= mappings->insert_ast_crate (bench_parse (source), crate_num);
+
+      long start = get_run_time ();
+      Rust::Resolver::NameResolution::Resolve (crate);
+      resolve_time += get_run_time () - start;
+
+      start = get_run_time ();
+      std::unique_ptr<Rust::HIR::Crate> lowered
+	= Rust::HIR::ASTLowering::Resolve (crate);
+      lower_time += get_run_time () - start;
+
+      Rust::HIR::Crate &hir = mappings->insert_hir_crate (std::move (lowered));
+
+      start = get_run_time ();
+      Rust::Resolver::TypeResolution::Resolve (hir);
+      typecheck_time += get_run_time () - start;
+    }
+  mappings->set_current_crate (saved_crate);
+
+  ASSERT_FALSE (seen_error ());
+  bench_report ("resolution", resolve_time, iterations);
+  bench_report ("lowering", lower_time, iterations);
+  bench_report ("typecheck", typecheck_time, iterations);
+}
+
+void
+rust_bench_test (void)
+{
+  int iterations = flag_rust_selftest_bench;
+  if (iterations == 0)
+    return;
+
+  std::string source = bench_source ();
+  fprintf (stderr, "rust bench: %d iterations over %lu bytes of input\n",
+	   iterations, (unsigned long) source.size ());
+
+  bench_lexer (source, iterations);
+  bench_parser (source, iterations);
+  bench_analysis (source, iterations);
+}
+
+} // namespace selftest
+
+#endif // CHECKING_P
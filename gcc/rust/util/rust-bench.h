@@ -0,0 +1,33 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_BENCH_H
+#define RUST_BENCH_H
+
+#include "rust-system.h"
+
+#if CHECKING_P
+namespace selftest {
+/* Time the front-end passes over a canned crate, repeated as many times as
+ * -frust-selftest-bench asks for. Does nothing without the option. */
+extern void
+rust_bench_test (void);
+} // namespace selftest
+#endif // CHECKING_P
+
+#endif // RUST_BENCH_H
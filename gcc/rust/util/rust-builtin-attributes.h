@@ -0,0 +1,98 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_BUILTIN_ATTRIBUTES_H
+#define RUST_BUILTIN_ATTRIBUTES_H
+
+#include "rust-system.h"
+
+namespace Rust {
+namespace AST {
+struct Attribute;
+}
+
+namespace Analysis {
+
+// The builtin attributes, in the order of the definitions table of
+// rust-attributes.cc
+enum class BuiltinAttrKind : uint8_t
+{
+  INLINE,
+  COLD,
+  CFG,
+  CFG_ATTR,
+  DERIVE,
+  DEPRECATED,
+  ALLOW,
+  DOC,
+  MUST_USE,
+  LANG,
+  LINK_SECTION,
+  LINK_NAME,
+  NO_MANGLE,
+  THREAD_LOCAL,
+  TARGET_FEATURE,
+  TARGET_CLONES,
+  REPR,
+  PATH,
+  MACRO_USE,
+  RUSTC_INHERIT_OVERFLOW_CHECKS,
+  RUSTC_ALLOCATOR,
+  RUSTC_ALLOCATOR_ZEROED,
+  RUSTC_REALLOCATOR,
+};
+
+/* The builtin attributes of an item, resolved from their paths once when the
+ * item is lowered to HIR. Later passes test the set instead of comparing
+ * attribute names, and reach an attribute's input through its index among the
+ * item's outer attributes. */
+class BuiltinAttrSet
+{
+public:
+  // a builtin attribute and its index among the item's outer attributes
+  using Entry = std::pair<BuiltinAttrKind, size_t>;
+
+  BuiltinAttrSet () : flags (0) {}
+
+  // Resolve ATTRS, with a single lookup for each of them
+  explicit BuiltinAttrSet (const std::vector<AST::Attribute> &attrs);
+
+  bool has (BuiltinAttrKind kind) const { return (flags & bit (kind)) != 0; }
+
+  /* The first KIND attribute of ATTRS, the attributes the set was resolved
+   * from, or nullptr. */
+  const AST::Attribute *get (const std::vector<AST::Attribute> &attrs,
+			     BuiltinAttrKind kind) const;
+
+  // Every builtin attribute, in the order they were written in
+  const std::vector<Entry> &get_entries () const { return entries; }
+
+private:
+  static uint32_t bit (BuiltinAttrKind kind)
+  {
+    return 1u << static_cast<unsigned> (kind);
+  }
+
+  uint32_t flags;
+  std::vector<Entry> entries;
+};
+
+} // namespace Analysis
+} // namespace Rust
+
+#endif // RUST_BUILTIN_ATTRIBUTES_H
@@ -0,0 +1,180 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-canonical-path.h"
+
+namespace Rust {
+namespace Resolver {
+
+namespace {
+
+struct CanonicalPathNodeKey
+{
+  const CanonicalPathNode *parent;
+  NodeId id;
+  std::string seg;
+
+  bool operator== (const CanonicalPathNodeKey &other) const
+  {
+    return parent == other.parent && id == other.id && seg == other.seg;
+  }
+};
+
+struct CanonicalPathNodeKeyHash
+{
+  size_t operator() (const CanonicalPathNodeKey &key) const
+  {
+    size_t h = std::hash<const CanonicalPathNode *> () (key.parent);
+    h = h * 31 + std::hash<NodeId> () (key.id);
+    h = h * 31 + std::hash<std::string> () (key.seg);
+    return h;
+  }
+};
+
+} // namespace
+
+// both tables live for the whole compilation; the elements of an
+// unordered_map are never moved so pointers into them stay valid
+static std::unordered_map<CanonicalPathNodeKey,
+			  std::unique_ptr<CanonicalPathNode>,
+			  CanonicalPathNodeKeyHash> &
+get_node_table ()
+{
+  static std::unordered_map<CanonicalPathNodeKey,
+			    std::unique_ptr<CanonicalPathNode>,
+			    CanonicalPathNodeKeyHash>
+    table;
+  return table;
+}
+
+// maps each joined path string to its id, id zero is the empty path
+static std::unordered_map<std::string, size_t> &
+get_path_table ()
+{
+  static std::unordered_map<std::string, size_t> table;
+  return table;
+}
+
+const CanonicalPathNode *
+CanonicalPath::intern_seg (const CanonicalPathNode *parent, NodeId id,
+			   const std::string &seg)
+{
+  auto &nodes = get_node_table ();
+  CanonicalPathNodeKey key{parent, id, seg};
+  auto it = nodes.find (key);
+  if (it != nodes.end ())
+    return it->second.get ();
+
+  auto &paths = get_path_table ();
+  std::string joined = parent == nullptr ? seg : *parent->path + "::" + seg;
+  auto path = paths.insert ({std::move (joined), paths.size () + 1}).first;
+
+  CanonicalPathNode *node
+    = new CanonicalPathNode (parent, id, seg, &path->first, path->second);
+  nodes.emplace (std::move (key), std::unique_ptr<CanonicalPathNode> (node));
+  return node;
+}
+
+const std::string &
+CanonicalPath::get () const
+{
+  static const std::string empty;
+  return is_empty () ? empty : *node->path;
+}
+
+size_t
+CanonicalPath::get_path_id () const
+{
+  return is_empty () ? 0 : node->path_id;
+}
+
+size_t
+CanonicalPath::size () const
+{
+  return is_empty () ? 0 : node->depth;
+}
+
+NodeId
+CanonicalPath::get_node_id () const
+{
+  rust_assert (!is_empty ());
+  return node->seg.first;
+}
+
+const std::pair<NodeId, std::string> &
+CanonicalPath::get_seg_at (size_t index) const
+{
+  rust_assert (index < size ());
+  const CanonicalPathNode *n = node;
+  for (size_t i = index + 1; i < size (); i++)
+    n = n->parent;
+  return n->seg;
+}
+
+CanonicalPath
+CanonicalPath::append (const CanonicalPath &other) const
+{
+  rust_assert (!other.is_empty ());
+  if (is_empty ())
+    return CanonicalPath (other.node, crate_num);
+
+  // other is nearly always a single segment
+  std::vector<const CanonicalPathNode *> segs;
+  for (const CanonicalPathNode *n = other.node; n != nullptr; n = n->parent)
+    segs.push_back (n);
+
+  const CanonicalPathNode *result = node;
+  for (auto it = segs.rbegin (); it != segs.rend (); it++)
+    result = intern_seg (result, (*it)->seg.first, (*it)->seg.second);
+
+  return CanonicalPath (result, crate_num);
+}
+
+void
+CanonicalPath::iterate (std::function<bool (const CanonicalPath &)> cb) const
+{
+  std::vector<const CanonicalPathNode *> prefixes;
+  for (const CanonicalPathNode *n = node; n != nullptr; n = n->parent)
+    prefixes.push_back (n);
+
+  for (auto it = prefixes.rbegin (); it != prefixes.rend (); it++)
+    {
+      if (!cb (CanonicalPath (*it, crate_num)))
+	return;
+    }
+}
+
+void
+CanonicalPath::iterate_segs (
+  std::function<bool (const CanonicalPath &)> cb) const
+{
+  std::vector<const CanonicalPathNode *> prefixes;
+  for (const CanonicalPathNode *n = node; n != nullptr; n = n->parent)
+    prefixes.push_back (n);
+
+  for (auto it = prefixes.rbegin (); it != prefixes.rend (); it++)
+    {
+      const CanonicalPathNode *seg
+	= intern_seg (nullptr, (*it)->seg.first, (*it)->seg.second);
+      if (!cb (CanonicalPath (seg, crate_num)))
+	return;
+    }
+}
+
+} // namespace Resolver
+} // namespace Rust
@@ -43,22 +43,26 @@ namespace Resolver {
 // impl Trait for Struct {
 //    fn f(&self) {} // <::a::Struct as ::a::Trait>::f
 // }
+class CanonicalPathNode;
+
 class CanonicalPath
 {
 public:
-  CanonicalPath (const CanonicalPath &other) : segs (other.segs) {}
+  CanonicalPath (const CanonicalPath &other)
+    : node (other.node), crate_num (other.crate_num)
+  {}
 
   CanonicalPath &operator= (const CanonicalPath &other)
   {
-    segs = other.segs;
+    node = other.node;
+    crate_num = other.crate_num;
     return *this;
   }
 
   static CanonicalPath new_seg (NodeId id, const std::string &path)
   {
     rust_assert (!path.empty ());
-    return CanonicalPath ({std::pair<NodeId, std::string> (id, path)},
-			  UNKNOWN_CREATENUM);
+    return CanonicalPath (intern_seg (nullptr, id, path), UNKNOWN_CREATENUM);
   }
 
   static CanonicalPath
@@ -69,17 +73,7 @@ public:
 					 + trait_seg.get () + ">");
   }
 
-  std::string get () const
-  {
-    std::string buf;
-    for (size_t i = 0; i < segs.size (); i++)
-      {
-	bool have_more = (i + 1) < segs.size ();
-	const std::string &seg = segs.at (i).second;
-	buf += seg + (have_more ? "::" : "");
-      }
-    return buf;
-  }
+  const std::string &get () const;
 
   static CanonicalPath get_big_self (NodeId id)
   {
@@ -88,23 +82,12 @@ public:
 
   static CanonicalPath create_empty ()
   {
-    return CanonicalPath ({}, UNKNOWN_CREATENUM);
+    return CanonicalPath (nullptr, UNKNOWN_CREATENUM);
   }
 
-  bool is_empty () const { return segs.size () == 0; }
+  bool is_empty () const { return node == nullptr; }
 
-  CanonicalPath append (const CanonicalPath &other) const
-  {
-    rust_assert (!other.is_empty ());
-    if (is_empty ())
-      return CanonicalPath (other.segs, crate_num);
-
-    std::vector<std::pair<NodeId, std::string>> copy (segs);
-    for (auto &s : other.segs)
-      copy.push_back (s);
-
-    return CanonicalPath (copy, crate_num);
-  }
+  CanonicalPath append (const CanonicalPath &other) const;
 
   // if we have the path A::B::C this will give a callback for each segment
   // including the prefix, example:
@@ -116,16 +99,7 @@ public:
   //   A
   //   A::B
   //   A::B::C
-  void iterate (std::function<bool (const CanonicalPath &)> cb) const
-  {
-    std::vector<std::pair<NodeId, std::string>> buf;
-    for (auto &seg : segs)
-      {
-	buf.push_back (seg);
-	if (!cb (CanonicalPath (buf, crate_num)))
-	  return;
-      }
-  }
+  void iterate (std::function<bool (const CanonicalPath &)> cb) const;
 
   // if we have the path A::B::C this will give a callback for each segment
   // example:
@@ -137,34 +111,19 @@ public:
   //   A
   //      B
   //         C
-  void iterate_segs (std::function<bool (const CanonicalPath &)> cb) const
-  {
-    for (auto &seg : segs)
-      {
-	std::vector<std::pair<NodeId, std::string>> buf;
-	buf.push_back ({seg.first, seg.second});
-	if (!cb (CanonicalPath (buf, crate_num)))
-	  return;
-      }
-  }
+  void iterate_segs (std::function<bool (const CanonicalPath &)> cb) const;
 
-  size_t size () const { return segs.size (); }
+  size_t size () const;
 
-  NodeId get_node_id () const
-  {
-    rust_assert (!segs.empty ());
-    return segs.back ().first;
-  }
+  NodeId get_node_id () const;
 
-  const std::pair<NodeId, std::string> &get_seg_at (size_t index) const
-  {
-    rust_assert (index < size ());
-    return segs.at (index);
-  }
+  const std::pair<NodeId, std::string> &get_seg_at (size_t index) const;
 
+  // paths are compared by their string form with the node ids ignored; the
+  // joined strings are interned so this is a single integer comparison
   bool is_equal (const CanonicalPath &b) const
   {
-    return get ().compare (b.get ()) == 0;
+    return get_path_id () == b.get_path_id ();
   }
 
   void set_crate_num (CrateNum n) { crate_num = n; }
@@ -177,19 +136,66 @@ public:
 
   bool operator== (const CanonicalPath &b) const { return is_equal (b); }
 
-  bool operator< (const CanonicalPath &b) const { return get () < b.get (); }
+  bool operator!= (const CanonicalPath &b) const { return !is_equal (b); }
+
+  // orders paths by when their string form was first created, which is
+  // deterministic for a given input but not lexicographic
+  bool operator< (const CanonicalPath &b) const
+  {
+    return get_path_id () < b.get_path_id ();
+  }
+
+  size_t hash () const { return get_path_id (); }
 
 private:
-  explicit CanonicalPath (std::vector<std::pair<NodeId, std::string>> path,
-			  CrateNum crate_num)
-    : segs (path), crate_num (crate_num)
+  explicit CanonicalPath (const CanonicalPathNode *node, CrateNum crate_num)
+    : node (node), crate_num (crate_num)
   {}
 
-  std::vector<std::pair<NodeId, std::string>> segs;
+  static const CanonicalPathNode *intern_seg (const CanonicalPathNode *parent,
+					      NodeId id,
+					      const std::string &seg);
+
+  size_t get_path_id () const;
+
+  const CanonicalPathNode *node;
   CrateNum crate_num;
 };
 
+// Canonical paths are hash-consed: every distinct (parent, node id, segment)
+// triple is allocated once for the whole compilation and paths only point to
+// the last segment. This makes copying and appending a segment cheap, and the
+// joined string and its id are computed once when the node is created.
+class CanonicalPathNode
+{
+public:
+  CanonicalPathNode (const CanonicalPathNode *parent, NodeId id,
+		     const std::string &seg, const std::string *path,
+		     size_t path_id)
+    : parent (parent), seg (id, seg), depth (parent ? parent->depth + 1 : 1),
+      path (path), path_id (path_id)
+  {}
+
+  const CanonicalPathNode *parent;
+  std::pair<NodeId, std::string> seg;
+  size_t depth;
+
+  // the interned joined string for this path along with a unique id for it
+  const std::string *path;
+  size_t path_id;
+};
+
 } // namespace Resolver
 } // namespace Rust
 
+namespace std {
+template <> struct hash<Rust::Resolver::CanonicalPath>
+{
+  size_t operator() (const Rust::Resolver::CanonicalPath &path) const noexcept
+  {
+    return path.hash ();
+  }
+};
+} // namespace std
+
 #endif // RUST_CANONICAL_PATH
@@ -0,0 +1,158 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_DENSE_ID_MAP_H
+#define RUST_DENSE_ID_MAP_H
+
+#include "rust-system.h"
+
+namespace Rust {
+
+/**
+ * Map keyed by ids which are handed out by a counter such as NodeId and HirId.
+ * Since the ids of a crate are allocated one after the other, the values are
+ * kept in a vector indexed by their offset from the smallest id inserted so
+ * far. Lookups are then a simple index instead of a tree walk and inserting
+ * does not need a node allocation.
+ */
+template <typename T> class DenseIdMap
+{
+public:
+  DenseIdMap () : base (0), count (0) {}
+
+  /**
+   * Insert or replace the value for the id
+   */
+  void insert (uint32_t id, T value)
+  {
+    if (values.empty ())
+      base = id;
+    else if (id < base)
+      {
+	size_t shift = base - id;
+	values.insert (values.begin (), shift, T ());
+	present.insert (present.begin (), shift, false);
+	base = id;
+      }
+
+    size_t index = id - base;
+    if (index >= values.size ())
+      {
+	values.resize (index + 1);
+	present.resize (index + 1, false);
+      }
+
+    values[index] = std::move (value);
+    if (!present[index])
+      {
+	present[index] = true;
+	count++;
+      }
+  }
+
+  /**
+   * Lookup the value for the id, returns nullptr when there is none
+   */
+  T *lookup (uint32_t id)
+  {
+    if (!contains (id))
+      return nullptr;
+
+    return &values[id - base];
+  }
+
+  const T *lookup (uint32_t id) const
+  {
+    if (!contains (id))
+      return nullptr;
+
+    return &values[id - base];
+  }
+
+  bool contains (uint32_t id) const
+  {
+    if (id < base)
+      return false;
+
+    size_t index = id - base;
+    return index < present.size () && present[index];
+  }
+
+  size_t size () const { return count; }
+
+private:
+  uint32_t base;
+  size_t count;
+  std::vector<T> values;
+  std::vector<bool> present;
+};
+
+/**
+ * Set of ids laid out the same way as DenseIdMap, one bit per id between the
+ * smallest and the largest id inserted so far.
+ */
+class DenseIdSet
+{
+public:
+  DenseIdSet () : base (0), count (0) {}
+
+  /**
+   * Insert the id, returns false when it was already present
+   */
+  bool insert (uint32_t id)
+  {
+    if (bits.empty ())
+      base = id;
+    else if (id < base)
+      {
+	bits.insert (bits.begin (), base - id, false);
+	base = id;
+      }
+
+    size_t index = id - base;
+    if (index >= bits.size ())
+      bits.resize (index + 1, false);
+
+    if (bits[index])
+      return false;
+
+    bits[index] = true;
+    count++;
+    return true;
+  }
+
+  bool contains (uint32_t id) const
+  {
+    if (id < base)
+      return false;
+
+    size_t index = id - base;
+    return index < bits.size () && bits[index];
+  }
+
+  size_t size () const { return count; }
+
+private:
+  uint32_t base;
+  size_t count;
+  std::vector<bool> bits;
+};
+
+} // namespace Rust
+
+#endif // RUST_DENSE_ID_MAP_H
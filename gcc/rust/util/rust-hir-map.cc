@@ -36,7 +36,7 @@ NodeMapping::get_error ()
 CrateNum
 NodeMapping::get_crate_num () const
 {
-  return crateNum;
+  return defIndex >> (32 - kCrateNumBits);
 }
 
 NodeId
@@ -54,7 +54,7 @@ NodeMapping::get_hirid () const
 LocalDefId
 NodeMapping::get_local_defid () const
 {
-  return localDefId;
+  return defIndex & kMaxLocalDefId;
 }
 
 DefId
@@ -95,7 +95,8 @@ static const HirId kDefaultCrateNumBegin = 0;
 
 Mappings::Mappings ()
   : crateNumItr (kDefaultCrateNumBegin), currentCrateNum (UNKNOWN_CREATENUM),
-    hirIdIter (kDefaultHirIdBegin), nodeIdIter (kDefaultNodeIdBegin)
+    hirIdIter (kDefaultHirIdBegin), nodeIdIter (kDefaultNodeIdBegin),
+    module_tree_times_valid (false)
 {}
 
 Mappings::~Mappings () {}
@@ -103,11 +104,7 @@ Mappings::~Mappings () {}
 Mappings *
 Mappings::get ()
 {
-  static std::unique_ptr<Mappings> instance;
-  if (!instance)
-    instance = std::unique_ptr<Mappings> (new Mappings ());
-
-  return instance.get ();
+  return &CompilationContext::current ().get_mappings ();
 }
 
 CrateNum
@@ -115,6 +112,10 @@ Mappings::get_next_crate_num (const std::string &name)
 {
   auto id = crateNumItr;
   crateNumItr++;
+  // the crate number shares its word in NodeMapping with the local def id
+  if (id > NodeMapping::kMaxCrateNum)
+    rust_fatal_error (Location (), "more than %u crates loaded",
+		      NodeMapping::kMaxCrateNum);
   set_crate_name (id, name);
   return id;
 }
@@ -172,29 +173,39 @@ Mappings::lookup_crate_name (const std::string &crate_name,
   return false;
 }
 
-bool
-Mappings::crate_num_to_nodeid (const CrateNum &crate_num, NodeId &node_id) const
+void
+Mappings::insert_shared_instance (const std::string &symbol)
 {
-  auto it = ast_crate_mappings.find (crate_num);
-  if (it == ast_crate_mappings.end ())
-    return false;
+  shared_instances.insert (symbol);
+}
 
-  node_id = it->second->get_node_id ();
-  return true;
+bool
+Mappings::is_shared_instance (const std::string &symbol) const
+{
+  return shared_instances.find (symbol) != shared_instances.end ();
 }
 
 bool
-Mappings::node_is_crate (NodeId node_id) const
+Mappings::crate_num_to_nodeid (const CrateNum &crate_num, NodeId &node_id) const
 {
-  for (const auto &it : ast_crate_mappings)
+  for (const auto &it : crate_node_to_crate_num)
     {
-      NodeId crate_node_id = it.second->get_node_id ();
-      if (crate_node_id == node_id)
-	return true;
+      if (it.second == crate_num)
+	{
+	  node_id = it.first;
+	  return true;
+	}
     }
   return false;
 }
 
+bool
+Mappings::node_is_crate (NodeId node_id) const
+{
+  return crate_node_to_crate_num.find (node_id)
+	 != crate_node_to_crate_num.end ();
+}
+
 NodeId
 Mappings::get_next_node_id ()
 {
@@ -203,37 +214,74 @@ Mappings::get_next_node_id ()
   return it;
 }
 
+size_t
+Mappings::get_num_node_ids () const
+{
+  return nodeIdIter - kDefaultNodeIdBegin;
+}
+
+size_t
+Mappings::get_num_hir_ids () const
+{
+  return hirIdIter - kDefaultHirIdBegin;
+}
+
+size_t
+Mappings::get_num_entries () const
+{
+  return hirItemMappings.size () + hirTypeMappings.size ()
+	 + hirExprMappings.size () + hirStmtMappings.size ()
+	 + hirParamMappings.size () + hirPathSegMappings.size ()
+	 + hirPatternMappings.size () + hirImplItemMappings.size ()
+	 + hirGenericParamMappings.size () + paths.size () + locations.size ()
+	 + inference_locations.size () + nodeIdToHirMappings.size ()
+	 + hirIdToNodeMappings.size () + ast_item_mappings.size ()
+	 + macroMappings.size ();
+}
+
 HirId
 Mappings::get_next_hir_id (CrateNum crateNum)
 {
   auto id = hirIdIter;
   hirIdIter++;
 
-  auto it = hirNodesWithinCrate.find (crateNum);
-  if (it == hirNodesWithinCrate.end ())
-    {
-      hirNodesWithinCrate.insert ({crateNum, {}});
-    }
+  auto &ranges = hirIdRangesWithinCrate[crateNum];
+  if (!ranges.empty () && ranges.back ().second + 1 == id)
+    ranges.back ().second = id;
+  else
+    ranges.push_back ({id, id});
 
-  hirNodesWithinCrate[crateNum].insert (id);
   return id;
 }
 
+bool
+Mappings::is_hirid_within_crate (CrateNum crate, HirId id) const
+{
+  auto it = hirIdRangesWithinCrate.find (crate);
+  if (it == hirIdRangesWithinCrate.end ())
+    return false;
+
+  // find the first run that ends at or after id
+  const auto &ranges = it->second;
+  auto range = std::lower_bound (ranges.begin (), ranges.end (), id,
+				 [] (const std::pair<HirId, HirId> &r,
+				     HirId value) { return r.second < value; });
+  return range != ranges.end () && range->first <= id;
+}
+
 LocalDefId
 Mappings::get_next_localdef_id (CrateNum crateNum)
 {
-  auto it = localIdIter.find (crateNum);
-  if (it == localIdIter.end ())
+  // local def ids start at one in every crate
+  auto it = localIdIter.insert ({crateNum, 1}).first;
+  if (it->second > NodeMapping::kMaxLocalDefId)
     {
-      localIdIter.insert ({crateNum, 1});
+      std::string name;
+      get_crate_name (crateNum, name);
+      rust_fatal_error (Location (), "crate %qs defines more than %u items",
+			name.c_str (), NodeMapping::kMaxLocalDefId);
     }
-
-  it = localIdIter.find (crateNum);
-  rust_assert (it != localIdIter.end ());
-
-  LocalDefId id = it->second;
-  localIdIter[crateNum] = id + 1;
-  return id;
+  return it->second++;
 }
 
 AST::Crate &
@@ -264,6 +312,7 @@ Mappings::insert_ast_crate (std::unique_ptr<AST::Crate> &&crate,
   rust_assert (it == ast_crate_mappings.end ());
 
   // store it
+  crate_node_to_crate_num[crate->get_node_id ()] = crate_num;
   ast_crate_mappings.insert ({crate_num, crate.release ()});
 
   // return the reference to it
@@ -272,6 +321,18 @@ Mappings::insert_ast_crate (std::unique_ptr<AST::Crate> &&crate,
   return *it->second;
 }
 
+void
+Mappings::release_ast_crates ()
+{
+  // the item and macro mappings point into the crates being freed
+  ast_item_mappings.clear ();
+  macroMappings.clear ();
+
+  for (auto &it : ast_crate_mappings)
+    delete it.second;
+  ast_crate_mappings.clear ();
+}
+
 HIR::Crate &
 Mappings::get_hir_crate (CrateNum crateNum)
 {
@@ -337,18 +398,18 @@ Mappings::insert_hir_item (HIR::Item *item)
   auto id = item->get_mappings ().get_hirid ();
   rust_assert (lookup_hir_item (id) == nullptr);
 
-  hirItemMappings[id] = item;
+  hirItemMappings.insert (id, item);
   insert_node_to_hir (item->get_mappings ().get_nodeid (), id);
 }
 
 HIR::Item *
 Mappings::lookup_hir_item (HirId id)
 {
-  auto it = hirItemMappings.find (id);
-  if (it == hirItemMappings.end ())
+  auto lookup = hirItemMappings.lookup (id);
+  if (lookup == nullptr)
     return nullptr;
 
-  return it->second;
+  return *lookup;
 }
 
 void
@@ -413,6 +474,21 @@ Mappings::lookup_hir_extern_item (HirId id, HirId *parent_block)
   return it->second.first;
 }
 
+static const std::string &
+impl_item_name (HIR::ImplItem &item)
+{
+  switch (item.get_impl_item_type ())
+    {
+    case HIR::ImplItem::ImplItemType::FUNCTION:
+      return static_cast<HIR::Function &> (item).get_function_name ();
+    case HIR::ImplItem::ImplItemType::TYPE_ALIAS:
+      return static_cast<HIR::TypeAlias &> (item).get_new_type_name ();
+    case HIR::ImplItem::ImplItemType::CONSTANT:
+      return static_cast<HIR::ConstantItem &> (item).get_identifier ();
+    }
+  gcc_unreachable ();
+}
+
 void
 Mappings::insert_hir_impl_block (HIR::ImplBlock *item)
 {
@@ -423,6 +499,14 @@ Mappings::insert_hir_impl_block (HIR::ImplBlock *item)
   hirImplBlockMappings[id] = item;
   hirImplBlockTypeMappings[impl_type_id] = item;
   insert_node_to_hir (item->get_mappings ().get_nodeid (), id);
+
+  bool is_trait_impl = item->has_trait_ref ();
+  if (is_trait_impl)
+    hirTraitImplBlockMappings[id] = item;
+
+  for (auto &impl_item : item->get_impl_items ())
+    implItemsByName[Symbol::intern (impl_item_name (*impl_item))].push_back (
+      {impl_item.get (), item});
 }
 
 HIR::ImplBlock *
@@ -495,7 +579,7 @@ void
 Mappings::insert_hir_expr (HIR::Expr *expr)
 {
   auto id = expr->get_mappings ().get_hirid ();
-  hirExprMappings[id] = expr;
+  hirExprMappings.insert (id, expr);
 
   insert_node_to_hir (expr->get_mappings ().get_nodeid (), id);
   insert_location (id, expr->get_locus ());
@@ -504,11 +588,11 @@ Mappings::insert_hir_expr (HIR::Expr *expr)
 HIR::Expr *
 Mappings::lookup_hir_expr (HirId id)
 {
-  auto it = hirExprMappings.find (id);
-  if (it == hirExprMappings.end ())
+  auto lookup = hirExprMappings.lookup (id);
+  if (lookup == nullptr)
     return nullptr;
 
-  return it->second;
+  return *lookup;
 }
 
 void
@@ -517,7 +601,7 @@ Mappings::insert_hir_path_expr_seg (HIR::PathExprSegment *expr)
   auto id = expr->get_mappings ().get_hirid ();
   rust_assert (lookup_hir_path_expr_seg (id) == nullptr);
 
-  hirPathSegMappings[id] = expr;
+  hirPathSegMappings.insert (id, expr);
   insert_node_to_hir (expr->get_mappings ().get_nodeid (), id);
   insert_location (id, expr->get_locus ());
 }
@@ -525,11 +609,11 @@ Mappings::insert_hir_path_expr_seg (HIR::PathExprSegment *expr)
 HIR::PathExprSegment *
 Mappings::lookup_hir_path_expr_seg (HirId id)
 {
-  auto it = hirPathSegMappings.find (id);
-  if (it == hirPathSegMappings.end ())
+  auto lookup = hirPathSegMappings.lookup (id);
+  if (lookup == nullptr)
     return nullptr;
 
-  return it->second;
+  return *lookup;
 }
 
 void
@@ -559,18 +643,18 @@ Mappings::insert_hir_type (HIR::Type *type)
   auto id = type->get_mappings ().get_hirid ();
   rust_assert (lookup_hir_type (id) == nullptr);
 
-  hirTypeMappings[id] = type;
+  hirTypeMappings.insert (id, type);
   insert_node_to_hir (type->get_mappings ().get_nodeid (), id);
 }
 
 HIR::Type *
 Mappings::lookup_hir_type (HirId id)
 {
-  auto it = hirTypeMappings.find (id);
-  if (it == hirTypeMappings.end ())
+  auto lookup = hirTypeMappings.lookup (id);
+  if (lookup == nullptr)
     return nullptr;
 
-  return it->second;
+  return *lookup;
 }
 
 void
@@ -579,18 +663,18 @@ Mappings::insert_hir_stmt (HIR::Stmt *stmt)
   auto id = stmt->get_mappings ().get_hirid ();
   rust_assert (lookup_hir_stmt (id) == nullptr);
 
-  hirStmtMappings[id] = stmt;
+  hirStmtMappings.insert (id, stmt);
   insert_node_to_hir (stmt->get_mappings ().get_nodeid (), id);
 }
 
 HIR::Stmt *
 Mappings::lookup_hir_stmt (HirId id)
 {
-  auto it = hirStmtMappings.find (id);
-  if (it == hirStmtMappings.end ())
+  auto lookup = hirStmtMappings.lookup (id);
+  if (lookup == nullptr)
     return nullptr;
 
-  return it->second;
+  return *lookup;
 }
 
 void
@@ -599,18 +683,18 @@ Mappings::insert_hir_param (HIR::FunctionParam *param)
   auto id = param->get_mappings ().get_hirid ();
   rust_assert (lookup_hir_param (id) == nullptr);
 
-  hirParamMappings[id] = param;
+  hirParamMappings.insert (id, param);
   insert_node_to_hir (param->get_mappings ().get_nodeid (), id);
 }
 
 HIR::FunctionParam *
 Mappings::lookup_hir_param (HirId id)
 {
-  auto it = hirParamMappings.find (id);
-  if (it == hirParamMappings.end ())
+  auto lookup = hirParamMappings.lookup (id);
+  if (lookup == nullptr)
     return nullptr;
 
-  return it->second;
+  return *lookup;
 }
 
 void
@@ -659,18 +743,18 @@ Mappings::insert_hir_pattern (HIR::Pattern *pattern)
   auto id = pattern->get_pattern_mappings ().get_hirid ();
   rust_assert (lookup_hir_pattern (id) == nullptr);
 
-  hirPatternMappings[id] = pattern;
+  hirPatternMappings.insert (id, pattern);
   insert_node_to_hir (pattern->get_pattern_mappings ().get_nodeid (), id);
 }
 
 HIR::Pattern *
 Mappings::lookup_hir_pattern (HirId id)
 {
-  auto it = hirPatternMappings.find (id);
-  if (it == hirPatternMappings.end ())
+  auto lookup = hirPatternMappings.lookup (id);
+  if (lookup == nullptr)
     return nullptr;
 
-  return it->second;
+  return *lookup;
 }
 
 void
@@ -713,56 +797,88 @@ Mappings::walk_local_defids_for_crate (CrateNum crateNum,
 void
 Mappings::insert_node_to_hir (NodeId id, HirId ref)
 {
-  nodeIdToHirMappings[id] = ref;
-  hirIdToNodeMappings[ref] = id;
+  nodeIdToHirMappings.insert (id, ref);
+  hirIdToNodeMappings.insert (ref, id);
 }
 
 bool
 Mappings::lookup_node_to_hir (NodeId id, HirId *ref)
 {
-  auto it = nodeIdToHirMappings.find (id);
-  if (it == nodeIdToHirMappings.end ())
+  auto lookup = nodeIdToHirMappings.lookup (id);
+  if (lookup == nullptr)
     return false;
 
-  *ref = it->second;
+  *ref = *lookup;
   return true;
 }
 
 bool
 Mappings::lookup_hir_to_node (HirId id, NodeId *ref)
 {
-  auto it = hirIdToNodeMappings.find (id);
-  if (it == hirIdToNodeMappings.end ())
+  auto lookup = hirIdToNodeMappings.lookup (id);
+  if (lookup == nullptr)
     return false;
 
-  *ref = it->second;
+  *ref = *lookup;
   return true;
 }
 
 void
 Mappings::insert_location (HirId id, Location locus)
 {
-  locations[id] = locus;
+  locations.insert (id, locus);
 }
 
 Location
 Mappings::lookup_location (HirId id)
 {
-  auto it = locations.find (id);
-  if (it == locations.end ())
+  auto lookup = locations.lookup (id);
+  if (lookup == nullptr)
+    lookup = inference_locations.lookup (id);
+  if (lookup == nullptr)
     return Location ();
 
-  return it->second;
+  return *lookup;
+}
+
+void
+Mappings::insert_inference_location (HirId id, Location locus)
+{
+  inference_locations.insert (id, locus);
+}
+
+void
+Mappings::release_inference_locations ()
+{
+  DenseIdMap<Location> empty;
+  std::swap (inference_locations, empty);
+}
+
+void
+Mappings::insert_retained_uses (HirId id, std::vector<HirId> uses)
+{
+  auto &existing = retainedUses[id];
+  existing.insert (existing.end (), uses.begin (), uses.end ());
+}
+
+const std::vector<HirId> *
+Mappings::lookup_retained_uses (HirId id) const
+{
+  auto it = retainedUses.find (id);
+  if (it == retainedUses.end ())
+    return nullptr;
+
+  return &it->second;
 }
 
 bool
 Mappings::resolve_nodeid_to_stmt (NodeId id, HIR::Stmt **stmt)
 {
-  auto it = nodeIdToHirMappings.find (id);
-  if (it == nodeIdToHirMappings.end ())
+  auto lookup = nodeIdToHirMappings.lookup (id);
+  if (lookup == nullptr)
     return false;
 
-  HirId resolved = it->second;
+  HirId resolved = *lookup;
   auto resolved_stmt = lookup_hir_stmt (resolved);
   *stmt = resolved_stmt;
   return resolved_stmt != nullptr;
@@ -784,6 +900,23 @@ Mappings::iterate_impl_items (
     }
 }
 
+void
+Mappings::iterate_impl_items_named (
+  Symbol item_name,
+  std::function<bool (HirId, HIR::ImplItem *, HIR::ImplBlock *)> cb)
+{
+  auto it = implItemsByName.find (item_name);
+  if (it == implItemsByName.end ())
+    return;
+
+  for (auto &candidate : it->second)
+    {
+      HIR::ImplItem *item = candidate.first;
+      if (!cb (item->get_impl_mappings ().get_hirid (), item, candidate.second))
+	return;
+    }
+}
+
 void
 Mappings::iterate_impl_blocks (std::function<bool (HirId, HIR::ImplBlock *)> cb)
 {
@@ -797,6 +930,48 @@ Mappings::iterate_impl_blocks (std::function<bool (HirId, HIR::ImplBlock *)> cb)
     }
 }
 
+void
+Mappings::iterate_trait_impl_blocks (
+  std::function<bool (HirId, HIR::ImplBlock *)> cb)
+{
+  for (auto it = hirTraitImplBlockMappings.begin ();
+       it != hirTraitImplBlockMappings.end (); it++)
+    {
+      HirId id = it->first;
+      HIR::ImplBlock *impl_block = it->second;
+      if (!cb (id, impl_block))
+	return;
+    }
+}
+
+void
+Mappings::iterate_impl_methods (
+  Symbol method_name, bool trait_impls,
+  std::function<bool (HIR::Function *, HIR::ImplBlock *)> cb)
+{
+  auto it = implItemsByName.find (method_name);
+  if (it == implItemsByName.end ())
+    return;
+
+  for (auto &candidate : it->second)
+    {
+      HIR::ImplBlock *impl = candidate.second;
+      if (impl->has_trait_ref () != trait_impls)
+	continue;
+
+      HIR::ImplItem *item = candidate.first;
+      if (item->get_impl_item_type () != HIR::ImplItem::ImplItemType::FUNCTION)
+	continue;
+
+      HIR::Function *fn = static_cast<HIR::Function *> (item);
+      if (!fn->is_method ())
+	continue;
+
+      if (!cb (fn, impl))
+	return;
+    }
+}
+
 void
 Mappings::iterate_trait_items (
   std::function<bool (HIR::TraitItem *, HIR::Trait *)> cb)
@@ -891,6 +1066,8 @@ Mappings::insert_module_child (NodeId module, NodeId child)
     module_child_map.insert ({module, {child}});
   else
     it->second.emplace_back (child);
+
+  module_tree_times_valid = false;
 }
 
 Optional<std::vector<NodeId> &>
@@ -903,6 +1080,63 @@ Mappings::lookup_module_children (NodeId module)
   return Optional<std::vector<NodeId> &>::some (it->second);
 }
 
+void
+Mappings::number_module_tree ()
+{
+  module_tree_times.clear ();
+
+  std::set<NodeId> children;
+  for (auto &entry : module_child_map)
+    children.insert (entry.second.begin (), entry.second.end ());
+
+  // Walk from every root, keeping an explicit stack so that deeply nested
+  // modules don't recurse
+  size_t time = 0;
+  std::vector<std::pair<NodeId, size_t>> stack;
+  for (auto &entry : module_child_map)
+    {
+      if (children.find (entry.first) != children.end ())
+	continue;
+
+      module_tree_times[entry.first].first = time++;
+      stack.push_back ({entry.first, 0});
+      while (!stack.empty ())
+	{
+	  NodeId module = stack.back ().first;
+	  size_t next = stack.back ().second++;
+
+	  auto it = module_child_map.find (module);
+	  if (it == module_child_map.end () || next >= it->second.size ())
+	    {
+	      module_tree_times[module].second = time++;
+	      stack.pop_back ();
+	      continue;
+	    }
+
+	  NodeId child = it->second[next];
+	  module_tree_times[child].first = time++;
+	  stack.push_back ({child, 0});
+	}
+    }
+
+  module_tree_times_valid = true;
+}
+
+bool
+Mappings::is_module_descendant (NodeId ancestor, NodeId module)
+{
+  if (!module_tree_times_valid)
+    number_module_tree ();
+
+  auto a = module_tree_times.find (ancestor);
+  auto m = module_tree_times.find (module);
+  if (a == module_tree_times.end () || m == module_tree_times.end ())
+    return false;
+
+  return a->second.first < m->second.first
+	 && m->second.second < a->second.second;
+}
+
 void
 Mappings::insert_module_child_item (NodeId module,
 				    Resolver::CanonicalPath child)
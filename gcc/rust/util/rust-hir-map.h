@@ -23,23 +23,38 @@
 #include "rust-system.h"
 #include "rust-location.h"
 #include "rust-mapping-common.h"
+#include "rust-dense-id-map.h"
+#include "rust-symbol.h"
 #include "rust-canonical-path.h"
 #include "rust-ast-full-decls.h"
 #include "rust-hir-full-decls.h"
 #include "rust-lang-item.h"
 #include "rust-privacy-common.h"
+#include "rust-compilation-context.h"
 
 namespace Rust {
 namespace Analysis {
 
+/**
+ * The ids attached to every HIR node. The crate number and the local def id
+ * share a single word: crates get the top kCrateNumBits bits and local def
+ * ids the rest, which keeps the header every HIR node carries at 12 bytes.
+ */
 class NodeMapping
 {
 public:
+  static const unsigned kCrateNumBits = 12;
+  static const uint32_t kMaxCrateNum = (1u << kCrateNumBits) - 1;
+  static const uint32_t kMaxLocalDefId = (1u << (32 - kCrateNumBits)) - 1;
+
   NodeMapping (CrateNum crateNum, NodeId nodeId, HirId hirId,
 	       LocalDefId localDefId)
-    : crateNum (crateNum), nodeId (nodeId), hirId (hirId),
-      localDefId (localDefId)
-  {}
+    : nodeId (nodeId), hirId (hirId),
+      defIndex ((crateNum << (32 - kCrateNumBits)) | localDefId)
+  {
+    rust_assert (crateNum <= kMaxCrateNum);
+    rust_assert (localDefId <= kMaxLocalDefId);
+  }
 
   static NodeMapping get_error ();
 
@@ -62,10 +77,9 @@ public:
   }
 
 private:
-  CrateNum crateNum;
   NodeId nodeId;
   HirId hirId;
-  LocalDefId localDefId;
+  uint32_t defIndex;
 };
 
 class Mappings
@@ -85,6 +99,11 @@ public:
   bool crate_num_to_nodeid (const CrateNum &crate_num, NodeId &node_id) const;
   bool node_is_crate (NodeId node_id) const;
 
+  // the generic instances extern crates define for their dependents to link
+  // against, by assembler name
+  void insert_shared_instance (const std::string &symbol);
+  bool is_shared_instance (const std::string &symbol) const;
+
   NodeId get_next_node_id ();
   HirId get_next_hir_id () { return get_next_hir_id (get_current_crate ()); }
   HirId get_next_hir_id (CrateNum crateNum);
@@ -94,10 +113,19 @@ public:
   }
   LocalDefId get_next_localdef_id (CrateNum crateNum);
 
+  // how many ids have been handed out, which is how many AST and HIR nodes
+  // have been created, and how many entries the main tables hold
+  size_t get_num_node_ids () const;
+  size_t get_num_hir_ids () const;
+  size_t get_num_entries () const;
+
   AST::Crate &get_ast_crate (CrateNum crateNum);
   AST::Crate &get_ast_crate_by_node_id (NodeId id);
   AST::Crate &insert_ast_crate (std::unique_ptr<AST::Crate> &&crate,
 				CrateNum crate_num);
+  // free the AST of every crate once it has been lowered; the crate node ids
+  // stay known
+  void release_ast_crates ();
   HIR::Crate &insert_hir_crate (std::unique_ptr<HIR::Crate> &&crate);
   HIR::Crate &get_hir_crate (CrateNum crateNum);
   bool is_local_hirid_crate (HirId crateNum);
@@ -168,12 +196,20 @@ public:
   void insert_location (HirId id, Location locus);
   Location lookup_location (HirId id);
 
+  // locations of inference variables are only needed to report type errors,
+  // they are kept apart so they can be released once type checking is done
+  void insert_inference_location (HirId id, Location locus);
+  void release_inference_locations ();
+
+  // the locals and constants referred to by code the HIR simplifier folded
+  // away or proved unreachable, keyed by the node standing in for that code,
+  // so they are still marked as used when the node is compiled
+  void insert_retained_uses (HirId id, std::vector<HirId> uses);
+  const std::vector<HirId> *lookup_retained_uses (HirId id) const;
+
   bool resolve_nodeid_to_stmt (NodeId id, HIR::Stmt **stmt);
 
-  std::set<HirId> &get_hirids_within_crate (CrateNum crate)
-  {
-    return hirNodesWithinCrate[crate];
-  }
+  bool is_hirid_within_crate (CrateNum crate, HirId id) const;
 
   void insert_impl_item_mapping (HirId impl_item_id, HIR::ImplBlock *impl)
   {
@@ -192,8 +228,25 @@ public:
   void iterate_impl_items (
     std::function<bool (HirId, HIR::ImplItem *, HIR::ImplBlock *)> cb);
 
+  // the impl items called ITEM_NAME, in the order of their impl blocks
+  void iterate_impl_items_named (
+    Symbol item_name,
+    std::function<bool (HirId, HIR::ImplItem *, HIR::ImplBlock *)> cb);
+
   void iterate_impl_blocks (std::function<bool (HirId, HIR::ImplBlock *)> cb);
 
+  void iterate_trait_impl_blocks (
+    std::function<bool (HirId, HIR::ImplBlock *)> cb);
+
+  size_t get_num_trait_impl_blocks () const
+  {
+    return hirTraitImplBlockMappings.size ();
+  }
+
+  void iterate_impl_methods (
+    Symbol method_name, bool trait_impls,
+    std::function<bool (HIR::Function *, HIR::ImplBlock *)> cb);
+
   void iterate_trait_items (
     std::function<bool (HIR::TraitItem *item, HIR::Trait *)> cb);
 
@@ -275,6 +328,11 @@ public:
   void insert_module_child (NodeId module, NodeId child);
   Optional<std::vector<NodeId> &> lookup_module_children (NodeId module);
 
+  /* Is MODULE a strict descendant of ANCESTOR in the module tree? Answered in
+   * constant time from entry and exit times of a walk of the tree, which is
+   * redone lazily after the tree changed. */
+  bool is_module_descendant (NodeId ancestor, NodeId module);
+
   void insert_module_child_item (NodeId module, Resolver::CanonicalPath item);
   Optional<std::vector<Resolver::CanonicalPath> &>
   lookup_module_chidren_items (NodeId module);
@@ -290,6 +348,7 @@ public:
   bool lookup_ast_item (NodeId id, AST::Item **result);
 
 private:
+  friend class Rust::CompilationContext;
   Mappings ();
 
   CrateNum crateNumItr;
@@ -305,38 +364,52 @@ private:
   std::map<CrateNum, std::map<LocalDefId, HIR::Item *>> localDefIdMappings;
 
   std::map<HirId, HIR::Module *> hirModuleMappings;
-  std::map<HirId, HIR::Item *> hirItemMappings;
-  std::map<HirId, HIR::Type *> hirTypeMappings;
-  std::map<HirId, HIR::Expr *> hirExprMappings;
-  std::map<HirId, HIR::Stmt *> hirStmtMappings;
-  std::map<HirId, HIR::FunctionParam *> hirParamMappings;
+  DenseIdMap<HIR::Item *> hirItemMappings;
+  DenseIdMap<HIR::Type *> hirTypeMappings;
+  DenseIdMap<HIR::Expr *> hirExprMappings;
+  DenseIdMap<HIR::Stmt *> hirStmtMappings;
+  DenseIdMap<HIR::FunctionParam *> hirParamMappings;
   std::map<HirId, HIR::StructExprField *> hirStructFieldMappings;
   std::map<HirId, std::pair<HirId, HIR::ImplItem *>> hirImplItemMappings;
   std::map<HirId, HIR::SelfParam *> hirSelfParamMappings;
   std::map<HirId, HIR::ImplBlock *> hirImplItemsToImplMappings;
   std::map<HirId, HIR::ImplBlock *> hirImplBlockMappings;
   std::map<HirId, HIR::ImplBlock *> hirImplBlockTypeMappings;
+  std::map<HirId, HIR::ImplBlock *> hirTraitImplBlockMappings;
   std::map<HirId, HIR::TraitItem *> hirTraitItemMappings;
   std::map<HirId, HIR::ExternBlock *> hirExternBlockMappings;
   std::map<HirId, std::pair<HIR::ExternalItem *, HirId>> hirExternItemMappings;
-  std::map<HirId, HIR::PathExprSegment *> hirPathSegMappings;
+  DenseIdMap<HIR::PathExprSegment *> hirPathSegMappings;
   std::map<HirId, HIR::GenericParam *> hirGenericParamMappings;
   std::map<HirId, HIR::Trait *> hirTraitItemsToTraitMappings;
-  std::map<HirId, HIR::Pattern *> hirPatternMappings;
+  DenseIdMap<HIR::Pattern *> hirPatternMappings;
   std::map<RustLangItem::ItemType, DefId> lang_item_mappings;
   std::map<NodeId, const Resolver::CanonicalPath> paths;
-  std::map<NodeId, Location> locations;
-  std::map<NodeId, HirId> nodeIdToHirMappings;
-  std::map<HirId, NodeId> hirIdToNodeMappings;
-
-  // all hirid nodes
-  std::map<CrateNum, std::set<HirId>> hirNodesWithinCrate;
+  DenseIdMap<Location> locations;
+  DenseIdMap<Location> inference_locations;
+  DenseIdMap<HirId> nodeIdToHirMappings;
+  DenseIdMap<NodeId> hirIdToNodeMappings;
+  std::map<HirId, std::vector<HirId>> retainedUses;
+
+  // the items of every impl block keyed by their name, which gives both the
+  // candidates of associated item paths such as Foo::new and the method
+  // candidates of a receiver
+  std::unordered_map<Symbol,
+		     std::vector<std::pair<HIR::ImplItem *, HIR::ImplBlock *>>>
+    implItemsByName;
+
+  // all hirid nodes, ids are handed out in increasing order so each crate
+  // owns a few contiguous runs of them [first, last] rather than having every
+  // id recorded on its own
+  std::map<CrateNum, std::vector<std::pair<HirId, HirId>>>
+    hirIdRangesWithinCrate;
 
   // macros
   std::map<NodeId, AST::MacroRulesDefinition *> macroMappings;
 
   // crate names
   std::map<CrateNum, std::string> crate_names;
+  std::set<std::string> shared_instances;
 
   // Low level visibility map for each DefId
   std::map<NodeId, Privacy::ModuleVisibility> visibility_map;
@@ -348,6 +421,11 @@ private:
   std::map<NodeId, std::vector<Resolver::CanonicalPath>> module_child_items;
   std::map<NodeId, NodeId> child_to_parent_module_map;
 
+  // Entry and exit times of each module in a depth-first walk of the tree
+  std::unordered_map<NodeId, std::pair<size_t, size_t>> module_tree_times;
+  bool module_tree_times_valid;
+  void number_module_tree ();
+
   // AST mappings
   std::map<NodeId, AST::Item *> ast_item_mappings;
 };
@@ -73,6 +73,9 @@ public:
     MUT_PTR,
     CONST_SLICE_PTR,
 
+    // https://github.com/rust-lang/rust/blob/master/library/core/src/cell.rs
+    UNSAFE_CELL,
+
     UNKNOWN,
   };
 
@@ -218,6 +221,10 @@ public:
       {
 	return ItemType::CONST_SLICE_PTR;
       }
+    else if (item.compare ("unsafe_cell") == 0)
+      {
+	return ItemType::UNSAFE_CELL;
+      }
 
     return ItemType::UNKNOWN;
   }
@@ -296,6 +303,8 @@ public:
 	return "mut_ptr";
       case CONST_SLICE_PTR:
 	return "const_slice_ptr";
+      case UNSAFE_CELL:
+	return "unsafe_cell";
 
       case UNKNOWN:
 	return "<UNKNOWN>";
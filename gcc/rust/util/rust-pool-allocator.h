@@ -0,0 +1,268 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_POOL_ALLOCATOR_H
+#define RUST_POOL_ALLOCATOR_H
+
+#include "rust-system.h"
+
+namespace Rust {
+
+/**
+ * Free list of fixed size blocks carved out of large chunks. Released blocks
+ * are reused for the next allocation; the chunks themselves are never freed.
+ */
+template <size_t Size, size_t Align> class FixedSizePool
+{
+public:
+  FixedSizePool () : free_list (nullptr), next (nullptr), limit (nullptr) {}
+
+  FixedSizePool (const FixedSizePool &other) = delete;
+  FixedSizePool &operator= (const FixedSizePool &other) = delete;
+
+  void *allocate ()
+  {
+    if (free_list != nullptr)
+      {
+	FreeBlock *block = free_list;
+	free_list = block->next;
+	return block;
+      }
+
+    if (next == limit)
+      {
+	char *chunk
+	  = static_cast<char *> (::operator new (block_size * chunk_blocks));
+	next = chunk;
+	limit = chunk + block_size * chunk_blocks;
+      }
+
+    void *block = next;
+    next += block_size;
+    return block;
+  }
+
+  void release (void *ptr)
+  {
+    FreeBlock *block = static_cast<FreeBlock *> (ptr);
+    block->next = free_list;
+    free_list = block;
+  }
+
+private:
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  static const size_t min_size
+    = Size < sizeof (FreeBlock) ? sizeof (FreeBlock) : Size;
+  static const size_t align
+    = Align < alignof (FreeBlock) ? alignof (FreeBlock) : Align;
+  static const size_t block_size = (min_size + align - 1) / align * align;
+  static const size_t chunk_blocks = 256;
+
+  FreeBlock *free_list;
+  char *next;
+  char *limit;
+};
+
+/**
+ * Allocator handing out single objects from a FixedSizePool shared by every
+ * allocator of the same type. It is meant for objects that are created and
+ * destroyed at a high rate, such as the tokens of the lexer, and is not thread
+ * safe.
+ */
+template <typename T> class PoolAllocator
+{
+public:
+  typedef T value_type;
+
+  PoolAllocator () {}
+
+  template <typename U> PoolAllocator (const PoolAllocator<U> &) {}
+
+  T *allocate (size_t n)
+  {
+    if (n != 1)
+      return static_cast<T *> (::operator new (n * sizeof (T)));
+
+    return static_cast<T *> (get_pool ().allocate ());
+  }
+
+  void deallocate (T *ptr, size_t n)
+  {
+    if (n != 1)
+      ::operator delete (ptr);
+    else
+      get_pool ().release (ptr);
+  }
+
+  template <typename U> bool operator== (const PoolAllocator<U> &) const
+  {
+    return true;
+  }
+
+  template <typename U> bool operator!= (const PoolAllocator<U> &) const
+  {
+    return false;
+  }
+
+private:
+  // the pool is intentionally leaked so that objects released during static
+  // destruction at exit do not touch a destroyed pool
+  static FixedSizePool<sizeof (T), alignof (T)> &get_pool ()
+  {
+    static FixedSizePool<sizeof (T), alignof (T)> *pool
+      = new FixedSizePool<sizeof (T), alignof (T)> ();
+    return *pool;
+  }
+};
+
+/**
+ * Set of free lists for small objects of arbitrary size. Requests are rounded
+ * up to a multiple of granularity and served from the list of that size
+ * class out of shared chunks; anything larger than max_size goes straight to
+ * the global operator new. Like FixedSizePool, the chunks are never freed.
+ */
+class SizeClassPool
+{
+public:
+  static const size_t granularity = 16;
+  static const size_t max_size = 512;
+
+  SizeClassPool ()
+    : next (nullptr), limit (nullptr), live_objects (0), reserved_bytes (0)
+  {
+    for (size_t i = 0; i < num_classes; i++)
+      free_lists[i] = nullptr;
+  }
+
+  SizeClassPool (const SizeClassPool &other) = delete;
+  SizeClassPool &operator= (const SizeClassPool &other) = delete;
+
+  void *allocate (size_t size)
+  {
+    live_objects++;
+    if (size > max_size)
+      return ::operator new (size);
+
+    size_t index = size_class (size);
+    if (free_lists[index] != nullptr)
+      {
+	FreeBlock *block = free_lists[index];
+	free_lists[index] = block->next;
+	return block;
+      }
+
+    size_t block_size = (index + 1) * granularity;
+    if (static_cast<size_t> (limit - next) < block_size)
+      {
+	// the tail of the old chunk is too small for this class, hand it to
+	// the free lists of the classes it still fits so it is not lost
+	while (static_cast<size_t> (limit - next) >= granularity)
+	  {
+	    size_t tail = static_cast<size_t> (limit - next);
+	    size_t tail_index
+	      = (tail > max_size ? max_size : tail) / granularity - 1;
+	    release_block (next, tail_index);
+	    next += (tail_index + 1) * granularity;
+	  }
+
+	next = static_cast<char *> (::operator new (chunk_size));
+	limit = next + chunk_size;
+	reserved_bytes += chunk_size;
+      }
+
+    void *block = next;
+    next += block_size;
+    return block;
+  }
+
+  void release (void *ptr, size_t size)
+  {
+    live_objects--;
+    if (size > max_size)
+      ::operator delete (ptr);
+    else
+      release_block (ptr, size_class (size));
+  }
+
+  // objects currently allocated from the pool and the bytes held in chunks,
+  // oversized objects go straight to operator new and are not in the latter
+  size_t get_live_objects () const { return live_objects; }
+  size_t get_reserved_bytes () const { return reserved_bytes; }
+
+  // the pool is intentionally leaked, see PoolAllocator::get_pool
+  static SizeClassPool &get ()
+  {
+    static SizeClassPool *pool = new SizeClassPool ();
+    return *pool;
+  }
+
+private:
+  struct FreeBlock
+  {
+    FreeBlock *next;
+  };
+
+  static const size_t num_classes = max_size / granularity;
+  static const size_t chunk_size = 64 * 1024;
+
+  static size_t size_class (size_t size)
+  {
+    return size == 0 ? 0 : (size - 1) / granularity;
+  }
+
+  void release_block (void *ptr, size_t index)
+  {
+    FreeBlock *block = static_cast<FreeBlock *> (ptr);
+    block->next = free_lists[index];
+    free_lists[index] = block;
+  }
+
+  FreeBlock *free_lists[num_classes];
+  char *next;
+  char *limit;
+  size_t live_objects;
+  size_t reserved_bytes;
+};
+
+/**
+ * Base class giving a class hierarchy class-specific operator new and delete
+ * backed by the shared SizeClassPool. The sized operator delete receives the
+ * size of the most derived object as long as the hierarchy has a virtual
+ * destructor, so objects of any subclass can be pooled this way.
+ */
+class PoolAllocated
+{
+public:
+  static void *operator new (size_t size)
+  {
+    return SizeClassPool::get ().allocate (size);
+  }
+
+  static void operator delete (void *ptr, size_t size)
+  {
+    SizeClassPool::get ().release (ptr, size);
+  }
+};
+
+} // namespace Rust
+
+#endif // RUST_POOL_ALLOCATOR_H
@@ -0,0 +1,53 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-symbol.h"
+
+namespace Rust {
+
+// the elements of an unordered_set are never moved, so pointers to them stay
+// valid for the duration of the compilation
+static std::unordered_set<std::string> &
+get_symbol_table ()
+{
+  static std::unordered_set<std::string> table;
+  return table;
+}
+
+Symbol
+Symbol::intern (const std::string &str)
+{
+  auto it = get_symbol_table ().insert (str).first;
+  return Symbol (&*it);
+}
+
+bool
+Symbol::is_interned (const std::string &str)
+{
+  const auto &table = get_symbol_table ();
+  return table.find (str) != table.end ();
+}
+
+const std::string &
+Symbol::as_string () const
+{
+  static const std::string empty;
+  return str == nullptr ? empty : *str;
+}
+
+} // namespace Rust
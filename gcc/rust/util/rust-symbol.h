@@ -0,0 +1,77 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_SYMBOL_H
+#define RUST_SYMBOL_H
+
+#include "rust-system.h"
+
+namespace Rust {
+
+/**
+ * An interned string. Each distinct string is only stored once in the symbol
+ * table for the whole compilation, so symbols are cheap to copy and comparing
+ * or hashing two symbols is a pointer comparison.
+ */
+class Symbol
+{
+public:
+  Symbol () : str (nullptr) {}
+
+  /**
+   * Lookup the symbol for this string, creating it if this is the first time
+   * it has been seen
+   */
+  static Symbol intern (const std::string &str);
+
+  /**
+   * Whether this string has already been interned, without interning it
+   */
+  static bool is_interned (const std::string &str);
+
+  const std::string &as_string () const;
+
+  bool is_null () const { return str == nullptr; }
+
+  bool is_empty () const { return str == nullptr || str->empty (); }
+
+  bool operator== (const Symbol &other) const { return str == other.str; }
+
+  bool operator!= (const Symbol &other) const { return str != other.str; }
+
+  size_t hash () const { return std::hash<const std::string *> () (str); }
+
+private:
+  explicit Symbol (const std::string *str) : str (str) {}
+
+  const std::string *str;
+};
+
+} // namespace Rust
+
+namespace std {
+template <> struct hash<Rust::Symbol>
+{
+  size_t operator() (const Rust::Symbol &sym) const noexcept
+  {
+    return sym.hash ();
+  }
+};
+} // namespace std
+
+#endif // RUST_SYMBOL_H
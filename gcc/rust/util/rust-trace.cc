@@ -0,0 +1,103 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#include "rust-trace.h"
+#include "rust-diagnostics.h"
+#include "json.h"
+
+namespace Rust {
+
+bool Trace::active = false;
+
+static json::array *trace_events = nullptr;
+
+void
+Trace::start ()
+{
+  rust_assert (trace_events == nullptr);
+  trace_events = new json::array ();
+  active = true;
+}
+
+void
+Trace::finish (const char *filename)
+{
+  if (trace_events == nullptr)
+    return;
+
+  active = false;
+
+  json::object root;
+  root.set ("traceEvents", trace_events);
+  root.set ("displayTimeUnit", new json::string ("ms"));
+  trace_events = nullptr;
+
+  FILE *out = fopen (filename, "w");
+  if (out == nullptr)
+    {
+      rust_error_at (Location (), "cannot open %s:%m", filename);
+      return;
+    }
+
+  root.dump (out);
+  fprintf (out, "\n");
+  fclose (out);
+}
+
+void
+Trace::event (
+  char phase, const char *category, const char *name,
+  const std::vector<std::pair<const char *, std::string>> &args)
+{
+  char ph[2] = {phase, '\0'};
+
+  json::object *event = new json::object ();
+  event->set ("name", new json::string (name));
+  event->set ("cat", new json::string (category));
+  event->set ("ph", new json::string (ph));
+  // get_run_time is in microseconds, the unit of the format
+  event->set ("ts", new json::integer_number (get_run_time ()));
+  event->set ("pid", new json::integer_number (1));
+  event->set ("tid", new json::integer_number (1));
+
+  if (!args.empty ())
+    {
+      json::object *event_args = new json::object ();
+      for (const auto &arg : args)
+	event_args->set (arg.first, new json::string (arg.second.c_str ()));
+      event->set ("args", event_args);
+    }
+
+  trace_events->append (event);
+}
+
+TraceScope::TraceScope (const char *category, const char *name)
+  : category (category), name (name), active (Trace::enabled ())
+{
+  if (active)
+    Trace::event ('B', category, name, {});
+}
+
+TraceScope::~TraceScope ()
+{
+  // tracing may have finished while the scope was open
+  if (active && Trace::enabled ())
+    Trace::event ('E', category, name, args);
+}
+
+} // namespace Rust
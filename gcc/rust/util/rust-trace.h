@@ -0,0 +1,74 @@
+// Copyright (C) 2020-2022 Free Software Foundation, Inc.
+
+// This file is part of GCC.
+
+// GCC is free software; you can redistribute it and/or modify it under
+// the terms of the GNU General Public License as published by the Free
+// Software Foundation; either version 3, or (at your option) any later
+// version.
+
+// GCC is distributed in the hope that it will be useful, but WITHOUT ANY
+// WARRANTY; without even the implied warranty of MERCHANTABILITY or
+// FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License
+// for more details.
+
+// You should have received a copy of the GNU General Public License
+// along with GCC; see the file COPYING3.  If not see
+// <http://www.gnu.org/licenses/>.
+
+#ifndef RUST_TRACE_H
+#define RUST_TRACE_H
+
+#include "rust-system.h"
+
+namespace Rust {
+
+/* Records begin/end events for -frust-trace=FILE, written out in the Chrome
+ * trace event format so that the trace can be loaded in about:tracing or
+ * Perfetto. Timevars only give the total of each pass, the trace shows which
+ * items the time went to. */
+class Trace
+{
+public:
+  static void start ();
+  static void finish (const char *filename);
+
+  static bool enabled () { return active; }
+
+private:
+  friend class TraceScope;
+
+  static void event (char phase, const char *category, const char *name,
+		     const std::vector<std::pair<const char *, std::string>>
+		       &args);
+
+  static bool active;
+};
+
+/* A begin event on construction and the matching end event on destruction,
+ * when tracing is enabled. Arguments such as the path of the item are
+ * attached to the end event, so that callers only compute them after
+ * checking is_active (). */
+class TraceScope
+{
+public:
+  TraceScope (const char *category, const char *name);
+  ~TraceScope ();
+
+  bool is_active () const { return active; }
+
+  void add_arg (const char *key, std::string value)
+  {
+    args.push_back ({key, std::move (value)});
+  }
+
+private:
+  const char *category;
+  const char *name;
+  bool active;
+  std::vector<std::pair<const char *, std::string>> args;
+};
+
+} // namespace Rust
+
+#endif // RUST_TRACE_H
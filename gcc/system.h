@@ -226,6 +226,9 @@ extern int errno;
 #ifdef INCLUDE_MAP
 # include <map>
 #endif
+#ifdef INCLUDE_UNORDERED_MAP
+# include <unordered_map>
+#endif
 #ifdef INCLUDE_SET
 # include <set>
 #endif
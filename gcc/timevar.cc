@@ -23,6 +23,7 @@ along with GCC; see the file COPYING3.  If not see
 #include "coretypes.h"
 #include "timevar.h"
 #include "options.h"
+#include "json.h"
 
 #ifndef HAVE_CLOCK_T
 typedef int clock_t;
@@ -134,6 +135,7 @@ class timer::named_items
   void push (const char *item_name);
   void pop ();
   void print (FILE *fp, const timevar_time_def *total);
+  json::array *make_json ();
 
  private:
   /* Which timer instance does this relate to?  */
@@ -207,6 +209,25 @@ timer::named_items::print (FILE *fp, const timevar_time_def *total)
     }
 }
 
+static json::object *make_json_row (const char *,
+				    const timevar_time_def &);
+
+/* Return the given client items as a JSON array.  Helper function for
+   timer::print_json.  */
+
+json::array *
+timer::named_items::make_json ()
+{
+  json::array *items = new json::array ();
+  for (const char *item_name : m_names)
+    {
+      timer::timevar_def *def = m_hash_map.get (item_name);
+      gcc_assert (def);
+      items->append (make_json_row (def->name, def->elapsed));
+    }
+  return items;
+}
+
 /* Fill the current times into TIME.  The definition of this function
    also defines any or all of the HAVE_USER_TIME, HAVE_SYS_TIME, and
    HAVE_WALL_TIME macros.  */
@@ -791,6 +812,82 @@ timer::print (FILE *fp)
   validate_phases (fp);
 }
 
+/* Return a JSON object with the name NAME and the times of ELAPSED, in
+   seconds, and the ggc memory it allocated, in bytes.  Helper function
+   for timer::print_json.  */
+
+static json::object *
+make_json_row (const char *name, const timevar_time_def &elapsed)
+{
+  json::object *row = new json::object ();
+  row->set ("name", new json::string (name));
+#ifdef HAVE_USER_TIME
+  row->set ("user", new json::float_number (elapsed.user));
+#endif
+#ifdef HAVE_SYS_TIME
+  row->set ("sys", new json::float_number (elapsed.sys));
+#endif
+#ifdef HAVE_WALL_TIME
+  row->set ("wall", new json::float_number (elapsed.wall));
+#endif
+  row->set ("ggc_mem", new json::integer_number ((long) elapsed.ggc_mem));
+  return row;
+}
+
+/* Summarize timing variables to FP as a JSON object, for
+   -ftime-report-format=json.  This reports the same timing variables
+   as timer::print, with the time spent in each of them under each
+   parent in a "children" array of the parent.  The times are not
+   rounded and the rows that would print as zeroes are kept.  */
+
+void
+timer::print_json (FILE *fp)
+{
+  const timevar_time_def *total = &m_timevars[TV_TOTAL].elapsed;
+  struct timevar_time_def now;
+
+  if (fp == 0)
+    fp = stderr;
+
+  /* As in timer::print, attribute the time elapsed so far to the
+     topmost element of the stack.  */
+  get_time (&now);
+  if (m_stack)
+    timevar_accumulate (&m_stack->timevar->elapsed, &m_start_time, &now);
+  m_start_time = now;
+
+  json::object *report = new json::object ();
+  json::array *timevars = new json::array ();
+  for (unsigned int id = 0; id < (unsigned int) TIMEVAR_LAST; ++id)
+    {
+      const timevar_def *tv = &m_timevars[(timevar_id_t) id];
+      if ((timevar_id_t) id == TV_TOTAL || !tv->used)
+	continue;
+
+      json::object *row = make_json_row (tv->name, tv->elapsed);
+      if (tv->children)
+	{
+	  json::array *children = new json::array ();
+	  for (child_map_t::iterator i = tv->children->begin ();
+	       i != tv->children->end (); ++i)
+	    children->append (make_json_row ((*i).first->name, (*i).second));
+	  row->set ("children", children);
+	}
+      timevars->append (row);
+    }
+  report->set ("timevars", timevars);
+  if (m_jit_client_items)
+    report->set ("client_items", m_jit_client_items->make_json ());
+  report->set ("total", make_json_row ("TOTAL", *total));
+  report->set ("checking", new json::literal (CHECKING_P || flag_checking));
+
+  report->dump (fp);
+  fputc ('\n', fp);
+  delete report;
+
+  validate_phases (fp);
+}
+
 /* Get the name of the topmost item.  For use by jit for validating
    inputs to gcc_jit_timer_pop.  */
 const char *
@@ -119,6 +119,7 @@ class timer
   void pop_client_item ();
 
   void print (FILE *fp);
+  void print_json (FILE *fp);
 
   const char *get_topmost_item_name () const;
 
@@ -2151,7 +2151,10 @@ toplev::~toplev ()
   if (g_timer && m_use_TV_TOTAL)
     {
       g_timer->stop (TV_TOTAL);
-      g_timer->print (stderr);
+      if (flag_time_report_format == TIME_REPORT_FORMAT_JSON)
+	g_timer->print_json (stderr);
+      else
+	g_timer->print (stderr);
       delete g_timer;
       g_timer = NULL;
     }
@@ -2276,6 +2279,9 @@ toplev::main (int argc, char **argv)
 	start_timevars ();
       do_compile (no_backend);
 
+      if (flag_time_report_functions)
+	print_function_pass_costs (stderr);
+
       if (flag_self_test)
 	{
 	  if (no_backend)
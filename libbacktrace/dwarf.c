@@ -290,6 +290,22 @@ struct function_vector
   size_t count;
 };
 
+/* The line number and function information of a compilation unit.
+   This is read in when a PC is first looked up in the unit, and never
+   changed after that, so that in threaded mode it can be stored into
+   the unit with a single compare and swap.  */
+
+struct unit_lines
+{
+  /* PC to line number mapping.  */
+  struct line *lines;
+  /* Number of entries in lines.  */
+  size_t lines_count;
+  /* PC ranges to function.  */
+  struct function_addrs *function_addrs;
+  size_t function_addrs_count;
+};
+
 /* A DWARF compilation unit.  This only holds the information we need
    to map a PC to a file and line.  */
 
@@ -314,6 +330,16 @@ struct unit
   int is_dwarf64;
   /* Address size.  */
   int addrsize;
+  /* Offset of the abbreviations for this unit in .debug_abbrev.  */
+  uint64_t abbrev_offset;
+
+  /* The fields above this point are read in during initialization and
+     may be accessed freely.  The fields from here to ABBREVS are read
+     from the unit DIE.  That is done during initialization, unless
+     .debug_aranges told us the address ranges of the unit, in which
+     case it is done by unit_read the first time the unit is needed;
+     use the unit that unit_read returns to access them.  */
+
   /* Offset into line number information.  */
   off_t lineoff;
   /* Offset of compilation unit in .debug_str_offsets.  */
@@ -326,25 +352,26 @@ struct unit
   const char *filename;
   /* Compilation command working directory.  */
   const char *comp_dir;
-  /* Absolute file name, only set if needed.  */
+  /* Absolute file name, only set if needed.  In threaded mode this is
+     accessed atomically.  */
   const char *abs_filename;
   /* The abbreviations for this unit.  */
   struct abbrevs abbrevs;
 
-  /* The fields above this point are read in during initialization and
-     may be accessed freely.  The fields below this point are read in
-     as needed, and therefore require care, as different threads may
-     try to initialize them simultaneously.  */
+  /* The fields below this point are read in as needed, and therefore
+     require care, as different threads may try to initialize them
+     simultaneously.  */
 
-  /* PC to line number mapping.  This is NULL if the values have not
-     been read.  This is (struct line *) -1 if there was an error
-     reading the values.  */
-  struct line *lines;
-  /* Number of entries in lines.  */
-  size_t lines_count;
-  /* PC ranges to function.  */
-  struct function_addrs *function_addrs;
-  size_t function_addrs_count;
+  /* The unit with the fields read from the unit DIE.  This is NULL if
+     they have not been read, and (struct unit *) -1 if there was an
+     error reading them.  In threaded mode this may point to a copy of
+     this unit; otherwise it points to this unit.  */
+  struct unit *full;
+
+  /* Line number and function information.  This is NULL if it has
+     not been read.  This is (struct unit_lines *) -1 if there was an
+     error reading it.  */
+  struct unit_lines *lines;
 };
 
 /* An address range for a compilation unit.  This maps a PC value to a
@@ -1934,8 +1961,9 @@ add_ranges (struct backtrace_state *state,
 }
 
 /* Find the address range covered by a compilation unit, reading from
-   UNIT_BUF and adding values to U.  Returns 1 if all data could be
-   read, 0 if there is some error.  */
+   UNIT_BUF and adding values to U.  If ADDRS is NULL, just read the
+   unit DIE into U.  Returns 1 if all data could be read, 0 if there is
+   some error.  */
 
 static int
 find_address_ranges (struct backtrace_state *state, uintptr_t base_address,
@@ -2057,6 +2085,9 @@ find_address_ranges (struct backtrace_state *state, uintptr_t base_address,
 	    return 0;
 	}
 
+      if (addrs == NULL)
+	return 1;
+
       if (abbrev->tag == DW_TAG_compile_unit
 	  || abbrev->tag == DW_TAG_subprogram
 	  || abbrev->tag == DW_TAG_skeleton_unit)
@@ -2088,6 +2119,206 @@ find_address_ranges (struct backtrace_state *state, uintptr_t base_address,
   return 1;
 }
 
+/* The address ranges of a compilation unit, as listed in
+   .debug_aranges.  */
+
+struct aranges_set
+{
+  /* Offset of the unit from the start of .debug_info.  */
+  uint64_t info_offset;
+  /* The address and length pairs.  */
+  const unsigned char *tuples;
+  /* Number of bytes at TUPLES.  */
+  size_t tuples_len;
+  /* Size of an address, and of a length.  This is 0 if the set can
+     not be used.  */
+  int addrsize;
+};
+
+/* Compare aranges_set for qsort.  */
+
+static int
+aranges_set_compare (const void *v1, const void *v2)
+{
+  const struct aranges_set *a1 = (const struct aranges_set *) v1;
+  const struct aranges_set *a2 = (const struct aranges_set *) v2;
+
+  if (a1->info_offset < a2->info_offset)
+    return -1;
+  else if (a1->info_offset > a2->info_offset)
+    return 1;
+  else
+    return 0;
+}
+
+/* Compare a unit offset against an aranges_set for bsearch.  */
+
+static int
+aranges_set_search (const void *vkey, const void *ventry)
+{
+  const uint64_t *key = (const uint64_t *) vkey;
+  const struct aranges_set *entry = (const struct aranges_set *) ventry;
+
+  if (*key < entry->info_offset)
+    return -1;
+  else if (*key > entry->info_offset)
+    return 1;
+  else
+    return 0;
+}
+
+/* Read the .debug_aranges section, if there is one, into SETS, sorted
+   by unit offset.  Returns 1 on success, 0 on failure.  */
+
+static int
+read_aranges (struct backtrace_state *state,
+	      const struct dwarf_sections *dwarf_sections, int is_bigendian,
+	      backtrace_error_callback error_callback, void *data,
+	      struct backtrace_vector *sets, size_t *sets_count)
+{
+  struct dwarf_buf aranges;
+  struct aranges_set *p;
+  size_t count;
+  size_t i;
+
+  memset (sets, 0, sizeof *sets);
+  *sets_count = 0;
+
+  aranges.name = ".debug_aranges";
+  aranges.start = dwarf_sections->data[DEBUG_ARANGES];
+  aranges.buf = aranges.start;
+  aranges.left = dwarf_sections->size[DEBUG_ARANGES];
+  aranges.is_bigendian = is_bigendian;
+  aranges.error_callback = error_callback;
+  aranges.data = data;
+  aranges.reported_underflow = 0;
+
+  count = 0;
+  while (aranges.left > 0)
+    {
+      const unsigned char *set_start;
+      uint64_t len;
+      int is_dwarf64;
+      struct dwarf_buf set_buf;
+      int version;
+      uint64_t info_offset;
+      int addrsize;
+      int segsize;
+      size_t align;
+      size_t pad;
+
+      set_start = aranges.buf;
+      len = read_initial_length (&aranges, &is_dwarf64);
+      set_buf = aranges;
+      set_buf.left = len;
+
+      if (!advance (&aranges, len))
+	goto fail;
+
+      version = read_uint16 (&set_buf);
+      info_offset = read_offset (&set_buf, is_dwarf64);
+      addrsize = read_byte (&set_buf);
+      segsize = read_byte (&set_buf);
+      if (set_buf.reported_underflow)
+	goto fail;
+
+      /* Units whose set we don't understand are read the slow way.  */
+      if (version != 2
+	  || segsize != 0
+	  || (addrsize != 1 && addrsize != 2 && addrsize != 4
+	      && addrsize != 8))
+	addrsize = 0;
+      else
+	{
+	  /* The first pair is aligned to twice the address size, from
+	     the start of the set.  */
+	  align = 2 * (size_t) addrsize;
+	  pad = (align - (size_t) (set_buf.buf - set_start) % align) % align;
+	  if (!advance (&set_buf, pad))
+	    goto fail;
+	}
+
+      p = ((struct aranges_set *)
+	   backtrace_vector_grow (state, sizeof (struct aranges_set),
+				  error_callback, data, sets));
+      if (p == NULL)
+	goto fail;
+      p->info_offset = info_offset;
+      p->tuples = set_buf.buf;
+      p->tuples_len = set_buf.left;
+      p->addrsize = addrsize;
+      ++count;
+    }
+
+  backtrace_qsort (sets->base, count, sizeof (struct aranges_set),
+		   aranges_set_compare);
+
+  /* We can only use one set for a unit, so if there are several,
+     don't use any of them.  */
+  p = (struct aranges_set *) sets->base;
+  for (i = 1; i < count; ++i)
+    {
+      if (p[i].info_offset == p[i - 1].info_offset)
+	{
+	  p[i].addrsize = 0;
+	  p[i - 1].addrsize = 0;
+	}
+    }
+
+  *sets_count = count;
+  return 1;
+
+ fail:
+  backtrace_vector_free (state, sets, error_callback, data);
+  return 0;
+}
+
+/* Add the address ranges in SET for U to ADDRS.  Returns 1 on
+   success, 0 on failure.  */
+
+static int
+add_aranges (struct backtrace_state *state, uintptr_t base_address,
+	     int is_bigendian, const struct aranges_set *set, struct unit *u,
+	     backtrace_error_callback error_callback, void *data,
+	     struct unit_addrs_vector *addrs)
+{
+  struct dwarf_buf tuples;
+
+  tuples.name = ".debug_aranges";
+  tuples.start = set->tuples;
+  tuples.buf = set->tuples;
+  tuples.left = set->tuples_len;
+  tuples.is_bigendian = is_bigendian;
+  tuples.error_callback = error_callback;
+  tuples.data = data;
+  tuples.reported_underflow = 0;
+
+  while (tuples.left > 0)
+    {
+      uint64_t address;
+      uint64_t length;
+
+      address = read_address (&tuples, set->addrsize);
+      length = read_address (&tuples, set->addrsize);
+      if (tuples.reported_underflow)
+	return 0;
+
+      if (address == 0 && length == 0)
+	break;
+      if (length == 0)
+	continue;
+
+      /* Add in the base address of the module when recording PC
+	 values, so that we can look up the PC directly.  */
+      if (!add_unit_addr (state, (void *) u, address + base_address,
+			  address + length + base_address, error_callback,
+			  data, (void *) addrs))
+	return 0;
+    }
+
+  return 1;
+}
+
 /* Build a mapping from address ranges to the compilation units where
    the line number information for that range can be found.  Returns 1
    on success, 0 on failure.  */
@@ -2107,15 +2338,25 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
   struct unit **pu;
   size_t unit_offset = 0;
   struct unit_addrs *pa;
+  struct backtrace_vector sets;
+  size_t sets_count;
 
   memset (&addrs->vec, 0, sizeof addrs->vec);
   memset (&unit_vec->vec, 0, sizeof unit_vec->vec);
   addrs->count = 0;
   unit_vec->count = 0;
 
-  /* Read through the .debug_info section.  FIXME: Should we use the
-     .debug_aranges section?  gdb and addr2line don't use it, but I'm
-     not sure why.  */
+  /* When .debug_aranges lists the address ranges of a unit, use them,
+     and leave reading the abbreviations and the unit DIE until the
+     unit is first needed.  For a large program most units are never
+     needed.  Units not in .debug_aranges are read now, finding their
+     ranges in .debug_info as gdb and addr2line do.  */
+
+  if (!read_aranges (state, dwarf_sections, is_bigendian, error_callback,
+		     data, &sets, &sets_count))
+    return 0;
+
+  /* Read through the .debug_info section.  */
 
   info.name = ".debug_info";
   info.start = dwarf_sections->data[DEBUG_INFO];
@@ -2141,6 +2382,7 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
       int addrsize;
       struct unit *u;
       enum dwarf_tag unit_tag;
+      struct aranges_set *set;
 
       if (info.reported_underflow)
 	goto fail;
@@ -2194,11 +2436,6 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
 
       memset (&u->abbrevs, 0, sizeof u->abbrevs);
       abbrev_offset = read_offset (&unit_buf, is_dwarf64);
-      if (!read_abbrevs (state, abbrev_offset,
-			 dwarf_sections->data[DEBUG_ABBREV],
-			 dwarf_sections->size[DEBUG_ABBREV],
-			 is_bigendian, error_callback, data, &u->abbrevs))
-	goto fail;
 
       if (version < 5)
 	addrsize = read_byte (&unit_buf);
@@ -2225,6 +2462,7 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
       u->version = version;
       u->is_dwarf64 = is_dwarf64;
       u->addrsize = addrsize;
+      u->abbrev_offset = abbrev_offset;
       u->filename = NULL;
       u->comp_dir = NULL;
       u->abs_filename = NULL;
@@ -2235,14 +2473,34 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
 
       /* The actual line number mappings will be read as needed.  */
       u->lines = NULL;
-      u->lines_count = 0;
-      u->function_addrs = NULL;
-      u->function_addrs_count = 0;
 
-      if (!find_address_ranges (state, base_address, &unit_buf, dwarf_sections,
-				is_bigendian, altlink, error_callback, data,
-				u, addrs, &unit_tag))
-	goto fail;
+      set = ((struct aranges_set *)
+	     bsearch (&u->low_offset, sets.base, sets_count,
+		      sizeof (struct aranges_set), aranges_set_search));
+      if (set != NULL && set->addrsize == addrsize)
+	{
+	  /* The unit DIE will be read as needed.  */
+	  u->full = NULL;
+
+	  if (!add_aranges (state, base_address, is_bigendian, set, u,
+			    error_callback, data, addrs))
+	    goto fail;
+	}
+      else
+	{
+	  u->full = u;
+
+	  if (!read_abbrevs (state, abbrev_offset,
+			     dwarf_sections->data[DEBUG_ABBREV],
+			     dwarf_sections->size[DEBUG_ABBREV],
+			     is_bigendian, error_callback, data, &u->abbrevs))
+	    goto fail;
+
+	  if (!find_address_ranges (state, base_address, &unit_buf,
+				    dwarf_sections, is_bigendian, altlink,
+				    error_callback, data, u, addrs, &unit_tag))
+	    goto fail;
+	}
 
       if (unit_buf.reported_underflow)
 	goto fail;
@@ -2250,6 +2508,8 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
   if (info.reported_underflow)
     goto fail;
 
+  backtrace_vector_free (state, &sets, error_callback, data);
+
   /* Add a trailing addrs entry, but don't include it in addrs->count.  */
   pa = ((struct unit_addrs *)
 	backtrace_vector_grow (state, sizeof (struct unit_addrs),
@@ -2266,6 +2526,7 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
   return 1;
 
  fail:
+  backtrace_vector_free (state, &sets, error_callback, data);
   if (units_count > 0)
     {
       pu = (struct unit **) units.base;
@@ -2284,6 +2545,110 @@ build_address_map (struct backtrace_state *state, uintptr_t base_address,
   return 0;
 }
 
+/* Read the abbreviations and the unit DIE of U.  Returns 1 on
+   success, 0 on failure.  */
+
+static int
+read_unit_die (struct backtrace_state *state, struct dwarf_data *ddata,
+	       struct unit *u, backtrace_error_callback error_callback,
+	       void *data)
+{
+  struct dwarf_buf unit_buf;
+
+  if (!read_abbrevs (state, u->abbrev_offset,
+		     ddata->dwarf_sections.data[DEBUG_ABBREV],
+		     ddata->dwarf_sections.size[DEBUG_ABBREV],
+		     ddata->is_bigendian, error_callback, data, &u->abbrevs))
+    return 0;
+
+  unit_buf.name = ".debug_info";
+  unit_buf.start = ddata->dwarf_sections.data[DEBUG_INFO];
+  unit_buf.buf = u->unit_data;
+  unit_buf.left = u->unit_data_len;
+  unit_buf.is_bigendian = ddata->is_bigendian;
+  unit_buf.error_callback = error_callback;
+  unit_buf.data = data;
+  unit_buf.reported_underflow = 0;
+
+  if (!find_address_ranges (state, ddata->base_address, &unit_buf,
+			    &ddata->dwarf_sections, ddata->is_bigendian,
+			    ddata->altlink, error_callback, data, u, NULL,
+			    NULL)
+      || unit_buf.reported_underflow)
+    {
+      free_abbrevs (state, &u->abbrevs, error_callback, data);
+      return 0;
+    }
+
+  return 1;
+}
+
+/* Return the unit to use for the fields of U that are read from the
+   unit DIE, reading it if this is the first time that U is needed.
+   Returns NULL if the unit DIE could not be read.  */
+
+static struct unit *
+unit_read (struct backtrace_state *state, struct dwarf_data *ddata,
+	   struct unit *u, backtrace_error_callback error_callback,
+	   void *data)
+{
+  struct unit *full;
+
+  if (!state->threaded)
+    full = u->full;
+  else
+    full = (struct unit *) backtrace_atomic_load_pointer (&u->full);
+
+  if (full == NULL)
+    {
+      if (!state->threaded)
+	{
+	  if (read_unit_die (state, ddata, u, error_callback, data))
+	    full = u;
+	  else
+	    full = (struct unit *) (uintptr_t) -1;
+	  u->full = full;
+	}
+      else
+	{
+	  /* Read into a copy of U, so that other threads never see a
+	     partly read unit, and atomically store the copy into U.
+	     If another thread got there first, use its copy.  */
+	  full = ((struct unit *)
+		  backtrace_alloc (state, sizeof *full, error_callback, data));
+	  if (full != NULL)
+	    {
+	      memcpy (full, u, sizeof *full);
+	      if (read_unit_die (state, ddata, full, error_callback, data))
+		full->full = full;
+	      else
+		{
+		  backtrace_free (state, full, sizeof *full, error_callback,
+				  data);
+		  full = NULL;
+		}
+	    }
+	  if (full == NULL)
+	    full = (struct unit *) (uintptr_t) -1;
+
+	  if (!__sync_bool_compare_and_swap (&u->full, NULL, full))
+	    {
+	      if (full != (struct unit *) (uintptr_t) -1)
+		{
+		  free_abbrevs (state, &full->abbrevs, error_callback, data);
+		  backtrace_free (state, full, sizeof *full, error_callback,
+				  data);
+		}
+	      full = (struct unit *) backtrace_atomic_load_pointer (&u->full);
+	    }
+	}
+    }
+
+  if (full == (struct unit *) (uintptr_t) -1)
+    return NULL;
+  return full;
+}
+
 /* Add a new mapping to the vector of line mappings that we are
    building.  Returns 1 on success, 0 on failure.  */
 
@@ -3009,14 +3374,16 @@ read_line_info (struct backtrace_state *state, struct dwarf_data *ddata,
   return 0;
 }
 
-static const char *read_referenced_name (struct dwarf_data *, struct unit *,
+static const char *read_referenced_name (struct backtrace_state *,
+					 struct dwarf_data *, struct unit *,
 					 uint64_t, backtrace_error_callback,
 					 void *);
 
 /* Read the name of a function from a DIE referenced by ATTR with VAL.  */
 
 static const char *
-read_referenced_name_from_attr (struct dwarf_data *ddata, struct unit *u,
+read_referenced_name_from_attr (struct backtrace_state *state,
+				struct dwarf_data *ddata, struct unit *u,
 				struct attr *attr, struct attr_val *val,
 				backtrace_error_callback error_callback,
 				void *data)
@@ -3042,12 +3409,17 @@ read_referenced_name_from_attr (struct dwarf_data *ddata, struct unit *u,
 	return NULL;
 
       uint64_t offset = val->u.uint - unit->low_offset;
-      return read_referenced_name (ddata, unit, offset, error_callback, data);
+      unit = unit_read (state, ddata, unit, error_callback, data);
+      if (unit == NULL)
+	return NULL;
+      return read_referenced_name (state, ddata, unit, offset,
+				   error_callback, data);
     }
 
   if (val->encoding == ATTR_VAL_UINT
       || val->encoding == ATTR_VAL_REF_UNIT)
-    return read_referenced_name (ddata, u, val->u.uint, error_callback, data);
+    return read_referenced_name (state, ddata, u, val->u.uint,
+				 error_callback, data);
 
   if (val->encoding == ATTR_VAL_REF_ALT_INFO)
     {
@@ -3058,7 +3430,11 @@ read_referenced_name_from_attr (struct dwarf_data *ddata, struct unit *u,
 	return NULL;
 
       uint64_t offset = val->u.uint - alt_unit->low_offset;
-      return read_referenced_name (ddata->altlink, alt_unit, offset,
+      alt_unit = unit_read (state, ddata->altlink, alt_unit, error_callback,
+			    data);
+      if (alt_unit == NULL)
+	return NULL;
+      return read_referenced_name (state, ddata->altlink, alt_unit, offset,
 				   error_callback, data);
     }
 
@@ -3070,9 +3446,9 @@ read_referenced_name_from_attr (struct dwarf_data *ddata, struct unit *u,
    the same compilation unit.  */
 
 static const char *
-read_referenced_name (struct dwarf_data *ddata, struct unit *u,
-		      uint64_t offset, backtrace_error_callback error_callback,
-		      void *data)
+read_referenced_name (struct backtrace_state *state, struct dwarf_data *ddata,
+		      struct unit *u, uint64_t offset,
+		      backtrace_error_callback error_callback, void *data)
 {
   struct dwarf_buf unit_buf;
   uint64_t code;
@@ -3163,8 +3539,9 @@ read_referenced_name (struct dwarf_data *ddata, struct unit *u,
 	  {
 	    const char *name;
 
-	    name = read_referenced_name_from_attr (ddata, u, &abbrev->attrs[i],
-						   &val, error_callback, data);
+	    name = read_referenced_name_from_attr (state, ddata, u,
+						   &abbrev->attrs[i], &val,
+						   error_callback, data);
 	    if (name != NULL)
 	      ret = name;
 	  }
@@ -3332,7 +3709,7 @@ read_function_entry (struct backtrace_state *state, struct dwarf_data *ddata,
 		    const char *name;
 
 		    name
-		      = read_referenced_name_from_attr (ddata, u,
+		      = read_referenced_name_from_attr (state, ddata, u,
 							&abbrev->attrs[i], &val,
 							error_callback, data);
 		    if (name != NULL)
@@ -3633,6 +4010,20 @@ report_inlined_functions (uintptr_t pc, struct function *function,
   return 0;
 }
 
+/* Return the line number and function information of U, which is
+   NULL if it has not been read.  U may be NULL, for a unit whose DIE
+   could not be read.  */
+
+static struct unit_lines *
+unit_get_lines (struct backtrace_state *state, struct unit *u)
+{
+  if (u == NULL)
+    return (struct unit_lines *) (uintptr_t) -1;
+  if (!state->threaded)
+    return u->lines;
+  return (struct unit_lines *) backtrace_atomic_load_pointer (&u->lines);
+}
+
 /* Look for a PC in the DWARF mapping for one module.  On success,
    call CALLBACK and return whatever it returns.  On error, call
    ERROR_CALLBACK and return 0.  Sets *FOUND to 1 if the PC is found,
@@ -3648,7 +4039,7 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
   int found_entry;
   struct unit *u;
   int new_data;
-  struct line *lines;
+  struct unit_lines *ulines;
   struct line *ln;
   struct function_addrs *p;
   struct function_addrs *fmatch;
@@ -3700,14 +4091,14 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
       return 0;
     }
 
-  /* We need the lines, lines_count, function_addrs,
-     function_addrs_count fields of u.  If they are not set, we need
-     to set them.  When running in threaded mode, we need to allow for
-     the possibility that some other thread is setting them
-     simultaneously.  */
+  /* We need the line number and function information of u.  If it
+     is not set, we need to set it.  When running in threaded mode, we
+     need to allow for the possibility that some other thread is
+     setting it simultaneously.  A unit whose DIE can't be read is
+     treated as having no useful line number information.  */
 
-  u = entry->u;
-  lines = u->lines;
+  u = unit_read (state, ddata, entry->u, error_callback, data);
+  ulines = unit_get_lines (state, u);
 
   /* Skip units with no useful line number information by walking
      backward.  Useless line number information is marked by setting
@@ -3716,35 +4107,31 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
 	 && pc >= (entry - 1)->low
 	 && pc < (entry - 1)->high)
     {
-      if (state->threaded)
-	lines = (struct line *) backtrace_atomic_load_pointer (&u->lines);
-
-      if (lines != (struct line *) (uintptr_t) -1)
+      if (ulines != (struct unit_lines *) (uintptr_t) -1)
 	break;
 
       --entry;
 
-      u = entry->u;
-      lines = u->lines;
+      u = unit_read (state, ddata, entry->u, error_callback, data);
+      ulines = unit_get_lines (state, u);
     }
 
-  if (state->threaded)
-    lines = backtrace_atomic_load_pointer (&u->lines);
-
   new_data = 0;
-  if (lines == NULL)
+  if (ulines == NULL)
     {
+      struct line *lines;
+      size_t count;
       struct function_addrs *function_addrs;
       size_t function_addrs_count;
       struct line_header lhdr;
-      size_t count;
 
       /* We have never read the line information for this unit.  Read
 	 it now.  */
 
+      ulines = (struct unit_lines *) (uintptr_t) -1;
       function_addrs = NULL;
       function_addrs_count = 0;
-      if (read_line_info (state, ddata, error_callback, data, entry->u, &lhdr,
+      if (read_line_info (state, ddata, error_callback, data, u, &lhdr,
 			  &lines, &count))
 	{
 	  struct function_vector *pfvec;
@@ -3756,39 +4143,56 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
 	  else
 	    pfvec = &ddata->fvec;
 	  read_function_info (state, ddata, &lhdr, error_callback, data,
-			      entry->u, pfvec, &function_addrs,
+			      u, pfvec, &function_addrs,
 			      &function_addrs_count);
 	  free_line_header (state, &lhdr, error_callback, data);
+
+	  ulines = ((struct unit_lines *)
+		    backtrace_alloc (state, sizeof *ulines, error_callback,
+				     data));
+	  if (ulines == NULL)
+	    ulines = (struct unit_lines *) (uintptr_t) -1;
+	  else
+	    {
+	      ulines->lines = lines;
+	      ulines->lines_count = count;
+	      ulines->function_addrs = function_addrs;
+	      ulines->function_addrs_count = function_addrs_count;
+	    }
 	  new_data = 1;
 	}
 
-      /* Atomically store the information we just read into the unit.
-	 If another thread is simultaneously writing, it presumably
-	 read the same information, and we don't care which one we
-	 wind up with; we just leak the other one.  We do have to
-	 write the lines field last, so that the acquire-loads above
-	 ensure that the other fields are set.  */
+      /* Store the information we just read into the unit.  In threaded
+	 mode another thread may be doing the same thing; whichever
+	 stores first wins, and the others free what they read and use
+	 its information.  This only frees the line and address tables;
+	 the function entries they point to are leaked.  */
 
       if (!state->threaded)
+	u->lines = ulines;
+      else if (!__sync_bool_compare_and_swap (&u->lines, NULL, ulines))
 	{
-	  u->lines_count = count;
-	  u->function_addrs = function_addrs;
-	  u->function_addrs_count = function_addrs_count;
-	  u->lines = lines;
-	}
-      else
-	{
-	  backtrace_atomic_store_size_t (&u->lines_count, count);
-	  backtrace_atomic_store_pointer (&u->function_addrs, function_addrs);
-	  backtrace_atomic_store_size_t (&u->function_addrs_count,
-					 function_addrs_count);
-	  backtrace_atomic_store_pointer (&u->lines, lines);
+	  if (ulines != (struct unit_lines *) (uintptr_t) -1)
+	    {
+	      backtrace_free (state, ulines->lines,
+			      (ulines->lines_count + 1) * sizeof (struct line),
+			      error_callback, data);
+	      if (ulines->function_addrs_count > 0)
+		backtrace_free (state, ulines->function_addrs,
+				((ulines->function_addrs_count + 1)
+				 * sizeof (struct function_addrs)),
+				error_callback, data);
+	      backtrace_free (state, ulines, sizeof *ulines, error_callback,
+			      data);
+	    }
+	  ulines = unit_get_lines (state, u);
+	  new_data = 0;
 	}
     }
 
   /* Now all fields of U have been initialized.  */
 
-  if (lines == (struct line *) (uintptr_t) -1)
+  if (ulines == (struct unit_lines *) (uintptr_t) -1)
     {
       /* If reading the line number information failed in some way,
 	 try again to see if there is a better compilation unit for
@@ -3801,7 +4205,7 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
 
   /* Search for PC within this unit.  */
 
-  ln = (struct line *) bsearch (&pc, lines, entry->u->lines_count,
+  ln = (struct line *) bsearch (&pc, ulines->lines, ulines->lines_count,
 				sizeof (struct line), line_search);
   if (ln == NULL)
     {
@@ -3810,14 +4214,21 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
 	 This implies that the start of the compilation unit has no
 	 line number information.  */
 
-      if (entry->u->abs_filename == NULL)
+      const char *abs_filename;
+
+      if (!state->threaded)
+	abs_filename = u->abs_filename;
+      else
+	abs_filename = ((const char *)
+			backtrace_atomic_load_pointer (&u->abs_filename));
+      if (abs_filename == NULL)
 	{
 	  const char *filename;
 
-	  filename = entry->u->filename;
+	  filename = u->filename;
 	  if (filename != NULL
 	      && !IS_ABSOLUTE_PATH (filename)
-	      && entry->u->comp_dir != NULL)
+	      && u->comp_dir != NULL)
 	    {
 	      size_t filename_len;
 	      const char *dir;
@@ -3825,7 +4236,7 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
 	      char *s;
 
 	      filename_len = strlen (filename);
-	      dir = entry->u->comp_dir;
+	      dir = u->comp_dir;
 	      dir_len = strlen (dir);
 	      s = (char *) backtrace_alloc (state, dir_len + filename_len + 2,
 					    error_callback, data);
@@ -3840,20 +4251,27 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
 	      memcpy (s + dir_len + 1, filename, filename_len + 1);
 	      filename = s;
 	    }
-	  entry->u->abs_filename = filename;
+
+	  /* If another thread is doing this too, we just leak one of
+	     the strings.  */
+	  abs_filename = filename;
+	  if (!state->threaded)
+	    u->abs_filename = abs_filename;
+	  else
+	    backtrace_atomic_store_pointer (&u->abs_filename, abs_filename);
 	}
 
-      return callback (data, pc, entry->u->abs_filename, 0, NULL);
+      return callback (data, pc, abs_filename, 0, NULL);
     }
 
   /* Search for function name within this unit.  */
 
-  if (entry->u->function_addrs_count == 0)
+  if (ulines->function_addrs_count == 0)
     return callback (data, pc, ln->filename, ln->lineno, NULL);
 
   p = ((struct function_addrs *)
-       bsearch (&pc, entry->u->function_addrs,
-		entry->u->function_addrs_count,
+       bsearch (&pc, ulines->function_addrs,
+		ulines->function_addrs_count,
 		sizeof (struct function_addrs),
 		function_addrs_search));
   if (p == NULL)
@@ -3874,7 +4292,7 @@ dwarf_lookup_pc (struct backtrace_state *state, struct dwarf_data *ddata,
 	  fmatch = p;
 	  break;
 	}
-      if (p == entry->u->function_addrs)
+      if (p == ulines->function_addrs)
 	break;
       if ((p - 1)->low < p->low)
 	break;
@@ -111,7 +111,8 @@ main (int argc ATTRIBUTE_UNUSED, char **argv ATTRIBUTE_UNUSED)
   // are racing calls to the allocator.
   struct backtrace_state *state_internal =
       (struct backtrace_state *) state;
-  state_internal->lock_alloc = 1;
+  for (int i = 0; i < BACKTRACE_FREELISTS; ++i)
+    state_internal->lock_alloc[i] = 1;
 
   // Kick off the test
   test1();
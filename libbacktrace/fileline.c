@@ -292,13 +292,25 @@ backtrace_pcinfo (struct backtrace_state *state, uintptr_t pc,
 		  backtrace_full_callback callback,
 		  backtrace_error_callback error_callback, void *data)
 {
+  fileline fileline_fn;
+
   if (!fileline_initialize (state, error_callback, data))
     return 0;
 
-  if (state->fileline_initialization_failed)
-    return 0;
+  if (!state->threaded)
+    {
+      if (state->fileline_initialization_failed)
+	return 0;
+      fileline_fn = state->fileline_fn;
+    }
+  else
+    {
+      if (backtrace_atomic_load_int (&state->fileline_initialization_failed))
+	return 0;
+      fileline_fn = backtrace_atomic_load_pointer (&state->fileline_fn);
+    }
 
-  return state->fileline_fn (state, pc, callback, error_callback, data);
+  return fileline_fn (state, pc, callback, error_callback, data);
 }
 
 /* Given a PC, find the symbol for it, and its value.  */
@@ -308,13 +320,25 @@ backtrace_syminfo (struct backtrace_state *state, uintptr_t pc,
 		   backtrace_syminfo_callback callback,
 		   backtrace_error_callback error_callback, void *data)
 {
+  syminfo syminfo_fn;
+
   if (!fileline_initialize (state, error_callback, data))
     return 0;
 
-  if (state->fileline_initialization_failed)
-    return 0;
+  if (!state->threaded)
+    {
+      if (state->fileline_initialization_failed)
+	return 0;
+      syminfo_fn = state->syminfo_fn;
+    }
+  else
+    {
+      if (backtrace_atomic_load_int (&state->fileline_initialization_failed))
+	return 0;
+      syminfo_fn = backtrace_atomic_load_pointer (&state->syminfo_fn);
+    }
 
-  state->syminfo_fn (state, pc, callback, error_callback, data);
+  syminfo_fn (state, pc, callback, error_callback, data);
   return 1;
 }
 
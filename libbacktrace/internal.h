@@ -130,6 +130,11 @@ typedef void (*syminfo) (struct backtrace_state *state, uintptr_t pc,
 			 backtrace_syminfo_callback callback,
 			 backtrace_error_callback error_callback, void *data);
 
+/* The number of free lists used when allocating with mmap.  This must
+   be a power of 2.  */
+
+#define BACKTRACE_FREELISTS 8
+
 /* What the backtrace state pointer points to.  */
 
 struct backtrace_state
@@ -152,10 +157,11 @@ struct backtrace_state
   void *syminfo_data;
   /* Whether initializing the file/line information failed.  */
   int fileline_initialization_failed;
-  /* The lock for the freelist.  */
-  int lock_alloc;
-  /* The freelist when using mmap.  */
-  struct backtrace_freelist_struct *freelist;
+  /* The locks for the freelists.  */
+  int lock_alloc[BACKTRACE_FREELISTS];
+  /* The freelists when using mmap.  Only the first one is used when
+     not threaded.  */
+  struct backtrace_freelist_struct *freelist[BACKTRACE_FREELISTS];
 };
 
 /* Open a file for reading.  Returns -1 on error.  If DOES_NOT_EXIST
@@ -307,6 +313,7 @@ enum dwarf_section
   DEBUG_STR_OFFSETS,
   DEBUG_LINE_STR,
   DEBUG_RNGLISTS,
+  DEBUG_ARANGES,
 
   DEBUG_MAX
 };
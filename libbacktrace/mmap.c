@@ -68,10 +68,30 @@ struct backtrace_freelist_struct
   size_t size;
 };
 
-/* Free memory allocated by backtrace_alloc.  */
+/* Return the index of the free list that the calling thread tries
+   first.  Threads run on different stacks, so hashing the address of
+   a local variable mostly gives threads that allocate at the same time
+   different lists, without using thread-local storage, which is not
+   async-signal safe.  */
+
+static size_t
+backtrace_freelist_start (struct backtrace_state *state)
+{
+  char local;
+  uint32_t h;
+
+  if (!state->threaded)
+    return 0;
+  h = (uint32_t) ((uintptr_t) &local >> 12);
+  return ((h * 2654435761U) >> 24) & (BACKTRACE_FREELISTS - 1);
+}
+
+/* Free memory allocated by backtrace_alloc onto the free list *LIST,
+   whose lock the caller holds.  */
 
 static void
-backtrace_free_locked (struct backtrace_state *state, void *addr, size_t size)
+backtrace_free_locked (struct backtrace_freelist_struct **list, void *addr,
+		       size_t size)
 {
   /* Just leak small blocks.  We don't have to be perfect.  Don't put
      more than 16 entries on the free list, to avoid wasting time
@@ -87,7 +107,7 @@ backtrace_free_locked (struct backtrace_state *state, void *addr, size_t size)
 
       c = 0;
       ppsmall = NULL;
-      for (pp = &state->freelist; *pp != NULL; pp = &(*pp)->next)
+      for (pp = list; *pp != NULL; pp = &(*pp)->next)
 	{
 	  if (ppsmall == NULL || (*pp)->size < (*ppsmall)->size)
 	    ppsmall = pp;
@@ -101,9 +121,9 @@ backtrace_free_locked (struct backtrace_state *state, void *addr, size_t size)
 	}
 
       p = (struct backtrace_freelist_struct *) addr;
-      p->next = state->freelist;
+      p->next = *list;
       p->size = size;
-      state->freelist = p;
+      *list = p;
     }
 }
 
@@ -116,7 +136,8 @@ backtrace_alloc (struct backtrace_state *state,
 		 void *data)
 {
   void *ret;
-  int locked;
+  size_t start;
+  size_t i;
   struct backtrace_freelist_struct **pp;
   size_t pagesize;
   size_t asksize;
@@ -124,19 +145,30 @@ backtrace_alloc (struct backtrace_state *state,
 
   ret = NULL;
 
-  /* If we can acquire the lock, then see if there is space on the
-     free list.  If we can't acquire the lock, drop straight into
-     using mmap.  __sync_lock_test_and_set returns the old state of
-     the lock, so we have acquired it if it returns 0.  */
-
-  if (!state->threaded)
-    locked = 1;
-  else
-    locked = __sync_lock_test_and_set (&state->lock_alloc, 1) == 0;
+  /* Look for space on each free list whose lock we can acquire.  If
+     we can't find any, drop into using mmap.  We never wait for a
+     lock.  __sync_lock_test_and_set returns the old state of the
+     lock, so we have acquired it if it returns 0.  */
 
-  if (locked)
+  start = backtrace_freelist_start (state);
+  for (i = 0; i < BACKTRACE_FREELISTS && ret == NULL; ++i)
     {
-      for (pp = &state->freelist; *pp != NULL; pp = &(*pp)->next)
+      size_t idx;
+      struct backtrace_freelist_struct **list;
+
+      idx = (start + i) & (BACKTRACE_FREELISTS - 1);
+      list = &state->freelist[idx];
+
+      if (!state->threaded)
+	{
+	  /* Only the first list is used.  */
+	  if (i > 0)
+	    break;
+	}
+      else if (__sync_lock_test_and_set (&state->lock_alloc[idx], 1) != 0)
+	continue;
+
+      for (pp = list; *pp != NULL; pp = &(*pp)->next)
 	{
 	  if ((*pp)->size >= size)
 	    {
@@ -149,7 +181,7 @@ backtrace_alloc (struct backtrace_state *state,
 		 is more than 8 bytes.  */
 	      size = (size + 7) & ~ (size_t) 7;
 	      if (size < p->size)
-		backtrace_free_locked (state, (char *) p + size,
+		backtrace_free_locked (list, (char *) p + size,
 				       p->size - size);
 
 	      ret = (void *) p;
@@ -159,7 +191,7 @@ backtrace_alloc (struct backtrace_state *state,
 	}
 
       if (state->threaded)
-	__sync_lock_release (&state->lock_alloc);
+	__sync_lock_release (&state->lock_alloc[idx]);
     }
 
   if (ret == NULL)
@@ -196,7 +228,8 @@ backtrace_free (struct backtrace_state *state, void *addr, size_t size,
 		backtrace_error_callback error_callback ATTRIBUTE_UNUSED,
 		void *data ATTRIBUTE_UNUSED)
 {
-  int locked;
+  size_t start;
+  size_t i;
 
   /* If we are freeing a large aligned block, just release it back to
      the system.  This case arises when growing a vector for a large
@@ -218,22 +251,29 @@ backtrace_free (struct backtrace_state *state, void *addr, size_t size,
 	}
     }
 
-  /* If we can acquire the lock, add the new space to the free list.
-     If we can't acquire the lock, just leak the memory.
-     __sync_lock_test_and_set returns the old state of the lock, so we
-     have acquired it if it returns 0.  */
+  /* Add the new space to the first free list whose lock we can
+     acquire.  If we can't acquire any of the locks, just leak the
+     memory.  __sync_lock_test_and_set returns the old state of the
+     lock, so we have acquired it if it returns 0.  */
 
   if (!state->threaded)
-    locked = 1;
-  else
-    locked = __sync_lock_test_and_set (&state->lock_alloc, 1) == 0;
+    {
+      backtrace_free_locked (&state->freelist[0], addr, size);
+      return;
+    }
 
-  if (locked)
+  start = backtrace_freelist_start (state);
+  for (i = 0; i < BACKTRACE_FREELISTS; ++i)
     {
-      backtrace_free_locked (state, addr, size);
+      size_t idx;
 
-      if (state->threaded)
-	__sync_lock_release (&state->lock_alloc);
+      idx = (start + i) & (BACKTRACE_FREELISTS - 1);
+      if (__sync_lock_test_and_set (&state->lock_alloc[idx], 1) == 0)
+	{
+	  backtrace_free_locked (&state->freelist[idx], addr, size);
+	  __sync_lock_release (&state->lock_alloc[idx]);
+	  return;
+	}
     }
 }
 
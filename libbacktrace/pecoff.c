@@ -145,7 +145,8 @@ static const char * const debug_section_names[DEBUG_MAX] =
   ".debug_addr",
   ".debug_str_offsets",
   ".debug_line_str",
-  ".debug_rnglists"
+  ".debug_rnglists",
+  ".debug_aranges"
 };
 
 /* Information we gather for the sections we care about.  */
@@ -1265,6 +1265,9 @@ xcoff_add (struct backtrace_state *state, int descriptor, off_t offset,
 	  case SSUBTYP_DWSTR:
 	    idx = DEBUG_STR;
 	    break;
+	  case SSUBTYP_DWARNGE:
+	    idx = DEBUG_ARANGES;
+	    break;
 	  default:
 	    continue;
 	}
@@ -1305,6 +1308,8 @@ xcoff_add (struct backtrace_state *state, int descriptor, off_t offset,
       dwarf_sections.size[DEBUG_RANGES] = dwsect[DEBUG_RANGES].size;
       dwarf_sections.data[DEBUG_STR] = dwsect[DEBUG_STR].data;
       dwarf_sections.size[DEBUG_STR] = dwsect[DEBUG_STR].size;
+      dwarf_sections.data[DEBUG_ARANGES] = dwsect[DEBUG_ARANGES].data;
+      dwarf_sections.size[DEBUG_ARANGES] = dwsect[DEBUG_ARANGES].size;
 
       if (!backtrace_dwarf_add (state, base_address, &dwarf_sections,
 				1, /* big endian */
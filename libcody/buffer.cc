@@ -183,12 +183,14 @@ int MessageBuffer::Write (int fd) noexcept
 
 int MessageBuffer::Read (int fd) noexcept
 {
-  constexpr size_t blockSize = 200;
+  constexpr size_t blockSize = 4096;
 
+  // Read into all the spare capacity, and grow it geometrically, so
+  // that the responses to a long corked batch take a handful of reads.
   size_t lwm = buffer.size ();
   size_t hwm = buffer.capacity ();
   if (hwm - lwm < blockSize / 2)
-    hwm += blockSize;
+    hwm = std::max (lwm + blockSize, hwm * 2);
   buffer.resize (hwm);
 
   auto iter = buffer.begin () + lwm;
@@ -226,17 +228,36 @@ int MessageBuffer::Read (int fd) noexcept
   return more ? EAGAIN : 0;
 }
 
-int MessageBuffer::Lex (std::vector<std::string> &result)
+// Whether C may be part of an unquoted word without ending it.
+
+static bool IsPlainChar (char c)
+{
+  return c > S2C(u8" ") && c < 0x7f && c != S2C(u8"'") && c != CONTINUE;
+}
+
+// Whether C may be copied as is into a quoted word.
+
+static bool IsPlainQuotedChar (char c)
 {
-  result.clear ();
+  return c >= S2C(u8" ") && c < 0x7f && c != S2C(u8"'") && c != S2C(u8"\\");
+}
 
+int MessageBuffer::Lex (std::vector<std::string> &result)
+{
   if (IsAtEnd ())
-    return ENOENT;
+    {
+      result.clear ();
+      return ENOENT;
+    }
 
   Assert (buffer.back () == S2C(u8"\n"));
 
   auto iter = buffer.begin () + lastBol;
 
+  // The strings already in RESULT are reused for the words, so that
+  // lexing each line of a message into the same vector does not
+  // allocate for every word.
+  size_t count = 0;
   for (std::string *word = nullptr;;)
     {
       char c = *iter;
@@ -265,8 +286,10 @@ int MessageBuffer::Lex (std::vector<std::string> &result)
 
       if (!word)
 	{
-	  result.emplace_back ();
-	  word = &result.back ();
+	  if (count == result.size ())
+	    result.emplace_back ();
+	  word = &result[count++];
+	  word->clear ();
 	}
 
       if (c == S2C(u8"'"))
@@ -274,6 +297,14 @@ int MessageBuffer::Lex (std::vector<std::string> &result)
 	  // Quoted word
 	  for (;;)
 	    {
+	      {
+		// Copy up to the next quote, escape or invalid char at once
+		auto run = iter;
+		while (IsPlainQuotedChar (*iter))
+		  ++iter;
+		word->append (run, iter);
+	      }
+
 	      c = *iter;
 
 	      if (c == S2C(u8"\n"))
@@ -362,10 +393,16 @@ int MessageBuffer::Lex (std::vector<std::string> &result)
 	    }
 	}
       else
-	// Unquoted character
-	word->push_back (c);
+	{
+	  // Unquoted characters, up to the end of the word or a quote
+	  auto run = iter - 1;
+	  while (IsPlainChar (*iter))
+	    ++iter;
+	  word->append (run, iter);
+	}
     }
   lastBol = iter - buffer.begin ();
+  result.resize (count);
   if (result.empty ())
     return ENOENT;
 
@@ -141,7 +141,9 @@ private:
 
 public:
   /// Lex the next input line into a vector of words.
-  /// @param words filled with a vector of lexed strings
+  /// @param words filled with a vector of lexed strings.  The strings
+  /// it already holds are reused, so passing the same vector for each
+  /// line avoids allocating for every word.
   /// @result 0 if no errors, an errno value on lexxing error such as
   /// there being no next line (ENOENT), or malformed quoting (EINVAL)
   int Lex (std::vector<std::string> &words);
@@ -167,6 +167,46 @@ struct file_hash_entry_pool
   struct cpp_file_hash_entry pool[FILE_HASH_POOL_SIZE];
 };
 
+/* The persistent include lookup cache, enabled by
+   CPP_OPTION (pfile, include_cache).  Failed probes of absolute paths
+   are written at the end of a compilation to a file of the cache
+   directory named after the search path, and the next compilation
+   with the same search path loads them into nonexistent_file_hash,
+   which find_file_in_dir consults before probing.  Each path is
+   recorded under its deepest existing ancestor directory and is only
+   trusted while that directory keeps the same modification time:
+   creating the file, or the first missing directory on its way,
+   changes it.  */
+
+#define INCLUDE_CACHE_MAGIC "GCC include cache 1"
+
+/* A directory validating cached paths.  Each is stat'ed at most once
+   per compilation.  */
+struct include_cache_dir
+{
+  const char *name;
+  time_t mtime;
+  bool exists;
+};
+
+struct include_cache
+{
+  /* The cache file of this search path.  */
+  char *file;
+
+  /* The include_cache_dirs looked up so far, allocated with their
+     names on OB.  */
+  struct htab *dirs;
+  struct obstack ob;
+
+  /* The nonexistent_file_hash entries loaded from FILE.  */
+  struct htab *loaded;
+
+  /* True if FILE needs rewriting: it had stale entries, or this
+     compilation failed probes it did not know of.  */
+  bool dirty;
+};
+
 static bool open_file (_cpp_file *file);
 static bool pch_open_file (cpp_reader *pfile, _cpp_file *file,
 			   bool *invalid_pch);
@@ -199,6 +239,8 @@ static bool validate_pch (cpp_reader *, _cpp_file *file, const char *pchname);
 static int pchf_save_compare (const void *e1, const void *e2);
 static int pchf_compare (const void *d_p, const void *e_p);
 static bool check_file_against_entries (cpp_reader *, _cpp_file *, bool);
+static void load_include_cache (cpp_reader *);
+static void destroy_include_cache (cpp_reader *);
 
 /* Given a filename in FILE->PATH, with the empty string interpreted
    as <stdin>, open it.
@@ -441,6 +483,8 @@ find_file_in_dir (cpp_reader *pfile, _cpp_file *file, bool *invalid_pch,
       pp = htab_find_slot_with_hash (pfile->nonexistent_file_hash,
 				     copy, hv, INSERT);
       *pp = copy;
+      if (pfile->include_cache && IS_ABSOLUTE_PATH (copy))
+	pfile->include_cache->dirty = true;
 
       file->path = file->name;
     }
@@ -863,6 +907,14 @@ has_unique_contents (cpp_reader *pfile, _cpp_file *file, bool import,
 	{
 	  _cpp_file *ref_file;
 
+	  /* The same file reached through another path, such as a
+	     symbolic link, needs no comparison.  Hosts without inode
+	     numbers report zero for every file.  */
+	  if (file->st.st_ino != 0
+	      && f->st.st_ino == file->st.st_ino
+	      && f->st.st_dev == file->st.st_dev)
+	    return false;
+
 	  if (f->buffer && !f->buffer_valid)
 	    {
 	      /* We already have a buffer but it is not valid, because
@@ -1456,6 +1508,7 @@ _cpp_cleanup_files (cpp_reader *pfile)
 {
   htab_delete (pfile->file_hash);
   htab_delete (pfile->dir_hash);
+  destroy_include_cache (pfile);
   htab_delete (pfile->nonexistent_file_hash);
   obstack_free (&pfile->nonexistent_file_ob, 0);
   free_file_hash_entries (pfile);
@@ -1692,6 +1745,333 @@ cpp_set_include_chains (cpp_reader *pfile, cpp_dir *quote, cpp_dir *bracket,
       if (quote == bracket)
 	pfile->bracket_include = bracket;
     }
+
+  if (CPP_OPTION (pfile, include_cache) && !pfile->include_cache)
+    load_include_cache (pfile);
+}
+
+/* Hash and compare include_cache_dirs, looked up by their name.  */
+static hashval_t
+include_cache_dir_hash (const void *p)
+{
+  return htab_hash_string (((const struct include_cache_dir *) p)->name);
+}
+
+static int
+include_cache_dir_eq (const void *p, const void *q)
+{
+  return filename_cmp (((const struct include_cache_dir *) p)->name,
+		       (const char *) q) == 0;
+}
+
+/* Return the include_cache_dir for the LEN bytes of NAME, stat'ing the
+   directory if it was not looked up before.  */
+static struct include_cache_dir *
+lookup_include_cache_dir (struct include_cache *cache, const char *name,
+			  size_t len)
+{
+  char *key = (char *) obstack_copy0 (&cache->ob, name, len);
+  void **slot = htab_find_slot_with_hash (cache->dirs, key,
+					  htab_hash_string (key), INSERT);
+  if (*slot)
+    {
+      obstack_free (&cache->ob, key);
+      return (struct include_cache_dir *) *slot;
+    }
+
+  struct include_cache_dir *dir = XOBNEW (&cache->ob,
+					  struct include_cache_dir);
+  struct stat st;
+  dir->name = key;
+  dir->exists = stat (key, &st) == 0 && S_ISDIR (st.st_mode);
+  dir->mtime = dir->exists ? st.st_mtime : 0;
+  *slot = dir;
+  return dir;
+}
+
+/* Return the deepest existing directory above the absolute PATH, or
+   NULL if there is none.  */
+static struct include_cache_dir *
+include_cache_parent (struct include_cache *cache, const char *path)
+{
+  size_t len = lbasename (path) - path;
+
+  while (len > 0)
+    {
+      /* Strip the trailing separators, but not a root one.  */
+      size_t dlen = len;
+      while (dlen > 1 && IS_DIR_SEPARATOR (path[dlen - 1]))
+	dlen--;
+
+      struct include_cache_dir *dir
+	= lookup_include_cache_dir (cache, path, dlen);
+      if (dir->exists)
+	return dir;
+
+      for (len = dlen; len > 0 && !IS_DIR_SEPARATOR (path[len - 1]); len--)
+	;
+      if (len == dlen)
+	break;
+    }
+
+  return NULL;
+}
+
+/* Parse the contents BUF of the cache file, of SIZE bytes, entering the
+   paths that are still missing into the nonexistent file hash.  */
+static void
+parse_include_cache (cpp_reader *pfile, char *buf, size_t size)
+{
+  struct include_cache *cache = pfile->include_cache;
+  char *end = buf + size;
+  size_t magic_len = strlen (INCLUDE_CACHE_MAGIC);
+  bool valid = false;
+
+  if (size <= magic_len
+      || memcmp (buf, INCLUDE_CACHE_MAGIC, magic_len) != 0
+      || buf[magic_len] != '\n')
+    {
+      cache->dirty = true;
+      return;
+    }
+
+  for (char *p = buf + magic_len + 1; p < end; )
+    {
+      char *eol = (char *) memchr (p, '\n', end - p);
+      if (!eol)
+	{
+	  cache->dirty = true;
+	  break;
+	}
+      *eol = '\0';
+
+      if (p[0] == 'D' && p[1] == ' ')
+	{
+	  /* "D <mtime> <directory>" validates the paths that follow.  */
+	  char *name;
+	  long long mtime = strtoll (p + 2, &name, 10);
+	  valid = false;
+	  if (*name == ' ')
+	    {
+	      name++;
+	      struct include_cache_dir *dir
+		= lookup_include_cache_dir (cache, name, eol - name);
+	      valid = dir->exists && (long long) dir->mtime == mtime;
+	    }
+	  if (!valid)
+	    cache->dirty = true;
+	}
+      else if (p[0] == 'M' && p[1] == ' ')
+	{
+	  /* "M <path>" is a path missing from the last directory.  */
+	  if (valid)
+	    {
+	      const char *path = p + 2;
+	      hashval_t hv = htab_hash_string (path);
+	      void **pp = htab_find_slot_with_hash (pfile->nonexistent_file_hash,
+						    path, hv, INSERT);
+	      if (*pp == NULL)
+		{
+		  *pp = obstack_copy0 (&pfile->nonexistent_file_ob, path,
+				       eol - path);
+		  *htab_find_slot (cache->loaded, *pp, INSERT) = *pp;
+		}
+	    }
+	}
+      else
+	cache->dirty = true;
+
+      p = eol + 1;
+    }
+}
+
+/* Load the persistent include lookup cache of the search path set by
+   cpp_set_include_chains.  The cache file is named after a digest of
+   the directories of the chains, so builds with different search
+   paths do not overwrite each other's caches.  */
+static void
+load_include_cache (cpp_reader *pfile)
+{
+  struct include_cache *cache = XCNEW (struct include_cache);
+  struct md5_ctx ctx;
+  unsigned char sum[16];
+  char hex[2 * sizeof sum + 1];
+  const char *dirname = CPP_OPTION (pfile, include_cache);
+
+  md5_init_ctx (&ctx);
+  for (cpp_dir *dir = pfile->quote_include; dir; dir = dir->next)
+    {
+      md5_process_bytes (dir->name, dir->len + 1, &ctx);
+      md5_process_bytes (&dir->sysp, 1, &ctx);
+      if (dir == pfile->bracket_include)
+	md5_process_bytes ("<", 1, &ctx);
+    }
+  md5_finish_ctx (&ctx, sum);
+  for (size_t i = 0; i < sizeof sum; i++)
+    sprintf (hex + 2 * i, "%02x", sum[i]);
+
+  size_t len = strlen (dirname);
+  cache->file = concat (dirname,
+			len && !IS_DIR_SEPARATOR (dirname[len - 1]) ? "/" : "",
+			hex, NULL);
+  cache->dirs = htab_create_alloc (127, include_cache_dir_hash,
+				   include_cache_dir_eq, NULL, xcalloc, free);
+  obstack_specify_allocation (&cache->ob, 0, 0, xmalloc, free);
+  cache->loaded = htab_create_alloc (127, htab_hash_pointer, htab_eq_pointer,
+				     NULL, xcalloc, free);
+  pfile->include_cache = cache;
+
+  int fd = open (cache->file, O_RDONLY | O_NOCTTY | O_BINARY);
+  struct stat st;
+  if (fd < 0)
+    return;
+
+  if (fstat (fd, &st) == 0 && st.st_size > 0)
+    {
+      size_t size = st.st_size, total = 0;
+      char *buf = XNEWVEC (char, size);
+      while (total < size)
+	{
+	  ssize_t count = read (fd, buf + total, size - total);
+	  if (count <= 0)
+	    break;
+	  total += count;
+	}
+      parse_include_cache (pfile, buf, total);
+      free (buf);
+    }
+  close (fd);
+}
+
+/* A path to save, and the directory validating it.  */
+struct include_cache_entry
+{
+  struct include_cache_dir *dir;
+  const char *path;
+};
+
+struct include_cache_save
+{
+  cpp_reader *pfile;
+  time_t now;
+  struct include_cache_entry *entries;
+  size_t count;
+};
+
+/* Modification times have a granularity of up to two seconds, so a
+   directory modified less than that before the cache is saved could be
+   modified again without its time changing.  */
+#define INCLUDE_CACHE_MTIME_SLACK 2
+
+/* htab_traverse callback of _cpp_save_include_cache: collect the path
+   in SLOT if the next compilation can trust it.  */
+static int
+collect_include_cache_entry (void **slot, void *b)
+{
+  struct include_cache_save *save = (struct include_cache_save *) b;
+  struct include_cache *cache = save->pfile->include_cache;
+  const char *path = (const char *) *slot;
+
+  if (!IS_ABSOLUTE_PATH (path) || strchr (path, '\n'))
+    return 1;
+
+  struct include_cache_dir *dir = include_cache_parent (cache, path);
+  if (!dir || dir->mtime + INCLUDE_CACHE_MTIME_SLACK > save->now)
+    return 1;
+
+  /* The directory of a path found missing by this compilation may have
+     been stat'ed only now, after a concurrent creation of the file:
+     check that it is still missing.  */
+  if (!htab_find (cache->loaded, path))
+    {
+      struct stat st;
+      if (stat (path, &st) == 0 || errno != ENOENT)
+	return 1;
+    }
+
+  save->entries[save->count].dir = dir;
+  save->entries[save->count].path = path;
+  save->count++;
+  return 1;
+}
+
+/* Order include_cache_entries by directory.  */
+static int
+include_cache_entry_compare (const void *a, const void *b)
+{
+  const struct include_cache_entry *ea
+    = (const struct include_cache_entry *) a;
+  const struct include_cache_entry *eb
+    = (const struct include_cache_entry *) b;
+  int cmp = strcmp (ea->dir->name, eb->dir->name);
+  return cmp ? cmp : strcmp (ea->path, eb->path);
+}
+
+/* Write the failed include lookups of this compilation, and those of
+   the cache still valid, back to the persistent include lookup cache.
+   The file is replaced atomically, so that concurrent compilations
+   read either version; when several save at once, the last one
+   wins.  Errors are ignored, the cache is only an optimization.  */
+void
+_cpp_save_include_cache (cpp_reader *pfile)
+{
+  struct include_cache *cache = pfile->include_cache;
+  if (!cache || !cache->dirty)
+    return;
+
+  struct include_cache_save save;
+  save.pfile = pfile;
+  save.now = time (NULL);
+  save.entries = XNEWVEC (struct include_cache_entry,
+			  htab_elements (pfile->nonexistent_file_hash));
+  save.count = 0;
+  htab_traverse (pfile->nonexistent_file_hash, collect_include_cache_entry,
+		 &save);
+  qsort (save.entries, save.count, sizeof (struct include_cache_entry),
+	 include_cache_entry_compare);
+
+  char *tmp = xasprintf ("%s.%ld.tmp", cache->file, (long) getpid ());
+  FILE *f = fopen (tmp, "w");
+  if (f)
+    {
+      struct include_cache_dir *dir = NULL;
+      fputs (INCLUDE_CACHE_MAGIC "\n", f);
+      for (size_t i = 0; i < save.count; i++)
+	{
+	  if (save.entries[i].dir != dir)
+	    {
+	      dir = save.entries[i].dir;
+	      fprintf (f, "D %lld %s\n", (long long) dir->mtime, dir->name);
+	    }
+	  fprintf (f, "M %s\n", save.entries[i].path);
+	}
+      bool ok = !ferror (f);
+      if (fclose (f) != 0)
+	ok = false;
+      if (ok && rename (tmp, cache->file) == 0)
+	cache->dirty = false;
+      else
+	unlink (tmp);
+    }
+
+  free (tmp);
+  free (save.entries);
+}
+
+/* Release the persistent include lookup cache.  */
+static void
+destroy_include_cache (cpp_reader *pfile)
+{
+  struct include_cache *cache = pfile->include_cache;
+  if (!cache)
+    return;
+
+  htab_delete (cache->dirs);
+  htab_delete (cache->loaded);
+  obstack_free (&cache->ob, 0);
+  free (cache->file);
+  free (cache);
+  pfile->include_cache = NULL;
 }
 
 /* Append the file name to the directory to create the path, but don't
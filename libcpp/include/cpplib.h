@@ -538,6 +538,9 @@ struct cpp_options
   /* Holds the name of the input character set.  */
   const char *input_charset;
 
+  /* Directory of the persistent include lookup cache, or NULL.  */
+  const char *include_cache;
+
   /* The minimum permitted level of normalization before a warning
      is generated.  See enum cpp_normalize_level.  */
   int warn_normalize;
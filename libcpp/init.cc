@@ -870,6 +870,8 @@ cpp_finish (cpp_reader *pfile, FILE *deps_stream)
   if (deps_stream)
     deps_write (pfile, deps_stream, 72);
 
+  _cpp_save_include_cache (pfile);
+
   /* Report on headers that could use multiple include guards.  */
   if (CPP_OPTION (pfile, print_include_names))
     _cpp_report_missing_guards (pfile);
@@ -29,7 +29,7 @@ static hashval_t cpp_string_hash (const void *);
 static int cpp_string_eq (const void *, const void *);
 static int count_defs (cpp_reader *, cpp_hashnode *, void *);
 static int comp_hashnodes (const void *, const void *);
-static int collect_ht_nodes (cpp_reader *, cpp_hashnode *, void *);
+static int check_undefined (cpp_reader *, cpp_hashnode *, void *);
 static int write_defs (cpp_reader *, cpp_hashnode *, void *);
 static int save_macros (cpp_reader *, cpp_hashnode *, void *);
 static int _cpp_save_pushed_macros (cpp_reader *, FILE *);
@@ -312,6 +312,8 @@ cpp_write_pch_deps (cpp_reader *r, FILE *f)
   struct macrodef_struct z;
   struct cpp_savedstate *const ss = r->savedstate;
   unsigned char *definedstrs;
+  unsigned int *buckets;
+  unsigned int nbuckets;
   size_t i;
 
   /* Collect the list of identifiers which have been seen and
@@ -324,12 +326,26 @@ cpp_write_pch_deps (cpp_reader *r, FILE *f)
   ss->n_defs = 0;
   cpp_forall_identifiers (r, write_defs, ss);
 
+  /* Index the list with an open-addressed hash table of offsets into
+     it, so that cpp_valid_state can probe the identifiers defined when
+     the PCH is used instead of sorting them and walking the list.  */
+  nbuckets = 16;
+  while (nbuckets < 2 * ss->n_defs)
+    nbuckets *= 2;
+  buckets = XCNEWVEC (unsigned int, nbuckets);
+
   /* Sort the list, copy it into a buffer, and write it out.  */
   qsort (ss->defs, ss->n_defs, sizeof (cpp_hashnode *), &comp_hashnodes);
   definedstrs = ss->definedstrs = XNEWVEC (unsigned char, ss->hashsize);
   for (i = 0; i < ss->n_defs; ++i)
     {
       size_t len = NODE_LEN (ss->defs[i]);
+      hashval_t h = hashmem (NODE_NAME (ss->defs[i]), len) & (nbuckets - 1);
+
+      while (buckets[h])
+	h = (h + 1) & (nbuckets - 1);
+      buckets[h] = definedstrs - ss->definedstrs + 1;
+
       memcpy (definedstrs, NODE_NAME (ss->defs[i]), len + 1);
       definedstrs += len + 1;
     }
@@ -337,11 +353,14 @@ cpp_write_pch_deps (cpp_reader *r, FILE *f)
   memset (&z, 0, sizeof (z));
   z.definition_length = ss->hashsize;
   if (fwrite (&z, sizeof (z), 1, f) != 1
-      || fwrite (ss->definedstrs, ss->hashsize, 1, f) != 1)
+      || fwrite (ss->definedstrs, ss->hashsize, 1, f) != 1
+      || fwrite (&nbuckets, sizeof (nbuckets), 1, f) != 1
+      || fwrite (buckets, sizeof (unsigned int), nbuckets, f) != nbuckets)
     {
       cpp_errno (r, CPP_DL_ERROR, "while writing precompiled header");
       return -1;
     }
+  free (buckets);
   free (ss->definedstrs);
   free (ss->defs);
   htab_delete (ss->definedhash);
@@ -514,37 +533,50 @@ _cpp_save_pushed_macros (cpp_reader *r, FILE *f)
 }
 
 
-/* Data structure to transform hash table nodes into a sorted list */
+/* The identifiers that must not be defined for a PCH to be used, as
+   written by cpp_write_pch_deps: null-terminated strings, indexed by a
+   hash table of their offsets plus one, zero for an empty bucket.  */
 
-struct ht_node_list
+struct undef_table
 {
-  /* Array of nodes */
-  cpp_hashnode **defs;
-  /* Number of nodes in the array */
-  size_t n_defs;
-  /* Size of the allocated array */
-  size_t asize;
+  const unsigned char *strs;
+  size_t size;
+  const unsigned int *buckets;
+  unsigned int nbuckets;
+  /* The first identifier found defined.  */
+  cpp_hashnode *defined;
 };
 
-/* Callback for collecting identifiers from hash table */
+/* Callback for cpp_forall_identifiers: stop at the first identifier
+   defined now that the table says must not be.  */
 
 static int
-collect_ht_nodes (cpp_reader *pfile ATTRIBUTE_UNUSED, cpp_hashnode *hn,
-		  void *nl_p)
+check_undefined (cpp_reader *pfile ATTRIBUTE_UNUSED, cpp_hashnode *hn,
+		 void *ut_p)
 {
-  struct ht_node_list *const nl = (struct ht_node_list *)nl_p;
+  struct undef_table *const ut = (struct undef_table *) ut_p;
 
-  if (hn->type != NT_VOID || hn->flags & NODE_POISONED)
-    {
-      if (nl->n_defs == nl->asize)
-        {
-          nl->asize *= 2;
-          nl->defs = XRESIZEVEC (cpp_hashnode *, nl->defs, nl->asize);
-        }
+  if (hn->type == NT_VOID && !(hn->flags & NODE_POISONED))
+    return 1;
 
-      nl->defs[nl->n_defs] = hn;
-      ++nl->n_defs;
+  size_t len = NODE_LEN (hn);
+  hashval_t h = hashmem (NODE_NAME (hn), len) & (ut->nbuckets - 1);
+  for (unsigned int probes = 0; probes < ut->nbuckets; probes++)
+    {
+      size_t off = ut->buckets[h];
+      if (off == 0)
+	break;
+      off--;
+      if (off + len < ut->size
+	  && ut->strs[off + len] == '\0'
+	  && memcmp (ut->strs + off, NODE_NAME (hn), len) == 0)
+	{
+	  ut->defined = hn;
+	  return 0;
+	}
+      h = (h + 1) & (ut->nbuckets - 1);
     }
+
   return 1;
 }
 
@@ -569,9 +601,9 @@ cpp_valid_state (cpp_reader *r, const char *name, int fd)
   size_t namebufsz = 256;
   unsigned char *namebuf = XNEWVEC (unsigned char, namebufsz);
   unsigned char *undeftab = NULL;
-  struct ht_node_list nl = { 0, 0, 0 };
-  unsigned char *first, *last;
-  unsigned int i;
+  unsigned int *buckets = NULL;
+  unsigned int nbuckets;
+  struct undef_table ut;
   unsigned int counter;
 
   /* Read in the list of identifiers that must be defined
@@ -662,40 +694,34 @@ cpp_valid_state (cpp_reader *r, const char *name, int fd)
   undeftab = XNEWVEC (unsigned char, m.definition_length);
   if ((size_t) read (fd, undeftab, m.definition_length) != m.definition_length)
     goto error;
+  if (read (fd, &nbuckets, sizeof (nbuckets)) != sizeof (nbuckets)
+      || nbuckets == 0
+      || (nbuckets & (nbuckets - 1)) != 0)
+    goto error;
+  buckets = XNEWVEC (unsigned int, nbuckets);
+  if ((size_t) read (fd, buckets, nbuckets * sizeof (unsigned int))
+      != nbuckets * sizeof (unsigned int))
+    goto error;
 
-  /* Collect identifiers from the current hash table.  */
-  nl.n_defs = 0;
-  nl.asize = 10;
-  nl.defs = XNEWVEC (cpp_hashnode *, nl.asize);
-  cpp_forall_identifiers (r, &collect_ht_nodes, &nl);
-  qsort (nl.defs, nl.n_defs, sizeof (cpp_hashnode *), &comp_hashnodes);
-
-  /* Loop through nl.defs and undeftab, both of which are sorted lists.
-     There should be no matches.  */
-  first = undeftab;
-  last = undeftab + m.definition_length;
-  i = 0;
-
-  while (first < last && i < nl.n_defs)
+  /* Look the identifiers defined now up in the table.  There should
+     be no matches.  */
+  ut.strs = undeftab;
+  ut.size = m.definition_length;
+  ut.buckets = buckets;
+  ut.nbuckets = nbuckets;
+  ut.defined = NULL;
+  cpp_forall_identifiers (r, check_undefined, &ut);
+  if (ut.defined)
     {
-      int cmp = ustrcmp (first, NODE_NAME (nl.defs[i]));
-
-      if (cmp < 0)
- 	first += ustrlen (first) + 1;
-      else if (cmp > 0)
- 	++i;
-      else
-	{
-	  if (CPP_OPTION (r, warn_invalid_pch))
-	    cpp_warning_syshdr (r, CPP_W_INVALID_PCH,
-		                "%s: not used because `%s' is defined",
-		                name, first);
-	  goto fail;
-	}
+      if (CPP_OPTION (r, warn_invalid_pch))
+	cpp_warning_syshdr (r, CPP_W_INVALID_PCH,
+			    "%s: not used because `%s' is defined",
+			    name, NODE_NAME (ut.defined));
+      goto fail;
     }
 
-  free(nl.defs);
-  nl.defs = NULL;
+  free (buckets);
+  buckets = NULL;
   free (undeftab);
   undeftab = NULL;
 
@@ -722,7 +748,7 @@ cpp_valid_state (cpp_reader *r, const char *name, int fd)
  fail:
   free (namebuf);
   free (undeftab);
-  free (nl.defs);
+  free (buckets);
   return 1;
 }
 
@@ -50,7 +50,9 @@ enum gomp_memkind_kind
 #define GOMP_MEMKIND_KIND(kind) GOMP_MEMKIND_##kind
   GOMP_MEMKIND_KINDS,
 #undef GOMP_MEMKIND_KIND
-  GOMP_MEMKIND_COUNT
+  GOMP_MEMKIND_COUNT,
+  /* Memory local to the allocating thread's NUMA node, from libnuma.  */
+  GOMP_MEMKIND_LIBNUMA = GOMP_MEMKIND_COUNT
 };
 
 struct omp_allocator_data
@@ -92,6 +94,14 @@ struct gomp_memkind_data
   void **kinds[GOMP_MEMKIND_COUNT];
 };
 
+struct gomp_libnuma_data
+{
+  void *numa_handle;
+  void *(*numa_alloc_local) (size_t);
+  void *(*numa_realloc) (void *, size_t, size_t);
+  void (*numa_free) (void *, size_t);
+};
+
 #ifdef LIBGOMP_USE_MEMKIND
 static struct gomp_memkind_data *memkind_data;
 static pthread_once_t memkind_data_once = PTHREAD_ONCE_INIT;
@@ -157,6 +167,105 @@ gomp_get_memkind (void)
   pthread_once (&memkind_data_once, gomp_init_memkind);
   return __atomic_load_n (&memkind_data, MEMMODEL_ACQUIRE);
 }
+
+static struct gomp_libnuma_data *libnuma_data;
+static pthread_once_t libnuma_data_once = PTHREAD_ONCE_INIT;
+
+static void
+gomp_init_libnuma (void)
+{
+  void *handle = dlopen ("libnuma.so.1", RTLD_LAZY);
+  struct gomp_libnuma_data *data;
+  int (*numa_available) (void);
+
+  data = calloc (1, sizeof (struct gomp_libnuma_data));
+  if (data == NULL)
+    {
+      if (handle)
+	dlclose (handle);
+      return;
+    }
+  if (handle)
+    {
+      numa_available
+	= (__typeof (numa_available)) dlsym (handle, "numa_available");
+      if (numa_available && numa_available () != -1)
+	{
+	  data->numa_alloc_local
+	    = (__typeof (data->numa_alloc_local))
+	      dlsym (handle, "numa_alloc_local");
+	  data->numa_realloc
+	    = (__typeof (data->numa_realloc)) dlsym (handle, "numa_realloc");
+	  data->numa_free
+	    = (__typeof (data->numa_free)) dlsym (handle, "numa_free");
+	}
+      if (data->numa_alloc_local && data->numa_realloc && data->numa_free)
+	data->numa_handle = handle;
+      else
+	{
+	  data->numa_alloc_local = NULL;
+	  dlclose (handle);
+	}
+    }
+  __atomic_store_n (&libnuma_data, data, MEMMODEL_RELEASE);
+}
+
+static struct gomp_libnuma_data *
+gomp_get_libnuma (void)
+{
+  struct gomp_libnuma_data *data
+    = __atomic_load_n (&libnuma_data, MEMMODEL_ACQUIRE);
+  if (data)
+    return data;
+  pthread_once (&libnuma_data_once, gomp_init_libnuma);
+  return __atomic_load_n (&libnuma_data, MEMMODEL_ACQUIRE);
+}
+
+/* Allocate SIZE bytes of MEMKIND, cleared if CLEAR.  libnuma maps its
+   memory, so it always comes cleared.  */
+
+static void *
+gomp_memkind_alloc (enum gomp_memkind_kind memkind, size_t size, bool clear)
+{
+  if (memkind == GOMP_MEMKIND_LIBNUMA)
+    return gomp_get_libnuma ()->numa_alloc_local (size);
+
+  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
+  void *kind = *memkind_data->kinds[memkind];
+  if (clear)
+    return memkind_data->memkind_calloc (kind, 1, size);
+  return memkind_data->memkind_malloc (kind, size);
+}
+
+/* Resize PTR, OLD_SIZE bytes of MEMKIND, to SIZE bytes.  */
+
+static void *
+gomp_memkind_realloc (enum gomp_memkind_kind memkind, void *ptr,
+		      size_t old_size, size_t size)
+{
+  if (memkind == GOMP_MEMKIND_LIBNUMA)
+    return gomp_get_libnuma ()->numa_realloc (ptr, old_size, size);
+
+  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
+  void *kind = *memkind_data->kinds[memkind];
+  return memkind_data->memkind_realloc (kind, ptr, size);
+}
+
+/* Free PTR, SIZE bytes of MEMKIND.  */
+
+static void
+gomp_memkind_free (enum gomp_memkind_kind memkind, void *ptr, size_t size)
+{
+  if (memkind == GOMP_MEMKIND_LIBNUMA)
+    {
+      gomp_get_libnuma ()->numa_free (ptr, size);
+      return;
+    }
+
+  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
+  void *kind = *memkind_data->kinds[memkind];
+  memkind_data->memkind_free (kind, ptr);
+}
 #endif
 
 omp_allocator_handle_t
@@ -319,6 +428,9 @@ omp_init_allocator (omp_memspace_handle_t memspace, int ntraits,
 	  if (memkind_data->kinds[GOMP_MEMKIND_INTERLEAVE])
 	    data.memkind = GOMP_MEMKIND_INTERLEAVE;
 	}
+      else if (data.partition == omp_atv_nearest
+	       && gomp_get_libnuma ()->numa_handle)
+	data.memkind = GOMP_MEMKIND_LIBNUMA;
 #endif
       break;
     }
@@ -446,11 +558,7 @@ retry:
 #endif
 #ifdef LIBGOMP_USE_MEMKIND
       if (memkind)
-	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[memkind];
-	  ptr = memkind_data->memkind_malloc (kind, new_size);
-	}
+      	ptr = gomp_memkind_alloc (memkind, new_size, false);
       else
 #endif
 	ptr = malloc (new_size);
@@ -471,11 +579,7 @@ retry:
     {
 #ifdef LIBGOMP_USE_MEMKIND
       if (memkind)
-	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[memkind];
-	  ptr = memkind_data->memkind_malloc (kind, new_size);
-	}
+      	ptr = gomp_memkind_alloc (memkind, new_size, false);
       else
 #endif
 	ptr = malloc (new_size);
@@ -580,9 +684,7 @@ omp_free (void *ptr, omp_allocator_handle_t allocator)
 #ifdef LIBGOMP_USE_MEMKIND
       if (allocator_data->memkind)
 	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[allocator_data->memkind];
-	  memkind_data->memkind_free (kind, data->ptr);
+	  gomp_memkind_free (allocator_data->memkind, data->ptr, data->size);
 	  return;
 	}
 #endif
@@ -600,8 +702,7 @@ omp_free (void *ptr, omp_allocator_handle_t allocator)
 	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
 	  if (memkind_data->kinds[memkind])
 	    {
-	      void *kind = *memkind_data->kinds[memkind];
-	      memkind_data->memkind_free (kind, data->ptr);
+	      gomp_memkind_free (memkind, data->ptr, data->size);
 	      return;
 	    }
 	}
@@ -716,11 +817,7 @@ retry:
 #endif
 #ifdef LIBGOMP_USE_MEMKIND
       if (memkind)
-	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[memkind];
-	  ptr = memkind_data->memkind_calloc (kind, 1, new_size);
-	}
+      	ptr = gomp_memkind_alloc (memkind, new_size, true);
       else
 #endif
 	ptr = calloc (1, new_size);
@@ -741,11 +838,7 @@ retry:
     {
 #ifdef LIBGOMP_USE_MEMKIND
       if (memkind)
-	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[memkind];
-	  ptr = memkind_data->memkind_calloc (kind, 1, new_size);
-	}
+      	ptr = gomp_memkind_alloc (memkind, new_size, true);
       else
 #endif
 	ptr = calloc (1, new_size);
@@ -956,13 +1049,11 @@ retry:
 #ifdef LIBGOMP_USE_MEMKIND
       if (memkind)
 	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[memkind];
 	  if (prev_size)
-	    new_ptr = memkind_data->memkind_realloc (kind, data->ptr,
-						     new_size);
+	    new_ptr = gomp_memkind_realloc (memkind, data->ptr, old_size,
+					    new_size);
 	  else
-	    new_ptr = memkind_data->memkind_malloc (kind, new_size);
+	    new_ptr = gomp_memkind_alloc (memkind, new_size, false);
 	}
       else
 #endif
@@ -1002,12 +1093,8 @@ retry:
     {
 #ifdef LIBGOMP_USE_MEMKIND
       if (memkind)
-	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[memkind];
-	  new_ptr = memkind_data->memkind_realloc (kind, data->ptr,
-						   new_size);
-	}
+	new_ptr = gomp_memkind_realloc (memkind, data->ptr, old_size,
+					new_size);
       else
 #endif
 	new_ptr = realloc (data->ptr, new_size);
@@ -1023,11 +1110,7 @@ retry:
     {
 #ifdef LIBGOMP_USE_MEMKIND
       if (memkind)
-	{
-	  struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-	  void *kind = *memkind_data->kinds[memkind];
-	  new_ptr = memkind_data->memkind_malloc (kind, new_size);
-	}
+      	new_ptr = gomp_memkind_alloc (memkind, new_size, false);
       else
 #endif
 	new_ptr = malloc (new_size);
@@ -1063,9 +1146,7 @@ retry:
 #ifdef LIBGOMP_USE_MEMKIND
   if (free_memkind)
     {
-      struct gomp_memkind_data *memkind_data = gomp_get_memkind ();
-      void *kind = *memkind_data->kinds[free_memkind];
-      memkind_data->memkind_free (kind, data->ptr);
+      gomp_memkind_free (free_memkind, data->ptr, data->size);
       return ret;
     }
 #endif
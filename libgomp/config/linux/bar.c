@@ -31,13 +31,30 @@
 #include "wait.h"
 
 
+/* Arrive on the group of the calling thread, and return true if it was
+   the last thread of the last group to arrive.  */
+
+bool
+gomp_barrier_arrive_group (gomp_barrier_t *bar)
+{
+  struct gomp_barrier_group *group
+    = &bar->group[gomp_thread ()->ts.team_id / bar->group_size];
+  if (__atomic_add_fetch (&group->awaited, -1, MEMMODEL_ACQ_REL) != 0)
+    return false;
+
+  /* The next arrivals on the group can't happen before BAR is released,
+     which needs this thread's arrival on AWAITED below.  */
+  group->awaited = group->total;
+  return __atomic_add_fetch (&bar->awaited, -1, MEMMODEL_ACQ_REL) == 0;
+}
+
 void
 gomp_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
 {
   if (__builtin_expect (state & BAR_WAS_LAST, 0))
     {
       /* Next time we'll be awaiting TOTAL threads again.  */
-      bar->awaited = bar->total;
+      gomp_barrier_reset_awaited (bar);
       __atomic_store_n (&bar->generation, bar->generation + BAR_INCR,
 			MEMMODEL_RELEASE);
       futex_wake ((int *) &bar->generation, INT_MAX);
@@ -88,7 +105,7 @@ gomp_team_barrier_wait_end (gomp_barrier_t *bar, gomp_barrier_state_t state)
       struct gomp_thread *thr = gomp_thread ();
       struct gomp_team *team = thr->ts.team;
 
-      bar->awaited = bar->total;
+      gomp_barrier_reset_awaited (bar);
       team->work_share_cancelled = 0;
       if (__builtin_expect (team->task_count, 0))
 	{
@@ -133,6 +150,8 @@ gomp_team_barrier_wait_final (gomp_barrier_t *bar)
   gomp_barrier_state_t state = gomp_barrier_wait_final_start (bar);
   if (__builtin_expect (state & BAR_WAS_LAST, 0))
     bar->awaited_final = bar->total;
+  /* This also repairs the AWAITED and group counts a cancelled team
+     barrier may have left behind, before the team can be reused.  */
   gomp_team_barrier_wait_end (bar, state);
 }
 
@@ -152,7 +171,7 @@ gomp_team_barrier_wait_cancel_end (gomp_barrier_t *bar,
       struct gomp_thread *thr = gomp_thread ();
       struct gomp_team *team = thr->ts.team;
 
-      bar->awaited = bar->total;
+      gomp_barrier_reset_awaited (bar);
       team->work_share_cancelled = 0;
       if (__builtin_expect (team->task_count, 0))
 	{
@@ -32,14 +32,32 @@
 
 #include "mutex.h"
 
+/* With many threads, arrivals are combined in groups of consecutive
+   threads, each counting down in its own cacheline, and only the last
+   thread of each group decrements AWAITED.  */
+#define GOMP_BARRIER_MAX_GROUPS 16
+#define GOMP_BARRIER_GROUP_SIZE 8
+#define GOMP_BARRIER_GROUP_THRESHOLD 32
+
+struct __attribute__((aligned (64))) gomp_barrier_group
+{
+  unsigned awaited;
+  unsigned total;
+};
+
 typedef struct
 {
   /* Make sure total/generation is in a mostly read cacheline, while
      awaited in a separate cacheline.  */
   unsigned total __attribute__((aligned (64)));
   unsigned generation;
+  /* Number of arrivals on AWAITED, which is the number of groups when
+     GROUP_SIZE is non-zero and TOTAL otherwise.  */
+  unsigned arrivals;
+  unsigned group_size;
   unsigned awaited __attribute__((aligned (64)));
   unsigned awaited_final;
+  struct gomp_barrier_group group[GOMP_BARRIER_MAX_GROUPS];
 } gomp_barrier_t;
 
 typedef unsigned int gomp_barrier_state_t;
@@ -56,15 +74,58 @@ typedef unsigned int gomp_barrier_state_t;
 static inline void gomp_barrier_init (gomp_barrier_t *bar, unsigned count)
 {
   bar->total = count;
+  bar->arrivals = count;
+  bar->group_size = 0;
   bar->awaited = count;
   bar->awaited_final = count;
   bar->generation = 0;
 }
 
+/* Split the arrivals on BAR, initialized for COUNT threads, in groups if
+   COUNT is large enough.  All the threads must then arrive on BAR with
+   distinct team_ids below COUNT, and BAR can't be reinitialized.  */
+
+static inline void gomp_barrier_init_groups (gomp_barrier_t *bar,
+					     unsigned count)
+{
+  unsigned size = GOMP_BARRIER_GROUP_SIZE, groups, i;
+
+  if (count < GOMP_BARRIER_GROUP_THRESHOLD)
+    return;
+  if (count > size * GOMP_BARRIER_MAX_GROUPS)
+    size = (count + GOMP_BARRIER_MAX_GROUPS - 1) / GOMP_BARRIER_MAX_GROUPS;
+  groups = (count + size - 1) / size;
+  for (i = 0; i < groups; i++)
+    {
+      unsigned n = count - i * size < size ? count - i * size : size;
+      bar->group[i].awaited = n;
+      bar->group[i].total = n;
+    }
+  bar->group_size = size;
+  bar->arrivals = groups;
+  bar->awaited = groups;
+}
+
+/* Make BAR await all its arrivals again.  Called by the last thread to
+   arrive, before BAR is released.  Each group is normally reset by its own
+   last arrival, but the threads which leave a cancelled team barrier early
+   leave partial counts in their groups, so they are all reset here too.  */
+
+static inline void gomp_barrier_reset_awaited (gomp_barrier_t *bar)
+{
+  unsigned i;
+
+  bar->awaited = bar->arrivals;
+  if (__builtin_expect (bar->group_size != 0, 0))
+    for (i = 0; i < bar->arrivals; i++)
+      bar->group[i].awaited = bar->group[i].total;
+}
+
 static inline void gomp_barrier_reinit (gomp_barrier_t *bar, unsigned count)
 {
   __atomic_add_fetch (&bar->awaited, count - bar->total, MEMMODEL_ACQ_REL);
   bar->total = count;
+  bar->arrivals = count;
 }
 
 static inline void gomp_barrier_destroy (gomp_barrier_t *bar)
@@ -82,6 +143,7 @@ extern bool gomp_team_barrier_wait_cancel (gomp_barrier_t *);
 extern bool gomp_team_barrier_wait_cancel_end (gomp_barrier_t *,
 					       gomp_barrier_state_t);
 extern void gomp_team_barrier_wake (gomp_barrier_t *, int);
+extern bool gomp_barrier_arrive_group (gomp_barrier_t *);
 struct gomp_team;
 extern void gomp_team_barrier_cancel (struct gomp_team *);
 
@@ -95,7 +157,12 @@ gomp_barrier_wait_start (gomp_barrier_t *bar)
      2.8.6 flush Construct, which says there is an implicit flush during
      a barrier region.  This is a convenient place to add the barrier,
      so we use MEMMODEL_ACQ_REL here rather than MEMMODEL_ACQUIRE.  */
-  if (__atomic_add_fetch (&bar->awaited, -1, MEMMODEL_ACQ_REL) == 0)
+  if (__builtin_expect (bar->group_size != 0, 0))
+    {
+      if (gomp_barrier_arrive_group (bar))
+	ret |= BAR_WAS_LAST;
+    }
+  else if (__atomic_add_fetch (&bar->awaited, -1, MEMMODEL_ACQ_REL) == 0)
     ret |= BAR_WAS_LAST;
   return ret;
 }
@@ -28,10 +28,72 @@
    implementation uses atomic instructions and the futex syscall.  */
 
 #include "wait.h"
+#ifdef HAVE_CLOCK_GETTIME
+# include <time.h>
+#endif
 
 int gomp_futex_wake = FUTEX_WAKE | FUTEX_PRIVATE_FLAG;
 int gomp_futex_wait = FUTEX_WAIT | FUTEX_PRIVATE_FLAG;
 
+struct gomp_spin_stats gomp_spin_stats;
+
+/* futex_wait for do_wait with GOMP_SPINCOUNT_ADAPTIVE, tuning the spin
+   budget of the thread from how long it was parked.  Being woken soon
+   means the thread should have spun a little longer and saved the
+   syscalls; a long park, such as a gap between parallel regions, means
+   it would have burnt its core for nothing.  */
+
+void
+gomp_adaptive_futex_wait (int *addr, int val)
+{
+  struct gomp_thread *thr = gomp_thread ();
+  unsigned long long budget = gomp_spin_budget (thr);
+
+#ifdef HAVE_CLOCK_GETTIME
+  struct timespec start, end;
+  unsigned long long ns;
+
+  clock_gettime (CLOCK_MONOTONIC, &start);
+  futex_wait (addr, val);
+  clock_gettime (CLOCK_MONOTONIC, &end);
+  ns = (end.tv_sec - start.tv_sec) * 1000000000ULL
+       + end.tv_nsec - start.tv_nsec;
+
+  if (ns < GOMP_SPIN_SHORT_PARK_NS)
+    {
+      budget = 2 * budget + GOMP_SPIN_MIN_BUDGET;
+      __atomic_add_fetch (&gomp_spin_stats.short_parks, 1, MEMMODEL_RELAXED);
+    }
+  else
+    budget /= 2;
+  __atomic_add_fetch (&gomp_spin_stats.parked_ns, ns, MEMMODEL_RELAXED);
+#else
+  futex_wait (addr, val);
+  budget /= 2;
+#endif
+  __atomic_add_fetch (&gomp_spin_stats.parks, 1, MEMMODEL_RELAXED);
+
+  if (budget < GOMP_SPIN_MIN_BUDGET)
+    budget = GOMP_SPIN_MIN_BUDGET;
+  if (budget > gomp_spin_count_var)
+    budget = gomp_spin_count_var;
+  thr->spin_budget = budget;
+}
+
+/* Report the adaptive spinning statistics with GOMP_DEBUG.  */
+
+static void __attribute__((destructor))
+gomp_spin_stats_report (void)
+{
+  if (!gomp_spin_adaptive_var)
+    return;
+
+  gomp_debug (0, "adaptive spinning: %llu parks, %llu woken within "
+	      "%u us, %llu us parked in total\n", gomp_spin_stats.parks,
+	      gomp_spin_stats.short_parks, GOMP_SPIN_SHORT_PARK_NS / 1000,
+	      gomp_spin_stats.parked_ns / 1000);
+}
+
 void
 gomp_mutex_lock_slow (gomp_mutex_t *mutex, int oldval)
 {
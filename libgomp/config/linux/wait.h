@@ -45,17 +45,54 @@ extern int gomp_futex_wait, gomp_futex_wake;
 
 #include <futex.h>
 
+/* With GOMP_SPINCOUNT_ADAPTIVE, each thread spins for its own budget of
+   at most gomp_spin_count_var.  The budget grows to twice the longest
+   spins that paid off, and after each futex_wait in do_wait it doubles
+   if the thread was woken within GOMP_SPIN_SHORT_PARK_NS and halves
+   otherwise, down to GOMP_SPIN_MIN_BUDGET.  */
+#define GOMP_SPIN_SHORT_PARK_NS 50000
+#define GOMP_SPIN_MIN_BUDGET 1000
+
+struct gomp_spin_stats
+{
+  unsigned long long parks;
+  unsigned long long short_parks;
+  unsigned long long parked_ns;
+};
+
+extern struct gomp_spin_stats gomp_spin_stats;
+extern void gomp_adaptive_futex_wait (int *, int);
+
+static inline unsigned long long gomp_spin_budget (struct gomp_thread *thr)
+{
+  if (__builtin_expect (thr->spin_budget == 0, 0))
+    thr->spin_budget = gomp_spin_count_var;
+  return thr->spin_budget;
+}
+
 static inline int do_spin (int *addr, int val)
 {
   unsigned long long i, count = gomp_spin_count_var;
+  struct gomp_thread *thr = NULL;
 
+  if (__builtin_expect (gomp_spin_adaptive_var, 0))
+    {
+      thr = gomp_thread ();
+      count = gomp_spin_budget (thr);
+    }
   if (__builtin_expect (__atomic_load_n (&gomp_managed_threads,
                                          MEMMODEL_RELAXED)
-                        > gomp_available_cpus, 0))
+                        > gomp_available_cpus, 0)
+      && count > gomp_throttled_spin_count_var)
     count = gomp_throttled_spin_count_var;
   for (i = 0; i < count; i++)
     if (__builtin_expect (__atomic_load_n (addr, MEMMODEL_RELAXED) != val, 0))
-      return 0;
+      {
+	if (__builtin_expect (thr != NULL, 0) && 2 * i > thr->spin_budget)
+	  thr->spin_budget = (2 * i < gomp_spin_count_var
+			      ? 2 * i : gomp_spin_count_var);
+	return 0;
+      }
     else
       cpu_relax ();
   return 1;
@@ -64,7 +101,12 @@ static inline int do_spin (int *addr, int val)
 static inline void do_wait (int *addr, int val)
 {
   if (do_spin (addr, val))
-    futex_wait (addr, val);
+    {
+      if (__builtin_expect (gomp_spin_adaptive_var, 0))
+	gomp_adaptive_futex_wait (addr, val);
+      else
+	futex_wait (addr, val);
+    }
 }
 
 #ifdef HAVE_ATTRIBUTE_VISIBILITY
@@ -146,6 +146,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   thr->ts.work_share = &team->work_shares[0];
   thr->ts.last_work_share = NULL;
   thr->ts.single_count = 0;
+  thr->ts.dynamic_ws = NULL;
   thr->ts.static_trip = 0;
   thr->task = &team->implicit_task[0];
   nthreads_var = icv->nthreads_var;
@@ -167,6 +168,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
       nthr->ts.level = team->prev_ts.level + 1;
       nthr->ts.active_level = thr->ts.active_level;
       nthr->ts.single_count = 0;
+      nthr->ts.dynamic_ws = NULL;
       nthr->ts.static_trip = 0;
       nthr->task = &team->implicit_task[i];
       gomp_init_task (nthr->task, task, icv);
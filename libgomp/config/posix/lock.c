@@ -207,6 +207,24 @@ gomp_test_nest_lock_30 (omp_nest_lock_t *lock)
 }
 #endif
 
+/* Synchronization hints can't change what a lock does, and there is
+   only one kind of lock to choose from here, so the OpenMP 4.5 hinted
+   initializers set up the same lock as the plain ones.  */
+
+void
+omp_init_lock_with_hint (omp_lock_t *lock,
+			 omp_sync_hint_t hint __attribute__((unused)))
+{
+  gomp_init_lock_30 (lock);
+}
+
+void
+omp_init_nest_lock_with_hint (omp_nest_lock_t *lock,
+			      omp_sync_hint_t hint __attribute__((unused)))
+{
+  gomp_init_nest_lock_30 (lock);
+}
+
 #ifdef LIBGOMP_GNU_SYMBOL_VERSIONING
 void
 gomp_init_lock_25 (omp_lock_25_t *lock)
@@ -26,6 +26,7 @@
 /* This file handles the CRITICAL construct.  */
 
 #include "libgomp.h"
+#include "ompt-int.h"
 #include <stdlib.h>
 
 
@@ -36,13 +37,16 @@ GOMP_critical_start (void)
 {
   /* There is an implicit flush on entry to a critical region. */
   __atomic_thread_fence (MEMMODEL_RELEASE);
+  gomp_ompt_mutex_acquire (ompt_mutex_critical, &default_lock);
   gomp_mutex_lock (&default_lock);
+  gomp_ompt_mutex_acquired (ompt_mutex_critical, &default_lock);
 }
 
 void
 GOMP_critical_end (void)
 {
   gomp_mutex_unlock (&default_lock);
+  gomp_ompt_mutex_released (ompt_mutex_critical, &default_lock);
 }
 
 #ifndef HAVE_SYNC_BUILTINS
@@ -95,7 +99,9 @@ GOMP_critical_name_start (void **pptr)
 	}
     }
 
+  gomp_ompt_mutex_acquire (ompt_mutex_critical, plock);
   gomp_mutex_lock (plock);
+  gomp_ompt_mutex_acquired (ompt_mutex_critical, plock);
 }
 
 void
@@ -113,6 +119,7 @@ GOMP_critical_name_end (void **pptr)
     plock = *pptr;
 
   gomp_mutex_unlock (plock);
+  gomp_ompt_mutex_released (ompt_mutex_critical, plock);
 }
 
 #if !GOMP_MUTEX_INIT_0
@@ -33,6 +33,7 @@
 #ifndef LIBGOMP_OFFLOADED_ONLY
 #include "libgomp_f.h"
 #include "oacc-int.h"
+#include "ompt-int.h"
 #include <ctype.h>
 #include <stdlib.h>
 #include <stdio.h>
@@ -105,6 +106,8 @@ gomp_mutex_t gomp_managed_threads_lock;
 #endif
 unsigned long gomp_available_cpus = 1, gomp_managed_threads = 1;
 unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
+bool gomp_spin_adaptive_var;
+bool gomp_taskloop_adaptive_var;
 unsigned long *gomp_nthreads_var_list, gomp_nthreads_var_list_len;
 char *gomp_bind_var_list;
 unsigned long gomp_bind_var_list_len;
@@ -1809,6 +1812,10 @@ omp_display_env (int verbose)
       fprintf (stderr, "  [host] GOMP_SPINCOUNT = '%lu'\n",
 	       (unsigned long) gomp_spin_count_var);
 #endif
+      fprintf (stderr, "  [host] GOMP_SPINCOUNT_ADAPTIVE = '%s'\n",
+	       gomp_spin_adaptive_var ? "TRUE" : "FALSE");
+      fprintf (stderr, "  [host] GOMP_TASKLOOP_ADAPTIVE = '%s'\n",
+	       gomp_taskloop_adaptive_var ? "TRUE" : "FALSE");
     }
 
   fputs ("OPENMP DISPLAY ENVIRONMENT END\n", stderr);
@@ -2271,6 +2278,10 @@ initialize_env (void)
     gomp_throttled_spin_count_var = 100LL;
   if (gomp_throttled_spin_count_var > gomp_spin_count_var)
     gomp_throttled_spin_count_var = gomp_spin_count_var;
+  parse_boolean ("GOMP_SPINCOUNT_ADAPTIVE", getenv ("GOMP_SPINCOUNT_ADAPTIVE"),
+		 (void *[]) {&gomp_spin_adaptive_var});
+  parse_boolean ("GOMP_TASKLOOP_ADAPTIVE", getenv ("GOMP_TASKLOOP_ADAPTIVE"),
+		 (void *[]) {&gomp_taskloop_adaptive_var});
 
   /* Not strictly environment related, but ordering constructors is tricky.  */
   pthread_attr_init (&gomp_thread_attr);
@@ -2326,5 +2337,8 @@ initialize_env (void)
   goacc_runtime_initialize ();
 
   goacc_profiling_initialize ();
+
+  /* OpenMP tools, once everything they might query is set up.  */
+  gomp_ompt_initialize ();
 }
 #endif /* LIBGOMP_OFFLOADED_ONLY */
@@ -277,6 +277,20 @@ omp_lock_symver (omp_unset_nest_lock_)
 omp_lock_symver (omp_test_nest_lock_)
 #endif
 
+void
+omp_init_lock_with_hint_ (omp_lock_arg_t lock,
+			  const int32_t *hint __attribute__((unused)))
+{
+  gomp_init_lock__30 (lock);
+}
+
+void
+omp_init_nest_lock_with_hint_ (omp_nest_lock_arg_t lock,
+			       const int32_t *hint __attribute__((unused)))
+{
+  gomp_init_nest_lock__30 (lock);
+}
+
 #define TO_INT(x) ((x) > INT_MIN ? (x) < INT_MAX ? (x) : INT_MAX : INT_MIN)
 
 void
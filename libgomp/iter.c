@@ -177,8 +177,44 @@ gomp_iter_dynamic_next_locked (long *pstart, long *pend)
 
 
 #ifdef HAVE_SYNC_BUILTINS
+/* Hand out the first chunk of the batch from START to NEND the current
+   thread claimed from WS, keep the others for its next calls, and pick the
+   size of its next batch from how much of the loop is left.  */
+
+static void
+gomp_iter_dynamic_batch (struct gomp_thread *thr, struct gomp_work_share *ws,
+			 long start, long nend, long *pstart, long *pend)
+{
+  long chunk = ws->chunk_size;
+  long end = start + chunk;
+  long batch;
+
+  if (ws->incr > 0 ? end > nend : end < nend)
+    end = nend;
+  *pstart = start;
+  *pend = end;
+
+  /* CHUNK has the sign of the increment, so this is positive either
+     way.  */
+  batch = (ws->end - nend) / chunk
+	  / ((long) thr->ts.team->nthreads * GOMP_DYNAMIC_BATCH_SPREAD);
+  if (batch < 1)
+    batch = 1;
+  else if (batch > GOMP_DYNAMIC_BATCH_MAX)
+    batch = GOMP_DYNAMIC_BATCH_MAX;
+
+  thr->ts.dynamic_ws = ws;
+  thr->ts.dynamic_next = end;
+  thr->ts.dynamic_end = nend;
+  thr->ts.dynamic_batch = batch;
+}
+
 /* Similar, but doesn't require the lock held, and uses compare-and-swap
-   instead.  Note that the only memory value that changes is ws->next.  */
+   instead.  Note that the only memory value that changes is ws->next.
+
+   In large teams, each thread claims several chunks with one fetch-and-add
+   while enough of the loop is left, and runs them in order.  As the
+   chunks are consecutive, the schedule stays monotonic.  */
 
 bool
 gomp_iter_dynamic_next (long *pstart, long *pend)
@@ -193,29 +229,47 @@ gomp_iter_dynamic_next (long *pstart, long *pend)
 
   if (__builtin_expect (ws->mode, 1))
     {
-      long tmp = __sync_fetch_and_add (&ws->next, chunk);
+      long tmp, batch = 1;
+
+      if (thr->ts.dynamic_ws == ws)
+	{
+	  /* Run the chunks claimed ahead first.  */
+	  if (thr->ts.dynamic_next != thr->ts.dynamic_end)
+	    {
+	      gomp_iter_dynamic_batch (thr, ws, thr->ts.dynamic_next,
+				       thr->ts.dynamic_end, pstart, pend);
+	      return true;
+	    }
+	  batch = thr->ts.dynamic_batch;
+	}
+
+      tmp = __sync_fetch_and_add (&ws->next, batch * chunk);
       if (incr > 0)
 	{
 	  if (tmp >= end)
 	    return false;
-	  nend = tmp + chunk;
+	  nend = tmp + batch * chunk;
 	  if (nend > end)
 	    nend = end;
-	  *pstart = tmp;
-	  *pend = nend;
-	  return true;
 	}
       else
 	{
 	  if (tmp <= end)
 	    return false;
-	  nend = tmp + chunk;
+	  nend = tmp + batch * chunk;
 	  if (nend < end)
 	    nend = end;
+	}
+
+      if (thr->ts.team != NULL
+	  && thr->ts.team->nthreads >= GOMP_DYNAMIC_BATCH_THREADS)
+	gomp_iter_dynamic_batch (thr, ws, tmp, nend, pstart, pend);
+      else
+	{
 	  *pstart = tmp;
 	  *pend = nend;
-	  return true;
 	}
+      return true;
     }
 
   start = __atomic_load_n (&ws->next, MEMMODEL_RELAXED);
@@ -45,6 +45,7 @@
 #include <stdint.h>
 #include "libgomp-plugin.h"
 #include "gomp-constants.h"
+#include "omp-tools.h"
 
 #ifdef HAVE_PTHREAD_H
 #include <pthread.h>
@@ -260,6 +261,14 @@ struct gomp_doacross_work_share
   unsigned int shift_counts[];
 };
 
+/* Threads of teams of at least GOMP_DYNAMIC_BATCH_THREADS claim up to
+   GOMP_DYNAMIC_BATCH_MAX chunks of a dynamically scheduled loop at once,
+   as long as each thread has GOMP_DYNAMIC_BATCH_SPREAD such batches left
+   to run, so that small chunks don't all contend for the NEXT counter.  */
+#define GOMP_DYNAMIC_BATCH_THREADS 8
+#define GOMP_DYNAMIC_BATCH_MAX 8
+#define GOMP_DYNAMIC_BATCH_SPREAD 4
+
 /* Like struct gomp_work_share, but only the 1st cacheline of it plus
    flexible array at the end.
    Keep in sync with struct gomp_work_share.  */
@@ -441,6 +450,14 @@ struct gomp_team_state
 #ifdef HAVE_SYNC_BUILTINS
   /* Number of single stmts encountered.  */
   unsigned long single_count;
+
+  /* For dynamically scheduled loops, the chunks of DYNAMIC_WS this thread
+     claimed ahead and has not run yet, from DYNAMIC_NEXT to DYNAMIC_END,
+     and how many chunks it claims the next time.  */
+  struct gomp_work_share *dynamic_ws;
+  long dynamic_next;
+  long dynamic_end;
+  long dynamic_batch;
 #endif
 
   /* For GFS_RUNTIME loops that resolved to GFS_STATIC, this is the
@@ -595,6 +612,8 @@ extern bool gomp_cancel_var;
 extern enum gomp_target_offload_t gomp_target_offload_var;
 extern int gomp_max_task_priority_var;
 extern unsigned long long gomp_spin_count_var, gomp_throttled_spin_count_var;
+extern bool gomp_spin_adaptive_var;
+extern bool gomp_taskloop_adaptive_var;
 extern unsigned long gomp_available_cpus, gomp_managed_threads;
 extern unsigned long *gomp_nthreads_var_list, gomp_nthreads_var_list_len;
 extern char *gomp_bind_var_list;
@@ -720,6 +739,11 @@ struct gomp_task
      block further execution of their parent until the dependencies
      are satisfied.  */
   bool parent_depends_on;
+  /* Size class of the per-thread task cache this descriptor can be
+     returned to, or GOMP_TASK_CACHE_CLASSES if it can only be freed.  */
+  unsigned char alloc_class;
+  /* Data of an attached OMPT tool for this task.  */
+  ompt_data_t ompt_data;
   /* Dependencies provided and/or needed for this task.  DEPEND_COUNT
      is the number of items available.  */
   struct gomp_task_depend_entry depend[];
@@ -827,6 +851,9 @@ struct gomp_team
   /* This barrier is used for most synchronization of the team.  */
   gomp_barrier_t barrier;
 
+  /* Data of an attached OMPT tool for the parallel region.  */
+  ompt_data_t ompt_data;
+
   /* Initial work shares, to avoid allocating any gomp_work_share
      structs in the common case.  */
   struct gomp_work_share work_shares[8];
@@ -856,6 +883,20 @@ struct gomp_team
   struct gomp_task implicit_task[];
 };
 
+/* Deferred task descriptors are allocated in a few size classes, and
+   each thread keeps up to GOMP_TASK_CACHE_MAX of the descriptors it
+   freed in each class for its next tasks.  */
+
+#define GOMP_TASK_CACHE_CLASSES 3
+#define GOMP_TASK_CACHE_MAX 64
+
+struct gomp_task_cache
+{
+  /* Free descriptors, chained through their parent field.  */
+  struct gomp_task *free_list;
+  unsigned count;
+};
+
 /* This structure contains all data that is private to libgomp and is
    allocated per thread.  */
 
@@ -882,12 +923,25 @@ struct gomp_thread
   /* User pthread thread pool */
   struct gomp_thread_pool *thread_pool;
 
+  /* Data of an attached OMPT tool for this thread, and for the implicit
+     parallel region and task it runs in when outside of any team.  */
+  ompt_data_t ompt_thread_data;
+  ompt_data_t ompt_parallel_data;
+  ompt_data_t ompt_task_data;
+
 #ifdef LIBGOMP_USE_PTHREADS
   /* omp_get_num_teams () - 1.  */
   unsigned int num_teams;
 
   /* omp_get_team_num ().  */
   unsigned int team_num;
+
+  /* Free task descriptors, see gomp_alloc_task.  */
+  struct gomp_task_cache task_cache[GOMP_TASK_CACHE_CLASSES];
+
+  /* Spin count used by this thread with GOMP_SPINCOUNT_ADAPTIVE, or zero
+     until it first waits.  */
+  unsigned long long spin_budget;
 #endif
 
 #if defined(LIBGOMP_USE_PTHREADS) \
@@ -1094,6 +1148,9 @@ extern unsigned gomp_dynamic_max_threads (void);
 extern void gomp_init_task (struct gomp_task *, struct gomp_task *,
 			    struct gomp_task_icv *);
 extern void gomp_end_task (void);
+extern struct gomp_task *gomp_alloc_task (size_t);
+extern void gomp_free_task (struct gomp_task *);
+extern void gomp_free_task_cache (struct gomp_thread *);
 extern void gomp_barrier_handle_tasks (gomp_barrier_state_t);
 extern void gomp_task_maybe_wait_for_dependencies (void **);
 extern bool gomp_create_target_task (struct gomp_device_descr *,
@@ -29,6 +29,7 @@
 
 #include <string.h>
 #include "libgomp.h"
+#include "ompt-int.h"
 
 /* The internal gomp_mutex_t and the external non-recursive omp_lock_t
    have the same form.  Re-use it.  */
@@ -48,13 +49,16 @@ gomp_destroy_lock_30 (omp_lock_t *lock)
 void
 gomp_set_lock_30 (omp_lock_t *lock)
 {
+  gomp_ompt_mutex_acquire (ompt_mutex_lock, lock);
   gomp_mutex_lock (lock);
+  gomp_ompt_mutex_acquired (ompt_mutex_lock, lock);
 }
 
 void
 gomp_unset_lock_30 (omp_lock_t *lock)
 {
   gomp_mutex_unlock (lock);
+  gomp_ompt_mutex_released (ompt_mutex_lock, lock);
 }
 
 int
@@ -62,8 +66,13 @@ gomp_test_lock_30 (omp_lock_t *lock)
 {
   int oldval = 0;
 
-  return __atomic_compare_exchange_n (lock, &oldval, 1, false,
-				      MEMMODEL_ACQUIRE, MEMMODEL_RELAXED);
+  gomp_ompt_mutex_acquire (ompt_mutex_test_lock, lock);
+  if (!__atomic_compare_exchange_n (lock, &oldval, 1, false,
+				    MEMMODEL_ACQUIRE, MEMMODEL_RELAXED))
+    return 0;
+
+  gomp_ompt_mutex_acquired (ompt_mutex_test_lock, lock);
+  return 1;
 }
 
 void
@@ -84,8 +93,10 @@ gomp_set_nest_lock_30 (omp_nest_lock_t *lock)
 
   if (lock->owner != me)
     {
+      gomp_ompt_mutex_acquire (ompt_mutex_nest_lock, lock);
       gomp_mutex_lock (&lock->lock);
       lock->owner = me;
+      gomp_ompt_mutex_acquired (ompt_mutex_nest_lock, lock);
     }
 
   lock->count++;
@@ -98,6 +109,7 @@ gomp_unset_nest_lock_30 (omp_nest_lock_t *lock)
     {
       lock->owner = NULL;
       gomp_mutex_unlock (&lock->lock);
+      gomp_ompt_mutex_released (ompt_mutex_nest_lock, lock);
     }
 }
 
@@ -111,13 +123,33 @@ gomp_test_nest_lock_30 (omp_nest_lock_t *lock)
     return ++lock->count;
 
   oldval = 0;
+  gomp_ompt_mutex_acquire (ompt_mutex_test_nest_lock, lock);
   if (__atomic_compare_exchange_n (&lock->lock, &oldval, 1, false,
 				   MEMMODEL_ACQUIRE, MEMMODEL_RELAXED))
     {
       lock->owner = me;
       lock->count = 1;
+      gomp_ompt_mutex_acquired (ompt_mutex_test_nest_lock, lock);
       return 1;
     }
 
   return 0;
 }
+
+/* Synchronization hints can't change what a lock does, and there is
+   only one kind of lock to choose from here, so the OpenMP 4.5 hinted
+   initializers set up the same lock as the plain ones.  */
+
+void
+omp_init_lock_with_hint (omp_lock_t *lock,
+			 omp_sync_hint_t hint __attribute__((unused)))
+{
+  gomp_init_lock_30 (lock);
+}
+
+void
+omp_init_nest_lock_with_hint (omp_nest_lock_t *lock,
+			      omp_sync_hint_t hint __attribute__((unused)))
+{
+  gomp_init_nest_lock_30 (lock);
+}
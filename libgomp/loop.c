@@ -59,6 +59,9 @@ gomp_loop_init (struct gomp_work_share *ws, long start, long end, long incr,
 	struct gomp_team *team = thr->ts.team;
 	long nthreads = team ? team->nthreads : 1;
 
+	/* Each thread may claim up to GOMP_DYNAMIC_BATCH_MAX chunks past
+	   the end.  */
+	nthreads *= GOMP_DYNAMIC_BATCH_MAX;
 	if (__builtin_expect (incr > 0, 1))
 	  {
 	    /* Cheap overflow protection.  */
@@ -0,0 +1,198 @@
+/* OpenMP Tools Interface (OMPT) internals
+
+   Copyright (C) 2022 Free Software Foundation, Inc.
+
+   This file is part of the GNU Offloading and Multi Processing Library
+   (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file contains the callbacks registered by an OMPT tool and the
+   helpers the runtime uses to dispatch them.  Each helper loads the
+   callback pointer once and calls out only if it is set, so that the
+   (very common) case of no tool being attached costs a single predicted
+   branch.  */
+
+#ifndef OMPT_INT_H
+#define OMPT_INT_H 1
+
+#include "omp-tools.h"
+
+#ifdef HAVE_ATTRIBUTE_VISIBILITY
+# pragma GCC visibility push(hidden)
+#endif
+
+struct gomp_ompt_callbacks
+{
+  ompt_callback_thread_begin_t thread_begin;
+  ompt_callback_thread_end_t thread_end;
+  ompt_callback_parallel_begin_t parallel_begin;
+  ompt_callback_parallel_end_t parallel_end;
+  ompt_callback_implicit_task_t implicit_task;
+  ompt_callback_task_create_t task_create;
+  ompt_callback_task_schedule_t task_schedule;
+  ompt_callback_sync_region_t sync_region_wait;
+  ompt_callback_mutex_acquire_t mutex_acquire;
+  ompt_callback_mutex_t mutex_acquired;
+  ompt_callback_mutex_t mutex_released;
+};
+
+extern struct gomp_ompt_callbacks gomp_ompt_callbacks;
+
+extern void gomp_ompt_initialize (void);
+
+#define GOMP_OMPT_CALLBACK(event) \
+  __atomic_load_n (&gomp_ompt_callbacks.event, MEMMODEL_RELAXED)
+
+/* The tool data of the parallel region and task THR is executing.  */
+
+static inline ompt_data_t *
+gomp_ompt_parallel_data (struct gomp_thread *thr)
+{
+  return thr->ts.team ? &thr->ts.team->ompt_data : &thr->ompt_parallel_data;
+}
+
+static inline ompt_data_t *
+gomp_ompt_task_data (struct gomp_thread *thr)
+{
+  return thr->task ? &thr->task->ompt_data : &thr->ompt_task_data;
+}
+
+static inline void
+gomp_ompt_thread_begin (struct gomp_thread *thr, ompt_thread_t type)
+{
+  ompt_callback_thread_begin_t cb = GOMP_OMPT_CALLBACK (thread_begin);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (type, &thr->ompt_thread_data);
+}
+
+static inline void
+gomp_ompt_thread_end (struct gomp_thread *thr)
+{
+  ompt_callback_thread_end_t cb = GOMP_OMPT_CALLBACK (thread_end);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (&thr->ompt_thread_data);
+}
+
+/* THR starts or ends TEAM's parallel region, as its master thread.  */
+
+static inline void
+gomp_ompt_parallel_begin (struct gomp_thread *thr, struct gomp_team *team,
+			  unsigned nthreads)
+{
+  ompt_callback_parallel_begin_t cb = GOMP_OMPT_CALLBACK (parallel_begin);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (gomp_ompt_task_data (thr), NULL, &team->ompt_data, nthreads,
+	ompt_parallel_invoker_runtime | ompt_parallel_team, NULL);
+}
+
+static inline void
+gomp_ompt_parallel_end (struct gomp_thread *thr, struct gomp_team *team)
+{
+  ompt_callback_parallel_end_t cb = GOMP_OMPT_CALLBACK (parallel_end);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (&team->ompt_data, gomp_ompt_task_data (thr),
+	ompt_parallel_invoker_runtime | ompt_parallel_team, NULL);
+}
+
+/* THR starts or finishes its implicit task in its current team.  */
+
+static inline void
+gomp_ompt_implicit_task (struct gomp_thread *thr,
+			 ompt_scope_endpoint_t endpoint)
+{
+  ompt_callback_implicit_task_t cb = GOMP_OMPT_CALLBACK (implicit_task);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (endpoint, &thr->ts.team->ompt_data, &thr->task->ompt_data,
+	thr->ts.team->nthreads, thr->ts.team_id, ompt_task_implicit);
+}
+
+/* The current thread creates TASK, with ompt_task_flag_t FLAGS.  */
+
+static inline void
+gomp_ompt_task_create (struct gomp_task *task, int flags, bool depend)
+{
+  ompt_callback_task_create_t cb = GOMP_OMPT_CALLBACK (task_create);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (gomp_ompt_task_data (gomp_thread ()), NULL, &task->ompt_data,
+	flags, depend, NULL);
+}
+
+/* The current thread switches from PRIOR to NEXT; either may be NULL for
+   the implicit task of a thread outside of any team.  */
+
+static inline void
+gomp_ompt_task_schedule (struct gomp_task *prior, ompt_task_status_t status,
+			 struct gomp_task *next)
+{
+  ompt_callback_task_schedule_t cb = GOMP_OMPT_CALLBACK (task_schedule);
+  if (__builtin_expect (cb != NULL, 0))
+    {
+      struct gomp_thread *thr = gomp_thread ();
+      cb (prior ? &prior->ompt_data : &thr->ompt_task_data, status,
+	  next ? &next->ompt_data : &thr->ompt_task_data);
+    }
+}
+
+static inline void
+gomp_ompt_sync_region_wait (ompt_sync_region_t kind,
+			    ompt_scope_endpoint_t endpoint)
+{
+  ompt_callback_sync_region_t cb = GOMP_OMPT_CALLBACK (sync_region_wait);
+  if (__builtin_expect (cb != NULL, 0))
+    {
+      struct gomp_thread *thr = gomp_thread ();
+      cb (kind, endpoint, gomp_ompt_parallel_data (thr),
+	  gomp_ompt_task_data (thr), NULL);
+    }
+}
+
+/* Waiting for, getting and releasing the mutex at ADDR, which is used to
+   identify it.  */
+
+static inline void
+gomp_ompt_mutex_acquire (ompt_mutex_t kind, void *addr)
+{
+  ompt_callback_mutex_acquire_t cb = GOMP_OMPT_CALLBACK (mutex_acquire);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (kind, 0, 0, (ompt_wait_id_t) (uintptr_t) addr, NULL);
+}
+
+static inline void
+gomp_ompt_mutex_acquired (ompt_mutex_t kind, void *addr)
+{
+  ompt_callback_mutex_t cb = GOMP_OMPT_CALLBACK (mutex_acquired);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (kind, (ompt_wait_id_t) (uintptr_t) addr, NULL);
+}
+
+static inline void
+gomp_ompt_mutex_released (ompt_mutex_t kind, void *addr)
+{
+  ompt_callback_mutex_t cb = GOMP_OMPT_CALLBACK (mutex_released);
+  if (__builtin_expect (cb != NULL, 0))
+    cb (kind, (ompt_wait_id_t) (uintptr_t) addr, NULL);
+}
+
+#ifdef HAVE_ATTRIBUTE_VISIBILITY
+# pragma GCC visibility pop
+#endif
+
+#endif /* OMPT_INT_H */
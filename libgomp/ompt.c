@@ -0,0 +1,267 @@
+/* OpenMP Tools Interface (OMPT)
+
+   Copyright (C) 2022 Free Software Foundation, Inc.
+
+   This file is part of the GNU Offloading and Multi Processing Library
+   (libgomp).
+
+   Libgomp is free software; you can redistribute it and/or modify it
+   under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 3, or (at your option)
+   any later version.
+
+   Libgomp is distributed in the hope that it will be useful, but WITHOUT ANY
+   WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS
+   FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+   more details.
+
+   Under Section 7 of GPL version 3, you are granted additional
+   permissions described in the GCC Runtime Library Exception, version
+   3.1, as published by the Free Software Foundation.
+
+   You should have received a copy of the GNU General Public License and
+   a copy of the GCC Runtime Library Exception along with this program;
+   see the files COPYING3 and COPYING.RUNTIME respectively.  If not, see
+   <http://www.gnu.org/licenses/>.  */
+
+/* This file implements the OpenMP Tools Interface: finding and starting a
+   tool, and the entry points it uses to register its callbacks.  */
+
+#define _GNU_SOURCE
+#include "libgomp.h"
+#include "ompt-int.h"
+#include "secure_getenv.h"
+#include <string.h>
+#ifdef PLUGIN_SUPPORT
+# include <dlfcn.h>
+#endif
+
+/* Value of _OPENMP passed to the tool.  */
+#define GOMP_OMPT_OMP_VERSION 201511
+
+struct gomp_ompt_callbacks gomp_ompt_callbacks;
+
+#ifndef LIBGOMP_OFFLOADED_ONLY
+
+/* The tool whose initializer accepted, to be finalized at exit.  */
+static ompt_start_tool_result_t *gomp_ompt_tool;
+
+static ompt_set_result_t
+gomp_ompt_set_callback (ompt_callbacks_t event, ompt_callback_t callback)
+{
+  gomp_debug (0, "%s: event=%d, callback=%p\n",
+	      __FUNCTION__, (int) event, (void *) callback);
+
+#define SET_CALLBACK(EVENT, TYPE, RESULT)				\
+    case ompt_callback_##EVENT:						\
+      __atomic_store_n (&gomp_ompt_callbacks.EVENT, (TYPE) callback,	\
+			MEMMODEL_RELAXED);				\
+      return RESULT
+
+  switch (event)
+    {
+      SET_CALLBACK (thread_begin, ompt_callback_thread_begin_t,
+		    ompt_set_always);
+      SET_CALLBACK (thread_end, ompt_callback_thread_end_t, ompt_set_always);
+      SET_CALLBACK (parallel_begin, ompt_callback_parallel_begin_t,
+		    ompt_set_always);
+      SET_CALLBACK (parallel_end, ompt_callback_parallel_end_t,
+		    ompt_set_always);
+      SET_CALLBACK (implicit_task, ompt_callback_implicit_task_t,
+		    ompt_set_always);
+      /* Undeferred taskloop tasks and target tasks are not reported.  */
+      SET_CALLBACK (task_create, ompt_callback_task_create_t,
+		    ompt_set_sometimes);
+      SET_CALLBACK (task_schedule, ompt_callback_task_schedule_t,
+		    ompt_set_sometimes);
+      /* Only barriers and taskwait are reported.  */
+      SET_CALLBACK (sync_region_wait, ompt_callback_sync_region_t,
+		    ompt_set_sometimes);
+      /* Only locks and critical regions are reported.  */
+      SET_CALLBACK (mutex_acquire, ompt_callback_mutex_acquire_t,
+		    ompt_set_sometimes);
+      SET_CALLBACK (mutex_acquired, ompt_callback_mutex_t,
+		    ompt_set_sometimes);
+      SET_CALLBACK (mutex_released, ompt_callback_mutex_t,
+		    ompt_set_sometimes);
+    default:
+      return ompt_set_never;
+    }
+
+#undef SET_CALLBACK
+}
+
+static int
+gomp_ompt_get_callback (ompt_callbacks_t event, ompt_callback_t *callback)
+{
+  ompt_callback_t cb;
+
+#define GET_CALLBACK(EVENT)						\
+    case ompt_callback_##EVENT:						\
+      cb = (ompt_callback_t) GOMP_OMPT_CALLBACK (EVENT);		\
+      break
+
+  switch (event)
+    {
+      GET_CALLBACK (thread_begin);
+      GET_CALLBACK (thread_end);
+      GET_CALLBACK (parallel_begin);
+      GET_CALLBACK (parallel_end);
+      GET_CALLBACK (implicit_task);
+      GET_CALLBACK (task_create);
+      GET_CALLBACK (task_schedule);
+      GET_CALLBACK (sync_region_wait);
+      GET_CALLBACK (mutex_acquire);
+      GET_CALLBACK (mutex_acquired);
+      GET_CALLBACK (mutex_released);
+    default:
+      return 0;
+    }
+
+#undef GET_CALLBACK
+
+  if (cb == NULL)
+    return 0;
+  *callback = cb;
+  return 1;
+}
+
+static ompt_data_t *
+gomp_ompt_get_thread_data (void)
+{
+  return &gomp_thread ()->ompt_thread_data;
+}
+
+static int
+gomp_ompt_get_num_procs (void)
+{
+  return gomp_available_cpus;
+}
+
+static ompt_interface_fn_t
+gomp_ompt_lookup (const char *name)
+{
+  static const struct
+  {
+    const char *name;
+    ompt_interface_fn_t fn;
+  } entry_points[] = {
+    { "ompt_set_callback", (ompt_interface_fn_t) gomp_ompt_set_callback },
+    { "ompt_get_callback", (ompt_interface_fn_t) gomp_ompt_get_callback },
+    { "ompt_get_thread_data",
+      (ompt_interface_fn_t) gomp_ompt_get_thread_data },
+    { "ompt_get_num_procs", (ompt_interface_fn_t) gomp_ompt_get_num_procs },
+  };
+
+  for (size_t i = 0; i < sizeof (entry_points) / sizeof (entry_points[0]); i++)
+    if (strcmp (name, entry_points[i].name) == 0)
+      return entry_points[i].fn;
+
+  gomp_debug (0, "%s: unknown entry point \"%s\"\n", __FUNCTION__, name);
+  return NULL;
+}
+
+#ifdef PLUGIN_SUPPORT
+/* Call ompt_start_tool in HANDLE, or in the program and the libraries it
+   already loaded if HANDLE is RTLD_DEFAULT.  */
+
+static ompt_start_tool_result_t *
+gomp_ompt_start_tool (void *handle)
+{
+  typeof (&ompt_start_tool) start_tool = dlsym (handle, "ompt_start_tool");
+  if (start_tool == NULL)
+    return NULL;
+
+  return start_tool (GOMP_OMPT_OMP_VERSION, PACKAGE_STRING);
+}
+
+/* Try each library of the colon-separated LIBS in turn until one of them
+   provides a tool.  */
+
+static ompt_start_tool_result_t *
+gomp_ompt_load_tool (const char *libs)
+{
+  while (libs != NULL && libs[0] != '\0')
+    {
+      const char *sep = strchr (libs, ':');
+      size_t len = sep ? (size_t) (sep - libs) : strlen (libs);
+
+      /* Skip empty entries, which would dlopen the main program.  */
+      if (len != 0)
+	{
+	  char *lib = gomp_malloc (len + 1);
+	  memcpy (lib, libs, len);
+	  lib[len] = '\0';
+
+	  gomp_debug (0, "%s: dlopen (\"%s\")\n", __FUNCTION__, lib);
+	  void *handle = dlopen (lib, RTLD_LAZY);
+	  if (handle != NULL)
+	    {
+	      ompt_start_tool_result_t *result = gomp_ompt_start_tool (handle);
+	      if (result != NULL)
+		{
+		  free (lib);
+		  return result;
+		}
+	      dlclose (handle);
+	    }
+	  else
+	    gomp_error ("while loading OMP_TOOL_LIBRARIES \"%s\": %s",
+			lib, dlerror ());
+	  free (lib);
+	}
+
+      libs = sep ? sep + 1 : NULL;
+    }
+
+  return NULL;
+}
+#endif /* PLUGIN_SUPPORT */
+
+/* Find and initialize a tool, as directed by OMP_TOOL and
+   OMP_TOOL_LIBRARIES.  Without one, all callbacks stay unset.  */
+
+void
+gomp_ompt_initialize (void)
+{
+  ompt_start_tool_result_t *result = NULL;
+
+  const char *tool = secure_getenv ("OMP_TOOL");
+  if (tool != NULL && strcmp (tool, "disabled") == 0)
+    return;
+
+#ifdef PLUGIN_SUPPORT
+  result = gomp_ompt_start_tool (RTLD_DEFAULT);
+  if (result == NULL)
+    result = gomp_ompt_load_tool (secure_getenv ("OMP_TOOL_LIBRARIES"));
+#endif
+
+  if (result == NULL)
+    return;
+
+  if (result->initialize == NULL
+      || !result->initialize (gomp_ompt_lookup, omp_initial_device,
+			      &result->tool_data))
+    {
+      /* The tool declined; drop whatever it registered.  */
+      memset (&gomp_ompt_callbacks, 0, sizeof (gomp_ompt_callbacks));
+      return;
+    }
+
+  gomp_ompt_tool = result;
+  gomp_ompt_thread_begin (gomp_thread (), ompt_thread_initial);
+}
+
+static void __attribute__((destructor))
+gomp_ompt_finalize (void)
+{
+  if (gomp_ompt_tool == NULL)
+    return;
+
+  gomp_ompt_thread_end (gomp_thread ());
+  if (gomp_ompt_tool->finalize)
+    gomp_ompt_tool->finalize (&gomp_ompt_tool->tool_data);
+  memset (&gomp_ompt_callbacks, 0, sizeof (gomp_ompt_callbacks));
+  gomp_ompt_tool = NULL;
+}
+#endif /* LIBGOMP_OFFLOADED_ONLY */
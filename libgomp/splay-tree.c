@@ -199,18 +199,39 @@ splay_tree_remove (splay_tree sp, splay_tree_key key)
     }
 }
 
+/* Lookups that get no deeper than this many nodes leave the tree as it
+   is.  */
+#ifndef SPLAY_TREE_LOOKUP_SPLAY_DEPTH
+#define SPLAY_TREE_LOOKUP_SPLAY_DEPTH 8
+#endif
+
 /* Lookup KEY in SP, returning NODE if present, and NULL
-   otherwise.  */
+   otherwise.
+
+   The tree is only splayed when KEY is deep in it.  Lookups of the nodes
+   near the root, which are the recently inserted or used ones, then don't
+   write to the tree at all, so that the nodes stay in the caches of all
+   the threads looking them up.  */
 
 attribute_hidden splay_tree_key
 splay_tree_lookup (splay_tree sp, splay_tree_key key)
 {
-  splay_tree_splay (sp, key);
+  splay_tree_node n = sp->root;
+  unsigned depth = 0;
 
-  if (sp->root && splay_compare (&sp->root->key, key) == 0)
-    return &sp->root->key;
-  else
-    return NULL;
+  while (n)
+    {
+      int cmp = splay_compare (key, &n->key);
+      if (cmp == 0)
+	break;
+      n = cmp < 0 ? n->left : n->right;
+      depth++;
+    }
+
+  if (depth > SPLAY_TREE_LOOKUP_SPLAY_DEPTH)
+    splay_tree_splay (sp, key);
+
+  return n ? &n->key : NULL;
 }
 
 /* Helper function for splay_tree_foreach.
@@ -982,7 +982,7 @@ gomp_map_vars_internal (struct gomp_device_descr *devicep,
       tgt_align = align;
       tgt_size = mapnum * sizeof (void *);
       cbuf.chunk_cnt = 1;
-      cbuf.use_cnt = 1 + (mapnum > 1);
+      cbuf.use_cnt = 1 + (mapnum > 1 && !aq);
       cbuf.chunks[0].start = 0;
       cbuf.chunks[0].end = tgt_size;
     }
@@ -1768,10 +1768,11 @@ gomp_map_vars_internal (struct gomp_device_descr *devicep,
 }
 
 static struct target_mem_desc *
-gomp_map_vars (struct gomp_device_descr *devicep, size_t mapnum,
-	       void **hostaddrs, void **devaddrs, size_t *sizes, void *kinds,
-	       bool short_mapkind, htab_t *refcount_set,
-	       enum gomp_map_vars_kind pragma_kind)
+gomp_map_vars_async (struct gomp_device_descr *devicep,
+		     struct goacc_asyncqueue *aq, size_t mapnum,
+		     void **hostaddrs, void **devaddrs, size_t *sizes,
+		     void *kinds, bool short_mapkind, htab_t *refcount_set,
+		     enum gomp_map_vars_kind pragma_kind)
 {
   /* This management of a local refcount_set is for convenience of callers
      who do not share a refcount_set over multiple map/unmap uses.  */
@@ -1783,7 +1784,7 @@ gomp_map_vars (struct gomp_device_descr *devicep, size_t mapnum,
     }
 
   struct target_mem_desc *tgt;
-  tgt = gomp_map_vars_internal (devicep, NULL, mapnum, hostaddrs, devaddrs,
+  tgt = gomp_map_vars_internal (devicep, aq, mapnum, hostaddrs, devaddrs,
 				sizes, kinds, short_mapkind, refcount_set,
 				pragma_kind);
   if (local_refcount_set)
@@ -1792,6 +1793,17 @@ gomp_map_vars (struct gomp_device_descr *devicep, size_t mapnum,
   return tgt;
 }
 
+static struct target_mem_desc *
+gomp_map_vars (struct gomp_device_descr *devicep, size_t mapnum,
+	       void **hostaddrs, void **devaddrs, size_t *sizes, void *kinds,
+	       bool short_mapkind, htab_t *refcount_set,
+	       enum gomp_map_vars_kind pragma_kind)
+{
+  return gomp_map_vars_async (devicep, NULL, mapnum, hostaddrs, devaddrs,
+			      sizes, kinds, short_mapkind, refcount_set,
+			      pragma_kind);
+}
+
 attribute_hidden struct target_mem_desc *
 goacc_map_vars (struct gomp_device_descr *devicep,
 		struct goacc_asyncqueue *aq, size_t mapnum,
@@ -1997,8 +2009,8 @@ gomp_unmap_vars_internal (struct target_mem_desc *tgt, bool do_copyfrom,
 }
 
 static void
-gomp_unmap_vars (struct target_mem_desc *tgt, bool do_copyfrom,
-		 htab_t *refcount_set)
+gomp_unmap_vars_async (struct target_mem_desc *tgt, bool do_copyfrom,
+		       htab_t *refcount_set, struct goacc_asyncqueue *aq)
 {
   /* This management of a local refcount_set is for convenience of callers
      who do not share a refcount_set over multiple map/unmap uses.  */
@@ -2009,12 +2021,19 @@ gomp_unmap_vars (struct target_mem_desc *tgt, bool do_copyfrom,
       refcount_set = &local_refcount_set;
     }
 
-  gomp_unmap_vars_internal (tgt, do_copyfrom, refcount_set, NULL);
+  gomp_unmap_vars_internal (tgt, do_copyfrom, refcount_set, aq);
 
   if (local_refcount_set)
     htab_free (local_refcount_set);
 }
 
+static void
+gomp_unmap_vars (struct target_mem_desc *tgt, bool do_copyfrom,
+		 htab_t *refcount_set)
+{
+  gomp_unmap_vars_async (tgt, do_copyfrom, refcount_set, NULL);
+}
+
 attribute_hidden void
 goacc_unmap_vars (struct target_mem_desc *tgt, bool do_copyfrom,
 		  struct goacc_asyncqueue *aq)
@@ -2821,6 +2840,7 @@ GOMP_target_ext (int device, void (*fn) (void *), size_t mapnum,
 	  thr->ts.last_work_share = NULL;
 #ifdef HAVE_SYNC_BUILTINS
 	  thr->ts.single_count = 0;
+	  thr->ts.dynamic_ws = NULL;
 #endif
 	  thr->ts.static_trip = 0;
 	  thr->task = &team->implicit_task[0];
@@ -3095,7 +3115,8 @@ GOMP_target_update_ext (int device, size_t mapnum, void **hostaddrs,
 }
 
 static void
-gomp_exit_data (struct gomp_device_descr *devicep, size_t mapnum,
+gomp_exit_data (struct gomp_device_descr *devicep,
+		struct goacc_asyncqueue *aq, size_t mapnum,
 		void **hostaddrs, size_t *sizes, unsigned short *kinds,
 		htab_t *refcount_set)
 {
@@ -3117,7 +3138,7 @@ gomp_exit_data (struct gomp_device_descr *devicep, size_t mapnum,
 	splay_tree_key n = splay_tree_lookup (&devicep->mem_map, &cur_node);
 
 	if (n)
-	  gomp_detach_pointer (devicep, NULL, n, (uintptr_t) hostaddrs[i],
+	  gomp_detach_pointer (devicep, aq, n, (uintptr_t) hostaddrs[i],
 			       false, NULL);
       }
 
@@ -3163,7 +3184,7 @@ gomp_exit_data (struct gomp_device_descr *devicep, size_t mapnum,
 		    {
 		      size_t i = (addr - k->host_start) / sizeof (void *);
 		      if (k->aux->attach_count[i] == 0)
-			gomp_copy_dev2host (devicep, NULL, (void *) addr,
+			gomp_copy_dev2host (devicep, aq, (void *) addr,
 					    (void *) (k->tgt->tgt_start
 						      + k->tgt_offset
 						      + addr - k->host_start),
@@ -3172,7 +3193,7 @@ gomp_exit_data (struct gomp_device_descr *devicep, size_t mapnum,
 		    }
 		}
 	      else
-		gomp_copy_dev2host (devicep, NULL, (void *) cur_node.host_start,
+		gomp_copy_dev2host (devicep, aq, (void *) cur_node.host_start,
 				    (void *) (k->tgt->tgt_start + k->tgt_offset
 					      + cur_node.host_start
 					      - k->host_start),
@@ -3203,7 +3224,10 @@ gomp_exit_data (struct gomp_device_descr *devicep, size_t mapnum,
     }
 
   for (int i = 0; i < nrmvars; i++)
-    gomp_remove_var (devicep, remove_vars[i]);
+    if (aq)
+      gomp_remove_var_async (devicep, remove_vars[i], aq);
+    else
+      gomp_remove_var (devicep, remove_vars[i]);
 
   gomp_mutex_unlock (&devicep->lock);
 }
@@ -3321,10 +3345,35 @@ GOMP_target_enter_exit_data (int device, size_t mapnum, void **hostaddrs,
 	gomp_map_vars (devicep, 1, &hostaddrs[i], NULL, &sizes[i], &kinds[i],
 		       true, &refcount_set, GOMP_MAP_VARS_ENTER_DATA);
   else
-    gomp_exit_data (devicep, mapnum, hostaddrs, sizes, kinds, &refcount_set);
+    gomp_exit_data (devicep, NULL, mapnum, hostaddrs, sizes, kinds,
+		    &refcount_set);
   htab_free (refcount_set);
 }
 
+/* Return an asynchronous queue to carry the data transfers of a target
+   task, or NULL if DEVICEP cannot queue them.  The copies are then issued
+   back to back without waiting for each one, and the host only waits once
+   for all of them in gomp_target_task_aq_wait.  */
+
+static struct goacc_asyncqueue *
+gomp_target_task_aq (struct gomp_device_descr *devicep)
+{
+  if (!(devicep->capabilities & GOMP_OFFLOAD_CAP_OPENACC_200))
+    return NULL;
+  return devicep->openacc.async.construct_func (devicep->target_id);
+}
+
+static void
+gomp_target_task_aq_wait (struct gomp_device_descr *devicep,
+			  struct goacc_asyncqueue *aq)
+{
+  if (aq == NULL)
+    return;
+  if (!devicep->openacc.async.synchronize_func (aq)
+      || !devicep->openacc.async.destruct_func (aq))
+    gomp_fatal ("error waiting for target task data transfers");
+}
+
 bool
 gomp_target_task_fn (void *data)
 {
@@ -3348,7 +3397,11 @@ gomp_target_task_fn (void *data)
       if (ttask->state == GOMP_TARGET_TASK_FINISHED)
 	{
 	  if (ttask->tgt)
-	    gomp_unmap_vars (ttask->tgt, true, NULL);
+	    {
+	      struct goacc_asyncqueue *aq = gomp_target_task_aq (devicep);
+	      gomp_unmap_vars_async (ttask->tgt, true, NULL, aq);
+	      gomp_target_task_aq_wait (devicep, aq);
+	    }
 	  return false;
 	}
 
@@ -3360,9 +3413,14 @@ gomp_target_task_fn (void *data)
 	}
       else
 	{
-	  ttask->tgt = gomp_map_vars (devicep, ttask->mapnum, ttask->hostaddrs,
-				      NULL, ttask->sizes, ttask->kinds, true,
-				      NULL, GOMP_MAP_VARS_TARGET);
+	  /* The plugins launch the kernel on a queue of their own, so the
+	     transfers have to be complete before async_run_func.  */
+	  struct goacc_asyncqueue *aq = gomp_target_task_aq (devicep);
+	  ttask->tgt = gomp_map_vars_async (devicep, aq, ttask->mapnum,
+					    ttask->hostaddrs, NULL,
+					    ttask->sizes, ttask->kinds, true,
+					    NULL, GOMP_MAP_VARS_TARGET);
+	  gomp_target_task_aq_wait (devicep, aq);
 	  actual_arguments = (void *) ttask->tgt->tgt_start;
 	}
       ttask->state = GOMP_TARGET_TASK_READY_TO_RUN;
@@ -3384,22 +3442,25 @@ gomp_target_task_fn (void *data)
   else
     {
       htab_t refcount_set = htab_create (ttask->mapnum);
+      struct goacc_asyncqueue *aq = gomp_target_task_aq (devicep);
       if ((ttask->flags & GOMP_TARGET_FLAG_EXIT_DATA) == 0)
 	for (i = 0; i < ttask->mapnum; i++)
 	  if ((ttask->kinds[i] & 0xff) == GOMP_MAP_STRUCT)
 	    {
-	      gomp_map_vars (devicep, ttask->sizes[i] + 1, &ttask->hostaddrs[i],
-			     NULL, &ttask->sizes[i], &ttask->kinds[i], true,
-			     &refcount_set, GOMP_MAP_VARS_ENTER_DATA);
+	      gomp_map_vars_async (devicep, aq, ttask->sizes[i] + 1,
+				   &ttask->hostaddrs[i], NULL,
+				   &ttask->sizes[i], &ttask->kinds[i], true,
+				   &refcount_set, GOMP_MAP_VARS_ENTER_DATA);
 	      i += ttask->sizes[i];
 	    }
 	  else
-	    gomp_map_vars (devicep, 1, &ttask->hostaddrs[i], NULL, &ttask->sizes[i],
-			   &ttask->kinds[i], true, &refcount_set,
-			   GOMP_MAP_VARS_ENTER_DATA);
+	    gomp_map_vars_async (devicep, aq, 1, &ttask->hostaddrs[i], NULL,
+				 &ttask->sizes[i], &ttask->kinds[i], true,
+				 &refcount_set, GOMP_MAP_VARS_ENTER_DATA);
       else
-	gomp_exit_data (devicep, ttask->mapnum, ttask->hostaddrs, ttask->sizes,
-			ttask->kinds, &refcount_set);
+	gomp_exit_data (devicep, aq, ttask->mapnum, ttask->hostaddrs,
+			ttask->sizes, ttask->kinds, &refcount_set);
+      gomp_target_task_aq_wait (devicep, aq);
       htab_free (refcount_set);
     }
   return false;
@@ -27,6 +27,7 @@
    creation and termination.  */
 
 #include "libgomp.h"
+#include "ompt-int.h"
 #include <stdlib.h>
 #include <string.h>
 #include <assert.h>
@@ -90,6 +91,7 @@ gomp_init_task (struct gomp_task *task, struct gomp_task *parent_task,
   task->final_task = false;
   task->copy_ctors_done = false;
   task->parent_depends_on = false;
+  task->ompt_data.value = 0;
 }
 
 /* Clean up a task, after completing it.  */
@@ -104,6 +106,88 @@ gomp_end_task (void)
   thr->task = task->parent;
 }
 
+/* Allocate a deferred task descriptor followed by SIZE bytes of depend
+   entries and arguments.  Small descriptors are rounded up to one of the
+   task cache size classes, and taken from the calling thread's cache
+   when it has one.  */
+
+struct gomp_task *
+gomp_alloc_task (size_t size)
+{
+  struct gomp_task *task;
+#ifdef LIBGOMP_USE_PTHREADS
+  unsigned int c;
+  for (c = 0; c < GOMP_TASK_CACHE_CLASSES; c++)
+    if (size <= (size_t) 64 << (2 * c))
+      break;
+
+  if (c < GOMP_TASK_CACHE_CLASSES)
+    {
+      struct gomp_task_cache *cache = &gomp_thread ()->task_cache[c];
+      task = cache->free_list;
+      if (task)
+	{
+	  cache->free_list = task->parent;
+	  cache->count--;
+	}
+      else
+	task = gomp_malloc (sizeof (*task) + ((size_t) 64 << (2 * c)));
+      task->alloc_class = c;
+      return task;
+    }
+#endif
+  task = gomp_malloc (sizeof (*task) + size);
+  task->alloc_class = GOMP_TASK_CACHE_CLASSES;
+  return task;
+}
+
+/* Free TASK, allocated by gomp_alloc_task, keeping it in the calling
+   thread's cache if there is room.  Descriptors are returned to the cache
+   of the thread that completed them, so that one is bounded too.  */
+
+void
+gomp_free_task (struct gomp_task *task)
+{
+#ifdef LIBGOMP_USE_PTHREADS
+  if (task->alloc_class < GOMP_TASK_CACHE_CLASSES)
+    {
+      struct gomp_task_cache *cache
+	= &gomp_thread ()->task_cache[task->alloc_class];
+      if (cache->count < GOMP_TASK_CACHE_MAX)
+	{
+	  task->parent = cache->free_list;
+	  cache->free_list = task;
+	  cache->count++;
+	  return;
+	}
+    }
+#endif
+  free (task);
+}
+
+/* Release the task descriptors cached by THR, before it exits.  */
+
+void
+gomp_free_task_cache (struct gomp_thread *thr)
+{
+#ifdef LIBGOMP_USE_PTHREADS
+  unsigned int c;
+  for (c = 0; c < GOMP_TASK_CACHE_CLASSES; c++)
+    {
+      struct gomp_task_cache *cache = &thr->task_cache[c];
+      while (cache->free_list)
+	{
+	  struct gomp_task *task = cache->free_list;
+	  cache->free_list = task->parent;
+	  free (task);
+	}
+      cache->count = 0;
+    }
+#else
+  (void) thr;
+#endif
+}
+
 /* Clear the parent field of every task in LIST.  */
 
 static inline void
@@ -467,6 +551,20 @@ empty_task (void *data __attribute__((unused)))
 {
 }
 
+/* The ompt_task_flag_t flags of an explicit task created with
+   GOMP_TASK_FLAG_* FLAGS.  */
+
+static inline int
+gomp_ompt_task_flags (unsigned flags)
+{
+  int ret = ompt_task_explicit;
+  if (flags & GOMP_TASK_FLAG_UNTIED)
+    ret |= ompt_task_untied;
+  if (flags & GOMP_TASK_FLAG_FINAL)
+    ret |= ompt_task_final;
+  return ret;
+}
+
 static void gomp_task_run_post_handle_depend_hash (struct gomp_task *);
 static inline size_t gomp_task_run_post_handle_depend (struct gomp_task *,
 						       struct gomp_team *);
@@ -571,6 +669,10 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	  task.in_tied_task = thr->task->in_tied_task;
 	  task.taskgroup = thr->task->taskgroup;
 	}
+      gomp_ompt_task_create (&task,
+			     gomp_ompt_task_flags (flags) | ompt_task_undeferred,
+			     (flags & GOMP_TASK_FLAG_DEPEND) != 0);
+      gomp_ompt_task_schedule (thr->task, ompt_task_switch, &task);
       thr->task = &task;
       if (__builtin_expect (cpyfn != NULL, 0))
 	{
@@ -588,6 +690,7 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	  gomp_sem_wait (&completion_sem);
 	  gomp_sem_destroy (&completion_sem);
 	}
+      gomp_ompt_task_schedule (&task, ompt_task_complete, task.parent);
 
       /* Access to "children" is normally done inside a task_lock
 	 mutex region, but the only way this particular task.children
@@ -618,8 +721,7 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       if (flags & GOMP_TASK_FLAG_DEPEND)
 	depend_size = ((uintptr_t) (depend[0] ? depend[0] : depend[1])
 		       * sizeof (struct gomp_task_depend_entry));
-      task = gomp_malloc (sizeof (*task) + depend_size
-			  + arg_size + arg_align - 1);
+      task = gomp_alloc_task (depend_size + arg_size + arg_align - 1);
       arg = (char *) (((uintptr_t) (task + 1) + depend_size + arg_align - 1)
 		      & ~(uintptr_t) (arg_align - 1));
       gomp_init_task (task, parent, gomp_icv (false));
@@ -651,6 +753,8 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
       task->fn = fn;
       task->fn_data = arg;
       task->final_task = (flags & GOMP_TASK_FLAG_FINAL) >> 1;
+      gomp_ompt_task_create (task, gomp_ompt_task_flags (flags),
+			     depend_size != 0);
       gomp_mutex_lock (&team->task_lock);
       /* If parallel or taskgroup has been cancelled, don't start new
 	 tasks.  */
@@ -662,7 +766,7 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	    do_cancel:
 	      gomp_mutex_unlock (&team->task_lock);
 	      gomp_finish_task (task);
-	      free (task);
+	      gomp_free_task (task);
 	      return;
 	    }
 	  if (taskgroup)
@@ -701,7 +805,7 @@ GOMP_task (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	      gomp_task_run_post_handle_depend_hash (task);
 	      gomp_mutex_unlock (&team->task_lock);
 	      gomp_finish_task (task);
-	      free (task);
+	      gomp_free_task (task);
 	      return;
 	    }
 	}
@@ -740,6 +844,34 @@ ialias (GOMP_taskgroup_start)
 ialias (GOMP_taskgroup_end)
 ialias (GOMP_taskgroup_reduction_register)
 
+/* The split of a taskloop with GOMP_TASKLOOP_ADAPTIVE: the iterations not
+   given to a task yet, and how they are shared out.  */
+
+struct gomp_taskloop_adaptive
+{
+  unsigned long long left;
+  unsigned long long min_chunk;
+  unsigned long div;
+};
+
+/* Take the iterations of the next task of an adaptive taskloop out of
+   A->left and return their number.  Each task gets 1/DIV of what is left,
+   so the first tasks are coarse and the last ones fine enough to even out
+   the load, but no less than MIN_CHUNK iterations so that the number of
+   tasks stays bounded.  */
+
+static inline unsigned long long
+gomp_taskloop_adaptive_take (struct gomp_taskloop_adaptive *a)
+{
+  unsigned long long chunk = a->left / a->div + (a->left % a->div != 0);
+  if (chunk < a->min_chunk)
+    chunk = a->min_chunk;
+  if (chunk > a->left)
+    chunk = a->left;
+  a->left -= chunk;
+  return chunk;
+}
+
 #define TYPE long
 #define UTYPE unsigned long
 #define TYPE_is_long 1
@@ -936,12 +1068,12 @@ gomp_create_target_task (struct gomp_device_descr *devicep,
 	}
     }
 
-  task = gomp_malloc (sizeof (*task) + depend_size
-		      + sizeof (*ttask)
-		      + args_cnt * sizeof (void *)
-		      + mapnum * (sizeof (void *) + sizeof (size_t)
-				  + sizeof (unsigned short))
-		      + tgt_size);
+  task = gomp_alloc_task (depend_size
+			  + sizeof (*ttask)
+			  + args_cnt * sizeof (void *)
+			  + mapnum * (sizeof (void *) + sizeof (size_t)
+				      + sizeof (unsigned short))
+			  + tgt_size);
   gomp_init_task (task, parent, gomp_icv (false));
   task->priority = 0;
   task->kind = GOMP_TASK_WAITING;
@@ -1000,7 +1132,7 @@ gomp_create_target_task (struct gomp_device_descr *devicep,
 	do_cancel:
 	  gomp_mutex_unlock (&team->task_lock);
 	  gomp_finish_task (task);
-	  free (task);
+	  gomp_free_task (task);
 	  return true;
 	}
       if (taskgroup)
@@ -1029,7 +1161,7 @@ gomp_create_target_task (struct gomp_device_descr *devicep,
       gomp_task_run_post_handle_depend_hash (task);
       gomp_mutex_unlock (&team->task_lock);
       gomp_finish_task (task);
-      free (task);
+      gomp_free_task (task);
       return false;
     }
   if (taskgroup)
@@ -1407,7 +1539,7 @@ gomp_task_run_post_handle_dependers (struct gomp_task *child_task,
 		}
 	    }
 	  gomp_finish_task (task);
-	  free (task);
+	  gomp_free_task (task);
 	  continue;
 	}
       if (parent)
@@ -1589,7 +1721,7 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 	      if (to_free)
 		{
 		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		  to_free = NULL;
 		}
 	      goto finish_cancelled;
@@ -1606,7 +1738,7 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 	  if (to_free)
 	    {
 	      gomp_finish_task (to_free);
-	      free (to_free);
+	      gomp_free_task (to_free);
 	    }
 	  return;
 	}
@@ -1619,7 +1751,7 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
       if (to_free)
 	{
 	  gomp_finish_task (to_free);
-	  free (to_free);
+	  gomp_free_task (to_free);
 	  to_free = NULL;
 	}
       if (child_task)
@@ -1647,7 +1779,14 @@ gomp_barrier_handle_tasks (gomp_barrier_state_t state)
 		}
 	    }
 	  else
-	    child_task->fn (child_task->fn_data);
+	    {
+	      gomp_ompt_task_schedule (task, ompt_task_switch, child_task);
+	      child_task->fn (child_task->fn_data);
+	      gomp_ompt_task_schedule (child_task,
+				       child_task->detach_team
+				       ? ompt_task_detach : ompt_task_complete,
+				       task);
+	    }
 	  thr->task = task;
 	}
       else
@@ -1729,7 +1868,7 @@ GOMP_taskwait (void)
 	  if (to_free)
 	    {
 	      gomp_finish_task (to_free);
-	      free (to_free);
+	      gomp_free_task (to_free);
 	    }
 	  if (destroy_taskwait)
 	    gomp_sem_destroy (&taskwait.taskwait_sem);
@@ -1748,7 +1887,7 @@ GOMP_taskwait (void)
 	      if (to_free)
 		{
 		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		  to_free = NULL;
 		}
 	      goto finish_cancelled;
@@ -1778,7 +1917,7 @@ GOMP_taskwait (void)
       if (to_free)
 	{
 	  gomp_finish_task (to_free);
-	  free (to_free);
+	  gomp_free_task (to_free);
 	  to_free = NULL;
 	}
       if (child_task)
@@ -1805,7 +1944,14 @@ GOMP_taskwait (void)
 		}
 	    }
 	  else
-	    child_task->fn (child_task->fn_data);
+	    {
+	      gomp_ompt_task_schedule (task, ompt_task_switch, child_task);
+	      child_task->fn (child_task->fn_data);
+	      gomp_ompt_task_schedule (child_task,
+				       child_task->detach_team
+				       ? ompt_task_detach : ompt_task_complete,
+				       task);
+	    }
 	  thr->task = task;
 	}
       else
@@ -2041,7 +2187,7 @@ gomp_task_maybe_wait_for_dependencies (void **depend)
 	  if (to_free)
 	    {
 	      gomp_finish_task (to_free);
-	      free (to_free);
+	      gomp_free_task (to_free);
 	    }
 	  gomp_sem_destroy (&taskwait.taskwait_sem);
 	  return;
@@ -2075,7 +2221,7 @@ gomp_task_maybe_wait_for_dependencies (void **depend)
 	      if (to_free)
 		{
 		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		  to_free = NULL;
 		}
 	      goto finish_cancelled;
@@ -2096,7 +2242,7 @@ gomp_task_maybe_wait_for_dependencies (void **depend)
       if (to_free)
 	{
 	  gomp_finish_task (to_free);
-	  free (to_free);
+	  gomp_free_task (to_free);
 	  to_free = NULL;
 	}
       if (child_task)
@@ -2123,7 +2269,14 @@ gomp_task_maybe_wait_for_dependencies (void **depend)
 		}
 	    }
 	  else
-	    child_task->fn (child_task->fn_data);
+	    {
+	      gomp_ompt_task_schedule (task, ompt_task_switch, child_task);
+	      child_task->fn (child_task->fn_data);
+	      gomp_ompt_task_schedule (child_task,
+				       child_task->detach_team
+				       ? ompt_task_detach : ompt_task_complete,
+				       task);
+	    }
 	  thr->task = task;
 	}
       else
@@ -2257,7 +2410,7 @@ GOMP_taskgroup_end (void)
 	      if (to_free)
 		{
 		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		}
 	      goto finish;
 	    }
@@ -2275,7 +2428,7 @@ GOMP_taskgroup_end (void)
 	      if (to_free)
 		{
 		  gomp_finish_task (to_free);
-		  free (to_free);
+		  gomp_free_task (to_free);
 		  to_free = NULL;
 		}
 	      goto finish_cancelled;
@@ -2300,7 +2453,7 @@ GOMP_taskgroup_end (void)
       if (to_free)
 	{
 	  gomp_finish_task (to_free);
-	  free (to_free);
+	  gomp_free_task (to_free);
 	  to_free = NULL;
 	}
       if (child_task)
@@ -2327,7 +2480,14 @@ GOMP_taskgroup_end (void)
 		}
 	    }
 	  else
-	    child_task->fn (child_task->fn_data);
+	    {
+	      gomp_ompt_task_schedule (task, ompt_task_switch, child_task);
+	      child_task->fn (child_task->fn_data);
+	      gomp_ompt_task_schedule (child_task,
+				       child_task->detach_team
+				       ? ompt_task_detach : ompt_task_complete,
+				       task);
+	    }
 	  thr->task = task;
 	}
       else
@@ -2473,6 +2633,7 @@ gomp_create_artificial_team (void)
   thr->ts.last_work_share = NULL;
 #ifdef HAVE_SYNC_BUILTINS
   thr->ts.single_count = 0;
+  thr->ts.dynamic_ws = NULL;
 #endif
   thr->ts.static_trip = 0;
   thr->task = &team->implicit_task[0];
@@ -2749,6 +2910,8 @@ omp_fulfill_event (omp_event_handle_t event)
   if (!shackled_thread_p)
     gomp_mutex_unlock (&team->task_lock);
 
+  /* This may run in a thread outside of the team, so don't keep the
+     descriptor in its cache.  */
   gomp_finish_task (task);
   free (task);
 }
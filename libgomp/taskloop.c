@@ -99,6 +99,7 @@ GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
   TYPE task_step = step;
   TYPE nfirst_task_step = step;
   unsigned long nfirst = n;
+  struct gomp_taskloop_adaptive adaptive = { 0, 0, 0 };
   if (flags & GOMP_TASK_FLAG_GRAINSIZE)
     {
       unsigned long grainsize = num_tasks;
@@ -158,6 +159,31 @@ GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	    }
 	}
     }
+  else if (num_tasks == 0
+	   && gomp_taskloop_adaptive_var
+	   && team
+	   && team->nthreads > 1
+	   && n > team->nthreads)
+    {
+      /* Without grainsize or num_tasks clauses the split is ours to choose:
+	 hand out shrinking chunks.  That keeps the number of tasks within a
+	 small multiple of the team size, but leaves fine tasks at the end
+	 for the threads that finish early.  */
+      adaptive.div = 2 * team->nthreads;
+      adaptive.min_chunk = n / (8ULL * team->nthreads);
+      if (adaptive.min_chunk == 0)
+	adaptive.min_chunk = 1;
+      adaptive.left = n;
+      num_tasks = 0;
+      while (adaptive.left)
+	{
+	  gomp_taskloop_adaptive_take (&adaptive);
+	  num_tasks++;
+	}
+      adaptive.left = n;
+      task_step = (TYPE) gomp_taskloop_adaptive_take (&adaptive) * step;
+      nfirst = num_tasks;
+    }
   else
     {
       if (num_tasks == 0)
@@ -245,6 +271,9 @@ GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	      ((TYPE *)arg)[1] = start;
 	      if (i == nfirst)
 		task_step = nfirst_task_step;
+	      else if (adaptive.left)
+		task_step
+		  = (TYPE) gomp_taskloop_adaptive_take (&adaptive) * step;
 	      fn (arg);
 	      arg += arg_size;
 	      if (!priority_queue_empty_p (&task[i].children_queue,
@@ -278,6 +307,8 @@ GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	    ((TYPE *)data)[1] = start;
 	    if (i == nfirst)
 	      task_step = nfirst_task_step;
+	    else if (adaptive.left)
+	      task_step = (TYPE) gomp_taskloop_adaptive_take (&adaptive) * step;
 	    fn (data);
 	    if (!priority_queue_empty_p (&task.children_queue,
 					 MEMMODEL_RELAXED))
@@ -300,8 +331,7 @@ GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 
       for (i = 0; i < num_tasks; i++)
 	{
-	  struct gomp_task *task
-	    = gomp_malloc (sizeof (*task) + arg_size + arg_align - 1);
+	  struct gomp_task *task = gomp_alloc_task (arg_size + arg_align - 1);
 	  tasks[i] = task;
 	  arg = (char *) (((uintptr_t) (task + 1) + arg_align - 1)
 			  & ~(uintptr_t) (arg_align - 1));
@@ -323,11 +353,14 @@ GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	  ((TYPE *)arg)[1] = start;
 	  if (i == nfirst)
 	    task_step = nfirst_task_step;
+	  else if (adaptive.left)
+	    task_step = (TYPE) gomp_taskloop_adaptive_take (&adaptive) * step;
 	  thr->task = parent;
 	  task->kind = GOMP_TASK_WAITING;
 	  task->fn = fn;
 	  task->fn_data = arg;
 	  task->final_task = (flags & GOMP_TASK_FLAG_FINAL) >> 1;
+	  gomp_ompt_task_create (task, gomp_ompt_task_flags (flags), 0);
 	}
       gomp_mutex_lock (&team->task_lock);
       /* If parallel or taskgroup has been cancelled, don't start new
@@ -342,7 +375,7 @@ GOMP_taskloop (void (*fn) (void *), void *data, void (*cpyfn) (void *, void *),
 	      for (i = 0; i < num_tasks; i++)
 		{
 		  gomp_finish_task (tasks[i]);
-		  free (tasks[i]);
+		  gomp_free_task (tasks[i]);
 		}
 	      if ((flags & GOMP_TASK_FLAG_NOGROUP) == 0)
 		ialias_call (GOMP_taskgroup_end) ();
@@ -27,6 +27,7 @@
    creation and termination.  */
 
 #include "libgomp.h"
+#include "ompt-int.h"
 #include "pool.h"
 #include <stdlib.h>
 #include <string.h>
@@ -82,6 +83,7 @@ gomp_thread_start (void *xdata)
   thr = &local_thr;
 #endif
   gomp_sem_init (&thr->release, 0);
+  memset (thr->task_cache, 0, sizeof (thr->task_cache));
 
   /* Extract what we need from data.  */
   local_fn = data->fn;
@@ -98,6 +100,7 @@ gomp_thread_start (void *xdata)
 #if !(defined HAVE_TLS || defined USE_EMUTLS)
   pthread_setspecific (gomp_tls_key, thr);
 #endif
+  gomp_ompt_thread_begin (thr, ompt_thread_worker);
 
   thr->ts.team->ordered_release[thr->ts.team_id] = &thr->release;
 
@@ -111,8 +114,14 @@ gomp_thread_start (void *xdata)
 
       gomp_barrier_wait (&team->barrier);
 
+      gomp_ompt_implicit_task (thr, ompt_scope_begin);
       local_fn (local_data);
+      gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_parallel,
+				  ompt_scope_begin);
       gomp_team_barrier_wait_final (&team->barrier);
+      gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_parallel,
+				  ompt_scope_end);
+      gomp_ompt_implicit_task (thr, ompt_scope_end);
       gomp_finish_task (task);
       gomp_barrier_wait_last (&team->barrier);
     }
@@ -126,8 +135,14 @@ gomp_thread_start (void *xdata)
 	  struct gomp_team *team = thr->ts.team;
 	  struct gomp_task *task = thr->task;
 
+	  gomp_ompt_implicit_task (thr, ompt_scope_begin);
 	  local_fn (local_data);
+	  gomp_ompt_sync_region_wait
+	    (ompt_sync_region_barrier_implicit_parallel, ompt_scope_begin);
 	  gomp_team_barrier_wait_final (&team->barrier);
+	  gomp_ompt_sync_region_wait
+	    (ompt_sync_region_barrier_implicit_parallel, ompt_scope_end);
+	  gomp_ompt_implicit_task (thr, ompt_scope_end);
 	  gomp_finish_task (task);
 
 	  gomp_simple_barrier_wait (&pool->threads_dock);
@@ -139,7 +154,9 @@ gomp_thread_start (void *xdata)
       while (local_fn);
     }
 
+  gomp_ompt_thread_end (thr);
   gomp_sem_destroy (&thr->release);
+  gomp_free_task_cache (thr);
   pthread_detach (pthread_self ());
   thr->thread_pool = NULL;
   thr->task = NULL;
@@ -188,6 +205,13 @@ gomp_new_team (unsigned nthreads)
       gomp_mutex_init (&team->work_share_list_free_lock);
 #endif
       gomp_barrier_init (&team->barrier, nthreads);
+#ifdef GOMP_BARRIER_MAX_GROUPS
+      /* When a nested team ends, its master arrives on the barrier with
+	 the team_id of the enclosing team, so only group the threads of
+	 non-nested teams.  */
+      if (gomp_thread ()->ts.team == NULL)
+	gomp_barrier_init_groups (&team->barrier, nthreads);
+#endif
       gomp_mutex_init (&team->task_lock);
 
       team->nthreads = nthreads;
@@ -244,7 +268,9 @@ gomp_free_pool_helper (void *thread_pool)
   struct gomp_thread_pool *pool
     = (struct gomp_thread_pool *) thread_pool;
   gomp_simple_barrier_wait_last (&pool->threads_dock);
+  gomp_ompt_thread_end (thr);
   gomp_sem_destroy (&thr->release);
+  gomp_free_task_cache (thr);
   thr->thread_pool = NULL;
   thr->task = NULL;
 #ifdef LIBGOMP_USE_PTHREADS
@@ -311,6 +337,7 @@ gomp_free_thread (void *arg __attribute__((unused)))
       gomp_end_task ();
       free (task);
     }
+  gomp_free_task_cache (thr);
 }
 
 /* Launch a team.  */
@@ -354,6 +381,9 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
      orphaned work share construct.  */
   team->prev_ts = thr->ts;
 
+  team->ompt_data.value = 0;
+  gomp_ompt_parallel_begin (thr, team, nthreads);
+
   thr->ts.team = team;
   thr->ts.team_id = 0;
   ++thr->ts.level;
@@ -363,6 +393,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   thr->ts.last_work_share = NULL;
 #ifdef HAVE_SYNC_BUILTINS
   thr->ts.single_count = 0;
+  thr->ts.dynamic_ws = NULL;
 #endif
   thr->ts.static_trip = 0;
   thr->task = &team->implicit_task[0];
@@ -384,6 +415,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
   thr->task->taskgroup = taskgroup;
   team->implicit_task[0].icv.nthreads_var = nthreads_var;
   team->implicit_task[0].icv.bind_var = bind_var;
+  gomp_ompt_implicit_task (thr, ompt_scope_begin);
 
   if (nthreads == 1)
     return;
@@ -652,6 +684,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
 	  nthr->ts.def_allocator = thr->ts.def_allocator;
 #ifdef HAVE_SYNC_BUILTINS
 	  nthr->ts.single_count = 0;
+	  nthr->ts.dynamic_ws = NULL;
 #endif
 	  nthr->ts.static_trip = 0;
 	  nthr->num_teams = thr->num_teams;
@@ -842,6 +875,7 @@ gomp_team_start (void (*fn) (void *), void *data, unsigned nthreads,
       start_data->ts.def_allocator = thr->ts.def_allocator;
 #ifdef HAVE_SYNC_BUILTINS
       start_data->ts.single_count = 0;
+      start_data->ts.dynamic_ws = NULL;
 #endif
       start_data->ts.static_trip = 0;
       start_data->num_teams = thr->num_teams;
@@ -953,7 +987,12 @@ gomp_team_end (void)
      As #pragma omp cancel parallel might get awaited count in
      team->barrier in a inconsistent state, we need to use a different
      counter here.  */
+  gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_parallel,
+			      ompt_scope_begin);
   gomp_team_barrier_wait_final (&team->barrier);
+  gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_parallel,
+			      ompt_scope_end);
+  gomp_ompt_implicit_task (thr, ompt_scope_end);
   if (__builtin_expect (team->team_cancelled, 0))
     {
       struct gomp_work_share *ws = team->work_shares_to_free;
@@ -972,6 +1011,7 @@ gomp_team_end (void)
 
   gomp_end_task ();
   thr->ts = team->prev_ts;
+  gomp_ompt_parallel_end (thr, team);
 
   if (__builtin_expect (thr->ts.level != 0, 0))
     {
@@ -1049,7 +1089,9 @@ gomp_pause_pool_helper (void *thread_pool)
   struct gomp_thread_pool *pool
     = (struct gomp_thread_pool *) thread_pool;
   gomp_simple_barrier_wait_last (&pool->threads_dock);
+  gomp_ompt_thread_end (thr);
   gomp_sem_destroy (&thr->release);
+  gomp_free_task_cache (thr);
   thr->thread_pool = NULL;
   thr->task = NULL;
   pthread_exit (NULL);
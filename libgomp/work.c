@@ -27,6 +27,7 @@
    of threads.  */
 
 #include "libgomp.h"
+#include "ompt-int.h"
 #include <stddef.h>
 #include <stdlib.h>
 #include <string.h>
@@ -190,6 +191,11 @@ gomp_work_share_start (size_t ordered)
   struct gomp_team *team = thr->ts.team;
   struct gomp_work_share *ws;
 
+#ifdef HAVE_SYNC_BUILTINS
+  /* Chunks claimed ahead belong to the previous construct.  */
+  thr->ts.dynamic_ws = NULL;
+#endif
+
   /* Work sharing constructs can be orphaned.  */
   if (team == NULL)
     {
@@ -240,6 +246,8 @@ gomp_work_share_end (void)
       return;
     }
 
+  gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_workshare,
+			      ompt_scope_begin);
   bstate = gomp_barrier_wait_start (&team->barrier);
 
   if (gomp_barrier_last_thread (bstate))
@@ -252,6 +260,8 @@ gomp_work_share_end (void)
     }
 
   gomp_team_barrier_wait_end (&team->barrier, bstate);
+  gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_workshare,
+			      ompt_scope_end);
   thr->ts.last_work_share = NULL;
 }
 
@@ -266,6 +276,8 @@ gomp_work_share_end_cancel (void)
   gomp_barrier_state_t bstate;
 
   /* Cancellable work sharing constructs cannot be orphaned.  */
+  gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_workshare,
+			      ompt_scope_begin);
   bstate = gomp_barrier_wait_cancel_start (&team->barrier);
 
   if (gomp_barrier_last_thread (bstate))
@@ -278,7 +290,10 @@ gomp_work_share_end_cancel (void)
     }
   thr->ts.last_work_share = NULL;
 
-  return gomp_team_barrier_wait_cancel_end (&team->barrier, bstate);
+  bool ret = gomp_team_barrier_wait_cancel_end (&team->barrier, bstate);
+  gomp_ompt_sync_region_wait (ompt_sync_region_barrier_implicit_workshare,
+			      ompt_scope_end);
+  return ret;
 }
 
 /* The current thread is done with its current work sharing construct.
@@ -502,6 +502,14 @@ __brick_find_if(_RandomAccessIterator __first, _RandomAccessIterator __last, _Pr
         [&__pred](_RandomAccessIterator __it, _SizeType __i) { return __pred(__it[__i]); });
 }
 
+template <class _RandomAccessIterator, class _Tp>
+_RandomAccessIterator
+__brick_find_if(_RandomAccessIterator __first, _RandomAccessIterator __last, __internal::__equal_value<_Tp> __pred,
+                /*is_vector=*/std::true_type) noexcept
+{
+    return __unseq_backend::__simd_find(__first, __last - __first, __pred);
+}
+
 template <class _ExecutionPolicy, class _ForwardIterator, class _Predicate, class _IsVector>
 _ForwardIterator
 __pattern_find_if(_ExecutionPolicy&&, _ForwardIterator __first, _ForwardIterator __last, _Predicate __pred,
@@ -3545,6 +3553,15 @@ __brick_mismatch(_ForwardIterator1 __first1, _ForwardIterator1 __last1, _Forward
     return __unseq_backend::__simd_first(__first1, __n, __first2, std::not_fn(__pred));
 }
 
+template <class _ForwardIterator1, class _ForwardIterator2>
+std::pair<_ForwardIterator1, _ForwardIterator2>
+__brick_mismatch(_ForwardIterator1 __first1, _ForwardIterator1 __last1, _ForwardIterator2 __first2,
+                 _ForwardIterator2 __last2, std::equal_to<>, /* __is_vector = */ std::true_type) noexcept
+{
+    auto __n = std::min(__last1 - __first1, __last2 - __first2);
+    return __unseq_backend::__simd_mismatch(__first1, __n, __first2);
+}
+
 template <class _ExecutionPolicy, class _ForwardIterator1, class _ForwardIterator2, class _Predicate, class _IsVector>
 std::pair<_ForwardIterator1, _ForwardIterator2>
 __pattern_mismatch(_ExecutionPolicy&&, _ForwardIterator1 __first1, _ForwardIterator1 __last1,
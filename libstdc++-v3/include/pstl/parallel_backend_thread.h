@@ -0,0 +1,566 @@
+// -*- C++ -*-
+//===-- parallel_backend_thread.h -----------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef _PSTL_PARALLEL_BACKEND_THREAD_H
+#define _PSTL_PARALLEL_BACKEND_THREAD_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if !defined(_GLIBCXX_HAS_GTHREADS)
+#    error std::thread is required by the thread parallel backend.
+#endif
+
+namespace __pstl
+{
+namespace __thread_backend
+{
+
+//! Raw memory buffer with automatic freeing and no exceptions.
+template <typename _Tp>
+class __buffer
+{
+    std::allocator<_Tp> _M_allocator;
+    _Tp* _M_ptr;
+    const std::size_t _M_buf_size;
+    __buffer(const __buffer&) = delete;
+    void
+    operator=(const __buffer&) = delete;
+
+  public:
+    __buffer(std::size_t __n) : _M_allocator(), _M_ptr(_M_allocator.allocate(__n)), _M_buf_size(__n) {}
+
+    operator bool() const { return _M_ptr != nullptr; }
+    _Tp*
+    get() const
+    {
+        return _M_ptr;
+    }
+    ~__buffer() { _M_allocator.deallocate(_M_ptr, _M_buf_size); }
+};
+
+inline void
+__cancel_execution()
+{
+}
+
+//------------------------------------------------------------------------
+// Thread pool
+//
+// All the algorithms share one pool of std::threads, started on first use
+// with one thread less than the hardware has: the thread that calls the
+// algorithm works too.  A thread waiting for its tasks runs queued tasks in
+// the meantime, so tasks can spawn and wait for tasks of their own.
+//------------------------------------------------------------------------
+
+class __task_group;
+
+struct __task
+{
+    std::function<void()> _M_fn;
+    __task_group* _M_group;
+};
+
+class __thread_pool
+{
+    std::mutex _M_mutex;
+    std::condition_variable _M_work;
+    std::condition_variable _M_done;
+    std::deque<__task> _M_queue;
+    std::size_t _M_num_threads;
+
+    __thread_pool() : _M_num_threads(std::max(1u, std::thread::hardware_concurrency()))
+    {
+        for (std::size_t __i = 1; __i < _M_num_threads; ++__i)
+            std::thread([this]() { _M_worker(); }).detach();
+    }
+
+    void
+    _M_worker()
+    {
+        std::unique_lock<std::mutex> __lock(_M_mutex);
+        for (;;)
+        {
+            _M_work.wait(__lock, [this]() { return !_M_queue.empty(); });
+            _M_run_front(__lock);
+        }
+    }
+
+    // Run the first queued task, with the lock released while it runs
+    inline void
+    _M_run_front(std::unique_lock<std::mutex>& __lock);
+
+  public:
+    //! The pool of the process; its threads are never joined
+    static __thread_pool&
+    __get()
+    {
+        static __thread_pool* __pool = new __thread_pool;
+        return *__pool;
+    }
+
+    std::size_t
+    __num_threads() const
+    {
+        return _M_num_threads;
+    }
+
+    //! Queue fn as a task of group
+    inline void
+    __submit(std::function<void()> __fn, __task_group& __group);
+
+    //! Run queued tasks until the tasks of group are all done
+    inline void
+    __wait(__task_group& __group);
+};
+
+//! Tasks submitted together and waited for together
+class __task_group
+{
+    friend class __thread_pool;
+
+    std::size_t _M_pending = 0;
+
+  public:
+    __task_group() = default;
+    __task_group(const __task_group&) = delete;
+    void
+    operator=(const __task_group&) = delete;
+
+    ~__task_group() { __wait(); }
+
+    template <class _Fp>
+    void
+    __run(_Fp&& __f)
+    {
+        __thread_pool::__get().__submit(std::function<void()>(std::forward<_Fp>(__f)), *this);
+    }
+
+    void
+    __wait()
+    {
+        __thread_pool::__get().__wait(*this);
+    }
+};
+
+inline void
+__thread_pool::__submit(std::function<void()> __fn, __task_group& __group)
+{
+    {
+        std::lock_guard<std::mutex> __lock(_M_mutex);
+        ++__group._M_pending;
+        _M_queue.push_back(__task{std::move(__fn), &__group});
+    }
+    _M_work.notify_one();
+}
+
+inline void
+__thread_pool::_M_run_front(std::unique_lock<std::mutex>& __lock)
+{
+    __task __t = std::move(_M_queue.front());
+    _M_queue.pop_front();
+    __lock.unlock();
+    // As with the other backends, an exception escaping an element access
+    // function terminates the program.
+    [&]() noexcept { __t._M_fn(); }();
+    __lock.lock();
+    if (--__t._M_group->_M_pending == 0)
+        _M_done.notify_all();
+}
+
+inline void
+__thread_pool::__wait(__task_group& __group)
+{
+    std::unique_lock<std::mutex> __lock(_M_mutex);
+    while (__group._M_pending != 0)
+    {
+        if (!_M_queue.empty())
+            _M_run_front(__lock);
+        else
+            _M_done.wait(__lock);
+    }
+}
+
+//------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------
+
+// Ranges are not split into chunks smaller than this
+constexpr std::size_t __chunk_size_min = 2048;
+// Chunks per thread, so that uneven chunks can be load balanced
+constexpr std::size_t __chunks_per_thread = 4;
+#define _PSTL_THREAD_STABLE_SORT_CUT_OFF 500
+#define _PSTL_THREAD_MERGE_CUT_OFF 2000
+
+//! Number of threads that execute the tasks of the algorithms
+inline std::size_t
+__num_threads()
+{
+    return __thread_pool::__get().__num_threads();
+}
+
+//! Number of chunks [0,n) is split into; 1 when it should run serially
+inline std::size_t
+__chunk_count(std::size_t __n)
+{
+    const std::size_t __by_size = __n / __chunk_size_min + (__n % __chunk_size_min != 0);
+    return std::max(std::size_t(1), std::min(__by_size, __chunks_per_thread * __num_threads()));
+}
+
+//! Start of the k-th of the nchunks balanced chunks of [0,n)
+inline std::size_t
+__chunk_begin(std::size_t __n, std::size_t __nchunks, std::size_t __k)
+{
+    return __k * (__n / __nchunks) + std::min(__k, __n % __nchunks);
+}
+
+//! Call f(k,i,j) for the first count of the nchunks chunks [i,j) of [0,n), as tasks
+template <class _Fp>
+void
+__for_each_chunk(std::size_t __n, std::size_t __nchunks, std::size_t __count, _Fp __f)
+{
+    if (__count == 0)
+        return;
+
+    __task_group __group;
+    for (std::size_t __k = 1; __k < __count; ++__k)
+        __group.__run([=, &__f]() {
+            __f(__k, __chunk_begin(__n, __nchunks, __k), __chunk_begin(__n, __nchunks, __k + 1));
+        });
+    __f(std::size_t(0), std::size_t(0), __chunk_begin(__n, __nchunks, 1));
+    __group.__wait();
+}
+
+//------------------------------------------------------------------------
+// parallel_for
+//------------------------------------------------------------------------
+
+//! Evaluation of brick f[i,j) for each subrange [i,j) of [first,last)
+template <class _ExecutionPolicy, class _Index, class _Fp>
+void
+__parallel_for(_ExecutionPolicy&&, _Index __first, _Index __last, _Fp __f)
+{
+    typedef decltype(__last - __first) _DifferenceType;
+    const std::size_t __n = __last - __first;
+    const std::size_t __nchunks = __chunk_count(__n);
+    if (__nchunks == 1)
+    {
+        if (__n)
+            __f(__first, __last);
+        return;
+    }
+
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks,
+                                       [__first, &__f](std::size_t, std::size_t __i, std::size_t __j) {
+                                           __f(__first + _DifferenceType(__i), __first + _DifferenceType(__j));
+                                       });
+}
+
+//------------------------------------------------------------------------
+// parallel_reduce
+//------------------------------------------------------------------------
+
+//! Reduction of real_body(i,j,identity) over the subranges [i,j) of [first,last)
+template <class _ExecutionPolicy, class _Value, class _Index, typename _RealBody, typename _Reduction>
+_Value
+__parallel_reduce(_ExecutionPolicy&&, _Index __first, _Index __last, const _Value& __identity,
+                  const _RealBody& __real_body, const _Reduction& __reduction)
+{
+    typedef decltype(__last - __first) _DifferenceType;
+    const std::size_t __n = __last - __first;
+    const std::size_t __nchunks = __chunk_count(__n);
+    if (__nchunks == 1)
+        return __n ? __real_body(__first, __last, __identity) : __identity;
+
+    std::vector<_Value> __sums(__nchunks, __identity);
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks,
+                                       [&](std::size_t __k, std::size_t __i, std::size_t __j) {
+                                           __sums[__k] = __real_body(__first + _DifferenceType(__i),
+                                                                     __first + _DifferenceType(__j), __identity);
+                                       });
+
+    // The reduction need not be commutative: combine the sums in order
+    _Value __sum = __sums[0];
+    for (std::size_t __k = 1; __k < __nchunks; ++__k)
+        __sum = __reduction(__sum, __sums[__k]);
+    return __sum;
+}
+
+//------------------------------------------------------------------------
+// parallel_transform_reduce
+//
+// Notation:
+//      r(i,j,init) returns reduction of init with reduction over [i,j)
+//      u(i) returns f(i,i+1,identity) for a hypothetical left identity element of r
+//      c(x,y) combines values x and y that were the result of r or u
+//------------------------------------------------------------------------
+
+template <class _ExecutionPolicy, class _Index, class _Up, class _Tp, class _Cp, class _Rp>
+_Tp
+__parallel_transform_reduce(_ExecutionPolicy&&, _Index __first, _Index __last, _Up __u, _Tp __init, _Cp __combine,
+                            _Rp __brick_reduce)
+{
+    typedef decltype(__last - __first) _DifferenceType;
+    const std::size_t __n = __last - __first;
+    const std::size_t __nchunks = __chunk_count(__n);
+    if (__nchunks == 1)
+        return __brick_reduce(__first, __last, __init);
+
+    // Without an identity, each chunk is reduced starting from its first element
+    std::vector<_Tp> __sums(__nchunks, __init);
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks,
+                                       [&](std::size_t __k, std::size_t __i, std::size_t __j) {
+                                           _Index __b = __first + _DifferenceType(__i);
+                                           __sums[__k] = __brick_reduce(__b + 1, __first + _DifferenceType(__j),
+                                                                        __u(__b));
+                                       });
+
+    _Tp __sum = __init;
+    for (std::size_t __k = 0; __k < __nchunks; ++__k)
+        __sum = __combine(__sum, __sums[__k]);
+    return __sum;
+}
+
+//------------------------------------------------------------------------
+// parallel_scan
+//------------------------------------------------------------------------
+
+// Expected actions of the functors are:
+//     reduce(i,len) -> s  -- return reduction value of i:len.
+//     combine(s1,s2) -> s -- return merged sum
+//     apex(s) -- do any processing necessary between reduce and scan.
+//     scan(i,len,initial) -- perform scan over i:len starting with initial.
+// reduce and scan are each called exactly once per subrange, and apex
+// exactly once, after all calls to reduce and before all calls to scan.
+template <class _ExecutionPolicy, typename _Index, typename _Tp, typename _Rp, typename _Cp, typename _Sp, typename _Ap>
+void
+__parallel_strict_scan(_ExecutionPolicy&&, _Index __n, _Tp __initial, _Rp __reduce, _Cp __combine, _Sp __scan,
+                       _Ap __apex)
+{
+    const std::size_t __nchunks = __chunk_count(__n);
+    if (__nchunks == 1)
+    {
+        _Tp __sum = __initial;
+        if (__n)
+            __sum = __combine(__sum, __reduce(_Index(0), __n));
+        __apex(__sum);
+        if (__n)
+            __scan(_Index(0), __n, __initial);
+        return;
+    }
+
+    // __sums[k] becomes the initial value of chunk k once the chunks are reduced
+    std::vector<_Tp> __sums(__nchunks + 1);
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks,
+                                       [&](std::size_t __k, std::size_t __i, std::size_t __j) {
+                                           __sums[__k + 1] = __reduce(_Index(__i), _Index(__j - __i));
+                                       });
+
+    __sums[0] = __initial;
+    for (std::size_t __k = 1; __k <= __nchunks; ++__k)
+        __sums[__k] = __combine(__sums[__k - 1], __sums[__k]);
+    __apex(__sums[__nchunks]);
+
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks,
+                                       [&](std::size_t __k, std::size_t __i, std::size_t __j) {
+                                           __scan(_Index(__i), _Index(__j - __i), __sums[__k]);
+                                       });
+}
+
+template <class _ExecutionPolicy, class _Index, class _Up, class _Tp, class _Cp, class _Rp, class _Sp>
+_Tp
+__parallel_transform_scan(_ExecutionPolicy&&, _Index __n, _Up __u, _Tp __init, _Cp __combine, _Rp __brick_reduce,
+                          _Sp __scan)
+{
+    const std::size_t __nchunks = __chunk_count(__n);
+    if (__nchunks == 1)
+        return __scan(_Index(0), __n, __init);
+
+    // __sums[k] becomes the initial value of chunk k; the last chunk needs no reduction
+    std::vector<_Tp> __sums(__nchunks, __init);
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks - 1,
+                                       [&](std::size_t __k, std::size_t __i, std::size_t __j) {
+                                           __sums[__k + 1] = __brick_reduce(_Index(__i + 1), _Index(__j),
+                                                                            __u(_Index(__i)));
+                                       });
+
+    for (std::size_t __k = 1; __k < __nchunks; ++__k)
+        __sums[__k] = __combine(__sums[__k - 1], __sums[__k]);
+
+    // The scan of the last chunk returns the total
+    _Tp __sum = __init;
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks,
+                                       [&](std::size_t __k, std::size_t __i, std::size_t __j) {
+                                           _Tp __last = __scan(_Index(__i), _Index(__j), __sums[__k]);
+                                           if (__k == __nchunks - 1)
+                                               __sum = std::move(__last);
+                                       });
+    return __sum;
+}
+
+//------------------------------------------------------------------------
+// parallel_merge
+//------------------------------------------------------------------------
+
+//! Merge [xs,xe) and [ys,ye) to zs, splitting the work into tasks
+template <typename _RandomAccessIterator1, typename _RandomAccessIterator2, typename _RandomAccessIterator3,
+          typename _Compare, typename _LeafMerge>
+void
+__merge_task(_RandomAccessIterator1 __xs, _RandomAccessIterator1 __xe, _RandomAccessIterator2 __ys,
+             _RandomAccessIterator2 __ye, _RandomAccessIterator3 __zs, _Compare __comp, _LeafMerge __leaf_merge)
+{
+    const std::size_t __n = (__xe - __xs) + (__ye - __ys);
+    if (__n <= _PSTL_THREAD_MERGE_CUT_OFF)
+    {
+        __leaf_merge(__xs, __xe, __ys, __ye, __zs, __comp);
+        return;
+    }
+
+    // Split so that the elements of x still come before the equivalent ones of y
+    _RandomAccessIterator1 __xm;
+    _RandomAccessIterator2 __ym;
+    if (__xe - __xs < __ye - __ys)
+    {
+        __ym = __ys + (__ye - __ys) / 2;
+        __xm = std::upper_bound(__xs, __xe, *__ym, __comp);
+    }
+    else
+    {
+        __xm = __xs + (__xe - __xs) / 2;
+        __ym = std::lower_bound(__ys, __ye, *__xm, __comp);
+    }
+    const _RandomAccessIterator3 __zm = __zs + ((__xm - __xs) + (__ym - __ys));
+
+    __task_group __group;
+    __group.__run([=]() { __thread_backend::__merge_task(__xs, __xm, __ys, __ym, __zs, __comp, __leaf_merge); });
+    __thread_backend::__merge_task(__xm, __xe, __ym, __ye, __zm, __comp, __leaf_merge);
+    __group.__wait();
+}
+
+template <class _ExecutionPolicy, typename _RandomAccessIterator1, typename _RandomAccessIterator2,
+          typename _RandomAccessIterator3, typename _Compare, typename _LeafMerge>
+void
+__parallel_merge(_ExecutionPolicy&&, _RandomAccessIterator1 __xs, _RandomAccessIterator1 __xe,
+                 _RandomAccessIterator2 __ys, _RandomAccessIterator2 __ye, _RandomAccessIterator3 __zs, _Compare __comp,
+                 _LeafMerge __leaf_merge)
+{
+    const std::size_t __n = (__xe - __xs) + (__ye - __ys);
+    if (__n <= _PSTL_THREAD_MERGE_CUT_OFF || __num_threads() == 1)
+    {
+        // Fall back on serial merge
+        __leaf_merge(__xs, __xe, __ys, __ye, __zs, __comp);
+        return;
+    }
+
+    __thread_backend::__merge_task(__xs, __xe, __ys, __ye, __zs, __comp, __leaf_merge);
+}
+
+//------------------------------------------------------------------------
+// parallel_stable_sort
+//------------------------------------------------------------------------
+
+//! Move [xs,xe) to the raw memory at zs, in parallel chunks
+template <typename _RandomAccessIterator, typename _ValueType>
+void
+__uninitialized_move_chunks(_RandomAccessIterator __xs, _RandomAccessIterator __xe, _ValueType* __zs)
+{
+    typedef typename std::iterator_traits<_RandomAccessIterator>::difference_type _DifferenceType;
+    const std::size_t __n = __xe - __xs;
+    const std::size_t __nchunks = std::max(std::size_t(1), __n / __chunk_size_min);
+    __thread_backend::__for_each_chunk(__n, __nchunks, __nchunks, [=](std::size_t, std::size_t __i, std::size_t __j) {
+        std::uninitialized_move(__xs + _DifferenceType(__i), __xs + _DifferenceType(__j), __zs + __i);
+    });
+}
+
+//! Stable sort of [xs,xe), using the raw memory at zs as temporary storage
+template <typename _RandomAccessIterator, typename _ValueType, typename _Compare, typename _LeafSort>
+void
+__stable_sort_task(_RandomAccessIterator __xs, _RandomAccessIterator __xe, _ValueType* __zs, _Compare __comp,
+                   _LeafSort __leaf_sort)
+{
+    const std::size_t __n = __xe - __xs;
+    if (__n <= _PSTL_THREAD_STABLE_SORT_CUT_OFF)
+    {
+        __leaf_sort(__xs, __xe, __comp);
+        return;
+    }
+
+    const _RandomAccessIterator __xm = __xs + __n / 2;
+    _ValueType* const __zm = __zs + __n / 2;
+    {
+        __task_group __group;
+        __group.__run([=]() { __thread_backend::__stable_sort_task(__xs, __xm, __zs, __comp, __leaf_sort); });
+        __thread_backend::__stable_sort_task(__xm, __xe, __zm, __comp, __leaf_sort);
+        __group.__wait();
+    }
+
+    // Merge the sorted halves back from the temporary storage
+    __thread_backend::__uninitialized_move_chunks(__xs, __xe, __zs);
+    __thread_backend::__merge_task(__zs, __zm, __zm, __zs + __n, __xs, __comp,
+                                   [](_ValueType* __xs, _ValueType* __xe, _ValueType* __ys, _ValueType* __ye,
+                                      _RandomAccessIterator __zs, _Compare __comp) {
+                                       std::merge(std::make_move_iterator(__xs), std::make_move_iterator(__xe),
+                                                  std::make_move_iterator(__ys), std::make_move_iterator(__ye), __zs,
+                                                  __comp);
+                                       for (; __xs != __xe; ++__xs)
+                                           __xs->~_ValueType();
+                                       for (; __ys != __ye; ++__ys)
+                                           __ys->~_ValueType();
+                                   });
+}
+
+template <class _ExecutionPolicy, typename _RandomAccessIterator, typename _Compare, typename _LeafSort>
+void
+__parallel_stable_sort(_ExecutionPolicy&&, _RandomAccessIterator __xs, _RandomAccessIterator __xe, _Compare __comp,
+                       _LeafSort __leaf_sort, std::size_t __nsort = 0)
+{
+    typedef typename std::iterator_traits<_RandomAccessIterator>::value_type _ValueType;
+    const std::size_t __n = __xe - __xs;
+    if (__nsort == __n)
+        __nsort = 0; // 'partial_sort' becames 'sort'
+
+    // A partial sort is left to the leaf sort, which does it in a single pass
+    if (__n <= _PSTL_THREAD_STABLE_SORT_CUT_OFF || __nsort != 0 || __num_threads() == 1)
+    {
+        __leaf_sort(__xs, __xe, __comp);
+        return;
+    }
+
+    __buffer<_ValueType> __buf(__n);
+    __thread_backend::__stable_sort_task(__xs, __xe, __buf.get(), __comp, __leaf_sort);
+}
+
+//------------------------------------------------------------------------
+// parallel_invoke
+//------------------------------------------------------------------------
+
+template <class _ExecutionPolicy, typename _F1, typename _F2>
+void
+__parallel_invoke(_ExecutionPolicy&&, _F1&& __f1, _F2&& __f2)
+{
+    __task_group __group;
+    __group.__run([&__f1]() { std::forward<_F1>(__f1)(); });
+    std::forward<_F2>(__f2)();
+    __group.__wait();
+}
+
+} // namespace __thread_backend
+} // namespace __pstl
+
+#endif /* _PSTL_PARALLEL_BACKEND_THREAD_H */
@@ -16,7 +16,8 @@
 #define _PSTL_VERSION_MINOR ((_PSTL_VERSION % 1000) / 10)
 #define _PSTL_VERSION_PATCH (_PSTL_VERSION % 10)
 
-#if !defined(_PSTL_PAR_BACKEND_SERIAL) && !defined(_PSTL_PAR_BACKEND_TBB)
+#if !defined(_PSTL_PAR_BACKEND_SERIAL) && !defined(_PSTL_PAR_BACKEND_TBB) && !defined(_PSTL_PAR_BACKEND_OPENMP) &&    \
+    !defined(_PSTL_PAR_BACKEND_THREAD)
 #    error "A parallel backend must be specified"
 #endif
 
@@ -102,6 +103,13 @@
     (!__INTEL_COMPILER || __INTEL_COMPILER >= 1700) && (_MSC_FULL_VER >= 190023918 || __cplusplus >= 201402L)
 
 #define _PSTL_EARLYEXIT_PRESENT (__INTEL_COMPILER >= 1800)
+
+// GCC vector extensions, for the explicitly vectorized kernels of the unseq backend
+#if !defined(__clang__) && !defined(__INTEL_COMPILER) && _PSTL_GCC_VERSION >= 80000
+#    define _PSTL_VECTOR_EXTENSIONS_PRESENT 1
+#else
+#    define _PSTL_VECTOR_EXTENSIONS_PRESENT 0
+#endif
 #define _PSTL_MONOTONIC_PRESENT (__INTEL_COMPILER >= 1800)
 
 #if (__INTEL_COMPILER >= 1900 || !defined(__INTEL_COMPILER) && _PSTL_GCC_VERSION >= 40900 || _OPENMP >= 201307)
@@ -10,6 +10,7 @@
 #ifndef _PSTL_UNSEQ_BACKEND_SIMD_H
 #define _PSTL_UNSEQ_BACKEND_SIMD_H
 
+#include <iterator>
 #include <type_traits>
 
 #include "utils.h"
@@ -24,6 +25,265 @@ namespace __unseq_backend
 // Expect vector width up to 64 (or 512 bit)
 const std::size_t __lane_size = 64;
 
+//------------------------------------------------------------------------
+// Explicitly vectorized kernels
+//
+// The loops of searches with an early exit, and of reductions and scans
+// of floating-point values, are not vectorized from the pragmas alone.
+// For arithmetic types, these kernels use GCC vector extensions instead.
+// Vectors are passed by reference, which keeps the calling convention
+// independent of the vector ISA enabled.
+//------------------------------------------------------------------------
+
+#if _PSTL_VECTOR_EXTENSIONS_PRESENT
+
+// Width of the vectors the kernels work on
+const std::size_t __vector_size = 32;
+
+template <typename _Tp>
+using __is_vectorizable =
+    std::integral_constant<bool, std::is_arithmetic<_Tp>::value && !std::is_same<_Tp, bool>::value &&
+                                     !std::is_same<_Tp, long double>::value && sizeof(_Tp) <= 8>;
+
+// Pointer to the elements when _Iterator is a pointer or wraps one
+template <typename _Iterator>
+using __element_pointer = decltype(std::__niter_base(std::declval<_Iterator>()));
+
+//! True if _Iterator iterates over contiguous elements of type _Tp, for which the kernels are used
+template <typename _Iterator, typename _Tp>
+using __is_vectorizable_range = std::integral_constant<
+    bool, std::is_pointer<__element_pointer<_Iterator>>::value &&
+              std::is_same<typename std::remove_cv<
+                               typename std::remove_pointer<__element_pointer<_Iterator>>::type>::type,
+                           _Tp>::value &&
+              __is_vectorizable<_Tp>::value>;
+
+template <typename _Tp>
+struct __vector
+{
+    static constexpr std::size_t __lanes = __vector_size / sizeof(_Tp);
+    typedef _Tp __type __attribute__((__vector_size__(__vector_size)));
+};
+
+template <typename _Vec, typename _Tp>
+void
+__vector_load(_Vec& __v, const _Tp* __p) noexcept
+{
+    __builtin_memcpy(&__v, __p, sizeof(_Vec));
+}
+
+template <typename _Vec, typename _Tp>
+void
+__vector_broadcast(_Vec& __v, _Tp __value) noexcept
+{
+    __v = _Vec{} + __value;
+}
+
+//! True if a lane of the comparison result __m is set
+template <typename _Mask>
+bool
+__vector_any(const _Mask& __m) noexcept
+{
+    unsigned long long __words[sizeof(_Mask) / sizeof(unsigned long long)];
+    __builtin_memcpy(__words, &__m, sizeof(_Mask));
+    unsigned long long __any = 0;
+    for (std::size_t __j = 0; __j < sizeof(_Mask) / sizeof(unsigned long long); ++__j)
+        __any |= __words[__j];
+    return __any != 0;
+}
+
+//! Lanes of __v moved up by __k lanes, with zeros shifted in
+template <typename _Vec>
+void
+__vector_shift_up(_Vec& __out, const _Vec& __v, std::size_t __k) noexcept
+{
+    typedef decltype(__v == __v) _Mask;
+    constexpr std::size_t __lanes = sizeof(_Vec) / sizeof(__v[0]);
+    _Mask __shuffle;
+    for (std::size_t __j = 0; __j < __lanes; ++__j)
+        __shuffle[__j] = __j >= __k ? __j - __k : __lanes;
+    __out = __builtin_shuffle(__v, _Vec{}, __shuffle);
+}
+
+//! Index of the first element of [first,first+n) equal to value, or n
+template <typename _Tp, typename _DifferenceType>
+_DifferenceType
+__vector_find(const _Tp* __first, _DifferenceType __n, _Tp __value) noexcept
+{
+    typedef typename __vector<_Tp>::__type _Vec;
+    // A single test for the early exit per block of four vectors
+    const _DifferenceType __lanes = __vector<_Tp>::__lanes;
+    const _DifferenceType __block_size = 4 * __lanes;
+    _Vec __val, __v0, __v1, __v2, __v3;
+    __vector_broadcast(__val, __value);
+
+    _DifferenceType __i = 0;
+    for (; __n - __i >= __block_size; __i += __block_size)
+    {
+        __vector_load(__v0, __first + __i);
+        __vector_load(__v1, __first + __i + __lanes);
+        __vector_load(__v2, __first + __i + 2 * __lanes);
+        __vector_load(__v3, __first + __i + 3 * __lanes);
+        if (__vector_any((__v0 == __val) | (__v1 == __val) | (__v2 == __val) | (__v3 == __val)))
+            break;
+    }
+    for (; __i < __n; ++__i)
+        if (__first[__i] == __value)
+            break;
+    return __i;
+}
+
+//! Number of elements of [first,first+n) equal to value
+template <typename _Tp, typename _DifferenceType>
+_DifferenceType
+__vector_count(const _Tp* __first, _DifferenceType __n, _Tp __value) noexcept
+{
+    typedef typename __vector<_Tp>::__type _Vec;
+    typedef decltype(_Vec{} == _Vec{}) _Mask;
+    const _DifferenceType __lanes = __vector<_Tp>::__lanes;
+    // Matches are counted down from 0 in the lanes of a mask, which are
+    // summed before they can overflow
+    const _DifferenceType __flush_size = 127 * __lanes;
+    _Vec __val, __v;
+    __vector_broadcast(__val, __value);
+
+    _DifferenceType __count = 0;
+    _DifferenceType __i = 0;
+    while (__n - __i >= __lanes)
+    {
+        const _DifferenceType __end = __i + std::min(__n - __i, __flush_size) / __lanes * __lanes;
+        _Mask __acc{};
+        for (; __i < __end; __i += __lanes)
+        {
+            __vector_load(__v, __first + __i);
+            __acc += __v == __val;
+        }
+        for (_DifferenceType __j = 0; __j < __lanes; ++__j)
+            __count -= __acc[__j];
+    }
+    for (; __i < __n; ++__i)
+        __count += __first[__i] == __value;
+    return __count;
+}
+
+//! Index of the first element of [first1,first1+n) that differs from the one of [first2,first2+n), or n
+template <typename _Tp, typename _DifferenceType>
+_DifferenceType
+__vector_mismatch(const _Tp* __first1, _DifferenceType __n, const _Tp* __first2) noexcept
+{
+    typedef typename __vector<_Tp>::__type _Vec;
+    const _DifferenceType __lanes = __vector<_Tp>::__lanes;
+    const _DifferenceType __block_size = 2 * __lanes;
+    _Vec __x0, __x1, __y0, __y1;
+
+    _DifferenceType __i = 0;
+    for (; __n - __i >= __block_size; __i += __block_size)
+    {
+        __vector_load(__x0, __first1 + __i);
+        __vector_load(__x1, __first1 + __i + __lanes);
+        __vector_load(__y0, __first2 + __i);
+        __vector_load(__y1, __first2 + __i + __lanes);
+        if (__vector_any((__x0 != __y0) | (__x1 != __y1)))
+            break;
+    }
+    for (; __i < __n; ++__i)
+        if (!(__first1[__i] == __first2[__i]))
+            break;
+    return __i;
+}
+
+//! Sum of init and of f(i) for i in [0,n)
+template <typename _Tp, typename _Size, typename _UnaryOperation>
+_Tp
+__vector_transform_reduce(_Size __n, _Tp __init, _UnaryOperation __f) noexcept
+{
+    typedef typename __vector<_Tp>::__type _Vec;
+    const _Size __lanes = __vector<_Tp>::__lanes;
+    // Four independent accumulators hide the latency of the additions
+    const _Size __block_size = 4 * __lanes;
+    _Vec __acc0{}, __acc1{}, __acc2{}, __acc3{};
+
+    _Size __i = 0;
+    for (; __n - __i >= __block_size; __i += __block_size)
+    {
+        _Vec __v0, __v1, __v2, __v3;
+        for (_Size __j = 0; __j < __lanes; ++__j)
+        {
+            __v0[__j] = __f(__i + __j);
+            __v1[__j] = __f(__i + __lanes + __j);
+            __v2[__j] = __f(__i + 2 * __lanes + __j);
+            __v3[__j] = __f(__i + 3 * __lanes + __j);
+        }
+        __acc0 += __v0;
+        __acc1 += __v1;
+        __acc2 += __v2;
+        __acc3 += __v3;
+    }
+
+    // Tree reduction of the accumulators, then of the lanes
+    __acc0 = (__acc0 + __acc1) + (__acc2 + __acc3);
+    for (_Size __width = __lanes / 2; __width > 0; __width /= 2)
+        for (_Size __j = 0; __j < __width; ++__j)
+            __acc0[__j] += __acc0[__j + __width];
+
+    _Tp __sum = __acc0[0];
+    for (; __i < __n; ++__i)
+        __sum += __f(__i);
+    return __init + __sum;
+}
+
+//! Inclusive or exclusive prefix sum of init and of unary_op(first[i]) to result
+template <typename _InputIterator, typename _Size, typename _Tp, typename _UnaryOperation>
+_Tp
+__vector_scan(_InputIterator __first, _Size __n, _Tp* __result, _UnaryOperation __unary_op, _Tp __init,
+              bool __inclusive) noexcept
+{
+    typedef typename __vector<_Tp>::__type _Vec;
+    const _Size __lanes = __vector<_Tp>::__lanes;
+    _Vec __v, __shifted, __carry;
+
+    _Size __i = 0;
+    for (; __n - __i >= __lanes; __i += __lanes)
+    {
+        for (_Size __j = 0; __j < __lanes; ++__j)
+            __v[__j] = __unary_op(__first[__i + __j]);
+        // Log-step prefix sum of the lanes
+        for (_Size __k = 1; __k < __lanes; __k *= 2)
+        {
+            __vector_shift_up(__shifted, __v, __k);
+            __v += __shifted;
+        }
+        __vector_broadcast(__carry, __init);
+        __init += __v[__lanes - 1];
+        if (!__inclusive)
+        {
+            __vector_shift_up(__shifted, __v, 1);
+            __v = __shifted;
+        }
+        __v += __carry;
+        __builtin_memcpy(__result + __i, &__v, sizeof(_Vec));
+    }
+    for (; __i < __n; ++__i)
+    {
+        if (!__inclusive)
+            __result[__i] = __init;
+        __init += __unary_op(__first[__i]);
+        if (__inclusive)
+            __result[__i] = __init;
+    }
+    return __init;
+}
+
+#else
+
+template <typename _Tp>
+using __is_vectorizable = std::false_type;
+
+template <typename _Iterator, typename _Tp>
+using __is_vectorizable_range = std::false_type;
+
+#endif // _PSTL_VECTOR_EXTENSIONS_PRESENT
+
 template <class _Iterator, class _DifferenceType, class _Function>
 _Iterator
 __simd_walk_1(_Iterator __first, _DifferenceType __n, _Function __f) noexcept
@@ -224,6 +484,93 @@ __simd_count(_Index __index, _DifferenceType __n, _Pred __pred) noexcept
     return __count;
 }
 
+// Searches and counts for ==value, explicitly vectorized for contiguous arithmetic ranges
+template <class _Index, class _DifferenceType, class _Tp>
+_Index
+__simd_find(_Index __first, _DifferenceType __n, const __internal::__equal_value<_Tp>& __pred,
+            /*vectorizable=*/std::false_type) noexcept
+{
+    return __unseq_backend::__simd_first(__first, _DifferenceType(0), __n,
+                                         [&__pred](_Index __it, _DifferenceType __i) { return __pred(__it[__i]); });
+}
+
+template <class _Index, class _DifferenceType, class _Tp>
+_DifferenceType
+__simd_count(_Index __index, _DifferenceType __n, const __internal::__equal_value<_Tp>& __pred,
+             /*vectorizable=*/std::false_type) noexcept
+{
+    _DifferenceType __count = 0;
+    _PSTL_PRAGMA_SIMD_REDUCTION(+ : __count)
+    for (_DifferenceType __i = 0; __i < __n; ++__i)
+        if (__pred(*(__index + __i)))
+            ++__count;
+
+    return __count;
+}
+
+template <class _Index1, class _DifferenceType, class _Index2>
+std::pair<_Index1, _Index2>
+__simd_mismatch(_Index1 __first1, _DifferenceType __n, _Index2 __first2, /*vectorizable=*/std::false_type) noexcept
+{
+    return __unseq_backend::__simd_first(
+        __first1, __n, __first2, [](decltype(*__first1) __x, decltype(*__first2) __y) { return !(__x == __y); });
+}
+
+#if _PSTL_VECTOR_EXTENSIONS_PRESENT
+template <class _Index, class _DifferenceType, class _Tp>
+_Index
+__simd_find(_Index __first, _DifferenceType __n, const __internal::__equal_value<_Tp>& __pred,
+            /*vectorizable=*/std::true_type) noexcept
+{
+    return __first + __unseq_backend::__vector_find(std::__niter_base(__first), __n, __pred.__get_value());
+}
+
+template <class _Index, class _DifferenceType, class _Tp>
+_DifferenceType
+__simd_count(_Index __index, _DifferenceType __n, const __internal::__equal_value<_Tp>& __pred,
+             /*vectorizable=*/std::true_type) noexcept
+{
+    return __unseq_backend::__vector_count(std::__niter_base(__index), __n, __pred.__get_value());
+}
+
+template <class _Index1, class _DifferenceType, class _Index2>
+std::pair<_Index1, _Index2>
+__simd_mismatch(_Index1 __first1, _DifferenceType __n, _Index2 __first2, /*vectorizable=*/std::true_type) noexcept
+{
+    const _DifferenceType __i =
+        __unseq_backend::__vector_mismatch(std::__niter_base(__first1), __n, std::__niter_base(__first2));
+    return std::make_pair(__first1 + __i, __first2 + __i);
+}
+#endif
+
+//! First element of [first,first+n) equal to the value of pred
+template <class _Index, class _DifferenceType, class _Tp>
+_Index
+__simd_find(_Index __first, _DifferenceType __n, const __internal::__equal_value<_Tp>& __pred) noexcept
+{
+    return __unseq_backend::__simd_find(__first, __n, __pred, __is_vectorizable_range<_Index, _Tp>());
+}
+
+//! Number of elements of [index,index+n) equal to the value of pred
+template <class _Index, class _DifferenceType, class _Tp>
+_DifferenceType
+__simd_count(_Index __index, _DifferenceType __n, const __internal::__equal_value<_Tp>& __pred) noexcept
+{
+    return __unseq_backend::__simd_count(__index, __n, __pred, __is_vectorizable_range<_Index, _Tp>());
+}
+
+//! First position where [first1,first1+n) and [first2,first2+n) differ, under ==
+template <class _Index1, class _DifferenceType, class _Index2>
+std::pair<_Index1, _Index2>
+__simd_mismatch(_Index1 __first1, _DifferenceType __n, _Index2 __first2) noexcept
+{
+    typedef typename std::iterator_traits<_Index1>::value_type _ValueType;
+    return __unseq_backend::__simd_mismatch(
+        __first1, __n, __first2,
+        std::integral_constant<bool, __is_vectorizable_range<_Index1, _ValueType>::value &&
+                                         __is_vectorizable_range<_Index2, _ValueType>::value>());
+}
+
 template <class _InputIterator, class _DifferenceType, class _OutputIterator, class _BinaryPredicate>
 _OutputIterator
 __simd_unique_copy(_InputIterator __first, _DifferenceType __n, _OutputIterator __result,
@@ -442,9 +789,9 @@ template <typename _Tp, typename _BinaryOperation>
 using is_arithmetic_plus = std::integral_constant<bool, std::is_arithmetic<_Tp>::value &&
                                                             std::is_same<_BinaryOperation, std::plus<_Tp>>::value>;
 
-template <typename _DifferenceType, typename _Tp, typename _BinaryOperation, typename _UnaryOperation>
-typename std::enable_if<is_arithmetic_plus<_Tp, _BinaryOperation>::value, _Tp>::type
-__simd_transform_reduce(_DifferenceType __n, _Tp __init, _BinaryOperation, _UnaryOperation __f) noexcept
+template <typename _DifferenceType, typename _Tp, typename _UnaryOperation>
+_Tp
+__simd_plus_reduce(_DifferenceType __n, _Tp __init, _UnaryOperation __f, /*vectorizable=*/std::false_type) noexcept
 {
     _PSTL_PRAGMA_SIMD_REDUCTION(+ : __init)
     for (_DifferenceType __i = 0; __i < __n; ++__i)
@@ -452,6 +799,26 @@ __simd_transform_reduce(_DifferenceType __n, _Tp __init, _BinaryOperation, _Unar
     return __init;
 }
 
+#if _PSTL_VECTOR_EXTENSIONS_PRESENT
+template <typename _DifferenceType, typename _Tp, typename _UnaryOperation>
+_Tp
+__simd_plus_reduce(_DifferenceType __n, _Tp __init, _UnaryOperation __f, /*vectorizable=*/std::true_type) noexcept
+{
+    return __unseq_backend::__vector_transform_reduce(__n, __init, __f);
+}
+#endif
+
+template <typename _DifferenceType, typename _Tp, typename _BinaryOperation, typename _UnaryOperation>
+typename std::enable_if<is_arithmetic_plus<_Tp, _BinaryOperation>::value, _Tp>::type
+__simd_transform_reduce(_DifferenceType __n, _Tp __init, _BinaryOperation, _UnaryOperation __f) noexcept
+{
+    // The lanes hold _Tp values, so f has to yield them without a conversion
+    typedef typename std::decay<decltype(__f(__n))>::type _ResultType;
+    return __unseq_backend::__simd_plus_reduce(
+        __n, __init, __f,
+        std::integral_constant<bool, __is_vectorizable<_Tp>::value && std::is_same<_ResultType, _Tp>::value>());
+}
+
 template <typename _Size, typename _Tp, typename _BinaryOperation, typename _UnaryOperation>
 typename std::enable_if<!is_arithmetic_plus<_Tp, _BinaryOperation>::value, _Tp>::type
 __simd_transform_reduce(_Size __n, _Tp __init, _BinaryOperation __binary_op, _UnaryOperation __f) noexcept
@@ -508,11 +875,10 @@ __simd_transform_reduce(_Size __n, _Tp __init, _BinaryOperation __binary_op, _Un
 }
 
 // Exclusive scan for "+" and arithmetic types
-template <class _InputIterator, class _Size, class _OutputIterator, class _UnaryOperation, class _Tp,
-          class _BinaryOperation>
-typename std::enable_if<is_arithmetic_plus<_Tp, _BinaryOperation>::value, std::pair<_OutputIterator, _Tp>>::type
-__simd_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryOperation __unary_op, _Tp __init,
-            _BinaryOperation, /*Inclusive*/ std::false_type)
+template <class _InputIterator, class _Size, class _OutputIterator, class _UnaryOperation, class _Tp>
+std::pair<_OutputIterator, _Tp>
+__simd_plus_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryOperation __unary_op, _Tp __init,
+                 /*Inclusive*/ std::false_type, /*vectorizable=*/std::false_type)
 {
     _PSTL_PRAGMA_SIMD_SCAN(+ : __init)
     for (_Size __i = 0; __i < __n; ++__i)
@@ -524,6 +890,49 @@ __simd_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryO
     return std::make_pair(__result + __n, __init);
 }
 
+// Inclusive scan for "+" and arithmetic types
+template <class _InputIterator, class _Size, class _OutputIterator, class _UnaryOperation, class _Tp>
+std::pair<_OutputIterator, _Tp>
+__simd_plus_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryOperation __unary_op, _Tp __init,
+                 /*Inclusive*/ std::true_type, /*vectorizable=*/std::false_type)
+{
+    _PSTL_PRAGMA_SIMD_SCAN(+ : __init)
+    for (_Size __i = 0; __i < __n; ++__i)
+    {
+        __init += __unary_op(__first[__i]);
+        _PSTL_PRAGMA_SIMD_INCLUSIVE_SCAN(__init)
+        __result[__i] = __init;
+    }
+    return std::make_pair(__result + __n, __init);
+}
+
+#if _PSTL_VECTOR_EXTENSIONS_PRESENT
+template <class _InputIterator, class _Size, class _OutputIterator, class _UnaryOperation, class _Tp, class _Inclusive>
+std::pair<_OutputIterator, _Tp>
+__simd_plus_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryOperation __unary_op, _Tp __init,
+                 _Inclusive, /*vectorizable=*/std::true_type)
+{
+    __init = __unseq_backend::__vector_scan(__first, __n, std::__niter_base(__result), __unary_op, __init,
+                                            _Inclusive::value);
+    return std::make_pair(__result + __n, __init);
+}
+#endif
+
+// Scans for "+" and arithmetic types: the lanes hold _Tp values, so
+// unary_op has to yield them without a conversion
+template <class _InputIterator, class _Size, class _OutputIterator, class _UnaryOperation, class _Tp,
+          class _BinaryOperation, class _Inclusive>
+typename std::enable_if<is_arithmetic_plus<_Tp, _BinaryOperation>::value, std::pair<_OutputIterator, _Tp>>::type
+__simd_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryOperation __unary_op, _Tp __init,
+            _BinaryOperation, _Inclusive __inclusive)
+{
+    typedef typename std::decay<decltype(__unary_op(*__first))>::type _ResultType;
+    return __unseq_backend::__simd_plus_scan(
+        __first, __n, __result, __unary_op, __init, __inclusive,
+        std::integral_constant<bool, __is_vectorizable_range<_OutputIterator, _Tp>::value &&
+                                         std::is_same<_ResultType, _Tp>::value>());
+}
+
 // As soon as we cannot call __binary_op in "combiner" we create a wrapper over _Tp to encapsulate __binary_op
 template <typename _Tp, typename _BinaryOp>
 struct _Combiner
@@ -565,23 +974,6 @@ __simd_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryO
     return std::make_pair(__result + __n, __init_.__value);
 }
 
-// Inclusive scan for "+" and arithmetic types
-template <class _InputIterator, class _Size, class _OutputIterator, class _UnaryOperation, class _Tp,
-          class _BinaryOperation>
-typename std::enable_if<is_arithmetic_plus<_Tp, _BinaryOperation>::value, std::pair<_OutputIterator, _Tp>>::type
-__simd_scan(_InputIterator __first, _Size __n, _OutputIterator __result, _UnaryOperation __unary_op, _Tp __init,
-            _BinaryOperation, /*Inclusive*/ std::true_type)
-{
-    _PSTL_PRAGMA_SIMD_SCAN(+ : __init)
-    for (_Size __i = 0; __i < __n; ++__i)
-    {
-        __init += __unary_op(__first[__i]);
-        _PSTL_PRAGMA_SIMD_INCLUSIVE_SCAN(__init)
-        __result[__i] = __init;
-    }
-    return std::make_pair(__result + __n, __init);
-}
-
 // Inclusive scan for other binary operations and types
 template <class _InputIterator, class _Size, class _OutputIterator, class _UnaryOperation, class _Tp,
           class _BinaryOperation>
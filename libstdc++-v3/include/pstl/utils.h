@@ -183,6 +183,12 @@ class __equal_value
     {
         return std::forward<_Arg>(__arg) == _M_value;
     }
+
+    const _Tp&
+    __get_value() const
+    {
+        return _M_value;
+    }
 };
 
 //! Logical negation of ==value